@@ -0,0 +1,1188 @@
+/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Standalone benchmark for the native navigation hot paths.
+ *
+ * Usage: NavBench <navmesh file> [-seed n] [-queries n] [-ticks n]
+ *        NavBench -check-raster
+ *
+ * The file holds the bytes returned by dtnmGetNavMeshRawData.  (The
+ * serialized navigation mesh.)  All workloads are driven by a seeded
+ * generator, so two runs with the same file and seed do the same work.
+ *
+ * Each workload reports the p50 and p99 latency of a single operation, the
+ * throughput, and the peak memory.  The Detour peak is exact. (All Detour
+ * allocations are counted.)  The process peak is reset before each workload
+ * where the platform allows it. Otherwise it is the peak of the whole run.
+ *
+ * -check-raster compares the two rasterization modes instead, and exits
+ * with 1 if they differ.  It needs no file.
+ *
+ * Build it as a console application from this file plus the nav-rcn and
+ * nmgen-rcn sources.  Link psapi on Windows and pthread elsewhere.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "DetourNavMesh.h"
+#include "DetourNavMeshQuery.h"
+#include "DetourCommon.h"
+#include "DetourAlloc.h"
+#include "DetourCrowd.h"
+#include "NMGen.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <time.h>
+#include <sys/resource.h>
+#endif
+
+extern "C"
+{
+    dtStatus dtnmBuildDTNavMeshFromRaw(const unsigned char* data
+        , int dataSize
+        , bool safeStorage
+        , dtNavMesh** ppNavMesh);
+
+    nmgBuildContext* nmbcAllocateContext(bool logEnabled);
+    void nmbcFreeContext(nmgBuildContext* context);
+
+    bool nmgBuildTiles(nmgBuildContext* ctx
+        , const rcConfig* config
+        , const int contourFlags
+        , const unsigned char buildFlags
+        , const float* verts
+        , const int nverts
+        , const int* tris
+        , const unsigned char* areas
+        , const int ntris
+        , const nmgAreaMarker* markers
+        , const int markerCount
+        , const int* tiles
+        , const int tileCount
+        , const int threadCount
+        , nmgTileCache* cache
+        , rcPolyMesh* polyMeshes
+        , nmgPolyMeshDetail* detailMeshes
+        , int* maxVerts
+        , unsigned char* results);
+
+    bool nmgBuildTileProfiles(nmgBuildContext* ctx
+        , const rcConfig* config
+        , const int contourFlags
+        , const unsigned char buildFlags
+        , const float* verts
+        , const int nverts
+        , const int* tris
+        , const unsigned char* areas
+        , const int ntris
+        , const nmgAreaMarker* markers
+        , const int markerCount
+        , const int* walkableRadii
+        , const int profileCount
+        , const int* tiles
+        , const int tileCount
+        , const int threadCount
+        , rcPolyMesh* polyMeshes
+        , nmgPolyMeshDetail* detailMeshes
+        , int* maxVerts
+        , unsigned char* results);
+
+    bool rcpmFreeMeshData(rcPolyMesh* mesh);
+    bool rcpdFreeMeshData(nmgPolyMeshDetail* mesh);
+}
+
+// Must match the private tile build flags and results in TileBuilder.cpp.
+static const unsigned char NB_TILE_FILTER_ALL = 0x01 | 0x02 | 0x04;
+static const unsigned char NB_TILE_COMPLETE = 1;
+
+static const int NB_MAX_PATH = 256;
+static const int NB_MAX_VISITED = 16;
+static const int NB_MAX_AGENT_COUNTS = 8;
+static const int NB_TILE_PROFILES = 3;
+static const float NB_CROWD_DT = 1.0f / 30.0f;
+static const float NB_PI = 3.14159265f;
+
+struct nbSettings
+{
+    unsigned int seed;
+    int queryCount;
+    int tickCount;
+    int agentCounts[NB_MAX_AGENT_COUNTS];
+    int agentCountCount;
+};
+
+// The latency of each operation in a workload, in microseconds.
+struct nbSamples
+{
+    double* times;
+    int count;
+    int maxCount;
+};
+
+/*
+ * Counting Detour allocator.
+ *
+ * Each block is prefixed with its size so the free can update the live
+ * total.  The benchmark is single threaded, so the counters are not
+ * synchronized.
+ */
+
+struct nbBlockHeader
+{
+    size_t size;
+    size_t pad;  // Keeps the user data 16 byte aligned.
+};
+
+static size_t sLiveBytes = 0;
+static size_t sPeakBytes = 0;
+
+static void* nbAlloc(size_t size, dtAllocHint)
+{
+    nbBlockHeader* header = (nbBlockHeader*)malloc(sizeof(nbBlockHeader) + size);
+    if (!header)
+        return 0;
+
+    header->size = size;
+    sLiveBytes += size;
+    if (sLiveBytes > sPeakBytes)
+        sPeakBytes = sLiveBytes;
+
+    return header + 1;
+}
+
+static void nbFree(void* ptr)
+{
+    if (!ptr)
+        return;
+
+    nbBlockHeader* header = (nbBlockHeader*)ptr - 1;
+    sLiveBytes -= header->size;
+    free(header);
+}
+
+static void nbResetPeak()
+{
+    sPeakBytes = sLiveBytes;
+
+#if defined(__linux__)
+    // Resets the process high water mark.  (Requires Linux 4.0+.)
+    FILE* fp = fopen("/proc/self/clear_refs", "w");
+    if (fp)
+    {
+        fputs("5", fp);
+        fclose(fp);
+    }
+#endif
+}
+
+// Returns the peak resident size of the process, in KB.
+static long nbGetProcessPeakKB()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return (long)(counters.PeakWorkingSetSize / 1024);
+#elif defined(__linux__)
+    long result = 0;
+    FILE* fp = fopen("/proc/self/status", "r");
+    if (fp)
+    {
+        char line[128];
+        while (fgets(line, sizeof(line), fp))
+        {
+            if (strncmp(line, "VmHWM:", 6) == 0)
+            {
+                result = atol(line + 6);
+                break;
+            }
+        }
+        fclose(fp);
+    }
+    return result;
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return (long)(usage.ru_maxrss / 1024);
+#else
+    return (long)usage.ru_maxrss;
+#endif
+#endif
+}
+
+// Returns a monotonic time stamp in microseconds.
+static double nbGetTimeUsec()
+{
+#if defined(_WIN32)
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart * 1000000.0 / (double)freq.QuadPart;
+#else
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000000.0 + (double)ts.tv_nsec / 1000.0;
+#endif
+}
+
+/*
+ * Seeded generator.  (Numerical Recipes LCG.)  Used instead of rand() so
+ * that the workloads are the same on every platform.
+ */
+
+static unsigned int sRandomState = 1;
+
+static float nbRandom()
+{
+    sRandomState = sRandomState * 1664525u + 1013904223u;
+    return (float)(sRandomState >> 8) / 16777216.0f;
+}
+
+static bool nbInitSamples(nbSamples& samples, const int maxCount)
+{
+    samples.times = (double*)malloc(sizeof(double) * (maxCount > 0 ? maxCount : 1));
+    samples.count = 0;
+    samples.maxCount = samples.times ? maxCount : 0;
+    return samples.times != 0;
+}
+
+static void nbFreeSamples(nbSamples& samples)
+{
+    free(samples.times);
+    samples.times = 0;
+    samples.count = 0;
+    samples.maxCount = 0;
+}
+
+static void nbAddSample(nbSamples& samples, const double usec)
+{
+    if (samples.count < samples.maxCount)
+        samples.times[samples.count++] = usec;
+}
+
+static int nbCompareTimes(const void* a, const void* b)
+{
+    const double da = *(const double*)a;
+    const double db = *(const double*)b;
+    return da < db ? -1 : (da > db ? 1 : 0);
+}
+
+// Nearest rank percentile.  The samples must be sorted.
+static double nbGetPercentile(const nbSamples& samples, const double p)
+{
+    if (samples.count == 0)
+        return 0;
+
+    int i = (int)ceil(p * samples.count) - 1;
+    i = dtClamp(i, 0, samples.count - 1);
+    return samples.times[i];
+}
+
+static void nbPrintHeader()
+{
+    printf("%-22s %8s %10s %10s %12s %12s %12s\n"
+        , "workload", "samples", "p50 (us)", "p99 (us)"
+        , "items/s", "dt peak KB", "proc peak KB");
+}
+
+/*
+ * The throughput is based on the summed latency, not the wall time, so the
+ * untimed setup between operations does not count.  itemsPerSample is the
+ * work done by one operation.  (E.g. The agent count of a crowd tick.)
+ */
+static void nbPrintResult(const char* name
+    , nbSamples& samples
+    , const int itemsPerSample)
+{
+    qsort(samples.times, samples.count, sizeof(double), nbCompareTimes);
+
+    double total = 0;
+    for (int i = 0; i < samples.count; i++)
+        total += samples.times[i];
+
+    const double throughput = total > 0
+        ? (double)samples.count * itemsPerSample * 1000000.0 / total : 0;
+
+    printf("%-22s %8d %10.2f %10.2f %12.0f %12ld %12ld\n"
+        , name
+        , samples.count
+        , nbGetPercentile(samples, 0.5)
+        , nbGetPercentile(samples, 0.99)
+        , throughput
+        , (long)(sPeakBytes / 1024)
+        , nbGetProcessPeakKB());
+}
+
+static unsigned char* nbReadFile(const char* path, int* size)
+{
+    *size = 0;
+
+    FILE* fp = fopen(path, "rb");
+    if (!fp)
+        return 0;
+
+    fseek(fp, 0, SEEK_END);
+    const long length = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    unsigned char* data = length > 0 ? (unsigned char*)malloc(length) : 0;
+    if (data && fread(data, 1, length, fp) != (size_t)length)
+    {
+        free(data);
+        data = 0;
+    }
+    fclose(fp);
+
+    if (data)
+        *size = (int)length;
+
+    return data;
+}
+
+static bool nbParseArgs(int argc, char** argv, nbSettings& settings, const char** path)
+{
+    settings.seed = 1;
+    settings.queryCount = 10000;
+    settings.tickCount = 300;
+    settings.agentCounts[0] = 100;
+    settings.agentCounts[1] = 1000;
+    settings.agentCounts[2] = 4000;
+    settings.agentCountCount = 3;
+
+    *path = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc)
+            settings.seed = (unsigned int)strtoul(argv[++i], 0, 10);
+        else if (strcmp(argv[i], "-queries") == 0 && i + 1 < argc)
+            settings.queryCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-ticks") == 0 && i + 1 < argc)
+            settings.tickCount = atoi(argv[++i]);
+        else if (argv[i][0] != '-' && !*path)
+            *path = argv[i];
+        else
+            return false;
+    }
+
+    return *path && settings.queryCount > 0 && settings.tickCount > 0;
+}
+
+/*
+ * Query workloads
+ *
+ * The start and end points are picked up front with findRandomPoint, so
+ * every workload gets the same points.
+ */
+
+struct nbQueryPoints
+{
+    dtPolyRef* refs;
+    float* points;
+    int count;
+};
+
+static bool nbBuildQueryPoints(dtNavMeshQuery& query
+    , const dtQueryFilter& filter
+    , const int count
+    , nbQueryPoints& result)
+{
+    result.refs = (dtPolyRef*)malloc(sizeof(dtPolyRef) * count);
+    result.points = (float*)malloc(sizeof(float) * 3 * count);
+    result.count = 0;
+
+    if (!result.refs || !result.points)
+        return false;
+
+    for (int i = 0; i < count; i++)
+    {
+        dtPolyRef ref = 0;
+        float* pt = &result.points[result.count * 3];
+        if (dtStatusSucceed(query.findRandomPoint(&filter, nbRandom, &ref, pt)) && ref)
+            result.refs[result.count++] = ref;
+    }
+
+    return result.count > 1;
+}
+
+static void nbFreeQueryPoints(nbQueryPoints& points)
+{
+    free(points.refs);
+    free(points.points);
+    points.refs = 0;
+    points.points = 0;
+    points.count = 0;
+}
+
+static void nbRunQueries(dtNavMesh& navmesh
+    , dtNavMeshQuery& query
+    , const dtQueryFilter& filter
+    , const nbQueryPoints& pts
+    , const float* extents
+    , const int count)
+{
+    nbSamples samples;
+    if (!nbInitSamples(samples, count))
+        return;
+
+    dtPolyRef path[NB_MAX_PATH];
+    float straight[NB_MAX_PATH * 3];
+    float pos[3];
+    float hitNormal[3];
+    int pathCount;
+    int straightCount;
+
+    // Pairs are picked from the point list so a path is never to itself.
+    const int n = pts.count;
+
+    nbResetPeak();
+    for (int i = 0; i < count; i++)
+    {
+        float center[3];
+        dtVcopy(center, &pts.points[(i % n) * 3]);
+        center[0] += (nbRandom() - 0.5f) * extents[0];
+        center[2] += (nbRandom() - 0.5f) * extents[2];
+
+        dtPolyRef ref;
+        const double start = nbGetTimeUsec();
+        query.findNearestPoly(center, extents, &filter, &ref, pos);
+        nbAddSample(samples, nbGetTimeUsec() - start);
+    }
+    nbPrintResult("findNearestPoly", samples, 1);
+
+    // Wide searches, where the polygon grids avoid testing every 
+    // polygon in the search box.
+    float wide[3];
+    dtVscale(wide, extents, 8.0f);
+    for (int grid = 0; grid < 2; grid++)
+    {
+        if (grid && dtStatusFailed(navmesh.setPolyGridsEnabled(true)))
+            break;
+
+        samples.count = 0;
+        nbResetPeak();
+        for (int i = 0; i < count; i++)
+        {
+            const float* center = &pts.points[(i % n) * 3];
+            dtPolyRef ref;
+            const double start = nbGetTimeUsec();
+            query.findNearestPoly(center, wide, &filter, &ref, pos
+                , grid ? DT_NEARESTPOLY_GRID : 0);
+            nbAddSample(samples, nbGetTimeUsec() - start);
+        }
+        nbPrintResult(grid ? "nearestPoly wide grid" : "nearestPoly wide", samples, 1);
+    }
+    navmesh.setPolyGridsEnabled(false);
+
+    samples.count = 0;
+    nbResetPeak();
+    for (int i = 0; i < count; i++)
+    {
+        const int a = i % n;
+        const int b = (i + 1 + (i / n)) % n;
+        const float* startPos = &pts.points[a * 3];
+        const float* endPos = &pts.points[b * 3];
+
+        const double start = nbGetTimeUsec();
+        const dtStatus status = query.findPath(pts.refs[a], pts.refs[b]
+            , startPos, endPos, &filter, path, &pathCount, NB_MAX_PATH);
+        if (dtStatusSucceed(status) && pathCount > 0)
+        {
+            // Partial paths end at the closest point on the last polygon.
+            dtVcopy(pos, endPos);
+            if (path[pathCount - 1] != pts.refs[b])
+                query.closestPointOnPoly(path[pathCount - 1], endPos, pos, 0);
+
+            query.findStraightPath(startPos, pos, path, pathCount
+                , straight, 0, 0, &straightCount, NB_MAX_PATH);
+        }
+        nbAddSample(samples, nbGetTimeUsec() - start);
+    }
+    nbPrintResult("findPath+straight", samples, 1);
+
+    samples.count = 0;
+    nbResetPeak();
+    for (int i = 0; i < count; i++)
+    {
+        const int a = i % n;
+        const int b = (i + 1 + (i / n)) % n;
+
+        float t;
+        const double start = nbGetTimeUsec();
+        query.raycast(pts.refs[a], &pts.points[a * 3], &pts.points[b * 3]
+            , &filter, &t, hitNormal, path, &pathCount, NB_MAX_PATH);
+        nbAddSample(samples, nbGetTimeUsec() - start);
+    }
+    nbPrintResult("raycast", samples, 1);
+
+    // Short moves, since this is how the corridor uses it.
+    const float moveDist = dtMax(extents[0], extents[2]) * 2;
+
+    samples.count = 0;
+    nbResetPeak();
+    for (int i = 0; i < count; i++)
+    {
+        const int a = i % n;
+        const float* startPos = &pts.points[a * 3];
+        const float angle = nbRandom() * 2 * NB_PI;
+
+        float target[3];
+        target[0] = startPos[0] + cosf(angle) * moveDist;
+        target[1] = startPos[1];
+        target[2] = startPos[2] + sinf(angle) * moveDist;
+
+        dtPolyRef visited[NB_MAX_VISITED];
+        int visitedCount;
+        const double start = nbGetTimeUsec();
+        query.moveAlongSurface(pts.refs[a], startPos, target, &filter
+            , pos, visited, &visitedCount, NB_MAX_VISITED);
+        nbAddSample(samples, nbGetTimeUsec() - start);
+    }
+    nbPrintResult("moveAlongSurface", samples, 1);
+
+    nbFreeSamples(samples);
+}
+
+/*
+ * Crowd workloads
+ *
+ * Agents that reach their target are given the next point, outside the
+ * timed update, so the crowd stays busy for the whole run.
+ */
+
+static void nbRunCrowd(dtNavMesh* navmesh
+    , const nbQueryPoints& pts
+    , const float* agentSize
+    , const int agentCount
+    , const int tickCount)
+{
+    nbSamples samples;
+    if (!nbInitSamples(samples, tickCount))
+        return;
+
+    nbResetPeak();
+
+    dtCrowd* crowd = dtAllocCrowd();
+    if (!crowd || !crowd->init(agentCount, agentSize[0], navmesh))
+    {
+        printf("crowd %d: init failed.\n", agentCount);
+        dtFreeCrowd(crowd);
+        nbFreeSamples(samples);
+        return;
+    }
+
+    dtCrowdAgentParams params;
+    memset(&params, 0, sizeof(params));
+    params.radius = agentSize[0];
+    params.height = agentSize[1];
+    params.maxAcceleration = 8.0f;
+    params.maxSpeed = 3.5f;
+    params.collisionQueryRange = params.radius * 12.0f;
+    params.pathOptimizationRange = params.radius * 30.0f;
+    params.separationWeight = 2.0f;
+    params.updateFlags = DT_CROWD_ANTICIPATE_TURNS
+        | DT_CROWD_OPTIMIZE_VIS
+        | DT_CROWD_OPTIMIZE_TOPO
+        | DT_CROWD_OBSTACLE_AVOIDANCE
+        | DT_CROWD_SEPARATION;
+
+    const int n = pts.count;
+    int next = 0;
+
+    for (int i = 0; i < agentCount; i++)
+    {
+        const int idx = crowd->addAgent(&pts.points[(next % n) * 3], &params);
+        next++;
+        if (idx >= 0)
+        {
+            crowd->requestMoveTarget(idx, pts.refs[next % n], &pts.points[(next % n) * 3]);
+            next++;
+        }
+    }
+
+    const float arriveDist = params.radius * 2;
+
+    for (int tick = 0; tick < tickCount; tick++)
+    {
+        const double start = nbGetTimeUsec();
+        crowd->update(NB_CROWD_DT, 0);
+        nbAddSample(samples, nbGetTimeUsec() - start);
+
+        for (int i = 0; i < crowd->getAgentCount(); i++)
+        {
+            const dtCrowdAgent* ag = crowd->getAgent(i);
+            if (!ag->active || ag->targetState != DT_CROWDAGENT_TARGET_VALID)
+                continue;
+
+            if (dtVdist2DSqr(ag->npos, ag->targetPos) < dtSqr(arriveDist))
+            {
+                crowd->requestMoveTarget(i, pts.refs[next % n], &pts.points[(next % n) * 3]);
+                next++;
+            }
+        }
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "crowd tick %d", agentCount);
+    nbPrintResult(name, samples, agentCount);
+
+    dtFreeCrowd(crowd);
+    nbFreeSamples(samples);
+}
+
+/*
+ * Tile build workload
+ *
+ * The input geometry is the detail surface of the loaded mesh, and the
+ * configuration is derived from the tile headers.  So the build is close to
+ * the one that made the mesh, which is enough to track its cost.  The cell
+ * height is not stored in the mesh, so half the cell size is used.
+ *
+ * Each tile is built with a separate single threaded call so that the
+ * latency is per tile.
+ */
+
+struct nbBuildInput
+{
+    float* verts;
+    int* tris;
+    unsigned char* areas;
+    int triCount;
+};
+
+static bool nbExtractGeometry(const dtNavMesh& navmesh, nbBuildInput& input)
+{
+    memset(&input, 0, sizeof(input));
+
+    int triCount = 0;
+    for (int i = 0; i < navmesh.getMaxTiles(); i++)
+    {
+        const dtMeshTile* tile = navmesh.getTile(i);
+        if (tile && tile->header)
+            triCount += tile->header->detailTriCount;
+    }
+
+    if (triCount == 0)
+        return false;
+
+    input.verts = (float*)malloc(sizeof(float) * 9 * triCount);
+    input.tris = (int*)malloc(sizeof(int) * 3 * triCount);
+    input.areas = (unsigned char*)malloc(sizeof(unsigned char) * triCount);
+    if (!input.verts || !input.tris || !input.areas)
+        return false;
+
+    for (int i = 0; i < navmesh.getMaxTiles(); i++)
+    {
+        const dtMeshTile* tile = navmesh.getTile(i);
+        if (!tile || !tile->header)
+            continue;
+
+        for (int j = 0; j < tile->header->polyCount; j++)
+        {
+            const dtPoly& poly = tile->polys[j];
+            if (poly.getType() == DT_POLYTYPE_OFFMESH_CONNECTION)
+                continue;
+
+            const dtPolyDetail& pd = tile->detailMeshes[j];
+            float buf[DT_MAX_DETAIL_VERTS * 3];
+            const float* dverts = dtGetDetailVerts(tile, &poly, &pd, buf);
+            for (int k = 0; k < pd.triCount; k++)
+            {
+                const unsigned char* t = &tile->detailTris[(pd.triBase + k) * 4];
+                const int t0 = input.triCount * 3;
+                for (int m = 0; m < 3; m++)
+                {
+                    const float* v = t[m] < poly.vertCount
+                        ? &tile->verts[poly.verts[t[m]] * 3]
+                        : &dverts[(t[m] - poly.vertCount) * 3];
+                    dtVcopy(&input.verts[(t0 + m) * 3], v);
+                }
+
+                input.tris[t0 + 0] = t0 + 0;
+                input.tris[t0 + 1] = t0 + 1;
+                input.tris[t0 + 2] = t0 + 2;
+                input.areas[input.triCount] = poly.getArea()
+                    ? poly.getArea() : RC_WALKABLE_AREA;
+                input.triCount++;
+            }
+        }
+    }
+
+    return input.triCount > 0;
+}
+
+static void nbFreeGeometry(nbBuildInput& input)
+{
+    free(input.verts);
+    free(input.tris);
+    free(input.areas);
+    memset(&input, 0, sizeof(input));
+}
+
+static bool nbDeriveConfig(const dtNavMesh& navmesh, rcConfig& config, int* tileMin)
+{
+    memset(&config, 0, sizeof(config));
+
+    const dtMeshHeader* first = 0;
+    float bmin[3] = { 0, 0, 0 };
+    float bmax[3] = { 0, 0, 0 };
+    tileMin[0] = 0;
+    tileMin[1] = 0;
+
+    for (int i = 0; i < navmesh.getMaxTiles(); i++)
+    {
+        const dtMeshTile* tile = navmesh.getTile(i);
+        if (!tile || !tile->header)
+            continue;
+
+        const dtMeshHeader* header = tile->header;
+        if (!first)
+        {
+            first = header;
+            dtVcopy(bmin, header->bmin);
+            dtVcopy(bmax, header->bmax);
+            tileMin[0] = header->x;
+            tileMin[1] = header->y;
+        }
+        else
+        {
+            dtVmin(bmin, header->bmin);
+            dtVmax(bmax, header->bmax);
+            tileMin[0] = dtMin(tileMin[0], header->x);
+            tileMin[1] = dtMin(tileMin[1], header->y);
+        }
+    }
+
+    if (!first || first->bvQuantFactor <= 0)
+        return false;
+
+    const dtNavMeshParams* params = navmesh.getParams();
+
+    config.cs = 1.0f / first->bvQuantFactor;
+    config.ch = config.cs * 0.5f;
+
+    // Aligned to the mesh tile grid.
+    config.bmin[0] = params->orig[0] + tileMin[0] * params->tileWidth;
+    config.bmin[1] = bmin[1];
+    config.bmin[2] = params->orig[2] + tileMin[1] * params->tileHeight;
+    dtVcopy(config.bmax, bmax);
+    config.bmax[1] += config.ch * 2;
+
+    config.width = (int)ceilf((config.bmax[0] - config.bmin[0]) / config.cs);
+    config.height = (int)ceilf((config.bmax[2] - config.bmin[2]) / config.cs);
+    config.tileSize = (int)(params->tileWidth / config.cs + 0.5f);
+
+    config.walkableSlopeAngle = 45.0f;
+    config.walkableHeight = (int)ceilf(first->walkableHeight / config.ch);
+    config.walkableClimb = (int)floorf(first->walkableClimb / config.ch);
+    config.walkableRadius = (int)ceilf(first->walkableRadius / config.cs);
+    config.borderSize = config.walkableRadius + 3;
+    config.maxEdgeLen = (int)(12.0f / config.cs);
+    config.maxSimplificationError = 1.3f;
+    config.minRegionArea = 8 * 8;
+    config.mergeRegionArea = 20 * 20;
+    config.maxVertsPerPoly = DT_VERTS_PER_POLYGON;
+    config.detailSampleDist = config.cs * 6;
+    config.detailSampleMaxError = config.ch;
+
+    return config.tileSize > 0 && config.walkableHeight > 0;
+}
+
+static void nbRunTileBuild(const dtNavMesh& navmesh)
+{
+    nbBuildInput input;
+    rcConfig config;
+    int tileMin[2];
+
+    if (!nbExtractGeometry(navmesh, input) || !nbDeriveConfig(navmesh, config, tileMin))
+    {
+        printf("tile build: no usable geometry.\n");
+        nbFreeGeometry(input);
+        return;
+    }
+
+    const int gridWidth = (config.width + config.tileSize - 1) / config.tileSize;
+    const int gridDepth = (config.height + config.tileSize - 1) / config.tileSize;
+    const int tileCount = gridWidth * gridDepth;
+
+    nbSamples samples;
+    nmgBuildContext* ctx = nmbcAllocateContext(false);
+    if (!ctx || !nbInitSamples(samples, tileCount))
+    {
+        nmbcFreeContext(ctx);
+        nbFreeGeometry(input);
+        return;
+    }
+
+    nbResetPeak();
+
+    int completeCount = 0;
+    for (int tz = 0; tz < gridDepth; tz++)
+    {
+        for (int tx = 0; tx < gridWidth; tx++)
+        {
+            const int tile[2] = { tx, tz };
+            rcPolyMesh polyMesh;
+            nmgPolyMeshDetail detailMesh;
+            int maxVerts;
+            unsigned char result;
+
+            const double start = nbGetTimeUsec();
+            nmgBuildTiles(ctx, &config, RC_CONTOUR_TESS_WALL_EDGES, NB_TILE_FILTER_ALL
+                , input.verts, input.triCount * 3, input.tris, input.areas, input.triCount
+                , 0, 0, tile, 1, 1, 0
+                , &polyMesh, &detailMesh, &maxVerts, &result);
+            nbAddSample(samples, nbGetTimeUsec() - start);
+
+            if (result == NB_TILE_COMPLETE)
+                completeCount++;
+
+            rcpmFreeMeshData(&polyMesh);
+            rcpdFreeMeshData(&detailMesh);
+        }
+    }
+
+    printf("(tile build: %d of %d tiles, %d tris, cs %.3f ch %.3f tile size %d)\n"
+        , completeCount, tileCount, input.triCount, config.cs, config.ch, config.tileSize);
+    nbPrintResult("tile build", samples, 1);
+
+    // Several agent sizes, built one after the other and then from one 
+    // shared rasterization.  The border must suit the largest radius.
+    rcConfig profileConfig = config;
+    int radii[NB_TILE_PROFILES];
+    for (int i = 0; i < NB_TILE_PROFILES; i++)
+        radii[i] = dtMax(config.walkableRadius, 1) * (i + 1);
+    profileConfig.borderSize = radii[NB_TILE_PROFILES - 1] + 3;
+
+    nbSamples separateSamples;
+    nbSamples sharedSamples;
+    if (!nbInitSamples(separateSamples, tileCount) || !nbInitSamples(sharedSamples, tileCount))
+    {
+        nbFreeSamples(separateSamples);
+        nmbcFreeContext(ctx);
+        nbFreeSamples(samples);
+        nbFreeGeometry(input);
+        return;
+    }
+
+    for (int tz = 0; tz < gridDepth; tz++)
+    {
+        for (int tx = 0; tx < gridWidth; tx++)
+        {
+            const int tile[2] = { tx, tz };
+            rcPolyMesh polyMeshes[NB_TILE_PROFILES];
+            nmgPolyMeshDetail detailMeshes[NB_TILE_PROFILES];
+            int maxVerts[NB_TILE_PROFILES];
+            unsigned char results[NB_TILE_PROFILES];
+
+            double start = nbGetTimeUsec();
+            for (int i = 0; i < NB_TILE_PROFILES; i++)
+            {
+                profileConfig.walkableRadius = radii[i];
+                nmgBuildTiles(ctx, &profileConfig, RC_CONTOUR_TESS_WALL_EDGES, NB_TILE_FILTER_ALL
+                    , input.verts, input.triCount * 3, input.tris, input.areas, input.triCount
+                    , 0, 0, tile, 1, 1, 0
+                    , &polyMeshes[i], &detailMeshes[i], &maxVerts[i], &results[i]);
+            }
+            nbAddSample(separateSamples, nbGetTimeUsec() - start);
+
+            for (int i = 0; i < NB_TILE_PROFILES; i++)
+            {
+                rcpmFreeMeshData(&polyMeshes[i]);
+                rcpdFreeMeshData(&detailMeshes[i]);
+            }
+
+            start = nbGetTimeUsec();
+            nmgBuildTileProfiles(ctx, &profileConfig, RC_CONTOUR_TESS_WALL_EDGES, NB_TILE_FILTER_ALL
+                , input.verts, input.triCount * 3, input.tris, input.areas, input.triCount
+                , 0, 0, radii, NB_TILE_PROFILES, tile, 1, 1
+                , polyMeshes, detailMeshes, maxVerts, results);
+            nbAddSample(sharedSamples, nbGetTimeUsec() - start);
+
+            for (int i = 0; i < NB_TILE_PROFILES; i++)
+            {
+                rcpmFreeMeshData(&polyMeshes[i]);
+                rcpdFreeMeshData(&detailMeshes[i]);
+            }
+        }
+    }
+
+    printf("(tile profiles: radii %d, %d, %d)\n", radii[0], radii[1], radii[2]);
+    nbPrintResult("tile build x3 separate", separateSamples, 1);
+    nbPrintResult("tile build x3 shared", sharedSamples, 1);
+
+    nmbcFreeContext(ctx);
+    nbFreeSamples(samples);
+    nbFreeSamples(separateSamples);
+    nbFreeSamples(sharedSamples);
+    nbFreeGeometry(input);
+}
+
+/*
+ * Rasterization check
+ *
+ * Rasterizes the same triangles with the default flags and with
+ * RC_RASTERIZE_FAST, and requires the same spans in every column.  (The 
+ * heights may differ by one step.)  The scene is the input the fast path
+ * is most likely to get wrong: axis-aligned walls on and off the column 
+ * boundaries, and triangles that cross the edges of the heightfield.
+ */
+
+static const int NB_CHECK_SIZE = 64;
+static const int NB_CHECK_WALLS = 400;
+static const int NB_CHECK_TRIS = 400;
+
+static void nbAddCheckWall(float* verts, int* tris, int& nverts, int& ntris
+    , const bool alongZ, const float c, const float a0, const float a1
+    , const float y0, const float y1)
+{
+    for (int k = 0; k < 4; k++)
+    {
+        const float a = (k == 0 || k == 3) ? a0 : a1;
+        float* v = &verts[(nverts + k) * 3];
+        v[0] = alongZ ? c : a;
+        v[1] = k < 2 ? y0 : y1;
+        v[2] = alongZ ? a : c;
+    }
+
+    const int quad[6] = { 0, 1, 2, 0, 2, 3 };
+    for (int k = 0; k < 6; k++)
+        tris[ntris * 3 + k] = nverts + quad[k];
+
+    nverts += 4;
+    ntris += 2;
+}
+
+static bool nbCheckRasterizeModes()
+{
+    const float cs = 0.25f;
+    const float ch = 0.2f;
+    const float size = NB_CHECK_SIZE * cs;
+    const float bmin[3] = { 0, 0, 0 };
+    const float bmax[3] = { size, 20, size };
+
+    const int maxVerts = NB_CHECK_WALLS * 4 + NB_CHECK_TRIS * 3;
+    const int maxTris = NB_CHECK_WALLS * 2 + NB_CHECK_TRIS;
+    float* verts = new float[maxVerts * 3];
+    int* tris = new int[maxTris * 3];
+    unsigned char* areas = new unsigned char[maxTris];
+
+    sRandomState = 1;
+
+    int nverts = 0;
+    int ntris = 0;
+    for (int i = 0; i < NB_CHECK_WALLS; i++)
+    {
+        // Most walls lie on a column boundary, some a little outside the 
+        // heightfield.
+        float c = (float)((int)(nbRandom() * (NB_CHECK_SIZE + 8)) - 4) * cs;
+        if (i % 4 == 0)
+            c += nbRandom() * cs;
+        const float a0 = nbRandom() * (size + 4) - 2;
+        const float y0 = nbRandom() * 5;
+        nbAddCheckWall(verts, tris, nverts, ntris, (i & 1) != 0
+            , c, a0, a0 + nbRandom() * 10, y0, y0 + nbRandom() * 6);
+    }
+
+    for (int i = 0; i < NB_CHECK_TRIS; i++)
+    {
+        const float cx = nbRandom() * (size + 6) - 3;
+        const float cz = nbRandom() * (size + 6) - 3;
+        for (int k = 0; k < 3; k++)
+        {
+            float* v = &verts[nverts * 3];
+            v[0] = cx + nbRandom() * 6 - 3;
+            v[1] = nbRandom() * 10;
+            v[2] = cz + nbRandom() * 6 - 3;
+            tris[ntris * 3 + k] = nverts++;
+        }
+        ntris++;
+    }
+
+    for (int i = 0; i < ntris; i++)
+        areas[i] = (unsigned char)(1 + i % 62);
+
+    rcContext ctx(false);
+    rcHeightfield* hfs[2] = { rcAllocHeightfield(), rcAllocHeightfield() };
+    bool ok = hfs[0] && hfs[1];
+    for (int i = 0; ok && i < 2; i++)
+    {
+        ok = rcCreateHeightfield(&ctx, *hfs[i], NB_CHECK_SIZE, NB_CHECK_SIZE, bmin, bmax, cs, ch);
+        if (ok)
+        {
+            rcRasterizeTriangles(&ctx, verts, nverts, tris, areas, ntris, *hfs[i], 1
+                , i ? RC_RASTERIZE_FAST : 0);
+        }
+    }
+
+    int spanCount = 0;
+    int diffCount = 0;
+    for (int i = 0; ok && i < NB_CHECK_SIZE * NB_CHECK_SIZE; i++)
+    {
+        const rcSpan* a = hfs[0]->spans[i];
+        const rcSpan* b = hfs[1]->spans[i];
+        bool same = true;
+        for (; a && b; a = a->next, b = b->next)
+        {
+            spanCount++;
+            if (a->area != b->area
+                || abs((int)a->smin - (int)b->smin) > 1
+                || abs((int)a->smax - (int)b->smax) > 1)
+            {
+                same = false;
+            }
+        }
+        if (a || b || !same)
+            diffCount++;
+    }
+
+    rcFreeHeightField(hfs[0]);
+    rcFreeHeightField(hfs[1]);
+    delete [] verts;
+    delete [] tris;
+    delete [] areas;
+
+    if (!ok)
+    {
+        printf("rasterize check: could not create the heightfields.\n");
+        return false;
+    }
+
+    printf("rasterize check: %d spans, %d of %d columns differ.\n"
+        , spanCount, diffCount, NB_CHECK_SIZE * NB_CHECK_SIZE);
+
+    return diffCount == 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc == 2 && strcmp(argv[1], "-check-raster") == 0)
+        return nbCheckRasterizeModes() ? 0 : 1;
+
+    nbSettings settings;
+    const char* path;
+    if (!nbParseArgs(argc, argv, settings, &path))
+    {
+        printf("Usage: NavBench <navmesh file> [-seed n] [-queries n] [-ticks n]\n");
+        printf("       NavBench -check-raster\n");
+        return 1;
+    }
+
+    // Before anything is allocated.
+    dtAllocSetCustom(nbAlloc, nbFree);
+
+    int dataSize;
+    unsigned char* data = nbReadFile(path, &dataSize);
+    if (!data)
+    {
+        printf("Could not read: %s\n", path);
+        return 1;
+    }
+
+    dtNavMesh* navmesh = 0;
+    const double loadStart = nbGetTimeUsec();
+    const dtStatus status = dtnmBuildDTNavMeshFromRaw(data, dataSize, true, &navmesh);
+    const double loadTime = nbGetTimeUsec() - loadStart;
+    free(data);
+
+    if (dtStatusFailed(status) || !navmesh)
+    {
+        printf("Could not load the navigation mesh: 0x%x\n", (unsigned int)status);
+        return 1;
+    }
+
+    // The agent size comes from the tiles, so the crowd matches the mesh.
+    float agentSize[2] = { 0, 0 };
+    float extents[3] = { 0, 0, 0 };
+    int tileCount = 0;
+    int polyCount = 0;
+    for (int i = 0; i < navmesh->getMaxTiles(); i++)
+    {
+        const dtMeshTile* tile = ((const dtNavMesh*)navmesh)->getTile(i);
+        if (!tile || !tile->header)
+            continue;
+
+        tileCount++;
+        polyCount += tile->header->polyCount;
+        agentSize[0] = dtMax(agentSize[0], tile->header->walkableRadius);
+        agentSize[1] = dtMax(agentSize[1], tile->header->walkableHeight);
+    }
+
+    if (agentSize[0] <= 0)
+        agentSize[0] = 0.5f;
+    if (agentSize[1] <= 0)
+        agentSize[1] = 2.0f;
+
+    extents[0] = agentSize[0] * 4;
+    extents[1] = agentSize[1];
+    extents[2] = agentSize[0] * 4;
+
+    printf("%s: %d tiles, %d polys, %d bytes, loaded in %.0f us, seed %u\n"
+        , path, tileCount, polyCount, dataSize, loadTime, settings.seed);
+
+    sRandomState = settings.seed;
+
+    dtNavMeshQuery* query = dtAllocNavMeshQuery();
+    // Enough nodes for long paths on large meshes.
+    if (!query || dtStatusFailed(query->init(navmesh, 4096)))
+    {
+        printf("Could not initialize the query.\n");
+        dtFreeNavMeshQuery(query);
+        dtFreeNavMesh(navmesh);
+        return 1;
+    }
+
+    dtQueryFilter filter;
+    nbQueryPoints pts;
+    if (!nbBuildQueryPoints(*query, filter, settings.queryCount, pts))
+    {
+        printf("Could not find query points.\n");
+        nbFreeQueryPoints(pts);
+        dtFreeNavMeshQuery(query);
+        dtFreeNavMesh(navmesh);
+        return 1;
+    }
+
+    printf("\n");
+    nbPrintHeader();
+
+    nbRunQueries(*navmesh, *query, filter, pts, extents, settings.queryCount);
+
+    for (int i = 0; i < settings.agentCountCount; i++)
+        nbRunCrowd(navmesh, pts, agentSize, settings.agentCounts[i], settings.tickCount);
+
+    nbRunTileBuild(*navmesh);
+
+    nbFreeQueryPoints(pts);
+    dtFreeNavMeshQuery(query);
+    dtFreeNavMesh(navmesh);
+
+    return 0;
+}
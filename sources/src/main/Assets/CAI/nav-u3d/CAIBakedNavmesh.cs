@@ -22,6 +22,11 @@
 using UnityEngine;
 using org.critterai.nav;
 using org.critterai.nav.u3d;
+#if CAI_POLYREF64
+using TileRef = System.UInt64;
+#else
+using TileRef = System.UInt32;
+#endif
 
 /// <summary>
 /// Navigation mesh data that is baked at design time.
@@ -195,7 +200,7 @@ public sealed class CAIBakedNavmesh
             if (tile == null)
                 continue;
 
-            uint trash;
+            TileRef trash;
             status = navmesh.AddTile(tile, Navmesh.NullTile, out trash);
 
             if ((status & NavStatus.Sucess) == 0)
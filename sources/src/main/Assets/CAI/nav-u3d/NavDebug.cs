@@ -22,6 +22,11 @@
 using UnityEngine;
 using org.critterai.geom;
 using org.critterai.u3d;
+#if CAI_POLYREF64
+using PolyRef = System.UInt64;
+#else
+using PolyRef = System.UInt32;
+#endif
 
 namespace org.critterai.nav.u3d
 {
@@ -154,7 +159,7 @@ namespace org.critterai.nav.u3d
         /// <param name="polyCount">
         /// The number of polygons in the <paramref name="markPolys"/> array.
         /// </param>
-        public static void Draw(Navmesh mesh, uint[] markPolys, int polyCount)
+        public static void Draw(Navmesh mesh, PolyRef[] markPolys, int polyCount)
         {
             int count = mesh.GetMaxTiles();
             for (int i = 0; i < count; i++)
@@ -233,8 +238,8 @@ namespace org.critterai.nav.u3d
             DebugDraw.Circle(v, goalScale * 0.25f, goalColor);
         }
 
-        private static Color GetStandardColor(uint polyRef, int polyArea, int colorId
-            , NavmeshQuery query, uint[] markPolys, int markPolyCount)
+        private static Color GetStandardColor(PolyRef polyRef, int polyArea, int colorId
+            , NavmeshQuery query, PolyRef[] markPolys, int markPolyCount)
         {
             Color result;
 
@@ -270,7 +275,7 @@ namespace org.critterai.nav.u3d
         /// </para>
         /// </remarks>
         private static void Draw(NavmeshTile tile
-            , NavmeshQuery query, uint[] markPolys, int markPolyCount
+            , NavmeshQuery query, PolyRef[] markPolys, int markPolyCount
             , int colorId)
         {
             NavmeshTileHeader header = tile.GetHeader();
@@ -281,7 +286,7 @@ namespace org.critterai.nav.u3d
 
             DebugDraw.SimpleMaterial.SetPass(0);
 
-            uint polyBase = tile.GetBasePolyRef();
+            PolyRef polyBase = tile.GetBasePolyRef();
 
             NavmeshPoly[] polys = new NavmeshPoly[header.polyCount];
             tile.GetPolys(polys);
@@ -309,7 +314,7 @@ namespace org.critterai.nav.u3d
 
                 NavmeshDetailMesh mesh = meshes[i];
 
-                Color color = GetStandardColor(polyBase | (uint)i
+                Color color = GetStandardColor(polyBase | (PolyRef)i
                     , poly.Area, colorId
                     , query, markPolys, markPolyCount);
 
@@ -383,7 +388,7 @@ namespace org.critterai.nav.u3d
                 if (poly.Type != NavmeshPolyType.OffMeshConnection)
                     continue;
 
-                Color color = GetStandardColor(polyBase | (uint)i
+                Color color = GetStandardColor(polyBase | (PolyRef)i
                     , poly.Area, colorId
                     , query, markPolys, markPolyCount);
 
@@ -452,8 +457,8 @@ namespace org.critterai.nav.u3d
         /// Returns the index of the polygon reference within the list, or
         /// -1 if it was not found.
         /// </summary>
-        private static int IsInList(uint polyRef
-            , uint[] polyList
+        private static int IsInList(PolyRef polyRef
+            , PolyRef[] polyList
             , int polyCount)
         {
             if (polyList == null)
@@ -595,7 +600,7 @@ namespace org.critterai.nav.u3d
         /// </param>
         /// <returns>The actual number of polygons found within the mesh. </returns>
         public static int GetCentroids(Navmesh mesh
-            , uint[] polyRefs
+            , PolyRef[] polyRefs
             , int polyCount
             , Vector3[] centroids)
         {
@@ -617,7 +622,7 @@ namespace org.critterai.nav.u3d
         /// Gets the centroids for the polygons that are part of the tile.
         /// </summary>
         private static int GetCentroids(NavmeshTile tile
-            , uint[] polyRefs
+            , PolyRef[] polyRefs
             , int polyCount
             , Vector3[] centroids)
         {
@@ -626,7 +631,7 @@ namespace org.critterai.nav.u3d
             if (header.polyCount < 1)
                 return 0;
 
-            uint polyBase = tile.GetBasePolyRef();
+            PolyRef polyBase = tile.GetBasePolyRef();
 
             NavmeshPoly[] polys = new NavmeshPoly[header.polyCount];
             tile.GetPolys(polys);
@@ -638,7 +643,7 @@ namespace org.critterai.nav.u3d
 
             for (int i = 0; i < header.polyCount; i++)
             {
-                uint polyRef = polyBase | (uint)i;
+                PolyRef polyRef = polyBase | (PolyRef)i;
 
                 int iResult = IsInList(polyRef, polyRefs, polyCount);
 
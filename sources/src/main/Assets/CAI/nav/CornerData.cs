@@ -26,6 +26,11 @@ using Vector3 = org.critterai.Vector3;
 #else
 using Vector3 = UnityEngine.Vector3;
 #endif
+#if CAI_POLYREF64
+using PolyRef = System.UInt64;
+#else
+using PolyRef = System.UInt32;
+#endif
 
 namespace org.critterai.nav
 {
@@ -91,7 +96,7 @@ namespace org.critterai.nav
         /// </para>
         /// </remarks>
         [MarshalAs(UnmanagedType.ByValArray, SizeConst = MarshalBufferSize)]
-        public uint[] polyRefs;
+        public PolyRef[] polyRefs;
 
         /// <summary>
         /// Number of corners in the local path. [Limits: 0 &lt;= value &lt;= maxCorners]
@@ -124,7 +129,7 @@ namespace org.critterai.nav
         {
             verts = new Vector3[MarshalBufferSize];
             flags = new WaypointFlag[MarshalBufferSize];
-            polyRefs = new uint[MarshalBufferSize];
+            polyRefs = new PolyRef[MarshalBufferSize];
         }
 
         /// <summary>
@@ -135,7 +140,7 @@ namespace org.critterai.nav
         {
             verts = new Vector3[maxCorners];
             flags = new WaypointFlag[maxCorners];
-            polyRefs = new uint[maxCorners];
+            polyRefs = new PolyRef[maxCorners];
         }
 
         /// <summary>
@@ -27,6 +27,11 @@ using Vector3 = org.critterai.Vector3;
 #else
 using Vector3 = UnityEngine.Vector3;
 #endif
+#if CAI_POLYREF64
+using PolyRef = System.UInt64;
+#else
+using PolyRef = System.UInt32;
+#endif
 
 namespace org.critterai.nav
 {
@@ -102,7 +107,7 @@ namespace org.critterai.nav
         /// <summary>
         /// The reference of the polygon containing the agent position.
         /// </summary>
-        public uint PositionPoly
+        public PolyRef PositionPoly
         {
             get { return mManager.agentStates[managerIndex].positionPoly; }
         }
@@ -123,7 +128,7 @@ namespace org.critterai.nav
         /// <summary>
         /// The reference of the polygon containing the target.
         /// </summary>
-        public uint TargetPoly
+        public PolyRef TargetPoly
         {
             get { return mManager.agentStates[managerIndex].targetPoly; }
         }
@@ -150,7 +155,7 @@ namespace org.critterai.nav
         /// target.
         /// </para>
         /// </remarks>
-        public uint NextCornerPoly
+        public PolyRef NextCornerPoly
         {
             get { return mManager.agentStates[managerIndex].nextCornerPoly; }
         }
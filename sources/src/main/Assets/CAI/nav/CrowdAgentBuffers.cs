@@ -0,0 +1,100 @@
+﻿/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+using System;
+using System.Runtime.InteropServices;
+#if CAI_POLYREF64
+using PolyRef = System.UInt64;
+#else
+using PolyRef = System.UInt32;
+#endif
+
+namespace org.critterai.nav
+{
+    /// <summary>
+    /// Pinned structure-of-arrays buffers used to bulk export agent state from a 
+    /// <see cref="CrowdManager"/>.
+    /// </summary>
+    /// <remarks>
+    /// <para>
+    /// All pointers must reference pinned memory that stays valid for the duration of the 
+    /// interop call.  A zero pointer disables the associated buffer.  The buffers must be 
+    /// reused between calls since their content is used to detect which agents changed.
+    /// </para>
+    /// </remarks>
+    [StructLayout(LayoutKind.Sequential)]
+    internal struct CrowdAgentBuffers
+    {
+        /*
+         * Duplicate of: rcnCrowdAgentBuffers
+         */
+
+        /// <summary>
+        /// Agent states. [(byte) * maxAgents]  (Zero for inactive agents.)
+        /// </summary>
+        public IntPtr states;
+
+        /// <summary>
+        /// The reference of the polygon that contains each position. [(PolyRef) * maxAgents]
+        /// </summary>
+        public IntPtr positionPolys;
+
+        /// <summary>
+        /// Agent positions. [(x, y, z) * maxAgents]
+        /// </summary>
+        public IntPtr positions;
+
+        /// <summary>
+        /// Agent velocities. [(x, y, z) * maxAgents]
+        /// </summary>
+        public IntPtr velocities;
+
+        /// <summary>
+        /// Agent desired velocities. [(x, y, z) * maxAgents]
+        /// </summary>
+        public IntPtr desiredVelocities;
+
+        /// <summary>
+        /// The number of corners for each agent. [(int) * maxAgents]
+        /// </summary>
+        public IntPtr cornerCounts;
+
+        /// <summary>
+        /// Agent corners. [(x, y, z) * maxCorners * maxAgents]
+        /// </summary>
+        public IntPtr corners;
+
+        /// <summary>
+        /// The number of corners per agent in <see cref="corners"/>. (The buffer stride.)
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// At most <see cref="CornerData.MarshalBufferSize"/> corners are written per agent.
+        /// </para>
+        /// </remarks>
+        public int maxCorners;
+
+        /// <summary>
+        /// Bit set for each agent whose data changed. [(uint) * ((maxAgents + 31) / 32)]
+        /// </summary>
+        public IntPtr dirtyMask;
+    }
+}
@@ -25,6 +25,11 @@ using Vector3 = org.critterai.Vector3;
 #else
 using Vector3 = UnityEngine.Vector3;
 #endif
+#if CAI_POLYREF64
+using PolyRef = System.UInt64;
+#else
+using PolyRef = System.UInt32;
+#endif
 
 namespace org.critterai.nav
 {
@@ -57,18 +62,18 @@ namespace org.critterai.nav
         /// <summary>
         /// The reference of the polygon that contains the position.
         /// </summary>
-        public uint positionPoly;
+        public PolyRef positionPoly;
 
         /// <summary>
         /// The reference of the polygon that contains the target.
         /// </summary>
-        public uint targetPoly;
+        public PolyRef targetPoly;
 
         /// <summary>
         /// The reference of the polygon the contains the next corner.
         /// (Or zero if the next corner is the target.)
         /// </summary>
-        public uint nextCornerPoly;
+        public PolyRef nextCornerPoly;
 
         /// <summary>
         /// The number of neighbors.
@@ -0,0 +1,60 @@
+﻿/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+namespace org.critterai.nav
+{
+    /// <summary>
+    /// The level of detail a <see cref="CrowdManager"/> agent is updated with.
+    /// </summary>
+    /// <remarks>
+    /// <para>
+    /// Unless overridden, the level of detail is chosen by the distance to the crowd's 
+    /// observers.  (See: <see cref="CrowdLodParams"/>)
+    /// </para>
+    /// </remarks>
+    public enum CrowdAgentLod : byte
+    {
+        /*
+         * Source: DetourCrowd.h dtCrowdAgentLod
+         */
+
+        /// <summary>
+        /// The agent is updated every tick.
+        /// </summary>
+        Full = 0,
+
+        /// <summary>
+        /// The agent is updated every <see cref="CrowdLodParams.reducedInterval"/> ticks.
+        /// </summary>
+        Reduced,
+
+        /// <summary>
+        /// The agent follows its corridor, with no neighbors, avoidance or collision.  
+        /// Updated every <see cref="CrowdLodParams.simpleInterval"/> ticks.
+        /// </summary>
+        Simple,
+
+        /// <summary>
+        /// The level of detail is chosen by observer distance.  (Only for overrides.)
+        /// </summary>
+        Auto = 0xff
+    }
+}
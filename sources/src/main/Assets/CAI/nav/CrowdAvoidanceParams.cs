@@ -110,6 +110,18 @@ namespace org.critterai.nav
         /// </summary>
         public byte adaptiveDepth = 5;
 
+        /// <summary>
+        /// Score the velocity samples four at a time using SIMD instructions, where the
+        /// platform supports them. [0 = off]
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// The results match the one-at-a-time scoring.  Debug sample data is always
+        /// collected one sample at a time.
+        /// </para>
+        /// </remarks>
+        public byte simdSampling = 1;
+
         /// <summary>
         /// Default constructor.
         /// </summary>
@@ -132,6 +144,7 @@ namespace org.critterai.nav
             result.adaptiveDivisions = adaptiveDivisions;
             result.adaptiveRings = adaptiveRings;
             result.adaptiveDepth = adaptiveDepth;
+            result.simdSampling = simdSampling;
             return result;
         }
 
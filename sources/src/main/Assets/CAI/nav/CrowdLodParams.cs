@@ -0,0 +1,62 @@
+﻿/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+using System.Runtime.InteropServices;
+
+namespace org.critterai.nav
+{
+    /// <summary>
+    /// Configures how a <see cref="CrowdManager"/> chooses the agent levels of detail.
+    /// </summary>
+    /// <remarks>
+    /// <para>
+    /// Agents further than a range from every observer use the corresponding level of detail.
+    /// Without observers all agents are fully updated.
+    /// </para>
+    /// </remarks>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct CrowdLodParams
+    {
+        /*
+         * Source: DetourCrowd.h dtCrowdLodParams (struct)
+         */
+
+        /// <summary>
+        /// The range beyond which agents use <see cref="CrowdAgentLod.Reduced"/>. [Limit: >= 0]
+        /// </summary>
+        public float reducedRange;
+
+        /// <summary>
+        /// The range beyond which agents use <see cref="CrowdAgentLod.Simple"/>. [Limit: >= 0]
+        /// </summary>
+        public float simpleRange;
+
+        /// <summary>
+        /// The number of ticks between the updates of a reduced agent. [Limit: >= 1]
+        /// </summary>
+        public int reducedInterval;
+
+        /// <summary>
+        /// The number of ticks between the updates of a simple agent. [Limit: >= 1]
+        /// </summary>
+        public int simpleInterval;
+    }
+}
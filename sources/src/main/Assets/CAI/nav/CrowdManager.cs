@@ -210,6 +210,35 @@ namespace org.critterai.nav
         /// </param>
         /// <returns>A new crowd manager, or null on error.</returns>
         public static CrowdManager Create(int maxAgents, float maxAgentRadius, Navmesh navmesh)
+        {
+            return Create(maxAgents, maxAgentRadius, navmesh, false);
+        }
+
+        /// <summary>
+        /// Creates a new crowd manager.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// The sorted proximity grid stores each agent once, sorted by cell, and only returns
+        /// agents whose bounds overlap a neighbour query.  It is usually faster than the default
+        /// hashed grid for large crowds.
+        /// </para>
+        /// </remarks>
+        /// <param name="maxAgents">
+        /// The maximum number of agents that can be added to the manager.
+        /// </param>
+        /// <param name="maxAgentRadius">The maximum allowed agent radius.</param>
+        /// <param name="navmesh">
+        /// The navigation mesh to use for path planning and steering related queries.
+        /// </param>
+        /// <param name="sortedGrid">
+        /// True if the sorted proximity grid should be used to find agent neighbours.
+        /// </param>
+        /// <returns>A new crowd manager, or null on error.</returns>
+        public static CrowdManager Create(int maxAgents
+            , float maxAgentRadius
+            , Navmesh navmesh
+            , bool sortedGrid)
         {
             if (navmesh == null || navmesh.IsDisposed)
                 return null;
@@ -218,7 +247,10 @@ namespace org.critterai.nav
             maxAgentRadius = Math.Max(0, maxAgentRadius);
 
             IntPtr root =
-                CrowdManagerEx.dtcDetourCrowdAlloc(maxAgents, maxAgentRadius, navmesh.root);
+                CrowdManagerEx.dtcDetourCrowdAlloc(maxAgents
+                    , maxAgentRadius
+                    , navmesh.root
+                    , sortedGrid ? 1 : 0);
 
             if (root == IntPtr.Zero)
                 return null;
@@ -379,6 +411,103 @@ namespace org.critterai.nav
             CrowdManagerEx.dtcUpdate(root, deltaTime, agentStates);
         }
 
+        /// <summary>
+        /// Gets the memory used by the manager, broken down by subsystem.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// The path and flow field caches attached to the manager are reported separately 
+        /// since the manager does not own them.
+        /// </para>
+        /// </remarks>
+        /// <returns>The memory used by the manager.</returns>
+        public CrowdMemoryStats GetMemoryStats()
+        {
+            CrowdMemoryStats stats = new CrowdMemoryStats();
+            if (!IsDisposed)
+                CrowdManagerEx.dtcGetMemoryStats(root, ref stats);
+            return stats;
+        }
+
+        /// <summary>
+        /// Gets the size of the buffer required by the <see cref="GetState"/> method.
+        /// </summary>
+        /// <returns>The size of the state data.</returns>
+        public int GetStateSize()
+        {
+            if (IsDisposed)
+                return 0;
+            return CrowdManagerEx.dtcGetStateSize(root);
+        }
+
+        /// <summary>
+        /// Gets the simulation state of the manager. (Agents, corridors, queued paths, 
+        /// and configuration.)
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// The state does not include the agent user data.  It is valid for any manager with 
+        /// the same maximum agent count whose navigation mesh has the same parameters and 
+        /// polygon references.
+        /// </para>
+        /// </remarks>
+        /// <param name="buffer">
+        /// The buffer to load the state into. [Length: >= <see cref="GetStateSize"/>]
+        /// </param>
+        /// <returns>The <see cref="NavStatus" /> flags for the operation.</returns>
+        public NavStatus GetState(byte[] buffer)
+        {
+            if (IsDisposed || buffer == null)
+                return (NavStatus.Failure | NavStatus.InvalidParam);
+
+            return CrowdManagerEx.dtcStoreState(root, buffer, buffer.Length);
+        }
+
+        /// <summary>
+        /// Replaces the simulation state of the manager with the state data.
+        /// (Obtained from the <see cref="GetState"/> method.)
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// All existing <see cref="CrowdAgent"/> objects are disposed, and new ones are created 
+        /// for the restored agents, at the same indices.  No path planning is needed to resume 
+        /// the simulation.
+        /// </para>
+        /// <para>
+        /// The manager will have no agents if the restore fails after the existing agents 
+        /// have been cleared.
+        /// </para>
+        /// </remarks>
+        /// <param name="stateData">The state data to apply.</param>
+        /// <returns>The <see cref="NavStatus" /> flags for the operation.</returns>
+        public NavStatus SetState(byte[] stateData)
+        {
+            if (IsDisposed || stateData == null)
+                return (NavStatus.Failure | NavStatus.InvalidParam);
+
+            IntPtr[] agents = new IntPtr[mAgents.Length];
+
+            NavStatus status = CrowdManagerEx.dtcRestoreState(root
+                , stateData
+                , stateData.Length
+                , agents
+                , agentStates);
+
+            for (int i = 0; i < mAgents.Length; i++)
+            {
+                if (mAgents[i] != null)
+                {
+                    mAgents[i].Dispose();
+                    mAgents[i] = null;
+                }
+
+                if (agents[i] != IntPtr.Zero)
+                    mAgents[i] = new CrowdAgent(this, agents[i], i);
+            }
+
+            return status;
+        }
+
         /// <summary>
         /// The extents used by the manager when it performs queries against the navigation mesh.
         /// </summary>
@@ -0,0 +1,81 @@
+﻿/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+using System.Runtime.InteropServices;
+
+namespace org.critterai.nav
+{
+    /// <summary>
+    /// The memory used by a crowd manager, in bytes, broken down by subsystem.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct CrowdMemoryStats
+    {
+        /*
+         * Source: DetourCrowd dtCrowdMemoryStats (struct)
+         */
+
+        /// <summary>
+        /// The crowd object and the agent tables.
+        /// </summary>
+        public int agentBytes;
+
+        /// <summary>
+        /// The agent path corridors.
+        /// </summary>
+        public int corridorBytes;
+
+        /// <summary>
+        /// The path request queue and its navigation query.
+        /// </summary>
+        public int pathQueueBytes;
+
+        /// <summary>
+        /// The navigation queries of the crowd and its workers.
+        /// </summary>
+        public int queryBytes;
+
+        /// <summary>
+        /// The obstacle avoidance queries of the crowd and its workers.
+        /// </summary>
+        public int avoidanceBytes;
+
+        /// <summary>
+        /// The proximity grid.
+        /// </summary>
+        public int proximityBytes;
+
+        /// <summary>
+        /// The wall segment cache.
+        /// </summary>
+        public int wallBytes;
+
+        /// <summary>
+        /// The attached path cache.  (Not owned by the crowd.)
+        /// </summary>
+        public int pathCacheBytes;
+
+        /// <summary>
+        /// The attached flow field cache.  (Not owned by the crowd.)
+        /// </summary>
+        public int flowFieldBytes;
+    }
+}
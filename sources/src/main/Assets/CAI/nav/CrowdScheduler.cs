@@ -0,0 +1,272 @@
+﻿/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+using System;
+using System.Runtime.InteropServices;
+using org.critterai.nav.rcn;
+using org.critterai.interop;
+
+namespace org.critterai.nav
+{
+    /// <summary>
+    /// Updates many crowd managers at once, across a pool of native worker threads.
+    /// </summary>
+    /// <remarks>
+    /// <para>
+    /// Each manager is updated as one task.  The managers that took longest on the previous 
+    /// update are started first, and a worker that runs out of managers takes over the ones 
+    /// another worker has not started.  So a few heavily populated managers do not hold up 
+    /// the quiet ones.
+    /// </para>
+    /// <para>
+    /// The managers may share a navigation mesh, but must not share a path cache or flow field 
+    /// cache.  The mesh must not be modified during <see cref="Update"/> unless concurrent reads 
+    /// are enabled on it.  (See: <see cref="Navmesh.EnableConcurrentReads"/>)
+    /// </para>
+    /// <para>
+    /// A manager must be removed before it is disposed.
+    /// </para>
+    /// <para>
+    /// Behavior is undefined if an object is used after disposal.
+    /// </para>
+    /// </remarks>
+    public sealed class CrowdScheduler
+        : IManagedObject
+    {
+        private IntPtr mRoot;
+        private CrowdManager[] mCrowds;
+        private IntPtr[] mStatePointers;
+        private GCHandle[] mStateHandles;
+        private float[] mTickTimes;
+        private int mCrowdCount;
+        private int mWorkerCount;
+
+        /// <summary>
+        /// The number of registered managers.
+        /// </summary>
+        public int CrowdCount { get { return mCrowdCount; } }
+
+        /// <summary>
+        /// The maximum number of managers that can be registered.
+        /// </summary>
+        public int MaxCrowds { get { return mCrowds.Length; } }
+
+        /// <summary>
+        /// The number of workers, including the thread that calls <see cref="Update"/>.
+        /// </summary>
+        public int WorkerCount { get { return mWorkerCount; } }
+
+        /// <summary>
+        /// The duration of the last <see cref="Update"/> call. [Unit: Microseconds]
+        /// </summary>
+        public float LastUpdateTime
+        {
+            get { return IsDisposed ? 0 : CrowdSchedulerEx.dtcsGetLastUpdateTime(mRoot); }
+        }
+
+        /// <summary>
+        /// The type of unmanaged resource used by the object.
+        /// </summary>
+        public AllocType ResourceType { get { return AllocType.External; } }
+
+        /// <summary>
+        /// True if the object has been disposed and should no longer be used.
+        /// </summary>
+        public bool IsDisposed { get { return (mRoot == IntPtr.Zero); } }
+
+        private CrowdScheduler(IntPtr root, int maxCrowds)
+        {
+            mRoot = root;
+            mCrowds = new CrowdManager[maxCrowds];
+            mStatePointers = new IntPtr[maxCrowds];
+            mStateHandles = new GCHandle[maxCrowds];
+            mTickTimes = new float[maxCrowds];
+            mWorkerCount = CrowdSchedulerEx.dtcsGetWorkerCount(root);
+        }
+
+        /// <summary>
+        /// Destructor.
+        /// </summary>
+        ~CrowdScheduler()
+        {
+            RequestDisposal();
+        }
+
+        /// <summary>
+        /// Immediately frees all unmanaged resources allocated by the object.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// The registered managers are not disposed.
+        /// </para>
+        /// </remarks>
+        public void RequestDisposal()
+        {
+            if (!IsDisposed)
+            {
+                CrowdSchedulerEx.dtcsFree(mRoot);
+                mRoot = IntPtr.Zero;
+                Array.Clear(mCrowds, 0, mCrowds.Length);
+                mCrowdCount = 0;
+            }
+        }
+
+        /// <summary>
+        /// Registers a manager.
+        /// </summary>
+        /// <param name="crowd">The manager to register.</param>
+        /// <returns>
+        /// The index of the manager, or -1 if the scheduler is full, the manager is already 
+        /// registered, or it shares a cache with a registered manager.
+        /// </returns>
+        public int Add(CrowdManager crowd)
+        {
+            if (IsDisposed || crowd == null || crowd.IsDisposed)
+                return -1;
+
+            int index = CrowdSchedulerEx.dtcsAddCrowd(mRoot, crowd.root);
+            if (index == -1)
+                return -1;
+
+            mCrowds[index] = crowd;
+            mTickTimes[index] = 0;
+            mCrowdCount++;
+
+            return index;
+        }
+
+        /// <summary>
+        /// Removes a manager.  The managers after it move down one index.
+        /// </summary>
+        /// <param name="crowd">The manager to remove.</param>
+        /// <returns>True if the manager was registered.</returns>
+        public bool Remove(CrowdManager crowd)
+        {
+            int index = IndexOf(crowd);
+            if (index == -1 || !CrowdSchedulerEx.dtcsRemoveCrowd(mRoot, crowd.root))
+                return false;
+
+            mCrowdCount--;
+            Array.Copy(mCrowds, index + 1, mCrowds, index, mCrowdCount - index);
+            Array.Copy(mTickTimes, index + 1, mTickTimes, index, mCrowdCount - index);
+            mCrowds[mCrowdCount] = null;
+
+            return true;
+        }
+
+        /// <summary>
+        /// Gets the index of a manager.
+        /// </summary>
+        /// <param name="crowd">The manager.</param>
+        /// <returns>The index of the manager, or -1 if it is not registered.</returns>
+        public int IndexOf(CrowdManager crowd)
+        {
+            if (crowd == null)
+                return -1;
+            return Array.IndexOf(mCrowds, crowd, 0, mCrowdCount);
+        }
+
+        /// <summary>
+        /// Gets a registered manager.
+        /// </summary>
+        /// <param name="index">The index of the manager.</param>
+        /// <returns>The manager.</returns>
+        public CrowdManager GetCrowd(int index)
+        {
+            return mCrowds[index];
+        }
+
+        /// <summary>
+        /// The duration of the manager's last update. [Unit: Microseconds]
+        /// </summary>
+        /// <param name="index">The index of the manager.</param>
+        /// <returns>The duration of the manager's last update.</returns>
+        public float GetTickTime(int index)
+        {
+            return mTickTimes[index];
+        }
+
+        /// <summary>
+        /// Updates all registered managers, as <see cref="CrowdManager.Update"/> does, and 
+        /// returns once all are complete.
+        /// </summary>
+        /// <param name="deltaTime">The time in seconds to update the simulation.</param>
+        /// <returns>The <see cref="NavStatus" /> flags for the operation.</returns>
+        public NavStatus Update(float deltaTime)
+        {
+            if (IsDisposed)
+                return NavStatus.Failure | NavStatus.InvalidParam;
+
+            for (int i = 0; i < mCrowdCount; i++)
+            {
+                mStateHandles[i] = GCHandle.Alloc(mCrowds[i].agentStates, GCHandleType.Pinned);
+                mStatePointers[i] = mStateHandles[i].AddrOfPinnedObject();
+            }
+
+            NavStatus status;
+            try
+            {
+                status = CrowdSchedulerEx.dtcUpdateAll(mRoot
+                    , deltaTime
+                    , mStatePointers
+                    , mTickTimes);
+            }
+            finally
+            {
+                for (int i = 0; i < mCrowdCount; i++)
+                {
+                    mStateHandles[i].Free();
+                    mStatePointers[i] = IntPtr.Zero;
+                }
+            }
+
+            return status;
+        }
+
+        /// <summary>
+        /// Creates a new crowd scheduler.
+        /// </summary>
+        /// <param name="maxCrowds">
+        /// The maximum number of managers that can be registered. [Limit: >= 1]
+        /// </param>
+        /// <param name="threadCount">
+        /// The number of worker threads in addition to the thread that calls  
+        /// <see cref="Update"/>.  Zero updates the managers one after the other. [Limit: >= 0]
+        /// </param>
+        /// <param name="resultScheduler">The new scheduler, or null on error.</param>
+        /// <returns>The <see cref="NavStatus" /> flags for the operation.</returns>
+        public static NavStatus Create(int maxCrowds
+            , int threadCount
+            , out CrowdScheduler resultScheduler)
+        {
+            resultScheduler = null;
+
+            IntPtr root = IntPtr.Zero;
+
+            NavStatus status = CrowdSchedulerEx.dtcsAlloc(maxCrowds, threadCount, ref root);
+
+            if (NavUtil.Succeeded(status))
+                resultScheduler = new CrowdScheduler(root, maxCrowds);
+
+            return status;
+        }
+    }
+}
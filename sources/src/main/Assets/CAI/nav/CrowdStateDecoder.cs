@@ -0,0 +1,163 @@
+﻿/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+using System;
+using org.critterai.nav.rcn;
+using org.critterai.interop;
+
+namespace org.critterai.nav
+{
+    /// <summary>
+    /// Applies the agent state streams written by a <see cref="CrowdStateEncoder"/>.
+    /// </summary>
+    /// <remarks>
+    /// <para>
+    /// The decoder must be created with the same limits and precisions as the encoder, and 
+    /// must be given every stream, in order.
+    /// </para>
+    /// <para>
+    /// Behavior is undefined if an object is used after disposal.
+    /// </para>
+    /// </remarks>
+    public sealed class CrowdStateDecoder
+        : IManagedObject
+    {
+        private IntPtr mRoot;
+        private readonly ReplicatedAgentState[] mStates;
+        private readonly uint[] mDirtyMask;
+
+        /// <summary>
+        /// The maximum number of agents supported by the decoder.
+        /// </summary>
+        public int MaxAgents { get { return mStates.Length; } }
+
+        /// <summary>
+        /// The replicated agent states, indexed by agent. [Length: <see cref="MaxAgents"/>]
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// The content is updated by <see cref="Read"/>.  Do not modify it.
+        /// </para>
+        /// </remarks>
+        public ReplicatedAgentState[] States { get { return mStates; } }
+
+        /// <summary>
+        /// The type of unmanaged resource used by the object.
+        /// </summary>
+        public AllocType ResourceType { get { return AllocType.External; } }
+
+        /// <summary>
+        /// True if the object has been disposed and should no longer be used.
+        /// </summary>
+        public bool IsDisposed { get { return (mRoot == IntPtr.Zero); } }
+
+        private CrowdStateDecoder(IntPtr root, int maxAgents)
+        {
+            mRoot = root;
+            mStates = new ReplicatedAgentState[maxAgents];
+            mDirtyMask = new uint[(maxAgents + 31) / 32];
+        }
+
+        /// <summary>
+        /// Destructor.
+        /// </summary>
+        ~CrowdStateDecoder()
+        {
+            RequestDisposal();
+        }
+
+        /// <summary>
+        /// Immediately frees all unmanaged resources allocated by the object.
+        /// </summary>
+        public void RequestDisposal()
+        {
+            if (!IsDisposed)
+            {
+                CrowdStreamEx.dtcsdFree(mRoot);
+                mRoot = IntPtr.Zero;
+            }
+        }
+
+        /// <summary>
+        /// True if the agent's state changed during the last <see cref="Read"/>.
+        /// </summary>
+        /// <param name="index">The agent index.</param>
+        /// <returns>True if the agent's state changed.</returns>
+        public bool IsDirty(int index)
+        {
+            return (mDirtyMask[index >> 5] & (1u << (index & 31))) != 0;
+        }
+
+        /// <summary>
+        /// Applies a stream to <see cref="States"/>.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// A keyframe clears all states first.  The states are unchanged if the stream is 
+        /// malformed.
+        /// </para>
+        /// </remarks>
+        /// <param name="stream">The stream buffer.</param>
+        /// <param name="size">The size of the stream.</param>
+        /// <returns>The <see cref="NavStatus" /> flags for the operation.</returns>
+        public NavStatus Read(byte[] stream, int size)
+        {
+            if (IsDisposed || stream == null || size < 0 || size > stream.Length)
+                return NavStatus.Failure | NavStatus.InvalidParam;
+
+            return CrowdStreamEx.dtcsdRead(mRoot, stream, size, mStates, mDirtyMask);
+        }
+
+        /// <summary>
+        /// Creates a new crowd state decoder.
+        /// </summary>
+        /// <param name="maxAgents">
+        /// The maximum number of agents supported by the decoder. [Limit: >= 1]
+        /// </param>
+        /// <param name="positionPrecision">
+        /// The position quantization step of the encoder. [Limit: > 0]
+        /// </param>
+        /// <param name="velocityPrecision">
+        /// The velocity quantization step of the encoder. [Limit: > 0]
+        /// </param>
+        /// <param name="resultDecoder">The new decoder, or null on error.</param>
+        /// <returns>The <see cref="NavStatus" /> flags for the operation.</returns>
+        public static NavStatus Create(int maxAgents
+            , float positionPrecision
+            , float velocityPrecision
+            , out CrowdStateDecoder resultDecoder)
+        {
+            resultDecoder = null;
+
+            IntPtr root = IntPtr.Zero;
+
+            NavStatus status = CrowdStreamEx.dtcsdAlloc(maxAgents
+                , positionPrecision
+                , velocityPrecision
+                , ref root);
+
+            if (NavUtil.Succeeded(status))
+                resultDecoder = new CrowdStateDecoder(root, maxAgents);
+
+            return status;
+        }
+    }
+}
@@ -0,0 +1,179 @@
+﻿/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+using System;
+using org.critterai.nav.rcn;
+using org.critterai.interop;
+
+namespace org.critterai.nav
+{
+    /// <summary>
+    /// Writes a compact stream of the agent state changes of a <see cref="CrowdManager"/>, 
+    /// for network replication.
+    /// </summary>
+    /// <remarks>
+    /// <para>
+    /// The positions and velocities are quantized to the configured precision and compared 
+    /// to the values last written for each agent.  Only the agents that changed are written, 
+    /// and only the fields that changed, as variable length deltas.  Agents that are standing 
+    /// still cost nothing.
+    /// </para>
+    /// <para>
+    /// Each stream is relative to the one before it, so the receiver must apply every stream, 
+    /// in order, with a <see cref="CrowdStateDecoder"/> of matching precision.  Use 
+    /// <see cref="Reset"/> to resynchronize a receiver.
+    /// </para>
+    /// <para>
+    /// Behavior is undefined if an object is used after disposal.
+    /// </para>
+    /// </remarks>
+    public sealed class CrowdStateEncoder
+        : IManagedObject
+    {
+        private IntPtr mRoot;
+        private readonly int mMaxAgents;
+
+        /// <summary>
+        /// The maximum number of agents supported by the encoder.
+        /// </summary>
+        public int MaxAgents { get { return mMaxAgents; } }
+
+        /// <summary>
+        /// The type of unmanaged resource used by the object.
+        /// </summary>
+        public AllocType ResourceType { get { return AllocType.External; } }
+
+        /// <summary>
+        /// True if the object has been disposed and should no longer be used.
+        /// </summary>
+        public bool IsDisposed { get { return (mRoot == IntPtr.Zero); } }
+
+        private CrowdStateEncoder(IntPtr root, int maxAgents)
+        {
+            mRoot = root;
+            mMaxAgents = maxAgents;
+        }
+
+        /// <summary>
+        /// Destructor.
+        /// </summary>
+        ~CrowdStateEncoder()
+        {
+            RequestDisposal();
+        }
+
+        /// <summary>
+        /// Immediately frees all unmanaged resources allocated by the object.
+        /// </summary>
+        public void RequestDisposal()
+        {
+            if (!IsDisposed)
+            {
+                CrowdStreamEx.dtcseFree(mRoot);
+                mRoot = IntPtr.Zero;
+            }
+        }
+
+        /// <summary>
+        /// Starts over from an empty baseline.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// The next stream is flagged as a keyframe and holds every active agent.
+        /// </para>
+        /// </remarks>
+        public void Reset()
+        {
+            if (!IsDisposed)
+                CrowdStreamEx.dtcseReset(mRoot);
+        }
+
+        /// <summary>
+        /// Writes the agent state changes since the previous stream.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// If the buffer fills, the result includes the <see cref="NavStatus.BufferTooSmall"/> 
+        /// flag and the agents that did not fit are written by the next call.
+        /// </para>
+        /// </remarks>
+        /// <param name="crowd">
+        /// The crowd to write. [Limit: <see cref="CrowdManager.MaxAgents"/> &lt;= 
+        /// <see cref="MaxAgents"/>]
+        /// </param>
+        /// <param name="stream">The stream buffer.</param>
+        /// <param name="size">The number of bytes written to the buffer.</param>
+        /// <param name="agentCount">The number of agents written.</param>
+        /// <returns>The <see cref="NavStatus" /> flags for the operation.</returns>
+        public NavStatus Write(CrowdManager crowd
+            , byte[] stream
+            , out int size
+            , out int agentCount)
+        {
+            size = 0;
+            agentCount = 0;
+
+            if (IsDisposed || crowd == null || crowd.IsDisposed || stream == null)
+                return NavStatus.Failure | NavStatus.InvalidParam;
+
+            return CrowdStreamEx.dtcWriteStateDelta(crowd.root
+                , mRoot
+                , stream
+                , stream.Length
+                , ref size
+                , ref agentCount);
+        }
+
+        /// <summary>
+        /// Creates a new crowd state encoder.
+        /// </summary>
+        /// <param name="maxAgents">
+        /// The maximum number of agents supported by the encoder. [Limit: >= 1]
+        /// </param>
+        /// <param name="positionPrecision">
+        /// The position quantization step. (E.g. 0.01 for centimeters.) [Limit: > 0]
+        /// </param>
+        /// <param name="velocityPrecision">
+        /// The velocity quantization step. [Limit: > 0]
+        /// </param>
+        /// <param name="resultEncoder">The new encoder, or null on error.</param>
+        /// <returns>The <see cref="NavStatus" /> flags for the operation.</returns>
+        public static NavStatus Create(int maxAgents
+            , float positionPrecision
+            , float velocityPrecision
+            , out CrowdStateEncoder resultEncoder)
+        {
+            resultEncoder = null;
+
+            IntPtr root = IntPtr.Zero;
+
+            NavStatus status = CrowdStreamEx.dtcseAlloc(maxAgents
+                , positionPrecision
+                , velocityPrecision
+                , ref root);
+
+            if (NavUtil.Succeeded(status))
+                resultEncoder = new CrowdStateEncoder(root, maxAgents);
+
+            return status;
+        }
+    }
+}
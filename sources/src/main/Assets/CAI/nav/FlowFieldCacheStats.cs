@@ -0,0 +1,67 @@
+﻿/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+using System.Runtime.InteropServices;
+
+namespace org.critterai.nav
+{
+    /// <summary>
+    /// Build and hit counters for a native flow field cache.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct FlowFieldCacheStats
+    {
+        /*
+         * Source: DetourFlowField dtFlowFieldCacheStats (struct)
+         */
+
+        /// <summary>
+        /// The number of cached fields.
+        /// </summary>
+        public int fieldCount;
+
+        /// <summary>
+        /// The maximum number of cached fields.
+        /// </summary>
+        public int maxFields;
+
+        /// <summary>
+        /// The number of lookups that returned a cached field.
+        /// </summary>
+        public uint hitCount;
+
+        /// <summary>
+        /// The number of fields built because no usable field was cached.
+        /// </summary>
+        public uint buildCount;
+
+        /// <summary>
+        /// The number of cached fields discarded because the navigation mesh
+        /// changed under them.
+        /// </summary>
+        public uint invalidCount;
+
+        /// <summary>
+        /// The number of cached fields discarded to make room for new ones.
+        /// </summary>
+        public uint evictCount;
+    }
+}
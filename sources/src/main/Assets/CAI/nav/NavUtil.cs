@@ -25,6 +25,11 @@ using Vector3 = org.critterai.Vector3;
 #else
 using Vector3 = UnityEngine.Vector3;
 #endif
+#if CAI_POLYREF64
+using PolyRef = System.UInt64;
+#else
+using PolyRef = System.UInt32;
+#endif
 
 namespace org.critterai.nav
 {
@@ -155,5 +160,22 @@ namespace org.critterai.nav
         {
             rcn.InteropUtil.dtvlVectorArrayTest(vectors, vectorCount, result);
         }
+
+        /// <summary>
+        /// Tests that the polygon reference size matches the native library.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// The native library can be built with 32-bit or 64-bit polygon and tile references.
+        /// (DT_POLYREF64)  Builds using 64-bit references must define CAI_POLYREF64 for the 
+        /// managed code.  A mismatch corrupts every structure and buffer that contains a
+        /// reference.
+        /// </para>
+        /// </remarks>
+        /// <returns>True if the managed and native reference sizes are equal.</returns>
+        public static bool TestPolyRefSize()
+        {
+            return rcn.InteropUtil.dtvlGetPolyRefSize() == sizeof(PolyRef);
+        }
     }
 }
@@ -29,6 +29,13 @@ using Vector3 = org.critterai.Vector3;
 #else
 using Vector3 = UnityEngine.Vector3;
 #endif
+#if CAI_POLYREF64
+using PolyRef = System.UInt64;
+using TileRef = System.UInt64;
+#else
+using PolyRef = System.UInt32;
+using TileRef = System.UInt32;
+#endif
 
 namespace org.critterai.nav
 {
@@ -108,12 +115,12 @@ namespace org.critterai.nav
         /// <summary>
         /// The reference for a null polygon. (Does not exist.)
         /// </summary>
-        public const uint NullPoly = 0;
+        public const PolyRef NullPoly = 0;
 
         /// <summary>
         /// The reference for a null tile. (Does not exist.)
         /// </summary>
-        public const uint NullTile = 0;
+        public const TileRef NullTile = 0;
 
         /// <summary>
         /// Represents an polygon index that does not point to anything.
@@ -194,8 +201,8 @@ namespace org.critterai.nav
         /// <param name="resultTileRef">The actual reference assigned to the tile.</param>
         /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
         public NavStatus AddTile(NavmeshTileData tileData
-            , uint desiredTileRef
-            , out uint resultTileRef)
+            , TileRef desiredTileRef
+            , out TileRef resultTileRef)
         {
             if (tileData == null
                 || tileData.IsOwned
@@ -218,13 +225,123 @@ namespace org.critterai.nav
         /// </summary>
         /// <param name="tileRef">The tile reference.</param>
         /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
-        public NavStatus RemoveTile(uint tileRef)
+        public NavStatus RemoveTile(TileRef tileRef)
         {
             int trash = 0;
             IntPtr dump = IntPtr.Zero;
             return NavmeshEx.dtnmRemoveTile(root, tileRef, ref dump, ref trash);
         }
 
+        /// <summary>
+        /// True if the tiles have the polygon grids used by grid nearest point searches.
+        /// </summary>
+        /// <seealso cref="SetPolyGridsEnabled"/>
+        public bool PolyGridsEnabled
+        {
+            get { return NavmeshEx.dtnmGetPolyGridsEnabled(root); }
+        }
+
+        /// <summary>
+        /// Enables or disables the per-tile polygon grids used by 
+        /// <see cref="NavmeshQuery.GetNearestPoint(Vector3, Vector3, NavmeshQueryFilter, bool, out NavmeshPoint)"/>.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// Enabling builds the grids of the existing tiles.  Tiles added later get their grid 
+        /// when they are added.  The grids use memory roughly proportional to the number of 
+        /// polygons.
+        /// </para>
+        /// </remarks>
+        /// <param name="enabled">True if the tiles should have polygon grids.</param>
+        /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
+        public NavStatus SetPolyGridsEnabled(bool enabled)
+        {
+            return NavmeshEx.dtnmSetPolyGridsEnabled(root, enabled);
+        }
+
+        /// <summary>
+        /// True if the tiles have the detail mesh height grids used by height queries.
+        /// </summary>
+        /// <seealso cref="SetHeightGridsEnabled"/>
+        public bool HeightGridsEnabled
+        {
+            get { return NavmeshEx.dtnmGetHeightGridsEnabled(root); }
+        }
+
+        /// <summary>
+        /// Enables or disables the per-tile detail mesh height grids.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// The grids let height queries, such as <see cref="NavmeshQuery.GetPolyHeight"/>, 
+        /// test only the few detail triangles near the position.  The heights are the same 
+        /// as without the grids.
+        /// </para>
+        /// <para>
+        /// Enabling builds the grids of the existing tiles.  Tiles added later get their grid 
+        /// when they are added.
+        /// </para>
+        /// </remarks>
+        /// <param name="enabled">True if the tiles should have height grids.</param>
+        /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
+        public NavStatus SetHeightGridsEnabled(bool enabled)
+        {
+            return NavmeshEx.dtnmSetHeightGridsEnabled(root, enabled);
+        }
+
+        /// <summary>
+        /// Gets the memory used by the navigation mesh.
+        /// </summary>
+        /// <returns>The memory used by the mesh, broken down by owner.</returns>
+        public NavmeshMemoryStats GetMemoryStats()
+        {
+            NavmeshMemoryStats stats = new NavmeshMemoryStats();
+            NavmeshEx.dtnmGetMemoryStats(root, ref stats);
+            return stats;
+        }
+
+        /// <summary>
+        /// Enables adding and removing tiles while queries run on other threads.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// Each query that is used on another thread must bracket its queries with
+        /// <see cref="NavmeshQuery.BeginRead"/> and <see cref="NavmeshQuery.EndRead"/>.  
+        /// A tile removed during a read keeps its memory until the read has ended.  Tiles 
+        /// must still be added and removed by one thread at a time.
+        /// </para>
+        /// <para>
+        /// Must be called before any query is used on another thread.
+        /// </para>
+        /// <para>
+        /// Each query that starts reads needs a reader slot, and a read that finds none 
+        /// fails.  A crowd manager needs two slots, one for its query and one for the query 
+        /// of its path queue.
+        /// </para>
+        /// </remarks>
+        /// <param name="maxReaders">
+        /// The maximum number of queries that start reads. [Limit: > 0]
+        /// </param>
+        /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
+        public NavStatus EnableConcurrentReads(int maxReaders)
+        {
+            return NavmeshEx.dtnmInitConcurrentReads(root, maxReaders);
+        }
+
+        /// <summary>
+        /// Frees the memory of removed tiles that no read is still using.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// This is done automatically when tiles are added or removed.
+        /// </para>
+        /// </remarks>
+        /// <returns>The number of removed tiles whose memory is still in use.</returns>
+        public int ReclaimRetiredTiles()
+        {
+            return NavmeshEx.dtnmReclaimRetiredTiles(root);
+        }
+
         /// <summary>
         /// Derives the tile grid location based on the provided world space position.
         /// </summary>
@@ -288,7 +405,7 @@ namespace org.critterai.nav
         /// <param name="z">The tile grid z-location.</param>
         /// <param name="layer">The tiles layer.</param>
         /// <returns>The tile reference, or zero if there is no tile at the location.</returns>
-        public uint GetTileRef(int x, int z, int layer)
+        public TileRef GetTileRef(int x, int z, int layer)
         {
             return NavmeshEx.dtnmGetTileRefAt(root, x, z, layer);
         }
@@ -298,7 +415,7 @@ namespace org.critterai.nav
         /// </summary>
         /// <param name="tileRef">The reference of the tile.</param>
         /// <returns>The tile, or null if none was found.</returns>
-        public NavmeshTile GetTileByRef(uint tileRef)
+        public NavmeshTile GetTileByRef(TileRef tileRef)
         {
             IntPtr tile = NavmeshEx.dtnmGetTileByRef(root, tileRef);
             if (tile == IntPtr.Zero)
@@ -330,6 +447,35 @@ namespace org.critterai.nav
             return new NavmeshTile(this, tile);
         }
 
+        /// <summary>
+        /// Gets read-only views of the data of all tiles in use.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// Views are returned in tile buffer order.  Empty tiles are skipped.  The views
+        /// reference the tiles' memory directly and are only valid until the associated tile is 
+        /// removed or replaced, or the navigation mesh is disposed.
+        /// </para>
+        /// <para>
+        /// The <see cref="NavStatus.BufferTooSmall"/> flag will be set if the buffer is too
+        /// small to hold a view for every tile in use.
+        /// </para>
+        /// </remarks>
+        /// <param name="buffer">
+        /// The buffer to load the results into. [Length: >= Tiles in use. (Up to <see cref="GetMaxTiles"/>)]
+        /// </param>
+        /// <param name="viewCount">The number of views returned.</param>
+        /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
+        public NavStatus GetTileViews(NavmeshTileView[] buffer, out int viewCount)
+        {
+            viewCount = 0;
+
+            if (IsDisposed || buffer == null)
+                return (NavStatus.Failure | NavStatus.InvalidParam);
+
+            return NavmeshTileEx.dtnmGetTileViews(root, buffer, buffer.Length, ref viewCount);
+        }
+
         /// <summary>
         /// Gets a polygon and its tile.
         /// </summary>
@@ -337,7 +483,7 @@ namespace org.critterai.nav
         /// <param name="tile">The tile the polygon belongs to.</param>
         /// <param name="poly">The polygon.</param>
         /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
-        public NavStatus GetTileAndPoly(uint polyRef
+        public NavStatus GetTileAndPoly(PolyRef polyRef
             , out NavmeshTile tile
             , out NavmeshPoly poly)
         {
@@ -370,7 +516,7 @@ namespace org.critterai.nav
         /// </summary>
         /// <param name="polyRef">The reference to check.</param>
         /// <returns>True if the provided reference is valid.</returns>
-        public bool IsValidPolyRef(uint polyRef)
+        public bool IsValidPolyRef(PolyRef polyRef)
         {
             return NavmeshEx.dtnmIsValidPolyRef(root, polyRef);
         }
@@ -393,8 +539,8 @@ namespace org.critterai.nav
         /// <param name="startPoint">The start point. (Out)</param>
         /// <param name="endPoint">The end point. (Out)</param>
         /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
-        public NavStatus GetConnectionEndpoints(uint startPolyRef
-            , uint connectionPolyRef
+        public NavStatus GetConnectionEndpoints(PolyRef startPolyRef
+            , PolyRef connectionPolyRef
             , out Vector3 startPoint
             , out Vector3 endPoint)
         {
@@ -412,7 +558,7 @@ namespace org.critterai.nav
         /// </summary>
         /// <param name="polyRef">The reference of the off-mesh connection.</param>
         /// <returns>The off-mesh connection.</returns>
-        public NavmeshConnection GetConnectionByRef(uint polyRef)
+        public NavmeshConnection GetConnectionByRef(PolyRef polyRef)
         {
             IntPtr conn = NavmeshEx.dtnmGetOffMeshConnectionByRef(root, polyRef);
 
@@ -433,7 +579,7 @@ namespace org.critterai.nav
         /// <param name="flags">The polygon flags.</param>
         /// <returns>The <see cref="NavStatus"/> flags for the operation.
         /// </returns>
-        public NavStatus GetPolyFlags(uint polyRef, out ushort flags)
+        public NavStatus GetPolyFlags(PolyRef polyRef, out ushort flags)
         {
             flags = 0;
             return NavmeshEx.dtnmGetPolyFlags(root, polyRef, ref flags);
@@ -446,7 +592,7 @@ namespace org.critterai.nav
         /// <param name="flags">The polygon flags.</param>
         /// <returns>The <see cref="NavStatus"/> flags for the operation.
         /// </returns>
-        public NavStatus SetPolyFlags(uint polyRef, ushort flags)
+        public NavStatus SetPolyFlags(PolyRef polyRef, ushort flags)
         {
             return NavmeshEx.dtnmSetPolyFlags(root, polyRef, flags);
         }
@@ -458,7 +604,7 @@ namespace org.critterai.nav
         /// <param name="area">The area of the polygon.</param>
         /// <returns>The <see cref="NavStatus"/> flags for the operation.
         /// </returns>
-        public NavStatus GetPolyArea(uint polyRef, out byte area)
+        public NavStatus GetPolyArea(PolyRef polyRef, out byte area)
         {
             area = 0;
             return NavmeshEx.dtnmGetPolyArea(root, polyRef, ref area);
@@ -472,7 +618,7 @@ namespace org.critterai.nav
         /// [Limit: &lt;= <see cref="Navmesh.MaxArea"/>]</param>
         /// <returns>The <see cref="NavStatus"/> flags for the operation.
         /// </returns>
-        public NavStatus SetPolyArea(uint polyRef, byte area)
+        public NavStatus SetPolyArea(PolyRef polyRef, byte area)
         {
             return NavmeshEx.dtnmSetPolyArea(root, polyRef, area);
         }
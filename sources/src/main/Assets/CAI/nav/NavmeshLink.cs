@@ -23,6 +23,11 @@ using System;
 using System.Collections.Generic;
 using System.Text;
 using System.Runtime.InteropServices;
+#if CAI_POLYREF64
+using PolyRef = System.UInt64;
+#else
+using PolyRef = System.UInt32;
+#endif
 
 namespace org.critterai.nav
 {
@@ -35,7 +40,7 @@ namespace org.critterai.nav
         /// <summary>
         /// The polygon reference of the neighbor.
         /// </summary>
-        public uint polyRef;
+        public PolyRef polyRef;
 
         /// <summary>
         /// The index of the next link.
@@ -0,0 +1,79 @@
+﻿/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+using System;
+using System.Runtime.InteropServices;
+
+namespace org.critterai.nav
+{
+    /// <summary>
+    /// The memory used by a navigation mesh, in bytes, broken down by owner.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct NavmeshMemoryStats
+    {
+        /*
+         * Source: DetourNavMesh dtNavMeshMemoryStats (struct)
+         * 
+         * The native byte counts are size_t.
+         */
+
+        private UIntPtr mMeshBytes;
+        private UIntPtr mTileDataBytes;
+        private UIntPtr mExternalTileDataBytes;
+        private UIntPtr mTileCopyBytes;
+        private UIntPtr mGridBytes;
+        private int mTileCount;
+
+        /// <summary>
+        /// The mesh object, the tile table and the tile lookup.
+        /// </summary>
+        public long MeshBytes { get { return (long)mMeshBytes.ToUInt64(); } }
+
+        /// <summary>
+        /// The tile data owned by the mesh.
+        /// </summary>
+        public long TileDataBytes { get { return (long)mTileDataBytes.ToUInt64(); } }
+
+        /// <summary>
+        /// The tile data owned by the caller or shared with other meshes.
+        /// </summary>
+        public long ExternalTileDataBytes 
+        { 
+            get { return (long)mExternalTileDataBytes.ToUInt64(); } 
+        }
+
+        /// <summary>
+        /// The per-mesh copies of shared tile data and the tile border edges.
+        /// </summary>
+        public long TileCopyBytes { get { return (long)mTileCopyBytes.ToUInt64(); } }
+
+        /// <summary>
+        /// The polygon and height grids.
+        /// </summary>
+        public long GridBytes { get { return (long)mGridBytes.ToUInt64(); } }
+
+        /// <summary>
+        /// The number of tiles in the mesh.
+        /// </summary>
+        public int TileCount { get { return mTileCount; } }
+    }
+}
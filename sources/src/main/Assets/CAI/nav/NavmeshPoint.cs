@@ -25,6 +25,11 @@ using Vector3 = org.critterai.Vector3;
 #else
 using Vector3 = UnityEngine.Vector3;
 #endif
+#if CAI_POLYREF64
+using PolyRef = System.UInt64;
+#else
+using PolyRef = System.UInt32;
+#endif
 
 namespace org.critterai.nav
 {
@@ -37,7 +42,7 @@ namespace org.critterai.nav
         /// <summary>
         /// The reference of the polygon the contains the point. (Or zero if not known.)
         /// </summary>
-        public uint polyRef;
+        public PolyRef polyRef;
 
         /// <summary>
         /// The location of the point.
@@ -51,7 +56,7 @@ namespace org.critterai.nav
         /// The reference of the polygon that contains the point. (Or zero if not known.)
         /// </param>
         /// <param name="point">The location of the point.</param>
-        public NavmeshPoint(uint polyRef, Vector3 point)
+        public NavmeshPoint(PolyRef polyRef, Vector3 point)
         {
             this.polyRef = polyRef;
             this.point = point;
@@ -27,6 +27,11 @@ using Vector3 = org.critterai.Vector3;
 #else
 using Vector3 = UnityEngine.Vector3;
 #endif
+#if CAI_POLYREF64
+using PolyRef = System.UInt64;
+#else
+using PolyRef = System.UInt32;
+#endif
 
 namespace org.critterai.nav
 {
@@ -52,6 +57,8 @@ namespace org.critterai.nav
     {
         internal IntPtr root; // dtNavmeshQuery
 
+        private const int NearestPolyGridOption = 0x01;  // DT_NEARESTPOLY_GRID
+
         private bool mIsRestricted;
 
         internal NavmeshQuery(IntPtr query, bool isConstant, AllocType type)
@@ -106,6 +113,44 @@ namespace org.critterai.nav
             get { return (root == IntPtr.Zero); }
         }
 
+        /// <summary>
+        /// Gets the memory used by the query and its node pools, in bytes.
+        /// </summary>
+        /// <returns>The memory used by the query, or zero if the query is disposed.</returns>
+        public int GetMemoryUsed()
+        {
+            return NavmeshQueryEx.dtnqGetMemUsed(root);
+        }
+
+        /// <summary>
+        /// Starts a read of the navigation mesh.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// Tiles removed on another thread are not freed until the read ends.  Reads may
+        /// be nested.  Does nothing unless <see cref="Navmesh.EnableConcurrentReads"/> 
+        /// has been called.
+        /// </para>
+        /// <para>
+        /// The read fails if the navigation mesh has no free reader slot for the query.  
+        /// The mesh must not be read after a failed read.  (Calling <see cref="EndRead"/> 
+        /// is harmless.)
+        /// </para>
+        /// </remarks>
+        /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
+        public NavStatus BeginRead()
+        {
+            return NavmeshQueryEx.dtnqBeginRead(root);
+        }
+
+        /// <summary>
+        /// Ends a read started with <see cref="BeginRead"/>.
+        /// </summary>
+        public void EndRead()
+        {
+            NavmeshQueryEx.dtnqEndRead(root);
+        }
+
         /// <summary>
         /// Finds the nearest point on the surface of the navigation mesh.
         /// </summary>
@@ -139,6 +184,82 @@ namespace org.critterai.nav
                 , ref result);
         }
 
+        /// <summary>
+        /// Finds the nearest point on the surface of the navigation mesh, optionally using
+        /// the polygon grids of the navigation mesh.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// The result is the same as 
+        /// <see cref="GetNearestPoint(Vector3, Vector3, NavmeshQueryFilter, out NavmeshPoint)"/>.
+        /// But when <paramref name="useGrids"/> is true the polygons nearest the search point 
+        /// are checked first, and the search stops once no remaining polygon can be closer.  
+        /// This keeps searches with large extents affordable.
+        /// </para>
+        /// <para>
+        /// The grids are only used if they are enabled for the navigation mesh.
+        /// (See: <see cref="Navmesh.SetPolyGridsEnabled"/>)
+        /// </para>
+        /// </remarks>
+        /// <param name="searchPoint">The center of the search box.</param>
+        /// <param name="extents">The search distance along each axis.</param>
+        /// <param name="filter">The filter to apply to the query.</param>
+        /// <param name="useGrids">True if the polygon grids should be used.</param>
+        /// <param name="result">The nearest point on the polygon.</param>
+        /// <returns>The <see cref="NavStatus"/> flags for the query.</returns>
+        public NavStatus GetNearestPoint(Vector3 searchPoint, Vector3 extents
+            , NavmeshQueryFilter filter
+            , bool useGrids
+            , out NavmeshPoint result)
+        {
+            result = NavmeshPoint.Zero;
+
+            return NavmeshQueryEx.dtqFindNearestPolyWithOptions(root
+                , ref searchPoint
+                , ref extents
+                , filter.root
+                , useGrids ? NearestPolyGridOption : 0
+                , ref result);
+        }
+
+        /// <summary>
+        /// Finds the nearest point on the surface of the navigation mesh, checking a polygon 
+        /// known to be near the search point, and its neighbors, first.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// If the search point is directly over the hint polygon, or one of the polygons
+        /// linked to it, and within the walkable climb of its surface, that polygon is the 
+        /// result.  Otherwise the result is the same as 
+        /// <see cref="GetNearestPoint(Vector3, Vector3, NavmeshQueryFilter, out NavmeshPoint)"/>.
+        /// This makes re-snapping an agent that has moved a short distance much cheaper 
+        /// than a full search.
+        /// </para>
+        /// </remarks>
+        /// <param name="hintRef">
+        /// The reference of a polygon near the search point.  (E.g. The polygon from the
+        /// previous update.)  Zero if not known.
+        /// </param>
+        /// <param name="searchPoint">The center of the search box.</param>
+        /// <param name="extents">The search distance along each axis.</param>
+        /// <param name="filter">The filter to apply to the query.</param>
+        /// <param name="result">The nearest point on the polygon.</param>
+        /// <returns>The <see cref="NavStatus"/> flags for the query.</returns>
+        public NavStatus GetNearestPoint(PolyRef hintRef
+            , Vector3 searchPoint, Vector3 extents
+            , NavmeshQueryFilter filter
+            , out NavmeshPoint result)
+        {
+            result = NavmeshPoint.Zero;
+
+            return NavmeshQueryEx.dtqFindNearestPolyHinted(root
+                , hintRef
+                , ref searchPoint
+                , ref extents
+                , filter.root
+                , ref result);
+        }
+
         /// <summary>
         /// Returns the wall segments for the specified polygon.
         /// </summary>
@@ -164,7 +285,7 @@ namespace org.critterai.nav
         /// The number of segments returned in the segments array.
         /// </param>
         /// <returns>The <see cref="NavStatus" /> flags for the query.</returns>
-        public NavStatus GetPolySegments(uint polyRef
+        public NavStatus GetPolySegments(PolyRef polyRef
             , NavmeshQueryFilter filter
             , Vector3[] resultSegments
             , out int segmentCount)
@@ -208,10 +329,10 @@ namespace org.critterai.nav
         /// considered impassable. [(polyRef) * segmentCount] (Optional)</param>
         /// <param name="segmentCount">The number of segments returned.</param>
         /// <returns>The <see cref="NavStatus" /> flags for the query.</returns>
-        public NavStatus GetPolySegments(uint polyRef
+        public NavStatus GetPolySegments(PolyRef polyRef
             , NavmeshQueryFilter filter
             , Vector3[] resultSegments
-            , uint[] segmentPolyRefs
+            , PolyRef[] segmentPolyRefs
             , out int segmentCount)
         {
             segmentCount = 0;
@@ -254,7 +375,7 @@ namespace org.critterai.nav
         public NavStatus GetPolys(Vector3 searchPoint
             , Vector3 extents
             , NavmeshQueryFilter filter
-            , uint[] resultPolyRefs
+            , PolyRef[] resultPolyRefs
             , out int resultCount)
         {
             resultCount = 0;
@@ -324,7 +445,7 @@ namespace org.critterai.nav
         /// <returns>The <see cref="NavStatus" /> flags for the query.</returns>
         public NavStatus FindPolys(NavmeshPoint start, float radius
             , NavmeshQueryFilter filter
-            , uint[] resultPolyRefs, uint[] resultParentRefs, float[] resultCosts
+            , PolyRef[] resultPolyRefs, PolyRef[] resultParentRefs, float[] resultCosts
             , out int resultCount)
         {
             resultCount = 0;
@@ -404,11 +525,11 @@ namespace org.critterai.nav
         /// </param>
         /// <param name="resultCount">The number of polygons found.</param>
         /// <returns>The <see cref="NavStatus" /> flags for the query.</returns>
-        public NavStatus FindPolys(uint startPolyRef
+        public NavStatus FindPolys(PolyRef startPolyRef
             , Vector3[] vertices
             , NavmeshQueryFilter filter
-            , uint[] resultPolyRefs
-            , uint[] resultParentRefs
+            , PolyRef[] resultPolyRefs
+            , PolyRef[] resultParentRefs
             , float[] resultCosts
             , out int resultCount)
         {
@@ -491,7 +612,7 @@ namespace org.critterai.nav
         /// <returns>The <see cref="NavStatus" /> flags for the query.</returns>
         public NavStatus GetPolysLocal(NavmeshPoint start, float radius
             , NavmeshQueryFilter filter
-            , uint[] resultPolyRefs, uint[] resultParentRefs, out int resultCount)
+            , PolyRef[] resultPolyRefs, PolyRef[] resultParentRefs, out int resultCount)
         {
             resultCount = 0;
 
@@ -531,7 +652,7 @@ namespace org.critterai.nav
         /// <param name="sourcePoint">The position to search from.</param>
         /// <param name="resultPoint">The closest point on the polygon.</param>
         /// <returns>The <see cref="NavStatus" /> flags for the query.</returns>
-        public NavStatus GetNearestPoint(uint polyRef, Vector3 sourcePoint, out Vector3 resultPoint)
+        public NavStatus GetNearestPoint(PolyRef polyRef, Vector3 sourcePoint, out Vector3 resultPoint)
         {
             resultPoint = Vector3Util.Zero;
 
@@ -564,7 +685,7 @@ namespace org.critterai.nav
         /// <param name="sourcePoint">The point to check.</param>
         /// <param name="resultPoint">The closest point.</param>
         /// <returns>The <see cref="NavStatus" /> flags for the query.</returns>
-        public NavStatus GetNearestPointF(uint polyRef
+        public NavStatus GetNearestPointF(PolyRef polyRef
             , Vector3 sourcePoint
             , out Vector3 resultPoint)
         {
@@ -671,7 +792,7 @@ namespace org.critterai.nav
         /// <returns>The <see cref="NavStatus" /> flags for the query.</returns>
         public NavStatus FindPath(NavmeshPoint start, NavmeshPoint end
             , NavmeshQueryFilter filter
-            , uint[] resultPath, out int pathCount)
+            , PolyRef[] resultPath, out int pathCount)
         {
             pathCount = 0;
 
@@ -695,11 +816,11 @@ namespace org.critterai.nav
         /// </para>
         /// <ol>
         /// <li>
-        /// Using <see cref="GetNearestPoint(uint, Vector3, out Vector3)"/> with the 
+        /// Using <see cref="GetNearestPoint(PolyRef, Vector3, out Vector3)"/> with the 
         /// <paramref name="start"/> point to get the start polygon.
         /// </li>
         /// <li>
-        /// Using <see cref="GetNearestPoint(uint, Vector3, out Vector3)"/> with the 
+        /// Using <see cref="GetNearestPoint(PolyRef, Vector3, out Vector3)"/> with the 
         /// <paramref name="end"/> point to get the end polygon.
         /// </li>
         /// <li>Calling the normal find path using the two new start and end points.</li>
@@ -757,7 +878,7 @@ namespace org.critterai.nav
         /// <returns>The <see cref="NavStatus" /> flags for the query.</returns>
         public NavStatus FindPath(ref NavmeshPoint start, ref NavmeshPoint end
             , Vector3 extents, NavmeshQueryFilter filter
-            , uint[] resultPath, out int pathCount)
+            , PolyRef[] resultPath, out int pathCount)
         {
             pathCount = 0;
 
@@ -786,7 +907,7 @@ namespace org.critterai.nav
         /// </remarks>
         /// <param name="polyRef">The polygon reference.</param>
         /// <returns>True if the polgyon is in the current closed list.</returns>
-        public bool IsInClosedList(uint polyRef)
+        public bool IsInClosedList(PolyRef polyRef)
         {
             return NavmeshQueryEx.dtqIsInClosedList(root, polyRef);
         }
@@ -799,7 +920,7 @@ namespace org.critterai.nav
         /// <returns>
         /// True if the polygon reference is valid and passes the filter restrictions.
         /// </returns>
-        public bool IsValidPolyRef(uint polyRef, NavmeshQueryFilter filter)
+        public bool IsValidPolyRef(PolyRef polyRef, NavmeshQueryFilter filter)
         {
             return NavmeshQueryEx.dtqIsValidPolyRef(root, polyRef, filter.root);
         }
@@ -864,7 +985,7 @@ namespace org.critterai.nav
         public NavStatus Raycast(NavmeshPoint start, Vector3 end
             , NavmeshQueryFilter filter
             , out float hitParameter, out Vector3 hitNormal
-            , uint[] path, out int pathCount)
+            , PolyRef[] path, out int pathCount)
         {
             pathCount = 0;
             hitParameter = 0;
@@ -956,8 +1077,8 @@ namespace org.critterai.nav
         /// <param name="resultCount">The number of points in the straight path.</param>
         /// <returns>The <see cref="NavStatus" /> flags for the query.</returns>
         public NavStatus GetStraightPath(Vector3 start, Vector3 end
-            , uint[] path, int pathStart, int pathCount
-            , Vector3[] resultPoints, WaypointFlag[] resultFlags, uint[] resultRefs
+            , PolyRef[] path, int pathStart, int pathCount
+            , Vector3[] resultPoints, WaypointFlag[] resultFlags, PolyRef[] resultRefs
             , out int resultCount)
         {
             resultCount = 0;
@@ -1021,7 +1142,7 @@ namespace org.critterai.nav
         public NavStatus MoveAlongSurface(NavmeshPoint start, Vector3 end
             , NavmeshQueryFilter filter
             , out Vector3 resultPoint
-            , uint[] visitedPolyRefs, out int visitedCount)
+            , PolyRef[] visitedPolyRefs, out int visitedCount)
         {
             visitedCount = 0;
             resultPoint = Vector3Util.Zero;
@@ -1157,7 +1278,7 @@ namespace org.critterai.nav
         /// [(polyRef) * pathCount]</param>
         /// <param name="pathCount">The number of polygons in the path.</param>
         /// <returns>The <see cref="NavStatus" /> flags for the query.</returns>
-        public NavStatus FinalizeSlicedFindPath(uint[] path
+        public NavStatus FinalizeSlicedFindPath(PolyRef[] path
             , out int pathCount)
         {
             pathCount = 0;
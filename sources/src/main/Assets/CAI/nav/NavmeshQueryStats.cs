@@ -0,0 +1,92 @@
+﻿/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+using System.Runtime.InteropServices;
+
+namespace org.critterai.nav
+{
+    /// <summary>
+    /// Search statistics for a <see cref="NavmeshQuery"/> object.
+    /// </summary>
+    /// <remarks>
+    /// <para>
+    /// The statistics are only collected if the native library is built with 
+    /// DT_QUERY_STATS defined.  Otherwise all fields are zero.
+    /// </para>
+    /// <para>
+    /// Graph searches, such as path searches, and polygon searches, such as 
+    /// nearest polygon searches, are counted.  Raycasts and local searches, such 
+    /// as moving along the surface, are not.
+    /// </para>
+    /// </remarks>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct NavmeshQueryStats
+    {
+        /*
+         * Source: DetourNavMeshQuery dtQueryStats (struct)
+         */
+
+        /// <summary>
+        /// The number of queries.
+        /// </summary>
+        public int queryCount;
+
+        /// <summary>
+        /// The number of nodes taken from the open list.
+        /// </summary>
+        public int nodesExpanded;
+
+        /// <summary>
+        /// The number of nodes added to the open list.
+        /// </summary>
+        public int openListPushes;
+
+        /// <summary>
+        /// The number of open list nodes that were given a lower cost.
+        /// </summary>
+        public int openListModifies;
+
+        /// <summary>
+        /// The number of open list nodes added in a different tile than their parent.
+        /// </summary>
+        public int tileCrossings;
+
+        /// <summary>
+        /// The number of tiles searched for polygons.
+        /// </summary>
+        public int tilesQueried;
+
+        /// <summary>
+        /// The number of bounding volume nodes visited while searching the tiles.
+        /// </summary>
+        public int bvNodesVisited;
+
+        /// <summary>
+        /// The number of queries that ran out of search nodes.
+        /// </summary>
+        public int outOfNodesCount;
+
+        /// <summary>
+        /// The number of path queries with a partial result.
+        /// </summary>
+        public int partialResultCount;
+    }
+}
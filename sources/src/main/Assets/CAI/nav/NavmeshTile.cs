@@ -28,6 +28,13 @@ using Vector3 = org.critterai.Vector3;
 #else
 using Vector3 = UnityEngine.Vector3;
 #endif
+#if CAI_POLYREF64
+using PolyRef = System.UInt64;
+using TileRef = System.UInt64;
+#else
+using PolyRef = System.UInt32;
+using TileRef = System.UInt32;
+#endif
 
 namespace org.critterai.nav
 {
@@ -70,7 +77,7 @@ namespace org.critterai.nav
         /// The reference of the tile.
         /// </summary>
         /// <returns>The refernce id of the tile.</returns>
-        public uint GetTileRef() 
+        public TileRef GetTileRef() 
         {
             if (mOwner.IsDisposed)
                 return 0;
@@ -81,7 +88,7 @@ namespace org.critterai.nav
         /// Gets the reference of the base polygon in the tile.
         /// </summary>
         /// <returns>The reference of the base polygon.</returns>
-        public uint GetBasePolyRef()
+        public PolyRef GetBasePolyRef()
         {
             if (mOwner.IsDisposed)
                 return 0;
@@ -161,6 +168,28 @@ namespace org.critterai.nav
                     Marshal.PtrToStructure(header, typeof(NavmeshTileHeader));
         }
 
+        /// <summary>
+        /// Gets a read-only view of the tile's data.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// The view references the tile's memory directly, so it avoids the copies made by the
+        /// other data methods.  It is only valid until the tile is removed or replaced, or the
+        /// navigation mesh is disposed.
+        /// </para>
+        /// </remarks>
+        /// <param name="view">The view of the tile's data.</param>
+        /// <returns>The <see cref="NavStatus" /> flags for the operation.</returns>
+        public NavStatus GetView(out NavmeshTileView view)
+        {
+            view = new NavmeshTileView();
+
+            if (mOwner.IsDisposed)
+                return (NavStatus.Failure | NavStatus.InvalidParam);
+
+            return NavmeshTileEx.dtnmGetTileView(mOwner.root, mTile, ref view);
+        }
+
         /// <summary>
         /// Gets a copy of the polygon buffer.
         /// </summary>
@@ -313,9 +342,9 @@ namespace org.critterai.nav
         /// </param>
         /// <param name="polyIndex">The polygon's index within the tile.</param>
         /// <returns>The reference of the polygon.</returns>
-        public static uint GetPolyRef(uint basePolyRef, int polyIndex)
+        public static PolyRef GetPolyRef(PolyRef basePolyRef, int polyIndex)
         {
-            return (basePolyRef | (uint)polyIndex);
+            return (basePolyRef | (PolyRef)polyIndex);
         }
     }
 }
@@ -178,7 +178,12 @@ namespace org.critterai.nav
         private float mWalkableStep = 0;
         private float mXZCellSize = 0;
         private float mYCellSize = 0;
+        // Note: The native fields are one byte bools followed by an int.
+        [MarshalAs(UnmanagedType.I1)]
         private bool mBVTreeEnabled = false;
+        [MarshalAs(UnmanagedType.I1)]
+        private bool mCompactDetail = false;
+        private int mBVTreeSplit = 0;
 
         #endregion
 
@@ -325,6 +330,41 @@ namespace org.critterai.nav
         /// or layers are being used.</remarks>
         public bool BVTreeEnabled { get { return mBVTreeEnabled; } }
 
+        /// <summary>
+        /// True if the detail vertices should be stored in the compact 16-bit format.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// Compact tiles use half the memory for the detail vertices, which are
+        /// usually the largest part of a tile with a detail mesh.  The height
+        /// and closest point queries decode the vertices as they read them, so
+        /// they are slightly slower.  The quantization error is well below
+        /// a millimeter for normal tile sizes.
+        /// </para>
+        /// </remarks>
+        public bool CompactDetailEnabled
+        {
+            get { return mCompactDetail; }
+            set { mCompactDetail = value; }
+        }
+
+        /// <summary>
+        /// True if the bounding volume tree nodes should be split using the surface area 
+        /// heuristic rather than at the median.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// The tree takes about three times as long to build, but polygon queries visit fewer
+        /// nodes.  It is most useful for tiles with many polygons of very different sizes.
+        /// Has no effect if <see cref="BVTreeEnabled"/> is false.
+        /// </para>
+        /// </remarks>
+        public bool SahBVTreeEnabled
+        {
+            get { return mBVTreeSplit == 1; }
+            set { mBVTreeSplit = (value ? 1 : 0); }
+        }
+
         /// <summary>
         /// True if the object has been disposed and should no longer be used.
         /// </summary>
@@ -630,6 +670,8 @@ namespace org.critterai.nav
             mXZCellSize = 0;
             mYCellSize = 0;
             mBVTreeEnabled = false;
+            mCompactDetail = false;
+            mBVTreeSplit = 0;
 
             mMaxConns = 0;
             mMaxDetailTris = 0;
@@ -20,6 +20,11 @@
  * THE SOFTWARE.
  */
 using System;
+#if CAI_POLYREF64
+using TileRef = System.UInt64;
+#else
+using TileRef = System.UInt32;
+#endif
 
 namespace org.critterai.nav
 {
@@ -42,6 +47,6 @@ namespace org.critterai.nav
         /// <summary>
         /// The tile reference in the original mesh.
         /// </summary>
-        public uint tileRef;
+        public TileRef tileRef;
     }
 }
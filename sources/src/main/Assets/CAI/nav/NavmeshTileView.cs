@@ -0,0 +1,214 @@
+﻿/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+using System;
+using System.Runtime.InteropServices;
+#if CAI_POLYREF64
+using PolyRef = System.UInt64;
+using TileRef = System.UInt64;
+#else
+using PolyRef = System.UInt32;
+using TileRef = System.UInt32;
+#endif
+
+namespace org.critterai.nav
+{
+    /// <summary>
+    /// A read-only view of the data of a tile in a <see cref="Navmesh"/> object.
+    /// </summary>
+    /// <remarks>
+    /// <para>
+    /// The pointers reference the tile's memory within the navigation mesh.  Nothing is 
+    /// copied, so the sections can be read in place. (E.g. Via <c>Marshal</c> or unsafe code.)
+    /// The strides are the size in bytes of one element of each section.
+    /// </para>
+    /// <para>
+    /// The view is only valid until the tile is removed from, or replaced in, the navigation
+    /// mesh, or the mesh is disposed.
+    /// </para>
+    /// <para>
+    /// Compact tiles do not have float detail vertices.  For them <see cref="detailVerts"/> 
+    /// is zero and <see cref="detailQuantVerts"/> references the quantized vertices.  Use 
+    /// <see cref="NavmeshTile.GetDetailVerts"/> if decoded vertices are required.
+    /// </para>
+    /// </remarks>
+    /// <seealso cref="NavmeshTile.GetView"/>
+    /// <seealso cref="Navmesh.GetTileViews"/>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct NavmeshTileView
+    {
+        /// <summary>
+        /// The tile header. [Type: <see cref="NavmeshTileHeader"/>]
+        /// </summary>
+        public IntPtr header;
+
+        /// <summary>
+        /// The polygons. [Type: <see cref="NavmeshPoly"/>, Length: <see cref="polyCount"/>]
+        /// </summary>
+        public IntPtr polys;
+
+        /// <summary>
+        /// The polygon vertices. [(x, y, z) * <see cref="vertCount"/>]
+        /// </summary>
+        public IntPtr verts;
+
+        /// <summary>
+        /// The polygon links. [Type: <see cref="NavmeshLink"/>, Length: <see cref="linkCount"/>]
+        /// </summary>
+        public IntPtr links;
+
+        /// <summary>
+        /// The detail meshes. 
+        /// [Type: <see cref="NavmeshDetailMesh"/>, Length: <see cref="detailMeshCount"/>]
+        /// </summary>
+        public IntPtr detailMeshes;
+
+        /// <summary>
+        /// The detail vertices. [(x, y, z) * <see cref="detailVertCount"/>] 
+        /// (Zero for compact tiles.)
+        /// </summary>
+        public IntPtr detailVerts;
+
+        /// <summary>
+        /// The quantized detail vertices of a compact tile. [(x, y, z) * 
+        /// <see cref="detailVertCount"/>] (Zero if the tile is not compact.)
+        /// </summary>
+        public IntPtr detailQuantVerts;
+
+        /// <summary>
+        /// The values used to decode <see cref="detailQuantVerts"/>. 
+        /// [(originX, originY, originZ, stepX, stepY, stepZ)] (Zero if the tile is not compact.)
+        /// </summary>
+        public IntPtr detailQuantParams;
+
+        /// <summary>
+        /// The detail triangles. [(vertA, vertB, vertC, flags) * <see cref="detailTriCount"/>]
+        /// </summary>
+        public IntPtr detailTris;
+
+        /// <summary>
+        /// The bounding volume tree. 
+        /// [Type: <see cref="NavmeshBVNode"/>, Length: <see cref="bvNodeCount"/>]
+        /// </summary>
+        public IntPtr bvTree;
+
+        /// <summary>
+        /// The off-mesh connections. 
+        /// [Type: <see cref="NavmeshConnection"/>, Length: <see cref="connCount"/>]
+        /// </summary>
+        public IntPtr connections;
+
+        /// <summary>
+        /// The reference of the tile.
+        /// </summary>
+        public TileRef tileRef;
+
+        /// <summary>
+        /// The reference of the base polygon in the tile.
+        /// </summary>
+        public PolyRef polyRefBase;
+
+        /// <summary>
+        /// The number of polygons.
+        /// </summary>
+        public int polyCount;
+
+        /// <summary>
+        /// The number of polygon vertices.
+        /// </summary>
+        public int vertCount;
+
+        /// <summary>
+        /// The number of links. (Allocated, not all may be in use.)
+        /// </summary>
+        public int linkCount;
+
+        /// <summary>
+        /// The number of detail meshes.
+        /// </summary>
+        public int detailMeshCount;
+
+        /// <summary>
+        /// The number of detail vertices.
+        /// </summary>
+        public int detailVertCount;
+
+        /// <summary>
+        /// The number of detail triangles.
+        /// </summary>
+        public int detailTriCount;
+
+        /// <summary>
+        /// The number of bounding volume nodes.
+        /// </summary>
+        public int bvNodeCount;
+
+        /// <summary>
+        /// The number of off-mesh connections.
+        /// </summary>
+        public int connCount;
+
+        /// <summary>
+        /// The size of a polygon in bytes.
+        /// </summary>
+        public int polyStride;
+
+        /// <summary>
+        /// The size of a polygon vertex in bytes.
+        /// </summary>
+        public int vertStride;
+
+        /// <summary>
+        /// The size of a link in bytes.
+        /// </summary>
+        public int linkStride;
+
+        /// <summary>
+        /// The size of a detail mesh in bytes.
+        /// </summary>
+        public int detailMeshStride;
+
+        /// <summary>
+        /// The size of a detail vertex in bytes. (Quantized for compact tiles.)
+        /// </summary>
+        public int detailVertStride;
+
+        /// <summary>
+        /// The size of a detail triangle in bytes.
+        /// </summary>
+        public int detailTriStride;
+
+        /// <summary>
+        /// The size of a bounding volume node in bytes.
+        /// </summary>
+        public int bvNodeStride;
+
+        /// <summary>
+        /// The size of an off-mesh connection in bytes.
+        /// </summary>
+        public int connStride;
+
+        /// <summary>
+        /// True if the tile is compact. (Has quantized detail vertices.)
+        /// </summary>
+        public bool IsCompact { get { return detailQuantVerts != IntPtr.Zero; } }
+    }
+}
@@ -0,0 +1,73 @@
+﻿/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+using System.Runtime.InteropServices;
+
+namespace org.critterai.nav
+{
+    /// <summary>
+    /// Hit and miss counters for a native path cache.
+    /// </summary>
+    /// <remarks>
+    /// <para>
+    /// The miss count includes the lookups that found a cached path which was
+    /// discarded because the navigation mesh changed under it.
+    /// </para>
+    /// </remarks>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct PathCacheStats
+    {
+        /*
+         * Source: DetourPathCache dtPathCacheStats (struct)
+         */
+
+        /// <summary>
+        /// The number of cached paths.
+        /// </summary>
+        public int entryCount;
+
+        /// <summary>
+        /// The maximum number of cached paths.
+        /// </summary>
+        public int maxEntries;
+
+        /// <summary>
+        /// The number of lookups that returned a cached path.
+        /// </summary>
+        public uint hitCount;
+
+        /// <summary>
+        /// The number of lookups that found no usable path.
+        /// </summary>
+        public uint missCount;
+
+        /// <summary>
+        /// The number of cached paths discarded because a polygon on the path
+        /// was removed, or its flags or area changed.
+        /// </summary>
+        public uint invalidCount;
+
+        /// <summary>
+        /// The number of cached paths discarded to make room for new ones.
+        /// </summary>
+        public uint evictCount;
+    }
+}
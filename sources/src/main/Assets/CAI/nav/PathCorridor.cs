@@ -27,6 +27,11 @@ using Vector3 = org.critterai.Vector3;
 #else
 using Vector3 = UnityEngine.Vector3;
 #endif
+#if CAI_POLYREF64
+using PolyRef = System.UInt64;
+#else
+using PolyRef = System.UInt32;
+#endif
 
 namespace org.critterai.nav
 {
@@ -465,7 +470,7 @@ namespace org.critterai.nav
         /// <param name="startPosition">The start position.</param>
         /// <param name="endPosition">The end position.</param>
         /// <returns>True if the operation succeeded.</returns>
-        public bool MoveOverConnection(uint connectionRef, uint[] endpointRefs
+        public bool MoveOverConnection(PolyRef connectionRef, PolyRef[] endpointRefs
             , Vector3 startPosition, Vector3 endPosition)
         {
             return PathCorridorEx.dtpcMoveOverOffmeshConnection(mRoot
@@ -590,7 +595,7 @@ namespace org.critterai.nav
         /// [Limits: 0 &lt;= value &lt;= <see cref="MaxPathSize"/>]
         /// </param>
         public void SetCorridor(Vector3 target
-            , uint[] path
+            , PolyRef[] path
             , int pathCount)
         {
             mCorners.cornerCount = PathCorridorEx.dtpcSetCorridor(mRoot
@@ -610,7 +615,7 @@ namespace org.critterai.nav
         /// </remarks>
         /// <param name="buffer">The buffer to load with the result. [(polyRef) * pathCount]</param>
         /// <returns>The number of polygons in the path.</returns>
-        public int GetPath(uint[] buffer)
+        public int GetPath(PolyRef[] buffer)
         {
             return PathCorridorEx.dtpcGetPath(mRoot, buffer, buffer.Length);
         }
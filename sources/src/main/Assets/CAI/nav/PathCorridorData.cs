@@ -26,6 +26,11 @@ using Vector3 = org.critterai.Vector3;
 #else
 using Vector3 = UnityEngine.Vector3;
 #endif
+#if CAI_POLYREF64
+using PolyRef = System.UInt64;
+#else
+using PolyRef = System.UInt32;
+#endif
 
 namespace org.critterai.nav
 {
@@ -66,7 +71,7 @@ namespace org.critterai.nav
         /// [(polyRef) * <see cref="pathCount"/>]
         /// </summary>
         [MarshalAs(UnmanagedType.ByValArray, SizeConst = MarshalBufferSize)]
-        public uint[] path;
+        public PolyRef[] path;
 
         /// <summary>
         /// The number of polygons in the path.
@@ -79,7 +84,7 @@ namespace org.critterai.nav
         /// </summary>
         public PathCorridorData() 
         {
-            path = new uint[MarshalBufferSize];
+            path = new PolyRef[MarshalBufferSize];
         }
 
         /// <summary>
@@ -88,7 +93,7 @@ namespace org.critterai.nav
         /// <param name="maxPathSize">The maximum path size the buffer can hold.</param>
         public PathCorridorData(int maxPathSize)
         {
-            path = new uint[maxPathSize];
+            path = new PolyRef[maxPathSize];
         }
     }
 }
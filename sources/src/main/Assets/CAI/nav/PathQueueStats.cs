@@ -0,0 +1,91 @@
+﻿/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+using System.Runtime.InteropServices;
+
+namespace org.critterai.nav
+{
+    /// <summary>
+    /// Path request queue statistics for a <see cref="CrowdManager"/> or <see cref="PathScheduler"/> object.
+    /// </summary>
+    /// <remarks>
+    /// <para>
+    /// Wait times are measured in crowd updates, or scheduler pump calls.
+    /// </para>
+    /// </remarks>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct PathQueueStats
+    {
+        /*
+         * Source: DetourPathQueue dtPathQueueStats (struct)
+         */
+
+        /// <summary>
+        /// The maximum number of requests the queue can hold.
+        /// </summary>
+        public int maxQueue;
+
+        /// <summary>
+        /// The number of requests waiting for, or being processed by, the pathfinder.
+        /// </summary>
+        public int pendingCount;
+
+        /// <summary>
+        /// The number of completed requests waiting for their results to be read.
+        /// </summary>
+        public int readyCount;
+
+        /// <summary>
+        /// The largest pending count seen since the statistics were reset.
+        /// </summary>
+        public int maxPendingCount;
+
+        /// <summary>
+        /// The number of requests refused because the queue was full.
+        /// </summary>
+        public int rejectedCount;
+
+        /// <summary>
+        /// The number of requests completed since the statistics were reset.
+        /// </summary>
+        public int completedCount;
+
+        /// <summary>
+        /// The longest time a completed request spent in the queue.
+        /// </summary>
+        public int maxWaitTicks;
+
+        /// <summary>
+        /// The average time completed requests spent in the queue.
+        /// </summary>
+        public float averageWaitTicks;
+
+        /// <summary>
+        /// The pathfinder iterations used by the last update.
+        /// </summary>
+        public int lastIterationCount;
+
+        /// <summary>
+        /// The time used by the last update. [Unit: Microseconds]
+        /// </summary>
+        public float lastUpdateTime;
+    }
+}
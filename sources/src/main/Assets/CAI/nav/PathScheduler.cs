@@ -0,0 +1,315 @@
+﻿/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+using System;
+using org.critterai.nav.rcn;
+using org.critterai.interop;
+#if CAI_POLYREF64
+using PolyRef = System.UInt64;
+#else
+using PolyRef = System.UInt32;
+#endif
+
+namespace org.critterai.nav
+{
+    /// <summary>
+    /// Runs many sliced path searches at once, advancing them all with a single call.
+    /// </summary>
+    /// <remarks>
+    /// <para>
+    /// The scheduler owns a pool of native query objects.  Each query runs one sliced search at 
+    /// a time.  A call to <see cref="Pump"/> shares its budget between the running searches, 
+    /// starts queued requests on the queries that become free, and returns the tickets of the 
+    /// requests that completed.  So any number of clients can be pathed at a fixed cost per 
+    /// frame, without a <see cref="CrowdManager"/>.
+    /// </para>
+    /// <para>
+    /// Requests are started highest priority first, oldest first among equals.  A completed 
+    /// request holds its slot until its path is read with <see cref="GetPathResult"/>, or it 
+    /// is cancelled.
+    /// </para>
+    /// <para>
+    /// The navigation mesh must not be modified while searches are in flight, and the filter 
+    /// of each request must not be disposed until the request completes.
+    /// </para>
+    /// <para>
+    /// Behavior is undefined if an object is used after disposal.
+    /// </para>
+    /// </remarks>
+    public sealed class PathScheduler
+        : IManagedObject
+    {
+        /// <summary>
+        /// The ticket value that never refers to a request.
+        /// </summary>
+        public const uint InvalidTicket = 0;
+
+        private IntPtr mRoot;
+        private Navmesh mNavmesh;
+        private int mSliceCount;
+        private int mMaxRequests;
+        private int mMaxPathSize;
+
+        /// <summary>
+        /// The number of searches that can be in flight at once.
+        /// </summary>
+        public int SliceCount { get { return mSliceCount; } }
+
+        /// <summary>
+        /// The number of queued, running, and completed requests that can be held at once.
+        /// </summary>
+        public int MaxRequests { get { return mMaxRequests; } }
+
+        /// <summary>
+        /// The maximum path size of a request result.
+        /// </summary>
+        public int MaxPathSize { get { return mMaxPathSize; } }
+
+        /// <summary>
+        /// The navigation mesh the searches run against.
+        /// </summary>
+        public Navmesh Navmesh { get { return mNavmesh; } }
+
+        /// <summary>
+        /// The type of unmanaged resource used by the object.
+        /// </summary>
+        public AllocType ResourceType { get { return AllocType.External; } }
+
+        /// <summary>
+        /// True if the object has been disposed and should no longer be used.
+        /// </summary>
+        public bool IsDisposed { get { return (mRoot == IntPtr.Zero); } }
+
+        private PathScheduler(IntPtr root
+            , Navmesh navmesh
+            , int sliceCount
+            , int maxRequests
+            , int maxPathSize)
+        {
+            mRoot = root;
+            mNavmesh = navmesh;
+            mSliceCount = sliceCount;
+            mMaxRequests = maxRequests;
+            mMaxPathSize = maxPathSize;
+        }
+
+        /// <summary>
+        /// Destructor.
+        /// </summary>
+        ~PathScheduler()
+        {
+            RequestDisposal();
+        }
+
+        /// <summary>
+        /// Immediately frees all unmanaged resources allocated by the object.
+        /// </summary>
+        public void RequestDisposal()
+        {
+            if (!IsDisposed)
+            {
+                PathSchedulerEx.dtpsFree(mRoot);
+                mRoot = IntPtr.Zero;
+                mNavmesh = null;
+            }
+        }
+
+        /// <summary>
+        /// Queues a path request.
+        /// </summary>
+        /// <param name="start">A point within the start polygon.</param>
+        /// <param name="end">A point within the end polygon.</param>
+        /// <param name="filter">
+        /// The filter to apply to the search.  (Must not be disposed until the request completes.)
+        /// </param>
+        /// <param name="priority">The request priority.  (Higher values are started first.)</param>
+        /// <param name="options">The search options.</param>
+        /// <returns>
+        /// The ticket of the request, or <see cref="InvalidTicket"/> if the scheduler is full.
+        /// </returns>
+        public uint Request(NavmeshPoint start
+            , NavmeshPoint end
+            , NavmeshQueryFilter filter
+            , float priority
+            , FindPathOptions options)
+        {
+            if (filter == null)
+                return InvalidTicket;
+
+            return PathSchedulerEx.dtpsRequest(mRoot, start, end, filter.root, priority, options);
+        }
+
+        /// <summary>
+        /// Advances the searches and returns the tickets of the requests that completed.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// A zero or negative budget removes that limit, but at least one must be set.
+        /// </para>
+        /// <para>
+        /// The call stops early, with the <see cref="NavStatus.BufferTooSmall"/> flag, if the 
+        /// ticket buffer fills.  The remaining completions are returned by the next call.
+        /// </para>
+        /// </remarks>
+        /// <param name="maxIterations">The maximum number of search iterations to perform.</param>
+        /// <param name="maxTime">The time budget for the call. [Unit: Microseconds]</param>
+        /// <param name="completed">
+        /// The tickets of the requests that completed. [Length: >= 1]
+        /// </param>
+        /// <param name="completedCount">The number of tickets returned.</param>
+        /// <returns>The <see cref="NavStatus" /> flags for the operation.</returns>
+        public NavStatus Pump(int maxIterations
+            , float maxTime
+            , uint[] completed
+            , out int completedCount)
+        {
+            completedCount = 0;
+
+            if (completed == null || completed.Length == 0)
+                return NavStatus.Failure | NavStatus.InvalidParam;
+
+            return PathSchedulerEx.dtpsPump(mRoot
+                , maxIterations
+                , maxTime
+                , completed
+                , completed.Length
+                , ref completedCount);
+        }
+
+        /// <summary>
+        /// Gets the status of a request.
+        /// </summary>
+        /// <param name="ticket">The ticket of the request.</param>
+        /// <returns>
+        /// The status of the completed search, zero if the request has not completed, or a 
+        /// failure if the ticket is not valid.
+        /// </returns>
+        public NavStatus GetRequestStatus(uint ticket)
+        {
+            return PathSchedulerEx.dtpsGetRequestStatus(mRoot, ticket);
+        }
+
+        /// <summary>
+        /// Copies the path of a completed request and frees the request.
+        /// </summary>
+        /// <param name="ticket">The ticket of the request.</param>
+        /// <param name="path">
+        /// The path. (Must be at least length 1.) [(polyRef) * pathCount]
+        /// </param>
+        /// <param name="pathCount">The number of polygons in the path.</param>
+        /// <returns>
+        /// The status of the search, with <see cref="NavStatus.BufferTooSmall"/> if the path was 
+        /// truncated, or <see cref="NavStatus.InProgress"/> if the request has not completed.
+        /// </returns>
+        public NavStatus GetPathResult(uint ticket, PolyRef[] path, out int pathCount)
+        {
+            pathCount = 0;
+
+            if (path == null || path.Length == 0)
+                return NavStatus.Failure | NavStatus.InvalidParam;
+
+            return PathSchedulerEx.dtpsGetPathResult(mRoot
+                , ticket
+                , path
+                , ref pathCount
+                , path.Length);
+        }
+
+        /// <summary>
+        /// Frees a request, stopping its search if it is running.
+        /// </summary>
+        /// <param name="ticket">The ticket of the request.</param>
+        /// <returns>The <see cref="NavStatus" /> flags for the operation.</returns>
+        public NavStatus Cancel(uint ticket)
+        {
+            return PathSchedulerEx.dtpsCancel(mRoot, ticket);
+        }
+
+        /// <summary>
+        /// Gets the request statistics.  (Wait times are measured in <see cref="Pump"/> calls.)
+        /// </summary>
+        /// <returns>The request statistics.</returns>
+        public PathQueueStats GetStats()
+        {
+            PathQueueStats stats = new PathQueueStats();
+            PathSchedulerEx.dtpsGetStats(mRoot, ref stats);
+            return stats;
+        }
+
+        /// <summary>
+        /// Resets the request statistics.
+        /// </summary>
+        public void ResetStats()
+        {
+            PathSchedulerEx.dtpsResetStats(mRoot);
+        }
+
+        /// <summary>
+        /// Creates a new path scheduler.
+        /// </summary>
+        /// <param name="navmesh">The navigation mesh to search.</param>
+        /// <param name="maximumNodes">
+        /// The maximum number of nodes allowed for each search.
+        /// </param>
+        /// <param name="sliceCount">
+        /// The number of searches that can be in flight at once. [Limit: >= 1]
+        /// </param>
+        /// <param name="maxRequests">
+        /// The number of queued, running, and completed requests that can be held at once.
+        /// [Limit: 1 &lt;= value &lt;= 65535]
+        /// </param>
+        /// <param name="maxPathSize">The maximum path size of a request result.</param>
+        /// <param name="resultScheduler">The new path scheduler, or null on error.</param>
+        /// <returns>The <see cref="NavStatus" /> flags for the operation.</returns>
+        public static NavStatus Create(Navmesh navmesh
+            , int maximumNodes
+            , int sliceCount
+            , int maxRequests
+            , int maxPathSize
+            , out PathScheduler resultScheduler)
+        {
+            resultScheduler = null;
+
+            if (navmesh == null || navmesh.IsDisposed)
+                return NavStatus.Failure | NavStatus.InvalidParam;
+
+            IntPtr root = IntPtr.Zero;
+
+            NavStatus status = PathSchedulerEx.dtpsAlloc(navmesh.root
+                , maximumNodes
+                , sliceCount
+                , maxRequests
+                , maxPathSize
+                , ref root);
+
+            if (NavUtil.Succeeded(status))
+            {
+                resultScheduler = new PathScheduler(root
+                    , navmesh
+                    , sliceCount
+                    , maxRequests
+                    , maxPathSize);
+            }
+
+            return status;
+        }
+    }
+}
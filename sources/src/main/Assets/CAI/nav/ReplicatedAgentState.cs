@@ -0,0 +1,74 @@
+﻿/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+using System.Runtime.InteropServices;
+#if NUNITY
+using Vector3 = org.critterai.Vector3;
+#else
+using Vector3 = UnityEngine.Vector3;
+#endif
+#if CAI_POLYREF64
+using PolyRef = System.UInt64;
+#else
+using PolyRef = System.UInt32;
+#endif
+
+namespace org.critterai.nav
+{
+    /// <summary>
+    /// The replicated state of a crowd agent, as applied by a <see cref="CrowdStateDecoder"/>.
+    /// </summary>
+    /// <remarks>
+    /// <para>
+    /// The position and velocity are quantized to the precision of the stream.  All fields are 
+    /// zero for an inactive agent.
+    /// </para>
+    /// </remarks>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct ReplicatedAgentState
+    {
+        /*
+         * Design notes:
+         * 
+         * Duplicate of: rcnReplicatedAgentState
+         */
+
+        /// <summary>
+        /// The state of the agent.
+        /// </summary>
+        public CrowdAgentState state;
+
+        /// <summary>
+        /// The reference of the polygon that contains the position.
+        /// </summary>
+        public PolyRef positionPoly;
+
+        /// <summary>
+        /// The position of the agent.
+        /// </summary>
+        public Vector3 position;
+
+        /// <summary>
+        /// The velocity of the agent.
+        /// </summary>
+        public Vector3 velocity;
+    }
+}
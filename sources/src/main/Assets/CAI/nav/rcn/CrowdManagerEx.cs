@@ -40,11 +40,86 @@ namespace org.critterai.nav.rcn
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern IntPtr dtcDetourCrowdAlloc(int maxAgents
             , float maxAgentRadius
-            , IntPtr navmesh);
+            , IntPtr navmesh
+            , int gridType);
 
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern void dtcDetourCrowdFree(IntPtr crowd);
 
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern IntPtr dtcCreateThreadPool(int threadCount);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtcFreeThreadPool(IntPtr pool);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern bool dtcSetThreadPool(IntPtr crowd, IntPtr pool);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtcSetPathQueueBudget(IntPtr crowd
+            , int maxIterations
+            , float maxTime);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtcSetPathCache(IntPtr crowd
+            , IntPtr cache);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtcSetFlowFieldCache(IntPtr crowd
+            , IntPtr cache);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtcSetPathPriorityCenter(IntPtr crowd
+            , [In] ref Vector3 position
+            , float weight);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtcSetAgentPathPriority(IntPtr crowd
+            , int index
+            , float priority);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtcSetLodParams(IntPtr crowd
+            , [In] ref CrowdLodParams lodParams);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtcGetLodParams(IntPtr crowd
+            , ref CrowdLodParams lodParams);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtcSetLodObservers(IntPtr crowd
+            , [In] Vector3[] positions
+            , int count);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtcSetAgentLod(IntPtr crowd
+            , int index
+            , CrowdAgentLod lod);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtcGetPathQueueStats(IntPtr crowd
+            , ref PathQueueStats stats
+            , ref int waitingCount);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtcGetMemoryStats(IntPtr crowd
+            , ref CrowdMemoryStats stats);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern int dtcGetStateSize(IntPtr crowd);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtcStoreState(IntPtr crowd
+            , [In, Out] byte[] stateData
+            , int dataSize);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtcRestoreState(IntPtr crowd
+            , [In] byte[] stateData
+            , int dataSize
+            , [In, Out] IntPtr[] agents
+            , [In, Out] CrowdAgentCoreState[] coreStates);
+
 	    [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern void dtcSetObstacleAvoidanceParams(IntPtr crowd
             , int index
@@ -102,6 +177,15 @@ namespace org.critterai.nav.rcn
             , float deltaTime
             , [In, Out] CrowdAgentCoreState[] coreStates);
 
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern int dtcUpdateBuffers(IntPtr crowd
+            , float deltaTime
+            , [In] ref CrowdAgentBuffers buffers);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern int dtcGetAgentBuffers(IntPtr crowd
+            , [In] ref CrowdAgentBuffers buffers);
+
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern IntPtr dtcGetNavMeshQuery(IntPtr crowd);
 
@@ -110,6 +194,11 @@ namespace org.critterai.nav.rcn
             , int agentIndex
             , NavmeshPoint position);
 
+	    [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern bool dtcRequestFlowFieldTarget(IntPtr crowd
+            , int agentIndex
+            , NavmeshPoint position);
+
 	    [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern bool dtcAdjustMoveTarget(IntPtr crowd
             , int agentIndex
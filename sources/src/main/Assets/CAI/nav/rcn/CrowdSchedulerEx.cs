@@ -0,0 +1,61 @@
+﻿/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+using System;
+using System.Runtime.InteropServices;
+
+namespace org.critterai.nav.rcn
+{
+    internal static class CrowdSchedulerEx
+    {
+        /*
+         * Design note: In order to stay compatible with Unity iOS, all
+         * extern methods must be unique and match DLL entry point.
+         * (Can't use EntryPoint.)
+         */
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtcsAlloc(int maxCrowds
+            , int threadCount
+            , ref IntPtr resultScheduler);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtcsFree(IntPtr scheduler);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern int dtcsAddCrowd(IntPtr scheduler, IntPtr crowd);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern bool dtcsRemoveCrowd(IntPtr scheduler, IntPtr crowd);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern int dtcsGetWorkerCount(IntPtr scheduler);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern float dtcsGetLastUpdateTime(IntPtr scheduler);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtcUpdateAll(IntPtr scheduler
+            , float deltaTime
+            , [In] IntPtr[] coreStates
+            , [In, Out] float[] tickTimes);
+    }
+}
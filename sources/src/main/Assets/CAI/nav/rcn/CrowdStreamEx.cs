@@ -0,0 +1,72 @@
+﻿/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+using System;
+using System.Runtime.InteropServices;
+using org.critterai.nav;
+
+namespace org.critterai.nav.rcn
+{
+    internal static class CrowdStreamEx
+    {
+        /*
+         * Design note: In order to stay compatible with Unity iOS, all
+         * extern methods must be unique and match DLL entry point.
+         * (Can't use EntryPoint.)
+         */
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtcseAlloc(int maxAgents
+            , float positionPrecision
+            , float velocityPrecision
+            , ref IntPtr resultEncoder);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtcseFree(IntPtr encoder);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtcseReset(IntPtr encoder);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtcWriteStateDelta(IntPtr crowd
+            , IntPtr encoder
+            , [In, Out] byte[] stream
+            , int maxSize
+            , ref int size
+            , ref int agentCount);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtcsdAlloc(int maxAgents
+            , float positionPrecision
+            , float velocityPrecision
+            , ref IntPtr resultDecoder);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtcsdFree(IntPtr decoder);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtcsdRead(IntPtr decoder
+            , [In] byte[] stream
+            , int size
+            , [In, Out] ReplicatedAgentState[] states
+            , [In, Out] uint[] dirtyMask);
+    }
+}
@@ -51,5 +51,8 @@ namespace org.critterai.nav.rcn
             [In] Vector3[] vector3in
             , int vectorCount
             , [In, Out] Vector3[] vector3out);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern int dtvlGetPolyRefSize();
     }
 }
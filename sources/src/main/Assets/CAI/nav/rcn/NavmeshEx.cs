@@ -26,6 +26,13 @@ using Vector3 = org.critterai.Vector3;
 #else
 using Vector3 = UnityEngine.Vector3;
 #endif
+#if CAI_POLYREF64
+using PolyRef = System.UInt64;
+using TileRef = System.UInt64;
+#else
+using PolyRef = System.UInt32;
+using TileRef = System.UInt32;
+#endif
 
 namespace org.critterai.nav.rcn
 {
@@ -48,6 +55,22 @@ namespace org.critterai.nav.rcn
             , bool safeStorage
             , ref IntPtr resultNavMesh);
 
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtnmCreateSharedNavMeshData([In] byte[] rawMeshData
+            , int dataSize
+            , ref IntPtr resultShared);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtnmReleaseSharedNavMeshData(ref IntPtr shared);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtnmBuildSharedNavMesh(IntPtr shared
+            , ref IntPtr resultNavMesh);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtnmFreeSharedNavMesh(IntPtr shared
+            , ref IntPtr navmesh);
+
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern NavStatus dtnmInitTiledNavMesh(NavmeshParams config
             , ref IntPtr navmesh);
@@ -62,15 +85,40 @@ namespace org.critterai.nav.rcn
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern NavStatus dtnmAddTile(IntPtr navmesh
             , [In, Out] NavmeshTileData tileData
-            , uint lastRef
-            , ref uint resultRef);
+            , TileRef lastRef
+            , ref TileRef resultRef);
 
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern NavStatus dtnmRemoveTile(IntPtr navmesh
-            , uint tileRef
+            , TileRef tileRef
             , ref IntPtr resultData
             , ref int resultDataSize);
 
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtnmSetPolyGridsEnabled(IntPtr navmesh
+            , bool enabled);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern bool dtnmGetPolyGridsEnabled(IntPtr navmesh);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtnmSetHeightGridsEnabled(IntPtr navmesh
+            , bool enabled);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern bool dtnmGetHeightGridsEnabled(IntPtr navmesh);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtnmGetMemoryStats(IntPtr navmesh
+            , ref NavmeshMemoryStats stats);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtnmInitConcurrentReads(IntPtr navmesh
+            , int maxReaders);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern int dtnmReclaimRetiredTiles(IntPtr navmesh);
+
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern void dtnmCalcTileLoc(IntPtr navmesh
             , [In] ref Vector3 position
@@ -91,7 +139,7 @@ namespace org.critterai.nav.rcn
             , int tilesSize);
 
         [DllImport(InteropUtil.PLATFORM_DLL)]
-        public static extern uint dtnmGetTileRefAt(IntPtr navMesh
+        public static extern TileRef dtnmGetTileRefAt(IntPtr navMesh
             , int x
             , int z
             , int layer);
@@ -100,7 +148,7 @@ namespace org.critterai.nav.rcn
 
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern IntPtr dtnmGetTileByRef(IntPtr navmesh
-            , uint tileRef);
+            , TileRef tileRef);
 
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern int dtnmGetMaxTiles(IntPtr navmesh);
@@ -111,44 +159,44 @@ namespace org.critterai.nav.rcn
 
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern NavStatus dtnmGetTileAndPolyByRef(IntPtr navmesh
-            , uint polyRef
+            , PolyRef polyRef
             , ref IntPtr tile
             , ref IntPtr poly);
 
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern bool dtnmIsValidPolyRef(IntPtr navmesh
-            , uint polyRef);
+            , PolyRef polyRef);
 
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern NavStatus dtnmGetConnectionEndPoints(
             IntPtr navmesh
-            , uint previousPolyRef
-            , uint polyRef
+            , PolyRef previousPolyRef
+            , PolyRef polyRef
             , [In, Out] ref Vector3 startPosition
             , [In, Out] ref Vector3 endPosition);
 
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern IntPtr dtnmGetOffMeshConnectionByRef(IntPtr navmesh
-            , uint polyRef);
+            , PolyRef polyRef);
 
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern NavStatus dtnmGetPolyFlags(IntPtr navmesh
-            , uint polyRef
+            , PolyRef polyRef
             , ref ushort flags);
 
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern NavStatus dtnmSetPolyFlags(IntPtr navmesh
-            , uint polyRef
+            , PolyRef polyRef
             , ushort flags);
 
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern NavStatus dtnmGetPolyArea(IntPtr navmesh
-            , uint polyRef
+            , PolyRef polyRef
             , ref byte area);
 
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern NavStatus dtnmSetPolyArea(IntPtr navmesh
-            , uint polyRef
+            , PolyRef polyRef
             , byte area);
 
         [DllImport(InteropUtil.PLATFORM_DLL)]
@@ -156,6 +204,32 @@ namespace org.critterai.nav.rcn
             , ref IntPtr resultData
             , ref int dataSize);
 
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtnmGetNavMeshIndexedData(IntPtr navmesh
+            , ref IntPtr resultData
+            , ref int dataSize);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern int dtnmGetNavMeshDataSize(IntPtr navmesh
+            , bool indexed
+            , [In] TileRef[] tileRefs
+            , int tileRefCount);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtnmWriteNavMeshData(IntPtr navmesh
+            , bool indexed
+            , [In] TileRef[] tileRefs
+            , int tileRefCount
+            , [In, Out] byte[] buffer
+            , int bufferSize
+            , ref int dataSize);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtnmValidateNavMeshTiles([In] byte[] rawMeshData
+            , int dataSize
+            , int firstTile
+            , int tileCount);
+
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern void dtnmFreeBytes(ref IntPtr data);
     }
@@ -26,6 +26,11 @@ using Vector3 = org.critterai.Vector3;
 #else
 using Vector3 = UnityEngine.Vector3;
 #endif
+#if CAI_POLYREF64
+using PolyRef = System.UInt64;
+#else
+using PolyRef = System.UInt32;
+#endif
 
 namespace org.critterai.nav.rcn
 {
@@ -45,12 +50,21 @@ namespace org.critterai.nav.rcn
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern void dtnqFree(ref IntPtr query);
 
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern int dtnqGetMemUsed(IntPtr query);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtnqBeginRead(IntPtr query);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtnqEndRead(IntPtr query);
+
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern NavStatus dtqGetPolyWallSegments(IntPtr query
-            , uint polyRef
+            , PolyRef polyRef
             , IntPtr filter
             , [In, Out] Vector3[] segmentVerts
-            , [In, Out] uint[] segmentPolyRefs
+            , [In, Out] PolyRef[] segmentPolyRefs
             , ref int segmentCount
             , int maxSegments);
 
@@ -61,15 +75,31 @@ namespace org.critterai.nav.rcn
 		    , IntPtr filter
 		    , ref NavmeshPoint nearest);
 
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtqFindNearestPolyWithOptions(IntPtr query
+            , [In] ref Vector3 position
+            , [In] ref Vector3 extents
+            , IntPtr filter
+            , int options
+            , ref NavmeshPoint nearest);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtqFindNearestPolyHinted(IntPtr query
+            , PolyRef hintRef
+            , [In] ref Vector3 position
+            , [In] ref Vector3 extents
+            , IntPtr filter
+            , ref NavmeshPoint nearest);
+
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern NavStatus dtqClosestPointOnPoly(IntPtr query
-            , uint polyRef
+            , PolyRef polyRef
             , [In] ref Vector3 position
             , ref Vector3 resultPoint);
 
 	    [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern NavStatus dtqClosestPointOnPolyBoundary(IntPtr query 
-            , uint polyRef
+            , PolyRef polyRef
             , [In] ref Vector3 position
             , [In] ref Vector3 resultPoint);
 
@@ -78,42 +108,42 @@ namespace org.critterai.nav.rcn
                 , ref Vector3 position
                 , ref Vector3 extents
                 , IntPtr filter
-                , [In, Out] uint[] resultPolyRefs
+                , [In, Out] PolyRef[] resultPolyRefs
                 , ref int resultCount
                 , int maxResult);
 
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern NavStatus dtqFindPolysAroundCircle(IntPtr query
-                , uint startPolyRef
+                , PolyRef startPolyRef
                 , [In] ref Vector3 position
                 , float radius
                 , IntPtr filter
-                , [In, Out] uint[] resultPolyRefs  // Optional
-                , [In, Out] uint[] resultParentRefs // Optional
+                , [In, Out] PolyRef[] resultPolyRefs  // Optional
+                , [In, Out] PolyRef[] resultParentRefs // Optional
                 , [In, Out] float[] resultCosts // Optional
                 , ref int resultCount
                 , int maxResult);
 
 	    [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern NavStatus dtqFindPolysAroundShape(IntPtr query 
-            , uint startPolyRef
+            , PolyRef startPolyRef
             , [In] Vector3[] verts
             , int vertCount
 	        , IntPtr filter
-	        , [In, Out] uint[] resultPolyRefs
-            , [In, Out] uint[] resultParentRefs
+	        , [In, Out] PolyRef[] resultPolyRefs
+            , [In, Out] PolyRef[] resultParentRefs
             , [In, Out] float[] resultCosts
 	        , ref int resultCount
             , int maxResult);
 
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern NavStatus dtqFindLocalNeighbourhood(IntPtr query
-            , uint startPolyRef
+            , PolyRef startPolyRef
             , [In] ref Vector3 position
             , float radius
             , IntPtr filter
-            , [In, Out] uint[] resultPolyRefs
-            , [In, Out] uint[] resultParentRefs
+            , [In, Out] PolyRef[] resultPolyRefs
+            , [In, Out] PolyRef[] resultParentRefs
             , ref int resultCount
             , int maxResult);
 
@@ -136,7 +166,16 @@ namespace org.critterai.nav.rcn
             , NavmeshPoint startPosition
             , NavmeshPoint endPosition
             , IntPtr filter
-            , [In, Out] uint[] resultPath
+            , [In, Out] PolyRef[] resultPath
+            , ref int pathCount
+            , int maxPath);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtqFindPathBidirectional(IntPtr query
+            , NavmeshPoint startPosition
+            , NavmeshPoint endPosition
+            , IntPtr filter
+            , [In, Out] PolyRef[] resultPath
             , ref int pathCount
             , int maxPath);
 
@@ -146,18 +185,26 @@ namespace org.critterai.nav.rcn
             , ref NavmeshPoint endPosition
             , [In] ref Vector3 extents
             , IntPtr filter
-            , [In, Out] uint[] resultPath
+            , [In, Out] PolyRef[] resultPath
             , ref int pathCount
             , int maxPath);
 
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern bool dtqIsInClosedList(IntPtr query
-            , uint polyRef);
+            , PolyRef polyRef);
 
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern bool dtqIsValidPolyRef(IntPtr query
-            , uint polyRef
+            , PolyRef polyRef
             , IntPtr filter);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern bool dtqGetQueryStats(IntPtr query
+            , ref NavmeshQueryStats lastQuery
+            , ref NavmeshQueryStats total);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtqResetQueryStats(IntPtr query);
 	
 	    [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern NavStatus dtqRaycast(IntPtr query
@@ -166,7 +213,7 @@ namespace org.critterai.nav.rcn
 	        , IntPtr filter
 	        , ref float hitParameter 
             , ref Vector3 hitNormal
-            , [In, Out] uint[] path
+            , [In, Out] PolyRef[] path
             , ref int pathCount
             , int maxPath);
 
@@ -174,12 +221,12 @@ namespace org.critterai.nav.rcn
         public static extern NavStatus dtqFindStraightPath(IntPtr query
             , [In] ref Vector3 startPosition
             , [In] ref Vector3 endPosition
-            , [In] uint[] path
+            , [In] PolyRef[] path
             , int pathStart
             , int pathSize
             , [In, Out] Vector3[] straightPathPoints
             , [In, Out] WaypointFlag[] straightPathFlags
-            , [In, Out] uint[] straightPathRefs
+            , [In, Out] PolyRef[] straightPathRefs
             , ref int straightPathCount
             , int maxStraightPath);
 
@@ -189,7 +236,7 @@ namespace org.critterai.nav.rcn
             , [In] ref Vector3 endPosition
             , IntPtr filter
             , ref Vector3 resultPosition
-            , [In, Out] uint[] visitedPolyRefs
+            , [In, Out] PolyRef[] visitedPolyRefs
             , ref int visitedCount
             , int maxVisited);
 
@@ -206,7 +253,7 @@ namespace org.critterai.nav.rcn
 
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern NavStatus dtqFinalizeSlicedFindPath(IntPtr query
-            , [In, Out] uint[] path
+            , [In, Out] PolyRef[] path
             , ref int pathCount
             , int maxPath);
 
@@ -221,5 +268,95 @@ namespace org.critterai.nav.rcn
             , float radius
             , IntPtr filter
             , ref NavmeshPoint randomPt);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtrsAlloc(IntPtr query
+            , IntPtr filter
+            , ref IntPtr resultSampler);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtrsFree(IntPtr sampler);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtrsUpdate(IntPtr sampler
+            , ref int rebuildCount);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtrsInvalidateTile(IntPtr sampler
+            , IntPtr tile);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtrsInvalidateAll(IntPtr sampler);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtrsFindRandomPoint(IntPtr sampler
+            , ref NavmeshPoint randomPt);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtrsFindRandomPoints(IntPtr sampler
+            , int count
+            , [Out] NavmeshPoint[] randomPts);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtqFindNearestPolyBatch(IntPtr query
+            , [In] Vector3[] centers
+            , [In] Vector3[] extents
+            , int extentsCount
+            , [In] IntPtr[] filters
+            , int filterCount
+            , [In] int[] filterIndices
+            , int count
+            , [In, Out] PolyRef[] resultPolyRefs
+            , [In, Out] Vector3[] resultPoints
+            , [In, Out] NavStatus[] resultStatus);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtqFindNearestPolyHintedBatch(IntPtr query
+            , [In] Vector3[] centers
+            , [In] Vector3[] extents
+            , int extentsCount
+            , [In] IntPtr[] filters
+            , int filterCount
+            , [In] int[] filterIndices
+            , int count
+            , int options
+            , [In, Out] NavmeshPoint[] points
+            , [In, Out] NavStatus[] resultStatus);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtqRaycastBatch(IntPtr query
+            , [In] PolyRef[] startPolyRefs
+            , [In] Vector3[] startPositions
+            , [In] Vector3[] endPositions
+            , [In] IntPtr[] filters
+            , int filterCount
+            , [In] int[] filterIndices
+            , int count
+            , [In, Out] float[] resultHitParameters
+            , [In, Out] Vector3[] resultHitNormals
+            , [In, Out] NavStatus[] resultStatus);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtqFindPathBatch(IntPtr query
+            , [In] PolyRef[] startPolyRefs
+            , [In] PolyRef[] endPolyRefs
+            , [In] Vector3[] startPositions
+            , [In] Vector3[] endPositions
+            , [In] IntPtr[] filters
+            , int filterCount
+            , [In] int[] filterIndices
+            , int count
+            , [In, Out] PolyRef[] resultPaths
+            , [In, Out] int[] resultPathCounts
+            , int maxPath
+            , [In, Out] NavStatus[] resultStatus);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtqGetPolyHeightBatch(IntPtr query
+            , [In] PolyRef[] polyRefs
+            , [In] Vector3[] positions
+            , int count
+            , [In, Out] float[] resultHeights
+            , [In, Out] NavStatus[] resultStatus);
     }
 }
@@ -26,6 +26,13 @@ using Vector3 = org.critterai.Vector3;
 #else
 using Vector3 = UnityEngine.Vector3;
 #endif
+#if CAI_POLYREF64
+using PolyRef = System.UInt64;
+using TileRef = System.UInt64;
+#else
+using PolyRef = System.UInt32;
+using TileRef = System.UInt32;
+#endif
 
 namespace org.critterai.nav.rcn
 {
@@ -60,7 +67,7 @@ namespace org.critterai.nav.rcn
             , ref NavmeshTileHeader resultHeader);
 
         [DllImport(InteropUtil.PLATFORM_DLL)]
-        public static extern uint dtnmGetTileRef(IntPtr navmesh, IntPtr tile);
+        public static extern TileRef dtnmGetTileRef(IntPtr navmesh, IntPtr tile);
 
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern int dtnmGetTileStateSize(IntPtr navmesh, IntPtr tile);
@@ -81,7 +88,18 @@ namespace org.critterai.nav.rcn
         public static extern IntPtr dtnmGetTileHeader(IntPtr tile);
 
         [DllImport(InteropUtil.PLATFORM_DLL)]
-        public static extern uint dtnmGetPolyRefBase(IntPtr navmesh, IntPtr tile);
+        public static extern PolyRef dtnmGetPolyRefBase(IntPtr navmesh, IntPtr tile);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtnmGetTileView(IntPtr navmesh
+            , IntPtr tile
+            , ref NavmeshTileView view);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtnmGetTileViews(IntPtr navmesh
+            , [In, Out] NavmeshTileView[] views
+            , int maxViews
+            , ref int viewCount);
 
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern int dtnmGetTileVerts(IntPtr tile
@@ -0,0 +1,73 @@
+﻿/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+using System;
+using System.Runtime.InteropServices;
+#if CAI_POLYREF64
+using PolyRef = System.UInt64;
+#else
+using PolyRef = System.UInt32;
+#endif
+
+namespace org.critterai.nav.rcn
+{
+    internal static class PathCacheEx
+    {
+        /*
+         * Design note: In order to stay compatible with Unity iOS, all
+         * extern methods must be unique and match DLL entry point.
+         * (Can't use EntryPoint.)
+         */
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtpchAlloc(IntPtr navmesh
+            , int maxEntries
+            , int maxPathSize
+            , ref IntPtr resultCache);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtpchFree(IntPtr cache);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtpchFindPath(IntPtr cache
+            , IntPtr query
+            , NavmeshPoint startPosition
+            , NavmeshPoint endPosition
+            , IntPtr filter
+            , [In, Out] PolyRef[] resultPath
+            , ref int pathCount
+            , int maxPath);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtpchInvalidatePoly(IntPtr cache
+            , PolyRef polyRef);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtpchClear(IntPtr cache);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtpchGetStats(IntPtr cache
+            , ref PathCacheStats stats);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtpchResetStats(IntPtr cache);
+    }
+}
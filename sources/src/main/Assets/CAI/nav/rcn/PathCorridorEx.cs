@@ -26,6 +26,11 @@ using Vector3 = org.critterai.Vector3;
 #else
 using Vector3 = UnityEngine.Vector3;
 #endif
+#if CAI_POLYREF64
+using PolyRef = System.UInt64;
+#else
+using PolyRef = System.UInt32;
+#endif
 
 namespace org.critterai.nav.rcn
 {
@@ -51,7 +56,7 @@ namespace org.critterai.nav.rcn
         public static extern int dtpcFindCorners(IntPtr corridor
             , [In, Out] Vector3[] cornerVerts
             , [In, Out] WaypointFlag[] cornerFlags
-            , [In, Out] uint[] cornerPolys
+            , [In, Out] PolyRef[] cornerPolys
             , int maxCorners
             , IntPtr navquery
             , IntPtr filter);
@@ -69,7 +74,7 @@ namespace org.critterai.nav.rcn
             , float pathOptimizationRange
             , [In, Out] Vector3[] cornerVerts
             , [In, Out] WaypointFlag[] cornerFlags
-            , [In, Out] uint[] cornerPolys
+            , [In, Out] PolyRef[] cornerPolys
             , int maxCorners
             , IntPtr navquery
             , IntPtr filter);
@@ -83,15 +88,15 @@ namespace org.critterai.nav.rcn
         public static extern int dtpcOptimizePathTopologyExt(IntPtr corridor
             , [In, Out] Vector3[] cornerVerts
             , [In, Out] WaypointFlag[] cornerFlags
-            , [In, Out] uint[] cornerPolys
+            , [In, Out] PolyRef[] cornerPolys
             , int maxCorners
             , IntPtr navquery
             , IntPtr filter);
 
 	    [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern bool dtpcMoveOverOffmeshConnection(IntPtr corridor
-            , uint offMeshConRef
-            , [In, Out] uint[] refs // size 2
+            , PolyRef offMeshConRef
+            , [In, Out] PolyRef[] refs // size 2
             , ref Vector3 startPos
             , ref Vector3 endPos
             , ref NavmeshPoint resultPos
@@ -103,7 +108,7 @@ namespace org.critterai.nav.rcn
             , ref NavmeshPoint pos
             , [In, Out] Vector3[] cornerVerts
             , [In, Out] WaypointFlag[] cornerFlags
-            , [In, Out] uint[] cornerPolys
+            , [In, Out] PolyRef[] cornerPolys
             , int maxCorners
             , IntPtr navquery
             , IntPtr filter);
@@ -114,7 +119,7 @@ namespace org.critterai.nav.rcn
             , ref NavmeshPoint pos
             , [In, Out] Vector3[] cornerVerts
             , [In, Out] WaypointFlag[] cornerFlags
-            , [In, Out] uint[] cornerPolys
+            , [In, Out] PolyRef[] cornerPolys
             , int maxCorners
             , IntPtr navquery
             , IntPtr filter);
@@ -127,7 +132,7 @@ namespace org.critterai.nav.rcn
             , ref NavmeshPoint target
             , [In, Out] Vector3[] cornerVerts
             , [In, Out] WaypointFlag[] cornerFlags
-            , [In, Out] uint[] cornerPolys
+            , [In, Out] PolyRef[] cornerPolys
             , int maxCorners
             , IntPtr navquery
             , IntPtr filter);
@@ -135,19 +140,19 @@ namespace org.critterai.nav.rcn
 	    [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern int dtpcSetCorridor(IntPtr corridor
             , [In] ref Vector3 target
-            , [In] uint[] path
+            , [In] PolyRef[] path
             , int pathCount
             , ref NavmeshPoint resultTarget
             , [In, Out] Vector3[] cornerVerts
             , [In, Out] WaypointFlag[] cornerFlags
-            , [In, Out] uint[] cornerPolys
+            , [In, Out] PolyRef[] cornerPolys
             , int maxCorners
             , IntPtr navquery
             , IntPtr filter);
 
 	    [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern int dtpcGetPath(IntPtr corridor
-             , [In, Out] uint[] path
+             , [In, Out] PolyRef[] path
              , int maxPath);
 
 	    [DllImport(InteropUtil.PLATFORM_DLL)]
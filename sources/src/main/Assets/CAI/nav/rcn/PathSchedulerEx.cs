@@ -0,0 +1,91 @@
+﻿/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+using System;
+using System.Runtime.InteropServices;
+#if CAI_POLYREF64
+using PolyRef = System.UInt64;
+#else
+using PolyRef = System.UInt32;
+#endif
+
+namespace org.critterai.nav.rcn
+{
+    internal static class PathSchedulerEx
+    {
+        /*
+         * Design note: In order to stay compatible with Unity iOS, all
+         * extern methods must be unique and match DLL entry point.
+         * (Can't use EntryPoint.)
+         */
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtpsAlloc(IntPtr navmesh
+            , int maxNodes
+            , int sliceCount
+            , int maxRequests
+            , int maxPathSize
+            , ref IntPtr resultScheduler);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtpsFree(IntPtr scheduler);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern uint dtpsRequest(IntPtr scheduler
+            , NavmeshPoint startPosition
+            , NavmeshPoint endPosition
+            , IntPtr filter
+            , float priority
+            , FindPathOptions options);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtpsPump(IntPtr scheduler
+            , int maxIterations
+            , float maxTime
+            , [In, Out] uint[] completed
+            , int maxCompleted
+            , ref int completedCount);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtpsGetRequestStatus(IntPtr scheduler
+            , uint ticket);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtpsGetPathResult(IntPtr scheduler
+            , uint ticket
+            , [In, Out] PolyRef[] resultPath
+            , ref int pathCount
+            , int maxPath);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtpsCancel(IntPtr scheduler, uint ticket);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtpsSetPathCache(IntPtr scheduler, IntPtr cache);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtpsGetStats(IntPtr scheduler
+            , ref PathQueueStats stats);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtpsResetStats(IntPtr scheduler);
+    }
+}
@@ -0,0 +1,80 @@
+﻿/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+using System;
+using System.Runtime.InteropServices;
+#if NUNITY
+using Vector3 = org.critterai.Vector3;
+#else
+using Vector3 = UnityEngine.Vector3;
+#endif
+#if CAI_POLYREF64
+using PolyRef = System.UInt64;
+#else
+using PolyRef = System.UInt32;
+#endif
+
+namespace org.critterai.nav.rcn
+{
+    internal static class RaycastCacheEx
+    {
+        /*
+         * Design note: In order to stay compatible with Unity iOS, all
+         * extern methods must be unique and match DLL entry point.
+         * (Can't use EntryPoint.)
+         */
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtrcAlloc(IntPtr navmesh
+            , int maxEntries
+            , float quantum
+            , ref IntPtr resultCache);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtrcFree(IntPtr cache);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern bool dtrcSetThreadPool(IntPtr cache, IntPtr pool);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtrcRaycastBatch(IntPtr cache
+            , [In] PolyRef[] startPolyRefs
+            , [In] Vector3[] startPositions
+            , [In] Vector3[] endPositions
+            , [In] IntPtr[] filters
+            , int filterCount
+            , [In] int[] filterIndices
+            , int count
+            , [In, Out] float[] resultHitParameters
+            , [In, Out] Vector3[] resultHitNormals
+            , [In, Out] NavStatus[] resultStatus);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtrcClear(IntPtr cache);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtrcGetStats(IntPtr cache
+            , ref RaycastCacheStats stats);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtrcResetStats(IntPtr cache);
+    }
+}
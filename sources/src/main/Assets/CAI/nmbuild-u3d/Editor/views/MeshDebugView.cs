@@ -26,6 +26,11 @@ using org.critterai.nav.u3d;
 using org.critterai.nmgen;
 using org.critterai.u3d;
 using UnityEngine;
+#if CAI_POLYREF64
+using TileRef = System.UInt64;
+#else
+using TileRef = System.UInt32;
+#endif
 
 namespace org.critterai.nmbuild.u3d.editor
 {
@@ -130,7 +135,7 @@ namespace org.critterai.nmbuild.u3d.editor
                     {
                         foreach (NavmeshTileData tile in tiles)
                         {
-                            uint trash;
+                            TileRef trash;
                             status = navmesh.AddTile(tile, Navmesh.NullTile, out trash);
 
                             if ((status & NavStatus.Sucess) == 0)
@@ -461,6 +461,10 @@ namespace org.critterai.nmbuild
 
                 mBuildContext.Log("Generated regions. Region Count: " + chf.MaxRegion, this);
 
+                // The later stages don't use the distance field.
+                if (CanDispose(NMGenAssetFlag.CompactField))
+                    chf.ReleaseDistanceData();
+
                 // Success.
                 mState = NMGenState.ContourBuild;
             }
@@ -371,6 +371,25 @@ namespace org.critterai.nmgen
             get { return (mDistanceToBorder != IntPtr.Zero); } 
         }
 
+        /// <summary>
+        /// Frees the distance field data.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// Only the region build uses the distance field.  Releasing it after the regions are 
+        /// built reduces the memory held through the contour, poly mesh and detail mesh builds.
+        /// </para>
+        /// <para>
+        /// <see cref="MaxDistance"/> is reset to zero.
+        /// </para>
+        /// </remarks>
+        public void ReleaseDistanceData()
+        {
+            if (IsDisposed)
+                return;
+            CompactHeightfieldEx.nmcfFreeDistanceData(this);
+        }
+
         /// <summary>
         /// Erodes the walkable area within the heightfield by the specified radius.
         /// </summary>
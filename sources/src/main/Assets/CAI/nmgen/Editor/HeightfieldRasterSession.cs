@@ -0,0 +1,165 @@
+﻿/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+using System;
+using org.critterai.interop;
+using org.critterai.nmgen.rcn;
+#if NUNITY
+using Vector3 = org.critterai.Vector3;
+#else
+using Vector3 = UnityEngine.Vector3;
+#endif
+
+namespace org.critterai.nmgen
+{
+    /// <summary>
+    /// Voxelizes triangles into a heightfield as they arrive, so the full source 
+    /// mesh never needs to exist in one array.
+    /// </summary>
+    /// <remarks>
+    /// <para>
+    /// The heightfield is split into bands of rows with their own locks.  Each chunk 
+    /// only locks the bands its vertices overlap, so several threads can add chunks
+    /// at the same time.  Spans are merged in the order the chunks reach each band.  
+    /// A single thread that adds the chunks in mesh order gets the same result as 
+    /// <see cref="Heightfield.AddTriangles(BuildContext, TriangleMesh, byte[], int)"/>.
+    /// </para>
+    /// <para>
+    /// The heightfield must not be used for anything else while the session is open,
+    /// and the session must be closed before the heightfield is disposed.
+    /// </para>
+    /// <para>
+    /// Behavior is undefined if used after disposal.
+    /// </para>
+    /// </remarks>
+    public sealed class HeightfieldRasterSession
+        : IManagedObject
+    {
+        private IntPtr root;
+        private Heightfield mField;
+
+        /// <summary>
+        /// The heightfield the session rasterizes into.
+        /// </summary>
+        public Heightfield Field { get { return mField; } }
+
+        /// <summary>
+        /// The type of unmanaged resources within the object.
+        /// </summary>
+        public AllocType ResourceType { get { return AllocType.External; } }
+
+        /// <summary>
+        /// True if the session has been closed and should no longer be used.
+        /// </summary>
+        public bool IsDisposed { get { return root == IntPtr.Zero; } }
+
+        private HeightfieldRasterSession(IntPtr root, Heightfield field)
+        {
+            this.root = root;
+            mField = field;
+        }
+
+        /// <summary>
+        /// Destructor
+        /// </summary>
+        ~HeightfieldRasterSession()
+        {
+            RequestDisposal();
+        }
+
+        /// <summary>
+        /// Opens a session on the heightfield.
+        /// </summary>
+        /// <param name="context">The context to use for the session.</param>
+        /// <param name="field">The heightfield to rasterize into.</param>
+        /// <param name="bandCount">
+        /// The number of row bands. A value &lt;= 0 selects a count based on the
+        /// field depth.
+        /// </param>
+        /// <param name="flagMergeThreshold">
+        /// The distance where the walkable flag is favored over the non-walkable flag. 
+        /// [Limit: >= 0] [Normal: 1]
+        /// </param>
+        /// <returns>The session, or null on error.</returns>
+        public static HeightfieldRasterSession Open(BuildContext context
+            , Heightfield field
+            , int bandCount
+            , int flagMergeThreshold)
+        {
+            if (context == null || field == null || field.IsDisposed)
+                return null;
+
+            IntPtr root = HeightfieldEx.nmhfOpenRasterSession(context.root
+                , field.root
+                , bandCount
+                , flagMergeThreshold);
+
+            if (root == IntPtr.Zero)
+                return null;
+
+            return new HeightfieldRasterSession(root, field);
+        }
+
+        /// <summary>
+        /// Voxelizes a chunk of triangles into the heightfield.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// Thread-safe.  The arrays are only used for the duration of the call.
+        /// </para>
+        /// </remarks>
+        /// <param name="verts">The chunk vertices. [Length: >= vertCount]</param>
+        /// <param name="vertCount">The number of vertices in the chunk.</param>
+        /// <param name="tris">
+        /// The triangles, indexing into the chunk vertices. 
+        /// [(vertA, vertB, vertC) * triCount]
+        /// </param>
+        /// <param name="areas">
+        /// The ids of the areas the triangles belong to.
+        /// [Limit: &lt;= <see cref="NMGen.MaxArea"/>] [Size: >= triCount]
+        /// </param>
+        /// <param name="triCount">The number of triangles in the chunk.</param>
+        /// <returns>True if the operation was successful.</returns>
+        public bool AddTriangles(Vector3[] verts, int vertCount
+            , int[] tris, byte[] areas, int triCount)
+        {
+            if (IsDisposed)
+                return false;
+
+            return HeightfieldEx.nmhfAddRasterChunk(root
+                , verts, vertCount
+                , tris, areas, triCount);
+        }
+
+        /// <summary>
+        /// Closes the session.  All added triangles are in the heightfield on return.
+        /// </summary>
+        public void RequestDisposal()
+        {
+            if (!IsDisposed)
+            {
+                HeightfieldEx.nmhfCloseRasterSession(root);
+                root = IntPtr.Zero;
+                mField = null;
+            }
+        }
+    }
+}
@@ -53,6 +53,45 @@ namespace org.critterai.nmgen.rcn
         public static extern void nmbcLog(IntPtr ctx
             , [In, MarshalAs(UnmanagedType.LPStr)] string message);
 
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern int nmbcGetScratchPeak(IntPtr context, int stage);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern int nmbcGetWorkingSetPeak(IntPtr context, int stage);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void nmbcResetScratchPeaks(IntPtr context);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void nmbcEnableTimers(IntPtr context, bool state);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern bool nmbcGetTimersEnabled(IntPtr context);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void nmbcResetTimers(IntPtr context);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern int nmbcGetTimers(IntPtr context
+            , [In, Out] long[] times
+            , [In, Out] int[] counts
+            , int bufferSize);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern bool nmbcSetThreadPool(IntPtr context, IntPtr pool);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern IntPtr nmgCreateThreadPool(int threadCount);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void nmgFreeThreadPool(IntPtr pool);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void nmbcSetRasterizeFlags(IntPtr context, int flags);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern int nmbcGetRasterizeFlags(IntPtr context);
+
         // Note: It is ok for the method prefix to be different.
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern void nmgTestContext(IntPtr ctx, int count);
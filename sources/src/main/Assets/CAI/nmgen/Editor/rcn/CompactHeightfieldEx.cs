@@ -42,6 +42,10 @@ namespace org.critterai.nmgen.rcn
         public static extern void nmcfFreeFieldData(
             [In, Out] CompactHeightfield chf);
 
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void nmcfFreeDistanceData(
+            [In, Out] CompactHeightfield chf);
+
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern bool nmcfGetCellData([In] CompactHeightfield chf
             , [In, Out] CompactCell[] cells
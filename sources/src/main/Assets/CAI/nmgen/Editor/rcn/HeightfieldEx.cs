@@ -59,6 +59,33 @@ namespace org.critterai.nmgen.rcn
             , IntPtr hf
             , int flagMergeThreshold);
 
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern bool nmhfRasterizeTriMeshParallel(IntPtr context
+            , [In] Vector3[] verts
+            , int vertCount
+            , [In] int[] tris
+            , [In] byte[] areas
+            , int triCount
+            , IntPtr hf
+            , int flagMergeThreshold);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern IntPtr nmhfOpenRasterSession(IntPtr context
+            , IntPtr hf
+            , int bandCount
+            , int flagMergeThreshold);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern bool nmhfAddRasterChunk(IntPtr session
+            , [In] Vector3[] verts
+            , int vertCount
+            , [In] int[] tris
+            , [In] byte[] areas
+            , int triCount);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void nmhfCloseRasterSession(IntPtr session);
+
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern bool nmhfRasterizeNodes(IntPtr context
             , IntPtr verts
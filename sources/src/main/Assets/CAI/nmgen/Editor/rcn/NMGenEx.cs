@@ -51,5 +51,176 @@ namespace org.critterai.nmgen.rcn
 
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern void nmgFreeSerializationData(ref IntPtr data);
+
+        /// <summary>
+        /// Builds the poly and detail meshes for many tiles at once.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// The config is a native rcConfig and the detail meshes are a native nmgPolyMeshDetail 
+        /// array.  The markers are a native nmgAreaMarker array.  All must be pinned by the 
+        /// caller.
+        /// </para>
+        /// <para>
+        /// The cache is optional.  If provided, the tiles can later be rebuilt with
+        /// <see cref="nmgRebuildTiles"/>.
+        /// </para>
+        /// </remarks>
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern bool nmgBuildTiles(IntPtr ctx
+            , IntPtr config
+            , ContourBuildFlags contourFlags
+            , byte buildFlags
+            , [In] Vector3[] verts
+            , int nv
+            , [In] int[] tris
+            , [In] byte[] areas
+            , int nt
+            , IntPtr markers
+            , int markerCount
+            , [In] int[] tiles
+            , int tileCount
+            , int threadCount
+            , IntPtr cache
+            , [In, Out] PolyMeshEx[] polyMeshes
+            , IntPtr detailMeshes
+            , [In, Out] int[] maxVerts
+            , [In, Out] byte[] results);
+
+        /// <summary>
+        /// Builds the poly and detail meshes of many tiles for several agent radii at once.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// Each tile is rasterized and compacted once, then built for each radius.  The
+        /// config's walkable radius is ignored and its border size must suit the largest
+        /// radius.
+        /// </para>
+        /// <para>
+        /// The outputs are profile major.  The outputs of profile p start at index 
+        /// p * tileCount and match <see cref="nmgBuildTiles"/> with that radius. 
+        /// [Length: tileCount * profileCount]
+        /// </para>
+        /// </remarks>
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern bool nmgBuildTileProfiles(IntPtr ctx
+            , IntPtr config
+            , ContourBuildFlags contourFlags
+            , byte buildFlags
+            , [In] Vector3[] verts
+            , int nv
+            , [In] int[] tris
+            , [In] byte[] areas
+            , int nt
+            , IntPtr markers
+            , int markerCount
+            , [In] int[] walkableRadii
+            , int profileCount
+            , [In] int[] tiles
+            , int tileCount
+            , int threadCount
+            , [In, Out] PolyMeshEx[] polyMeshes
+            , IntPtr detailMeshes
+            , [In, Out] int[] maxVerts
+            , [In, Out] byte[] results);
+
+        /// <summary>
+        /// Gets a content key for each tile's build inputs.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// The arguments match <see cref="nmgBuildTiles"/>, plus the off-mesh connections
+        /// that go into the tile data.  Each key is four words.  [Length: 4 * tileCount]
+        /// </para>
+        /// <para>
+        /// The salt covers everything else that changes the tile data, such as the
+        /// processors, polygon flags and the bounding volume setting.
+        /// </para>
+        /// </remarks>
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern bool nmgHashTiles(IntPtr ctx
+            , IntPtr config
+            , ContourBuildFlags contourFlags
+            , byte buildFlags
+            , [In] Vector3[] verts
+            , int nv
+            , [In] int[] tris
+            , [In] byte[] areas
+            , int nt
+            , IntPtr markers
+            , int markerCount
+            , [In] Vector3[] connVerts
+            , [In] float[] connRadii
+            , [In] byte[] connDirs
+            , [In] byte[] connAreas
+            , [In] ushort[] connFlags
+            , [In] uint[] connUserIds
+            , int connCount
+            , uint salt
+            , [In] int[] tiles
+            , int tileCount
+            , int threadCount
+            , [In, Out] uint[] keys);
+
+        /// <summary>
+        /// Stores tile data in the directory under its key.  (Four words.)
+        /// </summary>
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern bool nmgStoreTileData(string directory
+            , [In] uint[] key
+            , [In] byte[] data
+            , int dataSize);
+
+        /// <summary>
+        /// Loads the tile data stored under the key.  Returns false on a miss.
+        /// </summary>
+        /// <remarks>
+        /// The data must be freed with <see cref="nmgFreeSerializationData"/>.
+        /// </remarks>
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern bool nmgLoadTileData(string directory
+            , [In] uint[] key
+            , ref IntPtr data
+            , ref int dataSize);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern IntPtr nmgAllocTileCache();
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void nmgFreeTileCache(IntPtr cache);
+
+        /// <summary>
+        /// Gets the cached tiles touched by the markers.  (Pass both the old and new state
+        /// of the changed markers.)
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// Returns the total number of dirty tiles.  Only the first <paramref name="maxTiles"/>
+        /// are loaded, so a result greater than <paramref name="maxTiles"/> means the buffer
+        /// was too small.
+        /// </para>
+        /// </remarks>
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern int nmgGetDirtyTiles(IntPtr cache
+            , IntPtr markers
+            , int markerCount
+            , [In, Out] int[] tiles
+            , int maxTiles);
+
+        /// <summary>
+        /// Rebuilds tiles from their cached compact heightfields using the full marker set.
+        /// </summary>
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern bool nmgRebuildTiles(IntPtr ctx
+            , IntPtr cache
+            , IntPtr markers
+            , int markerCount
+            , [In] int[] tiles
+            , int tileCount
+            , int threadCount
+            , [In, Out] PolyMeshEx[] polyMeshes
+            , IntPtr detailMeshes
+            , [In, Out] int[] maxVerts
+            , [In, Out] byte[] results);
     }
 }
@@ -29,6 +29,31 @@ enum dtAllocHint
 	DT_ALLOC_TEMP		///< Memory used temporarily within a function.
 };
 
+/// Identifies the subsystem that owns an allocation.  Used for memory accounting.
+/// @see dtGetAllocStats
+enum dtAllocTag
+{
+	DT_ALLOC_TAG_GENERAL,		///< Untagged memory.
+	DT_ALLOC_TAG_NAVMESH,		///< Navigation mesh tile tables, lookups and per-tile grids.
+	DT_ALLOC_TAG_TILE_DATA,		///< Navigation mesh tile data.
+	DT_ALLOC_TAG_QUERY,			///< Navigation mesh queries and their node pools.
+	DT_ALLOC_TAG_CROWD,			///< Crowds, corridors, avoidance and proximity data.
+	DT_ALLOC_TAG_PATH_QUEUE,	///< Path queues, schedulers and path caches.
+	DT_ALLOC_TAG_TILE_CACHE,	///< Tile caches and compressed tiles.
+	DT_ALLOC_TAG_CLUSTERS,		///< Cluster graphs.
+	DT_MAX_ALLOC_TAGS			///< The number of tags.
+};
+
+/// The memory accounting of a tag.
+/// @see dtGetAllocStats
+struct dtAllocStats
+{
+	size_t liveBytes;		///< The bytes currently allocated.
+	size_t peakBytes;		///< The most bytes that were allocated at one time.
+	size_t liveBlocks;		///< The number of blocks currently allocated.
+	size_t totalBlocks;		///< The number of blocks allocated since startup.
+};
+
 /// A memory allocation function.
 //  @param[in]		size			The size, in bytes of memory, to allocate.
 //  @param[in]		rcAllocHint	A hint to the allocator on how long the memory is expected to be in use.
@@ -53,9 +78,27 @@ void dtAllocSetCustom(dtAllocFunc *allocFunc, dtFreeFunc *freeFunc);
 /// @see dtFree
 void* dtAlloc(size_t size, dtAllocHint hint);
 
+/// Allocates a memory block owned by a subsystem.
+///  @param[in]		size	The size, in bytes of memory, to allocate.
+///  @param[in]		hint	A hint to the allocator on how long the memory is expected to be in use.
+///  @param[in]		tag		The subsystem the memory is accounted to.
+///  @return A pointer to the beginning of the allocated memory block, or null if the allocation failed.
+/// @see dtFree, dtGetAllocStats
+void* dtAlloc(size_t size, dtAllocHint hint, dtAllocTag tag);
+
 /// Deallocates a memory block.
 ///  @param[in]		ptr		A pointer to a memory block previously allocated using #dtAlloc.
 /// @see dtAlloc
 void dtFree(void* ptr);
 
+/// Gets the size of a memory block.
+///  @param[in]		ptr		A pointer to a memory block allocated using #dtAlloc, or null.
+///  @return The size requested for the block, or zero if @p ptr is null.
+size_t dtAllocSize(const void* ptr);
+
+/// Gets the memory accounting of a subsystem.
+///  @param[in]		tag		The subsystem.
+///  @param[out]	stats	The accounting of the subsystem.
+void dtGetAllocStats(dtAllocTag tag, dtAllocStats* stats);
+
 #endif
@@ -393,6 +393,24 @@ bool dtPointInPolygon(const float* pt, const float* verts, const int nverts);
 bool dtDistancePtPolyEdgesSqr(const float* pt, const float* verts, const int nverts,
 							float* ed, float* et);
 
+/// Derives the distances from a point to several polygons on the xz-plane.
+/// The results match those of dtDistancePtPolyEdgesSqr() for each polygon.
+///  @param[in]		pt			The point. [(x, y, z)]
+///  @param[in]		verts		The polygon vertices, @p maxVerts per polygon.
+///								[(x, y, z) * @p maxVerts * @p npolys]
+///  @param[in]		nverts		The number of vertices of each polygon. [Size: @p npolys] [Limit: >= 3]
+///  @param[in]		npolys		The number of polygons.
+///  @param[in]		maxVerts	The number of vertices reserved for each polygon in @p verts.
+///  @param[out]	distSqr		The squared distance to the nearest edge of each polygon,
+///								or zero if the point is inside the polygon. [Size: @p npolys]
+///  @param[out]	edges		The index of the nearest edge of each polygon, or -1 if
+///								the point is inside the polygon. [Size: @p npolys]
+///  @param[out]	edgeT		The position of the nearest point along the nearest edge
+///								of each polygon. [Size: @p npolys] [Limits: 0 <= value <= 1]
+void dtDistancePtPolysSqr2D(const float* pt, const float* verts, const int* nverts,
+							const int npolys, const int maxVerts,
+							float* distSqr, int* edges, float* edgeT);
+
 float dtDistancePtSegSqr2D(const float* pt, const float* p, const float* q, float& t);
 
 /// Derives the centroid of a convex polygon.
@@ -0,0 +1,208 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifndef DETOURFLOWFIELD_H
+#define DETOURFLOWFIELD_H
+
+#include "DetourNavMesh.h"
+#include "DetourNavMeshQuery.h"
+
+/// Build and hit counters for a #dtFlowFieldCache.
+struct dtFlowFieldCacheStats
+{
+	int fieldCount;					///< The number of cached fields.
+	int maxFields;					///< The maximum number of cached fields.
+	unsigned int hitCount;			///< Lookups that returned a cached field.
+	unsigned int buildCount;		///< Fields built on a lookup miss.
+	unsigned int invalidCount;		///< Cached fields discarded because the mesh changed under them.
+	unsigned int evictCount;		///< Cached fields discarded to make room for new ones.
+};
+
+/// The next polygon towards a goal, and the cost to reach it, for the polygons around the goal.
+/// Fields are built by, and owned by, a #dtFlowFieldCache.
+/// @see dtNavMeshQuery::findFlowField
+/// @ingroup detour
+class dtFlowField
+{
+public:
+	/// Gets the next polygon towards the goal.
+	///  @param[in]		ref		The reference of the polygon.
+	///  @param[out]	next	The next polygon, or zero if @p ref is the goal. [opt]
+	///  @param[out]	cost	The cost to reach the goal. [opt]
+	/// @return True if the polygon is in the field.
+	bool getNext(dtPolyRef ref, dtPolyRef* next, float* cost) const;
+
+	/// Follows the field from a polygon to the goal.
+	///  @param[in]		startRef	The reference of the start polygon.
+	///  @param[out]	path		The path, from the start to the goal polygon. [(polyRef) * @p pathCount]
+	///  @param[out]	pathCount	The number of polygons in the path.
+	///  @param[in]		maxPath		The maximum number of polygons the path array can hold. [Limit: >= 1]
+	/// @return The status flags for the operation. Fails if the start polygon is not in the field.
+	dtStatus getPath(dtPolyRef startRef, dtPolyRef* path, int* pathCount, const int maxPath) const;
+
+	/// The reference of the goal polygon.
+	inline dtPolyRef getGoalRef() const { return m_goalRef; }
+
+	/// The goal position the field was built with. [(x, y, z)]
+	inline const float* getGoalPos() const { return m_goalPos; }
+
+	/// The number of polygons in the field.
+	inline int getPolyCount() const { return m_polyCount; }
+
+private:
+	friend class dtFlowFieldCache;
+
+	dtFlowField();
+
+	// Explicitly disabled copy constructor and copy assignment operator.
+	dtFlowField(const dtFlowField&);
+	dtFlowField& operator=(const dtFlowField&);
+
+	int findPoly(dtPolyRef ref) const;
+
+	dtPolyRef m_goalRef;			///< Zero if the field is unused.
+	float m_goalPos[3];
+	unsigned int m_filterHash;
+	unsigned int m_lastUsed;
+
+	dtPolyRef* m_polys;				///< In order of cost. [(polyRef) * m_polyCount]
+	dtPolyRef* m_next;				///< [(polyRef) * m_polyCount]
+	float* m_costs;					///< [(cost) * m_polyCount]
+	int m_polyCount;
+
+	int* m_lookup;					///< Open addressing. [(index) * (m_lookupMask + 1)]
+	int m_lookupMask;
+
+	dtTileRef* m_tiles;				///< The tiles the field covers. [(tileRef) * m_tileCount]
+	int m_tileCount;
+	int m_tileMin[2];				///< The tile bounds. [(x, y)]
+	int m_tileMax[2];
+};
+
+/// A least recently used cache of flow fields, keyed by goal polygon and filter.
+/// @ingroup detour
+class dtFlowFieldCache
+{
+public:
+	dtFlowFieldCache();
+	~dtFlowFieldCache();
+
+	/// Initializes the cache.
+	///  @param[in]		nav			The navigation mesh the fields belong to.
+	///  @param[in]		maxFields	The maximum number of cached fields. [Limit: >= 1]
+	///  @param[in]		maxPolys	The maximum number of polygons in a field. [Limits: 0 < value <= 65535, or 16777215 with #DT_NODE_INDEX32]
+	///  @param[in]		radius		The search radius around the goal.
+	/// @return The status flags for the operation.
+	dtStatus init(const dtNavMesh* nav, const int maxFields, const int maxPolys, const float radius);
+
+	/// Gets the field for the goal, building it if it is not cached, or no longer valid.
+	/// The field remains valid until the next call to a non-const method of the cache.
+	///  @param[in]		goalRef		The reference of the goal polygon.
+	///  @param[in]		goalPos		The goal position. Only used if the field is built. [(x, y, z)]
+	///  @param[in]		filter		The filter to apply to the search.
+	///  @param[out]	field		The field.
+	/// @return The status flags for the operation.
+	dtStatus getField(dtPolyRef goalRef, const float* goalPos, const dtQueryFilter* filter,
+					  const dtFlowField** field);
+
+	/// Discards every field that covers, or borders, the tile.
+	void invalidateTile(const int tx, const int ty);
+
+	/// Discards every field that contains the polygon.
+	void invalidatePoly(dtPolyRef ref);
+
+	/// Discards all cached fields.
+	void clear();
+
+	/// Gets the cache statistics.
+	void getStats(dtFlowFieldCacheStats* stats) const;
+
+	/// Resets the hit and build counters.
+	void resetStats();
+
+	/// The maximum number of polygons in a field.
+	inline int getMaxPolys() const { return m_maxPolys; }
+
+	/// The search radius around the goal.
+	inline float getRadius() const { return m_radius; }
+
+	/// Gets the memory used by the cache and its navigation query, in bytes.
+	int getMemUsed() const;
+
+private:
+	// Explicitly disabled copy constructor and copy assignment operator.
+	dtFlowFieldCache(const dtFlowFieldCache&);
+	dtFlowFieldCache& operator=(const dtFlowFieldCache&);
+
+	void purge();
+	bool validate(const dtFlowField& field) const;
+	void removeField(dtFlowField& field);
+	dtStatus buildField(dtFlowField& field, dtPolyRef goalRef, const float* goalPos,
+						const dtQueryFilter* filter, unsigned int filterHash);
+
+	const dtNavMesh* m_nav;
+	dtNavMeshQuery* m_query;
+
+	dtFlowField* m_fields;
+	int m_maxFields;
+	int m_maxPolys;
+	float m_radius;
+	int m_fieldCount;
+
+	unsigned int* m_tileStamps;		///< Used to collect the tiles of a field. [(stamp) * maxTiles]
+	unsigned int m_tick;
+
+	unsigned int m_hitCount;
+	unsigned int m_buildCount;
+	unsigned int m_invalidCount;
+	unsigned int m_evictCount;
+};
+
+dtFlowFieldCache* dtAllocFlowFieldCache();
+void dtFreeFlowFieldCache(dtFlowFieldCache* cache);
+
+#endif // DETOURFLOWFIELD_H
+
+///////////////////////////////////////////////////////////////////////////
+
+// This section contains detailed documentation for members that don't have
+// a source file. It reduces clutter in the main section of the header.
+
+/**
+
+@class dtFlowFieldCache
+@par
+
+When many agents share a goal, a single reverse Dijkstra search from the goal
+(#dtNavMeshQuery::findFlowField) gives each of them a path, so the agents
+don't need individual path requests.  Following the next polygon from an
+agent's polygon leads to the goal. (See: #dtFlowField::getPath)
+
+Fields are keyed by the goal polygon and a hash of the filter
+(#dtPathCache::hashFilter).  The goal position is not part of the key, so a
+field is built for the first goal position requested in the polygon.
+
+#getField discards a field if any tile it covers has been removed or
+replaced.  (The tile salt changes.)  The cache can't see other changes, so
+call #invalidateTile when a tile is added next to a field, and
+#invalidatePoly (or #invalidateTile) when polygon flags or areas change.
+
+Each field uses the cache's own query object, so the fields are not limited
+by the node pool of the callers.  The cache is not thread safe.
+
+*/
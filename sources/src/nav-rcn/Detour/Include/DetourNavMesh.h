@@ -23,8 +23,11 @@
 #include "DetourStatus.h"
 
 // Undefine (or define in a build cofnig) the following line to use 64bit polyref.
-// Generally not needed, useful for very large worlds.
+// Generally not needed, useful for very large worlds.  (The 64bit layout 
+// allows 2^28 tiles of up to 2^20 polygons each.)
 // Note: tiles build using 32bit refs are not compatible with 64bit refs!
+// The serialization versions differ between the two builds, so mixed data 
+// is rejected on load. (See: DT_POLYREF_VERSION_FLAG)
 //#define DT_POLYREF64 1
 
 #ifdef DT_POLYREF64
@@ -69,14 +72,31 @@ static const int DT_VERTS_PER_POLYGON = 6;
 /// A magic number used to detect compatibility of navigation tile data.
 static const int DT_NAVMESH_MAGIC = 'D'<<24 | 'N'<<16 | 'A'<<8 | 'V';
 
+/// Set in the serialization versions of builds that use 64-bit references.
+/// The layout of tile data and tile states depends on the size of #dtPolyRef.
+#ifdef DT_POLYREF64
+static const int DT_POLYREF_VERSION_FLAG = 0x200;
+#else
+static const int DT_POLYREF_VERSION_FLAG = 0;
+#endif
+
 /// A version number used to detect compatibility of navigation tile data.
-static const int DT_NAVMESH_VERSION = 7;
+static const int DT_NAVMESH_VERSION = DT_POLYREF_VERSION_FLAG | 7;
+
+/// The version number of compact navigation tile data, which stores the
+/// detail mesh vertices quantized to 16 bits. (See: dtNavMeshCreateParams::compactDetail)
+static const int DT_NAVMESH_COMPACT_VERSION = 0x100 | DT_NAVMESH_VERSION;
+
+/// Marks a compact detail vertex which lies on an edge of its polygon.
+/// The vertex is stored as a position along the edge, so that it decodes exactly on it.
+/// (See: dtGetDetailVerts)
+static const unsigned short DT_DETAIL_QUANT_EDGE = 0x8000;
 
 /// A magic number used to detect the compatibility of navigation tile states.
 static const int DT_NAVMESH_STATE_MAGIC = 'D'<<24 | 'N'<<16 | 'M'<<8 | 'S';
 
 /// A version number used to detect compatibility of navigation tile states.
-static const int DT_NAVMESH_STATE_VERSION = 1;
+static const int DT_NAVMESH_STATE_VERSION = DT_POLYREF_VERSION_FLAG | 1;
 
 /// @}
 
@@ -100,6 +120,19 @@ enum dtTileFlags
 {
 	/// The navigation mesh owns the tile memory and is responsible for freeing it.
 	DT_TILE_FREE_DATA = 0x01,
+
+	/// The tile data is read-only and may be shared with other navigation meshes.
+	/// The mesh keeps its own copy of the state it modifies. (Polygons and links.)
+	DT_TILE_SHARED_DATA = 0x02,
+
+	/// Set by the mesh on a removed tile whose memory may still be in use by a
+	/// concurrent read. (See: dtNavMesh::beginRead) The tile is no longer part of the mesh.
+	DT_TILE_RETIRED = 0x04,
+
+	/// The tile data belongs to the caller. (E.g. It is used in place in a serialized
+	/// mesh or a mapped file.)  The mesh does not free it, and neither may the code that 
+	/// removes the tile.
+	DT_TILE_EXTERNAL_DATA = 0x08,
 };
 
 /// Vertex flags returned by dtNavMeshQuery::findStraightPath.
@@ -122,6 +155,7 @@ enum dtStraightPathOptions
 enum dtFindPathOptions
 {
 	DT_FINDPATH_ANY_ANGLE	= 0x02,		///< use raycasts during pathfind to "shortcut" (raycast still consider costs)
+	DT_FINDPATH_BIDIRECTIONAL = 0x04,	///< search from both the start and the end and meet in the middle (ignores DT_FINDPATH_ANY_ANGLE)
 };
 
 /// Options for dtNavMeshQuery::raycast
@@ -130,6 +164,12 @@ enum dtRaycastOptions
 	DT_RAYCAST_USE_COSTS = 0x01,		///< Raycast should calculate movement cost along the ray and fill RaycastHit::cost
 };
 
+/// Options for dtNavMeshQuery::findNearestPoly
+enum dtFindNearestPolyOptions
+{
+	DT_NEARESTPOLY_GRID = 0x01,		///< visit polygons nearest first using the tile polygon grids (see dtNavMesh::setPolyGridsEnabled)
+};
+
 
 /// Limit raycasting during any angle pahfinding
 /// The limit is given as a multiple of the character radius
@@ -271,12 +311,116 @@ struct dtMeshHeader
 	float bvQuantFactor;
 };
 
+/// A portal edge in a tile's border edge index.
+/// @see dtMeshTile::borderEdges
+/// @ingroup detour
+struct dtBorderEdge
+{
+	float bmin[2];			///< The start of the edge. [(position along the border, height)]
+	float bmax[2];			///< The end of the edge. [(position along the border, height)]
+	float pos;				///< The position of the edge across the border.
+	float reach;			///< The largest bmax[0] of this and all preceding edges on the same side.
+	unsigned int poly;		///< The index of the polygon within the tile.
+	unsigned char edge;		///< The index of the polygon edge.
+	unsigned char side;		///< The side of the tile the edge lies on.
+};
+
+/// A polygon in a tile's polygon grid.
+/// @see dtPolyGrid
+/// @ingroup detour
+struct dtPolyGridItem
+{
+	float bmin[3];				///< The minimum bounds of the polygon's geometry, padded for rounding. [(x, y, z)]
+	float bmax[3];				///< The maximum bounds of the polygon's geometry, padded for rounding. [(x, y, z)]
+
+	/// The index of the polygon's bounding volume node, or the index of the polygon
+	/// if the tile has no bounding volume tree.
+	int index;
+
+	unsigned short cmin[2];		///< The first cell covered by the item. [(x, z)]
+	unsigned short cmax[2];		///< The last cell covered by the item. [(x, z)]
+};
+
+/// A uniform grid over the polygons of a tile, used to visit the polygons 
+/// nearest to a point first.
+/// @see dtNavMesh::setPolyGridsEnabled, dtMeshTile::polyGrid
+/// @ingroup detour
+struct dtPolyGrid
+{
+	float bmin[3];				///< The minimum bounds of all items. [(x, y, z)]
+	float bmax[3];				///< The maximum bounds of all items. [(x, y, z)]
+	float orig[2];				///< The origin of the grid. [(x, z)]
+	float cellSize;				///< The width and depth of a cell.
+	int width;					///< The number of cells along the x-axis.
+	int height;					///< The number of cells along the z-axis.
+	int itemCount;				///< The number of items.
+	dtPolyGridItem* items;		///< The grid items. [Size: #itemCount]
+	int* cellStart;				///< The index of the first entry of each cell in #cellItems. [Size: #width * #height + 1]
+	int* cellItems;				///< The indices of the items covering each cell.
+};
+
+/// Gets the grid cell that contains the specified position, clamped to the grid.
+///  @param[in]		grid	The polygon grid.
+///  @param[in]		pos		The position. [(x, y, z)]
+///  @param[out]	cx		The cell's x-index.
+///  @param[out]	cz		The cell's z-index.
+/// @ingroup detour
+inline void dtCalcPolyGridCell(const dtPolyGrid* grid, const float* pos, int& cx, int& cz)
+{
+	const float fx = (pos[0] - grid->orig[0]) / grid->cellSize;
+	const float fz = (pos[2] - grid->orig[1]) / grid->cellSize;
+	cx = fx <= 0 ? 0 : (fx >= (float)grid->width ? grid->width-1 : (int)fx);
+	cz = fz <= 0 ? 0 : (fz >= (float)grid->height ? grid->height-1 : (int)fz);
+}
+
+/// The height grid of a polygon's detail mesh. The grid cells list the detail 
+/// triangles that overlap them.
+/// @see dtHeightGrid
+/// @ingroup detour
+struct dtPolyHeightGrid
+{
+	float orig[2];				///< The origin of the grid. [(x, z)]
+	float cellSize;				///< The width and depth of a cell.
+	unsigned char width;		///< The number of cells along the x-axis. (Zero if the polygon has no grid.)
+	unsigned char height;		///< The number of cells along the z-axis.
+	int cellBase;				///< The index of the polygon's first cell in dtHeightGrid::cellStart.
+};
+
+/// The detail mesh height grids of a tile's polygons.
+/// @see dtNavMesh::setHeightGridsEnabled, dtMeshTile::heightGrid
+/// @ingroup detour
+struct dtHeightGrid
+{
+	dtPolyHeightGrid* polys;	///< The polygon grids. [Size: dtMeshHeader::detailMeshCount]
+	int* cellStart;				///< The index of the first entry of each cell in #cellTris.
+	unsigned char* cellTris;	///< The detail triangles of each cell, relative to dtPolyDetail::triBase.
+};
+
+/// Gets the cell of a polygon height grid that contains the specified position, 
+/// clamped to the grid.
+///  @param[in]		grid	The polygon height grid.
+///  @param[in]		pos		The position. [(x, y, z)]
+///  @param[out]	cx		The cell's x-index.
+///  @param[out]	cz		The cell's z-index.
+/// @ingroup detour
+inline void dtCalcHeightGridCell(const dtPolyHeightGrid* grid, const float* pos, int& cx, int& cz)
+{
+	const float fx = (pos[0] - grid->orig[0]) / grid->cellSize;
+	const float fz = (pos[2] - grid->orig[1]) / grid->cellSize;
+	cx = fx <= 0 ? 0 : (fx >= (float)grid->width ? grid->width-1 : (int)fx);
+	cz = fz <= 0 ? 0 : (fz >= (float)grid->height ? grid->height-1 : (int)fz);
+}
+
 /// Defines a navigation mesh tile.
 /// @ingroup detour
 struct dtMeshTile
 {
 	unsigned int salt;					///< Counter describing modifications to the tile.
 
+	/// The navigation mesh version of the last change to the tile's polygons or links.
+	/// Kept when the tile is removed, so it also covers slot reuse. (See: dtNavMesh::getVersion)
+	unsigned int version;
+
 	unsigned int linksFreeList;			///< Index to the next free link.
 	dtMeshHeader* header;				///< The tile header.
 	dtPoly* polys;						///< The tile polygons. [Size: dtMeshHeader::polyCount]
@@ -285,8 +429,16 @@ struct dtMeshTile
 	dtPolyDetail* detailMeshes;			///< The tile's detail sub-meshes. [Size: dtMeshHeader::detailMeshCount]
 	
 	/// The detail mesh's unique vertices. [(x, y, z) * dtMeshHeader::detailVertCount]
+	/// (Will be null for compact tiles. See #detailQuantVerts.)
 	float* detailVerts;	
 
+	/// The detail mesh's unique vertices of a compact tile, quantized to the detail bounds.
+	/// [(x, y, z) * dtMeshHeader::detailVertCount] (Will be null if the tile is not compact.)
+	unsigned short* detailQuantVerts;
+
+	/// The values used to decode #detailQuantVerts. [(origin x, y, z), (step x, y, z)]
+	const float* detailQuantParams;
+
 	/// The detail mesh's triangles. [(vertA, vertB, vertC) * dtMeshHeader::detailTriCount]
 	unsigned char* detailTris;	
 
@@ -295,7 +447,26 @@ struct dtMeshTile
 	dtBVNode* bvTree;
 
 	dtOffMeshConnection* offMeshCons;		///< The tile off-mesh connections. [Size: dtMeshHeader::offMeshConCount]
-		
+
+	/// The tile's portal edges, grouped by side and sorted along the border.
+	/// [Size: borderEdgeStart[8]] (Will be null if the tile has no portal edges.)
+	dtBorderEdge* borderEdges;
+	int borderEdgeStart[9];					///< The index of the first edge of each side in #borderEdges.
+
+	/// The indices of the tile's off-mesh connections, grouped by the side of the tile their
+	/// end point lands on (0-7), then those that land inside the tile, in connection order.
+	/// [Size: offMeshConStart[9]] (Will be null if the tile has no off-mesh connections.)
+	unsigned short* offMeshConIndex;
+	int offMeshConStart[10];				///< The index of the first connection of each side in #offMeshConIndex.
+
+	/// The tile's polygon grid. (Will be null unless polygon grids are enabled for the
+	/// navigation mesh, or if the tile has no ground polygons.)
+	dtPolyGrid* polyGrid;
+
+	/// The tile's detail mesh height grids. (Will be null unless height grids are enabled
+	/// for the navigation mesh.)
+	dtHeightGrid* heightGrid;
+
 	unsigned char* data;					///< The tile data. (Not directly accessed under normal situations.)
 	int dataSize;							///< Size of the tile data.
 	int flags;								///< Tile flags. (See: #dtTileFlags)
@@ -305,6 +476,82 @@ private:
 	dtMeshTile& operator=(const dtMeshTile&);
 };
 
+/// The maximum number of unique vertices in a polygon's detail mesh.
+/// @ingroup detour
+static const int DT_MAX_DETAIL_VERTS = 255;
+
+/// Decodes a unique vertex of a compact tile's detail mesh.
+///  @param[in]		tile	The compact tile containing the polygon.
+///  @param[in]		poly	The polygon.
+///  @param[in]		q		The quantized vertex. (See: dtMeshTile::detailQuantVerts)
+///  @param[out]	v		The vertex. [(x, y, z)]
+/// @ingroup detour
+inline void dtDecodeDetailVert(const dtMeshTile* tile, const dtPoly* poly,
+							   const unsigned short* q, float* v)
+{
+	const float* qp = tile->detailQuantParams;
+	if (q[2] & DT_DETAIL_QUANT_EDGE)
+	{
+		// Position along the polygon edge stored in the upper bits.
+		const int e = (q[2] >> 12) & 0x7;
+		const float* va = &tile->verts[poly->verts[e]*3];
+		const float* vb = &tile->verts[poly->verts[(e+1) % poly->vertCount]*3];
+		const float t = q[0] * (1.0f/65535.0f);
+		v[0] = va[0] + (vb[0]-va[0])*t;
+		v[2] = va[2] + (vb[2]-va[2])*t;
+	}
+	else
+	{
+		v[0] = qp[0] + q[0]*qp[3];
+		v[2] = qp[2] + q[2]*qp[5];
+	}
+	v[1] = qp[1] + q[1]*qp[4];
+}
+
+/// Gets the unique vertices of a polygon's detail mesh.
+///  @param[in]		tile	The tile containing the polygon.
+///  @param[in]		poly	The polygon.
+///  @param[in]		pd		The polygon's detail mesh.
+///  @param[out]	buf		Storage for the decoded vertices of a compact tile. 
+///  						[(x, y, z) * #DT_MAX_DETAIL_VERTS]
+/// @return The vertices, which are either in the tile data or @p buf. [(x, y, z) * dtPolyDetail::vertCount]
+/// @ingroup detour
+inline const float* dtGetDetailVerts(const dtMeshTile* tile, const dtPoly* poly,
+									 const dtPolyDetail* pd, float* buf)
+{
+	if (tile->detailVerts)
+		return &tile->detailVerts[pd->vertBase*3];
+	for (int i = 0; i < pd->vertCount; ++i)
+		dtDecodeDetailVert(tile, poly, &tile->detailQuantVerts[(pd->vertBase+i)*3], &buf[i*3]);
+	return buf;
+}
+
+/// Gets the height of the detail mesh of a polygon at the specified position.
+/// Uses the tile's height grid if it has one. (See: dtNavMesh::setHeightGridsEnabled)
+///  @param[in]		tile	The tile containing the polygon.
+///  @param[in]		poly	The polygon. (Must be a ground polygon.)
+///  @param[in]		pos		The position. [(x, y, z)]
+///  @param[out]	height	The height of the detail mesh at the position.
+/// @return True if the position is over the detail mesh.
+/// @ingroup detour
+bool dtGetDetailHeight(const dtMeshTile* tile, const dtPoly* poly, const float* pos, float* height);
+
+/// Finds the nearest of several polygons of a tile, measured the way dtNavMeshQuery::findNearestPoly()
+/// measures them.  A polygon only replaces the nearest one if it is nearer, so the first of
+/// equally near polygons is kept.
+///  @param[in]		tile			The tile containing the polygons.
+///  @param[in]		polys			The polygons. [Size: @p count]
+///  @param[in]		count			The number of polygons.
+///  @param[in]		center			The point to measure from. [(x, y, z)]
+///  @param[in,out]	nearestDistSqr	The distance to beat. Updated with the distance of the nearest
+///									polygon found.
+///  @param[out]	nearestPt		The nearest point on the nearest polygon found. [(x, y, z)]
+/// @return The index of the nearest polygon in @p polys, or -1 if none is nearer than the
+/// original @p nearestDistSqr.
+/// @ingroup detour
+int dtFindNearestPolyInList(const dtMeshTile* tile, const dtPoly* const* polys, const int count,
+							const float* center, float* nearestDistSqr, float* nearestPt);
+
 /// Configuration parameters used to define multi-tile navigation meshes.
 /// The values are used to allocate space during the initialization of a navigation mesh.
 /// @see dtNavMesh::init()
@@ -318,6 +565,23 @@ struct dtNavMeshParams
 	int maxPolys;					///< The maximum number of polygons each tile can contain.
 };
 
+/// The native memory used by a navigation mesh, in bytes.
+/// @see dtNavMesh::getMemoryStats
+/// @ingroup detour
+struct dtNavMeshMemoryStats
+{
+	size_t meshBytes;				///< The mesh object, the tile table and the tile lookup.
+	size_t tileDataBytes;			///< The tile data owned by the mesh. (#DT_TILE_FREE_DATA)
+	size_t externalTileDataBytes;	///< The tile data owned by the caller or shared with other meshes.
+	size_t tileCopyBytes;			///< The per-mesh copies of shared tile data and the tile border edges.
+	size_t gridBytes;				///< The polygon and height grids.
+	int tileCount;					///< The number of tiles in the mesh.
+};
+
+struct dtNavMeshReader;
+struct dtRetiredTile;
+struct dtRetiredLink;
+
 /// A navigation mesh based on tiles of convex polygons.
 /// @ingroup detour
 class dtNavMesh
@@ -361,6 +625,67 @@ public:
 	/// @return The status flags for the operation.
 	dtStatus removeTile(dtTileRef ref, unsigned char** data, int* dataSize);
 
+	/// Enables or disables the per-tile polygon grids used by #DT_NEARESTPOLY_GRID queries.
+	/// Enabling builds the grids of the tiles already in the mesh. Tiles added later get
+	/// their grid when they are added.
+	///  @param[in]	enabled	True if the tiles should have polygon grids.
+	/// @return The status flags for the operation.
+	dtStatus setPolyGridsEnabled(bool enabled);
+
+	/// True if the tiles have polygon grids. (See: #setPolyGridsEnabled)
+	bool getPolyGridsEnabled() const { return m_polyGrids; }
+
+	/// Enables or disables the per-tile detail mesh height grids used by height queries.
+	/// Enabling builds the grids of the tiles already in the mesh. Tiles added later get
+	/// their grid when they are added.
+	///  @param[in]	enabled	True if the tiles should have height grids.
+	/// @return The status flags for the operation.
+	dtStatus setHeightGridsEnabled(bool enabled);
+
+	/// True if the tiles have height grids. (See: #setHeightGridsEnabled)
+	bool getHeightGridsEnabled() const { return m_heightGrids; }
+
+	/// Gets the native memory used by the mesh.
+	///  @param[out]	stats	The memory use of the mesh.
+	void getMemoryStats(dtNavMeshMemoryStats* stats) const;
+
+	/// @}
+
+	/// @{
+	/// @name Concurrent Reads
+
+	/// Enables tile changes while reads run on other threads.
+	///  @param[in]	maxReaders	The number of reader slots. [Limit: > 0]
+	/// @return The status flags for the operation.
+	dtStatus initConcurrentReads(const int maxReaders);
+
+	/// True if concurrent reads are enabled. (See: #initConcurrentReads)
+	bool getConcurrentReadsEnabled() const { return m_readers != 0; }
+
+	/// Acquires a reader slot.
+	/// @return The reader slot, or -1 if concurrent reads are disabled or all slots are in use.
+	int acquireReader() const;
+
+	/// Releases a reader slot acquired using #acquireReader.
+	///  @param[in]	reader	The reader slot.
+	void releaseReader(const int reader) const;
+
+	/// Starts a read.  Tiles removed after this call keep their memory until the 
+	/// matching #endRead.
+	///  @param[in]	reader	The reader slot. (See: #acquireReader)
+	void beginRead(const int reader) const;
+
+	/// Ends a read started using #beginRead.
+	///  @param[in]	reader	The reader slot.
+	void endRead(const int reader) const;
+
+	/// Frees the memory of removed tiles that no read can still be using.
+	/// @return The number of removed tiles whose memory is still in use.
+	int reclaimRetired();
+
+	/// The number of removed tiles whose memory is still in use by reads.
+	int getRetiredTileCount() const { return m_retiredTileCount; }
+
 	/// @}
 
 	/// @{
@@ -432,6 +757,17 @@ public:
 	///  @param[in]	ref		The polygon reference to check.
 	/// @return True if polygon reference is valid for the navigation mesh.
 	bool isValidPolyRef(dtPolyRef ref) const;
+
+	/// The version of the most recent change to the navigation mesh. (Never zero.)
+	/// @return The version of the most recent change to the navigation mesh.
+	unsigned int getVersion() const { return m_version; }
+
+	/// Checks if the tile a polygon reference points to changed after the specified version.
+	///  @param[in]	ref			The polygon reference.
+	///  @param[in]	version		A version returned by #getVersion.
+	/// @return True if the tile was changed after the version, or if the reference does
+	/// 	not decode to a tile index.
+	bool hasTileChanged(dtPolyRef ref, unsigned int version) const;
 	
 	/// Gets the polygon reference for the tile's base polygon.
 	///  @param[in]	tile		The tile.
@@ -625,7 +961,9 @@ private:
 	void connectExtOffMeshLinks(dtMeshTile* tile, dtMeshTile* target, int side);
 	
 	/// Removes external links at specified side.
-	void unconnectLinks(dtMeshTile* tile, dtMeshTile* target);
+	void unconnectLinks(dtMeshTile* tile, dtMeshTile* target, int side);
+	/// Removes the polygon's links to the target tile.
+	void unconnectPolyLinks(dtMeshTile* tile, dtPoly* poly, const unsigned int targetNum);
 	
 
 	// TODO: These methods are duplicates from dtNavMeshQuery, but are needed for off-mesh connection finding.
@@ -638,6 +976,18 @@ private:
 									const float* halfExtents, float* nearestPt) const;
 	/// Returns closest point on polygon.
 	void closestPointOnPoly(dtPolyRef ref, const float* pos, float* closest, bool* posOverPoly) const;
+
+	/// Removes a link from its polygon, deferring its reuse if reads may be on it.
+	void retireLink(dtMeshTile* tile, unsigned int link);
+
+	/// Advances the mesh version and stamps the tile with it.
+	void markTileChanged(dtMeshTile* tile);
+
+	/// Frees the tile memory and returns the tile to the free list.
+	void releaseTile(dtMeshTile* tile);
+
+	/// True if no read that started before or in the epoch is still running.
+	bool isEpochReclaimable(const unsigned int epoch) const;
 	
 	dtNavMeshParams m_params;			///< Current initialization params. TODO: do not store this info twice.
 	float m_orig[3];					///< Origin of the tile (0,0)
@@ -649,6 +999,18 @@ private:
 	dtMeshTile** m_posLookup;			///< Tile hash lookup.
 	dtMeshTile* m_nextFree;				///< Freelist of tiles.
 	dtMeshTile* m_tiles;				///< List of tiles.
+	unsigned int m_version;				///< The version of the most recent change. (See: dtMeshTile::version)
+	bool m_polyGrids;					///< True if tiles get polygon grids.
+	bool m_heightGrids;					///< True if tiles get height grids.
+
+	dtNavMeshReader* m_readers;				///< Reader slots. [Size: #m_maxReaders] (Null if concurrent reads are disabled.)
+	int m_maxReaders;						///< Number of reader slots.
+	volatile unsigned int m_epoch;			///< The current epoch. Advanced each time memory is retired.
+	dtRetiredTile* m_retiredTiles;			///< Removed tiles still in use by reads. [Size: #m_maxTiles]
+	int m_retiredTileCount;					///< Number of retired tiles.
+	dtRetiredLink* m_retiredLinks;			///< Removed links still in use by reads. [Size: #m_retiredLinkCap]
+	int m_retiredLinkCount;					///< Number of retired links.
+	int m_retiredLinkCap;					///< Capacity of the retired link list.
 		
 #ifndef DT_POLYREF64
 	unsigned int m_saltBits;			///< Number of salt bits in the tile ID.
@@ -667,6 +1029,17 @@ dtNavMesh* dtAllocNavMesh();
 ///  @ingroup detour
 void dtFreeNavMesh(dtNavMesh* navmesh);
 
+/// Returns true if the version is a navigation tile data version supported by this build.
+///  @param[in]	version		The tile data version. (See: dtMeshHeader::version)
+///  @ingroup detour
+bool dtIsNavMeshVersion(const int version);
+
+/// Returns the size of the detail vertex section of navigation tile data.
+///  @param[in]	version			The tile data version. (See: dtMeshHeader::version)
+///  @param[in]	detailVertCount	The number of unique detail vertices.
+///  @ingroup detour
+int dtGetDetailVertsSize(const int version, const int detailVertCount);
+
 #endif // DETOURNAVMESH_H
 
 ///////////////////////////////////////////////////////////////////////////
@@ -21,6 +21,15 @@
 
 #include "DetourAlloc.h"
 
+/// The methods used to split the nodes of a tile's bounding volume tree.
+/// @ingroup detour
+/// @see dtNavMeshCreateParams::bvTreeSplit
+enum dtBVTreeSplit
+{
+	DT_BVTREE_SPLIT_MEDIAN = 0,		///< Split at the median along the longest axis of the node.
+	DT_BVTREE_SPLIT_SAH = 1,		///< Split using the surface area heuristic.
+};
+
 /// Represents the source data used to build an navigation mesh tile.
 /// @ingroup detour
 struct dtNavMeshCreateParams
@@ -101,6 +110,14 @@ struct dtNavMeshCreateParams
 	/// @note The BVTree is not normally needed for layered navigation meshes.
 	bool buildBvTree;
 
+	/// True if the detail mesh vertices should be stored in the compact 16-bit format.
+	/// @see DT_NAVMESH_COMPACT_VERSION
+	bool compactDetail;
+
+	/// The method used to split the bounding volume tree nodes. [Default: #DT_BVTREE_SPLIT_MEDIAN]
+	/// (See: #dtBVTreeSplit)
+	int bvTreeSplit;
+
 	/// @}
 };
 
@@ -145,5 +162,25 @@ function.
 
 @see dtCreateNavMeshData
 
+@var bool dtNavMeshCreateParams::compactDetail
+@par
+
+Compact tiles store each unique detail vertex in 6 bytes instead of 12. The vertices are 
+quantized to 1/65535 of the detail mesh bounds of the tile, so the error is well below a 
+millimeter for normal tile sizes.  The vertices are decoded when the height and closest 
+point queries read them, which makes those queries slightly slower.
+
+This is normally worth enabling for tiles built with a detail mesh, where the detail 
+vertices are usually the largest part of the tile data.  It has no effect on tiles without 
+unique detail vertices.
+
+@var int dtNavMeshCreateParams::bvTreeSplit
+@par
+
+Both methods build a tree with one polygon per leaf, so the tree size is the same.  The median 
+split builds faster and gives a balanced tree.  The surface area heuristic takes about three 
+times as long to build, but groups the polygons into tighter bounds, so polygon queries visit 
+fewer nodes.  It is most useful for tiles with many polygons of very different sizes.
+
 */
 
@@ -20,6 +20,7 @@
 #define DETOURNAVMESHQUERY_H
 
 #include "DetourNavMesh.h"
+#include "DetourCommon.h"
 #include "DetourStatus.h"
 
 
@@ -30,6 +31,14 @@
 
 //#define DT_VIRTUAL_QUERYFILTER 1
 
+// Define DT_QUERY_STATS if you wish dtNavMeshQuery to collect search statistics.
+// (See dtNavMeshQuery::getQueryStats.) The counters are updated in the inner
+// loops of the searches, so they are compiled out by default. When enabled, the
+// constant query functions also update the counters, so a query object must not
+// be shared between threads.
+
+//#define DT_QUERY_STATS 1
+
 /// Defines polygon filtering and traversal costs for navigation mesh query operations.
 /// @ingroup detour
 class dtQueryFilter
@@ -119,8 +128,63 @@ public:
 
 };
 
+#ifndef DT_VIRTUAL_QUERYFILTER
+// Defined here, rather than in the source file, so that code outside
+// the query can use the default filter.
+inline bool dtQueryFilter::passFilter(const dtPolyRef /*ref*/,
+									  const dtMeshTile* /*tile*/,
+									  const dtPoly* poly) const
+{
+	return (poly->flags & m_includeFlags) != 0 && (poly->flags & m_excludeFlags) == 0;
+}
+
+inline float dtQueryFilter::getCost(const float* pa, const float* pb,
+									const dtPolyRef /*prevRef*/, const dtMeshTile* /*prevTile*/, const dtPoly* /*prevPoly*/,
+									const dtPolyRef /*curRef*/, const dtMeshTile* /*curTile*/, const dtPoly* curPoly,
+									const dtPolyRef /*nextRef*/, const dtMeshTile* /*nextTile*/, const dtPoly* /*nextPoly*/) const
+{
+	return dtVdist(pa, pb) * m_areaCost[curPoly->getArea()];
+}
+#endif
+
 
 
+/// A polygon filter that only tests the include flags and uses the plain
+/// distance as the traversal cost.
+/// Never virtual, so the filter-specialized queries (e.g. dtNavMeshQuery::findPathT)
+/// can inline it regardless of #DT_VIRTUAL_QUERYFILTER.
+/// @ingroup detour
+class dtIncludeQueryFilter
+{
+	unsigned short m_includeFlags;		///< Flags for polygons that can be visited.
+
+public:
+	dtIncludeQueryFilter() : m_includeFlags(0xffff) {}
+	explicit dtIncludeQueryFilter(const unsigned short includeFlags) : m_includeFlags(includeFlags) {}
+
+	/// Returns true if the polygon has at least one of the include flags.
+	inline bool passFilter(const dtPolyRef /*ref*/, const dtMeshTile* /*tile*/, const dtPoly* poly) const
+	{
+		return (poly->flags & m_includeFlags) != 0;
+	}
+
+	/// Returns the distance between the two positions.
+	inline float getCost(const float* pa, const float* pb,
+						 const dtPolyRef /*prevRef*/, const dtMeshTile* /*prevTile*/, const dtPoly* /*prevPoly*/,
+						 const dtPolyRef /*curRef*/, const dtMeshTile* /*curTile*/, const dtPoly* /*curPoly*/,
+						 const dtPolyRef /*nextRef*/, const dtMeshTile* /*nextTile*/, const dtPoly* /*nextPoly*/) const
+	{
+		return dtVdist(pa, pb);
+	}
+
+	/// Returns the include flags for the filter.
+	inline unsigned short getIncludeFlags() const { return m_includeFlags; }
+
+	/// Sets the include flags for the filter.
+	/// @param[in]		flags	The new flags.
+	inline void setIncludeFlags(const unsigned short flags) { m_includeFlags = flags; }
+};
+
 /// Provides information about raycast hit
 /// filled by dtNavMeshQuery::raycast
 /// @ingroup detour
@@ -148,6 +212,46 @@ struct dtRaycastHit
 	float pathCost;
 };
 
+/// Provides a buffer of resolved path portals used by dtNavMeshQuery::findStraightPath.
+/// The buffers are owned by the caller.
+/// @ingroup detour
+struct dtPathPortals
+{
+	/// The left vertex of each portal. [(x, y, z) * @p maxPortals]
+	float* left;
+
+	/// The right vertex of each portal. [(x, y, z) * @p maxPortals]
+	float* right;
+
+	/// The type of the polygon each portal leads into. (See: #dtPolyTypes) [Size: @p maxPortals]
+	unsigned char* toTypes;
+
+	/// The path the portals were resolved for. [(polyRef) * (@p maxPortals + 1)]
+	dtPolyRef* refs;
+
+	/// The number of resolved portals. (Set to zero to discard the buffer contents.)
+	int count;
+
+	/// The maximum number of portals the buffers can hold.
+	int maxPortals;
+};
+
+/// Search statistics collected by dtNavMeshQuery when #DT_QUERY_STATS is defined.
+/// @see dtNavMeshQuery::getQueryStats
+/// @ingroup detour
+struct dtQueryStats
+{
+	int queryCount;				///< The number of queries.
+	int nodesExpanded;			///< The number of nodes taken from the open list.
+	int openListPushes;			///< The number of nodes added to the open list.
+	int openListModifies;		///< The number of open list nodes that were given a lower cost.
+	int tileCrossings;			///< The number of open list nodes added in a different tile than their parent.
+	int tilesQueried;			///< The number of tiles searched for polygons. (E.g. By findNearestPoly.)
+	int bvNodesVisited;			///< The number of bounding volume nodes visited while searching the tiles.
+	int outOfNodesCount;		///< The number of queries that ran out of nodes. (#DT_OUT_OF_NODES)
+	int partialResultCount;		///< The number of path queries with a partial result. (#DT_PARTIAL_RESULT)
+};
+
 /// Provides custom polygon query behavior.
 /// Used by dtNavMeshQuery::queryPolygons.
 /// @ingroup detour
@@ -172,7 +276,7 @@ public:
 	
 	/// Initializes the query object.
 	///  @param[in]		nav			Pointer to the dtNavMesh object to use for all queries.
-	///  @param[in]		maxNodes	Maximum number of search nodes. [Limits: 0 < value <= 65535]
+	///  @param[in]		maxNodes	Maximum number of search nodes. [Limits: 0 < value <= 65535, or 16777215 with #DT_NODE_INDEX32]
 	/// @returns The status flags for the query.
 	dtStatus init(const dtNavMesh* nav, const int maxNodes);
 	
@@ -194,6 +298,23 @@ public:
 					  const dtQueryFilter* filter,
 					  dtPolyRef* path, int* pathCount, const int maxPath) const;
 
+	/// Finds a path from the start polygon to the end polygon by searching from 
+	/// both ends at once.
+	///  @param[in]		startRef	The refrence id of the start polygon.
+	///  @param[in]		endRef		The reference id of the end polygon.
+	///  @param[in]		startPos	A position within the start polygon. [(x, y, z)]
+	///  @param[in]		endPos		A position within the end polygon. [(x, y, z)]
+	///  @param[in]		filter		The polygon filter to apply to the query.
+	///  @param[out]	path		An ordered list of polygon references representing the path. (Start to end.) 
+	///  							[(polyRef) * @p pathCount]
+	///  @param[out]	pathCount	The number of polygons returned in the @p path array.
+	///  @param[in]		maxPath		The maximum number of polygons the @p path array can hold. [Limit: >= 1]
+	/// @returns The status flags for the query.
+	dtStatus findPathBidirectional(dtPolyRef startRef, dtPolyRef endRef,
+								   const float* startPos, const float* endPos,
+								   const dtQueryFilter* filter,
+								   dtPolyRef* path, int* pathCount, const int maxPath);
+
 	/// Finds the straight path from the start to the end position within the polygon corridor.
 	///  @param[in]		startPos			Path start position. [(x, y, z)]
 	///  @param[in]		endPos				Path end position. [(x, y, z)]
@@ -211,6 +332,26 @@ public:
 							  float* straightPath, unsigned char* straightPathFlags, dtPolyRef* straightPathRefs,
 							  int* straightPathCount, const int maxStraightPath, const int options = 0) const;
 
+	/// Finds the straight path from the start to the end position within the polygon corridor, 
+	/// reusing the portals resolved by a previous call.
+	///  @param[in]		startPos			Path start position. [(x, y, z)]
+	///  @param[in]		endPos				Path end position. [(x, y, z)]
+	///  @param[in]		path				An array of polygon references that represent the path corridor.
+	///  @param[in]		pathSize			The number of polygons in the @p path array.
+	///  @param[out]	straightPath		Points describing the straight path. [(x, y, z) * @p straightPathCount].
+	///  @param[out]	straightPathFlags	Flags describing each point. (See: #dtStraightPathFlags) [opt]
+	///  @param[out]	straightPathRefs	The reference id of the polygon that is being entered at each point. [opt]
+	///  @param[out]	straightPathCount	The number of points in the straight path.
+	///  @param[in]		maxStraightPath		The maximum number of points the straight path arrays can hold.  [Limit: > 0]
+	///  @param[in]		options				Query options. (see: #dtStraightPathOptions)
+	///  @param[in,out]	portals				The portal buffer to reuse and extend.
+	/// @returns The status flags for the query.
+	dtStatus findStraightPath(const float* startPos, const float* endPos,
+							  const dtPolyRef* path, const int pathSize,
+							  float* straightPath, unsigned char* straightPathFlags, dtPolyRef* straightPathRefs,
+							  int* straightPathCount, const int maxStraightPath, const int options,
+							  dtPathPortals* portals) const;
+
 	///@}
 	/// @name Sliced Pathfinding Functions
 	/// Common use case:
@@ -296,6 +437,24 @@ public:
 								  dtPolyRef* resultRef, dtPolyRef* resultParent, float* resultCost,
 								  int* resultCount, const int maxResult) const;
 	
+	/// Finds the polygons that can reach the goal within the specified circle, the next polygon
+	/// each one should move to, and the cost to reach the goal. (A reverse Dijkstra search.)
+	///  @param[in]		goalRef			The reference id of the goal polygon.
+	///  @param[in]		goalPos			The goal position. [(x, y, z)]
+	///  @param[in]		radius			The radius of the search circle around the goal.
+	///  @param[in]		filter			The polygon filter to apply to the query.
+	///  @param[out]	resultRef		The reference ids of the polygons that can reach the goal. [opt]
+	///  @param[out]	resultNext		The reference ids of the next polygon towards the goal for
+	///  								each result. Zero for the goal polygon. [opt]
+	///  @param[out]	resultCost		The cost from the polygon to the goal. [opt]
+	///  @param[out]	resultCount		The number of polygons found.
+	///  @param[in]		maxResult		The maximum number of polygons the result arrays can hold.
+	/// @returns The status flags for the query.
+	dtStatus findFlowField(dtPolyRef goalRef, const float* goalPos, const float radius,
+						   const dtQueryFilter* filter,
+						   dtPolyRef* resultRef, dtPolyRef* resultNext, float* resultCost,
+						   int* resultCount, const int maxResult) const;
+	
 	/// Gets a path from the explored nodes in the previous search.
 	///  @param[in]		endRef		The reference id of the end polygon.
 	///  @param[out]	path		An ordered list of polygon references representing the path. (Start to end.)
@@ -324,6 +483,34 @@ public:
 	dtStatus findNearestPoly(const float* center, const float* halfExtents,
 							 const dtQueryFilter* filter,
 							 dtPolyRef* nearestRef, float* nearestPt) const;
+
+	/// Finds the polygon nearest to the specified center point.
+	///  @param[in]		center		The center of the search box. [(x, y, z)]
+	///  @param[in]		halfExtents		The search distance along each axis. [(x, y, z)]
+	///  @param[in]		filter		The polygon filter to apply to the query.
+	///  @param[out]	nearestRef	The reference id of the nearest polygon.
+	///  @param[out]	nearestPt	The nearest point on the polygon. [opt] [(x, y, z)]
+	///  @param[in]		options		Query options. (see: #dtFindNearestPolyOptions)
+	/// @returns The status flags for the query.
+	dtStatus findNearestPoly(const float* center, const float* halfExtents,
+							 const dtQueryFilter* filter,
+							 dtPolyRef* nearestRef, float* nearestPt, const int options) const;
+
+	/// Finds the polygon nearest to the specified center point, trying a polygon
+	/// known to be near it and that polygon's neighbours first.
+	///  @param[in]		hintRef		The reference id of a polygon near the center. (E.g. The 
+	///  							polygon from the previous update.) [opt]
+	///  @param[in]		center		The center of the search box. [(x, y, z)]
+	///  @param[in]		halfExtents		The search distance along each axis. [(x, y, z)]
+	///  @param[in]		filter		The polygon filter to apply to the query.
+	///  @param[out]	nearestRef	The reference id of the nearest polygon.
+	///  @param[out]	nearestPt	The nearest point on the polygon. [opt] [(x, y, z)]
+	///  @param[in]		options		Query options used if the full search is needed.
+	///  							(see: #dtFindNearestPolyOptions)
+	/// @returns The status flags for the query.
+	dtStatus findNearestPolyHinted(dtPolyRef hintRef, const float* center, const float* halfExtents,
+								   const dtQueryFilter* filter,
+								   dtPolyRef* nearestRef, float* nearestPt, const int options = 0) const;
 	
 	/// Finds polygons that overlap the search box.
 	///  @param[in]		center		The center of the search box. [(x, y, z)]
@@ -505,6 +692,57 @@ public:
 	/// @return The navigation mesh the query object is using.
 	const dtNavMesh* getAttachedNavMesh() const { return m_nav; }
 
+	/// Starts a read of the navigation mesh that tiles removed on other threads 
+	/// will not be freed under. (See: dtNavMesh::initConcurrentReads)
+	/// Reads may be nested.  Does nothing if concurrent reads are disabled.
+	/// @return The status flags for the operation.  On failure the read was not
+	/// 		started, and the mesh must not be read.
+	dtStatus beginRead();
+
+	/// Ends a read started using #beginRead.
+	void endRead();
+
+	/// Gets the memory used by the query object and its node pools.
+	/// @return The memory used, in bytes.
+	int getMemUsed() const;
+
+	/// Gets the search statistics.
+	///  @param[out]	lastQuery	The statistics of the most recent query. [opt]
+	///  @param[out]	total		The statistics of all queries since the last reset. [opt]
+	/// @returns False if the statistics are compiled out. (See #DT_QUERY_STATS.)
+	bool getQueryStats(dtQueryStats* lastQuery, dtQueryStats* total) const;
+
+	/// Clears the search statistics.
+	void resetQueryStats();
+
+	/// @}
+	/// @name Filter-specialized Functions
+	/// These behave like findPath(), raycast() and findPolysAroundCircle(), but are 
+	/// compiled for the concrete filter type so its calls can be inlined in the 
+	/// search loops. Instantiated for dtQueryFilter and dtIncludeQueryFilter; 
+	/// include DetourNavMeshQueryTemplates.h to use them with other filter types.
+	/// @{
+
+	/// @see findPath
+	template<class TFilter>
+	dtStatus findPathT(dtPolyRef startRef, dtPolyRef endRef,
+					   const float* startPos, const float* endPos,
+					   const TFilter* filter,
+					   dtPolyRef* path, int* pathCount, const int maxPath) const;
+
+	/// @see raycast
+	template<class TFilter>
+	dtStatus raycastT(dtPolyRef startRef, const float* startPos, const float* endPos,
+					  const TFilter* filter, const unsigned int options,
+					  dtRaycastHit* hit, dtPolyRef prevRef = 0) const;
+
+	/// @see findPolysAroundCircle
+	template<class TFilter>
+	dtStatus findPolysAroundCircleT(dtPolyRef startRef, const float* centerPos, const float radius,
+									const TFilter* filter,
+									dtPolyRef* resultRef, dtPolyRef* resultParent, float* resultCost,
+									int* resultCount, const int maxResult) const;
+
 	/// @}
 	
 private:
@@ -534,6 +772,13 @@ private:
 						  float* straightPath, unsigned char* straightPathFlags, dtPolyRef* straightPathRefs,
 						  int* straightPathCount, const int maxStraightPath) const;
 
+	// Realigns a portal buffer with the path and discards the portals that no longer match it.
+	void syncPathPortals(const dtPolyRef* path, const int pathSize, dtPathPortals* portals) const;
+
+	// Resolves the path portals up to the specified index into a portal buffer.
+	void resolvePathPortals(const dtPolyRef* path, const int pathSize, const int endIdx,
+							dtPathPortals* portals) const;
+
 	// Appends intermediate portal points to a straight path.
 	dtStatus appendPortals(const int startIdx, const int endIdx, const float* endPos, const dtPolyRef* path,
 						   float* straightPath, unsigned char* straightPathFlags, dtPolyRef* straightPathRefs,
@@ -541,8 +786,28 @@ private:
 
 	// Gets the path leading to the specified end node.
 	dtStatus getPathToNode(struct dtNode* endNode, dtPolyRef* path, int* pathCount, int maxPath) const;
+
+	// Allocates the node pool and open list of the backward search.
+	dtStatus initBackSearch();
+
+	// Sliced query steps for #DT_FINDPATH_BIDIRECTIONAL.
+	dtStatus updateSlicedFindPathBidirectional(const int maxIter, int* doneIters);
+	dtStatus finalizeSlicedFindPathBidirectional(dtPolyRef* path, int* pathCount, const int maxPath);
+
+#ifdef DT_QUERY_STATS
+	// Starts the statistics of a new query.
+	void beginQueryStats() const;
+
+	// Counts the outcome of the current query.
+	void endQueryStats(const dtStatus status) const;
+
+	mutable dtQueryStats m_lastStats;	///< Statistics of the most recent query.
+	mutable dtQueryStats m_totalStats;	///< Statistics of all queries since the last reset.
+#endif
 	
 	const dtNavMesh* m_nav;				///< Pointer to navmesh data.
+	int m_reader;						///< The reader slot of the navmesh, or -1 if none.
+	int m_readDepth;					///< Nesting depth of #beginRead.
 
 	struct dtQueryData
 	{
@@ -554,12 +819,17 @@ private:
 		const dtQueryFilter* filter;
 		unsigned int options;
 		float raycastLimitSqr;
+		struct dtNode* meetNode;		///< Forward node where the bidirectional searches met.
+		struct dtNode* meetBackNode;	///< Backward node where the bidirectional searches met.
+		float meetCost;					///< Cost of the best path through the meeting nodes.
 	};
 	dtQueryData m_query;				///< Sliced query state.
 
 	class dtNodePool* m_tinyNodePool;	///< Pointer to small node pool.
 	class dtNodePool* m_nodePool;		///< Pointer to node pool.
 	class dtNodeQueue* m_openList;		///< Pointer to open list queue.
+	class dtNodePool* m_backNodePool;	///< Pointer to the backward search node pool. (Allocated on first use.)
+	class dtNodeQueue* m_backOpenList;	///< Pointer to the backward search open list. (Allocated on first use.)
 };
 
 /// Allocates a query object using the Detour allocator.
@@ -28,7 +28,16 @@ enum dtNodeFlags
 	DT_NODE_PARENT_DETACHED = 0x04, // parent of the node is not adjacent. Found using raycast.
 };
 
+// Define (or define in a build config) the following line to use 32bit node indices.
+// Needed when a query is initialized with more than 65535 nodes, i.e. very large
+// searches on big meshes. Doubles the size of the node pool hash and next arrays.
+//#define DT_NODE_INDEX32 1
+
+#ifdef DT_NODE_INDEX32
+typedef unsigned int dtNodeIndex;
+#else
 typedef unsigned short dtNodeIndex;
+#endif
 static const dtNodeIndex DT_NULL_IDX = (dtNodeIndex)~0;
 
 static const int DT_NODE_PARENT_BITS = 24;
@@ -82,13 +91,17 @@ public:
 		return sizeof(*this) +
 			sizeof(dtNode)*m_maxNodes +
 			sizeof(dtNodeIndex)*m_maxNodes +
-			sizeof(dtNodeIndex)*m_hashSize;
+			sizeof(dtNodeIndex)*m_hashSize +
+			sizeof(unsigned int)*m_hashSize;
 	}
 	
 	inline int getMaxNodes() const { return m_maxNodes; }
 	
 	inline int getHashSize() const { return m_hashSize; }
-	inline dtNodeIndex getFirst(int bucket) const { return m_first[bucket]; }
+	inline dtNodeIndex getFirst(int bucket) const
+	{
+		return m_firstStamp[bucket] == m_stamp ? m_first[bucket] : DT_NULL_IDX;
+	}
 	inline dtNodeIndex getNext(int i) const { return m_next[i]; }
 	inline int getNodeCount() const { return m_nodeCount; }
 	
@@ -100,6 +113,8 @@ private:
 	dtNode* m_nodes;
 	dtNodeIndex* m_first;
 	dtNodeIndex* m_next;
+	unsigned int* m_firstStamp;		///< Clear generation each hash bucket was last written in.
+	unsigned int m_stamp;			///< Current clear generation.
 	const int m_maxNodes;
 	const int m_hashSize;
 	int m_nodeCount;
@@ -0,0 +1,173 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifndef DETOURPATHCACHE_H
+#define DETOURPATHCACHE_H
+
+#include "DetourNavMesh.h"
+#include "DetourNavMeshQuery.h"
+
+/// Hit and miss counters for a #dtPathCache.
+struct dtPathCacheStats
+{
+	int entryCount;			///< The number of cached paths.
+	int maxEntries;			///< The maximum number of cached paths.
+	unsigned int hitCount;			///< Lookups that returned a cached path.
+	unsigned int missCount;			///< Lookups that found no usable path. (Includes #invalidCount.)
+	unsigned int invalidCount;		///< Cached paths discarded because the mesh changed under them.
+	unsigned int evictCount;		///< Cached paths discarded to make room for new ones.
+};
+
+/// A least recently used cache of complete polygon paths.
+/// @ingroup detour
+class dtPathCache
+{
+public:
+	dtPathCache();
+	~dtPathCache();
+
+	/// Initializes the cache.
+	///  @param[in]		nav				The navigation mesh the paths belong to.
+	///  @param[in]		maxEntries		The maximum number of cached paths. [Limit: >= 1]
+	///  @param[in]		maxPathSize		The maximum number of polygons in a cached path.
+	/// @return The status flags for the operation.
+	dtStatus init(const dtNavMesh* nav, const int maxEntries, const int maxPathSize);
+
+	/// Finds a cached path and validates it against the navigation mesh.
+	///  @param[in]		startRef	The reference of the start polygon.
+	///  @param[in]		endRef		The reference of the end polygon.
+	///  @param[in]		filter		The filter the path must have been found with.
+	///  @param[out]	path		The path. [(polyRef) * @p pathCount]
+	///  @param[out]	pathCount	The number of polygons in the path.
+	///  @param[in]		maxPath		The maximum number of polygons the path array can hold.
+	/// @return True if a valid path was found.
+	bool find(dtPolyRef startRef, dtPolyRef endRef, const dtQueryFilter* filter,
+			  dtPolyRef* path, int* pathCount, const int maxPath);
+
+	/// Stores a path, replacing the least recently used entry if the cache is full.
+	/// Only complete paths, from @p startRef to @p endRef, are stored.
+	///  @param[in]		startRef	The reference of the start polygon.
+	///  @param[in]		endRef		The reference of the end polygon.
+	///  @param[in]		filter		The filter the path was found with.
+	///  @param[in]		path		The path. [(polyRef) * @p pathCount]
+	///  @param[in]		pathCount	The number of polygons in the path.
+	/// @return True if the path was stored.
+	bool store(dtPolyRef startRef, dtPolyRef endRef, const dtQueryFilter* filter,
+			   const dtPolyRef* path, const int pathCount);
+
+	/// Finds the path in the cache, or with the query on a miss and then stores it.
+	/// Same parameters and result as #dtNavMeshQuery::findPath.
+	dtStatus findPath(const dtNavMeshQuery* query, dtPolyRef startRef, dtPolyRef endRef,
+					  const float* startPos, const float* endPos,
+					  const dtQueryFilter* filter,
+					  dtPolyRef* path, int* pathCount, const int maxPath);
+
+	/// Discards every cached path that passes through the polygon.
+	void invalidatePoly(dtPolyRef ref);
+
+	/// Discards all cached paths.
+	void clear();
+
+	/// Gets the cache statistics.
+	void getStats(dtPathCacheStats* stats) const;
+
+	/// Resets the hit and miss counters.
+	void resetStats();
+
+	/// Returns a hash of the filter state that affects path results.
+	static unsigned int hashFilter(const dtQueryFilter* filter);
+
+	inline int getMaxPathSize() const { return m_maxPathSize; }
+
+	/// Gets the memory used by the cache, in bytes.
+	int getMemUsed() const;
+
+private:
+	// Explicitly disabled copy constructor and copy assignment operator.
+	dtPathCache(const dtPathCache&);
+	dtPathCache& operator=(const dtPathCache&);
+
+	struct Entry
+	{
+		dtPolyRef startRef, endRef;
+		unsigned int filterHash;
+		int npath;				///< Zero if the entry is unused.
+		int next;				///< Next entry in the hash chain, or the free list.
+		int lruPrev, lruNext;	///< The LRU list. (Most recent first.)
+	};
+
+	void purge();
+	int findEntry(dtPolyRef startRef, dtPolyRef endRef, unsigned int filterHash) const;
+	bool validate(const int idx) const;
+	void removeEntry(const int idx);
+	void unlinkLru(const int idx);
+	void pushLru(const int idx);
+	int hashKey(dtPolyRef startRef, dtPolyRef endRef, unsigned int filterHash) const;
+
+	const dtNavMesh* m_nav;
+
+	Entry* m_entries;
+	dtPolyRef* m_paths;				///< [(polyRef) * maxPathSize * maxEntries]
+	unsigned short* m_flags;		///< Polygon flags when the path was stored.
+	unsigned char* m_areas;			///< Polygon areas when the path was stored.
+	int m_maxEntries;
+	int m_maxPathSize;
+	int m_entryCount;
+
+	int* m_lookup;
+	int m_lookupMask;
+	int m_nextFree;
+	int m_lruHead, m_lruTail;
+
+	unsigned int m_hitCount;
+	unsigned int m_missCount;
+	unsigned int m_invalidCount;
+	unsigned int m_evictCount;
+};
+
+dtPathCache* dtAllocPathCache();
+void dtFreePathCache(dtPathCache* cache);
+
+#endif // DETOURPATHCACHE_H
+
+///////////////////////////////////////////////////////////////////////////
+
+// This section contains detailed documentation for members that don't have
+// a source file. It reduces clutter in the main section of the header.
+
+/**
+
+@class dtPathCache
+@par
+
+Paths are keyed by their start and end polygons and a hash of the filter
+(#hashFilter).  The start and end positions are not part of the key, so a
+cached path is the path found for the first request between the two
+polygons.
+
+Each entry records the flags and area of every polygon on its path.  #find
+discards the entry if any polygon is no longer valid, which happens when its
+tile is removed or replaced (the tile salt changes), or if its flags or area
+have changed.  Changes elsewhere on the mesh do not invalidate a path, so a
+new tile that offers a shorter route is only used once the old path is
+evicted or #clear is called.
+
+When DT_VIRTUAL_QUERYFILTER is defined, the hash only covers the base filter
+state.  Filters with additional state should not share a cache.
+
+*/
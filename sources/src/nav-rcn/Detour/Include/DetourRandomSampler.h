@@ -0,0 +1,129 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifndef DETOURRANDOMSAMPLER_H
+#define DETOURRANDOMSAMPLER_H
+
+#include "DetourNavMesh.h"
+#include "DetourNavMeshQuery.h"
+
+/// Picks random points on a navigation mesh, weighted by area, from a
+/// precomputed table.
+/// @ingroup detour
+class dtRandomPointSampler
+{
+public:
+	dtRandomPointSampler();
+	~dtRandomPointSampler();
+
+	/// Initializes the sampler and builds the area table.
+	///  @param[in]		query		The query used to find point heights. Its mesh is sampled.
+	///  @param[in]		filter		The filter polygons must pass.
+	/// @return The status flags for the operation.
+	dtStatus init(const dtNavMeshQuery* query, const dtQueryFilter* filter);
+
+	/// Rebuilds the table entries of the tiles that were added, removed or
+	/// replaced since the last update, and of the tiles marked with #invalidateTile.
+	///  @param[out]	rebuildCount	The number of tile entries that were rebuilt. [opt]
+	/// @return The status flags for the operation.
+	dtStatus update(int* rebuildCount = 0);
+
+	/// Marks a tile for rebuild on the next #update.  Use after changing 
+	/// polygon flags or areas.
+	///  @param[in]		tile	The tile.
+	void invalidateTile(const dtMeshTile* tile);
+
+	/// Marks every tile for rebuild on the next #update.  Use after changing the filter.
+	void invalidateAll();
+
+	/// Picks a random point.
+	///  @param[in]		frand		Function returning a random number [0..1).
+	///  @param[out]	randomRef	The reference of the polygon containing the point.
+	///  @param[out]	randomPt	The random point. [(x, y, z)]
+	/// @return The status flags for the operation.
+	dtStatus findRandomPoint(float (*frand)(), dtPolyRef* randomRef, float* randomPt) const;
+
+	/// Picks many random points.
+	///  @param[in]		frand		Function returning a random number [0..1).
+	///  @param[in]		count		The number of points to pick.
+	///  @param[out]	randomRefs	The references of the polygons containing the points. [(polyRef) * @p count]
+	///  @param[out]	randomPts	The random points. [(x, y, z) * @p count]
+	/// @return The status flags for the operation.
+	dtStatus findRandomPoints(float (*frand)(), const int count,
+							  dtPolyRef* randomRefs, float* randomPts) const;
+
+	/// The total area of the polygons that pass the filter.
+	inline float getTotalArea() const { return m_totalArea; }
+
+private:
+	// Explicitly disabled copy constructor and copy assignment operator.
+	dtRandomPointSampler(const dtRandomPointSampler&);
+	dtRandomPointSampler& operator=(const dtRandomPointSampler&);
+
+	struct TileTable
+	{
+		dtTileRef ref;			///< The tile the entry was built for, or zero.
+		float* cdf;				///< Cumulative polygon area. [(area) * npolys]
+		int* polys;				///< Polygon indices. [(index) * npolys]
+		int npolys;
+		bool dirty;
+	};
+
+	void purge();
+	dtStatus buildTile(const int idx, const dtMeshTile* tile);
+	void buildTileCdf();
+
+	const dtNavMeshQuery* m_query;
+	const dtNavMesh* m_nav;
+	const dtQueryFilter* m_filter;
+
+	TileTable* m_tiles;
+	float* m_tileCdf;			///< Cumulative tile area. [(area) * m_maxTiles]
+	int m_maxTiles;
+	int m_lastTile;				///< The last tile with area, or -1.
+	float m_totalArea;
+};
+
+dtRandomPointSampler* dtAllocRandomPointSampler();
+void dtFreeRandomPointSampler(dtRandomPointSampler* sampler);
+
+#endif // DETOURRANDOMSAMPLER_H
+
+///////////////////////////////////////////////////////////////////////////
+
+// This section contains detailed documentation for members that don't have
+// a source file. It reduces clutter in the main section of the header.
+
+/**
+
+@class dtRandomPointSampler
+@par
+
+Unlike dtNavMeshQuery::findRandomPoint, which visits every tile and polygon
+on each call, the sampler keeps cumulative area tables for the tiles and for
+the polygons of each tile.  A sample is two binary searches and a point pick
+within the polygon.  Tiles are weighted by their polygon area, so points are
+spread evenly over the mesh no matter how it is tiled.
+
+The polygon table is built with the filter given to #init.  The filter is
+not copied, so it must outlive the sampler.  #update finds tile changes by
+comparing tile references, which costs one pass over the tile slots.
+Polygon flag and area changes are not detected; mark the tile with
+#invalidateTile.
+
+*/
@@ -0,0 +1,250 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifndef DETOURRAYCASTCACHE_H
+#define DETOURRAYCASTCACHE_H
+
+#include "DetourNavMesh.h"
+#include "DetourNavMeshQuery.h"
+#include "DetourTaskScheduler.h"
+
+/// The maximum number of tiles a cached raycast result can depend on.
+/// Results that touch more tiles are not cached.
+static const int DT_RAYCAST_CACHE_MAX_TILES = 8;
+
+/// The maximum number of polygons a raycast can visit and still be cached.
+static const int DT_RAYCAST_CACHE_MAX_PATH = 256;
+
+/// Hit and miss counters for a #dtRaycastCache.
+struct dtRaycastCacheStats
+{
+	int entryCount;			///< The number of cached results.
+	int maxEntries;			///< The maximum number of cached results.
+	unsigned int hitCount;			///< Lookups that returned a cached result.
+	unsigned int missCount;			///< Lookups that found no usable result. (Includes #invalidCount.)
+	unsigned int invalidCount;		///< Cached results discarded because the mesh changed under them.
+	unsigned int evictCount;		///< Cached results discarded to make room for new ones.
+	unsigned int uncachedCount;		///< Results that could not be cached. (Failed, or too long.)
+};
+
+/// A least recently used cache of raycast results, with batched, parallel
+/// raycasts for the misses.
+/// @ingroup detour
+class dtRaycastCache
+{
+public:
+	dtRaycastCache();
+	~dtRaycastCache();
+
+	/// Initializes the cache.
+	///  @param[in]		nav				The navigation mesh to cast against.
+	///  @param[in]		maxEntries		The maximum number of cached results. [Limit: >= 1]
+	///  @param[in]		quantum			The cell size the ray end points are snapped to
+	///									for the lookup. Zero or less only matches
+	///									identical end points. [Units: wu]
+	/// @return The status flags for the operation.
+	dtStatus init(const dtNavMesh* nav, const int maxEntries, const float quantum);
+
+	/// Sets the scheduler used to run the raycasts of #raycastBatch in parallel.
+	/// Null runs them on the calling thread.
+	///  @param[in]		scheduler	The task scheduler, or null.
+	/// @return False if the per-worker queries could not be created. The cache
+	///  is then serial.
+	bool setTaskScheduler(dtTaskScheduler* scheduler);
+
+	/// Gets the task scheduler. (Null if the cache is serial.)
+	dtTaskScheduler* getTaskScheduler() const { return m_scheduler; }
+
+	/// Finds a cached result and validates it against the navigation mesh.
+	///  @param[in]		startRef	The reference of the start polygon.
+	///  @param[in]		startPos	The start position of the ray. [(x, y, z)]
+	///  @param[in]		endPos		The end position of the ray. [(x, y, z)]
+	///  @param[in]		filter		The filter the ray must have been cast with.
+	///  @param[out]	t			The hit parameter. (FLT_MAX if no wall was hit.)
+	///  @param[out]	hitNormal	The normal of the nearest wall hit. [(x, y, z)] [Optional]
+	///  @param[out]	status		The status the raycast returned. [Optional]
+	/// @return True if a valid result was found.
+	bool find(dtPolyRef startRef, const float* startPos, const float* endPos,
+			  const dtQueryFilter* filter, float* t, float* hitNormal, dtStatus* status);
+
+	/// Stores a raycast result, replacing the least recently used entry if the
+	/// cache is full.  Only successful raycasts with their complete path are stored.
+	///  @param[in]		startRef	The reference of the start polygon.
+	///  @param[in]		startPos	The start position of the ray. [(x, y, z)]
+	///  @param[in]		endPos		The end position of the ray. [(x, y, z)]
+	///  @param[in]		filter		The filter the ray was cast with.
+	///  @param[in]		t			The hit parameter.
+	///  @param[in]		hitNormal	The hit normal. [(x, y, z)]
+	///  @param[in]		status		The status the raycast returned.
+	///  @param[in]		path		The polygons the ray visited. [(polyRef) * @p pathCount]
+	///  @param[in]		pathCount	The number of polygons in the path.
+	/// @return True if the result was stored.
+	bool store(dtPolyRef startRef, const float* startPos, const float* endPos,
+			   const dtQueryFilter* filter, const float t, const float* hitNormal,
+			   const dtStatus status, const dtPolyRef* path, const int pathCount);
+
+	/// Finds the result in the cache, or casts the ray on a miss and then stores it.
+	/// Same parameters and result as #dtNavMeshQuery::raycast, without the path.
+	dtStatus raycast(dtPolyRef startRef, const float* startPos, const float* endPos,
+					 const dtQueryFilter* filter, float* t, float* hitNormal);
+
+	/// Casts a batch of rays.  The cache is searched for every ray, and the misses
+	/// are cast with the task scheduler and stored.
+	///  @param[in]		startRefs		The start polygon of each ray. [(polyRef) * @p count]
+	///  @param[in]		startPositions	The start position of each ray. [(x, y, z) * @p count]
+	///  @param[in]		endPositions	The end position of each ray. [(x, y, z) * @p count]
+	///  @param[in]		filters			The filters. [(filter) * @p filterCount]
+	///  @param[in]		filterCount		The number of filters.
+	///  @param[in]		filterIndices	The filter of each ray, or null to use the
+	///									first filter for all. [(index) * @p count]
+	///  @param[in]		count			The number of rays.
+	///  @param[out]	resultParams	The hit parameter of each ray. [(t) * @p count]
+	///  @param[out]	resultNormals	The hit normal of each ray. [(x, y, z) * @p count] [Optional]
+	///  @param[out]	resultStatus	The raycast status of each ray. [(status) * @p count]
+	/// @return The status flags for the operation.
+	dtStatus raycastBatch(const dtPolyRef* startRefs, const float* startPositions,
+						  const float* endPositions, const dtQueryFilter* const* filters,
+						  const int filterCount, const int* filterIndices, const int count,
+						  float* resultParams, float* resultNormals, dtStatus* resultStatus);
+
+	/// Discards all cached results.
+	void clear();
+
+	/// Gets the cache statistics.
+	void getStats(dtRaycastCacheStats* stats) const;
+
+	/// Resets the hit and miss counters.
+	void resetStats();
+
+	inline float getQuantum() const { return m_quantum; }
+
+	/// Gets the memory used by the cache, in bytes.
+	int getMemUsed() const;
+
+private:
+	// Explicitly disabled copy constructor and copy assignment operator.
+	dtRaycastCache(const dtRaycastCache&);
+	dtRaycastCache& operator=(const dtRaycastCache&);
+
+	struct Key
+	{
+		dtPolyRef startRef;
+		int pos[6];				///< The snapped start and end positions.
+		unsigned int filterHash;
+	};
+
+	struct Entry
+	{
+		Key key;
+		float t;
+		float hitNormal[3];
+		dtStatus status;
+		unsigned int version;	///< The mesh version the result is valid at.
+		dtPolyRef tiles[DT_RAYCAST_CACHE_MAX_TILES];	///< A polygon in each tile the result depends on.
+		int ntiles;
+		int next;				///< Next entry in the hash chain, or the free list.
+		int lruPrev, lruNext;	///< The LRU list. (Most recent first.)
+	};
+
+	/// A ray of #raycastBatch that missed the cache.
+	struct PendingRay
+	{
+		int index;
+		const dtQueryFilter* filter;
+		float hitNormal[3];
+		int ntiles;				///< Zero if the result can't be cached.
+		dtPolyRef tiles[DT_RAYCAST_CACHE_MAX_TILES];
+	};
+
+	struct BatchContext;
+	static void castPendingRays(void* userData, int taskIndex, int workerIndex);
+
+	void purge();
+	void freeWorkers();
+	bool initWorkers(const int count);
+	void makeKey(dtPolyRef startRef, const float* startPos, const float* endPos,
+				 const dtQueryFilter* filter, Key& key) const;
+	int findEntry(const Key& key) const;
+	bool validate(const int idx);
+	void removeEntry(const int idx);
+	void unlinkLru(const int idx);
+	void pushLru(const int idx);
+	int hashKey(const Key& key) const;
+	int collectTiles(const dtPolyRef* path, const int pathCount, dtPolyRef* tiles) const;
+	void insert(const Key& key, const float t, const float* hitNormal, const dtStatus status,
+				const dtPolyRef* tiles, const int ntiles, const unsigned int version);
+
+	const dtNavMesh* m_nav;
+	float m_quantum;
+
+	Entry* m_entries;
+	int m_maxEntries;
+	int m_entryCount;
+
+	int* m_lookup;
+	int m_lookupMask;
+	int m_nextFree;
+	int m_lruHead, m_lruTail;
+
+	dtTaskScheduler* m_scheduler;
+	dtNavMeshQuery** m_workerQueries;
+	dtPolyRef* m_workerPaths;		///< [(polyRef) * #DT_RAYCAST_CACHE_MAX_PATH * workerCount]
+	int m_workerCount;
+
+	unsigned int m_hitCount;
+	unsigned int m_missCount;
+	unsigned int m_invalidCount;
+	unsigned int m_evictCount;
+	unsigned int m_uncachedCount;
+};
+
+dtRaycastCache* dtAllocRaycastCache();
+void dtFreeRaycastCache(dtRaycastCache* cache);
+
+#endif // DETOURRAYCASTCACHE_H
+
+///////////////////////////////////////////////////////////////////////////
+
+// This section contains detailed documentation for members that don't have
+// a source file. It reduces clutter in the main section of the header.
+
+/**
+
+@class dtRaycastCache
+@par
+
+Results are keyed by the start polygon, the start and end positions snapped
+to the quantum, and a hash of the filter's include and exclude flags.  (The
+end polygon follows from the snapped end position.)  With a positive quantum,
+rays whose end points share the same cells share a result, so a cached hit
+parameter is that of the first ray cast between the cells.  A quantum of zero
+or less only matches identical positions and returns exactly what the query
+would.
+
+Each entry records the tiles of the polygons the ray visited and of their
+neighbours, and the mesh version (#dtNavMesh::getVersion) the result was
+found at.  #find discards the entry if any of those tiles has changed since.
+(See #dtNavMesh::hasTileChanged)  Changes elsewhere on the mesh do not
+invalidate a result.
+
+The mesh must not be modified during #raycastBatch.  The area costs do not
+affect a raycast and are not part of the key.  When DT_VIRTUAL_QUERYFILTER
+is defined, the hash only covers the base filter state.  Filters with
+additional state should not share a cache.
+
+*/
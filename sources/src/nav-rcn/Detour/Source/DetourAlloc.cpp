@@ -15,10 +15,14 @@
 //    misrepresented as being the original software.
 // 3. This notice may not be removed or altered from any source distribution.
 //
-
 #include <stdlib.h>
 #include "DetourAlloc.h"
 
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
 static void *dtAllocDefault(size_t size, dtAllocHint)
 {
 	return malloc(size);
@@ -32,6 +36,58 @@ static void dtFreeDefault(void *ptr)
 static dtAllocFunc* sAllocFunc = dtAllocDefault;
 static dtFreeFunc* sFreeFunc = dtFreeDefault;
 
+// Prefixed to each block for the accounting.  Sized so the block keeps the 
+// alignment of the base allocator.
+union dtAllocHeader
+{
+	struct
+	{
+		size_t size;
+		int tag;
+	} info;
+	double align[2];
+};
+
+struct dtAllocCounters
+{
+	volatile size_t liveBytes;
+	volatile size_t peakBytes;
+	volatile size_t liveBlocks;
+	volatile size_t totalBlocks;
+};
+
+static dtAllocCounters sCounters[DT_MAX_ALLOC_TAGS];
+
+// Adds the delta and returns the new value.  (Unsigned wrap is used to subtract.)
+static size_t atomicAdd(volatile size_t* value, size_t delta)
+{
+#if defined(_WIN64)
+	return (size_t)InterlockedExchangeAdd64((volatile LONG64*)value, (LONG64)delta) + delta;
+#elif defined(_WIN32)
+	return (size_t)InterlockedExchangeAdd((volatile LONG*)value, (LONG)delta) + delta;
+#else
+	return __sync_add_and_fetch(value, delta);
+#endif
+}
+
+static void atomicMax(volatile size_t* value, size_t v)
+{
+	size_t current = *value;
+	while (current < v)
+	{
+#if defined(_WIN64)
+		const size_t prev = (size_t)InterlockedCompareExchange64((volatile LONG64*)value, (LONG64)v, (LONG64)current);
+#elif defined(_WIN32)
+		const size_t prev = (size_t)InterlockedCompareExchange((volatile LONG*)value, (LONG)v, (LONG)current);
+#else
+		const size_t prev = __sync_val_compare_and_swap(value, current, v);
+#endif
+		if (prev == current)
+			break;
+		current = prev;
+	}
+}
+
 void dtAllocSetCustom(dtAllocFunc *allocFunc, dtFreeFunc *freeFunc)
 {
 	sAllocFunc = allocFunc ? allocFunc : dtAllocDefault;
@@ -40,11 +96,66 @@ void dtAllocSetCustom(dtAllocFunc *allocFunc, dtFreeFunc *freeFunc)
 
 void* dtAlloc(size_t size, dtAllocHint hint)
 {
-	return sAllocFunc(size, hint);
+	return dtAlloc(size, hint, DT_ALLOC_TAG_GENERAL);
+}
+
+/// @par
+///
+/// Each block carries a small header that records its size and tag, so the 
+/// custom allocation function receives slightly larger requests than the 
+/// caller made.
+///
+/// @see dtGetAllocStats
+void* dtAlloc(size_t size, dtAllocHint hint, dtAllocTag tag)
+{
+	dtAllocHeader* header = (dtAllocHeader*)sAllocFunc(sizeof(dtAllocHeader) + size, hint);
+	if (!header)
+		return 0;
+
+	header->info.size = size;
+	header->info.tag = (int)tag;
+
+	dtAllocCounters& counters = sCounters[tag];
+	atomicMax(&counters.peakBytes, atomicAdd(&counters.liveBytes, size));
+	atomicAdd(&counters.liveBlocks, 1);
+	atomicAdd(&counters.totalBlocks, 1);
+
+	return header + 1;
 }
 
 void dtFree(void* ptr)
 {
-	if (ptr)
-		sFreeFunc(ptr);
+	if (!ptr)
+		return;
+
+	dtAllocHeader* header = (dtAllocHeader*)ptr - 1;
+
+	dtAllocCounters& counters = sCounters[header->info.tag];
+	atomicAdd(&counters.liveBytes, (size_t)0 - header->info.size);
+	atomicAdd(&counters.liveBlocks, (size_t)0 - 1);
+
+	sFreeFunc(header);
+}
+
+size_t dtAllocSize(const void* ptr)
+{
+	if (!ptr)
+		return 0;
+	return ((const dtAllocHeader*)ptr - 1)->info.size;
+}
+
+/// @par
+///
+/// The counters are updated atomically, but the values are read separately, 
+/// so they can be slightly out of step while other threads allocate.
+void dtGetAllocStats(dtAllocTag tag, dtAllocStats* stats)
+{
+	if (!stats)
+		return;
+
+	const dtAllocCounters& counters = sCounters[tag];
+	stats->liveBytes = counters.liveBytes;
+	stats->peakBytes = counters.peakBytes;
+	stats->liveBlocks = counters.liveBlocks;
+	stats->totalBlocks = counters.totalBlocks;
 }
@@ -19,6 +19,64 @@
 #include "DetourCommon.h"
 #include "DetourMath.h"
 
+// Four lane helpers for the polygon distance kernel.  SSE2 is part of every
+// x86-64 target, and NEON with the divide instruction is part of every AArch64
+// target, so neither needs compiler flags or a runtime check.  Other targets
+// use the scalar code.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DT_COMMON_SIMD_SSE2
+#include <emmintrin.h>
+#elif (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+#define DT_COMMON_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(DT_COMMON_SIMD_SSE2)
+
+typedef __m128 dtSimdFloat;
+typedef __m128 dtSimdMask;
+
+inline dtSimdFloat dtSimdLoad(const float* p) { return _mm_loadu_ps(p); }
+inline void dtSimdStore(float* p, const dtSimdFloat a) { _mm_storeu_ps(p, a); }
+inline dtSimdFloat dtSimdSet(const float a) { return _mm_set1_ps(a); }
+inline dtSimdFloat dtSimdAdd(const dtSimdFloat a, const dtSimdFloat b) { return _mm_add_ps(a, b); }
+inline dtSimdFloat dtSimdSub(const dtSimdFloat a, const dtSimdFloat b) { return _mm_sub_ps(a, b); }
+inline dtSimdFloat dtSimdMul(const dtSimdFloat a, const dtSimdFloat b) { return _mm_mul_ps(a, b); }
+inline dtSimdFloat dtSimdDiv(const dtSimdFloat a, const dtSimdFloat b) { return _mm_div_ps(a, b); }
+inline dtSimdMask dtSimdLess(const dtSimdFloat a, const dtSimdFloat b) { return _mm_cmplt_ps(a, b); }
+inline dtSimdMask dtSimdGreater(const dtSimdFloat a, const dtSimdFloat b) { return _mm_cmpgt_ps(a, b); }
+inline dtSimdMask dtSimdAnd(const dtSimdMask a, const dtSimdMask b) { return _mm_and_ps(a, b); }
+inline dtSimdMask dtSimdXor(const dtSimdMask a, const dtSimdMask b) { return _mm_xor_ps(a, b); }
+inline dtSimdFloat dtSimdSelect(const dtSimdMask m, const dtSimdFloat a, const dtSimdFloat b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+inline dtSimdMask dtSimdMaskZero() { return _mm_setzero_ps(); }
+inline int dtSimdMaskBits(const dtSimdMask m) { return _mm_movemask_ps(m); }
+
+#elif defined(DT_COMMON_SIMD_NEON)
+
+typedef float32x4_t dtSimdFloat;
+typedef uint32x4_t dtSimdMask;
+
+inline dtSimdFloat dtSimdLoad(const float* p) { return vld1q_f32(p); }
+inline void dtSimdStore(float* p, const dtSimdFloat a) { vst1q_f32(p, a); }
+inline dtSimdFloat dtSimdSet(const float a) { return vdupq_n_f32(a); }
+inline dtSimdFloat dtSimdAdd(const dtSimdFloat a, const dtSimdFloat b) { return vaddq_f32(a, b); }
+inline dtSimdFloat dtSimdSub(const dtSimdFloat a, const dtSimdFloat b) { return vsubq_f32(a, b); }
+inline dtSimdFloat dtSimdMul(const dtSimdFloat a, const dtSimdFloat b) { return vmulq_f32(a, b); }
+inline dtSimdFloat dtSimdDiv(const dtSimdFloat a, const dtSimdFloat b) { return vdivq_f32(a, b); }
+inline dtSimdMask dtSimdLess(const dtSimdFloat a, const dtSimdFloat b) { return vcltq_f32(a, b); }
+inline dtSimdMask dtSimdGreater(const dtSimdFloat a, const dtSimdFloat b) { return vcgtq_f32(a, b); }
+inline dtSimdMask dtSimdAnd(const dtSimdMask a, const dtSimdMask b) { return vandq_u32(a, b); }
+inline dtSimdMask dtSimdXor(const dtSimdMask a, const dtSimdMask b) { return veorq_u32(a, b); }
+inline dtSimdFloat dtSimdSelect(const dtSimdMask m, const dtSimdFloat a, const dtSimdFloat b) { return vbslq_f32(m, a, b); }
+inline dtSimdMask dtSimdMaskZero() { return vdupq_n_u32(0); }
+inline int dtSimdMaskBits(const dtSimdMask m)
+{
+	const uint32x4_t bits = { 1, 2, 4, 8 };
+	return (int)vaddvq_u32(vandq_u32(m, bits));
+}
+
+#endif
+
 //////////////////////////////////////////////////////////////////////////////////////////
 
 void dtClosestPtPointTriangle(float* closest, const float* p,
@@ -269,6 +327,142 @@ bool dtDistancePtPolyEdgesSqr(const float* pt, const float* verts, const int nve
 	return c;
 }
 
+#if defined(DT_COMMON_SIMD_SSE2) || defined(DT_COMMON_SIMD_NEON)
+
+/// @par
+///
+/// The polygons are processed four at a time, one per lane, so the cost is that of the
+/// polygon with the most vertices in each group of four.  Every lane performs the same
+/// operations as dtDistancePtPolyEdgesSqr() in the same order, so the results are identical.
+void dtDistancePtPolysSqr2D(const float* pt, const float* verts, const int* nverts,
+							const int npolys, const int maxVerts,
+							float* distSqr, int* edges, float* edgeT)
+{
+	// The edge start and end vertices of the group, transposed to one lane per polygon.
+	static const int MAX_EDGES = 32;
+	float px[MAX_EDGES*4], pz[MAX_EDGES*4], qx[MAX_EDGES*4], qz[MAX_EDGES*4];
+	float vcount[4];
+
+	const dtSimdFloat ptx = dtSimdSet(pt[0]);
+	const dtSimdFloat ptz = dtSimdSet(pt[2]);
+	const dtSimdFloat zero = dtSimdSet(0.0f);
+	const dtSimdFloat one = dtSimdSet(1.0f);
+
+	for (int base = 0; base < npolys; base += 4)
+	{
+		const int nlanes = dtMin(4, npolys - base);
+		int maxn = 0;
+		for (int l = 0; l < 4; ++l)
+		{
+			const int n = l < nlanes ? dtMin(nverts[base+l], MAX_EDGES) : 0;
+			vcount[l] = (float)n;
+			maxn = dtMax(maxn, n);
+			const float* v = &verts[(base+l)*maxVerts*3];
+			for (int i = 0; i < n; ++i)
+			{
+				const float* vp = &v[i*3];
+				const float* vq = &v[((i+1) < n ? i+1 : 0)*3];
+				px[i*4+l] = vp[0];
+				pz[i*4+l] = vp[2];
+				qx[i*4+l] = vq[0];
+				qz[i*4+l] = vq[2];
+			}
+		}
+		// Clear the edges past the end of the shorter polygons.
+		for (int l = 0; l < 4; ++l)
+		{
+			for (int i = (int)vcount[l]; i < maxn; ++i)
+				px[i*4+l] = pz[i*4+l] = qx[i*4+l] = qz[i*4+l] = 0.0f;
+		}
+
+		const dtSimdFloat count = dtSimdLoad(vcount);
+		dtSimdMask inside = dtSimdMaskZero();
+		dtSimdFloat dmin = zero;
+		dtSimdFloat tmin = zero;
+		dtSimdFloat imin = zero;
+
+		for (int i = 0; i < maxn; ++i)
+		{
+			const dtSimdFloat fi = dtSimdSet((float)i);
+			const dtSimdMask valid = dtSimdLess(fi, count);
+			const dtSimdFloat ax = dtSimdLoad(&px[i*4]);
+			const dtSimdFloat az = dtSimdLoad(&pz[i*4]);
+			const dtSimdFloat bx = dtSimdLoad(&qx[i*4]);
+			const dtSimdFloat bz = dtSimdLoad(&qz[i*4]);
+
+			// Crossing test, with vi = b and vj = a.
+			const dtSimdMask straddle = dtSimdXor(dtSimdGreater(bz, ptz), dtSimdGreater(az, ptz));
+			const dtSimdFloat xcross = dtSimdAdd(dtSimdDiv(dtSimdMul(dtSimdSub(ax, bx), dtSimdSub(ptz, bz)),
+														   dtSimdSub(az, bz)), bx);
+			inside = dtSimdXor(inside, dtSimdAnd(valid, dtSimdAnd(straddle, dtSimdLess(ptx, xcross))));
+
+			// Distance to the segment from a to b.
+			const dtSimdFloat pqx = dtSimdSub(bx, ax);
+			const dtSimdFloat pqz = dtSimdSub(bz, az);
+			dtSimdFloat dx = dtSimdSub(ptx, ax);
+			dtSimdFloat dz = dtSimdSub(ptz, az);
+			const dtSimdFloat d = dtSimdAdd(dtSimdMul(pqx, pqx), dtSimdMul(pqz, pqz));
+			dtSimdFloat t = dtSimdAdd(dtSimdMul(pqx, dx), dtSimdMul(pqz, dz));
+			t = dtSimdSelect(dtSimdGreater(d, zero), dtSimdDiv(t, d), t);
+			t = dtSimdSelect(dtSimdLess(t, zero), zero, dtSimdSelect(dtSimdGreater(t, one), one, t));
+			dx = dtSimdSub(dtSimdAdd(ax, dtSimdMul(t, pqx)), ptx);
+			dz = dtSimdSub(dtSimdAdd(az, dtSimdMul(t, pqz)), ptz);
+			const dtSimdFloat dist = dtSimdAdd(dtSimdMul(dx, dx), dtSimdMul(dz, dz));
+
+			// Keep the first nearest edge.
+			const dtSimdMask closer = i == 0 ? valid : dtSimdAnd(valid, dtSimdLess(dist, dmin));
+			dmin = dtSimdSelect(closer, dist, dmin);
+			tmin = dtSimdSelect(closer, t, tmin);
+			imin = dtSimdSelect(closer, fi, imin);
+		}
+
+		float rd[4], rt[4], ri[4];
+		dtSimdStore(rd, dmin);
+		dtSimdStore(rt, tmin);
+		dtSimdStore(ri, imin);
+		const int in = dtSimdMaskBits(inside);
+		for (int l = 0; l < nlanes; ++l)
+		{
+			const bool over = (in & (1 << l)) != 0;
+			distSqr[base+l] = over ? 0.0f : rd[l];
+			edges[base+l] = over ? -1 : (int)ri[l];
+			edgeT[base+l] = over ? 0.0f : rt[l];
+		}
+	}
+}
+
+#else
+
+void dtDistancePtPolysSqr2D(const float* pt, const float* verts, const int* nverts,
+							const int npolys, const int maxVerts,
+							float* distSqr, int* edges, float* edgeT)
+{
+	static const int MAX_EDGES = 32;
+	float ed[MAX_EDGES], et[MAX_EDGES];
+	for (int i = 0; i < npolys; ++i)
+	{
+		const int n = dtMin(nverts[i], MAX_EDGES);
+		if (dtDistancePtPolyEdgesSqr(pt, &verts[i*maxVerts*3], n, ed, et))
+		{
+			distSqr[i] = 0.0f;
+			edges[i] = -1;
+			edgeT[i] = 0.0f;
+			continue;
+		}
+		int imin = 0;
+		for (int j = 1; j < n; ++j)
+		{
+			if (ed[j] < ed[imin])
+				imin = j;
+		}
+		distSqr[i] = ed[imin];
+		edges[i] = imin;
+		edgeT[i] = et[imin];
+	}
+}
+
+#endif
+
 static void projectPoly(const float* axis, const float* poly, const int npoly,
 						float& rmin, float& rmax)
 {
@@ -0,0 +1,479 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#include <string.h>
+#include <new>
+#include "DetourFlowField.h"
+#include "DetourPathCache.h"
+#include "DetourCommon.h"
+#include "DetourAlloc.h"
+#include "DetourAssert.h"
+
+dtFlowFieldCache* dtAllocFlowFieldCache()
+{
+	void* mem = dtAlloc(sizeof(dtFlowFieldCache), DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+	if (!mem) return 0;
+	return new(mem) dtFlowFieldCache;
+}
+
+void dtFreeFlowFieldCache(dtFlowFieldCache* cache)
+{
+	if (!cache) return;
+	cache->~dtFlowFieldCache();
+	dtFree(cache);
+}
+
+inline unsigned int hashPolyRef(dtPolyRef ref)
+{
+	unsigned int h = 2166136261u;
+	const unsigned char* p = (const unsigned char*)&ref;
+	for (int i = 0; i < (int)sizeof(ref); ++i)
+		h = (h ^ p[i]) * 16777619u;
+	return h;
+}
+
+dtFlowField::dtFlowField() :
+	m_goalRef(0),
+	m_filterHash(0),
+	m_lastUsed(0),
+	m_polys(0),
+	m_next(0),
+	m_costs(0),
+	m_polyCount(0),
+	m_lookup(0),
+	m_lookupMask(0),
+	m_tiles(0),
+	m_tileCount(0)
+{
+	dtVset(m_goalPos, 0, 0, 0);
+	m_tileMin[0] = m_tileMin[1] = 0;
+	m_tileMax[0] = m_tileMax[1] = 0;
+}
+
+int dtFlowField::findPoly(dtPolyRef ref) const
+{
+	if (!m_polyCount || !ref)
+		return -1;
+
+	unsigned int h = hashPolyRef(ref) & (unsigned int)m_lookupMask;
+	while (m_lookup[h] != -1)
+	{
+		const int idx = m_lookup[h];
+		if (m_polys[idx] == ref)
+			return idx;
+		h = (h+1) & (unsigned int)m_lookupMask;
+	}
+	return -1;
+}
+
+bool dtFlowField::getNext(dtPolyRef ref, dtPolyRef* next, float* cost) const
+{
+	const int idx = findPoly(ref);
+	if (idx == -1)
+		return false;
+
+	if (next)
+		*next = m_next[idx];
+	if (cost)
+		*cost = m_costs[idx];
+
+	return true;
+}
+
+dtStatus dtFlowField::getPath(dtPolyRef startRef, dtPolyRef* path, int* pathCount, const int maxPath) const
+{
+	dtAssert(pathCount);
+
+	*pathCount = 0;
+
+	if (!path || maxPath < 1)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	int idx = findPoly(startRef);
+	if (idx == -1)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	// The next polygons form a tree rooted at the goal, so this always ends.
+	int n = 0;
+	dtStatus status = DT_SUCCESS;
+	for (;;)
+	{
+		path[n++] = m_polys[idx];
+		if (!m_next[idx])
+			break;
+		if (n >= maxPath)
+		{
+			status |= DT_BUFFER_TOO_SMALL;
+			break;
+		}
+		idx = findPoly(m_next[idx]);
+		dtAssert(idx != -1);
+	}
+
+	*pathCount = n;
+
+	return status;
+}
+
+dtFlowFieldCache::dtFlowFieldCache() :
+	m_nav(0),
+	m_query(0),
+	m_fields(0),
+	m_maxFields(0),
+	m_maxPolys(0),
+	m_radius(0),
+	m_fieldCount(0),
+	m_tileStamps(0),
+	m_tick(0)
+{
+	resetStats();
+}
+
+dtFlowFieldCache::~dtFlowFieldCache()
+{
+	purge();
+}
+
+void dtFlowFieldCache::purge()
+{
+	if (m_fields)
+	{
+		// The field arrays are allocated in blocks owned by the first field.
+		dtFree(m_fields[0].m_polys);
+		dtFree(m_fields[0].m_next);
+		dtFree(m_fields[0].m_costs);
+		dtFree(m_fields[0].m_lookup);
+		dtFree(m_fields[0].m_tiles);
+		for (int i = 0; i < m_maxFields; ++i)
+			m_fields[i].~dtFlowField();
+		dtFree(m_fields);
+		m_fields = 0;
+	}
+	dtFreeNavMeshQuery(m_query);
+	m_query = 0;
+	dtFree(m_tileStamps);
+	m_tileStamps = 0;
+	m_nav = 0;
+	m_maxFields = 0;
+	m_maxPolys = 0;
+	m_fieldCount = 0;
+}
+
+int dtFlowFieldCache::getMemUsed() const
+{
+	int mem = sizeof(*this) + (int)dtAllocSize(m_fields) + (int)dtAllocSize(m_tileStamps);
+	if (m_fields)
+	{
+		// The field arrays are allocated in blocks owned by the first field.
+		mem += (int)dtAllocSize(m_fields[0].m_polys);
+		mem += (int)dtAllocSize(m_fields[0].m_next);
+		mem += (int)dtAllocSize(m_fields[0].m_costs);
+		mem += (int)dtAllocSize(m_fields[0].m_lookup);
+		mem += (int)dtAllocSize(m_fields[0].m_tiles);
+	}
+	if (m_query)
+		mem += m_query->getMemUsed();
+	return mem;
+}
+
+dtStatus dtFlowFieldCache::init(const dtNavMesh* nav, const int maxFields, const int maxPolys, const float radius)
+{
+	purge();
+
+	if (!nav || maxFields < 1 || maxPolys < 1 || radius <= 0)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	m_query = dtAllocNavMeshQuery();
+	if (!m_query)
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+	dtStatus status = m_query->init(nav, maxPolys);
+	if (dtStatusFailed(status))
+	{
+		purge();
+		return status;
+	}
+
+	m_fields = (dtFlowField*)dtAlloc(sizeof(dtFlowField)*maxFields, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+	if (!m_fields)
+	{
+		purge();
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+	}
+	for (int i = 0; i < maxFields; ++i)
+		new(&m_fields[i]) dtFlowField;
+	m_maxFields = maxFields;
+
+	const int lookupSize = dtNextPow2(maxPolys*2);
+	const int maxTiles = dtMin(maxPolys, nav->getMaxTiles());
+
+	dtPolyRef* polys = (dtPolyRef*)dtAlloc(sizeof(dtPolyRef)*maxPolys*maxFields, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+	dtPolyRef* next = (dtPolyRef*)dtAlloc(sizeof(dtPolyRef)*maxPolys*maxFields, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+	float* costs = (float*)dtAlloc(sizeof(float)*maxPolys*maxFields, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+	int* lookup = (int*)dtAlloc(sizeof(int)*lookupSize*maxFields, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+	dtTileRef* tiles = (dtTileRef*)dtAlloc(sizeof(dtTileRef)*maxTiles*maxFields, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+
+	// Assign the blocks to the first field so purge can free partial allocations.
+	m_fields[0].m_polys = polys;
+	m_fields[0].m_next = next;
+	m_fields[0].m_costs = costs;
+	m_fields[0].m_lookup = lookup;
+	m_fields[0].m_tiles = tiles;
+
+	m_tileStamps = (unsigned int*)dtAlloc(sizeof(unsigned int)*nav->getMaxTiles(), DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+
+	if (!polys || !next || !costs || !lookup || !tiles || !m_tileStamps)
+	{
+		purge();
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+	}
+	memset(m_tileStamps, 0, sizeof(unsigned int)*nav->getMaxTiles());
+
+	for (int i = 0; i < maxFields; ++i)
+	{
+		dtFlowField& field = m_fields[i];
+		field.m_polys = &polys[i*maxPolys];
+		field.m_next = &next[i*maxPolys];
+		field.m_costs = &costs[i*maxPolys];
+		field.m_lookup = &lookup[i*lookupSize];
+		field.m_lookupMask = lookupSize-1;
+		field.m_tiles = &tiles[i*maxTiles];
+	}
+
+	m_nav = nav;
+	m_maxPolys = maxPolys;
+	m_radius = radius;
+	m_tick = 0;
+
+	clear();
+	resetStats();
+
+	return DT_SUCCESS;
+}
+
+void dtFlowFieldCache::clear()
+{
+	for (int i = 0; i < m_maxFields; ++i)
+	{
+		m_fields[i].m_goalRef = 0;
+		m_fields[i].m_polyCount = 0;
+		m_fields[i].m_tileCount = 0;
+	}
+	m_fieldCount = 0;
+}
+
+void dtFlowFieldCache::removeField(dtFlowField& field)
+{
+	if (!field.m_goalRef)
+		return;
+	field.m_goalRef = 0;
+	field.m_polyCount = 0;
+	field.m_tileCount = 0;
+	m_fieldCount--;
+}
+
+bool dtFlowFieldCache::validate(const dtFlowField& field) const
+{
+	for (int i = 0; i < field.m_tileCount; ++i)
+	{
+		if (!m_nav->getTileByRef(field.m_tiles[i]))
+			return false;
+	}
+	return true;
+}
+
+dtStatus dtFlowFieldCache::buildField(dtFlowField& field, dtPolyRef goalRef, const float* goalPos,
+									  const dtQueryFilter* filter, unsigned int filterHash)
+{
+	int npolys = 0;
+	dtStatus status = m_query->findFlowField(goalRef, goalPos, m_radius, filter,
+											 field.m_polys, field.m_next, field.m_costs,
+											 &npolys, m_maxPolys);
+	if (dtStatusFailed(status))
+		return status;
+
+	// Index the polygons.
+	const int lookupSize = field.m_lookupMask+1;
+	for (int i = 0; i < lookupSize; ++i)
+		field.m_lookup[i] = -1;
+	for (int i = 0; i < npolys; ++i)
+	{
+		unsigned int h = hashPolyRef(field.m_polys[i]) & (unsigned int)field.m_lookupMask;
+		while (field.m_lookup[h] != -1)
+			h = (h+1) & (unsigned int)field.m_lookupMask;
+		field.m_lookup[h] = i;
+	}
+
+	// Collect the tiles and their bounds.
+	m_tick++;
+	if (!m_tick)
+	{
+		memset(m_tileStamps, 0, sizeof(unsigned int)*m_nav->getMaxTiles());
+		m_tick = 1;
+	}
+
+	field.m_tileCount = 0;
+	for (int i = 0; i < npolys; ++i)
+	{
+		const dtMeshTile* tile = 0;
+		const dtPoly* poly = 0;
+		m_nav->getTileAndPolyByRefUnsafe(field.m_polys[i], &tile, &poly);
+		const int tileIndex = (int)m_nav->decodePolyIdTile(field.m_polys[i]);
+		if (m_tileStamps[tileIndex] == m_tick)
+			continue;
+		m_tileStamps[tileIndex] = m_tick;
+
+		const int x = tile->header->x;
+		const int y = tile->header->y;
+		if (field.m_tileCount == 0)
+		{
+			field.m_tileMin[0] = field.m_tileMax[0] = x;
+			field.m_tileMin[1] = field.m_tileMax[1] = y;
+		}
+		else
+		{
+			field.m_tileMin[0] = dtMin(field.m_tileMin[0], x);
+			field.m_tileMin[1] = dtMin(field.m_tileMin[1], y);
+			field.m_tileMax[0] = dtMax(field.m_tileMax[0], x);
+			field.m_tileMax[1] = dtMax(field.m_tileMax[1], y);
+		}
+		field.m_tiles[field.m_tileCount++] = m_nav->getTileRef(tile);
+	}
+
+	field.m_goalRef = goalRef;
+	dtVcopy(field.m_goalPos, goalPos);
+	field.m_filterHash = filterHash;
+	field.m_polyCount = npolys;
+
+	return status;
+}
+
+dtStatus dtFlowFieldCache::getField(dtPolyRef goalRef, const float* goalPos, const dtQueryFilter* filter,
+									const dtFlowField** result)
+{
+	if (!result)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	*result = 0;
+
+	if (!m_fields || !goalRef || !goalPos || !filter)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	const unsigned int filterHash = dtPathCache::hashFilter(filter);
+
+	// The cache is expected to be small, so a linear search is used.
+	dtFlowField* slot = 0;
+	for (int i = 0; i < m_maxFields; ++i)
+	{
+		dtFlowField& field = m_fields[i];
+		if (field.m_goalRef != goalRef || field.m_filterHash != filterHash)
+			continue;
+
+		if (validate(field))
+		{
+			field.m_lastUsed = ++m_tick;
+			m_hitCount++;
+			*result = &field;
+			return DT_SUCCESS;
+		}
+
+		removeField(field);
+		m_invalidCount++;
+		slot = &field;
+		break;
+	}
+
+	if (!slot)
+	{
+		// Use a free field, or evict the least recently used one.
+		dtFlowField* lru = 0;
+		for (int i = 0; i < m_maxFields && !slot; ++i)
+		{
+			dtFlowField& field = m_fields[i];
+			if (!field.m_goalRef)
+				slot = &field;
+			else if (!lru || field.m_lastUsed < lru->m_lastUsed)
+				lru = &field;
+		}
+		if (!slot)
+		{
+			removeField(*lru);
+			m_evictCount++;
+			slot = lru;
+		}
+	}
+
+	dtStatus status = buildField(*slot, goalRef, goalPos, filter, filterHash);
+	if (dtStatusFailed(status))
+		return status;
+
+	slot->m_lastUsed = ++m_tick;
+	m_fieldCount++;
+	m_buildCount++;
+	*result = slot;
+
+	return status;
+}
+
+void dtFlowFieldCache::invalidateTile(const int tx, const int ty)
+{
+	for (int i = 0; i < m_maxFields; ++i)
+	{
+		dtFlowField& field = m_fields[i];
+		if (!field.m_goalRef)
+			continue;
+		if (tx < field.m_tileMin[0]-1 || tx > field.m_tileMax[0]+1 ||
+			ty < field.m_tileMin[1]-1 || ty > field.m_tileMax[1]+1)
+			continue;
+		removeField(field);
+		m_invalidCount++;
+	}
+}
+
+void dtFlowFieldCache::invalidatePoly(dtPolyRef ref)
+{
+	for (int i = 0; i < m_maxFields; ++i)
+	{
+		dtFlowField& field = m_fields[i];
+		if (field.m_goalRef && field.findPoly(ref) != -1)
+		{
+			removeField(field);
+			m_invalidCount++;
+		}
+	}
+}
+
+void dtFlowFieldCache::getStats(dtFlowFieldCacheStats* stats) const
+{
+	if (!stats)
+		return;
+	stats->fieldCount = m_fieldCount;
+	stats->maxFields = m_maxFields;
+	stats->hitCount = m_hitCount;
+	stats->buildCount = m_buildCount;
+	stats->invalidCount = m_invalidCount;
+	stats->evictCount = m_evictCount;
+}
+
+void dtFlowFieldCache::resetStats()
+{
+	m_hitCount = 0;
+	m_buildCount = 0;
+	m_invalidCount = 0;
+	m_evictCount = 0;
+}
@@ -18,6 +18,7 @@
 
 #include <float.h>
 #include <string.h>
+#include <stdlib.h>
 #include <stdio.h>
 #include "DetourNavMesh.h"
 #include "DetourNode.h"
@@ -27,6 +28,11 @@
 #include "DetourAssert.h"
 #include <new>
 
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
 
 inline bool overlapSlabs(const float* amin, const float* amax,
 						 const float* bmin, const float* bmax,
@@ -111,6 +117,596 @@ static void calcSlabEndPoints(const float* va, const float* vb, float* bmin, flo
 	}
 }
 
+static int compareBorderEdges(const void* va, const void* vb)
+{
+	const dtBorderEdge* a = (const dtBorderEdge*)va;
+	const dtBorderEdge* b = (const dtBorderEdge*)vb;
+	if (a->side != b->side)
+		return (int)a->side - (int)b->side;
+	if (a->bmin[0] < b->bmin[0])
+		return -1;
+	if (a->bmin[0] > b->bmin[0])
+		return 1;
+	return 0;
+}
+
+// Builds the tile's portal edge index used by findConnectingPolys() and connectExtLinks().
+// Returns false if the index could not be allocated.
+static bool buildBorderEdges(dtMeshTile* tile, const dtMeshHeader* header)
+{
+	tile->borderEdges = 0;
+	memset(tile->borderEdgeStart, 0, sizeof(tile->borderEdgeStart));
+	
+	int nedges = 0;
+	for (int i = 0; i < header->polyCount; ++i)
+	{
+		const dtPoly* poly = &tile->polys[i];
+		for (int j = 0; j < poly->vertCount; ++j)
+		{
+			if ((poly->neis[j] & DT_EXT_LINK) && (poly->neis[j] & 0xff) < 8)
+				nedges++;
+		}
+	}
+	if (!nedges)
+		return true;
+	
+	dtBorderEdge* edges = (dtBorderEdge*)dtAlloc(sizeof(dtBorderEdge)*nedges, DT_ALLOC_PERM, DT_ALLOC_TAG_NAVMESH);
+	if (!edges)
+		return false;
+	
+	int n = 0;
+	for (int i = 0; i < header->polyCount; ++i)
+	{
+		const dtPoly* poly = &tile->polys[i];
+		const int nv = poly->vertCount;
+		for (int j = 0; j < nv; ++j)
+		{
+			if ((poly->neis[j] & DT_EXT_LINK) == 0)
+				continue;
+			const int side = (int)(poly->neis[j] & 0xff);
+			if (side >= 8)
+				continue;
+			const float* va = &tile->verts[poly->verts[j]*3];
+			const float* vb = &tile->verts[poly->verts[(j+1) % nv]*3];
+			dtBorderEdge& e = edges[n++];
+			calcSlabEndPoints(va, vb, e.bmin, e.bmax, side);
+			e.pos = getSlabCoord(va, side);
+			e.poly = (unsigned int)i;
+			e.edge = (unsigned char)j;
+			e.side = (unsigned char)side;
+			tile->borderEdgeStart[side+1]++;
+		}
+	}
+	
+	qsort(edges, nedges, sizeof(dtBorderEdge), compareBorderEdges);
+	
+	for (int i = 0; i < 8; ++i)
+		tile->borderEdgeStart[i+1] += tile->borderEdgeStart[i];
+	
+	// The running maximum of the edge ends lets a lookup stop walking back
+	// as soon as no earlier edge can reach the query segment.
+	for (int i = 0; i < 8; ++i)
+	{
+		float reach = -FLT_MAX;
+		for (int j = tile->borderEdgeStart[i]; j < tile->borderEdgeStart[i+1]; ++j)
+		{
+			reach = dtMax(reach, edges[j].bmax[0]);
+			edges[j].reach = reach;
+		}
+	}
+	
+	tile->borderEdges = edges;
+	return true;
+}
+
+// Gets the group of the off-mesh connection index that holds connections which land
+// on the specified side of the tile. (0xff for connections that land inside the tile.)
+inline int offMeshConGroup(const unsigned char side)
+{
+	return side < 8 ? (int)side : 8;
+}
+
+// Builds the tile's off-mesh connection index used by connectExtOffMeshLinks() and
+// unconnectLinks(). Returns false if the index could not be allocated.
+static bool buildOffMeshConIndex(dtMeshTile* tile, const dtMeshHeader* header)
+{
+	tile->offMeshConIndex = 0;
+	memset(tile->offMeshConStart, 0, sizeof(tile->offMeshConStart));
+	
+	const int ncons = header->offMeshConCount;
+	if (!ncons)
+		return true;
+	
+	unsigned short* index = (unsigned short*)dtAlloc(sizeof(unsigned short)*ncons, DT_ALLOC_PERM, DT_ALLOC_TAG_NAVMESH);
+	if (!index)
+		return false;
+	
+	// Counting sort, so each group keeps the connection order.
+	int* start = tile->offMeshConStart;
+	for (int i = 0; i < ncons; ++i)
+		start[offMeshConGroup(tile->offMeshCons[i].side)+1]++;
+	for (int i = 0; i < 9; ++i)
+		start[i+1] += start[i];
+	
+	int next[9];
+	memcpy(next, start, sizeof(next));
+	for (int i = 0; i < ncons; ++i)
+		index[next[offMeshConGroup(tile->offMeshCons[i].side)]++] = (unsigned short)i;
+	
+	tile->offMeshConIndex = index;
+	return true;
+}
+
+// Builds the tile's polygon grid used by nearest polygon queries.
+// Returns false if the grid could not be allocated.
+static bool buildPolyGrid(dtMeshTile* tile, const dtMeshHeader* header)
+{
+	tile->polyGrid = 0;
+	
+	// The grid holds the same polygons the bounding volume tree does, so that
+	// queries using the grid consider exactly the same candidates.
+	int nitems = 0;
+	if (tile->bvTree)
+	{
+		for (int i = 0; i < header->bvNodeCount; ++i)
+		{
+			if (tile->bvTree[i].i >= 0)
+				nitems++;
+		}
+	}
+	else
+	{
+		for (int i = 0; i < header->polyCount; ++i)
+		{
+			if (tile->polys[i].getType() != DT_POLYTYPE_OFFMESH_CONNECTION)
+				nitems++;
+		}
+	}
+	if (!nitems)
+		return true;
+
+	const float tw = header->bmax[0] - header->bmin[0];
+	const float th = header->bmax[2] - header->bmin[2];
+	static const int MAX_GRID_SIZE = 64;
+	const int size = dtMin((int)dtMathCeilf(dtMathSqrtf((float)nitems)), MAX_GRID_SIZE);
+	float cs = dtMax(tw, th) / (float)size;
+	if (cs <= 0.0f)
+		cs = 1.0f;
+	const int width = dtClamp((int)dtMathCeilf(tw / cs), 1, size);
+	const int height = dtClamp((int)dtMathCeilf(th / cs), 1, size);
+	const int ncells = width * height;
+	
+	// The item bounds are padded so that rounding in the closest point 
+	// calculations can never put a result outside of them.
+	const float pad = 0.001f * (1.0f + dtMax(dtMax(tw, th), header->bmax[1] - header->bmin[1]));
+	
+	dtPolyGridItem* items = (dtPolyGridItem*)dtAlloc(sizeof(dtPolyGridItem)*nitems, DT_ALLOC_TEMP);
+	if (!items)
+		return false;
+	
+	dtPolyGrid grid;
+	grid.orig[0] = header->bmin[0];
+	grid.orig[1] = header->bmin[2];
+	grid.cellSize = cs;
+	grid.width = width;
+	grid.height = height;
+	dtVset(grid.bmin, FLT_MAX, FLT_MAX, FLT_MAX);
+	dtVset(grid.bmax, -FLT_MAX, -FLT_MAX, -FLT_MAX);
+	
+	const float qfac = header->bvQuantFactor;
+	float dbuf[DT_MAX_DETAIL_VERTS*3];
+	int n = 0;
+	int nentries = 0;
+	const int count = tile->bvTree ? header->bvNodeCount : header->polyCount;
+	for (int i = 0; i < count; ++i)
+	{
+		int ip = i;
+		if (tile->bvTree)
+		{
+			ip = tile->bvTree[i].i;
+			if (ip < 0)
+				continue;
+		}
+		const dtPoly* poly = &tile->polys[ip];
+		if (!tile->bvTree && poly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION)
+			continue;
+		
+		dtPolyGridItem& item = items[n++];
+		item.index = i;
+		
+		dtVcopy(item.bmin, &tile->verts[poly->verts[0]*3]);
+		dtVcopy(item.bmax, &tile->verts[poly->verts[0]*3]);
+		for (int j = 1; j < poly->vertCount; ++j)
+		{
+			dtVmin(item.bmin, &tile->verts[poly->verts[j]*3]);
+			dtVmax(item.bmax, &tile->verts[poly->verts[j]*3]);
+		}
+		if (poly->getType() == DT_POLYTYPE_GROUND && ip < header->detailMeshCount)
+		{
+			const dtPolyDetail* pd = &tile->detailMeshes[ip];
+			const float* dverts = dtGetDetailVerts(tile, poly, pd, dbuf);
+			for (int j = 0; j < pd->vertCount; ++j)
+			{
+				dtVmin(item.bmin, &dverts[j*3]);
+				dtVmax(item.bmax, &dverts[j*3]);
+			}
+		}
+		for (int j = 0; j < 3; ++j)
+		{
+			item.bmin[j] -= pad;
+			item.bmax[j] += pad;
+		}
+		dtVmin(grid.bmin, item.bmin);
+		dtVmax(grid.bmax, item.bmax);
+		
+		// The cells must also cover the quantized node bounds since those 
+		// decide whether the polygon is a candidate.
+		float cmin[3], cmax[3];
+		dtVcopy(cmin, item.bmin);
+		dtVcopy(cmax, item.bmax);
+		if (tile->bvTree)
+		{
+			const dtBVNode* node = &tile->bvTree[i];
+			cmin[0] = dtMin(cmin[0], header->bmin[0] + node->bmin[0] / qfac - pad);
+			cmin[2] = dtMin(cmin[2], header->bmin[2] + node->bmin[2] / qfac - pad);
+			cmax[0] = dtMax(cmax[0], header->bmin[0] + node->bmax[0] / qfac + pad);
+			cmax[2] = dtMax(cmax[2], header->bmin[2] + node->bmax[2] / qfac + pad);
+		}
+		int x0, z0, x1, z1;
+		dtCalcPolyGridCell(&grid, cmin, x0, z0);
+		dtCalcPolyGridCell(&grid, cmax, x1, z1);
+		item.cmin[0] = (unsigned short)x0;
+		item.cmin[1] = (unsigned short)z0;
+		item.cmax[0] = (unsigned short)x1;
+		item.cmax[1] = (unsigned short)z1;
+		nentries += (x1-x0+1) * (z1-z0+1);
+	}
+	
+	const int itemsSize = dtAlign4(sizeof(dtPolyGridItem)*nitems);
+	const int cellStartSize = dtAlign4(sizeof(int)*(ncells+1));
+	const int cellItemsSize = dtAlign4(sizeof(int)*nentries);
+	const int headerSize = dtAlign4(sizeof(dtPolyGrid));
+	unsigned char* mem = (unsigned char*)dtAlloc(headerSize + itemsSize + cellStartSize + cellItemsSize, DT_ALLOC_PERM, DT_ALLOC_TAG_NAVMESH);
+	if (!mem)
+	{
+		dtFree(items);
+		return false;
+	}
+	
+	dtPolyGrid* pg = (dtPolyGrid*)mem;
+	*pg = grid;
+	pg->itemCount = nitems;
+	pg->items = (dtPolyGridItem*)(mem + headerSize);
+	pg->cellStart = (int*)(mem + headerSize + itemsSize);
+	pg->cellItems = (int*)(mem + headerSize + itemsSize + cellStartSize);
+	memcpy(pg->items, items, sizeof(dtPolyGridItem)*nitems);
+	dtFree(items);
+	
+	// Bucket the items by cell.
+	memset(pg->cellStart, 0, sizeof(int)*(ncells+1));
+	for (int i = 0; i < nitems; ++i)
+	{
+		const dtPolyGridItem& item = pg->items[i];
+		for (int z = item.cmin[1]; z <= item.cmax[1]; ++z)
+			for (int x = item.cmin[0]; x <= item.cmax[0]; ++x)
+				pg->cellStart[x + z*width + 1]++;
+	}
+	for (int i = 0; i < ncells; ++i)
+		pg->cellStart[i+1] += pg->cellStart[i];
+	for (int i = 0; i < nitems; ++i)
+	{
+		const dtPolyGridItem& item = pg->items[i];
+		for (int z = item.cmin[1]; z <= item.cmax[1]; ++z)
+			for (int x = item.cmin[0]; x <= item.cmax[0]; ++x)
+				pg->cellItems[pg->cellStart[x + z*width]++] = i;
+	}
+	for (int i = ncells; i > 0; --i)
+		pg->cellStart[i] = pg->cellStart[i-1];
+	pg->cellStart[0] = 0;
+	
+	tile->polyGrid = pg;
+	return true;
+}
+
+// Gets a vertex of a detail triangle, decoding it into buf for compact tiles.
+inline const float* getDetailTriVert(const dtMeshTile* tile, const dtPoly* poly,
+									 const dtPolyDetail* pd, const unsigned char index, float* buf)
+{
+	if (index < poly->vertCount)
+		return &tile->verts[poly->verts[index]*3];
+	const int i = pd->vertBase + index - poly->vertCount;
+	if (tile->detailVerts)
+		return &tile->detailVerts[i*3];
+	dtDecodeDetailVert(tile, poly, &tile->detailQuantVerts[i*3], buf);
+	return buf;
+}
+
+// Gets the range of height grid cells covered by the bounds of a detail triangle.
+static void calcHeightGridTriCells(const dtPolyHeightGrid* grid, const float* const* v, const float pad,
+								   int& x0, int& z0, int& x1, int& z1)
+{
+	float bmin[3], bmax[3];
+	dtVcopy(bmin, v[0]);
+	dtVcopy(bmax, v[0]);
+	dtVmin(bmin, v[1]);
+	dtVmax(bmax, v[1]);
+	dtVmin(bmin, v[2]);
+	dtVmax(bmax, v[2]);
+	bmin[0] -= pad;
+	bmin[2] -= pad;
+	bmax[0] += pad;
+	bmax[2] += pad;
+	dtCalcHeightGridCell(grid, bmin, x0, z0);
+	dtCalcHeightGridCell(grid, bmax, x1, z1);
+}
+
+// Builds the tile's detail mesh height grids used by dtGetDetailHeight().
+// Returns false if the grids could not be allocated.
+static bool buildHeightGrid(dtMeshTile* tile, const dtMeshHeader* header)
+{
+	tile->heightGrid = 0;
+	
+	const int npolys = header->detailMeshCount;
+	if (!npolys)
+		return true;
+	
+	// Polygons with few detail triangles are faster to search without a grid.
+	static const int MIN_GRID_TRIS = 8;
+	static const int MAX_GRID_SIZE = 16;
+	
+	dtPolyHeightGrid* grids = (dtPolyHeightGrid*)dtAlloc(sizeof(dtPolyHeightGrid)*npolys, DT_ALLOC_TEMP);
+	if (!grids)
+		return false;
+	float* pads = (float*)dtAlloc(sizeof(float)*npolys, DT_ALLOC_TEMP);
+	if (!pads)
+	{
+		dtFree(grids);
+		return false;
+	}
+	memset(grids, 0, sizeof(dtPolyHeightGrid)*npolys);
+	
+	float buf[3*3];
+	int ncells = 0;
+	int nentries = 0;
+	for (int i = 0; i < npolys; ++i)
+	{
+		const dtPoly* poly = &tile->polys[i];
+		const dtPolyDetail* pd = &tile->detailMeshes[i];
+		dtPolyHeightGrid& grid = grids[i];
+		grid.cellBase = ncells;
+		if (poly->getType() != DT_POLYTYPE_GROUND || pd->triCount < MIN_GRID_TRIS)
+			continue;
+		
+		float bmin[3], bmax[3];
+		dtVcopy(bmin, &tile->verts[poly->verts[0]*3]);
+		dtVcopy(bmax, &tile->verts[poly->verts[0]*3]);
+		for (int j = 1; j < poly->vertCount; ++j)
+		{
+			dtVmin(bmin, &tile->verts[poly->verts[j]*3]);
+			dtVmax(bmax, &tile->verts[poly->verts[j]*3]);
+		}
+		const float ex = bmax[0] - bmin[0];
+		const float ez = bmax[2] - bmin[2];
+		const int size = dtClamp((int)dtMathCeilf(dtMathSqrtf(pd->triCount * 0.5f)), 2, MAX_GRID_SIZE);
+		const float cs = dtMax(ex, ez) / (float)size;
+		if (cs <= 0.0f)
+			continue;
+		
+		grid.orig[0] = bmin[0];
+		grid.orig[1] = bmin[2];
+		grid.cellSize = cs;
+		grid.width = (unsigned char)dtClamp((int)dtMathCeilf(ex / cs), 1, size);
+		grid.height = (unsigned char)dtClamp((int)dtMathCeilf(ez / cs), 1, size);
+		ncells += grid.width * grid.height;
+		
+		// The triangle bounds are padded by more than the tolerance of 
+		// dtClosestHeightPointTriangle() and the rounding of the positions.
+		pads[i] = 0.001f * dtMax(ex, ez) + 0.00001f * (1.0f + dtMax(dtAbs(bmin[0]), dtAbs(bmin[2])));
+		
+		for (int j = 0; j < pd->triCount; ++j)
+		{
+			const unsigned char* t = &tile->detailTris[(pd->triBase+j)*4];
+			const float* v[3];
+			for (int k = 0; k < 3; ++k)
+				v[k] = getDetailTriVert(tile, poly, pd, t[k], &buf[k*3]);
+			int x0, z0, x1, z1;
+			calcHeightGridTriCells(&grid, v, pads[i], x0, z0, x1, z1);
+			nentries += (x1-x0+1) * (z1-z0+1);
+		}
+	}
+	
+	const int headerSize = dtAlign4(sizeof(dtHeightGrid));
+	const int polysSize = dtAlign4(sizeof(dtPolyHeightGrid)*npolys);
+	const int cellStartSize = dtAlign4(sizeof(int)*(ncells+1));
+	const int cellTrisSize = dtAlign4(nentries);
+	unsigned char* mem = (unsigned char*)dtAlloc(headerSize + polysSize + cellStartSize + cellTrisSize, DT_ALLOC_PERM, DT_ALLOC_TAG_NAVMESH);
+	if (!mem)
+	{
+		dtFree(pads);
+		dtFree(grids);
+		return false;
+	}
+	
+	dtHeightGrid* hg = (dtHeightGrid*)mem;
+	hg->polys = (dtPolyHeightGrid*)(mem + headerSize);
+	hg->cellStart = (int*)(mem + headerSize + polysSize);
+	hg->cellTris = mem + headerSize + polysSize + cellStartSize;
+	memcpy(hg->polys, grids, sizeof(dtPolyHeightGrid)*npolys);
+	dtFree(grids);
+	
+	// Bucket the triangles by cell, keeping them in triangle order so that a
+	// lookup finds the same triangle as a search of all the triangles.
+	memset(hg->cellStart, 0, sizeof(int)*(ncells+1));
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		for (int i = 0; i < npolys; ++i)
+		{
+			const dtPolyHeightGrid& grid = hg->polys[i];
+			if (!grid.width)
+				continue;
+			const dtPoly* poly = &tile->polys[i];
+			const dtPolyDetail* pd = &tile->detailMeshes[i];
+			for (int j = 0; j < pd->triCount; ++j)
+			{
+				const unsigned char* t = &tile->detailTris[(pd->triBase+j)*4];
+				const float* v[3];
+				for (int k = 0; k < 3; ++k)
+					v[k] = getDetailTriVert(tile, poly, pd, t[k], &buf[k*3]);
+				int x0, z0, x1, z1;
+				calcHeightGridTriCells(&grid, v, pads[i], x0, z0, x1, z1);
+				for (int z = z0; z <= z1; ++z)
+				{
+					for (int x = x0; x <= x1; ++x)
+					{
+						const int cell = grid.cellBase + x + z*grid.width;
+						if (pass == 0)
+							hg->cellStart[cell+1]++;
+						else
+							hg->cellTris[hg->cellStart[cell]++] = (unsigned char)j;
+					}
+				}
+			}
+		}
+		if (pass == 0)
+		{
+			for (int i = 0; i < ncells; ++i)
+				hg->cellStart[i+1] += hg->cellStart[i];
+		}
+	}
+	for (int i = ncells; i > 0; --i)
+		hg->cellStart[i] = hg->cellStart[i-1];
+	hg->cellStart[0] = 0;
+	dtFree(pads);
+	
+	tile->heightGrid = hg;
+	return true;
+}
+
+bool dtGetDetailHeight(const dtMeshTile* tile, const dtPoly* poly, const float* pos, float* height)
+{
+	const unsigned int ip = (unsigned int)(poly - tile->polys);
+	const dtPolyDetail* pd = &tile->detailMeshes[ip];
+	
+	const dtPolyHeightGrid* grid = tile->heightGrid ? &tile->heightGrid->polys[ip] : 0;
+	if (grid && grid->width)
+	{
+		int cx, cz;
+		dtCalcHeightGridCell(grid, pos, cx, cz);
+		const int cell = grid->cellBase + cx + cz*grid->width;
+		const int* cellStart = tile->heightGrid->cellStart;
+		float buf[3*3];
+		for (int i = cellStart[cell]; i < cellStart[cell+1]; ++i)
+		{
+			const unsigned char* t = &tile->detailTris[(pd->triBase + tile->heightGrid->cellTris[i])*4];
+			const float* v[3];
+			for (int k = 0; k < 3; ++k)
+				v[k] = getDetailTriVert(tile, poly, pd, t[k], &buf[k*3]);
+			if (dtClosestHeightPointTriangle(pos, v[0], v[1], v[2], *height))
+				return true;
+		}
+		return false;
+	}
+	
+	float buf[DT_MAX_DETAIL_VERTS*3];
+	const float* dverts = dtGetDetailVerts(tile, poly, pd, buf);
+	for (int j = 0; j < pd->triCount; ++j)
+	{
+		const unsigned char* t = &tile->detailTris[(pd->triBase+j)*4];
+		const float* v[3];
+		for (int k = 0; k < 3; ++k)
+		{
+			if (t[k] < poly->vertCount)
+				v[k] = &tile->verts[poly->verts[t[k]]*3];
+			else
+				v[k] = &dverts[(t[k]-poly->vertCount)*3];
+		}
+		if (dtClosestHeightPointTriangle(pos, v[0], v[1], v[2], *height))
+			return true;
+	}
+	return false;
+}
+
+/// @par
+///
+/// The distances of the polygons on the xz-plane are found in batches with
+/// dtDistancePtPolysSqr2D().  They are lower bounds of the measured distances, so a polygon
+/// that is not under the point and is already too far on the plane is skipped without
+/// looking up its detail height.
+int dtFindNearestPolyInList(const dtMeshTile* tile, const dtPoly* const* polys, const int count,
+							const float* center, float* nearestDistSqr, float* nearestPt)
+{
+	static const int BATCH_SIZE = 16;
+	float verts[BATCH_SIZE*DT_VERTS_PER_POLYGON*3];
+	int nverts[BATCH_SIZE];
+	float distSqr[BATCH_SIZE];
+	int edges[BATCH_SIZE];
+	float edgeT[BATCH_SIZE];
+
+	const float climb = tile->header->walkableClimb;
+	int nearest = -1;
+
+	for (int base = 0; base < count; base += BATCH_SIZE)
+	{
+		const int n = dtMin(BATCH_SIZE, count - base);
+		for (int i = 0; i < n; ++i)
+		{
+			const dtPoly* poly = polys[base+i];
+			nverts[i] = poly->vertCount;
+			for (int j = 0; j < poly->vertCount; ++j)
+				dtVcopy(&verts[(i*DT_VERTS_PER_POLYGON+j)*3], &tile->verts[poly->verts[j]*3]);
+		}
+		dtDistancePtPolysSqr2D(center, verts, nverts, n, DT_VERTS_PER_POLYGON, distSqr, edges, edgeT);
+
+		for (int i = 0; i < n; ++i)
+		{
+			const dtPoly* poly = polys[base+i];
+			const float* v = &verts[i*DT_VERTS_PER_POLYGON*3];
+			float closest[3];
+			float d;
+
+			if (poly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION)
+			{
+				// Off-mesh connections don't have detail polygons.
+				const float d0 = dtVdist(center, &v[0]);
+				const float d1 = dtVdist(center, &v[3]);
+				dtVlerp(closest, &v[0], &v[3], d0 / (d0+d1));
+				d = dtVdistSqr(center, closest);
+			}
+			else if (edges[i] == -1)
+			{
+				// If a point is directly over a polygon and closer than
+				// climb height, favor that instead of straight line nearest point.
+				dtVcopy(closest, center);
+				float h;
+				if (dtGetDetailHeight(tile, poly, closest, &h))
+					closest[1] = h;
+				d = dtAbs(center[1] - closest[1]) - climb;
+				d = d > 0 ? d*d : 0;
+			}
+			else
+			{
+				if (distSqr[i] >= *nearestDistSqr)
+					continue;
+				const int e = edges[i];
+				dtVlerp(closest, &v[e*3], &v[((e+1)%nverts[i])*3], edgeT[i]);
+				float h;
+				if (dtGetDetailHeight(tile, poly, closest, &h))
+					closest[1] = h;
+				d = dtVdistSqr(center, closest);
+			}
+
+			if (d < *nearestDistSqr)
+			{
+				dtVcopy(nearestPt, closest);
+				*nearestDistSqr = d;
+				nearest = base + i;
+			}
+		}
+	}
+
+	return nearest;
+}
+
 inline int computeTileHash(int x, int y, const int mask)
 {
 	const unsigned int h1 = 0x8da6b343; // Large multiplicative constants;
@@ -134,10 +730,61 @@ inline void freeLink(dtMeshTile* tile, unsigned int link)
 	tile->linksFreeList = link;
 }
 
+// Orders the memory accesses before the barrier ahead of those after it, for
+// the compiler and the processor.
+inline void memoryBarrier()
+{
+#if defined(_WIN32)
+	MemoryBarrier();
+#else
+	__sync_synchronize();
+#endif
+}
+
+inline bool tryClaim(volatile long* value)
+{
+#if defined(_WIN32)
+	return InterlockedCompareExchange((volatile LONG*)value, 1, 0) == 0;
+#else
+	return __sync_bool_compare_and_swap(value, 0L, 1L);
+#endif
+}
+
+// Adds the link to the front of the polygon's link list.  The link is complete
+// before it is published, so a concurrent read sees either the old or the new list.
+inline void publishLink(dtMeshTile* tile, dtPoly* poly, unsigned int link)
+{
+	tile->links[link].next = poly->firstLink;
+	memoryBarrier();
+	poly->firstLink = link;
+}
+
+// A reader slot.  Padded to a cache line so that readers on different threads
+// do not share one.
+struct dtNavMeshReader
+{
+	volatile long used;				// Non-zero while the slot is acquired.
+	volatile unsigned int epoch;	// The epoch the current read started in, or zero if idle.
+	char pad[64 - sizeof(long) - sizeof(unsigned int)];
+};
+
+struct dtRetiredTile
+{
+	dtMeshTile* tile;
+	unsigned int epoch;				// The epoch the tile was removed in.
+};
+
+struct dtRetiredLink
+{
+	dtTileRef tileRef;				// The tile that owns the link.
+	unsigned int link;
+	unsigned int epoch;				// The epoch the link was removed in.
+};
+
 
 dtNavMesh* dtAllocNavMesh()
 {
-	void* mem = dtAlloc(sizeof(dtNavMesh), DT_ALLOC_PERM);
+	void* mem = dtAlloc(sizeof(dtNavMesh), DT_ALLOC_PERM, DT_ALLOC_TAG_NAVMESH);
 	if (!mem) return 0;
 	return new(mem) dtNavMesh;
 }
@@ -153,6 +800,29 @@ void dtFreeNavMesh(dtNavMesh* navmesh)
 	dtFree(navmesh);
 }
 
+bool dtIsNavMeshVersion(const int version)
+{
+	return version == DT_NAVMESH_VERSION || version == DT_NAVMESH_COMPACT_VERSION;
+}
+
+/// @par
+///
+/// The detail vertices of compact tile data are stored as unsigned shorts,
+/// preceded by the origin and step used to decode them. [(x, y, z) * 2]
+/// The x and y values use 16 bits and the z value 15 bits.  Vertices on an
+/// edge of their polygon set #DT_DETAIL_QUANT_EDGE in z, with the edge index
+/// in the three bits below it, and store the position along the edge in x.
+int dtGetDetailVertsSize(const int version, const int detailVertCount)
+{
+	if (version == DT_NAVMESH_COMPACT_VERSION)
+	{
+		if (!detailVertCount)
+			return 0;
+		return dtAlign4(sizeof(float)*6 + sizeof(unsigned short)*3*detailVertCount);
+	}
+	return dtAlign4(sizeof(float)*3*detailVertCount);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 
 /**
@@ -193,7 +863,18 @@ dtNavMesh::dtNavMesh() :
 	m_tileLutMask(0),
 	m_posLookup(0),
 	m_nextFree(0),
-	m_tiles(0)
+	m_tiles(0),
+	m_version(1),
+	m_polyGrids(false),
+	m_heightGrids(false),
+	m_readers(0),
+	m_maxReaders(0),
+	m_epoch(1),
+	m_retiredTiles(0),
+	m_retiredTileCount(0),
+	m_retiredLinks(0),
+	m_retiredLinkCount(0),
+	m_retiredLinkCap(0)
 {
 #ifndef DT_POLYREF64
 	m_saltBits = 0;
@@ -210,6 +891,19 @@ dtNavMesh::~dtNavMesh()
 {
 	for (int i = 0; i < m_maxTiles; ++i)
 	{
+		if (m_tiles[i].flags & DT_TILE_SHARED_DATA)
+		{
+			dtFree(m_tiles[i].polys);
+			m_tiles[i].polys = 0;
+		}
+		dtFree(m_tiles[i].borderEdges);
+		m_tiles[i].borderEdges = 0;
+		dtFree(m_tiles[i].offMeshConIndex);
+		m_tiles[i].offMeshConIndex = 0;
+		dtFree(m_tiles[i].polyGrid);
+		m_tiles[i].polyGrid = 0;
+		dtFree(m_tiles[i].heightGrid);
+		m_tiles[i].heightGrid = 0;
 		if (m_tiles[i].flags & DT_TILE_FREE_DATA)
 		{
 			dtFree(m_tiles[i].data);
@@ -219,8 +913,43 @@ dtNavMesh::~dtNavMesh()
 	}
 	dtFree(m_posLookup);
 	dtFree(m_tiles);
+	dtFree(m_readers);
+	dtFree(m_retiredTiles);
+	dtFree(m_retiredLinks);
 }
 		
+/// @par
+///
+/// The tile data of a mapped or caller owned tile is reported at its data size, 
+/// though it may not be held in native heap memory.  Removed tiles still in use
+/// by concurrent reads are included in the memory but not in the tile count.
+void dtNavMesh::getMemoryStats(dtNavMeshMemoryStats* stats) const
+{
+	if (!stats)
+		return;
+	
+	memset(stats, 0, sizeof(dtNavMeshMemoryStats));
+	stats->meshBytes = sizeof(dtNavMesh) + dtAllocSize(m_tiles) + dtAllocSize(m_posLookup);
+	
+	for (int i = 0; i < m_maxTiles; ++i)
+	{
+		const dtMeshTile& tile = m_tiles[i];
+		if (!tile.header)
+			continue;
+		
+		if (!(tile.flags & DT_TILE_RETIRED))
+			stats->tileCount++;
+		if (tile.flags & DT_TILE_FREE_DATA)
+			stats->tileDataBytes += dtAllocSize(tile.data);
+		else
+			stats->externalTileDataBytes += (size_t)tile.dataSize;
+		if (tile.flags & DT_TILE_SHARED_DATA)
+			stats->tileCopyBytes += dtAllocSize(tile.polys);
+		stats->tileCopyBytes += dtAllocSize(tile.borderEdges) + dtAllocSize(tile.offMeshConIndex);
+		stats->gridBytes += dtAllocSize(tile.polyGrid) + dtAllocSize(tile.heightGrid);
+	}
+}
+
 dtStatus dtNavMesh::init(const dtNavMeshParams* params)
 {
 	memcpy(&m_params, params, sizeof(dtNavMeshParams));
@@ -228,16 +957,22 @@ dtStatus dtNavMesh::init(const dtNavMeshParams* params)
 	m_tileWidth = params->tileWidth;
 	m_tileHeight = params->tileHeight;
 	
+#ifdef DT_POLYREF64
+	// The tile and polygon indices must fit their fixed number of bits.
+	if ((unsigned int)params->maxTiles > (1u<<DT_TILE_BITS) || (unsigned int)params->maxPolys > (1u<<DT_POLY_BITS))
+		return DT_FAILURE | DT_INVALID_PARAM;
+#endif
+
 	// Init tiles
 	m_maxTiles = params->maxTiles;
 	m_tileLutSize = dtNextPow2(params->maxTiles/4);
 	if (!m_tileLutSize) m_tileLutSize = 1;
 	m_tileLutMask = m_tileLutSize-1;
 	
-	m_tiles = (dtMeshTile*)dtAlloc(sizeof(dtMeshTile)*m_maxTiles, DT_ALLOC_PERM);
+	m_tiles = (dtMeshTile*)dtAlloc(sizeof(dtMeshTile)*m_maxTiles, DT_ALLOC_PERM, DT_ALLOC_TAG_NAVMESH);
 	if (!m_tiles)
 		return DT_FAILURE | DT_OUT_OF_MEMORY;
-	m_posLookup = (dtMeshTile**)dtAlloc(sizeof(dtMeshTile*)*m_tileLutSize, DT_ALLOC_PERM);
+	m_posLookup = (dtMeshTile**)dtAlloc(sizeof(dtMeshTile*)*m_tileLutSize, DT_ALLOC_PERM, DT_ALLOC_TAG_NAVMESH);
 	if (!m_posLookup)
 		return DT_FAILURE | DT_OUT_OF_MEMORY;
 	memset(m_tiles, 0, sizeof(dtMeshTile)*m_maxTiles);
@@ -270,7 +1005,7 @@ dtStatus dtNavMesh::init(unsigned char* data, const int dataSize, const int flag
 	dtMeshHeader* header = (dtMeshHeader*)data;
 	if (header->magic != DT_NAVMESH_MAGIC)
 		return DT_FAILURE | DT_WRONG_MAGIC;
-	if (header->version != DT_NAVMESH_VERSION)
+	if (!dtIsNavMeshVersion(header->version))
 		return DT_FAILURE | DT_WRONG_VERSION;
 
 	dtNavMeshParams params;
@@ -307,145 +1042,193 @@ int dtNavMesh::findConnectingPolys(const float* va, const float* vb,
 	calcSlabEndPoints(va, vb, amin, amax, side);
 	const float apos = getSlabCoord(va, side);
 
-	// Remove links pointing to 'side' and compact the links array. 
-	float bmin[2], bmax[2];
-	unsigned short m = DT_EXT_LINK | (unsigned short)side;
-	int n = 0;
+	// The edges on the side are sorted by their start, so only the edges
+	// before the first one starting past the segment can overlap it, and
+	// since the reach is increasing, only from the first one reaching it.
+	const dtBorderEdge* edges = tile->borderEdges + tile->borderEdgeStart[side];
+	const int nedges = tile->borderEdgeStart[side+1] - tile->borderEdgeStart[side];
+	int lo = 0, hi = nedges;
+	while (lo < hi)
+	{
+		const int mid = (lo+hi)/2;
+		if (edges[mid].bmin[0] <= amax[0])
+			lo = mid+1;
+		else
+			hi = mid;
+	}
+	const int last = lo;
+	lo = 0;
+	while (lo < hi)
+	{
+		const int mid = (lo+hi)/2;
+		if (edges[mid].reach < amin[0])
+			lo = mid+1;
+		else
+			hi = mid;
+	}
+	const int first = lo;
 	
 	dtPolyRef base = getPolyRefBase(tile);
+	int n = 0;
 	
-	for (int i = 0; i < tile->header->polyCount; ++i)
+	// Return the polygons in index order, each through its first touching
+	// edge, the same as a scan over the tile's polygons would.
+	unsigned int prevPoly = 0;
+	while (n < maxcon)
 	{
-		dtPoly* poly = &tile->polys[i];
-		const int nv = poly->vertCount;
-		for (int j = 0; j < nv; ++j)
+		const dtBorderEdge* best = 0;
+		for (int i = first; i < last; ++i)
 		{
-			// Skip edges which do not point to the right side.
-			if (poly->neis[j] != m) continue;
-			
-			const float* vc = &tile->verts[poly->verts[j]*3];
-			const float* vd = &tile->verts[poly->verts[(j+1) % nv]*3];
-			const float bpos = getSlabCoord(vc, side);
+			const dtBorderEdge* edge = &edges[i];
+			if (n > 0 && edge->poly <= prevPoly)
+				continue;
+			if (best && (edge->poly > best->poly || (edge->poly == best->poly && edge->edge > best->edge)))
+				continue;
 			
 			// Segments are not close enough.
-			if (dtAbs(apos-bpos) > 0.01f)
+			if (dtAbs(apos-edge->pos) > 0.01f)
 				continue;
 			
 			// Check if the segments touch.
-			calcSlabEndPoints(vc,vd, bmin,bmax, side);
-			
-			if (!overlapSlabs(amin,amax, bmin,bmax, 0.01f, tile->header->walkableClimb)) continue;
+			if (!overlapSlabs(amin,amax, edge->bmin,edge->bmax, 0.01f, tile->header->walkableClimb)) continue;
 			
-			// Add return value.
-			if (n < maxcon)
-			{
-				conarea[n*2+0] = dtMax(amin[0], bmin[0]);
-				conarea[n*2+1] = dtMin(amax[0], bmax[0]);
-				con[n] = base | (dtPolyRef)i;
-				n++;
-			}
-			break;
+			best = edge;
 		}
+		if (!best)
+			break;
+		
+		// Add return value.
+		conarea[n*2+0] = dtMax(amin[0], best->bmin[0]);
+		conarea[n*2+1] = dtMin(amax[0], best->bmax[0]);
+		con[n] = base | (dtPolyRef)best->poly;
+		prevPoly = best->poly;
+		n++;
 	}
 	return n;
 }
 
-void dtNavMesh::unconnectLinks(dtMeshTile* tile, dtMeshTile* target)
+void dtNavMesh::unconnectPolyLinks(dtMeshTile* tile, dtPoly* poly, const unsigned int targetNum)
+{
+	unsigned int j = poly->firstLink;
+	unsigned int pj = DT_NULL_LINK;
+	while (j != DT_NULL_LINK)
+	{
+		if (decodePolyIdTile(tile->links[j].ref) == targetNum)
+		{
+			// Remove link.
+			unsigned int nj = tile->links[j].next;
+			if (pj == DT_NULL_LINK)
+				poly->firstLink = nj;
+			else
+				tile->links[pj].next = nj;
+			retireLink(tile, j);
+			j = nj;
+		}
+		else
+		{
+			// Advance
+			pj = j;
+			j = tile->links[j].next;
+		}
+	}
+}
+
+void dtNavMesh::unconnectLinks(dtMeshTile* tile, dtMeshTile* target, int side)
 {
 	if (!tile || !target) return;
 
 	const unsigned int targetNum = decodePolyIdTile(getTileRef(target));
 
-	for (int i = 0; i < tile->header->polyCount; ++i)
+	// Only visit the polygons that connectExtLinks() and connectExtOffMeshLinks()
+	// can have linked to the target.  A return link of a bidirectional connection
+	// that lands in this tile can be on any ground polygon, so those are all 
+	// visited if the target has one.
+	const int landing = side == -1 ? 8 : dtOppositeTile(side);
+	bool hasReturnLinks = false;
+	for (int k = target->offMeshConStart[landing]; k < target->offMeshConStart[landing+1]; ++k)
 	{
-		dtPoly* poly = &tile->polys[i];
-		unsigned int j = poly->firstLink;
-		unsigned int pj = DT_NULL_LINK;
-		while (j != DT_NULL_LINK)
+		if (target->offMeshCons[target->offMeshConIndex[k]].flags & DT_OFFMESH_CON_BIDIR)
 		{
-			if (decodePolyIdTile(tile->links[j].ref) == targetNum)
-			{
-				// Remove link.
-				unsigned int nj = tile->links[j].next;
-				if (pj == DT_NULL_LINK)
-					poly->firstLink = nj;
-				else
-					tile->links[pj].next = nj;
-				freeLink(tile, j);
-				j = nj;
-			}
-			else
-			{
-				// Advance
-				pj = j;
-				j = tile->links[j].next;
-			}
+			hasReturnLinks = true;
+			break;
 		}
 	}
+
+	if (hasReturnLinks)
+	{
+		for (int i = 0; i < tile->header->offMeshBase; ++i)
+			unconnectPolyLinks(tile, &tile->polys[i], targetNum);
+	}
+	else
+	{
+		// Portal links are on the polygons with an edge on the side facing the target.
+		const int first = tile->borderEdgeStart[side == -1 ? 0 : side];
+		const int last = tile->borderEdgeStart[side == -1 ? 8 : side+1];
+		for (int i = first; i < last; ++i)
+			unconnectPolyLinks(tile, &tile->polys[tile->borderEdges[i].poly], targetNum);
+	}
+
+	// Off-mesh connections that land in the target.
+	const int group = side == -1 ? 8 : side;
+	for (int k = tile->offMeshConStart[group]; k < tile->offMeshConStart[group+1]; ++k)
+	{
+		const dtOffMeshConnection* con = &tile->offMeshCons[tile->offMeshConIndex[k]];
+		unconnectPolyLinks(tile, &tile->polys[con->poly], targetNum);
+	}
 }
 
 void dtNavMesh::connectExtLinks(dtMeshTile* tile, dtMeshTile* target, int side)
 {
 	if (!tile) return;
 	
-	// Connect border links.
-	for (int i = 0; i < tile->header->polyCount; ++i)
+	// Connect border links, visiting only the portal edges on the requested side.
+	const int first = tile->borderEdgeStart[side == -1 ? 0 : side];
+	const int last = tile->borderEdgeStart[side == -1 ? 8 : side+1];
+	for (int i = first; i < last; ++i)
 	{
-		dtPoly* poly = &tile->polys[i];
-
-		// Create new links.
-//		unsigned short m = DT_EXT_LINK | (unsigned short)side;
-		
+		const dtBorderEdge* edge = &tile->borderEdges[i];
+		dtPoly* poly = &tile->polys[edge->poly];
 		const int nv = poly->vertCount;
-		for (int j = 0; j < nv; ++j)
+		const int j = edge->edge;
+		const int dir = edge->side;
+		
+		// Create new links
+		const float* va = &tile->verts[poly->verts[j]*3];
+		const float* vb = &tile->verts[poly->verts[(j+1) % nv]*3];
+		dtPolyRef nei[4];
+		float neia[4*2];
+		int nnei = findConnectingPolys(va,vb, target, dtOppositeTile(dir), nei,neia,4);
+		for (int k = 0; k < nnei; ++k)
 		{
-			// Skip non-portal edges.
-			if ((poly->neis[j] & DT_EXT_LINK) == 0)
-				continue;
-			
-			const int dir = (int)(poly->neis[j] & 0xff);
-			if (side != -1 && dir != side)
-				continue;
-			
-			// Create new links
-			const float* va = &tile->verts[poly->verts[j]*3];
-			const float* vb = &tile->verts[poly->verts[(j+1) % nv]*3];
-			dtPolyRef nei[4];
-			float neia[4*2];
-			int nnei = findConnectingPolys(va,vb, target, dtOppositeTile(dir), nei,neia,4);
-			for (int k = 0; k < nnei; ++k)
+			unsigned int idx = allocLink(tile);
+			if (idx != DT_NULL_LINK)
 			{
-				unsigned int idx = allocLink(tile);
-				if (idx != DT_NULL_LINK)
+				dtLink* link = &tile->links[idx];
+				link->ref = nei[k];
+				link->edge = (unsigned char)j;
+				link->side = (unsigned char)dir;
+
+				// Compress portal limits to a byte value.
+				if (dir == 0 || dir == 4)
 				{
-					dtLink* link = &tile->links[idx];
-					link->ref = nei[k];
-					link->edge = (unsigned char)j;
-					link->side = (unsigned char)dir;
-					
-					link->next = poly->firstLink;
-					poly->firstLink = idx;
-
-					// Compress portal limits to a byte value.
-					if (dir == 0 || dir == 4)
-					{
-						float tmin = (neia[k*2+0]-va[2]) / (vb[2]-va[2]);
-						float tmax = (neia[k*2+1]-va[2]) / (vb[2]-va[2]);
-						if (tmin > tmax)
-							dtSwap(tmin,tmax);
-						link->bmin = (unsigned char)(dtClamp(tmin, 0.0f, 1.0f)*255.0f);
-						link->bmax = (unsigned char)(dtClamp(tmax, 0.0f, 1.0f)*255.0f);
-					}
-					else if (dir == 2 || dir == 6)
-					{
-						float tmin = (neia[k*2+0]-va[0]) / (vb[0]-va[0]);
-						float tmax = (neia[k*2+1]-va[0]) / (vb[0]-va[0]);
-						if (tmin > tmax)
-							dtSwap(tmin,tmax);
-						link->bmin = (unsigned char)(dtClamp(tmin, 0.0f, 1.0f)*255.0f);
-						link->bmax = (unsigned char)(dtClamp(tmax, 0.0f, 1.0f)*255.0f);
-					}
+					float tmin = (neia[k*2+0]-va[2]) / (vb[2]-va[2]);
+					float tmax = (neia[k*2+1]-va[2]) / (vb[2]-va[2]);
+					if (tmin > tmax)
+						dtSwap(tmin,tmax);
+					link->bmin = (unsigned char)(dtClamp(tmin, 0.0f, 1.0f)*255.0f);
+					link->bmax = (unsigned char)(dtClamp(tmax, 0.0f, 1.0f)*255.0f);
+				}
+				else if (dir == 2 || dir == 6)
+				{
+					float tmin = (neia[k*2+0]-va[0]) / (vb[0]-va[0]);
+					float tmax = (neia[k*2+1]-va[0]) / (vb[0]-va[0]);
+					if (tmin > tmax)
+						dtSwap(tmin,tmax);
+					link->bmin = (unsigned char)(dtClamp(tmin, 0.0f, 1.0f)*255.0f);
+					link->bmax = (unsigned char)(dtClamp(tmax, 0.0f, 1.0f)*255.0f);
 				}
+
+				publishLink(tile, poly, idx);
 			}
 		}
 	}
@@ -457,11 +1240,13 @@ void dtNavMesh::connectExtOffMeshLinks(dtMeshTile* tile, dtMeshTile* target, int
 	
 	// Connect off-mesh links.
 	// We are interested on links which land from target tile to this tile.
+	// Visit only the target's connections in the group for that side.
 	const unsigned char oppositeSide = (side == -1) ? 0xff : (unsigned char)dtOppositeTile(side);
+	const int group = offMeshConGroup(oppositeSide);
 	
-	for (int i = 0; i < target->header->offMeshConCount; ++i)
+	for (int k = target->offMeshConStart[group]; k < target->offMeshConStart[group+1]; ++k)
 	{
-		dtOffMeshConnection* targetCon = &target->offMeshCons[i];
+		dtOffMeshConnection* targetCon = &target->offMeshCons[target->offMeshConIndex[k]];
 		if (targetCon->side != oppositeSide)
 			continue;
 
@@ -495,8 +1280,7 @@ void dtNavMesh::connectExtOffMeshLinks(dtMeshTile* tile, dtMeshTile* target, int
 			link->side = oppositeSide;
 			link->bmin = link->bmax = 0;
 			// Add to linked list.
-			link->next = targetPoly->firstLink;
-			targetPoly->firstLink = idx;
+			publishLink(target, targetPoly, idx);
 		}
 		
 		// Link target poly to off-mesh connection.
@@ -513,8 +1297,7 @@ void dtNavMesh::connectExtOffMeshLinks(dtMeshTile* tile, dtMeshTile* target, int
 				link->side = (unsigned char)(side == -1 ? 0xff : side);
 				link->bmin = link->bmax = 0;
 				// Add to linked list.
-				link->next = landPoly->firstLink;
-				landPoly->firstLink = tidx;
+				publishLink(tile, landPoly, tidx);
 			}
 		}
 	}
@@ -636,9 +1419,6 @@ void dtNavMesh::closestPointOnPoly(dtPolyRef ref, const float* pos, float* close
 		return;
 	}
 	
-	const unsigned int ip = (unsigned int)(poly - tile->polys);
-	const dtPolyDetail* pd = &tile->detailMeshes[ip];
-	
 	// Clamp point to be inside the polygon.
 	float verts[DT_VERTS_PER_POLYGON*3];	
 	float edged[DT_VERTS_PER_POLYGON];
@@ -675,24 +1455,9 @@ void dtNavMesh::closestPointOnPoly(dtPolyRef ref, const float* pos, float* close
 	}
 	
 	// Find height at the location.
-	for (int j = 0; j < pd->triCount; ++j)
-	{
-		const unsigned char* t = &tile->detailTris[(pd->triBase+j)*4];
-		const float* v[3];
-		for (int k = 0; k < 3; ++k)
-		{
-			if (t[k] < poly->vertCount)
-				v[k] = &tile->verts[poly->verts[t[k]]*3];
-			else
-				v[k] = &tile->detailVerts[(pd->vertBase+(t[k]-poly->vertCount))*3];
-		}
-		float h;
-		if (dtClosestHeightPointTriangle(closest, v[0], v[1], v[2], h))
-		{
-			closest[1] = h;
-			break;
-		}
-	}
+	float h;
+	if (dtGetDetailHeight(tile, poly, closest, &h))
+		closest[1] = h;
 }
 
 dtPolyRef dtNavMesh::findNearestPolyInTile(const dtMeshTile* tile,
@@ -708,39 +1473,14 @@ dtPolyRef dtNavMesh::findNearestPolyInTile(const dtMeshTile* tile,
 	int polyCount = queryPolygonsInTile(tile, bmin, bmax, polys, 128);
 	
 	// Find nearest polygon amongst the nearby polygons.
-	dtPolyRef nearest = 0;
-	float nearestDistanceSqr = FLT_MAX;
+	const dtPoly* candidates[128];
 	for (int i = 0; i < polyCount; ++i)
-	{
-		dtPolyRef ref = polys[i];
-		float closestPtPoly[3];
-		float diff[3];
-		bool posOverPoly = false;
-		float d;
-		closestPointOnPoly(ref, center, closestPtPoly, &posOverPoly);
-
-		// If a point is directly over a polygon and closer than
-		// climb height, favor that instead of straight line nearest point.
-		dtVsub(diff, center, closestPtPoly);
-		if (posOverPoly)
-		{
-			d = dtAbs(diff[1]) - tile->header->walkableClimb;
-			d = d > 0 ? d*d : 0;			
-		}
-		else
-		{
-			d = dtVlenSqr(diff);
-		}
-		
-		if (d < nearestDistanceSqr)
-		{
-			dtVcopy(nearestPt, closestPtPoly);
-			nearestDistanceSqr = d;
-			nearest = ref;
-		}
-	}
+		candidates[i] = &tile->polys[decodePolyIdPoly(polys[i])];
+	float nearestDistanceSqr = FLT_MAX;
+	const int nearest = dtFindNearestPolyInList(tile, candidates, polyCount, center,
+												&nearestDistanceSqr, nearestPt);
 	
-	return nearest;
+	return nearest == -1 ? 0 : polys[nearest];
 }
 
 int dtNavMesh::queryPolygonsInTile(const dtMeshTile* tile, const float* qmin, const float* qmax,
@@ -850,12 +1590,17 @@ dtStatus dtNavMesh::addTile(unsigned char* data, int dataSize, int flags,
 	dtMeshHeader* header = (dtMeshHeader*)data;
 	if (header->magic != DT_NAVMESH_MAGIC)
 		return DT_FAILURE | DT_WRONG_MAGIC;
-	if (header->version != DT_NAVMESH_VERSION)
+	if (!dtIsNavMeshVersion(header->version))
 		return DT_FAILURE | DT_WRONG_VERSION;
 		
 	// Make sure the location is free.
 	if (getTileAt(header->x, header->y, header->layer))
 		return DT_FAILURE | DT_ALREADY_OCCUPIED;
+
+	// Return the removed tiles that reads are done with to the free list.
+	if (m_retiredTileCount || m_retiredLinkCount)
+		reclaimRetired();
+	flags &= ~DT_TILE_RETIRED;
 		
 	// Allocate a tile.
 	dtMeshTile* tile = 0;
@@ -900,18 +1645,13 @@ dtStatus dtNavMesh::addTile(unsigned char* data, int dataSize, int flags,
 	if (!tile)
 		return DT_FAILURE | DT_OUT_OF_MEMORY;
 	
-	// Insert tile into the position lut.
-	int h = computeTileHash(header->x, header->y, m_tileLutMask);
-	tile->next = m_posLookup[h];
-	m_posLookup[h] = tile;
-	
 	// Patch header pointers.
 	const int headerSize = dtAlign4(sizeof(dtMeshHeader));
 	const int vertsSize = dtAlign4(sizeof(float)*3*header->vertCount);
 	const int polysSize = dtAlign4(sizeof(dtPoly)*header->polyCount);
 	const int linksSize = dtAlign4(sizeof(dtLink)*(header->maxLinkCount));
 	const int detailMeshesSize = dtAlign4(sizeof(dtPolyDetail)*header->detailMeshCount);
-	const int detailVertsSize = dtAlign4(sizeof(float)*3*header->detailVertCount);
+	const int detailVertsSize = dtGetDetailVertsSize(header->version, header->detailVertCount);
 	const int detailTrisSize = dtAlign4(sizeof(unsigned char)*4*header->detailTriCount);
 	const int bvtreeSize = dtAlign4(sizeof(dtBVNode)*header->bvNodeCount);
 	const int offMeshLinksSize = dtAlign4(sizeof(dtOffMeshConnection)*header->offMeshConCount);
@@ -921,15 +1661,92 @@ dtStatus dtNavMesh::addTile(unsigned char* data, int dataSize, int flags,
 	tile->polys = dtGetThenAdvanceBufferPointer<dtPoly>(d, polysSize);
 	tile->links = dtGetThenAdvanceBufferPointer<dtLink>(d, linksSize);
 	tile->detailMeshes = dtGetThenAdvanceBufferPointer<dtPolyDetail>(d, detailMeshesSize);
-	tile->detailVerts = dtGetThenAdvanceBufferPointer<float>(d, detailVertsSize);
+	if (header->version == DT_NAVMESH_COMPACT_VERSION)
+	{
+		// The decode values are followed by the quantized vertices. (Both are null without detail vertices.)
+		tile->detailVerts = 0;
+		tile->detailQuantParams = detailVertsSize ? (const float*)d : 0;
+		tile->detailQuantVerts = detailVertsSize ? (unsigned short*)(d + sizeof(float)*6) : 0;
+		d += detailVertsSize;
+	}
+	else
+	{
+		tile->detailVerts = dtGetThenAdvanceBufferPointer<float>(d, detailVertsSize);
+		tile->detailQuantVerts = 0;
+		tile->detailQuantParams = 0;
+	}
 	tile->detailTris = dtGetThenAdvanceBufferPointer<unsigned char>(d, detailTrisSize);
 	tile->bvTree = dtGetThenAdvanceBufferPointer<dtBVNode>(d, bvtreeSize);
 	tile->offMeshCons = dtGetThenAdvanceBufferPointer<dtOffMeshConnection>(d, offMeshLinksSize);
 
+	if (flags & DT_TILE_SHARED_DATA)
+	{
+		// Copy the sections the mesh writes to: Polygons and links, plus the
+		// vertices if off-mesh connections will snap their end points.
+		// The copy starts with the polygons, so it is freed through tile->polys.
+		const int privVertsSize = header->offMeshConCount ? vertsSize : 0;
+		unsigned char* priv = (unsigned char*)dtAlloc(polysSize + linksSize + privVertsSize, DT_ALLOC_PERM, DT_ALLOC_TAG_NAVMESH);
+		if (!priv)
+		{
+			// Return the tile to the free list.
+			tile->next = m_nextFree;
+			m_nextFree = tile;
+			tile->polys = 0;
+			tile->verts = 0;
+			tile->links = 0;
+			return DT_FAILURE | DT_OUT_OF_MEMORY;
+		}
+		memcpy(priv, tile->polys, polysSize);
+		if (privVertsSize)
+		{
+			memcpy(priv + polysSize + linksSize, tile->verts, privVertsSize);
+			tile->verts = (float*)(priv + polysSize + linksSize);
+		}
+		tile->polys = (dtPoly*)priv;
+		tile->links = (dtLink*)(priv + polysSize);
+	}
+
+	// Index the portal edges and off-mesh connections so that linking to 
+	// neighbours does not need to scan every polygon of both tiles.
+	if (!buildBorderEdges(tile, header) || !buildOffMeshConIndex(tile, header))
+	{
+		if (flags & DT_TILE_SHARED_DATA)
+			dtFree(tile->polys);
+		dtFree(tile->borderEdges);
+		tile->borderEdges = 0;
+		tile->next = m_nextFree;
+		m_nextFree = tile;
+		tile->polys = 0;
+		tile->verts = 0;
+		tile->links = 0;
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+	}
+
 	// If there are no items in the bvtree, reset the tree pointer.
 	if (!bvtreeSize)
 		tile->bvTree = 0;
 
+	tile->polyGrid = 0;
+	tile->heightGrid = 0;
+	if ((m_polyGrids && !buildPolyGrid(tile, header)) ||
+		(m_heightGrids && !buildHeightGrid(tile, header)))
+	{
+		if (flags & DT_TILE_SHARED_DATA)
+			dtFree(tile->polys);
+		dtFree(tile->borderEdges);
+		dtFree(tile->offMeshConIndex);
+		dtFree(tile->polyGrid);
+		tile->next = m_nextFree;
+		m_nextFree = tile;
+		tile->polys = 0;
+		tile->verts = 0;
+		tile->links = 0;
+		tile->borderEdges = 0;
+		tile->offMeshConIndex = 0;
+		tile->polyGrid = 0;
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+	}
+
 	// Build links freelist
 	tile->linksFreeList = 0;
 	tile->links[header->maxLinkCount-1].next = DT_NULL_LINK;
@@ -942,6 +1759,8 @@ dtStatus dtNavMesh::addTile(unsigned char* data, int dataSize, int flags,
 	tile->dataSize = dataSize;
 	tile->flags = flags;
 
+	markTileChanged(tile);
+
 	connectIntLinks(tile);
 
 	// Base off-mesh connections to their starting polygons and connect connections inside the tile.
@@ -960,6 +1779,7 @@ dtStatus dtNavMesh::addTile(unsigned char* data, int dataSize, int flags,
 		if (neis[j] == tile)
 			continue;
 	
+		markTileChanged(neis[j]);
 		connectExtLinks(tile, neis[j], -1);
 		connectExtLinks(neis[j], tile, -1);
 		connectExtOffMeshLinks(tile, neis[j], -1);
@@ -972,12 +1792,20 @@ dtStatus dtNavMesh::addTile(unsigned char* data, int dataSize, int flags,
 		nneis = getNeighbourTilesAt(header->x, header->y, i, neis, MAX_NEIS);
 		for (int j = 0; j < nneis; ++j)
 		{
+			markTileChanged(neis[j]);
 			connectExtLinks(tile, neis[j], i);
 			connectExtLinks(neis[j], tile, dtOppositeTile(i));
 			connectExtOffMeshLinks(tile, neis[j], i);
 			connectExtOffMeshLinks(neis[j], tile, dtOppositeTile(i));
 		}
 	}
+
+	// Insert tile into the position lut.  This is done last so that a concurrent
+	// read never finds a partly connected tile.
+	int h = computeTileHash(header->x, header->y, m_tileLutMask);
+	tile->next = m_posLookup[h];
+	memoryBarrier();
+	m_posLookup[h] = tile;
 	
 	if (result)
 		*result = getTileRef(tile);
@@ -1099,7 +1927,7 @@ const dtMeshTile* dtNavMesh::getTileByRef(dtTileRef ref) const
 	if ((int)tileIndex >= m_maxTiles)
 		return 0;
 	const dtMeshTile* tile = &m_tiles[tileIndex];
-	if (tile->salt != tileSalt)
+	if (tile->salt != tileSalt || (tile->flags & DT_TILE_RETIRED))
 		return 0;
 	return tile;
 }
@@ -1162,11 +1990,42 @@ bool dtNavMesh::isValidPolyRef(dtPolyRef ref) const
 	return true;
 }
 
+/// @par
+///
+/// The version of a tile advances when it is added or removed, when a neighbour 
+/// is added or removed next to it (its links change), and when the flags or area 
+/// of one of its polygons change.  A reference whose salt no longer matches is 
+/// reported as changed, as long as the version predates the removal.
+///
+/// Versions are compared with wrap-around, so they stay meaningful for 2^31 
+/// changes after they were taken.
+bool dtNavMesh::hasTileChanged(dtPolyRef ref, unsigned int version) const
+{
+	const unsigned int it = decodePolyIdTile(ref);
+	if (it >= (unsigned int)m_maxTiles)
+		return true;
+	return (int)(m_tiles[it].version - version) > 0;
+}
+
+void dtNavMesh::markTileChanged(dtMeshTile* tile)
+{
+	// Zero is kept free for the users, to mean no version.
+	if (++m_version == 0)
+		m_version = 1;
+	tile->version = m_version;
+}
+
 /// @par
 ///
 /// This function returns the data for the tile so that, if desired,
 /// it can be added back to the navigation mesh at a later point.
 ///
+/// If concurrent reads are enabled and a read is running, the tile memory is 
+/// kept until the reads that may be using it have ended. (See: #reclaimRetired)
+/// The tile is flagged #DT_TILE_RETIRED meanwhile.  Returned data is still in
+/// use until then, so it must not be freed or reused while #getRetiredTileCount
+/// is non-zero.
+///
 /// @see #addTile
 dtStatus dtNavMesh::removeTile(dtTileRef ref, unsigned char** data, int* dataSize)
 {
@@ -1177,10 +2036,11 @@ dtStatus dtNavMesh::removeTile(dtTileRef ref, unsigned char** data, int* dataSiz
 	if ((int)tileIndex >= m_maxTiles)
 		return DT_FAILURE | DT_INVALID_PARAM;
 	dtMeshTile* tile = &m_tiles[tileIndex];
-	if (tile->salt != tileSalt)
+	if (tile->salt != tileSalt || (tile->flags & DT_TILE_RETIRED))
 		return DT_FAILURE | DT_INVALID_PARAM;
 	
-	// Remove tile from hash lookup.
+	// Remove tile from hash lookup.  The tile keeps its next pointer so that a
+	// concurrent read on it can continue down the chain.
 	int h = computeTileHash(tile->header->x,tile->header->y,m_tileLutMask);
 	dtMeshTile* prev = 0;
 	dtMeshTile* cur = m_posLookup[h];
@@ -1198,6 +2058,8 @@ dtStatus dtNavMesh::removeTile(dtTileRef ref, unsigned char** data, int* dataSiz
 		cur = cur->next;
 	}
 	
+	markTileChanged(tile);
+
 	// Remove connections to neighbour tiles.
 	static const int MAX_NEIS = 32;
 	dtMeshTile* neis[MAX_NEIS];
@@ -1208,7 +2070,8 @@ dtStatus dtNavMesh::removeTile(dtTileRef ref, unsigned char** data, int* dataSiz
 	for (int j = 0; j < nneis; ++j)
 	{
 		if (neis[j] == tile) continue;
-		unconnectLinks(neis[j], tile);
+		markTileChanged(neis[j]);
+		unconnectLinks(neis[j], tile, -1);
 	}
 	
 	// Disconnect from neighbour tiles.
@@ -1216,16 +2079,14 @@ dtStatus dtNavMesh::removeTile(dtTileRef ref, unsigned char** data, int* dataSiz
 	{
 		nneis = getNeighbourTilesAt(tile->header->x, tile->header->y, i, neis, MAX_NEIS);
 		for (int j = 0; j < nneis; ++j)
-			unconnectLinks(neis[j], tile);
+		{
+			markTileChanged(neis[j]);
+			unconnectLinks(neis[j], tile, dtOppositeTile(i));
+		}
 	}
-		
-	// Reset tile.
+
 	if (tile->flags & DT_TILE_FREE_DATA)
 	{
-		// Owns data
-		dtFree(tile->data);
-		tile->data = 0;
-		tile->dataSize = 0;
 		if (data) *data = 0;
 		if (dataSize) *dataSize = 0;
 	}
@@ -1235,31 +2096,321 @@ dtStatus dtNavMesh::removeTile(dtTileRef ref, unsigned char** data, int* dataSiz
 		if (dataSize) *dataSize = tile->dataSize;
 	}
 
+	// Update salt, salt should never be zero.
+#ifdef DT_POLYREF64
+	tile->salt = (tile->salt+1) & ((1<<DT_SALT_BITS)-1);
+#else
+	tile->salt = (tile->salt+1) & ((1<<m_saltBits)-1);
+#endif
+	if (tile->salt == 0)
+		tile->salt++;
+
+	if (!m_readers)
+	{
+		releaseTile(tile);
+		return DT_SUCCESS;
+	}
+
+	// Retire the tile in the current epoch, then start a new one.  Reads that 
+	// start in the new epoch cannot reach the tile or its links.
+	tile->flags |= DT_TILE_RETIRED;
+	m_retiredTiles[m_retiredTileCount].tile = tile;
+	m_retiredTiles[m_retiredTileCount].epoch = m_epoch;
+	m_retiredTileCount++;
+
+	memoryBarrier();
+	const unsigned int epoch = m_epoch + 1;
+	m_epoch = epoch ? epoch : 1;
+	memoryBarrier();
+
+	reclaimRetired();
+
+	return DT_SUCCESS;
+}
+
+void dtNavMesh::releaseTile(dtMeshTile* tile)
+{
+	// Reset tile.
+	if (tile->flags & DT_TILE_SHARED_DATA)
+		dtFree(tile->polys);
+	dtFree(tile->borderEdges);
+	dtFree(tile->offMeshConIndex);
+	dtFree(tile->polyGrid);
+	dtFree(tile->heightGrid);
+	if (tile->flags & DT_TILE_FREE_DATA)
+	{
+		// Owns data
+		dtFree(tile->data);
+	}
+
 	tile->header = 0;
 	tile->flags = 0;
+	tile->data = 0;
+	tile->dataSize = 0;
 	tile->linksFreeList = 0;
 	tile->polys = 0;
 	tile->verts = 0;
 	tile->links = 0;
 	tile->detailMeshes = 0;
 	tile->detailVerts = 0;
+	tile->detailQuantVerts = 0;
+	tile->detailQuantParams = 0;
 	tile->detailTris = 0;
 	tile->bvTree = 0;
 	tile->offMeshCons = 0;
-
-	// Update salt, salt should never be zero.
-#ifdef DT_POLYREF64
-	tile->salt = (tile->salt+1) & ((1<<DT_SALT_BITS)-1);
-#else
-	tile->salt = (tile->salt+1) & ((1<<m_saltBits)-1);
-#endif
-	if (tile->salt == 0)
-		tile->salt++;
+	tile->borderEdges = 0;
+	memset(tile->borderEdgeStart, 0, sizeof(tile->borderEdgeStart));
+	tile->offMeshConIndex = 0;
+	memset(tile->offMeshConStart, 0, sizeof(tile->offMeshConStart));
+	tile->polyGrid = 0;
+	tile->heightGrid = 0;
 
 	// Add to free list.
 	tile->next = m_nextFree;
 	m_nextFree = tile;
+}
+
+void dtNavMesh::retireLink(dtMeshTile* tile, unsigned int link)
+{
+	if (!m_readers)
+	{
+		freeLink(tile, link);
+		return;
+	}
+
+	// A read may be on the link, so its next index must stay intact until the
+	// reads of the current epoch have ended.
+	if (m_retiredLinkCount == m_retiredLinkCap)
+	{
+		const int cap = m_retiredLinkCap ? m_retiredLinkCap*2 : 256;
+		dtRetiredLink* links = (dtRetiredLink*)dtAlloc(sizeof(dtRetiredLink)*cap, DT_ALLOC_PERM, DT_ALLOC_TAG_NAVMESH);
+		if (!links)
+		{
+			// The link is not reused until the tile is removed.
+			return;
+		}
+		if (m_retiredLinkCount)
+			memcpy(links, m_retiredLinks, sizeof(dtRetiredLink)*m_retiredLinkCount);
+		dtFree(m_retiredLinks);
+		m_retiredLinks = links;
+		m_retiredLinkCap = cap;
+	}
+
+	dtRetiredLink& retired = m_retiredLinks[m_retiredLinkCount++];
+	retired.tileRef = getTileRef(tile);
+	retired.link = link;
+	retired.epoch = m_epoch;
+}
+
+/// @par
+///
+/// Each thread that reads the mesh while tiles are added or removed on another
+/// thread needs a reader slot. (See: #acquireReader)  The mesh must be initialized
+/// and no reads may be running.  The change itself (#addTile and #removeTile) must 
+/// still be made by one thread at a time.
+///
+/// Size @p maxReaders for every query that starts reads.  A crowd needs two slots,
+/// one for its query and one for the query of its path queue.  A read that finds 
+/// no free slot fails. (See: dtNavMeshQuery::beginRead)
+///
+/// A read sees either the old or the new links of each polygon.  A tile that is
+/// removed during a read keeps its memory until the read has ended, but its 
+/// references stop being valid at once.  So a read that checks its references, as
+/// the sliced queries do, fails cleanly instead of using freed memory.
+///
+/// @see #beginRead
+dtStatus dtNavMesh::initConcurrentReads(const int maxReaders)
+{
+	if (maxReaders <= 0 || !m_tiles || m_readers)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	m_retiredTiles = (dtRetiredTile*)dtAlloc(sizeof(dtRetiredTile)*m_maxTiles, DT_ALLOC_PERM, DT_ALLOC_TAG_NAVMESH);
+	if (!m_retiredTiles)
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+	m_retiredTileCount = 0;
+
+	dtNavMeshReader* readers = (dtNavMeshReader*)dtAlloc(sizeof(dtNavMeshReader)*maxReaders, DT_ALLOC_PERM, DT_ALLOC_TAG_NAVMESH);
+	if (!readers)
+	{
+		dtFree(m_retiredTiles);
+		m_retiredTiles = 0;
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+	}
+	memset(readers, 0, sizeof(dtNavMeshReader)*maxReaders);
+
+	m_maxReaders = maxReaders;
+	memoryBarrier();
+	m_readers = readers;
+
+	return DT_SUCCESS;
+}
+
+int dtNavMesh::acquireReader() const
+{
+	for (int i = 0; i < m_maxReaders; ++i)
+	{
+		if (!m_readers[i].used && tryClaim(&m_readers[i].used))
+			return i;
+	}
+	return -1;
+}
+
+void dtNavMesh::releaseReader(const int reader) const
+{
+	if (reader < 0 || reader >= m_maxReaders)
+		return;
+	m_readers[reader].epoch = 0;
+	memoryBarrier();
+	m_readers[reader].used = 0;
+}
+
+/// @par
+///
+/// Reads do not block the thread that changes the mesh, and a read that has not
+/// ended delays only the freeing of the tiles removed since it started.  So a
+/// read should cover one query or one update, not the lifetime of the reader.
+///
+/// Other threads that read the mesh only while the read is running are covered
+/// by it.  (E.g. The worker threads of a crowd update.)
+///
+/// @see #endRead, #initConcurrentReads
+void dtNavMesh::beginRead(const int reader) const
+{
+	if (reader < 0 || reader >= m_maxReaders)
+		return;
+	m_readers[reader].epoch = m_epoch;
+	// The slot must be visible to the writer before anything in the mesh is read.
+	memoryBarrier();
+}
+
+void dtNavMesh::endRead(const int reader) const
+{
+	if (reader < 0 || reader >= m_maxReaders)
+		return;
+	memoryBarrier();
+	m_readers[reader].epoch = 0;
+}
+
+bool dtNavMesh::isEpochReclaimable(const unsigned int epoch) const
+{
+	for (int i = 0; i < m_maxReaders; ++i)
+	{
+		const unsigned int readEpoch = m_readers[i].epoch;
+		if (readEpoch && (int)(readEpoch - epoch) <= 0)
+			return false;
+	}
+	return true;
+}
+
+/// @par
+///
+/// Called by #addTile and #removeTile, so it is only needed to free memory early 
+/// or before the data returned by #removeTile is reused.
+int dtNavMesh::reclaimRetired()
+{
+	if (!m_readers)
+		return 0;
+
+	memoryBarrier();
+
+	// Links first, since the tile that owns a link may be released below.
+	int n = 0;
+	for (int i = 0; i < m_retiredLinkCount; ++i)
+	{
+		const dtRetiredLink& retired = m_retiredLinks[i];
+		if (!isEpochReclaimable(retired.epoch))
+		{
+			m_retiredLinks[n++] = retired;
+			continue;
+		}
+		// The links of a tile removed since go with the tile.
+		const unsigned int tileIndex = decodePolyIdTile((dtPolyRef)retired.tileRef);
+		dtMeshTile* tile = &m_tiles[tileIndex];
+		if (tile->salt == decodePolyIdSalt((dtPolyRef)retired.tileRef) && !(tile->flags & DT_TILE_RETIRED))
+			freeLink(tile, retired.link);
+	}
+	m_retiredLinkCount = n;
+
+	n = 0;
+	for (int i = 0; i < m_retiredTileCount; ++i)
+	{
+		const dtRetiredTile& retired = m_retiredTiles[i];
+		if (!isEpochReclaimable(retired.epoch))
+		{
+			m_retiredTiles[n++] = retired;
+			continue;
+		}
+		releaseTile(retired.tile);
+	}
+	m_retiredTileCount = n;
+
+	return n;
+}
+
+/// @par
+///
+/// The grids cost memory roughly proportional to the number of polygons and
+/// are only used by dtNavMeshQuery::findNearestPoly() with #DT_NEARESTPOLY_GRID.
+/// If a grid cannot be allocated all grids are freed and the grids stay disabled.
+dtStatus dtNavMesh::setPolyGridsEnabled(bool enabled)
+{
+	if (enabled)
+	{
+		for (int i = 0; i < m_maxTiles; ++i)
+		{
+			dtMeshTile* tile = &m_tiles[i];
+			if (!tile->header || tile->polyGrid || (tile->flags & DT_TILE_RETIRED))
+				continue;
+			if (!buildPolyGrid(tile, tile->header))
+			{
+				setPolyGridsEnabled(false);
+				return DT_FAILURE | DT_OUT_OF_MEMORY;
+			}
+		}
+	}
+	else
+	{
+		for (int i = 0; i < m_maxTiles; ++i)
+		{
+			dtFree(m_tiles[i].polyGrid);
+			m_tiles[i].polyGrid = 0;
+		}
+	}
+	m_polyGrids = enabled;
+	return DT_SUCCESS;
+}
 
+/// @par
+///
+/// A height grid is built for each ground polygon with enough detail triangles
+/// that searching all of them is slower than looking up the few that overlap 
+/// a grid cell. The grids give the same heights as searching all the triangles.
+/// If a grid cannot be allocated all grids are freed and the grids stay disabled.
+dtStatus dtNavMesh::setHeightGridsEnabled(bool enabled)
+{
+	if (enabled)
+	{
+		for (int i = 0; i < m_maxTiles; ++i)
+		{
+			dtMeshTile* tile = &m_tiles[i];
+			if (!tile->header || tile->heightGrid || (tile->flags & DT_TILE_RETIRED))
+				continue;
+			if (!buildHeightGrid(tile, tile->header))
+			{
+				setHeightGridsEnabled(false);
+				return DT_FAILURE | DT_OUT_OF_MEMORY;
+			}
+		}
+	}
+	else
+	{
+		for (int i = 0; i < m_maxTiles; ++i)
+		{
+			dtFree(m_tiles[i].heightGrid);
+			m_tiles[i].heightGrid = 0;
+		}
+	}
+	m_heightGrids = enabled;
 	return DT_SUCCESS;
 }
 
@@ -1376,6 +2527,7 @@ dtStatus dtNavMesh::restoreTileState(dtMeshTile* tile, const unsigned char* data
 		p->flags = s->flags;
 		p->setArea(s->area);
 	}
+	markTileChanged(tile);
 	
 	return DT_SUCCESS;
 }
@@ -1468,6 +2620,7 @@ dtStatus dtNavMesh::setPolyFlags(dtPolyRef ref, unsigned short flags)
 	
 	// Change flags.
 	poly->flags = flags;
+	markTileChanged(tile);
 	
 	return DT_SUCCESS;
 }
@@ -1500,6 +2653,7 @@ dtStatus dtNavMesh::setPolyArea(dtPolyRef ref, unsigned char area)
 	dtPoly* poly = &tile->polys[ip];
 	
 	poly->setArea(area);
+	markTileChanged(tile);
 	
 	return DT_SUCCESS;
 }
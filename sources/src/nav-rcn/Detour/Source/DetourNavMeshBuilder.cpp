@@ -37,39 +37,6 @@ struct BVItem
 	int i;
 };
 
-static int compareItemX(const void* va, const void* vb)
-{
-	const BVItem* a = (const BVItem*)va;
-	const BVItem* b = (const BVItem*)vb;
-	if (a->bmin[0] < b->bmin[0])
-		return -1;
-	if (a->bmin[0] > b->bmin[0])
-		return 1;
-	return 0;
-}
-
-static int compareItemY(const void* va, const void* vb)
-{
-	const BVItem* a = (const BVItem*)va;
-	const BVItem* b = (const BVItem*)vb;
-	if (a->bmin[1] < b->bmin[1])
-		return -1;
-	if (a->bmin[1] > b->bmin[1])
-		return 1;
-	return 0;
-}
-
-static int compareItemZ(const void* va, const void* vb)
-{
-	const BVItem* a = (const BVItem*)va;
-	const BVItem* b = (const BVItem*)vb;
-	if (a->bmin[2] < b->bmin[2])
-		return -1;
-	if (a->bmin[2] > b->bmin[2])
-		return 1;
-	return 0;
-}
-
 static void calcExtends(BVItem* items, const int /*nitems*/, const int imin, const int imax,
 						unsigned short* bmin, unsigned short* bmax)
 {
@@ -110,7 +77,172 @@ inline int longestAxis(unsigned short x, unsigned short y, unsigned short z)
 	return axis;
 }
 
-static void subdivide(BVItem* items, int nitems, int imin, int imax, int& curNode, dtBVNode* nodes)
+// Partially orders the items along the axis so that the item at index k is the one a 
+// full sort would put there, with no greater items before it and no smaller items after it.
+static void selectItems(BVItem* items, const int imin, const int imax, const int k, const int axis)
+{
+	int lo = imin;
+	int hi = imax-1;
+	while (lo < hi)
+	{
+		// Median of three pivot.
+		const unsigned short a = items[lo].bmin[axis];
+		const unsigned short b = items[(lo+hi)/2].bmin[axis];
+		const unsigned short c = items[hi].bmin[axis];
+		const unsigned short pivot = dtMax(dtMin(a, b), dtMin(dtMax(a, b), c));
+		
+		int i = lo;
+		int j = hi;
+		while (i <= j)
+		{
+			while (items[i].bmin[axis] < pivot) i++;
+			while (items[j].bmin[axis] > pivot) j--;
+			if (i <= j)
+			{
+				dtSwap(items[i], items[j]);
+				i++;
+				j--;
+			}
+		}
+		
+		if (k <= j)
+			hi = j;
+		else if (k >= i)
+			lo = i;
+		else
+			break; // Items between j and i are equal to the pivot.
+	}
+}
+
+static const int BV_SAH_BIN_COUNT = 16;
+
+// Nodes deeper than this use the median split so that degenerate input can't
+// result in a very deep tree.
+static const int BV_SAH_MAX_DEPTH = 48;
+
+struct BVBin
+{
+	unsigned short bmin[3];
+	unsigned short bmax[3];
+	int count;
+};
+
+inline void addBounds(unsigned short* bmin, unsigned short* bmax,
+					  const unsigned short* obmin, const unsigned short* obmax, const bool first)
+{
+	for (int i = 0; i < 3; ++i)
+	{
+		bmin[i] = first ? obmin[i] : dtMin(bmin[i], obmin[i]);
+		bmax[i] = first ? obmax[i] : dtMax(bmax[i], obmax[i]);
+	}
+}
+
+// The bounds are inclusive, so even a point covers one unit.
+inline float boundsArea(const unsigned short* bmin, const unsigned short* bmax)
+{
+	const float dx = (float)(bmax[0] - bmin[0] + 1);
+	const float dy = (float)(bmax[1] - bmin[1] + 1);
+	const float dz = (float)(bmax[2] - bmin[2] + 1);
+	return dx*dy + dy*dz + dz*dx;
+}
+
+inline int getBin(const BVItem& it, const int axis, const int cmin, const int cmax)
+{
+	const int c = (int)it.bmin[axis] + (int)it.bmax[axis];
+	return (c - cmin) * BV_SAH_BIN_COUNT / (cmax - cmin + 1);
+}
+
+// Partitions the items at the lowest cost binned surface area heuristic split along the 
+// axis with the largest spread of item centers.  Returns the index of the first item of 
+// the second partition, or -1 if the item centers are all the same.
+static int partitionItemsSah(BVItem* items, const int imin, const int imax)
+{
+	// Item centers are doubled to stay integer.
+	int cmin[3] = { 0x7fffffff, 0x7fffffff, 0x7fffffff };
+	int cmax[3] = { 0, 0, 0 };
+	for (int i = imin; i < imax; ++i)
+	{
+		for (int j = 0; j < 3; ++j)
+		{
+			const int c = (int)items[i].bmin[j] + (int)items[i].bmax[j];
+			cmin[j] = dtMin(cmin[j], c);
+			cmax[j] = dtMax(cmax[j], c);
+		}
+	}
+	
+	int axis = 0;
+	for (int j = 1; j < 3; ++j)
+	{
+		if (cmax[j] - cmin[j] > cmax[axis] - cmin[axis])
+			axis = j;
+	}
+	if (cmin[axis] == cmax[axis])
+		return -1;
+	
+	BVBin bins[BV_SAH_BIN_COUNT];
+	for (int i = 0; i < BV_SAH_BIN_COUNT; ++i)
+		bins[i].count = 0;
+	
+	for (int i = imin; i < imax; ++i)
+	{
+		BVBin& bin = bins[getBin(items[i], axis, cmin[axis], cmax[axis])];
+		addBounds(bin.bmin, bin.bmax, items[i].bmin, items[i].bmax, bin.count == 0);
+		bin.count++;
+	}
+	
+	// The cost of the second partition of the split before each bin.
+	float rightCost[BV_SAH_BIN_COUNT];
+	unsigned short bmin[3], bmax[3];
+	int n = 0;
+	for (int i = BV_SAH_BIN_COUNT-1; i > 0; --i)
+	{
+		if (bins[i].count)
+		{
+			addBounds(bmin, bmax, bins[i].bmin, bins[i].bmax, n == 0);
+			n += bins[i].count;
+		}
+		rightCost[i] = n ? boundsArea(bmin, bmax) * n : 0;
+	}
+	
+	float bestCost = FLT_MAX;
+	int bestBin = -1;
+	n = 0;
+	for (int i = 0; i < BV_SAH_BIN_COUNT-1; ++i)
+	{
+		if (bins[i].count)
+		{
+			addBounds(bmin, bmax, bins[i].bmin, bins[i].bmax, n == 0);
+			n += bins[i].count;
+		}
+		if (n == 0 || n == imax - imin)
+			continue;
+		
+		const float cost = boundsArea(bmin, bmax) * n + rightCost[i+1];
+		if (cost < bestCost)
+		{
+			bestCost = cost;
+			bestBin = i+1;
+		}
+	}
+	
+	if (bestBin < 0)
+		return -1;
+	
+	int i = imin;
+	int j = imax-1;
+	while (i <= j)
+	{
+		if (getBin(items[i], axis, cmin[axis], cmax[axis]) < bestBin)
+			i++;
+		else
+			dtSwap(items[i], items[j--]);
+	}
+	
+	return i;
+}
+
+static void subdivide(BVItem* items, int nitems, int imin, int imax, const int split, const int depth,
+					  int& curNode, dtBVNode* nodes)
 {
 	int inum = imax - imin;
 	int icur = curNode;
@@ -135,32 +267,25 @@ static void subdivide(BVItem* items, int nitems, int imin, int imax, int& curNod
 		// Split
 		calcExtends(items, nitems, imin, imax, node.bmin, node.bmax);
 		
-		int	axis = longestAxis(node.bmax[0] - node.bmin[0],
-							   node.bmax[1] - node.bmin[1],
-							   node.bmax[2] - node.bmin[2]);
+		int isplit = -1;
+		if (split == DT_BVTREE_SPLIT_SAH && depth < BV_SAH_MAX_DEPTH)
+			isplit = partitionItemsSah(items, imin, imax);
 		
-		if (axis == 0)
-		{
-			// Sort along x-axis
-			qsort(items+imin, inum, sizeof(BVItem), compareItemX);
-		}
-		else if (axis == 1)
+		if (isplit < 0)
 		{
-			// Sort along y-axis
-			qsort(items+imin, inum, sizeof(BVItem), compareItemY);
-		}
-		else
-		{
-			// Sort along z-axis
-			qsort(items+imin, inum, sizeof(BVItem), compareItemZ);
+			int	axis = longestAxis(node.bmax[0] - node.bmin[0],
+								   node.bmax[1] - node.bmin[1],
+								   node.bmax[2] - node.bmin[2]);
+			
+			// Only the median needs to be in place, not a full sort.
+			isplit = imin+inum/2;
+			selectItems(items, imin, imax, isplit, axis);
 		}
 		
-		int isplit = imin+inum/2;
-		
 		// Left
-		subdivide(items, nitems, imin, isplit, curNode, nodes);
+		subdivide(items, nitems, imin, isplit, split, depth+1, curNode, nodes);
 		// Right
-		subdivide(items, nitems, isplit, imax, curNode, nodes);
+		subdivide(items, nitems, isplit, imax, split, depth+1, curNode, nodes);
 		
 		int iescape = curNode - icur;
 		// Negative index means escape.
@@ -233,7 +358,7 @@ static int createBVTree(dtNavMeshCreateParams* params, dtBVNode* nodes, int /*nn
 	}
 	
 	int curNode = 0;
-	subdivide(items, params->polyCount, 0, params->polyCount, curNode, nodes);
+	subdivide(items, params->polyCount, 0, params->polyCount, params->bvTreeSplit, 0, curNode, nodes);
 	
 	dtFree(items);
 	
@@ -268,6 +393,77 @@ static unsigned char classifyOffMeshPoint(const float* pt, const float* bmin, co
 	return 0xff;	
 }
 
+// Calculates the origin and step used to quantize the unique detail vertices of a compact tile.
+static void calcDetailQuantParams(const dtNavMeshCreateParams* params, const dtPoly* polys, float* qp)
+{
+	float bmin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float bmax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (int i = 0; i < params->polyCount; ++i)
+	{
+		// Skip the first 'nv' verts which are equal to nav poly verts.
+		const int vb = (int)params->detailMeshes[i*4+0];
+		const int ndv = (int)params->detailMeshes[i*4+1];
+		for (int j = polys[i].vertCount; j < ndv; ++j)
+		{
+			dtVmin(bmin, &params->detailVerts[(vb+j)*3]);
+			dtVmax(bmax, &params->detailVerts[(vb+j)*3]);
+		}
+	}
+	// The high bit of z is used by DT_DETAIL_QUANT_EDGE.
+	for (int i = 0; i < 3; ++i)
+		qp[i] = bmin[i];
+	qp[3] = (bmax[0] - bmin[0]) / 65535.0f;
+	qp[4] = (bmax[1] - bmin[1]) / 65535.0f;
+	qp[5] = (bmax[2] - bmin[2]) / 32767.0f;
+}
+
+inline unsigned short quantizeDetailValue(const float v, const float orig, const float step, const int maxValue)
+{
+	const float q = step > 0 ? (v - orig) / step + 0.5f : 0.0f;
+	return (unsigned short)dtClamp((int)q, 0, maxValue);
+}
+
+// Quantizes the unique detail vertices of a polygon.
+// Vertices on the polygon edges are stored relative to the edge, so that 
+// they decode exactly on it and do not leave gaps at the polygon boundary.
+static void quantizeDetailVerts(const float* verts, const int nverts,
+								const float* navVerts, const dtPoly* poly, const float edgeThr,
+								const float* qp, unsigned short* out)
+{
+	for (int i = 0; i < nverts; ++i)
+	{
+		const float* v = &verts[i*3];
+		unsigned short* q = &out[i*3];
+		
+		q[1] = quantizeDetailValue(v[1], qp[1], qp[4], 0xffff);
+		
+		int edge = -1;
+		float edgeT = 0;
+		for (int j = 0; j < poly->vertCount && edge == -1; ++j)
+		{
+			const float* va = &navVerts[poly->verts[j]*3];
+			const float* vb = &navVerts[poly->verts[(j+1) % poly->vertCount]*3];
+			float t;
+			if (dtDistancePtSegSqr2D(v, va, vb, t) < edgeThr)
+			{
+				edge = j;
+				edgeT = t;
+			}
+		}
+		
+		if (edge != -1)
+		{
+			q[0] = (unsigned short)dtClamp((int)(edgeT*65535.0f + 0.5f), 0, 0xffff);
+			q[2] = (unsigned short)(DT_DETAIL_QUANT_EDGE | (edge << 12));
+		}
+		else
+		{
+			q[0] = quantizeDetailValue(v[0], qp[0], qp[3], 0xffff);
+			q[2] = quantizeDetailValue(v[2], qp[2], qp[5], 0x7fff);
+		}
+	}
+}
+
 // TODO: Better error handling.
 
 /// @par
@@ -429,16 +625,19 @@ bool dtCreateNavMeshData(dtNavMeshCreateParams* params, unsigned char** outData,
 	const int polysSize = dtAlign4(sizeof(dtPoly)*totPolyCount);
 	const int linksSize = dtAlign4(sizeof(dtLink)*maxLinkCount);
 	const int detailMeshesSize = dtAlign4(sizeof(dtPolyDetail)*params->polyCount);
-	const int detailVertsSize = dtAlign4(sizeof(float)*3*uniqueDetailVertCount);
+	const int version = params->compactDetail ? DT_NAVMESH_COMPACT_VERSION : DT_NAVMESH_VERSION;
+	const int detailVertsSize = dtGetDetailVertsSize(version, uniqueDetailVertCount);
 	const int detailTrisSize = dtAlign4(sizeof(unsigned char)*4*detailTriCount);
-	const int bvTreeSize = params->buildBvTree ? dtAlign4(sizeof(dtBVNode)*params->polyCount*2) : 0;
+	// The tree has one leaf per polygon, so it always has 2n-1 nodes.
+	const int bvNodeCount = params->buildBvTree ? params->polyCount*2-1 : 0;
+	const int bvTreeSize = dtAlign4(sizeof(dtBVNode)*bvNodeCount);
 	const int offMeshConsSize = dtAlign4(sizeof(dtOffMeshConnection)*storedOffMeshConCount);
 	
 	const int dataSize = headerSize + vertsSize + polysSize + linksSize +
 						 detailMeshesSize + detailVertsSize + detailTrisSize +
 						 bvTreeSize + offMeshConsSize;
 						 
-	unsigned char* data = (unsigned char*)dtAlloc(sizeof(unsigned char)*dataSize, DT_ALLOC_PERM);
+	unsigned char* data = (unsigned char*)dtAlloc(sizeof(unsigned char)*dataSize, DT_ALLOC_PERM, DT_ALLOC_TAG_TILE_DATA);
 	if (!data)
 	{
 		dtFree(offMeshConClass);
@@ -453,7 +652,7 @@ bool dtCreateNavMeshData(dtNavMeshCreateParams* params, unsigned char** outData,
 	dtPoly* navPolys = dtGetThenAdvanceBufferPointer<dtPoly>(d, polysSize);
 	d += linksSize; // Ignore links; just leave enough space for them. They'll be created on load.
 	dtPolyDetail* navDMeshes = dtGetThenAdvanceBufferPointer<dtPolyDetail>(d, detailMeshesSize);
-	float* navDVerts = dtGetThenAdvanceBufferPointer<float>(d, detailVertsSize);
+	unsigned char* navDVerts = dtGetThenAdvanceBufferPointer<unsigned char>(d, detailVertsSize);
 	unsigned char* navDTris = dtGetThenAdvanceBufferPointer<unsigned char>(d, detailTrisSize);
 	dtBVNode* navBvtree = dtGetThenAdvanceBufferPointer<dtBVNode>(d, bvTreeSize);
 	dtOffMeshConnection* offMeshCons = dtGetThenAdvanceBufferPointer<dtOffMeshConnection>(d, offMeshConsSize);
@@ -461,7 +660,7 @@ bool dtCreateNavMeshData(dtNavMeshCreateParams* params, unsigned char** outData,
 	
 	// Store header
 	header->magic = DT_NAVMESH_MAGIC;
-	header->version = DT_NAVMESH_VERSION;
+	header->version = version;
 	header->x = params->tileX;
 	header->y = params->tileY;
 	header->layer = params->tileLayer;
@@ -480,7 +679,7 @@ bool dtCreateNavMeshData(dtNavMeshCreateParams* params, unsigned char** outData,
 	header->walkableRadius = params->walkableRadius;
 	header->walkableClimb = params->walkableClimb;
 	header->offMeshConCount = storedOffMeshConCount;
-	header->bvNodeCount = params->buildBvTree ? params->polyCount*2 : 0;
+	header->bvNodeCount = bvNodeCount;
 	
 	const int offMeshVertsBase = params->vertCount;
 	const int offMeshPolyBase = params->polyCount;
@@ -572,6 +771,16 @@ bool dtCreateNavMeshData(dtNavMeshCreateParams* params, unsigned char** outData,
 	// We compress the mesh data by skipping them and using the navmesh coordinates.
 	if (params->detailMeshes)
 	{
+		// Compact tiles store the quantization values ahead of the vertices.
+		float* quantParams = 0;
+		unsigned short* quantVerts = 0;
+		if (params->compactDetail && uniqueDetailVertCount)
+		{
+			quantParams = (float*)navDVerts;
+			quantVerts = (unsigned short*)(navDVerts + sizeof(float)*6);
+			calcDetailQuantParams(params, navPolys, quantParams);
+		}
+		
 		unsigned short vbase = 0;
 		for (int i = 0; i < params->polyCount; ++i)
 		{
@@ -586,7 +795,14 @@ bool dtCreateNavMeshData(dtNavMeshCreateParams* params, unsigned char** outData,
 			// Copy vertices except the first 'nv' verts which are equal to nav poly verts.
 			if (ndv-nv)
 			{
-				memcpy(&navDVerts[vbase*3], &params->detailVerts[(vb+nv)*3], sizeof(float)*3*(ndv-nv));
+				const float* src = &params->detailVerts[(vb+nv)*3];
+				if (quantVerts)
+				{
+					const float edgeThr = dtSqr(0.001f*params->cs);
+					quantizeDetailVerts(src, ndv-nv, navVerts, &navPolys[i], edgeThr, quantParams, &quantVerts[vbase*3]);
+				}
+				else
+					memcpy((float*)navDVerts + vbase*3, src, sizeof(float)*3*(ndv-nv));
 				vbase += (unsigned short)(ndv-nv);
 			}
 		}
@@ -624,7 +840,7 @@ bool dtCreateNavMeshData(dtNavMeshCreateParams* params, unsigned char** outData,
 	// Store and create BVtree.
 	if (params->buildBvTree)
 	{
-		createBVTree(params, navBvtree, 2*params->polyCount);
+		createBVTree(params, navBvtree, bvNodeCount);
 	}
 	
 	// Store Off-Mesh connections.
@@ -663,11 +879,13 @@ bool dtNavMeshHeaderSwapEndian(unsigned char* data, const int /*dataSize*/)
 	
 	int swappedMagic = DT_NAVMESH_MAGIC;
 	int swappedVersion = DT_NAVMESH_VERSION;
+	int swappedCompactVersion = DT_NAVMESH_COMPACT_VERSION;
 	dtSwapEndian(&swappedMagic);
 	dtSwapEndian(&swappedVersion);
+	dtSwapEndian(&swappedCompactVersion);
 	
-	if ((header->magic != DT_NAVMESH_MAGIC || header->version != DT_NAVMESH_VERSION) &&
-		(header->magic != swappedMagic || header->version != swappedVersion))
+	if ((header->magic != DT_NAVMESH_MAGIC || !dtIsNavMeshVersion(header->version)) &&
+		(header->magic != swappedMagic || (header->version != swappedVersion && header->version != swappedCompactVersion)))
 	{
 		return false;
 	}
@@ -715,8 +933,9 @@ bool dtNavMeshDataSwapEndian(unsigned char* data, const int /*dataSize*/)
 	dtMeshHeader* header = (dtMeshHeader*)data;
 	if (header->magic != DT_NAVMESH_MAGIC)
 		return false;
-	if (header->version != DT_NAVMESH_VERSION)
+	if (!dtIsNavMeshVersion(header->version))
 		return false;
+	const bool compact = header->version == DT_NAVMESH_COMPACT_VERSION;
 	
 	// Patch header pointers.
 	const int headerSize = dtAlign4(sizeof(dtMeshHeader));
@@ -724,7 +943,7 @@ bool dtNavMeshDataSwapEndian(unsigned char* data, const int /*dataSize*/)
 	const int polysSize = dtAlign4(sizeof(dtPoly)*header->polyCount);
 	const int linksSize = dtAlign4(sizeof(dtLink)*(header->maxLinkCount));
 	const int detailMeshesSize = dtAlign4(sizeof(dtPolyDetail)*header->detailMeshCount);
-	const int detailVertsSize = dtAlign4(sizeof(float)*3*header->detailVertCount);
+	const int detailVertsSize = dtGetDetailVertsSize(header->version, header->detailVertCount);
 	const int detailTrisSize = dtAlign4(sizeof(unsigned char)*4*header->detailTriCount);
 	const int bvtreeSize = dtAlign4(sizeof(dtBVNode)*header->bvNodeCount);
 	const int offMeshLinksSize = dtAlign4(sizeof(dtOffMeshConnection)*header->offMeshConCount);
@@ -735,7 +954,7 @@ bool dtNavMeshDataSwapEndian(unsigned char* data, const int /*dataSize*/)
 	d += linksSize; // Ignore links; they technically should be endian-swapped but all their data is overwritten on load anyway.
 	//dtLink* links = dtGetThenAdvanceBufferPointer<dtLink>(d, linksSize);
 	dtPolyDetail* detailMeshes = dtGetThenAdvanceBufferPointer<dtPolyDetail>(d, detailMeshesSize);
-	float* detailVerts = dtGetThenAdvanceBufferPointer<float>(d, detailVertsSize);
+	unsigned char* detailVerts = dtGetThenAdvanceBufferPointer<unsigned char>(d, detailVertsSize);
 	d += detailTrisSize; // Ignore detail tris; single bytes can't be endian-swapped.
 	//unsigned char* detailTris = dtGetThenAdvanceBufferPointer<unsigned char>(d, detailTrisSize);
 	dtBVNode* bvTree = dtGetThenAdvanceBufferPointer<dtBVNode>(d, bvtreeSize);
@@ -771,9 +990,19 @@ bool dtNavMeshDataSwapEndian(unsigned char* data, const int /*dataSize*/)
 	}
 	
 	// Detail verts
-	for (int i = 0; i < header->detailVertCount*3; ++i)
+	if (compact && header->detailVertCount)
+	{
+		float* quantParams = (float*)detailVerts;
+		unsigned short* quantVerts = (unsigned short*)(detailVerts + sizeof(float)*6);
+		for (int i = 0; i < 6; ++i)
+			dtSwapEndian(&quantParams[i]);
+		for (int i = 0; i < header->detailVertCount*3; ++i)
+			dtSwapEndian(&quantVerts[i]);
+	}
+	else if (!compact)
 	{
-		dtSwapEndian(&detailVerts[i]);
+		for (int i = 0; i < header->detailVertCount*3; ++i)
+			dtSwapEndian(&((float*)detailVerts)[i]);
 	}
 
 	// BV-tree
@@ -19,6 +19,7 @@
 #include <float.h>
 #include <string.h>
 #include "DetourNavMeshQuery.h"
+#include "DetourNavMeshQueryTemplates.h"
 #include "DetourNavMesh.h"
 #include "DetourNode.h"
 #include "DetourCommon.h"
@@ -83,29 +84,13 @@ float dtQueryFilter::getCost(const float* pa, const float* pb,
 {
 	return dtVdist(pa, pb) * m_areaCost[curPoly->getArea()];
 }
-#else
-inline bool dtQueryFilter::passFilter(const dtPolyRef /*ref*/,
-									  const dtMeshTile* /*tile*/,
-									  const dtPoly* poly) const
-{
-	return (poly->flags & m_includeFlags) != 0 && (poly->flags & m_excludeFlags) == 0;
-}
-
-inline float dtQueryFilter::getCost(const float* pa, const float* pb,
-									const dtPolyRef /*prevRef*/, const dtMeshTile* /*prevTile*/, const dtPoly* /*prevPoly*/,
-									const dtPolyRef /*curRef*/, const dtMeshTile* /*curTile*/, const dtPoly* curPoly,
-									const dtPolyRef /*nextRef*/, const dtMeshTile* /*nextTile*/, const dtPoly* /*nextPoly*/) const
-{
-	return dtVdist(pa, pb) * m_areaCost[curPoly->getArea()];
-}
 #endif	
 	
-static const float H_SCALE = 0.999f; // Search heuristic scale.
 
 
 dtNavMeshQuery* dtAllocNavMeshQuery()
 {
-	void* mem = dtAlloc(sizeof(dtNavMeshQuery), DT_ALLOC_PERM);
+	void* mem = dtAlloc(sizeof(dtNavMeshQuery), DT_ALLOC_PERM, DT_ALLOC_TAG_QUERY);
 	if (!mem) return 0;
 	return new(mem) dtNavMeshQuery;
 }
@@ -117,6 +102,22 @@ void dtFreeNavMeshQuery(dtNavMeshQuery* navmesh)
 	dtFree(navmesh);
 }
 
+// The filter-specialized queries for the built-in filters.
+template dtStatus dtNavMeshQuery::findPathT<dtQueryFilter>(dtPolyRef, dtPolyRef, const float*, const float*,
+														   const dtQueryFilter*, dtPolyRef*, int*, const int) const;
+template dtStatus dtNavMeshQuery::raycastT<dtQueryFilter>(dtPolyRef, const float*, const float*,
+														  const dtQueryFilter*, const unsigned int, dtRaycastHit*, dtPolyRef) const;
+template dtStatus dtNavMeshQuery::findPolysAroundCircleT<dtQueryFilter>(dtPolyRef, const float*, const float,
+																		const dtQueryFilter*, dtPolyRef*, dtPolyRef*, float*,
+																		int*, const int) const;
+template dtStatus dtNavMeshQuery::findPathT<dtIncludeQueryFilter>(dtPolyRef, dtPolyRef, const float*, const float*,
+																  const dtIncludeQueryFilter*, dtPolyRef*, int*, const int) const;
+template dtStatus dtNavMeshQuery::raycastT<dtIncludeQueryFilter>(dtPolyRef, const float*, const float*,
+																 const dtIncludeQueryFilter*, const unsigned int, dtRaycastHit*, dtPolyRef) const;
+template dtStatus dtNavMeshQuery::findPolysAroundCircleT<dtIncludeQueryFilter>(dtPolyRef, const float*, const float,
+																			   const dtIncludeQueryFilter*, dtPolyRef*, dtPolyRef*, float*,
+																			   int*, const int) const;
+
 //////////////////////////////////////////////////////////////////////////////////////////
 
 /// @class dtNavMeshQuery
@@ -137,24 +138,91 @@ void dtFreeNavMeshQuery(dtNavMeshQuery* navmesh)
 
 dtNavMeshQuery::dtNavMeshQuery() :
 	m_nav(0),
+	m_reader(-1),
+	m_readDepth(0),
 	m_tinyNodePool(0),
 	m_nodePool(0),
-	m_openList(0)
+	m_openList(0),
+	m_backNodePool(0),
+	m_backOpenList(0)
 {
 	memset(&m_query, 0, sizeof(dtQueryData));
+	resetQueryStats();
 }
 
 dtNavMeshQuery::~dtNavMeshQuery()
 {
+	if (m_nav && m_reader >= 0)
+		m_nav->releaseReader(m_reader);
 	if (m_tinyNodePool)
 		m_tinyNodePool->~dtNodePool();
 	if (m_nodePool)
 		m_nodePool->~dtNodePool();
 	if (m_openList)
 		m_openList->~dtNodeQueue();
+	if (m_backNodePool)
+		m_backNodePool->~dtNodePool();
+	if (m_backOpenList)
+		m_backOpenList->~dtNodeQueue();
 	dtFree(m_tinyNodePool);
 	dtFree(m_nodePool);
 	dtFree(m_openList);
+	dtFree(m_backNodePool);
+	dtFree(m_backOpenList);
+}
+
+/// @par
+///
+/// The query acquires a reader slot of the mesh on its first read and keeps it until
+/// it is destroyed or initialized again.  So the mesh needs a slot for each query 
+/// that starts reads. (Queries used only inside the read of another query do not 
+/// need one. E.g. The worker queries of a crowd.)  If all slots are in use the read
+/// fails with #DT_BUFFER_TOO_SMALL.  Calling #endRead after a failed read is 
+/// harmless.
+dtStatus dtNavMeshQuery::beginRead()
+{
+	if (!m_nav)
+		return DT_FAILURE | DT_INVALID_PARAM;
+	if (m_readDepth)
+	{
+		m_readDepth++;
+		return DT_SUCCESS;
+	}
+	if (m_nav->getConcurrentReadsEnabled())
+	{
+		if (m_reader < 0)
+			m_reader = m_nav->acquireReader();
+		if (m_reader < 0)
+			return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+		m_nav->beginRead(m_reader);
+	}
+	m_readDepth = 1;
+	return DT_SUCCESS;
+}
+
+void dtNavMeshQuery::endRead()
+{
+	if (!m_nav || !m_readDepth)
+		return;
+	if (--m_readDepth)
+		return;
+	m_nav->endRead(m_reader);
+}
+
+int dtNavMeshQuery::getMemUsed() const
+{
+	int mem = sizeof(dtNavMeshQuery);
+	if (m_tinyNodePool)
+		mem += m_tinyNodePool->getMemUsed();
+	if (m_nodePool)
+		mem += m_nodePool->getMemUsed();
+	if (m_openList)
+		mem += m_openList->getMemUsed();
+	if (m_backNodePool)
+		mem += m_backNodePool->getMemUsed();
+	if (m_backOpenList)
+		mem += m_backOpenList->getMemUsed();
+	return mem;
 }
 
 /// @par 
@@ -165,10 +233,14 @@ dtNavMeshQuery::~dtNavMeshQuery()
 /// This function can be used multiple times.
 dtStatus dtNavMeshQuery::init(const dtNavMesh* nav, const int maxNodes)
 {
-	if (maxNodes > DT_NULL_IDX || maxNodes > (1 << DT_NODE_PARENT_BITS) - 1)
+	if (maxNodes <= 0 || (unsigned int)maxNodes > (unsigned int)DT_NULL_IDX || maxNodes > (1 << DT_NODE_PARENT_BITS) - 1)
 		return DT_FAILURE | DT_INVALID_PARAM;
 
+	if (m_nav && m_reader >= 0)
+		m_nav->releaseReader(m_reader);
 	m_nav = nav;
+	m_reader = -1;
+	m_readDepth = 0;
 	
 	if (!m_nodePool || m_nodePool->getMaxNodes() < maxNodes)
 	{
@@ -178,7 +250,7 @@ dtStatus dtNavMeshQuery::init(const dtNavMesh* nav, const int maxNodes)
 			dtFree(m_nodePool);
 			m_nodePool = 0;
 		}
-		m_nodePool = new (dtAlloc(sizeof(dtNodePool), DT_ALLOC_PERM)) dtNodePool(maxNodes, dtNextPow2(maxNodes/4));
+		m_nodePool = new (dtAlloc(sizeof(dtNodePool), DT_ALLOC_PERM, DT_ALLOC_TAG_QUERY)) dtNodePool(maxNodes, dtNextPow2(maxNodes/4));
 		if (!m_nodePool)
 			return DT_FAILURE | DT_OUT_OF_MEMORY;
 	}
@@ -189,7 +261,7 @@ dtStatus dtNavMeshQuery::init(const dtNavMesh* nav, const int maxNodes)
 	
 	if (!m_tinyNodePool)
 	{
-		m_tinyNodePool = new (dtAlloc(sizeof(dtNodePool), DT_ALLOC_PERM)) dtNodePool(64, 32);
+		m_tinyNodePool = new (dtAlloc(sizeof(dtNodePool), DT_ALLOC_PERM, DT_ALLOC_TAG_QUERY)) dtNodePool(64, 32);
 		if (!m_tinyNodePool)
 			return DT_FAILURE | DT_OUT_OF_MEMORY;
 	}
@@ -206,7 +278,7 @@ dtStatus dtNavMeshQuery::init(const dtNavMesh* nav, const int maxNodes)
 			dtFree(m_openList);
 			m_openList = 0;
 		}
-		m_openList = new (dtAlloc(sizeof(dtNodeQueue), DT_ALLOC_PERM)) dtNodeQueue(maxNodes);
+		m_openList = new (dtAlloc(sizeof(dtNodeQueue), DT_ALLOC_PERM, DT_ALLOC_TAG_QUERY)) dtNodeQueue(maxNodes);
 		if (!m_openList)
 			return DT_FAILURE | DT_OUT_OF_MEMORY;
 	}
@@ -229,7 +301,7 @@ dtStatus dtNavMeshQuery::findRandomPoint(const dtQueryFilter* filter, float (*fr
 	for (int i = 0; i < m_nav->getMaxTiles(); i++)
 	{
 		const dtMeshTile* t = m_nav->getTile(i);
-		if (!t || !t->header) continue;
+		if (!t || !t->header || (t->flags & DT_TILE_RETIRED)) continue;
 		
 		// Choose random tile using reservoi sampling.
 		const float area = 1.0f; // Could be tile area too.
@@ -328,6 +400,8 @@ dtStatus dtNavMeshQuery::findRandomPointAroundCircle(dtPolyRef startRef, const f
 	if (!filter->passFilter(startRef, startTile, startPoly))
 		return DT_FAILURE | DT_INVALID_PARAM;
 	
+	DT_QUERY_STATS_BEGIN();
+
 	m_nodePool->clear();
 	m_openList->clear();
 	
@@ -339,6 +413,7 @@ dtStatus dtNavMeshQuery::findRandomPointAroundCircle(dtPolyRef startRef, const f
 	startNode->id = startRef;
 	startNode->flags = DT_NODE_OPEN;
 	m_openList->push(startNode);
+	DT_QUERY_STAT(openListPushes);
 	
 	dtStatus status = DT_SUCCESS;
 	
@@ -352,6 +427,7 @@ dtStatus dtNavMeshQuery::findRandomPointAroundCircle(dtPolyRef startRef, const f
 	while (!m_openList->empty())
 	{
 		dtNode* bestNode = m_openList->pop();
+		DT_QUERY_STAT(nodesExpanded);
 		bestNode->flags &= ~DT_NODE_OPEN;
 		bestNode->flags |= DT_NODE_CLOSED;
 		
@@ -451,11 +527,15 @@ dtStatus dtNavMeshQuery::findRandomPointAroundCircle(dtPolyRef startRef, const f
 			if (neighbourNode->flags & DT_NODE_OPEN)
 			{
 				m_openList->modify(neighbourNode);
+				DT_QUERY_STAT(openListModifies);
 			}
 			else
 			{
 				neighbourNode->flags = DT_NODE_OPEN;
 				m_openList->push(neighbourNode);
+				DT_QUERY_STAT(openListPushes);
+				if (neighbourTile != bestTile)
+					DT_QUERY_STAT(tileCrossings);
 			}
 		}
 	}
@@ -527,9 +607,6 @@ dtStatus dtNavMeshQuery::closestPointOnPoly(dtPolyRef ref, const float* pos, flo
 		return DT_SUCCESS;
 	}
 
-	const unsigned int ip = (unsigned int)(poly - tile->polys);
-	const dtPolyDetail* pd = &tile->detailMeshes[ip];
-
 	// Clamp point to be inside the polygon.
 	float verts[DT_VERTS_PER_POLYGON*3];	
 	float edged[DT_VERTS_PER_POLYGON];
@@ -566,24 +643,9 @@ dtStatus dtNavMeshQuery::closestPointOnPoly(dtPolyRef ref, const float* pos, flo
 	}
 
 	// Find height at the location.
-	for (int j = 0; j < pd->triCount; ++j)
-	{
-		const unsigned char* t = &tile->detailTris[(pd->triBase+j)*4];
-		const float* v[3];
-		for (int k = 0; k < 3; ++k)
-		{
-			if (t[k] < poly->vertCount)
-				v[k] = &tile->verts[poly->verts[t[k]]*3];
-			else
-				v[k] = &tile->detailVerts[(pd->vertBase+(t[k]-poly->vertCount))*3];
-		}
-		float h;
-		if (dtClosestHeightPointTriangle(closest, v[0], v[1], v[2], h))
-		{
-			closest[1] = h;
-			break;
-		}
-	}
+	float h;
+	if (dtGetDetailHeight(tile, poly, closest, &h))
+		closest[1] = h;
 	
 	return DT_SUCCESS;
 }
@@ -673,26 +735,12 @@ dtStatus dtNavMeshQuery::getPolyHeight(dtPolyRef ref, const float* pos, float* h
 	}
 	else
 	{
-		const unsigned int ip = (unsigned int)(poly - tile->polys);
-		const dtPolyDetail* pd = &tile->detailMeshes[ip];
-		for (int j = 0; j < pd->triCount; ++j)
+		float h;
+		if (dtGetDetailHeight(tile, poly, pos, &h))
 		{
-			const unsigned char* t = &tile->detailTris[(pd->triBase+j)*4];
-			const float* v[3];
-			for (int k = 0; k < 3; ++k)
-			{
-				if (t[k] < poly->vertCount)
-					v[k] = &tile->verts[poly->verts[t[k]]*3];
-				else
-					v[k] = &tile->detailVerts[(pd->vertBase+(t[k]-poly->vertCount))*3];
-			}
-			float h;
-			if (dtClosestHeightPointTriangle(pos, v[0], v[1], v[2], h))
-			{
-				if (height)
-					*height = h;
-				return DT_SUCCESS;
-			}
+			if (height)
+				*height = h;
+			return DT_SUCCESS;
 		}
 	}
 	
@@ -718,71 +766,423 @@ public:
 
 	void process(const dtMeshTile* tile, dtPoly** polys, dtPolyRef* refs, int count)
 	{
-		dtIgnoreUnused(polys);
+		const int nearest = dtFindNearestPolyInList(tile, polys, count, m_center,
+													&m_nearestDistanceSqr, m_nearestPoint);
+		if (nearest != -1)
+			m_nearestRef = refs[nearest];
+	}
+};
+
+/// @par 
+///
+/// @note If the search box does not intersect any polygons the search will 
+/// return #DT_SUCCESS, but @p nearestRef will be zero. So if in doubt, check 
+/// @p nearestRef before using @p nearestPt.
+///
+dtStatus dtNavMeshQuery::findNearestPoly(const float* center, const float* halfExtents,
+										 const dtQueryFilter* filter,
+										 dtPolyRef* nearestRef, float* nearestPt) const
+{
+	dtAssert(m_nav);
 
-		for (int i = 0; i < count; ++i)
+	if (!nearestRef)
+		return DT_FAILURE | DT_INVALID_PARAM;
+	
+	dtFindNearestPolyQuery query(this, center);
+
+	dtStatus status = queryPolygons(center, halfExtents, filter, &query);
+	if (dtStatusFailed(status))
+		return status;
+
+	*nearestRef = query.nearestRef();
+	// Only override nearestPt if we actually found a poly so the nearest point
+	// is valid.
+	if (nearestPt && *nearestRef)
+		dtVcopy(nearestPt, query.nearestPoint());
+	
+	return DT_SUCCESS;
+}
+
+// Quantizes the query box to the bounding volume space of the tile.
+static void quantizeQueryBounds(const dtMeshHeader* header, const float* qmin, const float* qmax,
+								unsigned short* bmin, unsigned short* bmax)
+{
+	const float* tbmin = header->bmin;
+	const float* tbmax = header->bmax;
+	const float qfac = header->bvQuantFactor;
+
+	// dtClamp query box to world box.
+	float minx = dtClamp(qmin[0], tbmin[0], tbmax[0]) - tbmin[0];
+	float miny = dtClamp(qmin[1], tbmin[1], tbmax[1]) - tbmin[1];
+	float minz = dtClamp(qmin[2], tbmin[2], tbmax[2]) - tbmin[2];
+	float maxx = dtClamp(qmax[0], tbmin[0], tbmax[0]) - tbmin[0];
+	float maxy = dtClamp(qmax[1], tbmin[1], tbmax[1]) - tbmin[1];
+	float maxz = dtClamp(qmax[2], tbmin[2], tbmax[2]) - tbmin[2];
+	// Quantize
+	bmin[0] = (unsigned short)(qfac * minx) & 0xfffe;
+	bmin[1] = (unsigned short)(qfac * miny) & 0xfffe;
+	bmin[2] = (unsigned short)(qfac * minz) & 0xfffe;
+	bmax[0] = (unsigned short)(qfac * maxx + 1) | 1;
+	bmax[1] = (unsigned short)(qfac * maxy + 1) | 1;
+	bmax[2] = (unsigned short)(qfac * maxz + 1) | 1;
+}
+
+// Returns a lower bound of the distance dtFindNearestPolyQuery measures from 
+// the center to any polygon within the bounds.
+static float nearestPolyDistanceBound(const float* center, const float* bmin, const float* bmax,
+									  const float walkableClimb)
+{
+	const float dx = dtMax(dtMax(bmin[0] - center[0], center[0] - bmax[0]), 0.0f);
+	const float dy = dtMax(dtMax(bmin[1] - center[1], center[1] - bmax[1]), 0.0f);
+	const float dz = dtMax(dtMax(bmin[2] - center[2], center[2] - bmax[2]), 0.0f);
+	const float dxz = dx*dx + dz*dz;
+	if (dxz > 0)
+		return dxz + dy*dy;
+	// The center may be directly over a polygon, which is measured by height only.
+	const float d = dy - walkableClimb;
+	return d > 0 ? d*d : 0;
+}
+
+// Finds the nearest polygon the same way dtFindNearestPolyQuery does, but visits 
+// the polygons of each tile nearest first and skips those that cannot be closer 
+// than the best one so far. Every candidate is keyed by the order in which 
+// queryPolygons() would have visited it, and ties are resolved by that order, 
+// so the result does not depend on the order the tiles and cells are searched.
+class dtFindNearestPolyGridQuery
+{
+	const dtNavMeshQuery* m_query;
+	const dtNavMesh* m_nav;
+	const float* m_center;
+	const float* m_qmin;
+	const float* m_qmax;
+	const dtQueryFilter* m_filter;
+	float m_nearestDistanceSqr;
+	dtPolyRef m_nearestRef;
+	float m_nearestPoint[3];
+	int m_nearestKey[3];
+
+public:
+	dtFindNearestPolyGridQuery(const dtNavMeshQuery* query, const dtNavMesh* nav, const float* center,
+							   const float* qmin, const float* qmax, const dtQueryFilter* filter)
+		: m_query(query), m_nav(nav), m_center(center), m_qmin(qmin), m_qmax(qmax), m_filter(filter),
+		  m_nearestDistanceSqr(FLT_MAX), m_nearestRef(0), m_nearestPoint()
+	{
+		m_nearestKey[0] = m_nearestKey[1] = m_nearestKey[2] = 0;
+	}
+
+	dtPolyRef nearestRef() const { return m_nearestRef; }
+	const float* nearestPoint() const { return m_nearestPoint; }
+
+	// Searches a tile. Returns false if the tile could be skipped.
+	//  order	The index of the tile's location in the order queryPolygons() visits them.
+	//  layer	The index of the tile within its location.
+	bool searchTile(const dtMeshTile* tile, const int order, const int layer)
+	{
+		const dtPolyGrid* grid = tile->polyGrid;
+		if (!grid)
+			return false;
+
+		const float climb = tile->header->walkableClimb;
+		if (nearestPolyDistanceBound(m_center, grid->bmin, grid->bmax, climb) > m_nearestDistanceSqr)
+			return false;
+
+		// Find the cells a candidate polygon can cover.
+		unsigned short qbmin[3], qbmax[3];
+		float rmin[3], rmax[3];
+		dtVcopy(rmin, m_qmin);
+		dtVcopy(rmax, m_qmax);
+		if (tile->bvTree)
+		{
+			const dtMeshHeader* header = tile->header;
+			quantizeQueryBounds(header, m_qmin, m_qmax, qbmin, qbmax);
+			rmin[0] = dtMin(rmin[0], header->bmin[0] + qbmin[0] / header->bvQuantFactor);
+			rmin[2] = dtMin(rmin[2], header->bmin[2] + qbmin[2] / header->bvQuantFactor);
+			rmax[0] = dtMax(rmax[0], header->bmin[0] + qbmax[0] / header->bvQuantFactor);
+			rmax[2] = dtMax(rmax[2], header->bmin[2] + qbmax[2] / header->bvQuantFactor);
+		}
+		int x0, z0, x1, z1, cx, cz;
+		dtCalcPolyGridCell(grid, rmin, x0, z0);
+		dtCalcPolyGridCell(grid, rmax, x1, z1);
+		dtCalcPolyGridCell(grid, m_center, cx, cz);
+		cx = dtClamp(cx, x0, x1);
+		cz = dtClamp(cz, z0, z1);
+
+		const dtPolyRef base = m_nav->getPolyRefBase(tile);
+		const int maxRing = dtMax(dtMax(cx - x0, x1 - cx), dtMax(cz - z0, z1 - cz));
+		for (int r = 0; r <= maxRing; ++r)
+		{
+			// Every polygon in the ring is at least this far from the center.
+			if (r > 1)
+			{
+				const float d = (float)(r-1) * grid->cellSize * 0.999f;
+				if (d*d > m_nearestDistanceSqr)
+					break;
+			}
+			for (int z = dtMax(cz - r, z0); z <= dtMin(cz + r, z1); ++z)
+			{
+				const bool edge = z == cz - r || z == cz + r;
+				const int step = edge ? 1 : 2*r;
+				for (int x = cx - r; x <= cx + r; x += step)
+				{
+					if (x < x0 || x > x1)
+						continue;
+					searchCell(tile, base, x, z, cx, cz, order, layer, qbmin, qbmax);
+				}
+			}
+		}
+		return true;
+	}
+
+private:
+	void searchCell(const dtMeshTile* tile, const dtPolyRef base, const int x, const int z,
+					const int cx, const int cz, const int order, const int layer,
+					const unsigned short* qbmin, const unsigned short* qbmax)
+	{
+		const dtPolyGrid* grid = tile->polyGrid;
+		const int cell = x + z*grid->width;
+		for (int i = grid->cellStart[cell]; i < grid->cellStart[cell+1]; ++i)
 		{
-			dtPolyRef ref = refs[i];
+			const dtPolyGridItem& item = grid->items[grid->cellItems[i]];
+
+			// An item is handled only by its cell nearest the center cell.
+			if (dtClamp(cx, (int)item.cmin[0], (int)item.cmax[0]) != x ||
+				dtClamp(cz, (int)item.cmin[1], (int)item.cmax[1]) != z)
+				continue;
+			
+			if (nearestPolyDistanceBound(m_center, item.bmin, item.bmax, tile->header->walkableClimb) > m_nearestDistanceSqr)
+				continue;
+
+			// Apply the same overlap test as queryPolygonsInTile().
+			int ip;
+			if (tile->bvTree)
+			{
+				const dtBVNode* node = &tile->bvTree[item.index];
+				if (!dtOverlapQuantBounds(qbmin, qbmax, node->bmin, node->bmax))
+					continue;
+				ip = node->i;
+			}
+			else
+			{
+				ip = item.index;
+				const dtPoly* p = &tile->polys[ip];
+				float bmin[3], bmax[3];
+				const float* v = &tile->verts[p->verts[0]*3];
+				dtVcopy(bmin, v);
+				dtVcopy(bmax, v);
+				for (int j = 1; j < p->vertCount; ++j)
+				{
+					v = &tile->verts[p->verts[j]*3];
+					dtVmin(bmin, v);
+					dtVmax(bmax, v);
+				}
+				if (!dtOverlapBounds(m_qmin, m_qmax, bmin, bmax))
+					continue;
+			}
+
+			const dtPolyRef ref = base | (dtPolyRef)ip;
+			if (!m_filter->passFilter(ref, tile, &tile->polys[ip]))
+				continue;
+
 			float closestPtPoly[3];
 			float diff[3];
 			bool posOverPoly = false;
 			float d;
 			m_query->closestPointOnPoly(ref, m_center, closestPtPoly, &posOverPoly);
 
-			// If a point is directly over a polygon and closer than
-			// climb height, favor that instead of straight line nearest point.
 			dtVsub(diff, m_center, closestPtPoly);
 			if (posOverPoly)
 			{
 				d = dtAbs(diff[1]) - tile->header->walkableClimb;
-				d = d > 0 ? d*d : 0;			
+				d = d > 0 ? d*d : 0;
 			}
 			else
 			{
 				d = dtVlenSqr(diff);
 			}
-			
-			if (d < m_nearestDistanceSqr)
+
+			if (d < m_nearestDistanceSqr || (d == m_nearestDistanceSqr && m_nearestRef && 
+				isBefore(order, layer, item.index)))
 			{
 				dtVcopy(m_nearestPoint, closestPtPoly);
 
 				m_nearestDistanceSqr = d;
 				m_nearestRef = ref;
+				m_nearestKey[0] = order;
+				m_nearestKey[1] = layer;
+				m_nearestKey[2] = item.index;
 			}
 		}
 	}
+
+	bool isBefore(const int order, const int layer, const int index) const
+	{
+		if (order != m_nearestKey[0])
+			return order < m_nearestKey[0];
+		if (layer != m_nearestKey[1])
+			return layer < m_nearestKey[1];
+		return index < m_nearestKey[2];
+	}
 };
 
 /// @par 
 ///
+/// With #DT_NEARESTPOLY_GRID the polygon grids of the tiles are used to search 
+/// the polygons nearest to the center first and to stop once no remaining 
+/// polygon can be closer. The result is the same as without the option, but the
+/// cost no longer grows with the number of polygons in the search box, which makes
+/// large search extents affordable. The option is ignored unless polygon grids 
+/// are enabled for the navigation mesh. (See: dtNavMesh::setPolyGridsEnabled)
+///
 /// @note If the search box does not intersect any polygons the search will 
 /// return #DT_SUCCESS, but @p nearestRef will be zero. So if in doubt, check 
 /// @p nearestRef before using @p nearestPt.
 ///
 dtStatus dtNavMeshQuery::findNearestPoly(const float* center, const float* halfExtents,
 										 const dtQueryFilter* filter,
-										 dtPolyRef* nearestRef, float* nearestPt) const
+										 dtPolyRef* nearestRef, float* nearestPt, const int options) const
 {
 	dtAssert(m_nav);
 
-	if (!nearestRef)
+	if (!(options & DT_NEARESTPOLY_GRID) || !m_nav->getPolyGridsEnabled())
+		return findNearestPoly(center, halfExtents, filter, nearestRef, nearestPt);
+
+	if (!nearestRef || !center || !halfExtents || !filter)
 		return DT_FAILURE | DT_INVALID_PARAM;
+
+	DT_QUERY_STATS_BEGIN();
+
+	float bmin[3], bmax[3];
+	dtVsub(bmin, center, halfExtents);
+	dtVadd(bmax, center, halfExtents);
+
+	dtFindNearestPolyGridQuery query(this, m_nav, center, bmin, bmax, filter);
+
+	int minx, miny, maxx, maxy, tx, ty;
+	m_nav->calcTileLoc(bmin, &minx, &miny);
+	m_nav->calcTileLoc(bmax, &maxx, &maxy);
+	m_nav->calcTileLoc(center, &tx, &ty);
 	
-	dtFindNearestPolyQuery query(this, center);
+	static const int MAX_NEIS = 32;
+	const dtMeshTile* neis[MAX_NEIS];
+	const int w = maxx - minx + 1;
 
-	dtStatus status = queryPolygons(center, halfExtents, filter, &query);
-	if (dtStatusFailed(status))
-		return status;
+	// Search the tiles at the center first so that the others can usually be skipped.
+	int nneis = m_nav->getTilesAt(tx, ty, neis, MAX_NEIS);
+	for (int j = 0; j < nneis; ++j)
+	{
+		if (query.searchTile(neis[j], (ty-miny)*w + (tx-minx), j))
+			DT_QUERY_STAT(tilesQueried);
+	}
+	
+	for (int y = miny; y <= maxy; ++y)
+	{
+		for (int x = minx; x <= maxx; ++x)
+		{
+			if (x == tx && y == ty)
+				continue;
+			nneis = m_nav->getTilesAt(x, y, neis, MAX_NEIS);
+			for (int j = 0; j < nneis; ++j)
+			{
+				if (query.searchTile(neis[j], (y-miny)*w + (x-minx), j))
+					DT_QUERY_STAT(tilesQueried);
+			}
+		}
+	}
 
 	*nearestRef = query.nearestRef();
 	// Only override nearestPt if we actually found a poly so the nearest point
 	// is valid.
 	if (nearestPt && *nearestRef)
 		dtVcopy(nearestPt, query.nearestPoint());
-	
+
 	return DT_SUCCESS;
 }
 
+// Returns true if the center is directly over the polygon and the polygon
+// would be measured at zero distance by dtFindNearestPolyQuery.
+static bool isOverPolyWithinClimb(const dtNavMeshQuery* query, dtPolyRef ref,
+								  const dtMeshTile* tile, const dtPoly* poly,
+								  const float* center, const float* halfExtents,
+								  const dtQueryFilter* filter, float* height)
+{
+	if (poly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION)
+		return false;
+	if (!filter->passFilter(ref, tile, poly))
+		return false;
+
+	float verts[DT_VERTS_PER_POLYGON*3];
+	const int nv = poly->vertCount;
+	for (int i = 0; i < nv; ++i)
+		dtVcopy(&verts[i*3], &tile->verts[poly->verts[i]*3]);
+	if (!dtPointInPolygon(center, verts, nv))
+		return false;
+
+	if (dtStatusFailed(query->getPolyHeight(ref, center, height)))
+		return false;
+	const float dy = dtAbs(center[1] - *height);
+	return dy <= tile->header->walkableClimb && dy <= halfExtents[1];
+}
+
+/// @par
+///
+/// If the center is directly over the hint polygon, or over one of the polygons
+/// linked to it, and no further above or below it than the walkable climb of
+/// the tile, that polygon is the result. A polygon like that is at the smallest
+/// distance findNearestPoly() measures. Otherwise, or if the hint is not a
+/// valid polygon, the result is the same as findNearestPoly().
+///
+/// When several polygons are at the smallest distance, findNearestPoly() may
+/// choose a different one than this function does. (E.g. When the center is on
+/// the edge between two polygons.) Preferring the hint keeps the result from 
+/// flipping between such polygons from one update to the next.
+///
+/// @note If the search box does not intersect any polygons the search will 
+/// return #DT_SUCCESS, but @p nearestRef will be zero. So if in doubt, check 
+/// @p nearestRef before using @p nearestPt.
+///
+dtStatus dtNavMeshQuery::findNearestPolyHinted(dtPolyRef hintRef, const float* center, const float* halfExtents,
+											   const dtQueryFilter* filter,
+											   dtPolyRef* nearestRef, float* nearestPt, const int options) const
+{
+	dtAssert(m_nav);
+
+	if (!nearestRef || !center || !halfExtents || !filter)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	const dtMeshTile* tile = 0;
+	const dtPoly* poly = 0;
+	if (hintRef && dtStatusSucceed(m_nav->getTileAndPolyByRef(hintRef, &tile, &poly)))
+	{
+		float h;
+		if (isOverPolyWithinClimb(this, hintRef, tile, poly, center, halfExtents, filter, &h))
+		{
+			*nearestRef = hintRef;
+			if (nearestPt)
+				dtVset(nearestPt, center[0], h, center[2]);
+			return DT_SUCCESS;
+		}
+
+		for (unsigned int i = poly->firstLink; i != DT_NULL_LINK; i = tile->links[i].next)
+		{
+			const dtPolyRef neiRef = tile->links[i].ref;
+			if (!neiRef)
+				continue;
+			const dtMeshTile* neiTile = 0;
+			const dtPoly* neiPoly = 0;
+			m_nav->getTileAndPolyByRefUnsafe(neiRef, &neiTile, &neiPoly);
+			if (isOverPolyWithinClimb(this, neiRef, neiTile, neiPoly, center, halfExtents, filter, &h))
+			{
+				*nearestRef = neiRef;
+				if (nearestPt)
+					dtVset(nearestPt, center[0], h, center[2]);
+				return DT_SUCCESS;
+			}
+		}
+	}
+
+	return findNearestPoly(center, halfExtents, filter, nearestRef, nearestPt, options);
+}
+
 void dtNavMeshQuery::queryPolygonsInTile(const dtMeshTile* tile, const float* qmin, const float* qmax,
 										 const dtQueryFilter* filter, dtPolyQuery* query) const
 {
@@ -792,35 +1192,23 @@ void dtNavMeshQuery::queryPolygonsInTile(const dtMeshTile* tile, const float* qm
 	dtPoly* polys[batchSize];
 	int n = 0;
 
+	DT_QUERY_STAT(tilesQueried);
+
 	if (tile->bvTree)
 	{
 		const dtBVNode* node = &tile->bvTree[0];
 		const dtBVNode* end = &tile->bvTree[tile->header->bvNodeCount];
-		const float* tbmin = tile->header->bmin;
-		const float* tbmax = tile->header->bmax;
-		const float qfac = tile->header->bvQuantFactor;
 
 		// Calculate quantized box
 		unsigned short bmin[3], bmax[3];
-		// dtClamp query box to world box.
-		float minx = dtClamp(qmin[0], tbmin[0], tbmax[0]) - tbmin[0];
-		float miny = dtClamp(qmin[1], tbmin[1], tbmax[1]) - tbmin[1];
-		float minz = dtClamp(qmin[2], tbmin[2], tbmax[2]) - tbmin[2];
-		float maxx = dtClamp(qmax[0], tbmin[0], tbmax[0]) - tbmin[0];
-		float maxy = dtClamp(qmax[1], tbmin[1], tbmax[1]) - tbmin[1];
-		float maxz = dtClamp(qmax[2], tbmin[2], tbmax[2]) - tbmin[2];
-		// Quantize
-		bmin[0] = (unsigned short)(qfac * minx) & 0xfffe;
-		bmin[1] = (unsigned short)(qfac * miny) & 0xfffe;
-		bmin[2] = (unsigned short)(qfac * minz) & 0xfffe;
-		bmax[0] = (unsigned short)(qfac * maxx + 1) | 1;
-		bmax[1] = (unsigned short)(qfac * maxy + 1) | 1;
-		bmax[2] = (unsigned short)(qfac * maxz + 1) | 1;
+		quantizeQueryBounds(tile->header, qmin, qmax, bmin, bmax);
 
 		// Traverse tree
 		const dtPolyRef base = m_nav->getPolyRefBase(tile);
 		while (node < end)
 		{
+			DT_QUERY_STAT(bvNodesVisited);
+
 			const bool overlap = dtOverlapQuantBounds(bmin, bmax, node->bmin, node->bmax);
 			const bool isLeafNode = node->i >= 0;
 
@@ -975,6 +1363,8 @@ dtStatus dtNavMeshQuery::queryPolygons(const float* center, const float* halfExt
 	if (!center || !halfExtents || !filter || !query)
 		return DT_FAILURE | DT_INVALID_PARAM;
 
+	DT_QUERY_STATS_BEGIN();
+
 	float bmin[3], bmax[3];
 	dtVsub(bmin, center, halfExtents);
 	dtVadd(bmax, center, halfExtents);
@@ -1017,10 +1407,30 @@ dtStatus dtNavMeshQuery::findPath(dtPolyRef startRef, dtPolyRef endRef,
 								  const float* startPos, const float* endPos,
 								  const dtQueryFilter* filter,
 								  dtPolyRef* path, int* pathCount, const int maxPath) const
+{
+	return findPathT(startRef, endRef, startPos, endPos, filter, path, pathCount, maxPath);
+}
+
+/// @par
+///
+/// Gives the same kind of result as findPath(), but runs a second search from
+/// the end polygon toward the start and stops once the two searches have met
+/// and neither can improve the path. On long corridors and maze-like meshes
+/// this expands far fewer nodes than searching from the start alone.
+///
+/// The backward search uses its own node pool and open list, the same size
+/// as the main ones, which are allocated on the first call.
+///
+/// This method runs a #DT_FINDPATH_BIDIRECTIONAL sliced query to completion,
+/// so it cancels any sliced query in progress on this object.
+///
+dtStatus dtNavMeshQuery::findPathBidirectional(dtPolyRef startRef, dtPolyRef endRef,
+											   const float* startPos, const float* endPos,
+											   const dtQueryFilter* filter,
+											   dtPolyRef* path, int* pathCount, const int maxPath)
 {
 	dtAssert(m_nav);
 	dtAssert(m_nodePool);
-	dtAssert(m_openList);
 	
 	if (pathCount)
 		*pathCount = 0;
@@ -1030,175 +1440,16 @@ dtStatus dtNavMeshQuery::findPath(dtPolyRef startRef, dtPolyRef endRef,
 		!startPos || !endPos || !filter || maxPath <= 0 || !path || !pathCount)
 		return DT_FAILURE | DT_INVALID_PARAM;
 
-	if (startRef == endRef)
+	dtStatus status = initSlicedFindPath(startRef, endRef, startPos, endPos, filter, DT_FINDPATH_BIDIRECTIONAL);
+	while (dtStatusInProgress(status))
+		status = updateSlicedFindPath(m_nodePool->getMaxNodes(), 0);
+	if (dtStatusFailed(status))
 	{
-		path[0] = startRef;
-		*pathCount = 1;
-		return DT_SUCCESS;
+		memset(&m_query, 0, sizeof(dtQueryData));
+		return status;
 	}
 	
-	m_nodePool->clear();
-	m_openList->clear();
-	
-	dtNode* startNode = m_nodePool->getNode(startRef);
-	dtVcopy(startNode->pos, startPos);
-	startNode->pidx = 0;
-	startNode->cost = 0;
-	startNode->total = dtVdist(startPos, endPos) * H_SCALE;
-	startNode->id = startRef;
-	startNode->flags = DT_NODE_OPEN;
-	m_openList->push(startNode);
-	
-	dtNode* lastBestNode = startNode;
-	float lastBestNodeCost = startNode->total;
-	
-	bool outOfNodes = false;
-	
-	while (!m_openList->empty())
-	{
-		// Remove node from open list and put it in closed list.
-		dtNode* bestNode = m_openList->pop();
-		bestNode->flags &= ~DT_NODE_OPEN;
-		bestNode->flags |= DT_NODE_CLOSED;
-		
-		// Reached the goal, stop searching.
-		if (bestNode->id == endRef)
-		{
-			lastBestNode = bestNode;
-			break;
-		}
-		
-		// Get current poly and tile.
-		// The API input has been cheked already, skip checking internal data.
-		const dtPolyRef bestRef = bestNode->id;
-		const dtMeshTile* bestTile = 0;
-		const dtPoly* bestPoly = 0;
-		m_nav->getTileAndPolyByRefUnsafe(bestRef, &bestTile, &bestPoly);
-		
-		// Get parent poly and tile.
-		dtPolyRef parentRef = 0;
-		const dtMeshTile* parentTile = 0;
-		const dtPoly* parentPoly = 0;
-		if (bestNode->pidx)
-			parentRef = m_nodePool->getNodeAtIdx(bestNode->pidx)->id;
-		if (parentRef)
-			m_nav->getTileAndPolyByRefUnsafe(parentRef, &parentTile, &parentPoly);
-		
-		for (unsigned int i = bestPoly->firstLink; i != DT_NULL_LINK; i = bestTile->links[i].next)
-		{
-			dtPolyRef neighbourRef = bestTile->links[i].ref;
-			
-			// Skip invalid ids and do not expand back to where we came from.
-			if (!neighbourRef || neighbourRef == parentRef)
-				continue;
-			
-			// Get neighbour poly and tile.
-			// The API input has been cheked already, skip checking internal data.
-			const dtMeshTile* neighbourTile = 0;
-			const dtPoly* neighbourPoly = 0;
-			m_nav->getTileAndPolyByRefUnsafe(neighbourRef, &neighbourTile, &neighbourPoly);			
-			
-			if (!filter->passFilter(neighbourRef, neighbourTile, neighbourPoly))
-				continue;
-
-			// deal explicitly with crossing tile boundaries
-			unsigned char crossSide = 0;
-			if (bestTile->links[i].side != 0xff)
-				crossSide = bestTile->links[i].side >> 1;
-
-			// get the node
-			dtNode* neighbourNode = m_nodePool->getNode(neighbourRef, crossSide);
-			if (!neighbourNode)
-			{
-				outOfNodes = true;
-				continue;
-			}
-			
-			// If the node is visited the first time, calculate node position.
-			if (neighbourNode->flags == 0)
-			{
-				getEdgeMidPoint(bestRef, bestPoly, bestTile,
-								neighbourRef, neighbourPoly, neighbourTile,
-								neighbourNode->pos);
-			}
-
-			// Calculate cost and heuristic.
-			float cost = 0;
-			float heuristic = 0;
-			
-			// Special case for last node.
-			if (neighbourRef == endRef)
-			{
-				// Cost
-				const float curCost = filter->getCost(bestNode->pos, neighbourNode->pos,
-													  parentRef, parentTile, parentPoly,
-													  bestRef, bestTile, bestPoly,
-													  neighbourRef, neighbourTile, neighbourPoly);
-				const float endCost = filter->getCost(neighbourNode->pos, endPos,
-													  bestRef, bestTile, bestPoly,
-													  neighbourRef, neighbourTile, neighbourPoly,
-													  0, 0, 0);
-				
-				cost = bestNode->cost + curCost + endCost;
-				heuristic = 0;
-			}
-			else
-			{
-				// Cost
-				const float curCost = filter->getCost(bestNode->pos, neighbourNode->pos,
-													  parentRef, parentTile, parentPoly,
-													  bestRef, bestTile, bestPoly,
-													  neighbourRef, neighbourTile, neighbourPoly);
-				cost = bestNode->cost + curCost;
-				heuristic = dtVdist(neighbourNode->pos, endPos)*H_SCALE;
-			}
-
-			const float total = cost + heuristic;
-			
-			// The node is already in open list and the new result is worse, skip.
-			if ((neighbourNode->flags & DT_NODE_OPEN) && total >= neighbourNode->total)
-				continue;
-			// The node is already visited and process, and the new result is worse, skip.
-			if ((neighbourNode->flags & DT_NODE_CLOSED) && total >= neighbourNode->total)
-				continue;
-			
-			// Add or update the node.
-			neighbourNode->pidx = m_nodePool->getNodeIdx(bestNode);
-			neighbourNode->id = neighbourRef;
-			neighbourNode->flags = (neighbourNode->flags & ~DT_NODE_CLOSED);
-			neighbourNode->cost = cost;
-			neighbourNode->total = total;
-			
-			if (neighbourNode->flags & DT_NODE_OPEN)
-			{
-				// Already in open, update node location.
-				m_openList->modify(neighbourNode);
-			}
-			else
-			{
-				// Put the node in open list.
-				neighbourNode->flags |= DT_NODE_OPEN;
-				m_openList->push(neighbourNode);
-			}
-			
-			// Update nearest node to target so far.
-			if (heuristic < lastBestNodeCost)
-			{
-				lastBestNodeCost = heuristic;
-				lastBestNode = neighbourNode;
-			}
-		}
-	}
-
-	dtStatus status = getPathToNode(lastBestNode, path, pathCount, maxPath);
-
-	if (lastBestNode->id != endRef)
-		status |= DT_PARTIAL_RESULT;
-
-	if (outOfNodes)
-		status |= DT_OUT_OF_NODES;
-	
-	return status;
+	return finalizeSlicedFindPath(path, pathCount, maxPath);
 }
 
 dtStatus dtNavMeshQuery::getPathToNode(dtNode* endNode, dtPolyRef* path, int* pathCount, int maxPath) const
@@ -1268,6 +1519,7 @@ dtStatus dtNavMeshQuery::initSlicedFindPath(dtPolyRef startRef, dtPolyRef endRef
 	m_query.filter = filter;
 	m_query.options = options;
 	m_query.raycastLimitSqr = FLT_MAX;
+	m_query.meetCost = FLT_MAX;
 	
 	if (!startRef || !endRef)
 		return DT_FAILURE | DT_INVALID_PARAM;
@@ -1276,8 +1528,10 @@ dtStatus dtNavMeshQuery::initSlicedFindPath(dtPolyRef startRef, dtPolyRef endRef
 	if (!m_nav->isValidPolyRef(startRef) || !m_nav->isValidPolyRef(endRef))
 		return DT_FAILURE | DT_INVALID_PARAM;
 
+	DT_QUERY_STATS_BEGIN();
+
 	// trade quality with performance?
-	if (options & DT_FINDPATH_ANY_ANGLE)
+	if ((options & DT_FINDPATH_ANY_ANGLE) && !(options & DT_FINDPATH_BIDIRECTIONAL))
 	{
 		// limiting to several times the character radius yields nice results. It is not sensitive 
 		// so it is enough to compute it from the first tile.
@@ -1299,17 +1553,88 @@ dtStatus dtNavMeshQuery::initSlicedFindPath(dtPolyRef startRef, dtPolyRef endRef
 	dtVcopy(startNode->pos, startPos);
 	startNode->pidx = 0;
 	startNode->cost = 0;
-	startNode->total = dtVdist(startPos, endPos) * H_SCALE;
+	startNode->total = dtVdist(startPos, endPos) * DT_QUERY_H_SCALE;
 	startNode->id = startRef;
 	startNode->flags = DT_NODE_OPEN;
 	m_openList->push(startNode);
+	DT_QUERY_STAT(openListPushes);
 	
 	m_query.status = DT_IN_PROGRESS;
 	m_query.lastBestNode = startNode;
 	m_query.lastBestNodeCost = startNode->total;
+
+	if (options & DT_FINDPATH_BIDIRECTIONAL)
+	{
+		// See updateSlicedFindPathBidirectional() for the heuristic.
+		startNode->total *= 0.5f;
+		m_query.options &= ~DT_FINDPATH_ANY_ANGLE;
+
+		dtStatus status = initBackSearch();
+		if (dtStatusFailed(status))
+		{
+			m_query.status = status;
+			return status;
+		}
+
+		m_backNodePool->clear();
+		m_backOpenList->clear();
+
+		// The backward search enters the end polygon like the forward search
+		// would, so an end polygon excluded by the filter leaves its list empty.
+		const dtMeshTile* endTile = 0;
+		const dtPoly* endPoly = 0;
+		m_nav->getTileAndPolyByRefUnsafe(endRef, &endTile, &endPoly);
+		if (filter->passFilter(endRef, endTile, endPoly))
+		{
+			dtNode* endNode = m_backNodePool->getNode(endRef);
+			dtVcopy(endNode->pos, endPos);
+			endNode->pidx = 0;
+			endNode->cost = 0;
+			endNode->total = dtVdist(endPos, startPos) * DT_QUERY_H_SCALE * 0.5f;
+			endNode->id = endRef;
+			endNode->flags = DT_NODE_OPEN;
+			m_backOpenList->push(endNode);
+			DT_QUERY_STAT(openListPushes);
+		}
+	}
 	
 	return m_query.status;
 }
+
+dtStatus dtNavMeshQuery::initBackSearch()
+{
+	const int maxNodes = m_nodePool->getMaxNodes();
+
+	if (!m_backNodePool || m_backNodePool->getMaxNodes() < maxNodes)
+	{
+		if (m_backNodePool)
+		{
+			m_backNodePool->~dtNodePool();
+			dtFree(m_backNodePool);
+			m_backNodePool = 0;
+		}
+		void* mem = dtAlloc(sizeof(dtNodePool), DT_ALLOC_PERM, DT_ALLOC_TAG_QUERY);
+		if (!mem)
+			return DT_FAILURE | DT_OUT_OF_MEMORY;
+		m_backNodePool = new (mem) dtNodePool(maxNodes, m_nodePool->getHashSize());
+	}
+
+	if (!m_backOpenList || m_backOpenList->getCapacity() < maxNodes)
+	{
+		if (m_backOpenList)
+		{
+			m_backOpenList->~dtNodeQueue();
+			dtFree(m_backOpenList);
+			m_backOpenList = 0;
+		}
+		void* mem = dtAlloc(sizeof(dtNodeQueue), DT_ALLOC_PERM, DT_ALLOC_TAG_QUERY);
+		if (!mem)
+			return DT_FAILURE | DT_OUT_OF_MEMORY;
+		m_backOpenList = new (mem) dtNodeQueue(maxNodes);
+	}
+
+	return DT_SUCCESS;
+}
 	
 dtStatus dtNavMeshQuery::updateSlicedFindPath(const int maxIter, int* doneIters)
 {
@@ -1323,6 +1648,9 @@ dtStatus dtNavMeshQuery::updateSlicedFindPath(const int maxIter, int* doneIters)
 		return DT_FAILURE;
 	}
 
+	if (m_query.options & DT_FINDPATH_BIDIRECTIONAL)
+		return updateSlicedFindPathBidirectional(maxIter, doneIters);
+
 	dtRaycastHit rayHit;
 	rayHit.maxPath = 0;
 		
@@ -1333,6 +1661,7 @@ dtStatus dtNavMeshQuery::updateSlicedFindPath(const int maxIter, int* doneIters)
 		
 		// Remove node from open list and put it in closed list.
 		dtNode* bestNode = m_openList->pop();
+		DT_QUERY_STAT(nodesExpanded);
 		bestNode->flags &= ~DT_NODE_OPEN;
 		bestNode->flags |= DT_NODE_CLOSED;
 		
@@ -1473,7 +1802,7 @@ dtStatus dtNavMeshQuery::updateSlicedFindPath(const int maxIter, int* doneIters)
 			}
 			else
 			{
-				heuristic = dtVdist(neighbourNode->pos, m_query.endPos)*H_SCALE;
+				heuristic = dtVdist(neighbourNode->pos, m_query.endPos)*DT_QUERY_H_SCALE;
 			}
 			
 			const float total = cost + heuristic;
@@ -1498,12 +1827,16 @@ dtStatus dtNavMeshQuery::updateSlicedFindPath(const int maxIter, int* doneIters)
 			{
 				// Already in open, update node location.
 				m_openList->modify(neighbourNode);
+				DT_QUERY_STAT(openListModifies);
 			}
 			else
 			{
 				// Put the node in open list.
 				neighbourNode->flags |= DT_NODE_OPEN;
 				m_openList->push(neighbourNode);
+				DT_QUERY_STAT(openListPushes);
+				if (neighbourTile != bestTile)
+					DT_QUERY_STAT(tileCrossings);
 			}
 			
 			// Update nearest node to target so far.
@@ -1539,6 +1872,9 @@ dtStatus dtNavMeshQuery::finalizeSlicedFindPath(dtPolyRef* path, int* pathCount,
 		return DT_FAILURE;
 	}
 
+	if ((m_query.options & DT_FINDPATH_BIDIRECTIONAL) && m_query.startRef != m_query.endRef)
+		return finalizeSlicedFindPathBidirectional(path, pathCount, maxPath);
+
 	int n = 0;
 
 	if (m_query.startRef == m_query.endRef)
@@ -1602,6 +1938,8 @@ dtStatus dtNavMeshQuery::finalizeSlicedFindPath(dtPolyRef* path, int* pathCount,
 		while (node);
 	}
 	
+	DT_QUERY_STATS_END(m_query.status);
+
 	const dtStatus details = m_query.status & DT_STATUS_DETAIL_MASK;
 
 	// Reset query.
@@ -1628,6 +1966,10 @@ dtStatus dtNavMeshQuery::finalizeSlicedFindPathPartial(const dtPolyRef* existing
 		memset(&m_query, 0, sizeof(dtQueryData));
 		return DT_FAILURE;
 	}
+
+	// A completed bidirectional search already has a path.
+	if ((m_query.options & DT_FINDPATH_BIDIRECTIONAL) && m_query.meetNode)
+		return finalizeSlicedFindPathBidirectional(path, pathCount, maxPath);
 	
 	int n = 0;
 	
@@ -1702,6 +2044,8 @@ dtStatus dtNavMeshQuery::finalizeSlicedFindPathPartial(const dtPolyRef* existing
 		while (node);
 	}
 	
+	DT_QUERY_STATS_END(m_query.status);
+
 	const dtStatus details = m_query.status & DT_STATUS_DETAIL_MASK;
 
 	// Reset query.
@@ -1713,6 +2057,306 @@ dtStatus dtNavMeshQuery::finalizeSlicedFindPathPartial(const dtPolyRef* existing
 }
 
 
+// Returns true if the polygon has a link to the specified polygon.
+static bool hasLinkTo(const dtMeshTile* tile, const dtPoly* poly, const dtPolyRef ref)
+{
+	for (unsigned int i = poly->firstLink; i != DT_NULL_LINK; i = tile->links[i].next)
+	{
+		if (tile->links[i].ref == ref)
+			return true;
+	}
+	return false;
+}
+
+dtStatus dtNavMeshQuery::updateSlicedFindPathBidirectional(const int maxIter, int* doneIters)
+{
+	dtAssert(m_backNodePool);
+	dtAssert(m_backOpenList);
+
+	int iter = 0;
+	while (iter < maxIter)
+	{
+		const bool forwardEmpty = m_openList->empty();
+		const bool backEmpty = m_backOpenList->empty();
+
+		// Once the searches have met, stop when the frontiers together cannot lead to a cheaper path.
+		if (m_query.meetNode &&
+			(forwardEmpty || backEmpty ||
+			 m_openList->top()->total + m_backOpenList->top()->total >= m_query.meetCost))
+		{
+			const dtStatus details = m_query.status & DT_STATUS_DETAIL_MASK;
+			m_query.status = DT_SUCCESS | details;
+			break;
+		}
+
+		// Exhausted all nodes, but could not find path. An exhausted backward search 
+		// means the same, but the forward search keeps going so the partial result 
+		// gets as close to the end as it does with a single search.
+		if (forwardEmpty)
+		{
+			const dtStatus details = m_query.status & DT_STATUS_DETAIL_MASK;
+			m_query.status = DT_SUCCESS | details;
+			break;
+		}
+
+		iter++;
+
+		// Expand the search that has visited fewer nodes to keep the frontiers balanced.
+		const bool forward = backEmpty || m_nodePool->getNodeCount() <= m_backNodePool->getNodeCount();
+		dtNodePool* pool = forward ? m_nodePool : m_backNodePool;
+		dtNodeQueue* openList = forward ? m_openList : m_backOpenList;
+		dtNodePool* otherPool = forward ? m_backNodePool : m_nodePool;
+		const float* goalPos = forward ? m_query.endPos : m_query.startPos;
+		const float* originPos = forward ? m_query.startPos : m_query.endPos;
+
+		// Remove node from open list and put it in closed list.
+		dtNode* bestNode = openList->pop();
+		DT_QUERY_STAT(nodesExpanded);
+		bestNode->flags &= ~DT_NODE_OPEN;
+		bestNode->flags |= DT_NODE_CLOSED;
+
+		// Get current poly and tile.
+		const dtPolyRef bestRef = bestNode->id;
+		const dtMeshTile* bestTile = 0;
+		const dtPoly* bestPoly = 0;
+		if (dtStatusFailed(m_nav->getTileAndPolyByRef(bestRef, &bestTile, &bestPoly)))
+		{
+			// The polygon has disappeared during the sliced query, fail.
+			m_query.status = DT_FAILURE;
+			if (doneIters)
+				*doneIters = iter;
+			return m_query.status;
+		}
+
+		// Get parent poly and tile. In the backward search the parent is the
+		// next polygon toward the end.
+		dtPolyRef parentRef = 0;
+		const dtMeshTile* parentTile = 0;
+		const dtPoly* parentPoly = 0;
+		if (bestNode->pidx)
+			parentRef = pool->getNodeAtIdx(bestNode->pidx)->id;
+		if (parentRef && dtStatusFailed(m_nav->getTileAndPolyByRef(parentRef, &parentTile, &parentPoly)))
+		{
+			// The polygon has disappeared during the sliced query, fail.
+			m_query.status = DT_FAILURE;
+			if (doneIters)
+				*doneIters = iter;
+			return m_query.status;
+		}
+
+		for (unsigned int i = bestPoly->firstLink; i != DT_NULL_LINK; i = bestTile->links[i].next)
+		{
+			dtPolyRef neighbourRef = bestTile->links[i].ref;
+			
+			// Skip invalid ids and do not expand back to where we came from.
+			if (!neighbourRef || neighbourRef == parentRef)
+				continue;
+			
+			// Get neighbour poly and tile.
+			// The API input has been cheked already, skip checking internal data.
+			const dtMeshTile* neighbourTile = 0;
+			const dtPoly* neighbourPoly = 0;
+			m_nav->getTileAndPolyByRefUnsafe(neighbourRef, &neighbourTile, &neighbourPoly);
+
+			if (forward)
+			{
+				if (!m_query.filter->passFilter(neighbourRef, neighbourTile, neighbourPoly))
+					continue;
+			}
+			else
+			{
+				// Like the forward search, never filter the start polygon.
+				if (neighbourRef != m_query.startRef &&
+					!m_query.filter->passFilter(neighbourRef, neighbourTile, neighbourPoly))
+					continue;
+
+				// The backward search follows the links in reverse. Off-mesh 
+				// connections can be one-way, so the neighbour must link back.
+				if ((bestPoly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION ||
+					 neighbourPoly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION) &&
+					!hasLinkTo(neighbourTile, neighbourPoly, bestRef))
+					continue;
+			}
+
+			// get the neighbor node
+			dtNode* neighbourNode = pool->getNode(neighbourRef, 0);
+			if (!neighbourNode)
+			{
+				m_query.status |= DT_OUT_OF_NODES;
+				continue;
+			}
+
+			// If the node is visited the first time, calculate node position.
+			if (neighbourNode->flags == 0)
+			{
+				getEdgeMidPoint(bestRef, bestPoly, bestTile,
+								neighbourRef, neighbourPoly, neighbourTile,
+								neighbourNode->pos);
+			}
+
+			// Cost of crossing the current polygon. The backward search 
+			// crosses it from the neighbour toward the parent.
+			float curCost;
+			if (forward)
+			{
+				curCost = m_query.filter->getCost(bestNode->pos, neighbourNode->pos,
+												  parentRef, parentTile, parentPoly,
+												  bestRef, bestTile, bestPoly,
+												  neighbourRef, neighbourTile, neighbourPoly);
+			}
+			else
+			{
+				curCost = m_query.filter->getCost(neighbourNode->pos, bestNode->pos,
+												  neighbourRef, neighbourTile, neighbourPoly,
+												  bestRef, bestTile, bestPoly,
+												  parentRef, parentTile, parentPoly);
+			}
+			
+			// Both searches use the average of the distances to their goal and to
+			// their origin as the heuristic. That keeps the two heuristics consistent
+			// with each other, so the searches can stop as soon as their frontiers meet.
+			const float cost = bestNode->cost + curCost;
+			const float heuristic = dtVdist(neighbourNode->pos, goalPos)*DT_QUERY_H_SCALE;
+			const float total = cost + (heuristic - dtVdist(neighbourNode->pos, originPos)*DT_QUERY_H_SCALE)*0.5f;
+
+			// The node is already in open list and the new result is worse, skip.
+			if ((neighbourNode->flags & DT_NODE_OPEN) && total >= neighbourNode->total)
+				continue;
+			// The node is already visited and process, and the new result is worse, skip.
+			if ((neighbourNode->flags & DT_NODE_CLOSED) && total >= neighbourNode->total)
+				continue;
+
+			// Add or update the node.
+			neighbourNode->pidx = pool->getNodeIdx(bestNode);
+			neighbourNode->id = neighbourRef;
+			neighbourNode->flags = (neighbourNode->flags & ~DT_NODE_CLOSED);
+			neighbourNode->cost = cost;
+			neighbourNode->total = total;
+			
+			if (neighbourNode->flags & DT_NODE_OPEN)
+			{
+				// Already in open, update node location.
+				openList->modify(neighbourNode);
+				DT_QUERY_STAT(openListModifies);
+			}
+			else
+			{
+				// Put the node in open list.
+				neighbourNode->flags |= DT_NODE_OPEN;
+				openList->push(neighbourNode);
+				DT_QUERY_STAT(openListPushes);
+				if (neighbourTile != bestTile)
+					DT_QUERY_STAT(tileCrossings);
+			}
+
+			// Update nearest node to target so far.
+			if (forward && heuristic < m_query.lastBestNodeCost)
+			{
+				m_query.lastBestNodeCost = heuristic;
+				m_query.lastBestNode = neighbourNode;
+			}
+
+			// If the other search has reached the polygon too, join the two paths 
+			// by crossing it from the forward node's edge to the backward node's edge.
+			dtNode* otherNode = otherPool->findNode(neighbourRef, 0);
+			if (!otherNode || !(otherNode->flags & (DT_NODE_OPEN | DT_NODE_CLOSED)))
+				continue;
+
+			dtNode* fwdNode = forward ? neighbourNode : otherNode;
+			dtNode* backNode = forward ? otherNode : neighbourNode;
+
+			dtPolyRef prevRef = 0, nextRef = 0;
+			const dtMeshTile* prevTile = 0;
+			const dtMeshTile* nextTile = 0;
+			const dtPoly* prevPoly = 0;
+			const dtPoly* nextPoly = 0;
+			if (fwdNode->pidx)
+			{
+				prevRef = m_nodePool->getNodeAtIdx(fwdNode->pidx)->id;
+				m_nav->getTileAndPolyByRef(prevRef, &prevTile, &prevPoly);
+			}
+			if (backNode->pidx)
+			{
+				nextRef = m_backNodePool->getNodeAtIdx(backNode->pidx)->id;
+				m_nav->getTileAndPolyByRef(nextRef, &nextTile, &nextPoly);
+			}
+			
+			const float joinCost = fwdNode->cost + backNode->cost +
+				m_query.filter->getCost(fwdNode->pos, backNode->pos,
+										prevRef, prevTile, prevPoly,
+										neighbourRef, neighbourTile, neighbourPoly,
+										nextRef, nextTile, nextPoly);
+			if (joinCost < m_query.meetCost)
+			{
+				m_query.meetCost = joinCost;
+				m_query.meetNode = fwdNode;
+				m_query.meetBackNode = backNode;
+			}
+		}
+	}
+
+	if (doneIters)
+		*doneIters = iter;
+
+	return m_query.status;
+}
+
+dtStatus dtNavMeshQuery::finalizeSlicedFindPathBidirectional(dtPolyRef* path, int* pathCount, const int maxPath)
+{
+	dtNode* node = m_query.meetNode;
+	if (!node)
+	{
+		// The searches never met, return the path toward the polygon nearest to the end.
+		dtAssert(m_query.lastBestNode);
+		node = m_query.lastBestNode;
+		m_query.status |= DT_PARTIAL_RESULT;
+	}
+
+	// Store the forward half, from the start to the meeting polygon. It is 
+	// walked from the meeting end, so keep only what fits from the start.
+	int length = 0;
+	for (dtNode* cur = node; cur; cur = m_nodePool->getNodeAtIdx(cur->pidx))
+		length++;
+
+	int i = length;
+	for (dtNode* cur = node; cur; cur = m_nodePool->getNodeAtIdx(cur->pidx))
+	{
+		--i;
+		if (i < maxPath)
+			path[i] = cur->id;
+	}
+
+	int n = dtMin(length, maxPath);
+	if (length > maxPath)
+		m_query.status |= DT_BUFFER_TOO_SMALL;
+
+	// Append the backward half, from the polygon after the meeting polygon to the end.
+	if (m_query.meetBackNode && !(m_query.status & DT_BUFFER_TOO_SMALL))
+	{
+		for (dtNode* cur = m_backNodePool->getNodeAtIdx(m_query.meetBackNode->pidx); cur;
+			 cur = m_backNodePool->getNodeAtIdx(cur->pidx))
+		{
+			if (n >= maxPath)
+			{
+				m_query.status |= DT_BUFFER_TOO_SMALL;
+				break;
+			}
+			path[n++] = cur->id;
+		}
+	}
+
+	DT_QUERY_STATS_END(m_query.status);
+
+	const dtStatus details = m_query.status & DT_STATUS_DETAIL_MASK;
+
+	// Reset query.
+	memset(&m_query, 0, sizeof(dtQueryData));
+	
+	*pathCount = n;
+	
+	return DT_SUCCESS | details;
+}
+
 dtStatus dtNavMeshQuery::appendVertex(const float* pos, const unsigned char flags, const dtPolyRef ref,
 									  float* straightPath, unsigned char* straightPathFlags, dtPolyRef* straightPathRefs,
 									  int* straightPathCount, const int maxStraightPath) const
@@ -1800,6 +2444,103 @@ dtStatus dtNavMeshQuery::appendPortals(const int startIdx, const int endIdx, con
 	return DT_IN_PROGRESS;
 }
 
+void dtNavMeshQuery::syncPathPortals(const dtPolyRef* path, const int pathSize, dtPathPortals* portals) const
+{
+	if (!portals->count)
+		return;
+	
+	// Find the start of the path in the buffer. The front of the path is
+	// trimmed as the start position moves along it.
+	int start = -1;
+	for (int i = 0; i <= portals->count; ++i)
+	{
+		if (portals->refs[i] == path[0])
+		{
+			start = i;
+			break;
+		}
+	}
+	if (start < 0 || !m_nav->isValidPolyRef(path[0]))
+	{
+		portals->count = 0;
+		return;
+	}
+	
+	if (start > 0)
+	{
+		const int n = portals->count - start;
+		memmove(portals->left, portals->left + start*3, sizeof(float)*3*n);
+		memmove(portals->right, portals->right + start*3, sizeof(float)*3*n);
+		memmove(portals->toTypes, portals->toTypes + start, sizeof(unsigned char)*n);
+		memmove(portals->refs, portals->refs + start, sizeof(dtPolyRef)*(n+1));
+		portals->count = n;
+	}
+	
+	// Keep the portals that still lead along the path into valid polygons.
+	// A changed tile changes the salt of its polygon references too.
+	const int maxCount = dtMin(portals->count, pathSize-1);
+	int n = 0;
+	while (n < maxCount && portals->refs[n+1] == path[n+1] && m_nav->isValidPolyRef(path[n+1]))
+		n++;
+	portals->count = n;
+}
+
+void dtNavMeshQuery::resolvePathPortals(const dtPolyRef* path, const int pathSize, const int endIdx,
+										dtPathPortals* portals) const
+{
+	int i = portals->count;
+	const int n = dtMin(dtMin(endIdx, portals->maxPortals), pathSize-1);
+	if (i >= n)
+		return;
+	
+	const dtMeshTile* fromTile = 0;
+	const dtPoly* fromPoly = 0;
+	if (dtStatusFailed(m_nav->getTileAndPolyByRef(path[i], &fromTile, &fromPoly)))
+		return;
+	portals->refs[i] = path[i];
+	
+	// Each polygon is decoded once, as the 'to' side of a portal and then the 'from' side of the next.
+	for (; i < n; ++i)
+	{
+		const dtMeshTile* toTile = 0;
+		const dtPoly* toPoly = 0;
+		if (dtStatusFailed(m_nav->getTileAndPolyByRef(path[i+1], &toTile, &toPoly)))
+			break;
+		if (dtStatusFailed(getPortalPoints(path[i], fromPoly, fromTile, path[i+1], toPoly, toTile,
+										   &portals->left[i*3], &portals->right[i*3])))
+			break;
+		portals->toTypes[i] = toPoly->getType();
+		portals->refs[i+1] = path[i+1];
+		portals->count = i+1;
+		
+		fromTile = toTile;
+		fromPoly = toPoly;
+	}
+}
+
+dtStatus dtNavMeshQuery::findStraightPath(const float* startPos, const float* endPos,
+										  const dtPolyRef* path, const int pathSize,
+										  float* straightPath, unsigned char* straightPathFlags, dtPolyRef* straightPathRefs,
+										  int* straightPathCount, const int maxStraightPath, const int options) const
+{
+	static const int MAX_PORTALS = 64;
+	float left[MAX_PORTALS*3], right[MAX_PORTALS*3];
+	unsigned char toTypes[MAX_PORTALS];
+	dtPolyRef refs[MAX_PORTALS+1];
+	
+	dtPathPortals portals;
+	portals.left = left;
+	portals.right = right;
+	portals.toTypes = toTypes;
+	portals.refs = refs;
+	portals.count = 0;
+	portals.maxPortals = MAX_PORTALS;
+	
+	return findStraightPath(startPos, endPos, path, pathSize,
+							straightPath, straightPathFlags, straightPathRefs,
+							straightPathCount, maxStraightPath, options, &portals);
+}
+
 /// @par
 /// 
 /// This method peforms what is often called 'string pulling'.
@@ -1817,12 +2558,27 @@ dtStatus dtNavMeshQuery::appendPortals(const int startIdx, const int endIdx, con
 /// they will be filled as far as possible from the start toward the end 
 /// position.
 ///
+/// The portals of the path are resolved in small batches into @p portals, 
+/// ahead of the funnel, so each polygon is decoded once and the funnel does 
+/// not look a portal up again when it restarts from a new apex. Portals 
+/// beyond the capacity of the buffer are looked up one at a time.
+///
+/// A buffer kept between calls is realigned with the new path, and the 
+/// portals leading along the part of the path that did not change are 
+/// reused. A polygon path that has its front trimmed or its end changed keeps 
+/// the rest of its portals. Set dtPathPortals::count to zero before the first 
+/// call.
+///
 dtStatus dtNavMeshQuery::findStraightPath(const float* startPos, const float* endPos,
 										  const dtPolyRef* path, const int pathSize,
 										  float* straightPath, unsigned char* straightPathFlags, dtPolyRef* straightPathRefs,
-										  int* straightPathCount, const int maxStraightPath, const int options) const
+										  int* straightPathCount, const int maxStraightPath, const int options,
+										  dtPathPortals* portals) const
 {
+	static const int PORTAL_BATCH_SIZE = 8;
+	
 	dtAssert(m_nav);
+	dtAssert(portals);
 	
 	*straightPathCount = 0;
 	
@@ -1832,6 +2588,8 @@ dtStatus dtNavMeshQuery::findStraightPath(const float* startPos, const float* en
 	if (!path[0])
 		return DT_FAILURE | DT_INVALID_PARAM;
 	
+	syncPathPortals(path, pathSize, portals);
+	
 	dtStatus stat = 0;
 	
 	// TODO: Should this be callers responsibility?
@@ -1868,15 +2626,26 @@ dtStatus dtNavMeshQuery::findStraightPath(const float* startPos, const float* en
 		
 		for (int i = 0; i < pathSize; ++i)
 		{
-			float left[3], right[3];
+			const float* left;
+			const float* right;
+			float portalBuf[6];
 			unsigned char toType;
 			
 			if (i+1 < pathSize)
 			{
-				unsigned char fromType; // fromType is ignored.
-
 				// Next portal.
-				if (dtStatusFailed(getPortalPoints(path[i], path[i+1], left, right, fromType, toType)))
+				if (i >= portals->count && portals->count < portals->maxPortals)
+					resolvePathPortals(path, pathSize, i + PORTAL_BATCH_SIZE, portals);
+				
+				unsigned char fromType; // fromType is ignored.
+				
+				if (i < portals->count)
+				{
+					left = &portals->left[i*3];
+					right = &portals->right[i*3];
+					toType = portals->toTypes[i];
+				}
+				else if (dtStatusFailed(getPortalPoints(path[i], path[i+1], &portalBuf[0], &portalBuf[3], fromType, toType)))
 				{
 					// Failed to get portal points, in practice this means that path[i+1] is invalid polygon.
 					// Clamp the end point to path[i], and return the path so far.
@@ -1903,6 +2672,11 @@ dtStatus dtNavMeshQuery::findStraightPath(const float* startPos, const float* en
 					
 					return DT_SUCCESS | DT_PARTIAL_RESULT | ((*straightPathCount >= maxStraightPath) ? DT_BUFFER_TOO_SMALL : 0);
 				}
+				else
+				{
+					left = &portalBuf[0];
+					right = &portalBuf[3];
+				}
 				
 				// If starting really close the portal, advance.
 				if (i == 0)
@@ -1915,8 +2689,8 @@ dtStatus dtNavMeshQuery::findStraightPath(const float* startPos, const float* en
 			else
 			{
 				// End of the path.
-				dtVcopy(left, closestEndPos);
-				dtVcopy(right, closestEndPos);
+				left = closestEndPos;
+				right = closestEndPos;
 				
 				toType = DT_POLYTYPE_GROUND;
 			}
@@ -2424,279 +3198,68 @@ dtStatus dtNavMeshQuery::getEdgeMidPoint(dtPolyRef from, const dtPoly* fromPoly,
 dtStatus dtNavMeshQuery::raycast(dtPolyRef startRef, const float* startPos, const float* endPos,
 								 const dtQueryFilter* filter,
 								 float* t, float* hitNormal, dtPolyRef* path, int* pathCount, const int maxPath) const
-{
-	dtRaycastHit hit;
-	hit.path = path;
-	hit.maxPath = maxPath;
-
-	dtStatus status = raycast(startRef, startPos, endPos, filter, 0, &hit);
-	
-	*t = hit.t;
-	if (hitNormal)
-		dtVcopy(hitNormal, hit.hitNormal);
-	if (pathCount)
-		*pathCount = hit.pathCount;
-
-	return status;
-}
-
-
-/// @par
-///
-/// This method is meant to be used for quick, short distance checks.
-///
-/// If the path array is too small to hold the result, it will be filled as 
-/// far as possible from the start postion toward the end position.
-///
-/// <b>Using the Hit Parameter t of RaycastHit</b>
-/// 
-/// If the hit parameter is a very high value (FLT_MAX), then the ray has hit 
-/// the end position. In this case the path represents a valid corridor to the 
-/// end position and the value of @p hitNormal is undefined.
-///
-/// If the hit parameter is zero, then the start position is on the wall that 
-/// was hit and the value of @p hitNormal is undefined.
-///
-/// If 0 < t < 1.0 then the following applies:
-///
-/// @code
-/// distanceToHitBorder = distanceToEndPosition * t
-/// hitPoint = startPos + (endPos - startPos) * t
-/// @endcode
-///
-/// <b>Use Case Restriction</b>
-///
-/// The raycast ignores the y-value of the end position. (2D check.) This 
-/// places significant limits on how it can be used. For example:
-///
-/// Consider a scene where there is a main floor with a second floor balcony 
-/// that hangs over the main floor. So the first floor mesh extends below the 
-/// balcony mesh. The start position is somewhere on the first floor. The end 
-/// position is on the balcony.
-///
-/// The raycast will search toward the end position along the first floor mesh. 
-/// If it reaches the end position's xz-coordinates it will indicate FLT_MAX
-/// (no wall hit), meaning it reached the end position. This is one example of why
-/// this method is meant for short distance checks.
-///
-dtStatus dtNavMeshQuery::raycast(dtPolyRef startRef, const float* startPos, const float* endPos,
-								 const dtQueryFilter* filter, const unsigned int options,
-								 dtRaycastHit* hit, dtPolyRef prevRef) const
-{
-	dtAssert(m_nav);
-	
-	hit->t = 0;
-	hit->pathCount = 0;
-	hit->pathCost = 0;
-
-	// Validate input
-	if (!startRef || !m_nav->isValidPolyRef(startRef))
-		return DT_FAILURE | DT_INVALID_PARAM;
-	if (prevRef && !m_nav->isValidPolyRef(prevRef))
-		return DT_FAILURE | DT_INVALID_PARAM;
-	
-	float dir[3], curPos[3], lastPos[3];
-	float verts[DT_VERTS_PER_POLYGON*3+3];	
-	int n = 0;
-
-	dtVcopy(curPos, startPos);
-	dtVsub(dir, endPos, startPos);
-	dtVset(hit->hitNormal, 0, 0, 0);
-
-	dtStatus status = DT_SUCCESS;
-
-	const dtMeshTile* prevTile, *tile, *nextTile;
-	const dtPoly* prevPoly, *poly, *nextPoly;
-	dtPolyRef curRef;
-
-	// The API input has been checked already, skip checking internal data.
-	curRef = startRef;
-	tile = 0;
-	poly = 0;
-	m_nav->getTileAndPolyByRefUnsafe(curRef, &tile, &poly);
-	nextTile = prevTile = tile;
-	nextPoly = prevPoly = poly;
-	if (prevRef)
-		m_nav->getTileAndPolyByRefUnsafe(prevRef, &prevTile, &prevPoly);
-
-	while (curRef)
-	{
-		// Cast ray against current polygon.
-		
-		// Collect vertices.
-		int nv = 0;
-		for (int i = 0; i < (int)poly->vertCount; ++i)
-		{
-			dtVcopy(&verts[nv*3], &tile->verts[poly->verts[i]*3]);
-			nv++;
-		}
-		
-		float tmin, tmax;
-		int segMin, segMax;
-		if (!dtIntersectSegmentPoly2D(startPos, endPos, verts, nv, tmin, tmax, segMin, segMax))
-		{
-			// Could not hit the polygon, keep the old t and report hit.
-			hit->pathCount = n;
-			return status;
-		}
-
-		hit->hitEdgeIndex = segMax;
-
-		// Keep track of furthest t so far.
-		if (tmax > hit->t)
-			hit->t = tmax;
-		
-		// Store visited polygons.
-		if (n < hit->maxPath)
-			hit->path[n++] = curRef;
-		else
-			status |= DT_BUFFER_TOO_SMALL;
-
-		// Ray end is completely inside the polygon.
-		if (segMax == -1)
-		{
-			hit->t = FLT_MAX;
-			hit->pathCount = n;
-			
-			// add the cost
-			if (options & DT_RAYCAST_USE_COSTS)
-				hit->pathCost += filter->getCost(curPos, endPos, prevRef, prevTile, prevPoly, curRef, tile, poly, curRef, tile, poly);
-			return status;
-		}
-
-		// Follow neighbours.
-		dtPolyRef nextRef = 0;
-		
-		for (unsigned int i = poly->firstLink; i != DT_NULL_LINK; i = tile->links[i].next)
-		{
-			const dtLink* link = &tile->links[i];
-			
-			// Find link which contains this edge.
-			if ((int)link->edge != segMax)
-				continue;
-			
-			// Get pointer to the next polygon.
-			nextTile = 0;
-			nextPoly = 0;
-			m_nav->getTileAndPolyByRefUnsafe(link->ref, &nextTile, &nextPoly);
-			
-			// Skip off-mesh connections.
-			if (nextPoly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION)
-				continue;
-			
-			// Skip links based on filter.
-			if (!filter->passFilter(link->ref, nextTile, nextPoly))
-				continue;
-			
-			// If the link is internal, just return the ref.
-			if (link->side == 0xff)
-			{
-				nextRef = link->ref;
-				break;
-			}
-			
-			// If the link is at tile boundary,
-			
-			// Check if the link spans the whole edge, and accept.
-			if (link->bmin == 0 && link->bmax == 255)
-			{
-				nextRef = link->ref;
-				break;
-			}
-			
-			// Check for partial edge links.
-			const int v0 = poly->verts[link->edge];
-			const int v1 = poly->verts[(link->edge+1) % poly->vertCount];
-			const float* left = &tile->verts[v0*3];
-			const float* right = &tile->verts[v1*3];
-			
-			// Check that the intersection lies inside the link portal.
-			if (link->side == 0 || link->side == 4)
-			{
-				// Calculate link size.
-				const float s = 1.0f/255.0f;
-				float lmin = left[2] + (right[2] - left[2])*(link->bmin*s);
-				float lmax = left[2] + (right[2] - left[2])*(link->bmax*s);
-				if (lmin > lmax) dtSwap(lmin, lmax);
-				
-				// Find Z intersection.
-				float z = startPos[2] + (endPos[2]-startPos[2])*tmax;
-				if (z >= lmin && z <= lmax)
-				{
-					nextRef = link->ref;
-					break;
-				}
-			}
-			else if (link->side == 2 || link->side == 6)
-			{
-				// Calculate link size.
-				const float s = 1.0f/255.0f;
-				float lmin = left[0] + (right[0] - left[0])*(link->bmin*s);
-				float lmax = left[0] + (right[0] - left[0])*(link->bmax*s);
-				if (lmin > lmax) dtSwap(lmin, lmax);
-				
-				// Find X intersection.
-				float x = startPos[0] + (endPos[0]-startPos[0])*tmax;
-				if (x >= lmin && x <= lmax)
-				{
-					nextRef = link->ref;
-					break;
-				}
-			}
-		}
-		
-		// add the cost
-		if (options & DT_RAYCAST_USE_COSTS)
-		{
-			// compute the intersection point at the furthest end of the polygon
-			// and correct the height (since the raycast moves in 2d)
-			dtVcopy(lastPos, curPos);
-			dtVmad(curPos, startPos, dir, hit->t);
-			float* e1 = &verts[segMax*3];
-			float* e2 = &verts[((segMax+1)%nv)*3];
-			float eDir[3], diff[3];
-			dtVsub(eDir, e2, e1);
-			dtVsub(diff, curPos, e1);
-			float s = dtSqr(eDir[0]) > dtSqr(eDir[2]) ? diff[0] / eDir[0] : diff[2] / eDir[2];
-			curPos[1] = e1[1] + eDir[1] * s;
-
-			hit->pathCost += filter->getCost(lastPos, curPos, prevRef, prevTile, prevPoly, curRef, tile, poly, nextRef, nextTile, nextPoly);
-		}
-
-		if (!nextRef)
-		{
-			// No neighbour, we hit a wall.
-			
-			// Calculate hit normal.
-			const int a = segMax;
-			const int b = segMax+1 < nv ? segMax+1 : 0;
-			const float* va = &verts[a*3];
-			const float* vb = &verts[b*3];
-			const float dx = vb[0] - va[0];
-			const float dz = vb[2] - va[2];
-			hit->hitNormal[0] = dz;
-			hit->hitNormal[1] = 0;
-			hit->hitNormal[2] = -dx;
-			dtVnormalize(hit->hitNormal);
-			
-			hit->pathCount = n;
-			return status;
-		}
+{
+	dtRaycastHit hit;
+	hit.path = path;
+	hit.maxPath = maxPath;
 
-		// No hit, advance to neighbour polygon.
-		prevRef = curRef;
-		curRef = nextRef;
-		prevTile = tile;
-		tile = nextTile;
-		prevPoly = poly;
-		poly = nextPoly;
-	}
-	
-	hit->pathCount = n;
+	dtStatus status = raycast(startRef, startPos, endPos, filter, 0, &hit);
 	
+	*t = hit.t;
+	if (hitNormal)
+		dtVcopy(hitNormal, hit.hitNormal);
+	if (pathCount)
+		*pathCount = hit.pathCount;
+
 	return status;
 }
 
+
+/// @par
+///
+/// This method is meant to be used for quick, short distance checks.
+///
+/// If the path array is too small to hold the result, it will be filled as 
+/// far as possible from the start postion toward the end position.
+///
+/// <b>Using the Hit Parameter t of RaycastHit</b>
+/// 
+/// If the hit parameter is a very high value (FLT_MAX), then the ray has hit 
+/// the end position. In this case the path represents a valid corridor to the 
+/// end position and the value of @p hitNormal is undefined.
+///
+/// If the hit parameter is zero, then the start position is on the wall that 
+/// was hit and the value of @p hitNormal is undefined.
+///
+/// If 0 < t < 1.0 then the following applies:
+///
+/// @code
+/// distanceToHitBorder = distanceToEndPosition * t
+/// hitPoint = startPos + (endPos - startPos) * t
+/// @endcode
+///
+/// <b>Use Case Restriction</b>
+///
+/// The raycast ignores the y-value of the end position. (2D check.) This 
+/// places significant limits on how it can be used. For example:
+///
+/// Consider a scene where there is a main floor with a second floor balcony 
+/// that hangs over the main floor. So the first floor mesh extends below the 
+/// balcony mesh. The start position is somewhere on the first floor. The end 
+/// position is on the balcony.
+///
+/// The raycast will search toward the end position along the first floor mesh. 
+/// If it reaches the end position's xz-coordinates it will indicate FLT_MAX
+/// (no wall hit), meaning it reached the end position. This is one example of why
+/// this method is meant for short distance checks.
+///
+dtStatus dtNavMeshQuery::raycast(dtPolyRef startRef, const float* startPos, const float* endPos,
+								 const dtQueryFilter* filter, const unsigned int options,
+								 dtRaycastHit* hit, dtPolyRef prevRef) const
+{
+	return raycastT(startRef, startPos, endPos, filter, options, hit, prevRef);
+}
+
 /// @par
 ///
 /// At least one result array must be provided.
@@ -2730,20 +3293,58 @@ dtStatus dtNavMeshQuery::findPolysAroundCircle(dtPolyRef startRef, const float*
 											   const dtQueryFilter* filter,
 											   dtPolyRef* resultRef, dtPolyRef* resultParent, float* resultCost,
 											   int* resultCount, const int maxResult) const
+{
+	return findPolysAroundCircleT(startRef, centerPos, radius, filter,
+								  resultRef, resultParent, resultCost, resultCount, maxResult);
+}
+
+/// @par
+///
+/// The order of the result set is from least to highest cost.
+/// 
+/// At least one result array must be provided.
+///
+/// A common use case for this method is to perform Dijkstra searches. 
+/// Candidate polygons are found by searching the graph beginning at the start 
+/// polygon.
+/// 
+/// The same intersection test restrictions that apply to findPolysAroundCircle()
+/// method apply to this method.
+/// 
+/// The 3D centroid of the search polygon is used as the start position for cost 
+/// calculations.
+/// 
+/// Intersection tests occur in 2D. All polygons are projected onto the 
+/// xz-plane. So the y-values of the vertices do not effect intersection tests.
+/// 
+/// If the result arrays are is too small to hold the entire result set, they will 
+/// be filled to capacity.
+///
+dtStatus dtNavMeshQuery::findPolysAroundShape(dtPolyRef startRef, const float* verts, const int nverts,
+											  const dtQueryFilter* filter,
+											  dtPolyRef* resultRef, dtPolyRef* resultParent, float* resultCost,
+											  int* resultCount, const int maxResult) const
 {
 	dtAssert(m_nav);
 	dtAssert(m_nodePool);
 	dtAssert(m_openList);
-
+	
 	*resultCount = 0;
 	
 	// Validate input
 	if (!startRef || !m_nav->isValidPolyRef(startRef))
 		return DT_FAILURE | DT_INVALID_PARAM;
 	
+	DT_QUERY_STATS_BEGIN();
+
 	m_nodePool->clear();
 	m_openList->clear();
 	
+	float centerPos[3] = {0,0,0};
+	for (int i = 0; i < nverts; ++i)
+		dtVadd(centerPos,centerPos,&verts[i*3]);
+	dtVscale(centerPos,centerPos,1.0f/nverts);
+
 	dtNode* startNode = m_nodePool->getNode(startRef);
 	dtVcopy(startNode->pos, centerPos);
 	startNode->pidx = 0;
@@ -2752,16 +3353,16 @@ dtStatus dtNavMeshQuery::findPolysAroundCircle(dtPolyRef startRef, const float*
 	startNode->id = startRef;
 	startNode->flags = DT_NODE_OPEN;
 	m_openList->push(startNode);
+	DT_QUERY_STAT(openListPushes);
 	
 	dtStatus status = DT_SUCCESS;
-	
+
 	int n = 0;
 	
-	const float radiusSqr = dtSqr(radius);
-	
 	while (!m_openList->empty())
 	{
 		dtNode* bestNode = m_openList->pop();
+		DT_QUERY_STAT(nodesExpanded);
 		bestNode->flags &= ~DT_NODE_OPEN;
 		bestNode->flags |= DT_NODE_CLOSED;
 		
@@ -2789,6 +3390,7 @@ dtStatus dtNavMeshQuery::findPolysAroundCircle(dtPolyRef startRef, const float*
 				resultParent[n] = parentRef;
 			if (resultCost)
 				resultCost[n] = bestNode->total;
+
 			++n;
 		}
 		else
@@ -2808,7 +3410,7 @@ dtStatus dtNavMeshQuery::findPolysAroundCircle(dtPolyRef startRef, const float*
 			const dtMeshTile* neighbourTile = 0;
 			const dtPoly* neighbourPoly = 0;
 			m_nav->getTileAndPolyByRefUnsafe(neighbourRef, &neighbourTile, &neighbourPoly);
-		
+			
 			// Do not advance if the polygon is excluded by the filter.
 			if (!filter->passFilter(neighbourRef, neighbourTile, neighbourPoly))
 				continue;
@@ -2818,10 +3420,12 @@ dtStatus dtNavMeshQuery::findPolysAroundCircle(dtPolyRef startRef, const float*
 			if (!getPortalPoints(bestRef, bestPoly, bestTile, neighbourRef, neighbourPoly, neighbourTile, va, vb))
 				continue;
 			
-			// If the circle is not touching the next polygon, skip it.
-			float tseg;
-			float distSqr = dtDistancePtSegSqr2D(centerPos, va, vb, tseg);
-			if (distSqr > radiusSqr)
+			// If the poly is not touching the edge to the next polygon, skip the connection it.
+			float tmin, tmax;
+			int segMin, segMax;
+			if (!dtIntersectSegmentPoly2D(va, vb, verts, nverts, tmin, tmax, segMin, segMax))
+				continue;
+			if (tmin > 1.0f || tmax < 0.0f)
 				continue;
 			
 			dtNode* neighbourNode = m_nodePool->getNode(neighbourRef);
@@ -2830,7 +3434,7 @@ dtStatus dtNavMeshQuery::findPolysAroundCircle(dtPolyRef startRef, const float*
 				status |= DT_OUT_OF_NODES;
 				continue;
 			}
-				
+			
 			if (neighbourNode->flags & DT_NODE_CLOSED)
 				continue;
 			
@@ -2857,92 +3461,101 @@ dtStatus dtNavMeshQuery::findPolysAroundCircle(dtPolyRef startRef, const float*
 			if (neighbourNode->flags & DT_NODE_OPEN)
 			{
 				m_openList->modify(neighbourNode);
+				DT_QUERY_STAT(openListModifies);
 			}
 			else
 			{
 				neighbourNode->flags = DT_NODE_OPEN;
 				m_openList->push(neighbourNode);
+				DT_QUERY_STAT(openListPushes);
+				if (neighbourTile != bestTile)
+					DT_QUERY_STAT(tileCrossings);
 			}
 		}
 	}
 	
 	*resultCount = n;
 	
+	DT_QUERY_STATS_END(status);
+
 	return status;
 }
 
 /// @par
 ///
-/// The order of the result set is from least to highest cost.
-/// 
-/// At least one result array must be provided.
+/// The search runs from the goal polygon outwards, and costs are calculated in the
+/// direction of travel, so the result is a flow field. Following the next polygon from
+/// any result polygon leads to the goal, on the least cost path found by the search.
+/// Agents that share a goal can use the same result instead of finding individual paths.
+///
+/// The order of the result set is from least to highest cost to reach the goal.
+///
+/// A polygon is only expanded to a neighbour that links back to it, so one-way
+/// off-mesh connections are only followed if their landing polygon links back to the
+/// connection.
+///
+/// The cost of a polygon is the cost from the portal it leaves through to the goal
+/// position. (Zero for the goal polygon.)
 ///
-/// A common use case for this method is to perform Dijkstra searches. 
-/// Candidate polygons are found by searching the graph beginning at the start 
-/// polygon.
-/// 
 /// The same intersection test restrictions that apply to findPolysAroundCircle()
-/// method apply to this method.
-/// 
-/// The 3D centroid of the search polygon is used as the start position for cost 
-/// calculations.
-/// 
-/// Intersection tests occur in 2D. All polygons are projected onto the 
-/// xz-plane. So the y-values of the vertices do not effect intersection tests.
-/// 
-/// If the result arrays are is too small to hold the entire result set, they will 
-/// be filled to capacity.
+/// apply to this method. The search is also limited by the size of the node pool.
+/// (#DT_OUT_OF_NODES)
 ///
-dtStatus dtNavMeshQuery::findPolysAroundShape(dtPolyRef startRef, const float* verts, const int nverts,
-											  const dtQueryFilter* filter,
-											  dtPolyRef* resultRef, dtPolyRef* resultParent, float* resultCost,
-											  int* resultCount, const int maxResult) const
+/// If the result arrays are to small to hold the entire result set, they will be
+/// filled to capacity. The polygons closest to the goal are found first, so a partial
+/// result is still a valid flow field.
+///
+dtStatus dtNavMeshQuery::findFlowField(dtPolyRef goalRef, const float* goalPos, const float radius,
+									   const dtQueryFilter* filter,
+									   dtPolyRef* resultRef, dtPolyRef* resultNext, float* resultCost,
+									   int* resultCount, const int maxResult) const
 {
 	dtAssert(m_nav);
 	dtAssert(m_nodePool);
 	dtAssert(m_openList);
-	
+
 	*resultCount = 0;
-	
+
 	// Validate input
-	if (!startRef || !m_nav->isValidPolyRef(startRef))
+	if (!goalRef || !m_nav->isValidPolyRef(goalRef) || !goalPos || !filter || maxResult < 0)
 		return DT_FAILURE | DT_INVALID_PARAM;
-	
+
+	DT_QUERY_STATS_BEGIN();
+
 	m_nodePool->clear();
 	m_openList->clear();
-	
-	float centerPos[3] = {0,0,0};
-	for (int i = 0; i < nverts; ++i)
-		dtVadd(centerPos,centerPos,&verts[i*3]);
-	dtVscale(centerPos,centerPos,1.0f/nverts);
 
-	dtNode* startNode = m_nodePool->getNode(startRef);
-	dtVcopy(startNode->pos, centerPos);
-	startNode->pidx = 0;
-	startNode->cost = 0;
-	startNode->total = 0;
-	startNode->id = startRef;
-	startNode->flags = DT_NODE_OPEN;
-	m_openList->push(startNode);
-	
+	dtNode* goalNode = m_nodePool->getNode(goalRef);
+	dtVcopy(goalNode->pos, goalPos);
+	goalNode->pidx = 0;
+	goalNode->cost = 0;
+	goalNode->total = 0;
+	goalNode->id = goalRef;
+	goalNode->flags = DT_NODE_OPEN;
+	m_openList->push(goalNode);
+	DT_QUERY_STAT(openListPushes);
+
 	dtStatus status = DT_SUCCESS;
 
 	int n = 0;
-	
+
+	const float radiusSqr = dtSqr(radius);
+
 	while (!m_openList->empty())
 	{
 		dtNode* bestNode = m_openList->pop();
+		DT_QUERY_STAT(nodesExpanded);
 		bestNode->flags &= ~DT_NODE_OPEN;
 		bestNode->flags |= DT_NODE_CLOSED;
-		
+
 		// Get poly and tile.
 		// The API input has been cheked already, skip checking internal data.
 		const dtPolyRef bestRef = bestNode->id;
 		const dtMeshTile* bestTile = 0;
 		const dtPoly* bestPoly = 0;
 		m_nav->getTileAndPolyByRefUnsafe(bestRef, &bestTile, &bestPoly);
-		
-		// Get parent poly and tile.
+
+		// The parent is the next polygon towards the goal.
 		dtPolyRef parentRef = 0;
 		const dtMeshTile* parentTile = 0;
 		const dtPoly* parentPoly = 0;
@@ -2951,22 +3564,21 @@ dtStatus dtNavMeshQuery::findPolysAroundShape(dtPolyRef startRef, const float* v
 		if (parentRef)
 			m_nav->getTileAndPolyByRefUnsafe(parentRef, &parentTile, &parentPoly);
 
-		if (n < maxResult)
-		{
-			if (resultRef)
-				resultRef[n] = bestRef;
-			if (resultParent)
-				resultParent[n] = parentRef;
-			if (resultCost)
-				resultCost[n] = bestNode->total;
-
-			++n;
-		}
-		else
+		if (n >= maxResult)
 		{
+			// Nothing further out can be stored.
 			status |= DT_BUFFER_TOO_SMALL;
+			break;
 		}
-		
+
+		if (resultRef)
+			resultRef[n] = bestRef;
+		if (resultNext)
+			resultNext[n] = parentRef;
+		if (resultCost)
+			resultCost[n] = bestNode->total;
+		++n;
+
 		for (unsigned int i = bestPoly->firstLink; i != DT_NULL_LINK; i = bestTile->links[i].next)
 		{
 			const dtLink* link = &bestTile->links[i];
@@ -2974,73 +3586,92 @@ dtStatus dtNavMeshQuery::findPolysAroundShape(dtPolyRef startRef, const float* v
 			// Skip invalid neighbours and do not follow back to parent.
 			if (!neighbourRef || neighbourRef == parentRef)
 				continue;
-			
+
 			// Expand to neighbour
 			const dtMeshTile* neighbourTile = 0;
 			const dtPoly* neighbourPoly = 0;
 			m_nav->getTileAndPolyByRefUnsafe(neighbourRef, &neighbourTile, &neighbourPoly);
-			
+
 			// Do not advance if the polygon is excluded by the filter.
 			if (!filter->passFilter(neighbourRef, neighbourTile, neighbourPoly))
 				continue;
-			
+
+			// Agents move from the neighbour into the current polygon, so the
+			// neighbour must link back to it.
+			bool linksBack = false;
+			for (unsigned int j = neighbourPoly->firstLink; j != DT_NULL_LINK; j = neighbourTile->links[j].next)
+			{
+				if (neighbourTile->links[j].ref == bestRef)
+				{
+					linksBack = true;
+					break;
+				}
+			}
+			if (!linksBack)
+				continue;
+
 			// Find edge and calc distance to the edge.
 			float va[3], vb[3];
 			if (!getPortalPoints(bestRef, bestPoly, bestTile, neighbourRef, neighbourPoly, neighbourTile, va, vb))
 				continue;
-			
-			// If the poly is not touching the edge to the next polygon, skip the connection it.
-			float tmin, tmax;
-			int segMin, segMax;
-			if (!dtIntersectSegmentPoly2D(va, vb, verts, nverts, tmin, tmax, segMin, segMax))
-				continue;
-			if (tmin > 1.0f || tmax < 0.0f)
+
+			// If the circle is not touching the next polygon, skip it.
+			float tseg;
+			float distSqr = dtDistancePtSegSqr2D(goalPos, va, vb, tseg);
+			if (distSqr > radiusSqr)
 				continue;
-			
+
 			dtNode* neighbourNode = m_nodePool->getNode(neighbourRef);
 			if (!neighbourNode)
 			{
 				status |= DT_OUT_OF_NODES;
 				continue;
 			}
-			
+
 			if (neighbourNode->flags & DT_NODE_CLOSED)
 				continue;
-			
+
 			// Cost
 			if (neighbourNode->flags == 0)
 				dtVlerp(neighbourNode->pos, va, vb, 0.5f);
-			
+
+			// The cost of crossing the current polygon, from the neighbour to the parent.
 			float cost = filter->getCost(
-				bestNode->pos, neighbourNode->pos,
-				parentRef, parentTile, parentPoly,
+				neighbourNode->pos, bestNode->pos,
+				neighbourRef, neighbourTile, neighbourPoly,
 				bestRef, bestTile, bestPoly,
-				neighbourRef, neighbourTile, neighbourPoly);
+				parentRef, parentTile, parentPoly);
 
 			const float total = bestNode->total + cost;
-			
+
 			// The node is already in open list and the new result is worse, skip.
 			if ((neighbourNode->flags & DT_NODE_OPEN) && total >= neighbourNode->total)
 				continue;
-			
+
 			neighbourNode->id = neighbourRef;
 			neighbourNode->pidx = m_nodePool->getNodeIdx(bestNode);
 			neighbourNode->total = total;
-			
+
 			if (neighbourNode->flags & DT_NODE_OPEN)
 			{
 				m_openList->modify(neighbourNode);
+				DT_QUERY_STAT(openListModifies);
 			}
 			else
 			{
 				neighbourNode->flags = DT_NODE_OPEN;
 				m_openList->push(neighbourNode);
+				DT_QUERY_STAT(openListPushes);
+				if (neighbourTile != bestTile)
+					DT_QUERY_STAT(tileCrossings);
 			}
 		}
 	}
-	
+
 	*resultCount = n;
-	
+
+	DT_QUERY_STATS_END(status);
+
 	return status;
 }
 
@@ -3458,6 +4089,8 @@ dtStatus dtNavMeshQuery::findDistanceToWall(dtPolyRef startRef, const float* cen
 	if (!startRef || !m_nav->isValidPolyRef(startRef))
 		return DT_FAILURE | DT_INVALID_PARAM;
 	
+	DT_QUERY_STATS_BEGIN();
+
 	m_nodePool->clear();
 	m_openList->clear();
 	
@@ -3469,6 +4102,7 @@ dtStatus dtNavMeshQuery::findDistanceToWall(dtPolyRef startRef, const float* cen
 	startNode->id = startRef;
 	startNode->flags = DT_NODE_OPEN;
 	m_openList->push(startNode);
+	DT_QUERY_STAT(openListPushes);
 	
 	float radiusSqr = dtSqr(maxRadius);
 	
@@ -3477,6 +4111,7 @@ dtStatus dtNavMeshQuery::findDistanceToWall(dtPolyRef startRef, const float* cen
 	while (!m_openList->empty())
 	{
 		dtNode* bestNode = m_openList->pop();
+		DT_QUERY_STAT(nodesExpanded);
 		bestNode->flags &= ~DT_NODE_OPEN;
 		bestNode->flags |= DT_NODE_CLOSED;
 		
@@ -3610,11 +4245,15 @@ dtStatus dtNavMeshQuery::findDistanceToWall(dtPolyRef startRef, const float* cen
 			if (neighbourNode->flags & DT_NODE_OPEN)
 			{
 				m_openList->modify(neighbourNode);
+				DT_QUERY_STAT(openListModifies);
 			}
 			else
 			{
 				neighbourNode->flags |= DT_NODE_OPEN;
 				m_openList->push(neighbourNode);
+				DT_QUERY_STAT(openListPushes);
+				if (neighbourTile != bestTile)
+					DT_QUERY_STAT(tileCrossings);
 			}
 		}
 	}
@@ -3625,6 +4264,8 @@ dtStatus dtNavMeshQuery::findDistanceToWall(dtPolyRef startRef, const float* cen
 	
 	*hitDist = dtMathSqrtf(radiusSqr);
 	
+	DT_QUERY_STATS_END(status);
+
 	return status;
 }
 
@@ -3662,3 +4303,53 @@ bool dtNavMeshQuery::isInClosedList(dtPolyRef ref) const
 
 	return false;
 }
+
+/// @par
+///
+/// The last query statistics start over with each graph search (A* or Dijkstra)
+/// and each polygon query. A sliced path query is counted from
+/// #initSlicedFindPath through #finalizeSlicedFindPath. Raycasts and the
+/// local queries, such as #moveAlongSurface, are not counted.
+///
+/// Both results are zeroed if the statistics are compiled out.
+bool dtNavMeshQuery::getQueryStats(dtQueryStats* lastQuery, dtQueryStats* total) const
+{
+#ifdef DT_QUERY_STATS
+	if (lastQuery)
+		*lastQuery = m_lastStats;
+	if (total)
+		*total = m_totalStats;
+	return true;
+#else
+	if (lastQuery)
+		memset(lastQuery, 0, sizeof(dtQueryStats));
+	if (total)
+		memset(total, 0, sizeof(dtQueryStats));
+	return false;
+#endif
+}
+
+void dtNavMeshQuery::resetQueryStats()
+{
+#ifdef DT_QUERY_STATS
+	memset(&m_lastStats, 0, sizeof(dtQueryStats));
+	memset(&m_totalStats, 0, sizeof(dtQueryStats));
+#endif
+}
+
+#ifdef DT_QUERY_STATS
+void dtNavMeshQuery::beginQueryStats() const
+{
+	memset(&m_lastStats, 0, sizeof(dtQueryStats));
+	m_lastStats.queryCount = 1;
+	m_totalStats.queryCount++;
+}
+
+void dtNavMeshQuery::endQueryStats(const dtStatus status) const
+{
+	if (status & DT_OUT_OF_NODES)
+		DT_QUERY_STAT(outOfNodesCount);
+	if (status & DT_PARTIAL_RESULT)
+		DT_QUERY_STAT(partialResultCount);
+}
+#endif
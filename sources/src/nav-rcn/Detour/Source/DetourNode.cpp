@@ -52,6 +52,8 @@ dtNodePool::dtNodePool(int maxNodes, int hashSize) :
 	m_nodes(0),
 	m_first(0),
 	m_next(0),
+	m_firstStamp(0),
+	m_stamp(1),
 	m_maxNodes(maxNodes),
 	m_hashSize(hashSize),
 	m_nodeCount(0)
@@ -59,18 +61,21 @@ dtNodePool::dtNodePool(int maxNodes, int hashSize) :
 	dtAssert(dtNextPow2(m_hashSize) == (unsigned int)m_hashSize);
 	// pidx is special as 0 means "none" and 1 is the first node. For that reason
 	// we have 1 fewer nodes available than the number of values it can contain.
-	dtAssert(m_maxNodes > 0 && m_maxNodes <= DT_NULL_IDX && m_maxNodes <= (1 << DT_NODE_PARENT_BITS) - 1);
+	dtAssert(m_maxNodes > 0 && (unsigned int)m_maxNodes <= (unsigned int)DT_NULL_IDX && m_maxNodes <= (1 << DT_NODE_PARENT_BITS) - 1);
 
-	m_nodes = (dtNode*)dtAlloc(sizeof(dtNode)*m_maxNodes, DT_ALLOC_PERM);
-	m_next = (dtNodeIndex*)dtAlloc(sizeof(dtNodeIndex)*m_maxNodes, DT_ALLOC_PERM);
-	m_first = (dtNodeIndex*)dtAlloc(sizeof(dtNodeIndex)*hashSize, DT_ALLOC_PERM);
+	m_nodes = (dtNode*)dtAlloc(sizeof(dtNode)*m_maxNodes, DT_ALLOC_PERM, DT_ALLOC_TAG_QUERY);
+	m_next = (dtNodeIndex*)dtAlloc(sizeof(dtNodeIndex)*m_maxNodes, DT_ALLOC_PERM, DT_ALLOC_TAG_QUERY);
+	m_first = (dtNodeIndex*)dtAlloc(sizeof(dtNodeIndex)*hashSize, DT_ALLOC_PERM, DT_ALLOC_TAG_QUERY);
+	m_firstStamp = (unsigned int*)dtAlloc(sizeof(unsigned int)*hashSize, DT_ALLOC_PERM, DT_ALLOC_TAG_QUERY);
 
 	dtAssert(m_nodes);
 	dtAssert(m_next);
 	dtAssert(m_first);
+	dtAssert(m_firstStamp);
 
 	memset(m_first, 0xff, sizeof(dtNodeIndex)*m_hashSize);
 	memset(m_next, 0xff, sizeof(dtNodeIndex)*m_maxNodes);
+	memset(m_firstStamp, 0, sizeof(unsigned int)*m_hashSize);
 }
 
 dtNodePool::~dtNodePool()
@@ -78,11 +83,20 @@ dtNodePool::~dtNodePool()
 	dtFree(m_nodes);
 	dtFree(m_next);
 	dtFree(m_first);
+	dtFree(m_firstStamp);
 }
 
 void dtNodePool::clear()
 {
-	memset(m_first, 0xff, sizeof(dtNodeIndex)*m_hashSize);
+	// Buckets whose stamp does not match the current generation are treated
+	// as empty, so clearing is O(1) instead of touching the whole hash table.
+	// The stamps are only reset when the generation counter wraps around.
+	m_stamp++;
+	if (m_stamp == 0)
+	{
+		memset(m_firstStamp, 0, sizeof(unsigned int)*m_hashSize);
+		m_stamp = 1;
+	}
 	m_nodeCount = 0;
 }
 
@@ -90,7 +104,7 @@ unsigned int dtNodePool::findNodes(dtPolyRef id, dtNode** nodes, const int maxNo
 {
 	int n = 0;
 	unsigned int bucket = dtHashRef(id) & (m_hashSize-1);
-	dtNodeIndex i = m_first[bucket];
+	dtNodeIndex i = getFirst(bucket);
 	while (i != DT_NULL_IDX)
 	{
 		if (m_nodes[i].id == id)
@@ -108,7 +122,7 @@ unsigned int dtNodePool::findNodes(dtPolyRef id, dtNode** nodes, const int maxNo
 dtNode* dtNodePool::findNode(dtPolyRef id, unsigned char state)
 {
 	unsigned int bucket = dtHashRef(id) & (m_hashSize-1);
-	dtNodeIndex i = m_first[bucket];
+	dtNodeIndex i = getFirst(bucket);
 	while (i != DT_NULL_IDX)
 	{
 		if (m_nodes[i].id == id && m_nodes[i].state == state)
@@ -121,7 +135,7 @@ dtNode* dtNodePool::findNode(dtPolyRef id, unsigned char state)
 dtNode* dtNodePool::getNode(dtPolyRef id, unsigned char state)
 {
 	unsigned int bucket = dtHashRef(id) & (m_hashSize-1);
-	dtNodeIndex i = m_first[bucket];
+	dtNodeIndex i = getFirst(bucket);
 	dtNode* node = 0;
 	while (i != DT_NULL_IDX)
 	{
@@ -145,8 +159,9 @@ dtNode* dtNodePool::getNode(dtPolyRef id, unsigned char state)
 	node->state = state;
 	node->flags = 0;
 	
-	m_next[i] = m_first[bucket];
+	m_next[i] = getFirst(bucket);
 	m_first[bucket] = i;
+	m_firstStamp[bucket] = m_stamp;
 	
 	return node;
 }
@@ -160,7 +175,7 @@ dtNodeQueue::dtNodeQueue(int n) :
 {
 	dtAssert(m_capacity > 0);
 	
-	m_heap = (dtNode**)dtAlloc(sizeof(dtNode*)*(m_capacity+1), DT_ALLOC_PERM);
+	m_heap = (dtNode**)dtAlloc(sizeof(dtNode*)*(m_capacity+1), DT_ALLOC_PERM, DT_ALLOC_TAG_QUERY);
 	dtAssert(m_heap);
 }
 
@@ -0,0 +1,426 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#include <string.h>
+#include <new>
+#include "DetourPathCache.h"
+#include "DetourCommon.h"
+#include "DetourAlloc.h"
+
+dtPathCache* dtAllocPathCache()
+{
+	void* mem = dtAlloc(sizeof(dtPathCache), DT_ALLOC_PERM, DT_ALLOC_TAG_PATH_QUEUE);
+	if (!mem) return 0;
+	return new(mem) dtPathCache;
+}
+
+void dtFreePathCache(dtPathCache* cache)
+{
+	if (!cache) return;
+	cache->~dtPathCache();
+	dtFree(cache);
+}
+
+inline unsigned int fnvHash(unsigned int h, const void* data, const int size)
+{
+	const unsigned char* p = (const unsigned char*)data;
+	for (int i = 0; i < size; ++i)
+		h = (h ^ p[i]) * 16777619u;
+	return h;
+}
+
+dtPathCache::dtPathCache() :
+	m_nav(0),
+	m_entries(0),
+	m_paths(0),
+	m_flags(0),
+	m_areas(0),
+	m_maxEntries(0),
+	m_maxPathSize(0),
+	m_entryCount(0),
+	m_lookup(0),
+	m_lookupMask(0),
+	m_nextFree(-1),
+	m_lruHead(-1),
+	m_lruTail(-1)
+{
+	resetStats();
+}
+
+dtPathCache::~dtPathCache()
+{
+	purge();
+}
+
+void dtPathCache::purge()
+{
+	dtFree(m_entries);
+	dtFree(m_paths);
+	dtFree(m_flags);
+	dtFree(m_areas);
+	dtFree(m_lookup);
+	m_entries = 0;
+	m_paths = 0;
+	m_flags = 0;
+	m_areas = 0;
+	m_lookup = 0;
+	m_maxEntries = 0;
+	m_maxPathSize = 0;
+	m_entryCount = 0;
+}
+
+int dtPathCache::getMemUsed() const
+{
+	return sizeof(*this) +
+		(int)dtAllocSize(m_entries) +
+		(int)dtAllocSize(m_paths) +
+		(int)dtAllocSize(m_flags) +
+		(int)dtAllocSize(m_areas) +
+		(int)dtAllocSize(m_lookup);
+}
+
+dtStatus dtPathCache::init(const dtNavMesh* nav, const int maxEntries, const int maxPathSize)
+{
+	purge();
+
+	if (!nav || maxEntries < 1 || maxPathSize < 1)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	const int lookupSize = dtNextPow2(maxEntries);
+	const int pathSize = maxEntries * maxPathSize;
+
+	m_entries = (Entry*)dtAlloc(sizeof(Entry)*maxEntries, DT_ALLOC_PERM, DT_ALLOC_TAG_PATH_QUEUE);
+	m_paths = (dtPolyRef*)dtAlloc(sizeof(dtPolyRef)*pathSize, DT_ALLOC_PERM, DT_ALLOC_TAG_PATH_QUEUE);
+	m_flags = (unsigned short*)dtAlloc(sizeof(unsigned short)*pathSize, DT_ALLOC_PERM, DT_ALLOC_TAG_PATH_QUEUE);
+	m_areas = (unsigned char*)dtAlloc(sizeof(unsigned char)*pathSize, DT_ALLOC_PERM, DT_ALLOC_TAG_PATH_QUEUE);
+	m_lookup = (int*)dtAlloc(sizeof(int)*lookupSize, DT_ALLOC_PERM, DT_ALLOC_TAG_PATH_QUEUE);
+	if (!m_entries || !m_paths || !m_flags || !m_areas || !m_lookup)
+	{
+		purge();
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+	}
+
+	m_nav = nav;
+	m_maxEntries = maxEntries;
+	m_maxPathSize = maxPathSize;
+	m_lookupMask = lookupSize-1;
+
+	clear();
+	resetStats();
+
+	return DT_SUCCESS;
+}
+
+void dtPathCache::clear()
+{
+	if (!m_entries)
+		return;
+
+	memset(m_entries, 0, sizeof(Entry)*m_maxEntries);
+	for (int i = 0; i <= m_lookupMask; ++i)
+		m_lookup[i] = -1;
+
+	m_nextFree = -1;
+	for (int i = m_maxEntries-1; i >= 0; --i)
+	{
+		m_entries[i].next = m_nextFree;
+		m_nextFree = i;
+	}
+
+	m_lruHead = -1;
+	m_lruTail = -1;
+	m_entryCount = 0;
+}
+
+unsigned int dtPathCache::hashFilter(const dtQueryFilter* filter)
+{
+	unsigned int h = 2166136261u;
+	for (int i = 0; i < DT_MAX_AREAS; ++i)
+	{
+		const float cost = filter->getAreaCost(i);
+		h = fnvHash(h, &cost, sizeof(cost));
+	}
+	const unsigned short include = filter->getIncludeFlags();
+	const unsigned short exclude = filter->getExcludeFlags();
+	h = fnvHash(h, &include, sizeof(include));
+	h = fnvHash(h, &exclude, sizeof(exclude));
+	return h;
+}
+
+int dtPathCache::hashKey(dtPolyRef startRef, dtPolyRef endRef, unsigned int filterHash) const
+{
+	unsigned int h = 2166136261u;
+	h = fnvHash(h, &startRef, sizeof(startRef));
+	h = fnvHash(h, &endRef, sizeof(endRef));
+	h = fnvHash(h, &filterHash, sizeof(filterHash));
+	return (int)(h & (unsigned int)m_lookupMask);
+}
+
+int dtPathCache::findEntry(dtPolyRef startRef, dtPolyRef endRef, unsigned int filterHash) const
+{
+	int i = m_lookup[hashKey(startRef, endRef, filterHash)];
+	while (i != -1)
+	{
+		const Entry& e = m_entries[i];
+		if (e.startRef == startRef && e.endRef == endRef && e.filterHash == filterHash)
+			return i;
+		i = e.next;
+	}
+	return -1;
+}
+
+void dtPathCache::unlinkLru(const int idx)
+{
+	Entry& e = m_entries[idx];
+	if (e.lruPrev != -1)
+		m_entries[e.lruPrev].lruNext = e.lruNext;
+	else
+		m_lruHead = e.lruNext;
+	if (e.lruNext != -1)
+		m_entries[e.lruNext].lruPrev = e.lruPrev;
+	else
+		m_lruTail = e.lruPrev;
+	e.lruPrev = -1;
+	e.lruNext = -1;
+}
+
+void dtPathCache::pushLru(const int idx)
+{
+	Entry& e = m_entries[idx];
+	e.lruPrev = -1;
+	e.lruNext = m_lruHead;
+	if (m_lruHead != -1)
+		m_entries[m_lruHead].lruPrev = idx;
+	m_lruHead = idx;
+	if (m_lruTail == -1)
+		m_lruTail = idx;
+}
+
+void dtPathCache::removeEntry(const int idx)
+{
+	Entry& e = m_entries[idx];
+
+	const int h = hashKey(e.startRef, e.endRef, e.filterHash);
+	if (m_lookup[h] == idx)
+	{
+		m_lookup[h] = e.next;
+	}
+	else
+	{
+		int i = m_lookup[h];
+		while (m_entries[i].next != idx)
+			i = m_entries[i].next;
+		m_entries[i].next = e.next;
+	}
+
+	unlinkLru(idx);
+
+	e.npath = 0;
+	e.next = m_nextFree;
+	m_nextFree = idx;
+	m_entryCount--;
+}
+
+bool dtPathCache::validate(const int idx) const
+{
+	const Entry& e = m_entries[idx];
+	const dtPolyRef* path = &m_paths[idx*m_maxPathSize];
+	const unsigned short* flags = &m_flags[idx*m_maxPathSize];
+	const unsigned char* areas = &m_areas[idx*m_maxPathSize];
+
+	for (int i = 0; i < e.npath; ++i)
+	{
+		// Fails if the tile was removed or replaced. (Salt mismatch.)
+		const dtMeshTile* tile = 0;
+		const dtPoly* poly = 0;
+		if (dtStatusFailed(m_nav->getTileAndPolyByRef(path[i], &tile, &poly)))
+			return false;
+		if (poly->flags != flags[i] || poly->getArea() != areas[i])
+			return false;
+	}
+
+	return true;
+}
+
+bool dtPathCache::find(dtPolyRef startRef, dtPolyRef endRef, const dtQueryFilter* filter,
+					   dtPolyRef* path, int* pathCount, const int maxPath)
+{
+	if (!m_entries || !filter || !path || !pathCount)
+		return false;
+
+	const int idx = findEntry(startRef, endRef, hashFilter(filter));
+	if (idx == -1)
+	{
+		m_missCount++;
+		return false;
+	}
+
+	if (!validate(idx))
+	{
+		removeEntry(idx);
+		m_invalidCount++;
+		m_missCount++;
+		return false;
+	}
+
+	const Entry& e = m_entries[idx];
+	if (e.npath > maxPath)
+	{
+		// A truncated path would not reach the end polygon.
+		m_missCount++;
+		return false;
+	}
+
+	memcpy(path, &m_paths[idx*m_maxPathSize], sizeof(dtPolyRef)*e.npath);
+	*pathCount = e.npath;
+
+	unlinkLru(idx);
+	pushLru(idx);
+	m_hitCount++;
+
+	return true;
+}
+
+bool dtPathCache::store(dtPolyRef startRef, dtPolyRef endRef, const dtQueryFilter* filter,
+						const dtPolyRef* path, const int pathCount)
+{
+	if (!m_entries || !filter || !path
+		|| pathCount < 1 || pathCount > m_maxPathSize
+		|| path[0] != startRef || path[pathCount-1] != endRef)
+	{
+		return false;
+	}
+
+	// Every polygon must be valid so the entry can be validated later.
+	for (int i = 0; i < pathCount; ++i)
+	{
+		if (!m_nav->isValidPolyRef(path[i]))
+			return false;
+	}
+
+	const unsigned int filterHash = hashFilter(filter);
+
+	int idx = findEntry(startRef, endRef, filterHash);
+	if (idx != -1)
+	{
+		unlinkLru(idx);
+	}
+	else
+	{
+		if (m_nextFree == -1)
+		{
+			removeEntry(m_lruTail);
+			m_evictCount++;
+		}
+
+		idx = m_nextFree;
+		m_nextFree = m_entries[idx].next;
+
+		Entry& e = m_entries[idx];
+		e.startRef = startRef;
+		e.endRef = endRef;
+		e.filterHash = filterHash;
+
+		const int h = hashKey(startRef, endRef, filterHash);
+		e.next = m_lookup[h];
+		m_lookup[h] = idx;
+		m_entryCount++;
+	}
+
+	dtPolyRef* epath = &m_paths[idx*m_maxPathSize];
+	unsigned short* flags = &m_flags[idx*m_maxPathSize];
+	unsigned char* areas = &m_areas[idx*m_maxPathSize];
+
+	for (int i = 0; i < pathCount; ++i)
+	{
+		const dtMeshTile* tile = 0;
+		const dtPoly* poly = 0;
+		m_nav->getTileAndPolyByRefUnsafe(path[i], &tile, &poly);
+		epath[i] = path[i];
+		flags[i] = poly->flags;
+		areas[i] = poly->getArea();
+	}
+	m_entries[idx].npath = pathCount;
+
+	pushLru(idx);
+
+	return true;
+}
+
+dtStatus dtPathCache::findPath(const dtNavMeshQuery* query, dtPolyRef startRef, dtPolyRef endRef,
+							   const float* startPos, const float* endPos,
+							   const dtQueryFilter* filter,
+							   dtPolyRef* path, int* pathCount, const int maxPath)
+{
+	if (!query || !pathCount)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	if (find(startRef, endRef, filter, path, pathCount, maxPath))
+		return DT_SUCCESS;
+
+	const dtStatus status = query->findPath(startRef, endRef, startPos, endPos, filter,
+											path, pathCount, maxPath);
+	if (dtStatusSucceed(status) && !(status & DT_STATUS_DETAIL_MASK))
+		store(startRef, endRef, filter, path, *pathCount);
+
+	return status;
+}
+
+void dtPathCache::invalidatePoly(dtPolyRef ref)
+{
+	if (!m_entries)
+		return;
+
+	for (int i = 0; i < m_maxEntries; ++i)
+	{
+		const Entry& e = m_entries[i];
+		if (!e.npath)
+			continue;
+		const dtPolyRef* path = &m_paths[i*m_maxPathSize];
+		for (int j = 0; j < e.npath; ++j)
+		{
+			if (path[j] == ref)
+			{
+				removeEntry(i);
+				m_invalidCount++;
+				break;
+			}
+		}
+	}
+}
+
+void dtPathCache::getStats(dtPathCacheStats* stats) const
+{
+	if (!stats)
+		return;
+
+	stats->entryCount = m_entryCount;
+	stats->maxEntries = m_maxEntries;
+	stats->hitCount = m_hitCount;
+	stats->missCount = m_missCount;
+	stats->invalidCount = m_invalidCount;
+	stats->evictCount = m_evictCount;
+}
+
+void dtPathCache::resetStats()
+{
+	m_hitCount = 0;
+	m_missCount = 0;
+	m_invalidCount = 0;
+	m_evictCount = 0;
+}
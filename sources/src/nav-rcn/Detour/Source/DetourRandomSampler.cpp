@@ -0,0 +1,310 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#include <string.h>
+#include <new>
+#include "DetourRandomSampler.h"
+#include "DetourCommon.h"
+#include "DetourAlloc.h"
+
+dtRandomPointSampler* dtAllocRandomPointSampler()
+{
+	void* mem = dtAlloc(sizeof(dtRandomPointSampler), DT_ALLOC_PERM, DT_ALLOC_TAG_QUERY);
+	if (!mem) return 0;
+	return new(mem) dtRandomPointSampler;
+}
+
+void dtFreeRandomPointSampler(dtRandomPointSampler* sampler)
+{
+	if (!sampler) return;
+	sampler->~dtRandomPointSampler();
+	dtFree(sampler);
+}
+
+// Returns the first index whose cumulative value is greater than u.
+static int findCdfIndex(const float* cdf, const int n, const float u)
+{
+	int lo = 0;
+	int hi = n-1;
+	while (lo < hi)
+	{
+		const int mid = (lo+hi)/2;
+		if (cdf[mid] > u)
+			hi = mid;
+		else
+			lo = mid+1;
+	}
+	return lo;
+}
+
+dtRandomPointSampler::dtRandomPointSampler() :
+	m_query(0),
+	m_nav(0),
+	m_filter(0),
+	m_tiles(0),
+	m_tileCdf(0),
+	m_maxTiles(0),
+	m_lastTile(-1),
+	m_totalArea(0)
+{
+}
+
+dtRandomPointSampler::~dtRandomPointSampler()
+{
+	purge();
+}
+
+void dtRandomPointSampler::purge()
+{
+	if (m_tiles)
+	{
+		for (int i = 0; i < m_maxTiles; ++i)
+		{
+			dtFree(m_tiles[i].cdf);
+			dtFree(m_tiles[i].polys);
+		}
+	}
+	dtFree(m_tiles);
+	dtFree(m_tileCdf);
+	m_tiles = 0;
+	m_tileCdf = 0;
+	m_maxTiles = 0;
+	m_lastTile = -1;
+	m_totalArea = 0;
+}
+
+dtStatus dtRandomPointSampler::init(const dtNavMeshQuery* query, const dtQueryFilter* filter)
+{
+	purge();
+
+	if (!query || !filter || !query->getAttachedNavMesh())
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	m_query = query;
+	m_nav = query->getAttachedNavMesh();
+	m_filter = filter;
+	m_maxTiles = m_nav->getMaxTiles();
+
+	m_tiles = (TileTable*)dtAlloc(sizeof(TileTable)*m_maxTiles, DT_ALLOC_PERM, DT_ALLOC_TAG_QUERY);
+	m_tileCdf = (float*)dtAlloc(sizeof(float)*m_maxTiles, DT_ALLOC_PERM, DT_ALLOC_TAG_QUERY);
+	if (!m_tiles || !m_tileCdf)
+	{
+		purge();
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+	}
+	memset(m_tiles, 0, sizeof(TileTable)*m_maxTiles);
+	memset(m_tileCdf, 0, sizeof(float)*m_maxTiles);
+
+	invalidateAll();
+
+	return update();
+}
+
+dtStatus dtRandomPointSampler::buildTile(const int idx, const dtMeshTile* tile)
+{
+	TileTable& table = m_tiles[idx];
+
+	dtFree(table.cdf);
+	dtFree(table.polys);
+	table.cdf = 0;
+	table.polys = 0;
+	table.npolys = 0;
+	table.ref = 0;
+	table.dirty = false;
+
+	if (!tile || !tile->header)
+		return DT_SUCCESS;
+
+	table.ref = m_nav->getTileRef(tile);
+
+	const int polyCount = tile->header->polyCount;
+	if (!polyCount)
+		return DT_SUCCESS;
+
+	table.cdf = (float*)dtAlloc(sizeof(float)*polyCount, DT_ALLOC_PERM, DT_ALLOC_TAG_QUERY);
+	table.polys = (int*)dtAlloc(sizeof(int)*polyCount, DT_ALLOC_PERM, DT_ALLOC_TAG_QUERY);
+	if (!table.cdf || !table.polys)
+	{
+		dtFree(table.cdf);
+		dtFree(table.polys);
+		table.cdf = 0;
+		table.polys = 0;
+		table.dirty = true;
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+	}
+
+	const dtPolyRef base = m_nav->getPolyRefBase(tile);
+
+	float areaSum = 0.0f;
+	for (int i = 0; i < polyCount; ++i)
+	{
+		const dtPoly* p = &tile->polys[i];
+		// Do not return off-mesh connection polygons.
+		if (p->getType() != DT_POLYTYPE_GROUND)
+			continue;
+		if (!m_filter->passFilter(base | (dtPolyRef)i, tile, p))
+			continue;
+
+		float polyArea = 0.0f;
+		for (int j = 2; j < p->vertCount; ++j)
+		{
+			const float* va = &tile->verts[p->verts[0]*3];
+			const float* vb = &tile->verts[p->verts[j-1]*3];
+			const float* vc = &tile->verts[p->verts[j]*3];
+			polyArea += dtTriArea2D(va,vb,vc);
+		}
+		if (polyArea <= 0.0f)
+			continue;
+
+		areaSum += polyArea;
+		table.cdf[table.npolys] = areaSum;
+		table.polys[table.npolys] = i;
+		table.npolys++;
+	}
+
+	return DT_SUCCESS;
+}
+
+void dtRandomPointSampler::buildTileCdf()
+{
+	float sum = 0.0f;
+	m_lastTile = -1;
+	for (int i = 0; i < m_maxTiles; ++i)
+	{
+		const TileTable& table = m_tiles[i];
+		if (table.npolys > 0)
+		{
+			sum += table.cdf[table.npolys-1];
+			m_lastTile = i;
+		}
+		m_tileCdf[i] = sum;
+	}
+	m_totalArea = sum;
+}
+
+dtStatus dtRandomPointSampler::update(int* rebuildCount)
+{
+	if (!m_tiles)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	dtStatus status = DT_SUCCESS;
+	int count = 0;
+
+	for (int i = 0; i < m_maxTiles; ++i)
+	{
+		const dtMeshTile* tile = m_nav->getTile(i);
+		const dtTileRef ref = (tile && tile->header && !(tile->flags & DT_TILE_RETIRED)) ? m_nav->getTileRef(tile) : 0;
+
+		TileTable& table = m_tiles[i];
+		if (!table.dirty && table.ref == ref)
+			continue;
+
+		status |= buildTile(i, tile);
+		count++;
+	}
+
+	if (count)
+		buildTileCdf();
+
+	if (rebuildCount)
+		*rebuildCount = count;
+
+	return status;
+}
+
+void dtRandomPointSampler::invalidateTile(const dtMeshTile* tile)
+{
+	if (!m_tiles || !tile)
+		return;
+
+	const int idx = (int)(tile - m_nav->getTile(0));
+	if (idx >= 0 && idx < m_maxTiles)
+		m_tiles[idx].dirty = true;
+}
+
+void dtRandomPointSampler::invalidateAll()
+{
+	for (int i = 0; i < m_maxTiles; ++i)
+		m_tiles[i].dirty = true;
+}
+
+dtStatus dtRandomPointSampler::findRandomPoint(float (*frand)(), dtPolyRef* randomRef, float* randomPt) const
+{
+	if (!frand || !randomRef || !randomPt)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	if (m_lastTile == -1)
+		return DT_FAILURE;
+
+	// Pick the tile, then the polygon, weighted by area.
+	// frand() can return 1, so clamp to the last entries with area.
+	const float tu = frand()*m_totalArea;
+	const int it = tu < m_totalArea ? findCdfIndex(m_tileCdf, m_maxTiles, tu) : m_lastTile;
+	const TileTable& table = m_tiles[it];
+
+	const float tileArea = table.cdf[table.npolys-1];
+	const float pu = frand()*tileArea;
+	const int ip = pu < tileArea ? findCdfIndex(table.cdf, table.npolys, pu) : table.npolys-1;
+
+	// Fails if the mesh changed since the last update.
+	const dtMeshTile* tile = m_nav->getTile(it);
+	if (!tile->header || m_nav->getTileRef(tile) != table.ref)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	const dtPoly* poly = &tile->polys[table.polys[ip]];
+	const dtPolyRef polyRef = m_nav->getPolyRefBase(tile) | (dtPolyRef)table.polys[ip];
+
+	// Randomly pick point on polygon.
+	float verts[3*DT_VERTS_PER_POLYGON];
+	float areas[DT_VERTS_PER_POLYGON];
+	for (int j = 0; j < poly->vertCount; ++j)
+		dtVcopy(&verts[j*3], &tile->verts[poly->verts[j]*3]);
+
+	const float s = frand();
+	const float t = frand();
+
+	float pt[3];
+	dtRandomPointInConvexPoly(verts, poly->vertCount, areas, s, t, pt);
+
+	float h = 0.0f;
+	dtStatus status = m_query->getPolyHeight(polyRef, pt, &h);
+	if (dtStatusFailed(status))
+		return status;
+	pt[1] = h;
+
+	dtVcopy(randomPt, pt);
+	*randomRef = polyRef;
+
+	return DT_SUCCESS;
+}
+
+dtStatus dtRandomPointSampler::findRandomPoints(float (*frand)(), const int count,
+												dtPolyRef* randomRefs, float* randomPts) const
+{
+	if (!randomRefs || !randomPts || count < 0)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	for (int i = 0; i < count; ++i)
+	{
+		dtStatus status = findRandomPoint(frand, &randomRefs[i], &randomPts[i*3]);
+		if (dtStatusFailed(status))
+			return status;
+	}
+
+	return DT_SUCCESS;
+}
@@ -0,0 +1,709 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#include <string.h>
+#include <new>
+#include "DetourRaycastCache.h"
+#include "DetourCommon.h"
+#include "DetourMath.h"
+#include "DetourAlloc.h"
+
+// Raycasts don't use the node pool.
+static const int RAYCAST_QUERY_NODES = 32;
+
+// The number of cache misses cast by one scheduler task.
+static const int RAYS_PER_TASK = 16;
+
+dtRaycastCache* dtAllocRaycastCache()
+{
+	void* mem = dtAlloc(sizeof(dtRaycastCache), DT_ALLOC_PERM, DT_ALLOC_TAG_QUERY);
+	if (!mem) return 0;
+	return new(mem) dtRaycastCache;
+}
+
+void dtFreeRaycastCache(dtRaycastCache* cache)
+{
+	if (!cache) return;
+	cache->~dtRaycastCache();
+	dtFree(cache);
+}
+
+inline unsigned int fnvHash(unsigned int h, const void* data, const int size)
+{
+	const unsigned char* p = (const unsigned char*)data;
+	for (int i = 0; i < size; ++i)
+		h = (h ^ p[i]) * 16777619u;
+	return h;
+}
+
+dtRaycastCache::dtRaycastCache() :
+	m_nav(0),
+	m_quantum(0),
+	m_entries(0),
+	m_maxEntries(0),
+	m_entryCount(0),
+	m_lookup(0),
+	m_lookupMask(0),
+	m_nextFree(-1),
+	m_lruHead(-1),
+	m_lruTail(-1),
+	m_scheduler(0),
+	m_workerQueries(0),
+	m_workerPaths(0),
+	m_workerCount(0)
+{
+	resetStats();
+}
+
+dtRaycastCache::~dtRaycastCache()
+{
+	purge();
+}
+
+void dtRaycastCache::purge()
+{
+	freeWorkers();
+	dtFree(m_entries);
+	dtFree(m_lookup);
+	m_entries = 0;
+	m_lookup = 0;
+	m_maxEntries = 0;
+	m_entryCount = 0;
+	m_scheduler = 0;
+	m_nav = 0;
+}
+
+void dtRaycastCache::freeWorkers()
+{
+	for (int i = 0; i < m_workerCount; ++i)
+		dtFreeNavMeshQuery(m_workerQueries[i]);
+
+	dtFree(m_workerQueries);
+	dtFree(m_workerPaths);
+	m_workerQueries = 0;
+	m_workerPaths = 0;
+	m_workerCount = 0;
+}
+
+bool dtRaycastCache::initWorkers(const int count)
+{
+	freeWorkers();
+
+	m_workerQueries = (dtNavMeshQuery**)dtAlloc(sizeof(dtNavMeshQuery*)*count, DT_ALLOC_PERM, DT_ALLOC_TAG_QUERY);
+	m_workerPaths = (dtPolyRef*)dtAlloc(sizeof(dtPolyRef)*DT_RAYCAST_CACHE_MAX_PATH*count,
+										DT_ALLOC_PERM, DT_ALLOC_TAG_QUERY);
+	if (!m_workerQueries || !m_workerPaths)
+	{
+		freeWorkers();
+		return false;
+	}
+
+	memset(m_workerQueries, 0, sizeof(dtNavMeshQuery*)*count);
+	m_workerCount = count;
+
+	for (int i = 0; i < count; ++i)
+	{
+		m_workerQueries[i] = dtAllocNavMeshQuery();
+		if (!m_workerQueries[i] ||
+			dtStatusFailed(m_workerQueries[i]->init(m_nav, RAYCAST_QUERY_NODES)))
+		{
+			freeWorkers();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int dtRaycastCache::getMemUsed() const
+{
+	int size = sizeof(*this) +
+		(int)dtAllocSize(m_entries) +
+		(int)dtAllocSize(m_lookup) +
+		(int)dtAllocSize(m_workerQueries) +
+		(int)dtAllocSize(m_workerPaths);
+	for (int i = 0; i < m_workerCount; ++i)
+		size += m_workerQueries[i]->getMemUsed();
+	return size;
+}
+
+dtStatus dtRaycastCache::init(const dtNavMesh* nav, const int maxEntries, const float quantum)
+{
+	purge();
+
+	if (!nav || maxEntries < 1)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	const int lookupSize = dtNextPow2(maxEntries);
+
+	m_entries = (Entry*)dtAlloc(sizeof(Entry)*maxEntries, DT_ALLOC_PERM, DT_ALLOC_TAG_QUERY);
+	m_lookup = (int*)dtAlloc(sizeof(int)*lookupSize, DT_ALLOC_PERM, DT_ALLOC_TAG_QUERY);
+	if (!m_entries || !m_lookup)
+	{
+		purge();
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+	}
+
+	m_nav = nav;
+	m_quantum = quantum > 0 ? quantum : 0;
+	m_maxEntries = maxEntries;
+	m_lookupMask = lookupSize-1;
+
+	if (!initWorkers(1))
+	{
+		purge();
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+	}
+
+	clear();
+	resetStats();
+
+	return DT_SUCCESS;
+}
+
+/// @par
+///
+/// The scheduler must outlive the cache, or be replaced before it is destroyed.
+/// Each worker gets its own navigation mesh query.  The results do not depend
+/// on the scheduler or the number of workers.
+bool dtRaycastCache::setTaskScheduler(dtTaskScheduler* scheduler)
+{
+	if (!m_nav)
+		return false;
+
+	const int count = scheduler ? scheduler->getWorkerCount() : 1;
+	if (count < 1 || !initWorkers(count))
+	{
+		m_scheduler = 0;
+		initWorkers(1);
+		return false;
+	}
+
+	m_scheduler = scheduler;
+	return true;
+}
+
+void dtRaycastCache::clear()
+{
+	if (!m_entries)
+		return;
+
+	memset(m_entries, 0, sizeof(Entry)*m_maxEntries);
+	for (int i = 0; i <= m_lookupMask; ++i)
+		m_lookup[i] = -1;
+
+	m_nextFree = -1;
+	for (int i = m_maxEntries-1; i >= 0; --i)
+	{
+		m_entries[i].next = m_nextFree;
+		m_nextFree = i;
+	}
+
+	m_lruHead = -1;
+	m_lruTail = -1;
+	m_entryCount = 0;
+}
+
+void dtRaycastCache::makeKey(dtPolyRef startRef, const float* startPos, const float* endPos,
+							 const dtQueryFilter* filter, Key& key) const
+{
+	key.startRef = startRef;
+
+	if (m_quantum > 0)
+	{
+		const float iq = 1.0f / m_quantum;
+		for (int i = 0; i < 3; ++i)
+		{
+			key.pos[i] = (int)dtMathFloorf(startPos[i]*iq);
+			key.pos[3+i] = (int)dtMathFloorf(endPos[i]*iq);
+		}
+	}
+	else
+	{
+		memcpy(&key.pos[0], startPos, sizeof(float)*3);
+		memcpy(&key.pos[3], endPos, sizeof(float)*3);
+	}
+
+	const unsigned short include = filter->getIncludeFlags();
+	const unsigned short exclude = filter->getExcludeFlags();
+	unsigned int h = 2166136261u;
+	h = fnvHash(h, &include, sizeof(include));
+	h = fnvHash(h, &exclude, sizeof(exclude));
+	key.filterHash = h;
+}
+
+inline unsigned int mixHash(unsigned int h, const unsigned int v)
+{
+	h ^= v;
+	h *= 0x9e3779b1u;
+	return h ^ (h >> 15);
+}
+
+int dtRaycastCache::hashKey(const Key& key) const
+{
+	unsigned int h = key.filterHash;
+	dtPolyRef ref = key.startRef;
+	for (int i = 0; i < (int)(sizeof(dtPolyRef)/sizeof(unsigned int)); ++i)
+	{
+		h = mixHash(h, (unsigned int)ref);
+		ref = (dtPolyRef)(ref >> 16 >> 16);
+	}
+	for (int i = 0; i < 6; ++i)
+		h = mixHash(h, (unsigned int)key.pos[i]);
+	return (int)(h & (unsigned int)m_lookupMask);
+}
+
+inline bool keyEquals(const int* a, const int* b)
+{
+	return a[0] == b[0] && a[1] == b[1] && a[2] == b[2]
+		&& a[3] == b[3] && a[4] == b[4] && a[5] == b[5];
+}
+
+int dtRaycastCache::findEntry(const Key& key) const
+{
+	int i = m_lookup[hashKey(key)];
+	while (i != -1)
+	{
+		const Entry& e = m_entries[i];
+		if (e.key.startRef == key.startRef && e.key.filterHash == key.filterHash
+			&& keyEquals(e.key.pos, key.pos))
+		{
+			return i;
+		}
+		i = e.next;
+	}
+	return -1;
+}
+
+void dtRaycastCache::unlinkLru(const int idx)
+{
+	Entry& e = m_entries[idx];
+	if (e.lruPrev != -1)
+		m_entries[e.lruPrev].lruNext = e.lruNext;
+	else
+		m_lruHead = e.lruNext;
+	if (e.lruNext != -1)
+		m_entries[e.lruNext].lruPrev = e.lruPrev;
+	else
+		m_lruTail = e.lruPrev;
+	e.lruPrev = -1;
+	e.lruNext = -1;
+}
+
+void dtRaycastCache::pushLru(const int idx)
+{
+	Entry& e = m_entries[idx];
+	e.lruPrev = -1;
+	e.lruNext = m_lruHead;
+	if (m_lruHead != -1)
+		m_entries[m_lruHead].lruPrev = idx;
+	m_lruHead = idx;
+	if (m_lruTail == -1)
+		m_lruTail = idx;
+}
+
+void dtRaycastCache::removeEntry(const int idx)
+{
+	Entry& e = m_entries[idx];
+
+	const int h = hashKey(e.key);
+	if (m_lookup[h] == idx)
+	{
+		m_lookup[h] = e.next;
+	}
+	else
+	{
+		int i = m_lookup[h];
+		while (m_entries[i].next != idx)
+			i = m_entries[i].next;
+		m_entries[i].next = e.next;
+	}
+
+	unlinkLru(idx);
+
+	e.next = m_nextFree;
+	m_nextFree = idx;
+	m_entryCount--;
+}
+
+bool dtRaycastCache::validate(const int idx)
+{
+	Entry& e = m_entries[idx];
+
+	const unsigned int version = m_nav->getVersion();
+	if (e.version == version)
+		return true;
+
+	for (int i = 0; i < e.ntiles; ++i)
+	{
+		if (m_nav->hasTileChanged(e.tiles[i], e.version))
+			return false;
+	}
+
+	// Nothing the result depends on changed, so it is also valid at the
+	// current version.  This keeps the next check on the fast path.
+	e.version = version;
+
+	return true;
+}
+
+static bool addTile(const dtNavMesh* nav, dtPolyRef ref, dtPolyRef* tiles, int& ntiles)
+{
+	const unsigned int it = nav->decodePolyIdTile(ref);
+	for (int i = 0; i < ntiles; ++i)
+	{
+		if (nav->decodePolyIdTile(tiles[i]) == it)
+			return true;
+	}
+	if (ntiles == DT_RAYCAST_CACHE_MAX_TILES)
+		return false;
+	tiles[ntiles++] = ref;
+	return true;
+}
+
+int dtRaycastCache::collectTiles(const dtPolyRef* path, const int pathCount, dtPolyRef* tiles) const
+{
+	// The result depends on the visited polygons and on the filter state of
+	// their neighbours.  (A link change marks the tiles on both sides.)
+	int ntiles = 0;
+
+	for (int i = 0; i < pathCount; ++i)
+	{
+		const dtMeshTile* tile = 0;
+		const dtPoly* poly = 0;
+		m_nav->getTileAndPolyByRefUnsafe(path[i], &tile, &poly);
+
+		if (!addTile(m_nav, path[i], tiles, ntiles))
+			return 0;
+
+		for (unsigned int j = poly->firstLink; j != DT_NULL_LINK; j = tile->links[j].next)
+		{
+			const dtPolyRef ref = tile->links[j].ref;
+			if (ref && !addTile(m_nav, ref, tiles, ntiles))
+				return 0;
+		}
+	}
+
+	return ntiles;
+}
+
+void dtRaycastCache::insert(const Key& key, const float t, const float* hitNormal, const dtStatus status,
+							const dtPolyRef* tiles, const int ntiles, const unsigned int version)
+{
+	int idx = findEntry(key);
+	if (idx != -1)
+	{
+		unlinkLru(idx);
+	}
+	else
+	{
+		if (m_nextFree == -1)
+		{
+			removeEntry(m_lruTail);
+			m_evictCount++;
+		}
+
+		idx = m_nextFree;
+		m_nextFree = m_entries[idx].next;
+
+		Entry& e = m_entries[idx];
+		e.key = key;
+
+		const int h = hashKey(key);
+		e.next = m_lookup[h];
+		m_lookup[h] = idx;
+		m_entryCount++;
+	}
+
+	Entry& e = m_entries[idx];
+	e.t = t;
+	dtVcopy(e.hitNormal, hitNormal);
+	e.status = status;
+	e.version = version;
+	memcpy(e.tiles, tiles, sizeof(dtPolyRef)*ntiles);
+	e.ntiles = ntiles;
+
+	pushLru(idx);
+}
+
+bool dtRaycastCache::find(dtPolyRef startRef, const float* startPos, const float* endPos,
+						  const dtQueryFilter* filter, float* t, float* hitNormal, dtStatus* status)
+{
+	if (!m_entries || !startPos || !endPos || !filter || !t)
+		return false;
+
+	Key key;
+	makeKey(startRef, startPos, endPos, filter, key);
+
+	const int idx = findEntry(key);
+	if (idx == -1)
+	{
+		m_missCount++;
+		return false;
+	}
+
+	if (!validate(idx))
+	{
+		removeEntry(idx);
+		m_invalidCount++;
+		m_missCount++;
+		return false;
+	}
+
+	const Entry& e = m_entries[idx];
+	*t = e.t;
+	if (hitNormal)
+		dtVcopy(hitNormal, e.hitNormal);
+	if (status)
+		*status = e.status;
+
+	unlinkLru(idx);
+	pushLru(idx);
+	m_hitCount++;
+
+	return true;
+}
+
+bool dtRaycastCache::store(dtPolyRef startRef, const float* startPos, const float* endPos,
+						   const dtQueryFilter* filter, const float t, const float* hitNormal,
+						   const dtStatus status, const dtPolyRef* path, const int pathCount)
+{
+	if (!m_entries || !startPos || !endPos || !filter || !hitNormal || !path)
+		return false;
+
+	// A truncated path does not cover every tile the result depends on.
+	if (dtStatusFailed(status) || (status & DT_BUFFER_TOO_SMALL)
+		|| pathCount < 1 || path[0] != startRef)
+	{
+		m_uncachedCount++;
+		return false;
+	}
+
+	// Every polygon must be valid so its tile can be recorded.
+	for (int i = 0; i < pathCount; ++i)
+	{
+		if (!m_nav->isValidPolyRef(path[i]))
+			return false;
+	}
+
+	dtPolyRef tiles[DT_RAYCAST_CACHE_MAX_TILES];
+	const int ntiles = collectTiles(path, pathCount, tiles);
+	if (!ntiles)
+	{
+		m_uncachedCount++;
+		return false;
+	}
+
+	Key key;
+	makeKey(startRef, startPos, endPos, filter, key);
+	insert(key, t, hitNormal, status, tiles, ntiles, m_nav->getVersion());
+
+	return true;
+}
+
+dtStatus dtRaycastCache::raycast(dtPolyRef startRef, const float* startPos, const float* endPos,
+								 const dtQueryFilter* filter, float* t, float* hitNormal)
+{
+	if (!m_entries || !startPos || !endPos || !filter || !t)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	dtStatus status;
+	if (find(startRef, startPos, endPos, filter, t, hitNormal, &status))
+		return status;
+
+	dtRaycastHit hit;
+	hit.path = m_workerPaths;
+	hit.maxPath = DT_RAYCAST_CACHE_MAX_PATH;
+
+	status = m_workerQueries[0]->raycast(startRef, startPos, endPos, filter, 0, &hit);
+
+	*t = hit.t;
+	if (hitNormal)
+		dtVcopy(hitNormal, hit.hitNormal);
+
+	store(startRef, startPos, endPos, filter, hit.t, hit.hitNormal, status, hit.path, hit.pathCount);
+
+	// The path is not returned.
+	return status & ~DT_BUFFER_TOO_SMALL;
+}
+
+struct dtRaycastCache::BatchContext
+{
+	const dtRaycastCache* cache;
+	const dtPolyRef* startRefs;
+	const float* startPositions;
+	const float* endPositions;
+	float* resultParams;
+	float* resultNormals;
+	dtStatus* resultStatus;
+	PendingRay* pending;
+	int pendingCount;
+};
+
+void dtRaycastCache::castPendingRays(void* userData, int taskIndex, int workerIndex)
+{
+	BatchContext* ctx = (BatchContext*)userData;
+	const dtRaycastCache* cache = ctx->cache;
+	const dtNavMeshQuery* query = cache->m_workerQueries[workerIndex];
+
+	dtRaycastHit hit;
+	hit.path = &cache->m_workerPaths[workerIndex*DT_RAYCAST_CACHE_MAX_PATH];
+	hit.maxPath = DT_RAYCAST_CACHE_MAX_PATH;
+
+	const int begin = taskIndex*RAYS_PER_TASK;
+	const int end = dtMin(begin + RAYS_PER_TASK, ctx->pendingCount);
+	for (int k = begin; k < end; ++k)
+	{
+		PendingRay& ray = ctx->pending[k];
+		const int i = ray.index;
+
+		const dtStatus status = query->raycast(ctx->startRefs[i],
+											   &ctx->startPositions[i*3], &ctx->endPositions[i*3],
+											   ray.filter, 0, &hit);
+
+		ctx->resultParams[i] = hit.t;
+		if (ctx->resultNormals)
+			dtVcopy(&ctx->resultNormals[i*3], hit.hitNormal);
+		ctx->resultStatus[i] = status & ~DT_BUFFER_TOO_SMALL;
+
+		dtVcopy(ray.hitNormal, hit.hitNormal);
+		ray.ntiles = 0;
+		if (dtStatusSucceed(status) && !(status & DT_BUFFER_TOO_SMALL))
+			ray.ntiles = cache->collectTiles(hit.path, hit.pathCount, ray.tiles);
+	}
+}
+
+/// @par
+///
+/// The lookups and the stores run on the calling thread, in ray order.  Only the
+/// raycasts of the misses run on the task scheduler.  So the results and the
+/// cache state do not depend on the number of workers.
+///
+/// Rays in the same batch that share a key are all cast.  The last one is the
+/// one that stays in the cache.
+///
+/// A ray whose filter index is out of range, or whose filter is null, gets
+/// DT_FAILURE | DT_INVALID_PARAM and is not cast.
+dtStatus dtRaycastCache::raycastBatch(const dtPolyRef* startRefs, const float* startPositions,
+									  const float* endPositions, const dtQueryFilter* const* filters,
+									  const int filterCount, const int* filterIndices, const int count,
+									  float* resultParams, float* resultNormals, dtStatus* resultStatus)
+{
+	if (!m_entries || !startRefs || !startPositions || !endPositions || !filters
+		|| filterCount < 1 || count < 0 || !resultParams || !resultStatus)
+	{
+		return DT_FAILURE | DT_INVALID_PARAM;
+	}
+
+	if (!count)
+		return DT_SUCCESS;
+
+	PendingRay* pending = (PendingRay*)dtAlloc(sizeof(PendingRay)*count, DT_ALLOC_TEMP, DT_ALLOC_TAG_QUERY);
+	if (!pending)
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+	int pendingCount = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		const int fi = filterIndices ? filterIndices[i] : 0;
+		const dtQueryFilter* filter = (fi >= 0 && fi < filterCount) ? filters[fi] : 0;
+		if (!filter)
+		{
+			resultParams[i] = 0;
+			resultStatus[i] = DT_FAILURE | DT_INVALID_PARAM;
+			continue;
+		}
+
+		if (!find(startRefs[i], &startPositions[i*3], &endPositions[i*3], filter,
+				  &resultParams[i], resultNormals ? &resultNormals[i*3] : 0, &resultStatus[i]))
+		{
+			pending[pendingCount].index = i;
+			pending[pendingCount].filter = filter;
+			pendingCount++;
+		}
+	}
+
+	if (pendingCount)
+	{
+		BatchContext ctx;
+		ctx.cache = this;
+		ctx.startRefs = startRefs;
+		ctx.startPositions = startPositions;
+		ctx.endPositions = endPositions;
+		ctx.resultParams = resultParams;
+		ctx.resultNormals = resultNormals;
+		ctx.resultStatus = resultStatus;
+		ctx.pending = pending;
+		ctx.pendingCount = pendingCount;
+
+		const int taskCount = (pendingCount + RAYS_PER_TASK-1) / RAYS_PER_TASK;
+		if (m_scheduler && m_workerCount > 1 && taskCount > 1)
+		{
+			m_scheduler->parallelFor(castPendingRays, &ctx, taskCount);
+		}
+		else
+		{
+			for (int i = 0; i < taskCount; ++i)
+				castPendingRays(&ctx, i, 0);
+		}
+
+		const unsigned int version = m_nav->getVersion();
+		for (int k = 0; k < pendingCount; ++k)
+		{
+			const PendingRay& ray = pending[k];
+			if (!ray.ntiles)
+			{
+				m_uncachedCount++;
+				continue;
+			}
+
+			const int i = ray.index;
+
+			Key key;
+			makeKey(startRefs[i], &startPositions[i*3], &endPositions[i*3], ray.filter, key);
+			insert(key, resultParams[i], ray.hitNormal, resultStatus[i], ray.tiles, ray.ntiles, version);
+		}
+	}
+
+	dtFree(pending);
+
+	return DT_SUCCESS;
+}
+
+void dtRaycastCache::getStats(dtRaycastCacheStats* stats) const
+{
+	if (!stats)
+		return;
+
+	stats->entryCount = m_entryCount;
+	stats->maxEntries = m_maxEntries;
+	stats->hitCount = m_hitCount;
+	stats->missCount = m_missCount;
+	stats->invalidCount = m_invalidCount;
+	stats->evictCount = m_evictCount;
+	stats->uncachedCount = m_uncachedCount;
+}
+
+void dtRaycastCache::resetStats()
+{
+	m_hitCount = 0;
+	m_missCount = 0;
+	m_invalidCount = 0;
+	m_evictCount = 0;
+	m_uncachedCount = 0;
+}
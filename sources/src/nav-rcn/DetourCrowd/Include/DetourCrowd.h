@@ -22,9 +22,12 @@
 #include "DetourNavMeshQuery.h"
 #include "DetourObstacleAvoidance.h"
 #include "DetourLocalBoundary.h"
+#include "DetourWallSegmentCache.h"
 #include "DetourPathCorridor.h"
 #include "DetourProximityGrid.h"
 #include "DetourPathQueue.h"
+#include "DetourFlowField.h"
+#include "DetourTaskScheduler.h"
 
 /// The maximum number of neighbors that a crowd agent can take into account
 /// for steering decisions.
@@ -51,6 +54,20 @@ static const int DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS = 8;
 ///		dtCrowdAgentParams::queryFilterType
 static const int DT_CROWD_MAX_QUERY_FILTER_TYPE = 16;
 
+/// The maximum number of observer positions used to choose the agent levels of detail.
+/// @ingroup crowd
+/// @see dtCrowd::setLodObservers()
+static const int DT_CROWD_MAX_LOD_OBSERVERS = 16;
+
+/// A magic number used to detect the compatibility of crowd states.
+/// @ingroup crowd
+/// @see dtCrowd::storeState()
+static const int DT_CROWD_STATE_MAGIC = 'D'<<24 | 'C'<<16 | 'R'<<8 | 'S';
+
+/// A version number used to detect compatibility of crowd states.
+/// @ingroup crowd
+static const int DT_CROWD_STATE_VERSION = DT_POLYREF_VERSION_FLAG | 1;
+
 /// Provides neighbor data for agents managed by the crowd.
 /// @ingroup crowd
 /// @see dtCrowdAgent::neis, dtCrowd
@@ -69,6 +86,28 @@ enum CrowdAgentState
 	DT_CROWDAGENT_STATE_OFFMESH,		///< The agent is traversing an off-mesh connection.
 };
 
+/// The levels of detail a crowd agent can be updated with.
+/// @ingroup crowd
+/// @see dtCrowdLodParams, dtCrowd::setAgentLod()
+enum dtCrowdAgentLod
+{
+	DT_CROWDAGENT_LOD_FULL,				///< Updated every tick.
+	DT_CROWDAGENT_LOD_REDUCED,			///< Updated every #dtCrowdLodParams::reducedInterval ticks.
+	DT_CROWDAGENT_LOD_SIMPLE,			///< Follows its corridor, with no neighbours, avoidance or collision. Updated every #dtCrowdLodParams::simpleInterval ticks.
+	DT_CROWDAGENT_LOD_AUTO = 0xff,		///< Chosen by the distance to the crowd's observers. (Only for overrides.)
+};
+
+/// Configures how the crowd chooses the agent levels of detail.
+/// @ingroup crowd
+/// @see dtCrowd::setLodParams(), dtCrowd::setLodObservers()
+struct dtCrowdLodParams
+{
+	float reducedRange;		///< Agents further than this from every observer use #DT_CROWDAGENT_LOD_REDUCED. [Limit: >= 0]
+	float simpleRange;		///< Agents further than this from every observer use #DT_CROWDAGENT_LOD_SIMPLE. [Limit: >= 0]
+	int reducedInterval;	///< The number of ticks between the updates of a reduced agent. [Limit: >= 1]
+	int simpleInterval;		///< The number of ticks between the updates of a simple agent. [Limit: >= 1]
+};
+
 /// Configuration parameters for a crowd agent.
 /// @ingroup crowd
 struct dtCrowdAgentParams
@@ -115,6 +154,10 @@ enum MoveRequestState
 /// @ingroup crowd
 struct dtCrowdAgent
 {
+	// Design note: The fields used by most of the update loops come first, so
+	// that they share the first cache lines of the agent. The corridor and
+	// boundary are large and are only used by some of the loops.
+
 	/// True if the agent is active, false if the agent is in an unused slot in the agent pool.
 	bool active;
 
@@ -124,21 +167,14 @@ struct dtCrowdAgent
 	/// True if the agent has valid path (targetState == DT_CROWDAGENT_TARGET_VALID) and the path does not lead to the requested position, else false.
 	bool partial;
 
-	/// The path corridor the agent is using.
-	dtPathCorridor corridor;
+	unsigned char targetState;			///< State of the movement request.
 
-	/// The local boundary data for the agent.
-	dtLocalBoundary boundary;
-	
-	/// Time since the agent's path corridor was optimized.
-	float topologyOptTime;
-	
-	/// The known neighbors of the agent.
-	dtCrowdNeighbour neis[DT_CROWDAGENT_MAX_NEIGHBOURS];
+	// Important: The rcnCrowdAgentCoreData interop structure copies the
+	// fields from nneis to vel as one block.
 
 	/// The number of neighbors.
 	int nneis;
-	
+
 	/// The desired speed.
 	float desiredSpeed;
 
@@ -151,6 +187,18 @@ struct dtCrowdAgent
 	/// The agent's configuration parameters.
 	dtCrowdAgentParams params;
 
+	/// The known neighbors of the agent.
+	dtCrowdNeighbour neis[DT_CROWDAGENT_MAX_NEIGHBOURS];
+
+	/// The path corridor the agent is using.
+	dtPathCorridor corridor;
+
+	/// The local boundary data for the agent.
+	dtLocalBoundary boundary;
+	
+	/// Time since the agent's path corridor was optimized.
+	float topologyOptTime;
+
 	/// The local path corridor corners for the agent. (Staight path.) [(x, y, z) * #ncorners]
 	float cornerVerts[DT_CROWDAGENT_MAX_CORNERS*3];
 
@@ -163,12 +211,22 @@ struct dtCrowdAgent
 	/// The number of corners.
 	int ncorners;
 	
-	unsigned char targetState;			///< State of the movement request.
 	dtPolyRef targetRef;				///< Target polyref of the movement request.
 	float targetPos[3];					///< Target position of the movement request (or velocity in case of DT_CROWDAGENT_TARGET_VELOCITY).
 	dtPathQueueRef targetPathqRef;		///< Path finder ref.
 	bool targetReplan;					///< Flag indicating that the current path is being replanned.
+	bool targetFlowField;				///< True if the path is taken from the crowd's flow fields. (See: #dtCrowd::requestFlowFieldTarget)
 	float targetReplanTime;				/// <Time since the agent's target was replanned.
+
+	/// The importance of the agent's path requests. Higher values are planned first.
+	/// Expressed in world units so that it can be traded against the distance to the
+	/// crowd's path priority center. (See: #dtCrowd::setPathPriorityCenter)
+	float pathPriority;
+	float targetPriority;				///< The effective priority of the pending path request.
+
+	unsigned char lod;					///< The level of detail of the last update. (See: #dtCrowdAgentLod)
+	unsigned char lodOverride;			///< The level of detail to use, or #DT_CROWDAGENT_LOD_AUTO. (See: #dtCrowd::setAgentLod)
+	float lodTime;						///< The time since the agent was last updated.
 };
 
 struct dtCrowdAgentAnimation
@@ -198,21 +256,54 @@ struct dtCrowdAgentDebugInfo
 	dtObstacleAvoidanceDebugData* vod;
 };
 
+/// The native memory used by a crowd, in bytes.
+/// @see dtCrowd::getMemoryStats
+/// @ingroup crowd
+struct dtCrowdMemoryStats
+{
+	int agentBytes;			///< The crowd object and the agent tables.
+	int corridorBytes;		///< The agent path corridors.
+	int pathQueueBytes;		///< The path request queue and its navigation query.
+	int queryBytes;			///< The navigation queries of the crowd and its workers.
+	int avoidanceBytes;		///< The obstacle avoidance queries of the crowd and its workers.
+	int proximityBytes;		///< The proximity grid.
+	int wallBytes;			///< The wall segment cache.
+	int pathCacheBytes;		///< The attached path cache. [Not owned]
+	int flowFieldBytes;		///< The attached flow field cache. [Not owned]
+};
+
 /// Provides local steering behaviors for a group of agents. 
 /// @ingroup crowd
 class dtCrowd
 {
 	int m_maxAgents;
 	dtCrowdAgent* m_agents;
-	dtCrowdAgent** m_activeAgents;
+	dtCrowdAgent** m_activeAgents;		///< The active agents, in no particular order. [Size: #m_numActiveAgents]
+	int* m_activeAgentIndex;			///< The index of each agent in #m_activeAgents, or -1. [Size: #m_maxAgents]
+	int m_numActiveAgents;
+	int* m_freeAgents;					///< Stack of unused agent indices. [Size: #m_maxAgents]
+	int m_numFreeAgents;
 	dtCrowdAgentAnimation* m_agentAnims;
 	
 	dtPathQueue m_pathq;
+	dtFlowFieldCache* m_flowFields;
+	dtCrowdAgent** m_pathqCandidates;
+	int m_pathqMaxIters;
+	float m_pathqMaxTime;
+	float m_pathPriorityCenter[3];
+	float m_pathPriorityWeight;
+
+	dtCrowdLodParams m_lodParams;
+	float m_lodObservers[DT_CROWD_MAX_LOD_OBSERVERS*3];
+	int m_nlodObservers;
+	unsigned int m_lodTick;
+	dtCrowdAgent** m_stepAgents;		///< The agents updated in the current tick. [Size: #m_maxAgents]
 
 	dtObstacleAvoidanceParams m_obstacleQueryParams[DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS];
 	dtObstacleAvoidanceQuery* m_obstacleQuery;
 	
 	dtProximityGrid* m_grid;
+	dtWallSegmentCache* m_walls;
 	
 	dtPolyRef* m_pathResult;
 	int m_maxPathResult;
@@ -227,14 +318,29 @@ class dtCrowd
 
 	dtNavMeshQuery* m_navquery;
 
+	dtTaskScheduler* m_scheduler;
+	dtNavMeshQuery** m_workerQueries;						///< Per worker. [0] is #m_navquery.
+	dtObstacleAvoidanceQuery** m_workerObstacleQueries;		///< Per worker. [0] is #m_obstacleQuery.
+	int* m_workerSampleCounts;
+	int m_workerCount;
+
+	friend struct dtCrowdUpdateTasks;
+
+	bool initWorkers(const int count);
+	void freeWorkers();
+	void runAgentTasks(dtTaskFunc func, void* userData, const int count);
+
 	void updateTopologyOptimization(dtCrowdAgent** agents, const int nagents, const float dt);
 	void updateMoveRequest(const float dt);
 	void checkPathValidity(dtCrowdAgent** agents, const int nagents, const float dt);
+	int updateLod(dtCrowdAgent** agents, const int nagents, const float dt);
 
 	inline int getAgentIndex(const dtCrowdAgent* agent) const  { return (int)(agent - m_agents); }
 
 	bool requestMoveTargetReplan(const int idx, dtPolyRef ref, const float* pos);
+	bool requestFlowFieldPath(dtCrowdAgent* ag);
 
+	void clearAgents();
 	void purge();
 	
 public:
@@ -245,8 +351,13 @@ public:
 	///  @param[in]		maxAgents		The maximum number of agents the crowd can manage. [Limit: >= 1]
 	///  @param[in]		maxAgentRadius	The maximum radius of any agent that will be added to the crowd. [Limit: > 0]
 	///  @param[in]		nav				The navigation mesh to use for planning.
+	///  @param[in]		maxPathQueue	The maximum number of queued path requests, or zero to
+	///									allow one request per agent. [Limit: >= 0]
+	///  @param[in]		gridType		The type of proximity grid used to find agent neighbours.
+	///									(See: #dtProximityGridType)
 	/// @return True if the initialization succeeded.
-	bool init(const int maxAgents, const float maxAgentRadius, dtNavMesh* nav);
+	bool init(const int maxAgents, const float maxAgentRadius, dtNavMesh* nav,
+			  const int maxPathQueue = 0, const int gridType = DT_PROXIMITY_GRID_HASHED);
 	
 	/// Sets the shared avoidance configuration for the specified index.
 	///  @param[in]		idx		The index. [Limits: 0 <= value < #DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS]
@@ -295,6 +406,16 @@ public:
 	/// @return True if the request was successfully submitted.
 	bool requestMoveTarget(const int idx, dtPolyRef ref, const float* pos);
 
+	/// Submits a new move request for the specified agent, using the flow field of the target.
+	/// Agents with the same target share the field instead of requesting individual paths.
+	/// Falls back to a normal request if there is no flow field cache, or the agent is outside
+	/// the field. (See: #setFlowFieldCache)
+	///  @param[in]		idx		The agent index. [Limits: 0 <= value < #getAgentCount()]
+	///  @param[in]		ref		The position's polygon reference.
+	///  @param[in]		pos		The position within the polygon. [(x, y, z)]
+	/// @return True if the request was successfully submitted.
+	bool requestFlowFieldTarget(const int idx, dtPolyRef ref, const float* pos);
+
 	/// Submits a new move request for the specified agent.
 	///  @param[in]		idx		The agent index. [Limits: 0 <= value < #getAgentCount()]
 	///  @param[in]		vel		The movement velocity. [(x, y, z)]
@@ -312,11 +433,91 @@ public:
 	/// @return The number of agents returned in @p agents.
 	int getActiveAgents(dtCrowdAgent** agents, const int maxAgents);
 
+	/// The number of active agents.
+	inline int getActiveAgentCount() const { return m_numActiveAgents; }
+
 	/// Updates the steering and positions of all agents.
 	///  @param[in]		dt		The time, in seconds, to update the simulation. [Limit: > 0]
 	///  @param[out]	debug	A debug object to load with debug information. [Opt]
 	void update(const float dt, dtCrowdAgentDebugInfo* debug);
 	
+	/// Sets the scheduler used to run the per-agent phases of #update in parallel.
+	///  @param[in]		scheduler	The scheduler, or null to update on the calling thread. [Opt]
+	/// @return True if the per-worker query objects could be created.
+	/// If false, the crowd reverts to the serial update.
+	bool setTaskScheduler(dtTaskScheduler* scheduler);
+
+	/// Gets the scheduler used by #update.
+	/// @return The scheduler, or null if the update is serial.
+	dtTaskScheduler* getTaskScheduler() const { return m_scheduler; }
+
+	/// Sets the pathfinder budget spent on queued path requests during each #update.
+	///  @param[in]		maxIters	The maximum pathfinder iterations per update. [Limit: >= 1]
+	///  @param[in]		maxTime		The time budget per update, or zero for no limit. [Unit: Microseconds]
+	void setPathQueueBudget(const int maxIters, const float maxTime);
+
+	/// Sets the cache used by the path request queue.
+	///  @param[in]		cache	The path cache, or null for no caching. [Not owned]
+	void setPathCache(dtPathCache* cache) { m_pathq.setPathCache(cache); }
+
+	/// Sets the cache used by #requestFlowFieldTarget.
+	///  @param[in]		cache	The flow field cache, or null for none. It must have been
+	///							initialized with the crowd's navigation mesh. [Not owned]
+	void setFlowFieldCache(dtFlowFieldCache* cache) { m_flowFields = cache; }
+
+	/// The flow field cache, or null if there is none.
+	dtFlowFieldCache* getFlowFieldCache() const { return m_flowFields; }
+
+	/// Gets the native memory used by the crowd.
+	///  @param[out]	stats	The memory use of the crowd.
+	void getMemoryStats(dtCrowdMemoryStats* stats) const;
+
+	/// Sets the point used to prioritize path requests by distance.
+	///  @param[in]		pos		The priority center. [(x, y, z)]
+	///  @param[in]		weight	The priority lost per world unit of distance from @p pos,
+	///							or zero to prioritize by agent importance only. [Limit: >= 0]
+	void setPathPriorityCenter(const float* pos, const float weight);
+
+	/// Sets the importance of the specified agent's path requests.
+	///  @param[in]		idx			The agent index. [Limits: 0 <= value < #getAgentCount()]
+	///  @param[in]		priority	The importance. Higher values are planned first.
+	void setAgentPathPriority(const int idx, const float priority);
+
+	/// Sets the ranges and update intervals of the agent levels of detail.
+	///  @param[in]		params	The level of detail configuration.
+	void setLodParams(const dtCrowdLodParams* params);
+
+	/// Gets the ranges and update intervals of the agent levels of detail.
+	/// @return The level of detail configuration.
+	const dtCrowdLodParams* getLodParams() const { return &m_lodParams; }
+
+	/// Sets the positions the agent levels of detail are chosen by. Usually the players.
+	///  @param[in]		pos			The observer positions. [(x, y, z) * @p count]
+	///  @param[in]		count		The number of observers. [Limits: 0 <= value <= #DT_CROWD_MAX_LOD_OBSERVERS]
+	void setLodObservers(const float* pos, const int count);
+
+	/// Overrides the level of detail of the specified agent.
+	///  @param[in]		idx		The agent index. [Limits: 0 <= value < #getAgentCount()]
+	///  @param[in]		lod		The level of detail, or #DT_CROWDAGENT_LOD_AUTO to choose it
+	///							by observer distance. (See: #dtCrowdAgentLod)
+	void setAgentLod(const int idx, const unsigned char lod);
+
+	/// Gets the size of the buffer required by #storeState to store the crowd's state.
+	/// @return The size of the buffer required to store the state.
+	int getStateSize() const;
+
+	/// Stores the agents, their paths and targets, and the crowd settings in the specified buffer.
+	///  @param[out]	data			The buffer to store the crowd's state in.
+	///  @param[in]		maxDataSize		The size of the data buffer. [Limit: >= #getStateSize]
+	/// @return The status flags for the operation.
+	dtStatus storeState(unsigned char* data, const int maxDataSize) const;
+
+	/// Replaces the agents and the crowd settings with a stored state.
+	///  @param[in]		data			The new state. (Obtained from #storeState.)
+	///  @param[in]		maxDataSize		The size of the state within the data buffer.
+	/// @return The status flags for the operation.
+	dtStatus restoreState(const unsigned char* data, const int maxDataSize);
+
 	/// Gets the filter used by the crowd.
 	/// @return The filter used by the crowd.
 	inline const dtQueryFilter* getFilter(const int i) const { return (i >= 0 && i < DT_CROWD_MAX_QUERY_FILTER_TYPE) ? &m_filters[i] : 0; }
@@ -341,6 +542,10 @@ public:
 	/// @return The crowd's proximity grid.
 	const dtProximityGrid* getGrid() const { return m_grid; }
 
+	/// Gets the wall segments used to update the agent boundaries.
+	/// @return The crowd's wall segment cache.
+	const dtWallSegmentCache* getWallSegmentCache() const { return m_walls; }
+
 	/// Gets the crowd's path request queue.
 	/// @return The crowd's path request queue.
 	const dtPathQueue* getPathQueue() const { return &m_pathq; }
@@ -456,5 +661,24 @@ This value is often based on the agent radius. E.g. radius * 30
 A higher value will result in agents trying to stay farther away from each other at 
 the cost of more difficult steering in tight spaces.
 
+@fn void dtCrowd::setLodParams(const dtCrowdLodParams* params)
+@par
+
+Each tick, every active agent that doesn't have a level of detail override
+is assigned one by its horizontal distance to the nearest observer.  Without
+observers, all agents use #DT_CROWDAGENT_LOD_FULL.
+
+Reduced and simple agents are only stepped every few ticks, with the time
+accumulated since they were last stepped.  The ticks are staggered by agent
+index, so the work is spread evenly.  Agents that are not stepped still take
+part in the move requests, path validity checks, and as neighbours of the
+other agents.
+
+Simple agents skip the local boundary and neighbour queries, the visibility
+and topology optimizations, obstacle avoidance and collision resolution.
+Other agents still avoid them.
+
+The defaults disable the reduced and simple levels of detail.
+
 */
 
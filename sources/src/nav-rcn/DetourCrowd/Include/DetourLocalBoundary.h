@@ -20,13 +20,16 @@
 #define DETOURLOCALBOUNDARY_H
 
 #include "DetourNavMeshQuery.h"
+#include "DetourWallSegmentCache.h"
 
 
 class dtLocalBoundary
 {
-	static const int MAX_LOCAL_SEGS = 8;
-	static const int MAX_LOCAL_POLYS = 16;
-	
+public:
+	static const int MAX_LOCAL_SEGS = 8;		///< The maximum number of segments.
+	static const int MAX_LOCAL_POLYS = 16;		///< The maximum number of polygons.
+
+private:
 	struct Segment
 	{
 		float s[6];	///< Segment start/end
@@ -49,13 +52,21 @@ public:
 	void reset();
 	
 	void update(dtPolyRef ref, const float* pos, const float collisionQueryRange,
-				dtNavMeshQuery* navquery, const dtQueryFilter* filter);
+				dtNavMeshQuery* navquery, const dtQueryFilter* filter,
+				const dtWallSegmentCache* walls = 0);
 	
 	bool isValid(dtNavMeshQuery* navquery, const dtQueryFilter* filter);
+
+	/// Replaces the boundary, e.g. to restore a stored crowd state.
+	/// Segments and polygons beyond the boundary's capacity are ignored.
+	void set(const float* center, const float* segs, const int nsegs,
+			 const dtPolyRef* polys, const int npolys);
 	
 	inline const float* getCenter() const { return m_center; }
 	inline int getSegmentCount() const { return m_nsegs; }
 	inline const float* getSegment(int i) const { return m_segs[i].s; }
+	inline int getPolyCount() const { return m_npolys; }
+	inline const dtPolyRef* getPolys() const { return m_polys; }
 
 private:
 	// Explicitly disabled copy constructor and copy assignment operator.
@@ -92,6 +92,7 @@ struct dtObstacleAvoidanceParams
 	unsigned char adaptiveDivs;	///< adaptive
 	unsigned char adaptiveRings;	///< adaptive
 	unsigned char adaptiveDepth;	///< adaptive
+	unsigned char simdSampling;	///< Score the samples four at a time with SIMD instructions, where available. [0 = off]
 };
 
 class dtObstacleAvoidanceQuery
@@ -125,6 +126,9 @@ public:
 	inline int getObstacleSegmentCount() const { return m_nsegments; }
 	const dtObstacleSegment* getObstacleSegment(const int i) { return &m_segments[i]; }
 
+	/// Gets the memory used by the query, in bytes.
+	int getMemUsed() const;
+
 private:
 	// Explicitly disabled copy constructor and copy assignment operator.
 	dtObstacleAvoidanceQuery(const dtObstacleAvoidanceQuery&);
@@ -138,6 +142,23 @@ private:
 						const float minPenalty,
 						dtObstacleAvoidanceDebugData* debug);
 
+	struct SampleBatch
+	{
+		float x[4], z[4];
+		int n;
+	};
+
+	void prepareBatch(const float* pos, const float rad, const float* vel);
+
+	void processSampleBatch(const float* vcandx, const float* vcandz,
+							const float* pos, const float rad,
+							const float* vel, const float* dvel,
+							const float minPenalty, float* penalties);
+
+	void flushBatch(SampleBatch& batch, const float* pos, const float rad,
+					const float* vel, const float* dvel,
+					float& minPenalty, float* bvel);
+
 	dtObstacleAvoidanceParams m_params;
 	float m_invHorizTime;
 	float m_vmax;
@@ -150,6 +171,9 @@ private:
 	int m_maxSegments;
 	dtObstacleSegment* m_segments;
 	int m_nsegments;
+
+	float* m_batchCircles;	///< Circle data for the batched sampler, one array per field. [(sx, sz, c, wx, wz, dpx, dpz, npx, npz) * m_maxCircles]
+	float* m_batchSegments;	///< Segment data for the batched sampler, one array per field. [(vx, vz, wx, wz, tnum) * m_maxSegments]
 };
 
 dtObstacleAvoidanceQuery* dtAllocObstacleAvoidanceQuery();
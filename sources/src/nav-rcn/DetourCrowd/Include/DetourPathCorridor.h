@@ -21,6 +21,9 @@
 
 #include "DetourNavMeshQuery.h"
 
+/// The number of portals at the front of a corridor that are kept between calls to dtPathCorridor::findCorners.
+static const int DT_PATHCORRIDOR_MAX_PORTALS = 16;
+
 /// Represents a dynamic polygon corridor used to plan agent movement.
 /// @ingroup crowd, detour
 class dtPathCorridor
@@ -32,6 +35,15 @@ class dtPathCorridor
 	int m_npath;
 	int m_maxPath;
 	
+	dtPathPortals m_portals;
+	
+	// The state the whole path was last found valid in. (See: #isValidIncremental)
+	const dtNavMesh* m_validNav;
+	const dtQueryFilter* m_validFilter;
+	unsigned int m_validVersion;		///< The mesh version, or zero if the path is unchecked.
+	unsigned short m_validIncludeFlags;
+	unsigned short m_validExcludeFlags;
+	
 public:
 	dtPathCorridor();
 	~dtPathCorridor();
@@ -87,6 +99,16 @@ public:
 	///  @param[in]		filter			The filter to apply to the operation.	
 	bool isValid(const int maxLookAhead, dtNavMeshQuery* navquery, const dtQueryFilter* filter);
 	
+	/// Checks the current corridor path the same as #isValid, but skips the polygons in tiles
+	/// that have not changed since the whole path was last found valid.
+	///  @param[in]		maxLookAhead	The number of polygons from the beginning of the corridor to search.
+	///  @param[in]		navquery		The query object used to build the corridor.
+	///  @param[in]		filter			The filter to apply to the operation.	
+	bool isValidIncremental(const int maxLookAhead, dtNavMeshQuery* navquery, const dtQueryFilter* filter);
+	
+	/// Makes the next #isValidIncremental call check every polygon.
+	inline void resetValidity() { m_validVersion = 0; }
+	
 	/// Moves the position from the current location to the desired location, adjusting the corridor 
 	/// as needed to reflect the change.
 	///  @param[in]		npos		The desired new position. [(x, y, z)]
@@ -133,7 +155,18 @@ public:
 	/// @return The number of polygons in the current corridor path.
 	inline int getPathCount() const { return m_npath; }
 
+	/// The memory used by the corridor, in bytes.
+	inline int getMemUsed() const { return sizeof(*this) + sizeof(dtPolyRef)*m_maxPath + getPortalMemUsed(m_portals.maxPortals); }
+
 private:
+	// The size of the portal cache allocation, in bytes.
+	static int getPortalMemUsed(const int maxPortals)
+	{
+		if (!maxPortals)
+			return 0;
+		return (int)(sizeof(dtPolyRef)*(maxPortals+1) + sizeof(float)*6*maxPortals + sizeof(unsigned char)*maxPortals);
+	}
+	
 	// Explicitly disabled copy constructor and copy assignment operator.
 	dtPathCorridor(const dtPathCorridor&);
 	dtPathCorridor& operator=(const dtPathCorridor&);
@@ -21,11 +21,37 @@
 
 #include "DetourNavMesh.h"
 #include "DetourNavMeshQuery.h"
+#include "DetourPathCache.h"
 
 static const unsigned int DT_PATHQ_INVALID = 0;
 
 typedef unsigned int dtPathQueueRef;
 
+/// The queue size used when none is specified to #dtPathQueue::init.
+static const int DT_PATHQ_DEFAULT_MAX_QUEUE = 8;
+
+/// A magic number used to detect the compatibility of path queue states.
+static const int DT_PATHQ_STATE_MAGIC = 'D'<<24 | 'P'<<16 | 'Q'<<8 | 'S';
+
+/// A version number used to detect compatibility of path queue states.
+static const int DT_PATHQ_STATE_VERSION = DT_POLYREF_VERSION_FLAG | 1;
+
+/// Queue depth and wait time statistics for a #dtPathQueue.
+/// Wait times are measured in calls to #dtPathQueue::update.
+struct dtPathQueueStats
+{
+	int maxQueue;			///< The maximum number of requests the queue can hold.
+	int pendingCount;		///< The number of requests waiting for, or being processed by, the pathfinder.
+	int readyCount;			///< The number of completed requests waiting for their results to be read.
+	int maxPendingCount;	///< The largest value of #pendingCount seen since the last reset.
+	int rejectedCount;		///< The number of requests refused because the queue was full.
+	int completedCount;		///< The number of requests completed since the last reset.
+	int maxWaitTicks;		///< The longest time a completed request spent in the queue.
+	float avgWaitTicks;		///< The average time completed requests spent in the queue.
+	int lastIterCount;		///< The pathfinder iterations used by the last update.
+	float lastUpdateTime;	///< The time used by the last update. [Unit: Microseconds]
+};
+
 class dtPathQueue
 {
 	struct PathQuery
@@ -41,33 +67,114 @@ class dtPathQueue
 		dtStatus status;
 		int keepAlive;
 		const dtQueryFilter* filter; ///< TODO: This is potentially dangerous!
+		unsigned int options;		///< Sliced query options. (See: #dtFindPathOptions)
+		/// Scheduling.
+		float priority;
+		unsigned int requestTick;
 	};
 	
-	static const int MAX_QUEUE = 8;
-	PathQuery m_queue[MAX_QUEUE];
+	PathQuery* m_queue;
+	int m_maxQueue;
 	dtPathQueueRef m_nextHandle;
 	int m_maxPathSize;
-	int m_queueHead;
+	int m_active;			///< The request owning the sliced query, or -1.
+	int m_activeIters;		///< The iterations spent on the request owning the sliced query.
+	unsigned int m_tick;
 	dtNavMeshQuery* m_navquery;
+	dtPathCache* m_cache;
+
+	int m_maxPendingCount;
+	int m_rejectedCount;
+	int m_completedCount;
+	int m_maxWaitTicks;
+	unsigned int m_totalWaitTicks;
+	int m_lastIterCount;
+	float m_lastUpdateTime;
 	
 	void purge();
+	int findNextRequest() const;
+	void completeRequest(PathQuery& q);
 	
 public:
 	dtPathQueue();
 	~dtPathQueue();
 	
-	bool init(const int maxPathSize, const int maxSearchNodeCount, dtNavMesh* nav);
+	/// Initializes the queue.
+	///  @param[in]		maxPathSize			The maximum number of polygons in a path result.
+	///  @param[in]		maxSearchNodeCount	The maximum number of search nodes used by the pathfinder.
+	///  @param[in]		nav					The navigation mesh to plan on.
+	///  @param[in]		maxQueue			The maximum number of requests the queue can hold. [Limit: >= 1]
+	/// @return True if the initialization succeeded.
+	bool init(const int maxPathSize, const int maxSearchNodeCount, dtNavMesh* nav,
+			  const int maxQueue = DT_PATHQ_DEFAULT_MAX_QUEUE);
 	
-	void update(const int maxIters);
+	/// Advances the pending requests, highest priority first.
+	///  @param[in]		maxIters	The maximum number of pathfinder iterations to use.
+	///  @param[in]		maxTime		The time budget for the update, or zero for no limit. [Unit: Microseconds]
+	void update(const int maxIters, const float maxTime = 0);
 	
+	/// Queues a path request.
+	///  @param[in]		startRef	The reference of the start polygon.
+	///  @param[in]		endRef		The reference of the end polygon.
+	///  @param[in]		startPos	The start position. [(x, y, z)]
+	///  @param[in]		endPos		The end position. [(x, y, z)]
+	///  @param[in]		filter		The filter to use. Must remain valid until the request completes.
+	///  @param[in]		priority	The request priority.  Higher values are processed first.
+	///  @param[in]		options		The sliced query options, e.g. #DT_FINDPATH_BIDIRECTIONAL. (See: #dtFindPathOptions)
+	/// @return The request reference, or #DT_PATHQ_INVALID if the queue is full.
 	dtPathQueueRef request(dtPolyRef startRef, dtPolyRef endRef,
 						   const float* startPos, const float* endPos, 
-						   const dtQueryFilter* filter);
+						   const dtQueryFilter* filter, const float priority = 0,
+						   const unsigned int options = 0);
 	
 	dtStatus getRequestStatus(dtPathQueueRef ref) const;
 	
 	dtStatus getPathResult(dtPathQueueRef ref, dtPolyRef* path, int* pathSize, const int maxPath);
 	
+	/// Gets the queue statistics.
+	///  @param[out]	stats	The statistics.
+	void getStats(dtPathQueueStats* stats) const;
+
+	/// Resets the cumulative statistics.
+	void resetStats();
+
+	/// Sets the cache checked by #request and filled by #update.
+	///  @param[in]		cache	The path cache, or null for no caching. It must have been
+	///							initialized with the queue's navigation mesh.
+	void setPathCache(dtPathCache* cache) { m_cache = cache; }
+
+	/// The path cache, or null if there is none.
+	inline dtPathCache* getPathCache() const { return m_cache; }
+
+	/// Gets the memory used by the queue and its navigation query, in bytes.
+	/// The path cache is not included, since the queue does not own it.
+	int getMemUsed() const;
+
+	/// Gets the size of the buffer required by #storeState to store the queue's state.
+	/// @return The size of the buffer required to store the state.
+	int getStateSize() const;
+
+	/// Stores the queued requests and their results in the specified buffer.
+	///  @param[out]	data			The buffer to store the queue's state in.
+	///  @param[in]		maxDataSize		The size of the data buffer. [Limit: >= #getStateSize]
+	///  @param[in]		filters			The filters the requests may use. [Size: @p filterCount]
+	///  @param[in]		filterCount		The number of filters.
+	/// @return The status flags for the operation.
+	dtStatus storeState(unsigned char* data, const int maxDataSize,
+						const dtQueryFilter* filters, const int filterCount) const;
+
+	/// Replaces the queued requests and their results.
+	///  @param[in]		data			The new state. (Obtained from #storeState.)
+	///  @param[in]		maxDataSize		The size of the state within the data buffer.
+	///  @param[in]		filters			The filters the requests may use. [Size: @p filterCount]
+	///  @param[in]		filterCount		The number of filters.
+	/// @return The status flags for the operation.
+	dtStatus restoreState(const unsigned char* data, const int maxDataSize,
+						  const dtQueryFilter* filters, const int filterCount);
+
+	/// The maximum number of requests the queue can hold.
+	inline int getMaxQueue() const { return m_maxQueue; }
+
 	inline const dtNavMeshQuery* getNavQuery() const { return m_navquery; }
 
 private:
@@ -19,10 +19,22 @@
 #ifndef DETOURPROXIMITYGRID_H
 #define DETOURPROXIMITYGRID_H
 
+/// The ways a #dtProximityGrid can store its items.
+enum dtProximityGridType
+{
+	/// Items are linked into hashed cell buckets for every cell their bounds overlap.
+	DT_PROXIMITY_GRID_HASHED = 0,
+
+	/// Items are stored once, sorted by cell into contiguous ranges with their bounds.
+	/// (See: #dtProximityGrid::sortItems)
+	DT_PROXIMITY_GRID_SORTED = 1,
+};
+
 class dtProximityGrid
 {
 	float m_cellSize;
 	float m_invCellSize;
+	int m_type;
 	
 	struct Item
 	{
@@ -38,12 +50,22 @@ class dtProximityGrid
 	int m_bucketsSize;
 	
 	int m_bounds[4];
+
+	// Sorted grid data. The pool holds the items in the order they were added,
+	// with the cell of their minimum bounds.
+	float* m_itemBounds;			///< The bounds of the added items. [(minx, miny, maxx, maxy) * m_poolHead]
+	int* m_cellStart;				///< The start of each bucket's range in the sorted items. [Size: m_bucketsSize+1]
+	unsigned short* m_sortedIds;	///< [Size: m_poolSize]
+	short* m_sortedCells;			///< [(x, y) * m_poolSize]
+	float* m_sortedBounds;			///< The item bounds. [minx * m_poolSize, miny..., maxx..., maxy...]
+	int m_sortedCount;
+	int m_maxCellSpan[2];			///< The largest number of cells an item spans, minus one. [(x, y)]
 	
 public:
 	dtProximityGrid();
 	~dtProximityGrid();
 	
-	bool init(const int poolSize, const float cellSize);
+	bool init(const int poolSize, const float cellSize, const int type = DT_PROXIMITY_GRID_HASHED);
 	
 	void clear();
 	
@@ -51,6 +73,11 @@ public:
 				 const float minx, const float miny,
 				 const float maxx, const float maxy);
 	
+	/// Sorts the items added since the last clear.  Must be called after adding
+	/// the items to a sorted grid and before it is queried. (Does nothing for 
+	/// a hashed grid.)
+	void sortItems();
+	
 	int queryItems(const float minx, const float miny,
 				   const float maxx, const float maxy,
 				   unsigned short* ids, const int maxIds) const;
@@ -59,11 +86,19 @@ public:
 	
 	inline const int* getBounds() const { return m_bounds; }
 	inline float getCellSize() const { return m_cellSize; }
+	inline int getType() const { return m_type; }
+
+	/// Gets the memory used by the grid, in bytes.
+	int getMemUsed() const;
 
 private:
 	// Explicitly disabled copy constructor and copy assignment operator.
 	dtProximityGrid(const dtProximityGrid&);
 	dtProximityGrid& operator=(const dtProximityGrid&);
+
+	int querySortedItems(const float minx, const float miny,
+						 const float maxx, const float maxy,
+						 unsigned short* ids, const int maxIds) const;
 };
 
 dtProximityGrid* dtAllocProximityGrid();
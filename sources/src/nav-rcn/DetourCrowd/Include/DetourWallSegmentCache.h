@@ -0,0 +1,82 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifndef DETOURWALLSEGMENTCACHE_H
+#define DETOURWALLSEGMENTCACHE_H
+
+#include "DetourNavMesh.h"
+#include "DetourNavMeshQuery.h"
+
+/// Precomputed polygon edge segments for each tile of a navigation mesh, used
+/// in place of dtNavMeshQuery::getPolyWallSegments by the local boundary.
+/// Portals are stored with the polygon they lead to and checked against the
+/// filter when the segments are gathered, so changes to the polygon flags
+/// don't require a rebuild.
+class dtWallSegmentCache
+{
+	struct TileSegments
+	{
+		dtTileRef ref;			///< The tile the segments were built for, or zero.
+		int tx, ty;				///< The tile location.
+		bool dirty;				///< The links of the tile may have changed.
+		int polyCount;
+		int segCount;
+		int* polyFirst;			///< First segment of each polygon. [(index) * (polyCount + 1)]
+		float* verts;			///< Segment start/end. [(x, y, z) * 2 * segCount]
+		dtPolyRef* neis;		///< The polygon on the other side, or zero for a solid edge. [(polyRef) * segCount]
+		unsigned char* edges;	///< The polygon edge the segment is on. [(edge) * segCount]
+	};
+	
+	const dtNavMesh* m_nav;
+	TileSegments* m_tiles;
+	int m_maxTiles;
+
+	void freeTile(TileSegments& ts);
+	void markNeighbours(const int tx, const int ty);
+	bool buildTile(TileSegments& ts, const dtMeshTile* tile, const dtTileRef ref);
+
+public:
+	dtWallSegmentCache();
+	~dtWallSegmentCache();
+	
+	bool init(const dtNavMesh* nav);
+	
+	/// Builds the segments of tiles that were added to the mesh, and drops the
+	/// segments of tiles that were removed, since the last update.  The
+	/// neighbours of those tiles are rebuilt, since their links changed.
+	void update();
+	
+	/// Gets the wall segments of a polygon, the same as dtNavMeshQuery::getPolyWallSegments
+	/// without portals.  Fails if the tile is not up to date.
+	dtStatus getPolyWallSegments(dtPolyRef ref, const dtQueryFilter* filter,
+								 float* segmentVerts, int* segmentCount, const int maxSegments) const;
+
+	/// Gets the memory used by the cache, in bytes.
+	int getMemUsed() const;
+
+private:
+	// Explicitly disabled copy constructor and copy assignment operator.
+	dtWallSegmentCache(const dtWallSegmentCache&);
+	dtWallSegmentCache& operator=(const dtWallSegmentCache&);
+};
+
+dtWallSegmentCache* dtAllocWallSegmentCache();
+void dtFreeWallSegmentCache(dtWallSegmentCache* ptr);
+
+
+#endif // DETOURWALLSEGMENTCACHE_H
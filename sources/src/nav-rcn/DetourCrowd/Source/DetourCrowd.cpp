@@ -33,7 +33,7 @@
 
 dtCrowd* dtAllocCrowd()
 {
-	void* mem = dtAlloc(sizeof(dtCrowd), DT_ALLOC_PERM);
+	void* mem = dtAlloc(sizeof(dtCrowd), DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
 	if (!mem) return 0;
 	return new(mem) dtCrowd;
 }
@@ -254,15 +254,25 @@ static int addToOptQueue(dtCrowdAgent* newag, dtCrowdAgent** agents, const int n
 	return dtMin(nagents+1, maxAgents);
 }
 
+// Orders path requests by priority, then by time since the last replan.
+static int comparePathRequest(const dtCrowdAgent* a, const dtCrowdAgent* b)
+{
+	if (a->targetPriority != b->targetPriority)
+		return a->targetPriority < b->targetPriority ? -1 : 1;
+	if (a->targetReplanTime != b->targetReplanTime)
+		return a->targetReplanTime < b->targetReplanTime ? -1 : 1;
+	return 0;
+}
+
 static int addToPathQueue(dtCrowdAgent* newag, dtCrowdAgent** agents, const int nagents, const int maxAgents)
 {
-	// Insert neighbour based on greatest time.
+	// Insert neighbour based on highest priority and greatest time.
 	int slot = 0;
 	if (!nagents)
 	{
 		slot = nagents;
 	}
-	else if (newag->targetReplanTime <= agents[nagents-1]->targetReplanTime)
+	else if (comparePathRequest(newag, agents[nagents-1]) <= 0)
 	{
 		if (nagents >= maxAgents)
 			return nagents;
@@ -272,7 +282,7 @@ static int addToPathQueue(dtCrowdAgent* newag, dtCrowdAgent** agents, const int
 	{
 		int i;
 		for (i = 0; i < nagents; ++i)
-			if (newag->targetReplanTime >= agents[i]->targetReplanTime)
+			if (comparePathRequest(newag, agents[i]) >= 0)
 				break;
 		
 		const int tgt = i+1;
@@ -333,15 +343,35 @@ dtCrowd::dtCrowd() :
 	m_maxAgents(0),
 	m_agents(0),
 	m_activeAgents(0),
+	m_activeAgentIndex(0),
+	m_numActiveAgents(0),
+	m_freeAgents(0),
+	m_numFreeAgents(0),
 	m_agentAnims(0),
+	m_flowFields(0),
+	m_pathqCandidates(0),
+	m_pathqMaxIters(MAX_ITERS_PER_UPDATE),
+	m_pathqMaxTime(0),
+	m_pathPriorityWeight(0),
+	m_nlodObservers(0),
+	m_lodTick(0),
+	m_stepAgents(0),
 	m_obstacleQuery(0),
 	m_grid(0),
+	m_walls(0),
 	m_pathResult(0),
 	m_maxPathResult(0),
 	m_maxAgentRadius(0),
 	m_velocitySampleCount(0),
-	m_navquery(0)
+	m_navquery(0),
+	m_scheduler(0),
+	m_workerQueries(0),
+	m_workerObstacleQueries(0),
+	m_workerSampleCounts(0),
+	m_workerCount(0)
 {
+	dtVset(m_pathPriorityCenter, 0,0,0);
+	memset(&m_lodParams, 0, sizeof(m_lodParams));
 }
 
 dtCrowd::~dtCrowd()
@@ -351,6 +381,9 @@ dtCrowd::~dtCrowd()
 
 void dtCrowd::purge()
 {
+	freeWorkers();
+	m_scheduler = 0;
+
 	for (int i = 0; i < m_maxAgents; ++i)
 		m_agents[i].~dtCrowdAgent();
 	dtFree(m_agents);
@@ -359,16 +392,30 @@ void dtCrowd::purge()
 	
 	dtFree(m_activeAgents);
 	m_activeAgents = 0;
+	dtFree(m_activeAgentIndex);
+	m_activeAgentIndex = 0;
+	m_numActiveAgents = 0;
+	dtFree(m_freeAgents);
+	m_freeAgents = 0;
+	m_numFreeAgents = 0;
+	dtFree(m_stepAgents);
+	m_stepAgents = 0;
 
 	dtFree(m_agentAnims);
 	m_agentAnims = 0;
 	
 	dtFree(m_pathResult);
 	m_pathResult = 0;
+
+	dtFree(m_pathqCandidates);
+	m_pathqCandidates = 0;
 	
 	dtFreeProximityGrid(m_grid);
 	m_grid = 0;
 
+	dtFreeWallSegmentCache(m_walls);
+	m_walls = 0;
+
 	dtFreeObstacleAvoidanceQuery(m_obstacleQuery);
 	m_obstacleQuery = 0;
 	
@@ -379,7 +426,8 @@ void dtCrowd::purge()
 /// @par
 ///
 /// May be called more than once to purge and re-initialize the crowd.
-bool dtCrowd::init(const int maxAgents, const float maxAgentRadius, dtNavMesh* nav)
+bool dtCrowd::init(const int maxAgents, const float maxAgentRadius, dtNavMesh* nav,
+				   const int maxPathQueue, const int gridType)
 {
 	purge();
 	
@@ -392,7 +440,13 @@ bool dtCrowd::init(const int maxAgents, const float maxAgentRadius, dtNavMesh* n
 	m_grid = dtAllocProximityGrid();
 	if (!m_grid)
 		return false;
-	if (!m_grid->init(m_maxAgents*4, maxAgentRadius*3))
+	if (!m_grid->init(m_maxAgents*4, maxAgentRadius*3, gridType))
+		return false;
+
+	m_walls = dtAllocWallSegmentCache();
+	if (!m_walls)
+		return false;
+	if (!m_walls->init(nav))
 		return false;
 	
 	m_obstacleQuery = dtAllocObstacleAvoidanceQuery();
@@ -416,26 +470,52 @@ bool dtCrowd::init(const int maxAgents, const float maxAgentRadius, dtNavMesh* n
 		params->adaptiveDivs = 7;
 		params->adaptiveRings = 2;
 		params->adaptiveDepth = 5;
+		params->simdSampling = 1;
 	}
+
+	// The reduced and simple levels of detail are off until the ranges are set.
+	m_lodParams.reducedRange = FLT_MAX;
+	m_lodParams.simpleRange = FLT_MAX;
+	m_lodParams.reducedInterval = 4;
+	m_lodParams.simpleInterval = 8;
+	m_nlodObservers = 0;
+	m_lodTick = 0;
 	
 	// Allocate temp buffer for merging paths.
 	m_maxPathResult = 256;
-	m_pathResult = (dtPolyRef*)dtAlloc(sizeof(dtPolyRef)*m_maxPathResult, DT_ALLOC_PERM);
+	m_pathResult = (dtPolyRef*)dtAlloc(sizeof(dtPolyRef)*m_maxPathResult, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
 	if (!m_pathResult)
 		return false;
 	
-	if (!m_pathq.init(m_maxPathResult, MAX_PATHQUEUE_NODES, nav))
+	const int pathqSize = maxPathQueue > 0 ? maxPathQueue : m_maxAgents;
+	if (!m_pathq.init(m_maxPathResult, MAX_PATHQUEUE_NODES, nav, pathqSize))
+		return false;
+
+	m_pathqCandidates = (dtCrowdAgent**)dtAlloc(sizeof(dtCrowdAgent*)*pathqSize, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+	if (!m_pathqCandidates)
 		return false;
 	
-	m_agents = (dtCrowdAgent*)dtAlloc(sizeof(dtCrowdAgent)*m_maxAgents, DT_ALLOC_PERM);
+	m_agents = (dtCrowdAgent*)dtAlloc(sizeof(dtCrowdAgent)*m_maxAgents, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
 	if (!m_agents)
 		return false;
 	
-	m_activeAgents = (dtCrowdAgent**)dtAlloc(sizeof(dtCrowdAgent*)*m_maxAgents, DT_ALLOC_PERM);
+	m_activeAgents = (dtCrowdAgent**)dtAlloc(sizeof(dtCrowdAgent*)*m_maxAgents, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
 	if (!m_activeAgents)
 		return false;
 
-	m_agentAnims = (dtCrowdAgentAnimation*)dtAlloc(sizeof(dtCrowdAgentAnimation)*m_maxAgents, DT_ALLOC_PERM);
+	m_activeAgentIndex = (int*)dtAlloc(sizeof(int)*m_maxAgents, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+	if (!m_activeAgentIndex)
+		return false;
+
+	m_freeAgents = (int*)dtAlloc(sizeof(int)*m_maxAgents, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+	if (!m_freeAgents)
+		return false;
+
+	m_stepAgents = (dtCrowdAgent**)dtAlloc(sizeof(dtCrowdAgent*)*m_maxAgents, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+	if (!m_stepAgents)
+		return false;
+
+	m_agentAnims = (dtCrowdAgentAnimation*)dtAlloc(sizeof(dtCrowdAgentAnimation)*m_maxAgents, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
 	if (!m_agentAnims)
 		return false;
 	
@@ -447,10 +527,7 @@ bool dtCrowd::init(const int maxAgents, const float maxAgentRadius, dtNavMesh* n
 			return false;
 	}
 
-	for (int i = 0; i < m_maxAgents; ++i)
-	{
-		m_agentAnims[i].active = false;
-	}
+	clearAgents();
 
 	// The navquery is mostly used for local searches, no need for large node pool.
 	m_navquery = dtAllocNavMeshQuery();
@@ -458,10 +535,167 @@ bool dtCrowd::init(const int maxAgents, const float maxAgentRadius, dtNavMesh* n
 		return false;
 	if (dtStatusFailed(m_navquery->init(nav, MAX_COMMON_NODES)))
 		return false;
+
+	if (!initWorkers(1))
+		return false;
 	
 	return true;
 }
 
+/// @par
+///
+/// The attached path and flow field caches are reported separately, since 
+/// several crowds may share them.
+void dtCrowd::getMemoryStats(dtCrowdMemoryStats* stats) const
+{
+	if (!stats)
+		return;
+	
+	memset(stats, 0, sizeof(dtCrowdMemoryStats));
+	
+	stats->agentBytes = (int)(sizeof(dtCrowd) - sizeof(dtPathQueue)) +
+		(int)dtAllocSize(m_agents) +
+		(int)dtAllocSize(m_activeAgents) +
+		(int)dtAllocSize(m_activeAgentIndex) +
+		(int)dtAllocSize(m_freeAgents) +
+		(int)dtAllocSize(m_stepAgents) +
+		(int)dtAllocSize(m_agentAnims) +
+		(int)dtAllocSize(m_pathResult) +
+		(int)dtAllocSize(m_pathqCandidates) +
+		(int)dtAllocSize(m_workerQueries) +
+		(int)dtAllocSize(m_workerObstacleQueries) +
+		(int)dtAllocSize(m_workerSampleCounts);
+	
+	// The corridor objects are part of the agent table.
+	for (int i = 0; i < m_maxAgents; ++i)
+		stats->corridorBytes += m_agents[i].corridor.getMemUsed() - (int)sizeof(dtPathCorridor);
+	
+	stats->pathQueueBytes = m_pathq.getMemUsed();
+	
+	if (m_workerCount > 0)
+	{
+		for (int i = 0; i < m_workerCount; ++i)
+		{
+			stats->queryBytes += m_workerQueries[i]->getMemUsed();
+			stats->avoidanceBytes += m_workerObstacleQueries[i]->getMemUsed();
+		}
+	}
+	else
+	{
+		if (m_navquery)
+			stats->queryBytes = m_navquery->getMemUsed();
+		if (m_obstacleQuery)
+			stats->avoidanceBytes = m_obstacleQuery->getMemUsed();
+	}
+	
+	if (m_grid)
+		stats->proximityBytes = m_grid->getMemUsed();
+	if (m_walls)
+		stats->wallBytes = m_walls->getMemUsed();
+	if (m_pathq.getPathCache())
+		stats->pathCacheBytes = m_pathq.getPathCache()->getMemUsed();
+	if (m_flowFields)
+		stats->flowFieldBytes = m_flowFields->getMemUsed();
+}
+
+void dtCrowd::freeWorkers()
+{
+	// Worker zero uses the crowd's own query objects.
+	for (int i = 1; i < m_workerCount; ++i)
+	{
+		dtFreeNavMeshQuery(m_workerQueries[i]);
+		dtFreeObstacleAvoidanceQuery(m_workerObstacleQueries[i]);
+	}
+
+	dtFree(m_workerQueries);
+	dtFree(m_workerObstacleQueries);
+	dtFree(m_workerSampleCounts);
+	m_workerQueries = 0;
+	m_workerObstacleQueries = 0;
+	m_workerSampleCounts = 0;
+	m_workerCount = 0;
+}
+
+bool dtCrowd::initWorkers(const int count)
+{
+	freeWorkers();
+
+	m_workerQueries = (dtNavMeshQuery**)dtAlloc(sizeof(dtNavMeshQuery*)*count, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+	m_workerObstacleQueries = 
+		(dtObstacleAvoidanceQuery**)dtAlloc(sizeof(dtObstacleAvoidanceQuery*)*count, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+	m_workerSampleCounts = (int*)dtAlloc(sizeof(int)*count, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+	if (!m_workerQueries || !m_workerObstacleQueries || !m_workerSampleCounts)
+	{
+		freeWorkers();
+		return false;
+	}
+
+	memset(m_workerQueries, 0, sizeof(dtNavMeshQuery*)*count);
+	memset(m_workerObstacleQueries, 0, sizeof(dtObstacleAvoidanceQuery*)*count);
+	m_workerCount = count;
+
+	m_workerQueries[0] = m_navquery;
+	m_workerObstacleQueries[0] = m_obstacleQuery;
+
+	for (int i = 1; i < count; ++i)
+	{
+		m_workerQueries[i] = dtAllocNavMeshQuery();
+		if (!m_workerQueries[i] ||
+			dtStatusFailed(m_workerQueries[i]->init(m_navquery->getAttachedNavMesh(), MAX_COMMON_NODES)))
+		{
+			freeWorkers();
+			return false;
+		}
+
+		// Same configuration as the crowd's own query.
+		m_workerObstacleQueries[i] = dtAllocObstacleAvoidanceQuery();
+		if (!m_workerObstacleQueries[i] || !m_workerObstacleQueries[i]->init(6, 8))
+		{
+			freeWorkers();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/// @par
+///
+/// The scheduler must outlive the crowd, or be replaced before it is destroyed.
+/// The update result does not depend on the scheduler or the number of workers.
+/// Each worker gets its own navigation mesh and obstacle avoidance queries, and
+/// the phases that depend on other agents (path requests, off-mesh connection 
+/// triggers, collision application) stay ordered.
+bool dtCrowd::setTaskScheduler(dtTaskScheduler* scheduler)
+{
+	if (!m_navquery)
+		return false;
+
+	const int count = scheduler ? scheduler->getWorkerCount() : 1;
+	if (count < 1 || !initWorkers(count))
+	{
+		m_scheduler = 0;
+		initWorkers(1);
+		return false;
+	}
+
+	m_scheduler = scheduler;
+	return true;
+}
+
+void dtCrowd::runAgentTasks(dtTaskFunc func, void* userData, const int count)
+{
+	if (m_scheduler && m_workerCount > 1 && count > 1)
+	{
+		m_scheduler->parallelFor(func, userData, count);
+	}
+	else
+	{
+		for (int i = 0; i < count; ++i)
+			func(userData, i, 0);
+	}
+}
+
 void dtCrowd::setObstacleAvoidanceParams(const int idx, const dtObstacleAvoidanceParams* params)
 {
 	if (idx >= 0 && idx < DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS)
@@ -475,6 +709,54 @@ const dtObstacleAvoidanceParams* dtCrowd::getObstacleAvoidanceParams(const int i
 	return 0;
 }
 
+void dtCrowd::setPathQueueBudget(const int maxIters, const float maxTime)
+{
+	m_pathqMaxIters = dtMax(maxIters, 1);
+	m_pathqMaxTime = dtMax(maxTime, 0.0f);
+}
+
+/// @par
+///
+/// The effective priority of a path request is the agent's #dtCrowdAgent::pathPriority
+/// less @p weight times its distance from @p pos.  E.g. Set @p pos to the player
+/// position so that nearby agents are replanned first.
+void dtCrowd::setPathPriorityCenter(const float* pos, const float weight)
+{
+	dtVcopy(m_pathPriorityCenter, pos);
+	m_pathPriorityWeight = dtMax(weight, 0.0f);
+}
+
+void dtCrowd::setAgentPathPriority(const int idx, const float priority)
+{
+	if (idx < 0 || idx >= m_maxAgents)
+		return;
+	m_agents[idx].pathPriority = priority;
+}
+
+void dtCrowd::setLodParams(const dtCrowdLodParams* params)
+{
+	m_lodParams.reducedRange = dtMax(params->reducedRange, 0.0f);
+	m_lodParams.simpleRange = dtMax(params->simpleRange, 0.0f);
+	m_lodParams.reducedInterval = dtMax(params->reducedInterval, 1);
+	m_lodParams.simpleInterval = dtMax(params->simpleInterval, 1);
+}
+
+void dtCrowd::setLodObservers(const float* pos, const int count)
+{
+	m_nlodObservers = dtClamp(count, 0, DT_CROWD_MAX_LOD_OBSERVERS);
+	if (m_nlodObservers)
+		memcpy(m_lodObservers, pos, sizeof(float)*3*m_nlodObservers);
+}
+
+void dtCrowd::setAgentLod(const int idx, const unsigned char lod)
+{
+	if (idx < 0 || idx >= m_maxAgents)
+		return;
+	if (lod > DT_CROWDAGENT_LOD_SIMPLE && lod != DT_CROWDAGENT_LOD_AUTO)
+		return;
+	m_agents[idx].lodOverride = lod;
+}
+
 int dtCrowd::getAgentCount() const
 {
 	return m_maxAgents;
@@ -511,18 +793,10 @@ void dtCrowd::updateAgentParameters(const int idx, const dtCrowdAgentParams* par
 /// The agent's position will be constrained to the surface of the navigation mesh.
 int dtCrowd::addAgent(const float* pos, const dtCrowdAgentParams* params)
 {
-	// Find empty slot.
-	int idx = -1;
-	for (int i = 0; i < m_maxAgents; ++i)
-	{
-		if (!m_agents[i].active)
-		{
-			idx = i;
-			break;
-		}
-	}
-	if (idx == -1)
+	if (!m_numFreeAgents)
 		return -1;
+
+	const int idx = m_freeAgents[--m_numFreeAgents];
 	
 	dtCrowdAgent* ag = &m_agents[idx];		
 
@@ -545,6 +819,8 @@ int dtCrowd::addAgent(const float* pos, const dtCrowdAgentParams* params)
 
 	ag->topologyOptTime = 0;
 	ag->targetReplanTime = 0;
+	ag->pathPriority = 0;
+	ag->targetPriority = 0;
 	ag->nneis = 0;
 	
 	dtVset(ag->dvel, 0,0,0);
@@ -560,9 +836,18 @@ int dtCrowd::addAgent(const float* pos, const dtCrowdAgentParams* params)
 		ag->state = DT_CROWDAGENT_STATE_INVALID;
 	
 	ag->targetState = DT_CROWDAGENT_TARGET_NONE;
+	ag->targetFlowField = false;
+
+	ag->lod = DT_CROWDAGENT_LOD_FULL;
+	ag->lodOverride = DT_CROWDAGENT_LOD_AUTO;
+	ag->lodTime = 0;
 	
 	ag->active = true;
 
+	m_agentAnims[idx].active = false;
+	m_activeAgentIndex[idx] = m_numActiveAgents;
+	m_activeAgents[m_numActiveAgents++] = ag;
+
 	return idx;
 }
 
@@ -570,12 +855,23 @@ int dtCrowd::addAgent(const float* pos, const dtCrowdAgentParams* params)
 ///
 /// The agent is deactivated and will no longer be processed.  Its #dtCrowdAgent object
 /// is not removed from the pool.  It is marked as inactive so that it is available for reuse.
+///
+/// The last agent in the active list takes the place of the removed agent, so the
+/// order of #getActiveAgents changes.
 void dtCrowd::removeAgent(const int idx)
 {
-	if (idx >= 0 && idx < m_maxAgents)
-	{
-		m_agents[idx].active = false;
-	}
+	if (idx < 0 || idx >= m_maxAgents || !m_agents[idx].active)
+		return;
+
+	m_agents[idx].active = false;
+
+	const int i = m_activeAgentIndex[idx];
+	dtCrowdAgent* last = m_activeAgents[--m_numActiveAgents];
+	m_activeAgents[i] = last;
+	m_activeAgentIndex[getAgentIndex(last)] = i;
+	m_activeAgentIndex[idx] = -1;
+
+	m_freeAgents[m_numFreeAgents++] = idx;
 }
 
 bool dtCrowd::requestMoveTargetReplan(const int idx, dtPolyRef ref, const float* pos)
@@ -619,6 +915,7 @@ bool dtCrowd::requestMoveTarget(const int idx, dtPolyRef ref, const float* pos)
 	dtVcopy(ag->targetPos, pos);
 	ag->targetPathqRef = DT_PATHQ_INVALID;
 	ag->targetReplan = false;
+	ag->targetFlowField = false;
 	if (ag->targetRef)
 		ag->targetState = DT_CROWDAGENT_TARGET_REQUESTING;
 	else
@@ -627,6 +924,49 @@ bool dtCrowd::requestMoveTarget(const int idx, dtPolyRef ref, const float* pos)
 	return true;
 }
 
+/// @par
+///
+/// The path is taken from the flow field of the target polygon when the request is
+/// processed, and on each replan. The field is built by the first agent that needs it.
+/// Agents outside the field, or whose path does not fit in the path result buffer,
+/// plan their path normally.
+///
+/// The request will be processed during the next #update().
+bool dtCrowd::requestFlowFieldTarget(const int idx, dtPolyRef ref, const float* pos)
+{
+	if (!requestMoveTarget(idx, ref, pos))
+		return false;
+
+	m_agents[idx].targetFlowField = true;
+
+	return true;
+}
+
+bool dtCrowd::requestFlowFieldPath(dtCrowdAgent* ag)
+{
+	if (!m_flowFields)
+		return false;
+
+	const dtFlowField* field = 0;
+	dtStatus status = m_flowFields->getField(ag->targetRef, ag->targetPos,
+											 &m_filters[ag->params.queryFilterType], &field);
+	if (dtStatusFailed(status))
+		return false;
+
+	int npath = 0;
+	status = field->getPath(ag->corridor.getFirstPoly(), m_pathResult, &npath, m_maxPathResult);
+	if (dtStatusFailed(status) || dtStatusDetail(status, DT_BUFFER_TOO_SMALL))
+		return false;
+
+	ag->corridor.setCorridor(ag->targetPos, m_pathResult, npath);
+	ag->boundary.reset();
+	ag->partial = false;
+	ag->targetState = DT_CROWDAGENT_TARGET_VALID;
+	ag->targetReplanTime = 0.0;
+
+	return true;
+}
+
 bool dtCrowd::requestMoveVelocity(const int idx, const float* vel)
 {
 	if (idx < 0 || idx >= m_maxAgents)
@@ -639,6 +979,7 @@ bool dtCrowd::requestMoveVelocity(const int idx, const float* vel)
 	dtVcopy(ag->targetPos, vel);
 	ag->targetPathqRef = DT_PATHQ_INVALID;
 	ag->targetReplan = false;
+	ag->targetFlowField = false;
 	ag->targetState = DT_CROWDAGENT_TARGET_VELOCITY;
 	
 	return true;
@@ -657,6 +998,7 @@ bool dtCrowd::resetMoveTarget(const int idx)
 	dtVset(ag->dvel, 0,0,0);
 	ag->targetPathqRef = DT_PATHQ_INVALID;
 	ag->targetReplan = false;
+	ag->targetFlowField = false;
 	ag->targetState = DT_CROWDAGENT_TARGET_NONE;
 	
 	return true;
@@ -664,34 +1006,471 @@ bool dtCrowd::resetMoveTarget(const int idx)
 
 int dtCrowd::getActiveAgents(dtCrowdAgent** agents, const int maxAgents)
 {
-	int n = 0;
+	const int n = dtMin(m_numActiveAgents, maxAgents);
+	if (agents != m_activeAgents)
+		memcpy(agents, m_activeAgents, sizeof(dtCrowdAgent*)*n);
+	return n;
+}
+
+
+struct dtCrowdState
+{
+	int magic;								// Magic number, used to identify the data.
+	int version;							// Data version number.
+	int dataSize;							// The size of the whole state.
+	int maxAgents;							// The agent capacity of the crowd.
+	int agentCount;							// The number of stored agents, in active agent order.
+	int pathQueueSize;						// The size of the path queue state.
+	dtNavMeshParams navParams;				// The navigation mesh at the time of storing the data.
+	dtObstacleAvoidanceParams obstacleParams[DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS];
+	float areaCost[DT_CROWD_MAX_QUERY_FILTER_TYPE][DT_MAX_AREAS];
+	unsigned short includeFlags[DT_CROWD_MAX_QUERY_FILTER_TYPE];
+	unsigned short excludeFlags[DT_CROWD_MAX_QUERY_FILTER_TYPE];
+	dtCrowdLodParams lodParams;
+	float lodObservers[DT_CROWD_MAX_LOD_OBSERVERS*3];
+	int nlodObservers;
+	unsigned int lodTick;
+	float pathPriorityCenter[3];
+	float pathPriorityWeight;
+	int pathqMaxIters;
+	float pathqMaxTime;
+};
+
+// Followed by the corridor path, the boundary polygons and the boundary segments.
+struct dtCrowdAgentRecord
+{
+	dtPolyRef targetRef;
+	dtPolyRef cornerPolys[DT_CROWDAGENT_MAX_CORNERS];
+	dtPolyRef animRef;
+	int idx;								// The agent index.
+	int nneis;
+	dtCrowdNeighbour neis[DT_CROWDAGENT_MAX_NEIGHBOURS];
+	int ncorners;
+	int npath;								// The number of polygons in the corridor.
+	int nboundarySegs;
+	int nboundaryPolys;
+	// The parameters, except the user data.
+	float radius;
+	float height;
+	float maxAcceleration;
+	float maxSpeed;
+	float collisionQueryRange;
+	float pathOptimizationRange;
+	float separationWeight;
+	float desiredSpeed;
+	float npos[3];
+	float dvel[3];
+	float nvel[3];
+	float vel[3];
+	float cornerVerts[DT_CROWDAGENT_MAX_CORNERS*3];
+	float corridorPos[3];
+	float corridorTarget[3];
+	float boundaryCenter[3];
+	float topologyOptTime;
+	float targetPos[3];
+	float targetReplanTime;
+	float pathPriority;
+	float targetPriority;
+	float lodTime;
+	float animInitPos[3], animStartPos[3], animEndPos[3];
+	float animT, animTmax;
+	dtPathQueueRef targetPathqRef;
+	unsigned char updateFlags;
+	unsigned char obstacleAvoidanceType;
+	unsigned char queryFilterType;
+	unsigned char state;
+	unsigned char partial;
+	unsigned char targetState;
+	unsigned char targetReplan;
+	unsigned char targetFlowField;
+	unsigned char lod;
+	unsigned char lodOverride;
+	unsigned char animActive;
+	unsigned char cornerFlags[DT_CROWDAGENT_MAX_CORNERS];
+};
+
+static int getAgentStateSize(const dtCrowdAgent* ag)
+{
+	return dtAlign4(sizeof(dtCrowdAgentRecord))
+		+ dtAlign4(sizeof(dtPolyRef)*ag->corridor.getPathCount())
+		+ dtAlign4(sizeof(dtPolyRef)*ag->boundary.getPolyCount())
+		+ dtAlign4(sizeof(float)*6*ag->boundary.getSegmentCount());
+}
+
+// The neighbour indices of a record index the agents directly, so they must be in range.
+static bool validNeighbours(const dtCrowdNeighbour* neis, const int nneis, const int maxAgents)
+{
+	for (int i = 0; i < nneis; ++i)
+	{
+		if (neis[i].idx < 0 || neis[i].idx >= maxAgents)
+			return false;
+	}
+	return true;
+}
+
+// Lowest index on top of the free stack, so the agents are allocated in index order.
+void dtCrowd::clearAgents()
+{
 	for (int i = 0; i < m_maxAgents; ++i)
 	{
-		if (!m_agents[i].active) continue;
-		if (n < maxAgents)
-			agents[n++] = &m_agents[i];
+		m_agents[i].active = false;
+		m_agentAnims[i].active = false;
+		m_activeAgentIndex[i] = -1;
+		m_freeAgents[i] = m_maxAgents-1-i;
 	}
-	return n;
+	m_numFreeAgents = m_maxAgents;
+	m_numActiveAgents = 0;
+}
+
+///  @see #storeState
+int dtCrowd::getStateSize() const
+{
+	int size = dtAlign4(sizeof(dtCrowdState)) + dtAlign4(sizeof(int)*m_numFreeAgents);
+	for (int i = 0; i < m_numActiveAgents; ++i)
+		size += getAgentStateSize(m_activeAgents[i]);
+	size += m_pathq.getStateSize();
+	return size;
+}
+
+/// @par
+///
+/// The state holds everything an update depends on: the active agents in their update order,
+/// the free agent indices, the agent parameters, corridors, local boundaries, corners, targets
+/// and off-mesh animations, the queued path requests and their results, and the crowd
+/// settings. (Filters, avoidance and level of detail configurations, and path budgets.)
+/// Restoring it only replays the search of the path request that was being processed, so the
+/// simulation continues exactly as it would have.
+///
+/// The agent user data is not stored, since it is usually a pointer. The proximity grid is
+/// rebuilt by every update, so it is not stored either.
+///
+/// The state stays valid across processes for a navigation mesh with the same parameters and
+/// polygon references. E.g. One loaded from the same data.
+/// @see #getStateSize, #restoreState
+dtStatus dtCrowd::storeState(unsigned char* data, const int maxDataSize) const
+{
+	if (!m_navquery)
+		return DT_FAILURE;
+
+	// Make sure there is enough space to store the state.
+	const int sizeReq = getStateSize();
+	if (!data || maxDataSize < sizeReq)
+		return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+
+	dtCrowdState* state = dtGetThenAdvanceBufferPointer<dtCrowdState>(data, dtAlign4(sizeof(dtCrowdState)));
+	memset(state, 0, sizeof(dtCrowdState));
+	state->magic = DT_CROWD_STATE_MAGIC;
+	state->version = DT_CROWD_STATE_VERSION;
+	state->dataSize = sizeReq;
+	state->maxAgents = m_maxAgents;
+	state->agentCount = m_numActiveAgents;
+	state->pathQueueSize = m_pathq.getStateSize();
+	memcpy(&state->navParams, m_navquery->getAttachedNavMesh()->getParams(), sizeof(dtNavMeshParams));
+	memcpy(state->obstacleParams, m_obstacleQueryParams, sizeof(m_obstacleQueryParams));
+	for (int i = 0; i < DT_CROWD_MAX_QUERY_FILTER_TYPE; ++i)
+	{
+		for (int j = 0; j < DT_MAX_AREAS; ++j)
+			state->areaCost[i][j] = m_filters[i].getAreaCost(j);
+		state->includeFlags[i] = m_filters[i].getIncludeFlags();
+		state->excludeFlags[i] = m_filters[i].getExcludeFlags();
+	}
+	state->lodParams = m_lodParams;
+	memcpy(state->lodObservers, m_lodObservers, sizeof(m_lodObservers));
+	state->nlodObservers = m_nlodObservers;
+	state->lodTick = m_lodTick;
+	dtVcopy(state->pathPriorityCenter, m_pathPriorityCenter);
+	state->pathPriorityWeight = m_pathPriorityWeight;
+	state->pathqMaxIters = m_pathqMaxIters;
+	state->pathqMaxTime = m_pathqMaxTime;
+
+	int* freeAgents = dtGetThenAdvanceBufferPointer<int>(data, dtAlign4(sizeof(int)*m_numFreeAgents));
+	memcpy(freeAgents, m_freeAgents, sizeof(int)*m_numFreeAgents);
+
+	for (int i = 0; i < m_numActiveAgents; ++i)
+	{
+		const dtCrowdAgent* ag = m_activeAgents[i];
+		const int idx = getAgentIndex(ag);
+		const dtCrowdAgentAnimation* anim = &m_agentAnims[idx];
+
+		dtCrowdAgentRecord* r = dtGetThenAdvanceBufferPointer<dtCrowdAgentRecord>(data, dtAlign4(sizeof(dtCrowdAgentRecord)));
+		memset(r, 0, sizeof(dtCrowdAgentRecord));
+
+		r->targetRef = ag->targetRef;
+		memcpy(r->cornerPolys, ag->cornerPolys, sizeof(ag->cornerPolys));
+		r->animRef = anim->polyRef;
+		r->idx = idx;
+		r->nneis = ag->nneis;
+		memcpy(r->neis, ag->neis, sizeof(ag->neis));
+		r->ncorners = ag->ncorners;
+		r->npath = ag->corridor.getPathCount();
+		r->nboundarySegs = ag->boundary.getSegmentCount();
+		r->nboundaryPolys = ag->boundary.getPolyCount();
+		r->radius = ag->params.radius;
+		r->height = ag->params.height;
+		r->maxAcceleration = ag->params.maxAcceleration;
+		r->maxSpeed = ag->params.maxSpeed;
+		r->collisionQueryRange = ag->params.collisionQueryRange;
+		r->pathOptimizationRange = ag->params.pathOptimizationRange;
+		r->separationWeight = ag->params.separationWeight;
+		r->desiredSpeed = ag->desiredSpeed;
+		dtVcopy(r->npos, ag->npos);
+		dtVcopy(r->dvel, ag->dvel);
+		dtVcopy(r->nvel, ag->nvel);
+		dtVcopy(r->vel, ag->vel);
+		memcpy(r->cornerVerts, ag->cornerVerts, sizeof(ag->cornerVerts));
+		dtVcopy(r->corridorPos, ag->corridor.getPos());
+		dtVcopy(r->corridorTarget, ag->corridor.getTarget());
+		dtVcopy(r->boundaryCenter, ag->boundary.getCenter());
+		r->topologyOptTime = ag->topologyOptTime;
+		dtVcopy(r->targetPos, ag->targetPos);
+		r->targetReplanTime = ag->targetReplanTime;
+		r->pathPriority = ag->pathPriority;
+		r->targetPriority = ag->targetPriority;
+		r->lodTime = ag->lodTime;
+		dtVcopy(r->animInitPos, anim->initPos);
+		dtVcopy(r->animStartPos, anim->startPos);
+		dtVcopy(r->animEndPos, anim->endPos);
+		r->animT = anim->t;
+		r->animTmax = anim->tmax;
+		r->targetPathqRef = ag->targetPathqRef;
+		r->updateFlags = ag->params.updateFlags;
+		r->obstacleAvoidanceType = ag->params.obstacleAvoidanceType;
+		r->queryFilterType = ag->params.queryFilterType;
+		r->state = ag->state;
+		r->partial = ag->partial ? 1 : 0;
+		r->targetState = ag->targetState;
+		r->targetReplan = ag->targetReplan ? 1 : 0;
+		r->targetFlowField = ag->targetFlowField ? 1 : 0;
+		r->lod = ag->lod;
+		r->lodOverride = ag->lodOverride;
+		r->animActive = anim->active ? 1 : 0;
+		memcpy(r->cornerFlags, ag->cornerFlags, sizeof(ag->cornerFlags));
+
+		memcpy(data, ag->corridor.getPath(), sizeof(dtPolyRef)*r->npath);
+		data += dtAlign4(sizeof(dtPolyRef)*r->npath);
+
+		memcpy(data, ag->boundary.getPolys(), sizeof(dtPolyRef)*r->nboundaryPolys);
+		data += dtAlign4(sizeof(dtPolyRef)*r->nboundaryPolys);
+
+		float* segs = dtGetThenAdvanceBufferPointer<float>(data, dtAlign4(sizeof(float)*6*r->nboundarySegs));
+		for (int j = 0; j < r->nboundarySegs; ++j)
+			memcpy(&segs[j*6], ag->boundary.getSegment(j), sizeof(float)*6);
+	}
+
+	return m_pathq.storeState(data, state->pathQueueSize, m_filters, DT_CROWD_MAX_QUERY_FILTER_TYPE);
 }
 
+/// @par
+///
+/// The crowd must have been initialized with the same maximum agent count, on a navigation
+/// mesh with the same parameters as the stored crowd.  The agent indices are preserved, and
+/// the user data of the restored agents is null.  The proximity grid is rebuilt by the next
+/// update, and any polygon reference that is no longer valid is replanned by it as usual.
+///
+/// If the state is rejected after the agents have been cleared, the crowd is left without
+/// agents.
+/// @see #storeState
+dtStatus dtCrowd::restoreState(const unsigned char* data, const int maxDataSize)
+{
+	const int headerSize = dtAlign4(sizeof(dtCrowdState));
+	if (!m_navquery || !data || maxDataSize < headerSize)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	const unsigned char* start = data;
+	const dtCrowdState* state = dtGetThenAdvanceBufferPointer<const dtCrowdState>(data, headerSize);
+
+	// Check that the restore is possible.
+	if (state->magic != DT_CROWD_STATE_MAGIC)
+		return DT_FAILURE | DT_WRONG_MAGIC;
+	if (state->version != DT_CROWD_STATE_VERSION)
+		return DT_FAILURE | DT_WRONG_VERSION;
+	if (state->dataSize > maxDataSize
+		|| state->maxAgents != m_maxAgents
+		|| state->agentCount < 0 || state->agentCount > m_maxAgents
+		|| state->pathQueueSize < 0)
+	{
+		return DT_FAILURE | DT_INVALID_PARAM;
+	}
+	if (memcmp(&state->navParams, m_navquery->getAttachedNavMesh()->getParams(), sizeof(dtNavMeshParams)) != 0)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	const unsigned char* end = start + state->dataSize;
+	const int freeCount = m_maxAgents - state->agentCount;
+	const int freeSize = dtAlign4(sizeof(int)*freeCount);
+	if (end - data < freeSize)
+		return DT_FAILURE | DT_INVALID_PARAM;
+	const int* freeAgents = dtGetThenAdvanceBufferPointer<const int>(data, freeSize);
+
+	clearAgents();
+
+	memcpy(m_obstacleQueryParams, state->obstacleParams, sizeof(m_obstacleQueryParams));
+	for (int i = 0; i < DT_CROWD_MAX_QUERY_FILTER_TYPE; ++i)
+	{
+		for (int j = 0; j < DT_MAX_AREAS; ++j)
+			m_filters[i].setAreaCost(j, state->areaCost[i][j]);
+		m_filters[i].setIncludeFlags(state->includeFlags[i]);
+		m_filters[i].setExcludeFlags(state->excludeFlags[i]);
+	}
+	m_lodParams = state->lodParams;
+	memcpy(m_lodObservers, state->lodObservers, sizeof(m_lodObservers));
+	m_nlodObservers = dtClamp(state->nlodObservers, 0, DT_CROWD_MAX_LOD_OBSERVERS);
+	m_lodTick = state->lodTick;
+	dtVcopy(m_pathPriorityCenter, state->pathPriorityCenter);
+	m_pathPriorityWeight = state->pathPriorityWeight;
+	m_pathqMaxIters = state->pathqMaxIters;
+	m_pathqMaxTime = state->pathqMaxTime;
+
+	for (int i = 0; i < state->agentCount; ++i)
+	{
+		const int recordSize = dtAlign4(sizeof(dtCrowdAgentRecord));
+		if (end - data < recordSize)
+		{
+			clearAgents();
+			return DT_FAILURE | DT_INVALID_PARAM;
+		}
+
+		const dtCrowdAgentRecord* r = dtGetThenAdvanceBufferPointer<const dtCrowdAgentRecord>(data, recordSize);
+		// The counts are checked before the sizes are computed, so the sizes can't overflow.
+		if (r->idx < 0 || r->idx >= m_maxAgents || m_agents[r->idx].active
+			|| r->npath < 1 || r->npath >= m_maxPathResult
+			|| r->nboundaryPolys < 0 || r->nboundaryPolys > dtLocalBoundary::MAX_LOCAL_POLYS
+			|| r->nboundarySegs < 0 || r->nboundarySegs > dtLocalBoundary::MAX_LOCAL_SEGS
+			|| r->queryFilterType >= DT_CROWD_MAX_QUERY_FILTER_TYPE
+			|| r->obstacleAvoidanceType >= DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS
+			|| !validNeighbours(r->neis, dtClamp(r->nneis, 0, DT_CROWDAGENT_MAX_NEIGHBOURS), m_maxAgents))
+		{
+			clearAgents();
+			return DT_FAILURE | DT_INVALID_PARAM;
+		}
+
+		const int pathSize = dtAlign4(sizeof(dtPolyRef)*r->npath);
+		const int polysSize = dtAlign4(sizeof(dtPolyRef)*r->nboundaryPolys);
+		const int segsSize = dtAlign4(sizeof(float)*6*r->nboundarySegs);
+		if (end - data < pathSize + polysSize + segsSize)
+		{
+			clearAgents();
+			return DT_FAILURE | DT_INVALID_PARAM;
+		}
+
+		const dtPolyRef* path = dtGetThenAdvanceBufferPointer<const dtPolyRef>(data, pathSize);
+		const dtPolyRef* polys = dtGetThenAdvanceBufferPointer<const dtPolyRef>(data, polysSize);
+		const float* segs = dtGetThenAdvanceBufferPointer<const float>(data, segsSize);
+
+		dtCrowdAgent* ag = &m_agents[r->idx];
+		dtCrowdAgentAnimation* anim = &m_agentAnims[r->idx];
+
+		ag->params.radius = r->radius;
+		ag->params.height = r->height;
+		ag->params.maxAcceleration = r->maxAcceleration;
+		ag->params.maxSpeed = r->maxSpeed;
+		ag->params.collisionQueryRange = r->collisionQueryRange;
+		ag->params.pathOptimizationRange = r->pathOptimizationRange;
+		ag->params.separationWeight = r->separationWeight;
+		ag->params.updateFlags = r->updateFlags;
+		ag->params.obstacleAvoidanceType = r->obstacleAvoidanceType;
+		ag->params.queryFilterType = r->queryFilterType;
+		ag->params.userData = 0;
+
+		ag->corridor.reset(path[0], r->corridorPos);
+		ag->corridor.setCorridor(r->corridorTarget, path, r->npath);
+		ag->boundary.set(r->boundaryCenter, segs, r->nboundarySegs, polys, r->nboundaryPolys);
+
+		ag->state = r->state;
+		ag->partial = r->partial != 0;
+		ag->targetState = r->targetState;
+		ag->nneis = dtClamp(r->nneis, 0, DT_CROWDAGENT_MAX_NEIGHBOURS);
+		memcpy(ag->neis, r->neis, sizeof(ag->neis));
+		ag->desiredSpeed = r->desiredSpeed;
+		dtVcopy(ag->npos, r->npos);
+		dtVset(ag->disp, 0,0,0);
+		dtVcopy(ag->dvel, r->dvel);
+		dtVcopy(ag->nvel, r->nvel);
+		dtVcopy(ag->vel, r->vel);
+		ag->topologyOptTime = r->topologyOptTime;
+		memcpy(ag->cornerVerts, r->cornerVerts, sizeof(ag->cornerVerts));
+		memcpy(ag->cornerFlags, r->cornerFlags, sizeof(ag->cornerFlags));
+		memcpy(ag->cornerPolys, r->cornerPolys, sizeof(ag->cornerPolys));
+		ag->ncorners = dtClamp(r->ncorners, 0, DT_CROWDAGENT_MAX_CORNERS);
+		ag->targetRef = r->targetRef;
+		dtVcopy(ag->targetPos, r->targetPos);
+		ag->targetPathqRef = r->targetPathqRef;
+		ag->targetReplan = r->targetReplan != 0;
+		ag->targetFlowField = r->targetFlowField != 0;
+		ag->targetReplanTime = r->targetReplanTime;
+		ag->pathPriority = r->pathPriority;
+		ag->targetPriority = r->targetPriority;
+		ag->lod = r->lod;
+		ag->lodOverride = r->lodOverride;
+		ag->lodTime = r->lodTime;
+		ag->active = true;
+
+		anim->active = r->animActive != 0;
+		dtVcopy(anim->initPos, r->animInitPos);
+		dtVcopy(anim->startPos, r->animStartPos);
+		dtVcopy(anim->endPos, r->animEndPos);
+		anim->polyRef = r->animRef;
+		anim->t = r->animT;
+		anim->tmax = r->animTmax;
+
+		m_activeAgentIndex[r->idx] = m_numActiveAgents;
+		m_activeAgents[m_numActiveAgents++] = ag;
+	}
+
+	// The free indices must be exactly the inactive agents.  A visited index is marked
+	// with an active index of -2 until the check is complete.
+	bool valid = true;
+	for (int i = 0; i < freeCount && valid; ++i)
+	{
+		const int idx = freeAgents[i];
+		if (idx < 0 || idx >= m_maxAgents || m_activeAgentIndex[idx] != -1)
+			valid = false;
+		else
+			m_activeAgentIndex[idx] = -2;
+	}
+	for (int i = 0; i < m_maxAgents; ++i)
+	{
+		if (m_activeAgentIndex[i] == -2)
+			m_activeAgentIndex[i] = -1;
+	}
+	if (!valid || end - data < state->pathQueueSize)
+	{
+		clearAgents();
+		return DT_FAILURE | DT_INVALID_PARAM;
+	}
+	memcpy(m_freeAgents, freeAgents, sizeof(int)*freeCount);
+	m_numFreeAgents = freeCount;
+
+	dtStatus status = m_pathq.restoreState(data, state->pathQueueSize, m_filters, DT_CROWD_MAX_QUERY_FILTER_TYPE);
+	if (dtStatusFailed(status))
+	{
+		clearAgents();
+		return status;
+	}
+
+	return DT_SUCCESS;
+}
 
 void dtCrowd::updateMoveRequest(const float /*dt*/)
 {
-	const int PATH_MAX_AGENTS = 8;
-	dtCrowdAgent* queue[PATH_MAX_AGENTS];
+	const int maxQueue = m_pathq.getMaxQueue();
+	dtCrowdAgent** queue = m_pathqCandidates;
 	int nqueue = 0;
 	
 	// Fire off new requests.
-	for (int i = 0; i < m_maxAgents; ++i)
+	for (int i = 0; i < m_numActiveAgents; ++i)
 	{
-		dtCrowdAgent* ag = &m_agents[i];
-		if (!ag->active)
-			continue;
+		dtCrowdAgent* ag = m_activeAgents[i];
 		if (ag->state == DT_CROWDAGENT_STATE_INVALID)
 			continue;
 		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
 			continue;
 
+		if (ag->targetState == DT_CROWDAGENT_TARGET_REQUESTING && ag->targetFlowField)
+		{
+			if (requestFlowFieldPath(ag))
+				continue;
+		}
+
 		if (ag->targetState == DT_CROWDAGENT_TARGET_REQUESTING)
 		{
 			const dtPolyRef* path = ag->corridor.getPath();
@@ -765,7 +1544,10 @@ void dtCrowd::updateMoveRequest(const float /*dt*/)
 		
 		if (ag->targetState == DT_CROWDAGENT_TARGET_WAITING_FOR_QUEUE)
 		{
-			nqueue = addToPathQueue(ag, queue, nqueue, PATH_MAX_AGENTS);
+			ag->targetPriority = ag->pathPriority;
+			if (m_pathPriorityWeight > 0)
+				ag->targetPriority -= dtVdist(ag->npos, m_pathPriorityCenter) * m_pathPriorityWeight;
+			nqueue = addToPathQueue(ag, queue, nqueue, maxQueue);
 		}
 	}
 
@@ -773,23 +1555,22 @@ void dtCrowd::updateMoveRequest(const float /*dt*/)
 	{
 		dtCrowdAgent* ag = queue[i];
 		ag->targetPathqRef = m_pathq.request(ag->corridor.getLastPoly(), ag->targetRef,
-											 ag->corridor.getTarget(), ag->targetPos, &m_filters[ag->params.queryFilterType]);
+											 ag->corridor.getTarget(), ag->targetPos, &m_filters[ag->params.queryFilterType],
+											 ag->targetPriority);
 		if (ag->targetPathqRef != DT_PATHQ_INVALID)
 			ag->targetState = DT_CROWDAGENT_TARGET_WAITING_FOR_PATH;
 	}
 
 	
 	// Update requests.
-	m_pathq.update(MAX_ITERS_PER_UPDATE);
+	m_pathq.update(m_pathqMaxIters, m_pathqMaxTime);
 
 	dtStatus status;
 
 	// Process path results.
-	for (int i = 0; i < m_maxAgents; ++i)
+	for (int i = 0; i < m_numActiveAgents; ++i)
 	{
-		dtCrowdAgent* ag = &m_agents[i];
-		if (!ag->active)
-			continue;
+		dtCrowdAgent* ag = m_activeAgents[i];
 		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
 			continue;
 		
@@ -924,6 +1705,8 @@ void dtCrowd::updateTopologyOptimization(dtCrowdAgent** agents, const int nagent
 			continue;
 		if ((ag->params.updateFlags & DT_CROWD_OPTIMIZE_TOPO) == 0)
 			continue;
+		if (ag->lod == DT_CROWDAGENT_LOD_SIMPLE)
+			continue;
 		ag->topologyOptTime += dt;
 		if (ag->topologyOptTime >= OPT_TIME_THR)
 			nqueue = addToOptQueue(ag, queue, nqueue, OPT_MAX_AGENTS);
@@ -938,6 +1721,57 @@ void dtCrowd::updateTopologyOptimization(dtCrowdAgent** agents, const int nagent
 
 }
 
+// Chooses the level of detail of each agent, and collects the agents that are
+// stepped this tick.  The time since each agent was last stepped is kept in
+// dtCrowdAgent::lodTime.
+int dtCrowd::updateLod(dtCrowdAgent** agents, const int nagents, const float dt)
+{
+	const float reducedRangeSqr = m_lodParams.reducedRange < FLT_MAX ? dtSqr(m_lodParams.reducedRange) : FLT_MAX;
+	const float simpleRangeSqr = m_lodParams.simpleRange < FLT_MAX ? dtSqr(m_lodParams.simpleRange) : FLT_MAX;
+	const unsigned int tick = m_lodTick++;
+	
+	int nstep = 0;
+	for (int i = 0; i < nagents; ++i)
+	{
+		dtCrowdAgent* ag = agents[i];
+		
+		unsigned char lod = ag->lodOverride;
+		if (lod == DT_CROWDAGENT_LOD_AUTO)
+		{
+			lod = DT_CROWDAGENT_LOD_FULL;
+			if (m_nlodObservers)
+			{
+				float distSqr = FLT_MAX;
+				for (int j = 0; j < m_nlodObservers; ++j)
+					distSqr = dtMin(distSqr, dtVdist2DSqr(ag->npos, &m_lodObservers[j*3]));
+				if (distSqr > simpleRangeSqr)
+					lod = DT_CROWDAGENT_LOD_SIMPLE;
+				else if (distSqr > reducedRangeSqr)
+					lod = DT_CROWDAGENT_LOD_REDUCED;
+			}
+		}
+		ag->lod = lod;
+
+		// Off-mesh animations are updated every tick, don't count that time twice.
+		if (ag->state == DT_CROWDAGENT_STATE_WALKING)
+			ag->lodTime += dt;
+		else
+			ag->lodTime = 0;
+		
+		int interval = 1;
+		if (lod == DT_CROWDAGENT_LOD_REDUCED)
+			interval = m_lodParams.reducedInterval;
+		else if (lod == DT_CROWDAGENT_LOD_SIMPLE)
+			interval = m_lodParams.simpleInterval;
+		
+		// Stagger the steps by agent index.
+		if (interval <= 1 || (tick + (unsigned int)getAgentIndex(ag)) % (unsigned int)interval == 0)
+			m_stepAgents[nstep++] = ag;
+	}
+	
+	return nstep;
+}
+
 void dtCrowd::checkPathValidity(dtCrowdAgent** agents, const int nagents, const float dt)
 {
 	static const int CHECK_LOOKAHEAD = 10;
@@ -954,12 +1788,18 @@ void dtCrowd::checkPathValidity(dtCrowdAgent** agents, const int nagents, const
 
 		bool replan = false;
 
-		// First check that the current location is valid.
+		// Check the nearby corridor.  Only the polygons in tiles that changed since the
+		// last check are looked at, so this is nearly free while the mesh is static.
+		const dtQueryFilter* filter = &m_filters[ag->params.queryFilterType];
+		const bool corridorValid = ag->corridor.isValidIncremental(CHECK_LOOKAHEAD, m_navquery, filter);
+
+		// First check that the current location is valid.  A valid corridor starts
+		// at the current location.
 		const int idx = getAgentIndex(ag);
 		float agentPos[3];
 		dtPolyRef agentRef = ag->corridor.getFirstPoly();
 		dtVcopy(agentPos, ag->npos);
-		if (!m_navquery->isValidPolyRef(agentRef, &m_filters[ag->params.queryFilterType]))
+		if (!(corridorValid && agentRef) && !m_navquery->isValidPolyRef(agentRef, filter))
 		{
 			// Current location is not valid, try to reposition.
 			// TODO: this can snap agents, how to handle that?
@@ -1016,7 +1856,7 @@ void dtCrowd::checkPathValidity(dtCrowdAgent** agents, const int nagents, const
 		}
 
 		// If nearby corridor is not valid, replan.
-		if (!ag->corridor.isValid(CHECK_LOOKAHEAD, m_navquery, &m_filters[ag->params.queryFilterType]))
+		if (!corridorValid)
 		{
 			// Fix current path.
 //			ag->corridor.trimInvalidPath(agentRef, agentPos, m_navquery, &m_filter);
@@ -1044,81 +1884,87 @@ void dtCrowd::checkPathValidity(dtCrowdAgent** agents, const int nagents, const
 	}
 }
 	
-void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
+struct dtCrowdUpdateContext
 {
-	m_velocitySampleCount = 0;
-	
-	const int debugIdx = debug ? debug->idx : -1;
-	
-	dtCrowdAgent** agents = m_activeAgents;
-	int nagents = getActiveAgents(agents, m_maxAgents);
-
-	// Check that all agents still have valid paths.
-	checkPathValidity(agents, nagents, dt);
-	
-	// Update async move request and path finder.
-	updateMoveRequest(dt);
-
-	// Optimize path topology.
-	updateTopologyOptimization(agents, nagents, dt);
-	
-	// Register agents to proximity grid.
-	m_grid->clear();
-	for (int i = 0; i < nagents; ++i)
-	{
-		dtCrowdAgent* ag = agents[i];
-		const float* p = ag->npos;
-		const float r = ag->params.radius;
-		m_grid->addItem((unsigned short)i, p[0]-r, p[2]-r, p[0]+r, p[2]+r);
-	}
-	
-	// Get nearby navmesh segments and agents to collide with.
-	for (int i = 0; i < nagents; ++i)
+	dtCrowd* crowd;
+	dtCrowdAgent** agents;			///< The agents stepped this tick.
+	int nagents;
+	dtCrowdAgent** gridAgents;		///< All active agents, indexed by the proximity grid ids.
+	int ngridAgents;
+	dtCrowdAgentDebugInfo* debug;
+	const dtCrowdAgent* debugAgent;
+};
+
+// The per-agent phases of dtCrowd::update().  Each task only writes to the state
+// of its own agent, and only reads the state other agents had before the phase 
+// started, so the phases can run in parallel.
+struct dtCrowdUpdateTasks
+{
+	static void updateNeighbours(void* userData, int i, int worker)
 	{
-		dtCrowdAgent* ag = agents[i];
+		const dtCrowdUpdateContext* ctx = (const dtCrowdUpdateContext*)userData;
+		dtCrowd* crowd = ctx->crowd;
+		dtCrowdAgent* ag = ctx->agents[i];
 		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
+			return;
+
+		// Simple agents don't avoid anything.
+		if (ag->lod == DT_CROWDAGENT_LOD_SIMPLE)
+		{
+			ag->boundary.reset();
+			ag->nneis = 0;
+			return;
+		}
+
+		dtNavMeshQuery* navquery = crowd->m_workerQueries[worker];
+		const dtQueryFilter* filter = &crowd->m_filters[ag->params.queryFilterType];
 
 		// Update the collision boundary after certain distance has been passed or
 		// if it has become invalid.
 		const float updateThr = ag->params.collisionQueryRange*0.25f;
 		if (dtVdist2DSqr(ag->npos, ag->boundary.getCenter()) > dtSqr(updateThr) ||
-			!ag->boundary.isValid(m_navquery, &m_filters[ag->params.queryFilterType]))
+			!ag->boundary.isValid(navquery, filter))
 		{
 			ag->boundary.update(ag->corridor.getFirstPoly(), ag->npos, ag->params.collisionQueryRange,
-								m_navquery, &m_filters[ag->params.queryFilterType]);
+								navquery, filter, crowd->m_walls);
 		}
 		// Query neighbour agents
 		ag->nneis = getNeighbours(ag->npos, ag->params.height, ag->params.collisionQueryRange,
 								  ag, ag->neis, DT_CROWDAGENT_MAX_NEIGHBOURS,
-								  agents, nagents, m_grid);
+								  ctx->gridAgents, ctx->ngridAgents, crowd->m_grid);
 		for (int j = 0; j < ag->nneis; j++)
-			ag->neis[j].idx = getAgentIndex(agents[ag->neis[j].idx]);
+			ag->neis[j].idx = crowd->getAgentIndex(ctx->gridAgents[ag->neis[j].idx]);
 	}
-	
-	// Find next corner to steer to.
-	for (int i = 0; i < nagents; ++i)
+
+	static void findCorners(void* userData, int i, int worker)
 	{
-		dtCrowdAgent* ag = agents[i];
+		const dtCrowdUpdateContext* ctx = (const dtCrowdUpdateContext*)userData;
+		dtCrowd* crowd = ctx->crowd;
+		dtCrowdAgent* ag = ctx->agents[i];
 		
 		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
+			return;
 		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
-			continue;
+			return;
+
+		dtNavMeshQuery* navquery = crowd->m_workerQueries[worker];
+		const dtQueryFilter* filter = &crowd->m_filters[ag->params.queryFilterType];
+		dtCrowdAgentDebugInfo* debug = ctx->debug;
 		
 		// Find corners for steering
 		ag->ncorners = ag->corridor.findCorners(ag->cornerVerts, ag->cornerFlags, ag->cornerPolys,
-												DT_CROWDAGENT_MAX_CORNERS, m_navquery, &m_filters[ag->params.queryFilterType]);
+												DT_CROWDAGENT_MAX_CORNERS, navquery, filter);
 		
 		// Check to see if the corner after the next corner is directly visible,
 		// and short cut to there.
-		if ((ag->params.updateFlags & DT_CROWD_OPTIMIZE_VIS) && ag->ncorners > 0)
+		if ((ag->params.updateFlags & DT_CROWD_OPTIMIZE_VIS) && ag->ncorners > 0 &&
+			ag->lod != DT_CROWDAGENT_LOD_SIMPLE)
 		{
 			const float* target = &ag->cornerVerts[dtMin(1,ag->ncorners-1)*3];
-			ag->corridor.optimizePathVisibility(target, ag->params.pathOptimizationRange, m_navquery, &m_filters[ag->params.queryFilterType]);
+			ag->corridor.optimizePathVisibility(target, ag->params.pathOptimizationRange, navquery, filter);
 			
 			// Copy data for debug purposes.
-			if (debugIdx == i)
+			if (ctx->debugAgent == ag)
 			{
 				dtVcopy(debug->optStart, ag->corridor.getPos());
 				dtVcopy(debug->optEnd, target);
@@ -1127,64 +1973,24 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 		else
 		{
 			// Copy data for debug purposes.
-			if (debugIdx == i)
+			if (ctx->debugAgent == ag)
 			{
 				dtVset(debug->optStart, 0,0,0);
 				dtVset(debug->optEnd, 0,0,0);
 			}
 		}
 	}
-	
-	// Trigger off-mesh connections (depends on corners).
-	for (int i = 0; i < nagents; ++i)
-	{
-		dtCrowdAgent* ag = agents[i];
-		
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
-		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
-			continue;
-		
-		// Check 
-		const float triggerRadius = ag->params.radius*2.25f;
-		if (overOffmeshConnection(ag, triggerRadius))
-		{
-			// Prepare to off-mesh connection.
-			const int idx = (int)(ag - m_agents);
-			dtCrowdAgentAnimation* anim = &m_agentAnims[idx];
-			
-			// Adjust the path over the off-mesh connection.
-			dtPolyRef refs[2];
-			if (ag->corridor.moveOverOffmeshConnection(ag->cornerPolys[ag->ncorners-1], refs,
-													   anim->startPos, anim->endPos, m_navquery))
-			{
-				dtVcopy(anim->initPos, ag->npos);
-				anim->polyRef = refs[1];
-				anim->active = true;
-				anim->t = 0.0f;
-				anim->tmax = (dtVdist2D(anim->startPos, anim->endPos) / ag->params.maxSpeed) * 0.5f;
-				
-				ag->state = DT_CROWDAGENT_STATE_OFFMESH;
-				ag->ncorners = 0;
-				ag->nneis = 0;
-				continue;
-			}
-			else
-			{
-				// Path validity check will ensure that bad/blocked connections will be replanned.
-			}
-		}
-	}
-		
-	// Calculate steering.
-	for (int i = 0; i < nagents; ++i)
+
+	static void calcSteering(void* userData, int i, int /*worker*/)
 	{
-		dtCrowdAgent* ag = agents[i];
+		const dtCrowdUpdateContext* ctx = (const dtCrowdUpdateContext*)userData;
+		dtCrowd* crowd = ctx->crowd;
+		dtCrowdAgent* ag = ctx->agents[i];
 
 		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
+			return;
 		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE)
-			continue;
+			return;
 		
 		float dvel[3] = {0,0,0};
 
@@ -1221,7 +2027,7 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 			
 			for (int j = 0; j < ag->nneis; ++j)
 			{
-				const dtCrowdAgent* nei = &m_agents[ag->neis[j].idx];
+				const dtCrowdAgent* nei = &crowd->m_agents[ag->neis[j].idx];
 				
 				float diff[3];
 				dtVsub(diff, ag->npos, nei->npos);
@@ -1254,24 +2060,26 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 		// Set the desired velocity.
 		dtVcopy(ag->dvel, dvel);
 	}
-	
-	// Velocity planning.	
-	for (int i = 0; i < nagents; ++i)
+
+	static void planVelocity(void* userData, int i, int worker)
 	{
-		dtCrowdAgent* ag = agents[i];
+		const dtCrowdUpdateContext* ctx = (const dtCrowdUpdateContext*)userData;
+		dtCrowd* crowd = ctx->crowd;
+		dtCrowdAgent* ag = ctx->agents[i];
 		
 		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
+			return;
 		
-		if (ag->params.updateFlags & DT_CROWD_OBSTACLE_AVOIDANCE)
+		if ((ag->params.updateFlags & DT_CROWD_OBSTACLE_AVOIDANCE) && ag->lod != DT_CROWDAGENT_LOD_SIMPLE)
 		{
-			m_obstacleQuery->reset();
+			dtObstacleAvoidanceQuery* obstacleQuery = crowd->m_workerObstacleQueries[worker];
+			obstacleQuery->reset();
 			
 			// Add neighbours as obstacles.
 			for (int j = 0; j < ag->nneis; ++j)
 			{
-				const dtCrowdAgent* nei = &m_agents[ag->neis[j].idx];
-				m_obstacleQuery->addCircle(nei->npos, nei->params.radius, nei->vel, nei->dvel);
+				const dtCrowdAgent* nei = &crowd->m_agents[ag->neis[j].idx];
+				obstacleQuery->addCircle(nei->npos, nei->params.radius, nei->vel, nei->dvel);
 			}
 
 			// Append neighbour segments as obstacles.
@@ -1280,30 +2088,31 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 				const float* s = ag->boundary.getSegment(j);
 				if (dtTriArea2D(ag->npos, s, s+3) < 0.0f)
 					continue;
-				m_obstacleQuery->addSegment(s, s+3);
+				obstacleQuery->addSegment(s, s+3);
 			}
 
 			dtObstacleAvoidanceDebugData* vod = 0;
-			if (debugIdx == i) 
-				vod = debug->vod;
+			if (ctx->debugAgent == ag) 
+				vod = ctx->debug->vod;
 			
 			// Sample new safe velocity.
 			bool adaptive = true;
 			int ns = 0;
 
-			const dtObstacleAvoidanceParams* params = &m_obstacleQueryParams[ag->params.obstacleAvoidanceType];
+			const dtObstacleAvoidanceParams* params = 
+				&crowd->m_obstacleQueryParams[ag->params.obstacleAvoidanceType];
 				
 			if (adaptive)
 			{
-				ns = m_obstacleQuery->sampleVelocityAdaptive(ag->npos, ag->params.radius, ag->desiredSpeed,
-															 ag->vel, ag->dvel, ag->nvel, params, vod);
+				ns = obstacleQuery->sampleVelocityAdaptive(ag->npos, ag->params.radius, ag->desiredSpeed,
+														   ag->vel, ag->dvel, ag->nvel, params, vod);
 			}
 			else
 			{
-				ns = m_obstacleQuery->sampleVelocityGrid(ag->npos, ag->params.radius, ag->desiredSpeed,
-														 ag->vel, ag->dvel, ag->nvel, params, vod);
+				ns = obstacleQuery->sampleVelocityGrid(ag->npos, ag->params.radius, ag->desiredSpeed,
+													   ag->vel, ag->dvel, ag->nvel, params, vod);
 			}
-			m_velocitySampleCount += ns;
+			crowd->m_workerSampleCounts[worker] += ns;
 		}
 		else
 		{
@@ -1312,90 +2121,92 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 		}
 	}
 
-	// Integrate.
-	for (int i = 0; i < nagents; ++i)
+	static void integrateAgent(void* userData, int i, int /*worker*/)
 	{
-		dtCrowdAgent* ag = agents[i];
+		const dtCrowdUpdateContext* ctx = (const dtCrowdUpdateContext*)userData;
+		dtCrowdAgent* ag = ctx->agents[i];
 		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
-		integrate(ag, dt);
+			return;
+		integrate(ag, ag->lodTime);
 	}
-	
-	// Handle collisions.
-	static const float COLLISION_RESOLVE_FACTOR = 0.7f;
-	
-	for (int iter = 0; iter < 4; ++iter)
+
+	static void calcCollisionDisplacement(void* userData, int i, int /*worker*/)
 	{
-		for (int i = 0; i < nagents; ++i)
+		static const float COLLISION_RESOLVE_FACTOR = 0.7f;
+
+		const dtCrowdUpdateContext* ctx = (const dtCrowdUpdateContext*)userData;
+		const dtCrowd* crowd = ctx->crowd;
+		dtCrowdAgent* ag = ctx->agents[i];
+		const int idx0 = crowd->getAgentIndex(ag);
+		
+		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+			return;
+
+		dtVset(ag->disp, 0,0,0);
+		
+		float w = 0;
+
+		for (int j = 0; j < ag->nneis; ++j)
 		{
-			dtCrowdAgent* ag = agents[i];
-			const int idx0 = getAgentIndex(ag);
-			
-			if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-				continue;
+			const dtCrowdAgent* nei = &crowd->m_agents[ag->neis[j].idx];
+			const int idx1 = crowd->getAgentIndex(nei);
 
-			dtVset(ag->disp, 0,0,0);
+			float diff[3];
+			dtVsub(diff, ag->npos, nei->npos);
+			diff[1] = 0;
 			
-			float w = 0;
-
-			for (int j = 0; j < ag->nneis; ++j)
+			float dist = dtVlenSqr(diff);
+			if (dist > dtSqr(ag->params.radius + nei->params.radius))
+				continue;
+			dist = dtMathSqrtf(dist);
+			float pen = (ag->params.radius + nei->params.radius) - dist;
+			if (dist < 0.0001f)
 			{
-				const dtCrowdAgent* nei = &m_agents[ag->neis[j].idx];
-				const int idx1 = getAgentIndex(nei);
-
-				float diff[3];
-				dtVsub(diff, ag->npos, nei->npos);
-				diff[1] = 0;
-				
-				float dist = dtVlenSqr(diff);
-				if (dist > dtSqr(ag->params.radius + nei->params.radius))
-					continue;
-				dist = dtMathSqrtf(dist);
-				float pen = (ag->params.radius + nei->params.radius) - dist;
-				if (dist < 0.0001f)
-				{
-					// Agents on top of each other, try to choose diverging separation directions.
-					if (idx0 > idx1)
-						dtVset(diff, -ag->dvel[2],0,ag->dvel[0]);
-					else
-						dtVset(diff, ag->dvel[2],0,-ag->dvel[0]);
-					pen = 0.01f;
-				}
+				// Agents on top of each other, try to choose diverging separation directions.
+				if (idx0 > idx1)
+					dtVset(diff, -ag->dvel[2],0,ag->dvel[0]);
 				else
-				{
-					pen = (1.0f/dist) * (pen*0.5f) * COLLISION_RESOLVE_FACTOR;
-				}
-				
-				dtVmad(ag->disp, ag->disp, diff, pen);			
-				
-				w += 1.0f;
+					dtVset(diff, ag->dvel[2],0,-ag->dvel[0]);
+				pen = 0.01f;
 			}
-			
-			if (w > 0.0001f)
+			else
 			{
-				const float iw = 1.0f / w;
-				dtVscale(ag->disp, ag->disp, iw);
+				pen = (1.0f/dist) * (pen*0.5f) * COLLISION_RESOLVE_FACTOR;
 			}
+			
+			dtVmad(ag->disp, ag->disp, diff, pen);			
+			
+			w += 1.0f;
 		}
 		
-		for (int i = 0; i < nagents; ++i)
+		if (w > 0.0001f)
 		{
-			dtCrowdAgent* ag = agents[i];
-			if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-				continue;
-			
-			dtVadd(ag->npos, ag->npos, ag->disp);
+			const float iw = 1.0f / w;
+			dtVscale(ag->disp, ag->disp, iw);
 		}
 	}
-	
-	for (int i = 0; i < nagents; ++i)
+
+	static void applyCollisionDisplacement(void* userData, int i, int /*worker*/)
 	{
-		dtCrowdAgent* ag = agents[i];
+		const dtCrowdUpdateContext* ctx = (const dtCrowdUpdateContext*)userData;
+		dtCrowdAgent* ag = ctx->agents[i];
 		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
+			return;
+		
+		dtVadd(ag->npos, ag->npos, ag->disp);
+	}
+
+	static void movePosition(void* userData, int i, int worker)
+	{
+		const dtCrowdUpdateContext* ctx = (const dtCrowdUpdateContext*)userData;
+		dtCrowd* crowd = ctx->crowd;
+		dtCrowdAgent* ag = ctx->agents[i];
+		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+			return;
 		
 		// Move along navmesh.
-		ag->corridor.movePosition(ag->npos, m_navquery, &m_filters[ag->params.queryFilterType]);
+		ag->corridor.movePosition(ag->npos, crowd->m_workerQueries[worker], 
+								  &crowd->m_filters[ag->params.queryFilterType]);
 		// Get valid constrained position back.
 		dtVcopy(ag->npos, ag->corridor.getPos());
 
@@ -1405,16 +2216,145 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 			ag->corridor.reset(ag->corridor.getFirstPoly(), ag->npos);
 			ag->partial = false;
 		}
+	}
+};
+
+/// @par
+///
+/// If a task scheduler is set, the per-agent phases (boundary and neighbour
+/// queries, corners, steering, velocity planning, integration, collision 
+/// and navigation mesh movement) run in parallel. (See #setTaskScheduler)
+///
+/// If concurrent reads are enabled on the navigation mesh and it has no free reader
+/// slot for the crowd, the update is skipped. (See: dtNavMesh::initConcurrentReads)
+void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
+{
+	// One read covers the queries of the update, including those of the workers.
+	if (dtStatusFailed(m_navquery->beginRead()))
+		return;
+
+	m_velocitySampleCount = 0;
+	
+	const int debugIdx = debug ? debug->idx : -1;
+	
+	dtCrowdAgent** agents = m_activeAgents;
+	int nagents = m_numActiveAgents;
+
+	// Check that all agents still have valid paths.
+	checkPathValidity(agents, nagents, dt);
+	
+	// Update async move request and path finder.
+	updateMoveRequest(dt);
+
+	// Choose the level of detail, and the agents to step.
+	const int nstep = updateLod(agents, nagents, dt);
+	dtCrowdAgent** stepAgents = m_stepAgents;
+
+	// Optimize path topology.
+	updateTopologyOptimization(agents, nagents, dt);
+	
+	// Register agents to proximity grid.
+	m_grid->clear();
+	for (int i = 0; i < nagents; ++i)
+	{
+		dtCrowdAgent* ag = agents[i];
+		const float* p = ag->npos;
+		const float r = ag->params.radius;
+		m_grid->addItem((unsigned short)i, p[0]-r, p[2]-r, p[0]+r, p[2]+r);
+	}
+	m_grid->sortItems();
+
+	dtCrowdUpdateContext ctx;
+	ctx.crowd = this;
+	ctx.agents = stepAgents;
+	ctx.nagents = nstep;
+	ctx.gridAgents = agents;
+	ctx.ngridAgents = nagents;
+	ctx.debug = debug;
+	ctx.debugAgent = (debugIdx >= 0 && debugIdx < nagents) ? agents[debugIdx] : 0;
+	
+	// Get nearby navmesh segments and agents to collide with.
+	m_walls->update();
+	runAgentTasks(dtCrowdUpdateTasks::updateNeighbours, &ctx, nstep);
+	
+	// Find next corner to steer to.
+	runAgentTasks(dtCrowdUpdateTasks::findCorners, &ctx, nstep);
+	
+	// Trigger off-mesh connections (depends on corners).
+	for (int i = 0; i < nstep; ++i)
+	{
+		dtCrowdAgent* ag = stepAgents[i];
+		
+		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+			continue;
+		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
+			continue;
+		
+		// Check 
+		const float triggerRadius = ag->params.radius*2.25f;
+		if (overOffmeshConnection(ag, triggerRadius))
+		{
+			// Prepare to off-mesh connection.
+			const int idx = (int)(ag - m_agents);
+			dtCrowdAgentAnimation* anim = &m_agentAnims[idx];
+			
+			// Adjust the path over the off-mesh connection.
+			dtPolyRef refs[2];
+			if (ag->corridor.moveOverOffmeshConnection(ag->cornerPolys[ag->ncorners-1], refs,
+													   anim->startPos, anim->endPos, m_navquery))
+			{
+				dtVcopy(anim->initPos, ag->npos);
+				anim->polyRef = refs[1];
+				anim->active = true;
+				anim->t = 0.0f;
+				anim->tmax = (dtVdist2D(anim->startPos, anim->endPos) / ag->params.maxSpeed) * 0.5f;
+				
+				ag->state = DT_CROWDAGENT_STATE_OFFMESH;
+				ag->ncorners = 0;
+				ag->nneis = 0;
+				continue;
+			}
+			else
+			{
+				// Path validity check will ensure that bad/blocked connections will be replanned.
+			}
+		}
+	}
+		
+	// Calculate steering.
+	runAgentTasks(dtCrowdUpdateTasks::calcSteering, &ctx, nstep);
+	
+	// Velocity planning.	
+	for (int i = 0; i < m_workerCount; ++i)
+		m_workerSampleCounts[i] = 0;
 
+	runAgentTasks(dtCrowdUpdateTasks::planVelocity, &ctx, nstep);
+
+	for (int i = 0; i < m_workerCount; ++i)
+		m_velocitySampleCount += m_workerSampleCounts[i];
+
+	// Integrate.
+	runAgentTasks(dtCrowdUpdateTasks::integrateAgent, &ctx, nstep);
+	
+	// Handle collisions.
+	for (int iter = 0; iter < 4; ++iter)
+	{
+		runAgentTasks(dtCrowdUpdateTasks::calcCollisionDisplacement, &ctx, nstep);
+		runAgentTasks(dtCrowdUpdateTasks::applyCollisionDisplacement, &ctx, nstep);
 	}
 	
+	runAgentTasks(dtCrowdUpdateTasks::movePosition, &ctx, nstep);
+
+	for (int i = 0; i < nstep; ++i)
+		stepAgents[i]->lodTime = 0;
+	
 	// Update agents using off-mesh connection.
-	for (int i = 0; i < m_maxAgents; ++i)
+	for (int i = 0; i < nagents; ++i)
 	{
-		dtCrowdAgentAnimation* anim = &m_agentAnims[i];
+		dtCrowdAgent* ag = agents[i];
+		dtCrowdAgentAnimation* anim = &m_agentAnims[getAgentIndex(ag)];
 		if (!anim->active)
 			continue;
-		dtCrowdAgent* ag = agents[i];
 
 		anim->t += dt;
 		if (anim->t > anim->tmax)
@@ -1444,5 +2384,6 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 		dtVset(ag->vel, 0,0,0);
 		dtVset(ag->dvel, 0,0,0);
 	}
-	
+
+	m_navquery->endRead();
 }
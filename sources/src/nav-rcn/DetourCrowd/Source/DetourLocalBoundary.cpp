@@ -42,6 +42,22 @@ void dtLocalBoundary::reset()
 	m_nsegs = 0;
 }
 
+void dtLocalBoundary::set(const float* center, const float* segs, const int nsegs,
+						  const dtPolyRef* polys, const int npolys)
+{
+	dtVcopy(m_center, center);
+	
+	m_nsegs = dtMin(nsegs, MAX_LOCAL_SEGS);
+	for (int i = 0; i < m_nsegs; ++i)
+	{
+		memcpy(m_segs[i].s, &segs[i*6], sizeof(float)*6);
+		m_segs[i].d = 0;
+	}
+	
+	m_npolys = dtMin(npolys, MAX_LOCAL_POLYS);
+	memcpy(m_polys, polys, sizeof(dtPolyRef)*m_npolys);
+}
+
 void dtLocalBoundary::addSegment(const float dist, const float* s)
 {
 	// Insert neighbour based on the distance.
@@ -81,8 +97,13 @@ void dtLocalBoundary::addSegment(const float dist, const float* s)
 		m_nsegs++;
 }
 
+/// @par
+///
+/// If @p walls is provided, the wall segments are gathered from it, and only
+/// polygons it doesn't have up to date segments for are queried.
 void dtLocalBoundary::update(dtPolyRef ref, const float* pos, const float collisionQueryRange,
-							 dtNavMeshQuery* navquery, const dtQueryFilter* filter)
+							 dtNavMeshQuery* navquery, const dtQueryFilter* filter,
+							 const dtWallSegmentCache* walls)
 {
 	static const int MAX_SEGS_PER_POLY = DT_VERTS_PER_POLYGON*3;
 	
@@ -106,7 +127,8 @@ void dtLocalBoundary::update(dtPolyRef ref, const float* pos, const float collis
 	int nsegs = 0;
 	for (int j = 0; j < m_npolys; ++j)
 	{
-		navquery->getPolyWallSegments(m_polys[j], filter, segs, 0, &nsegs, MAX_SEGS_PER_POLY);
+		if (!walls || dtStatusFailed(walls->getPolyWallSegments(m_polys[j], filter, segs, &nsegs, MAX_SEGS_PER_POLY)))
+			navquery->getPolyWallSegments(m_polys[j], filter, segs, 0, &nsegs, MAX_SEGS_PER_POLY);
 		for (int k = 0; k < nsegs; ++k)
 		{
 			const float* s = &segs[k*6];
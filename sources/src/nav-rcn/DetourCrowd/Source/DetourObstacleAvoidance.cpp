@@ -67,11 +67,100 @@ static int isectRaySeg(const float* ap, const float* u,
 	return 1;
 }
 
+// Four lane helpers for the batched sampler.  SSE2 is part of every x86-64
+// target, and NEON with the divide and square root instructions is part of
+// every AArch64 target, so neither needs compiler flags or a runtime check.
+// Other targets score the batches with the scalar code.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DT_OBSTACLE_SIMD_SSE2
+#include <emmintrin.h>
+#elif (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+#define DT_OBSTACLE_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(DT_OBSTACLE_SIMD_SSE2)
+
+typedef __m128 dtSimdFloat;
+typedef __m128 dtSimdMask;
+
+inline dtSimdFloat dtSimdLoad(const float* p) { return _mm_loadu_ps(p); }
+inline void dtSimdStore(float* p, const dtSimdFloat a) { _mm_storeu_ps(p, a); }
+inline dtSimdFloat dtSimdSet(const float a) { return _mm_set1_ps(a); }
+inline dtSimdFloat dtSimdAdd(const dtSimdFloat a, const dtSimdFloat b) { return _mm_add_ps(a, b); }
+inline dtSimdFloat dtSimdSub(const dtSimdFloat a, const dtSimdFloat b) { return _mm_sub_ps(a, b); }
+inline dtSimdFloat dtSimdMul(const dtSimdFloat a, const dtSimdFloat b) { return _mm_mul_ps(a, b); }
+inline dtSimdFloat dtSimdDiv(const dtSimdFloat a, const dtSimdFloat b) { return _mm_div_ps(a, b); }
+inline dtSimdFloat dtSimdMin(const dtSimdFloat a, const dtSimdFloat b) { return _mm_min_ps(a, b); }
+inline dtSimdFloat dtSimdMax(const dtSimdFloat a, const dtSimdFloat b) { return _mm_max_ps(a, b); }
+inline dtSimdFloat dtSimdSqrt(const dtSimdFloat a) { return _mm_sqrt_ps(a); }
+inline dtSimdFloat dtSimdAbs(const dtSimdFloat a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+inline dtSimdMask dtSimdLess(const dtSimdFloat a, const dtSimdFloat b) { return _mm_cmplt_ps(a, b); }
+inline dtSimdMask dtSimdGreater(const dtSimdFloat a, const dtSimdFloat b) { return _mm_cmpgt_ps(a, b); }
+inline dtSimdMask dtSimdGreaterEqual(const dtSimdFloat a, const dtSimdFloat b) { return _mm_cmpge_ps(a, b); }
+inline dtSimdMask dtSimdLessEqual(const dtSimdFloat a, const dtSimdFloat b) { return _mm_cmple_ps(a, b); }
+inline dtSimdMask dtSimdAnd(const dtSimdMask a, const dtSimdMask b) { return _mm_and_ps(a, b); }
+inline dtSimdMask dtSimdOr(const dtSimdMask a, const dtSimdMask b) { return _mm_or_ps(a, b); }
+inline dtSimdFloat dtSimdSelect(const dtSimdMask m, const dtSimdFloat a, const dtSimdFloat b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+inline bool dtSimdAll(const dtSimdMask m) { return _mm_movemask_ps(m) == 0xf; }
+
+#elif defined(DT_OBSTACLE_SIMD_NEON)
+
+typedef float32x4_t dtSimdFloat;
+typedef uint32x4_t dtSimdMask;
+
+inline dtSimdFloat dtSimdLoad(const float* p) { return vld1q_f32(p); }
+inline void dtSimdStore(float* p, const dtSimdFloat a) { vst1q_f32(p, a); }
+inline dtSimdFloat dtSimdSet(const float a) { return vdupq_n_f32(a); }
+inline dtSimdFloat dtSimdAdd(const dtSimdFloat a, const dtSimdFloat b) { return vaddq_f32(a, b); }
+inline dtSimdFloat dtSimdSub(const dtSimdFloat a, const dtSimdFloat b) { return vsubq_f32(a, b); }
+inline dtSimdFloat dtSimdMul(const dtSimdFloat a, const dtSimdFloat b) { return vmulq_f32(a, b); }
+inline dtSimdFloat dtSimdDiv(const dtSimdFloat a, const dtSimdFloat b) { return vdivq_f32(a, b); }
+inline dtSimdFloat dtSimdMin(const dtSimdFloat a, const dtSimdFloat b) { return vminq_f32(a, b); }
+inline dtSimdFloat dtSimdMax(const dtSimdFloat a, const dtSimdFloat b) { return vmaxq_f32(a, b); }
+inline dtSimdFloat dtSimdSqrt(const dtSimdFloat a) { return vsqrtq_f32(a); }
+inline dtSimdFloat dtSimdAbs(const dtSimdFloat a) { return vabsq_f32(a); }
+inline dtSimdMask dtSimdLess(const dtSimdFloat a, const dtSimdFloat b) { return vcltq_f32(a, b); }
+inline dtSimdMask dtSimdGreater(const dtSimdFloat a, const dtSimdFloat b) { return vcgtq_f32(a, b); }
+inline dtSimdMask dtSimdGreaterEqual(const dtSimdFloat a, const dtSimdFloat b) { return vcgeq_f32(a, b); }
+inline dtSimdMask dtSimdLessEqual(const dtSimdFloat a, const dtSimdFloat b) { return vcleq_f32(a, b); }
+inline dtSimdMask dtSimdAnd(const dtSimdMask a, const dtSimdMask b) { return vandq_u32(a, b); }
+inline dtSimdMask dtSimdOr(const dtSimdMask a, const dtSimdMask b) { return vorrq_u32(a, b); }
+inline dtSimdFloat dtSimdSelect(const dtSimdMask m, const dtSimdFloat a, const dtSimdFloat b) { return vbslq_f32(m, a, b); }
+inline bool dtSimdAll(const dtSimdMask m) { return vminvq_u32(m) != 0; }
+
+#endif
+
+// Field offsets of the batched sampler data, in units of the obstacle capacity.
+enum dtBatchCircleField
+{
+	DT_BATCH_CIRCLE_SX,		// Obstacle position relative to the agent.
+	DT_BATCH_CIRCLE_SZ,
+	DT_BATCH_CIRCLE_C,		// Squared distance minus the squared combined radius.
+	DT_BATCH_CIRCLE_WX,		// Agent velocity plus obstacle velocity.
+	DT_BATCH_CIRCLE_WZ,
+	DT_BATCH_CIRCLE_DPX,
+	DT_BATCH_CIRCLE_DPZ,
+	DT_BATCH_CIRCLE_NPX,
+	DT_BATCH_CIRCLE_NPZ,
+	DT_BATCH_CIRCLE_FIELDS
+};
+
+enum dtBatchSegmentField
+{
+	DT_BATCH_SEG_VX,		// Segment direction.
+	DT_BATCH_SEG_VZ,
+	DT_BATCH_SEG_WX,		// Agent position relative to the segment start.
+	DT_BATCH_SEG_WZ,
+	DT_BATCH_SEG_TNUM,		// Numerator of the hit time along the ray.
+	DT_BATCH_SEG_FIELDS
+};
+
 
 
 dtObstacleAvoidanceDebugData* dtAllocObstacleAvoidanceDebugData()
 {
-	void* mem = dtAlloc(sizeof(dtObstacleAvoidanceDebugData), DT_ALLOC_PERM);
+	void* mem = dtAlloc(sizeof(dtObstacleAvoidanceDebugData), DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
 	if (!mem) return 0;
 	return new(mem) dtObstacleAvoidanceDebugData;
 }
@@ -113,25 +202,25 @@ bool dtObstacleAvoidanceDebugData::init(const int maxSamples)
 	dtAssert(maxSamples);
 	m_maxSamples = maxSamples;
 
-	m_vel = (float*)dtAlloc(sizeof(float)*3*m_maxSamples, DT_ALLOC_PERM);
+	m_vel = (float*)dtAlloc(sizeof(float)*3*m_maxSamples, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
 	if (!m_vel)
 		return false;
-	m_pen = (float*)dtAlloc(sizeof(float)*m_maxSamples, DT_ALLOC_PERM);
+	m_pen = (float*)dtAlloc(sizeof(float)*m_maxSamples, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
 	if (!m_pen)
 		return false;
-	m_ssize = (float*)dtAlloc(sizeof(float)*m_maxSamples, DT_ALLOC_PERM);
+	m_ssize = (float*)dtAlloc(sizeof(float)*m_maxSamples, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
 	if (!m_ssize)
 		return false;
-	m_vpen = (float*)dtAlloc(sizeof(float)*m_maxSamples, DT_ALLOC_PERM);
+	m_vpen = (float*)dtAlloc(sizeof(float)*m_maxSamples, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
 	if (!m_vpen)
 		return false;
-	m_vcpen = (float*)dtAlloc(sizeof(float)*m_maxSamples, DT_ALLOC_PERM);
+	m_vcpen = (float*)dtAlloc(sizeof(float)*m_maxSamples, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
 	if (!m_vcpen)
 		return false;
-	m_spen = (float*)dtAlloc(sizeof(float)*m_maxSamples, DT_ALLOC_PERM);
+	m_spen = (float*)dtAlloc(sizeof(float)*m_maxSamples, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
 	if (!m_spen)
 		return false;
-	m_tpen = (float*)dtAlloc(sizeof(float)*m_maxSamples, DT_ALLOC_PERM);
+	m_tpen = (float*)dtAlloc(sizeof(float)*m_maxSamples, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
 	if (!m_tpen)
 		return false;
 	
@@ -193,7 +282,7 @@ void dtObstacleAvoidanceDebugData::normalizeSamples()
 
 dtObstacleAvoidanceQuery* dtAllocObstacleAvoidanceQuery()
 {
-	void* mem = dtAlloc(sizeof(dtObstacleAvoidanceQuery), DT_ALLOC_PERM);
+	void* mem = dtAlloc(sizeof(dtObstacleAvoidanceQuery), DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
 	if (!mem) return 0;
 	return new(mem) dtObstacleAvoidanceQuery;
 }
@@ -215,7 +304,9 @@ dtObstacleAvoidanceQuery::dtObstacleAvoidanceQuery() :
 	m_ncircles(0),
 	m_maxSegments(0),
 	m_segments(0),
-	m_nsegments(0)
+	m_nsegments(0),
+	m_batchCircles(0),
+	m_batchSegments(0)
 {
 }
 
@@ -223,23 +314,41 @@ dtObstacleAvoidanceQuery::~dtObstacleAvoidanceQuery()
 {
 	dtFree(m_circles);
 	dtFree(m_segments);
+	dtFree(m_batchCircles);
+	dtFree(m_batchSegments);
+}
+
+int dtObstacleAvoidanceQuery::getMemUsed() const
+{
+	return sizeof(*this) +
+		(int)dtAllocSize(m_circles) +
+		(int)dtAllocSize(m_segments) +
+		(int)dtAllocSize(m_batchCircles) +
+		(int)dtAllocSize(m_batchSegments);
 }
 
 bool dtObstacleAvoidanceQuery::init(const int maxCircles, const int maxSegments)
 {
 	m_maxCircles = maxCircles;
 	m_ncircles = 0;
-	m_circles = (dtObstacleCircle*)dtAlloc(sizeof(dtObstacleCircle)*m_maxCircles, DT_ALLOC_PERM);
+	m_circles = (dtObstacleCircle*)dtAlloc(sizeof(dtObstacleCircle)*m_maxCircles, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
 	if (!m_circles)
 		return false;
 	memset(m_circles, 0, sizeof(dtObstacleCircle)*m_maxCircles);
 
 	m_maxSegments = maxSegments;
 	m_nsegments = 0;
-	m_segments = (dtObstacleSegment*)dtAlloc(sizeof(dtObstacleSegment)*m_maxSegments, DT_ALLOC_PERM);
+	m_segments = (dtObstacleSegment*)dtAlloc(sizeof(dtObstacleSegment)*m_maxSegments, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
 	if (!m_segments)
 		return false;
 	memset(m_segments, 0, sizeof(dtObstacleSegment)*m_maxSegments);
+
+	m_batchCircles = (float*)dtAlloc(sizeof(float)*DT_BATCH_CIRCLE_FIELDS*dtMax(m_maxCircles, 1), DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+	if (!m_batchCircles)
+		return false;
+	m_batchSegments = (float*)dtAlloc(sizeof(float)*DT_BATCH_SEG_FIELDS*dtMax(m_maxSegments, 1), DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+	if (!m_batchSegments)
+		return false;
 	
 	return true;
 }
@@ -432,6 +541,227 @@ float dtObstacleAvoidanceQuery::processSample(const float* vcand, const float cs
 	return penalty;
 }
 
+// Precalculates the obstacle terms that don't depend on the sampled velocity.
+// Must be called after prepare().
+void dtObstacleAvoidanceQuery::prepareBatch(const float* pos, const float rad, const float* vel)
+{
+	float* cf = m_batchCircles;
+	const int nc = m_maxCircles;
+	for (int i = 0; i < m_ncircles; ++i)
+	{
+		const dtObstacleCircle* cir = &m_circles[i];
+		const float sx = cir->p[0] - pos[0];
+		const float sz = cir->p[2] - pos[2];
+		const float r = rad + cir->rad;
+		cf[DT_BATCH_CIRCLE_SX*nc+i] = sx;
+		cf[DT_BATCH_CIRCLE_SZ*nc+i] = sz;
+		cf[DT_BATCH_CIRCLE_C*nc+i] = sx*sx + sz*sz - r*r;
+		cf[DT_BATCH_CIRCLE_WX*nc+i] = vel[0] + cir->vel[0];
+		cf[DT_BATCH_CIRCLE_WZ*nc+i] = vel[2] + cir->vel[2];
+		cf[DT_BATCH_CIRCLE_DPX*nc+i] = cir->dp[0];
+		cf[DT_BATCH_CIRCLE_DPZ*nc+i] = cir->dp[2];
+		cf[DT_BATCH_CIRCLE_NPX*nc+i] = cir->np[0];
+		cf[DT_BATCH_CIRCLE_NPZ*nc+i] = cir->np[2];
+	}
+
+	float* sf = m_batchSegments;
+	const int ns = m_maxSegments;
+	for (int i = 0; i < m_nsegments; ++i)
+	{
+		const dtObstacleSegment* seg = &m_segments[i];
+		const float vx = seg->q[0] - seg->p[0];
+		const float vz = seg->q[2] - seg->p[2];
+		const float wx = pos[0] - seg->p[0];
+		const float wz = pos[2] - seg->p[2];
+		sf[DT_BATCH_SEG_VX*ns+i] = vx;
+		sf[DT_BATCH_SEG_VZ*ns+i] = vz;
+		sf[DT_BATCH_SEG_WX*ns+i] = wx;
+		sf[DT_BATCH_SEG_WZ*ns+i] = wz;
+		sf[DT_BATCH_SEG_TNUM*ns+i] = vz*wx - vx*wz;
+	}
+}
+
+/* Calculate the collision penalties for four sampled velocities at once.
+ * Same as processSample, except that the early out threshold is not lowered
+ * between the samples of the batch.  A sample that exits early still gets
+ * minPenalty.
+ *
+ * @param vcandx, vcandz sampled velocities
+ * @param minPenalty threshold penalty for early out
+ * @param penalties the penalty of each sample
+ */
+void dtObstacleAvoidanceQuery::processSampleBatch(const float* vcandx, const float* vcandz,
+												  const float* pos, const float rad,
+												  const float* vel, const float* dvel,
+												  const float minPenalty, float* penalties)
+{
+#if defined(DT_OBSTACLE_SIMD_SSE2) || defined(DT_OBSTACLE_SIMD_NEON)
+	dtIgnoreUnused(pos);
+	dtIgnoreUnused(rad);
+
+	const dtSimdFloat zero = dtSimdSet(0.0f);
+	const dtSimdFloat one = dtSimdSet(1.0f);
+	const dtSimdFloat half = dtSimdSet(0.5f);
+	const dtSimdFloat two = dtSimdSet(2.0f);
+	const dtSimdFloat horizTime = dtSimdSet(m_params.horizTime);
+	const dtSimdFloat minPenalty4 = dtSimdSet(minPenalty);
+	const dtSimdFloat invVmax = dtSimdSet(m_invVmax);
+
+	const dtSimdFloat vx = dtSimdLoad(vcandx);
+	const dtSimdFloat vz = dtSimdLoad(vcandz);
+
+	// penalty for straying away from the desired and current velocities
+	dtSimdFloat dx = dtSimdSub(vx, dtSimdSet(dvel[0]));
+	dtSimdFloat dz = dtSimdSub(vz, dtSimdSet(dvel[2]));
+	const dtSimdFloat vpen = dtSimdMul(dtSimdSet(m_params.weightDesVel),
+									   dtSimdMul(dtSimdSqrt(dtSimdAdd(dtSimdMul(dx,dx), dtSimdMul(dz,dz))), invVmax));
+	dx = dtSimdSub(vx, dtSimdSet(vel[0]));
+	dz = dtSimdSub(vz, dtSimdSet(vel[2]));
+	const dtSimdFloat vcpen = dtSimdMul(dtSimdSet(m_params.weightCurVel),
+										dtSimdMul(dtSimdSqrt(dtSimdAdd(dtSimdMul(dx,dx), dtSimdMul(dz,dz))), invVmax));
+
+	// find the threshold hit time to bail out based on the early out penalty
+	const dtSimdFloat minPen = dtSimdSub(dtSimdSub(minPenalty4, vpen), vcpen);
+	const dtSimdFloat tThresold = dtSimdMul(dtSimdSub(dtSimdDiv(dtSimdSet(m_params.weightToi), minPen), dtSimdSet(0.1f)),
+											horizTime);
+	dtSimdMask done = dtSimdGreater(dtSimdSub(tThresold, horizTime), dtSimdSet(-FLT_EPSILON));
+	if (dtSimdAll(done))
+	{
+		dtSimdStore(penalties, minPenalty4);
+		return;
+	}
+
+	// Find min time of impact and exit amongst all obstacles.
+	dtSimdFloat tmin = horizTime;
+	dtSimdFloat side = zero;
+
+	const dtSimdFloat vx2 = dtSimdMul(vx, two);
+	const dtSimdFloat vz2 = dtSimdMul(vz, two);
+	const float* cf = m_batchCircles;
+	const int nc = m_maxCircles;
+	for (int i = 0; i < m_ncircles && !dtSimdAll(done); ++i)
+	{
+		// RVO
+		const dtSimdFloat vabx = dtSimdSub(vx2, dtSimdSet(cf[DT_BATCH_CIRCLE_WX*nc+i]));
+		const dtSimdFloat vabz = dtSimdSub(vz2, dtSimdSet(cf[DT_BATCH_CIRCLE_WZ*nc+i]));
+
+		// Side
+		const dtSimdFloat sdp = dtSimdAdd(dtSimdMul(dtSimdAdd(dtSimdMul(dtSimdSet(cf[DT_BATCH_CIRCLE_DPX*nc+i]), vabx),
+															  dtSimdMul(dtSimdSet(cf[DT_BATCH_CIRCLE_DPZ*nc+i]), vabz)), half), half);
+		const dtSimdFloat snp = dtSimdMul(dtSimdAdd(dtSimdMul(dtSimdSet(cf[DT_BATCH_CIRCLE_NPX*nc+i]), vabx),
+													dtSimdMul(dtSimdSet(cf[DT_BATCH_CIRCLE_NPZ*nc+i]), vabz)), two);
+		side = dtSimdAdd(side, dtSimdMax(zero, dtSimdMin(one, dtSimdMin(sdp, snp))));
+
+		// Sweep
+		const dtSimdFloat a = dtSimdAdd(dtSimdMul(vabx,vabx), dtSimdMul(vabz,vabz));
+		const dtSimdFloat b = dtSimdAdd(dtSimdMul(vabx, dtSimdSet(cf[DT_BATCH_CIRCLE_SX*nc+i])),
+										dtSimdMul(vabz, dtSimdSet(cf[DT_BATCH_CIRCLE_SZ*nc+i])));
+		const dtSimdFloat d = dtSimdSub(dtSimdMul(b,b), dtSimdMul(a, dtSimdSet(cf[DT_BATCH_CIRCLE_C*nc+i])));
+		dtSimdMask hit = dtSimdAnd(dtSimdGreaterEqual(a, dtSimdSet(0.0001f)), dtSimdGreaterEqual(d, zero));
+		const dtSimdFloat rd = dtSimdSqrt(dtSimdMax(d, zero));
+		const dtSimdFloat inva = dtSimdDiv(one, dtSimdSelect(hit, a, one));
+		dtSimdFloat htmin = dtSimdMul(dtSimdSub(b, rd), inva);
+		const dtSimdFloat htmax = dtSimdMul(dtSimdAdd(b, rd), inva);
+
+		// Handle overlapping obstacles.
+		const dtSimdMask overlap = dtSimdAnd(dtSimdLess(htmin, zero), dtSimdGreater(htmax, zero));
+		htmin = dtSimdSelect(overlap, dtSimdMul(htmin, dtSimdSet(-0.5f)), htmin);
+
+		// The closest obstacle is somewhere ahead of us, keep track of nearest obstacle.
+		hit = dtSimdAnd(hit, dtSimdGreaterEqual(htmin, zero));
+		tmin = dtSimdMin(tmin, dtSimdSelect(hit, htmin, tmin));
+		done = dtSimdOr(done, dtSimdLess(tmin, tThresold));
+	}
+
+	const float* sf = m_batchSegments;
+	const int ns = m_maxSegments;
+	for (int i = 0; i < m_nsegments && !dtSimdAll(done); ++i)
+	{
+		const dtSimdFloat sx = dtSimdSet(sf[DT_BATCH_SEG_VX*ns+i]);
+		const dtSimdFloat sz = dtSimdSet(sf[DT_BATCH_SEG_VZ*ns+i]);
+		dtSimdFloat htmin;
+		dtSimdMask hit;
+
+		if (m_segments[i].touch)
+		{
+			// Special case when the agent is very close to the segment.
+			// If the velocity is pointing towards the segment, no collision.
+			// Else immediate collision.
+			hit = dtSimdGreaterEqual(dtSimdSub(dtSimdMul(sx, vz), dtSimdMul(sz, vx)), zero);
+			htmin = zero;
+		}
+		else
+		{
+			const dtSimdFloat wx = dtSimdSet(sf[DT_BATCH_SEG_WX*ns+i]);
+			const dtSimdFloat wz = dtSimdSet(sf[DT_BATCH_SEG_WZ*ns+i]);
+			const dtSimdFloat d = dtSimdSub(dtSimdMul(vz, sx), dtSimdMul(vx, sz));
+			hit = dtSimdGreaterEqual(dtSimdAbs(d), dtSimdSet(1e-6f));
+			const dtSimdFloat invd = dtSimdDiv(one, dtSimdSelect(hit, d, one));
+			htmin = dtSimdMul(dtSimdSet(sf[DT_BATCH_SEG_TNUM*ns+i]), invd);
+			const dtSimdFloat s = dtSimdMul(dtSimdSub(dtSimdMul(vz, wx), dtSimdMul(vx, wz)), invd);
+			hit = dtSimdAnd(hit, dtSimdAnd(dtSimdGreaterEqual(htmin, zero), dtSimdLessEqual(htmin, one)));
+			hit = dtSimdAnd(hit, dtSimdAnd(dtSimdGreaterEqual(s, zero), dtSimdLessEqual(s, one)));
+		}
+
+		// Avoid less when facing walls.
+		htmin = dtSimdMul(htmin, two);
+
+		// The closest obstacle is somewhere ahead of us, keep track of nearest obstacle.
+		tmin = dtSimdMin(tmin, dtSimdSelect(hit, htmin, tmin));
+		done = dtSimdOr(done, dtSimdLess(tmin, tThresold));
+	}
+
+	// Normalize side bias, to prevent it dominating too much.
+	if (m_ncircles)
+		side = dtSimdDiv(side, dtSimdSet((float)m_ncircles));
+
+	const dtSimdFloat spen = dtSimdMul(dtSimdSet(m_params.weightSide), side);
+	const dtSimdFloat tpen = dtSimdDiv(dtSimdSet(m_params.weightToi),
+									   dtSimdAdd(dtSimdSet(0.1f), dtSimdMul(tmin, dtSimdSet(m_invHorizTime))));
+
+	const dtSimdFloat penalty = dtSimdAdd(dtSimdAdd(vpen, vcpen), dtSimdAdd(spen, tpen));
+	dtSimdStore(penalties, dtSimdSelect(done, minPenalty4, penalty));
+#else
+	for (int i = 0; i < 4; ++i)
+	{
+		const float vcand[3] = { vcandx[i], 0, vcandz[i] };
+		penalties[i] = processSample(vcand, 0, pos, rad, vel, dvel, minPenalty, 0);
+	}
+#endif
+}
+
+// Scores the batched samples and keeps the best one.  The samples are compared
+// in the order they were added, so the result is the same as scoring them one
+// by one.
+void dtObstacleAvoidanceQuery::flushBatch(SampleBatch& batch, const float* pos, const float rad,
+										  const float* vel, const float* dvel,
+										  float& minPenalty, float* bvel)
+{
+	if (!batch.n)
+		return;
+
+	// Pad the unused lanes, their penalties are ignored.
+	for (int i = batch.n; i < 4; ++i)
+	{
+		batch.x[i] = batch.x[0];
+		batch.z[i] = batch.z[0];
+	}
+
+	float penalties[4];
+	processSampleBatch(batch.x, batch.z, pos, rad, vel, dvel, minPenalty, penalties);
+
+	for (int i = 0; i < batch.n; ++i)
+	{
+		if (penalties[i] < minPenalty)
+		{
+			minPenalty = penalties[i];
+			dtVset(bvel, batch.x[i], 0, batch.z[i]);
+		}
+	}
+
+	batch.n = 0;
+}
+
 int dtObstacleAvoidanceQuery::sampleVelocityGrid(const float* pos, const float rad, const float vmax,
 												 const float* vel, const float* dvel, float* nvel,
 												 const dtObstacleAvoidanceParams* params,
@@ -456,6 +786,13 @@ int dtObstacleAvoidanceQuery::sampleVelocityGrid(const float* pos, const float r
 		
 	float minPenalty = FLT_MAX;
 	int ns = 0;
+
+	// The debug data needs the parts of each penalty, so it is only collected by the scalar path.
+	const bool batched = m_params.simdSampling && !debug;
+	SampleBatch batch;
+	batch.n = 0;
+	if (batched)
+		prepareBatch(pos, rad, vel);
 		
 	for (int y = 0; y < m_params.gridSize; ++y)
 	{
@@ -467,9 +804,18 @@ int dtObstacleAvoidanceQuery::sampleVelocityGrid(const float* pos, const float r
 			vcand[2] = cvz + y*cs - half;
 			
 			if (dtSqr(vcand[0])+dtSqr(vcand[2]) > dtSqr(vmax+cs/2)) continue;
+			ns++;
+
+			if (batched)
+			{
+				batch.x[batch.n] = vcand[0];
+				batch.z[batch.n] = vcand[2];
+				if (++batch.n == 4)
+					flushBatch(batch, pos,rad,vel,dvel, minPenalty, nvel);
+				continue;
+			}
 			
 			const float penalty = processSample(vcand, cs, pos,rad,vel,dvel, minPenalty, debug);
-			ns++;
 			if (penalty < minPenalty)
 			{
 				minPenalty = penalty;
@@ -477,6 +823,7 @@ int dtObstacleAvoidanceQuery::sampleVelocityGrid(const float* pos, const float r
 			}
 		}
 	}
+	flushBatch(batch, pos,rad,vel,dvel, minPenalty, nvel);
 	
 	return ns;
 }
@@ -584,6 +931,13 @@ int dtObstacleAvoidanceQuery::sampleVelocityAdaptive(const float* pos, const flo
 	dtVset(res, dvel[0] * m_params.velBias, 0, dvel[2] * m_params.velBias);
 	int ns = 0;
 
+	// The debug data needs the parts of each penalty, so it is only collected by the scalar path.
+	const bool batched = m_params.simdSampling && !debug;
+	SampleBatch batch;
+	batch.n = 0;
+	if (batched)
+		prepareBatch(pos, rad, vel);
+
 	for (int k = 0; k < depth; ++k)
 	{
 		float minPenalty = FLT_MAX;
@@ -598,15 +952,25 @@ int dtObstacleAvoidanceQuery::sampleVelocityAdaptive(const float* pos, const flo
 			vcand[2] = res[2] + pat[i*2+1]*cr;
 			
 			if (dtSqr(vcand[0])+dtSqr(vcand[2]) > dtSqr(vmax+0.001f)) continue;
+			ns++;
+
+			if (batched)
+			{
+				batch.x[batch.n] = vcand[0];
+				batch.z[batch.n] = vcand[2];
+				if (++batch.n == 4)
+					flushBatch(batch, pos,rad,vel,dvel, minPenalty, bvel);
+				continue;
+			}
 			
 			const float penalty = processSample(vcand,cr/10, pos,rad,vel,dvel, minPenalty, debug);
-			ns++;
 			if (penalty < minPenalty)
 			{
 				minPenalty = penalty;
 				dtVcopy(bvel, vcand);
 			}
 		}
+		flushBatch(batch, pos,rad,vel,dvel, minPenalty, bvel);
 
 		dtVcopy(res, bvel);
 
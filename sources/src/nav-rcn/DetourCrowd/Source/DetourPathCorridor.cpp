@@ -200,13 +200,20 @@ may be needed.  E.g. If you move the target, check #getLastPoly() to see if it i
 dtPathCorridor::dtPathCorridor() :
 	m_path(0),
 	m_npath(0),
-	m_maxPath(0)
+	m_maxPath(0),
+	m_validNav(0),
+	m_validFilter(0),
+	m_validVersion(0),
+	m_validIncludeFlags(0),
+	m_validExcludeFlags(0)
 {
+	memset(&m_portals, 0, sizeof(m_portals));
 }
 
 dtPathCorridor::~dtPathCorridor()
 {
 	dtFree(m_path);
+	dtFree(m_portals.refs);
 }
 
 /// @par
@@ -215,9 +222,26 @@ dtPathCorridor::~dtPathCorridor()
 bool dtPathCorridor::init(const int maxPath)
 {
 	dtAssert(!m_path);
-	m_path = (dtPolyRef*)dtAlloc(sizeof(dtPolyRef)*maxPath, DT_ALLOC_PERM);
+	m_path = (dtPolyRef*)dtAlloc(sizeof(dtPolyRef)*maxPath, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
 	if (!m_path)
 		return false;
+	
+	// The portal cache is a single allocation, ordered by alignment.
+	const int maxPortals = DT_PATHCORRIDOR_MAX_PORTALS;
+	unsigned char* portalData = (unsigned char*)dtAlloc(getPortalMemUsed(maxPortals), DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+	if (!portalData)
+	{
+		dtFree(m_path);
+		m_path = 0;
+		return false;
+	}
+	m_portals.refs = (dtPolyRef*)portalData;
+	m_portals.left = (float*)(portalData + sizeof(dtPolyRef)*(maxPortals+1));
+	m_portals.right = m_portals.left + maxPortals*3;
+	m_portals.toTypes = (unsigned char*)(m_portals.right + maxPortals*3);
+	m_portals.count = 0;
+	m_portals.maxPortals = maxPortals;
+	
 	m_npath = 0;
 	m_maxPath = maxPath;
 	return true;
@@ -234,6 +258,8 @@ void dtPathCorridor::reset(dtPolyRef ref, const float* pos)
 	dtVcopy(m_target, pos);
 	m_path[0] = ref;
 	m_npath = 1;
+	m_portals.count = 0;
+	m_validVersion = 0;
 }
 
 /**
@@ -257,9 +283,12 @@ int dtPathCorridor::findCorners(float* cornerVerts, unsigned char* cornerFlags,
 	
 	static const float MIN_TARGET_DIST = 0.01f;
 	
+	// The portal cache is realigned with the corridor by the query, so it
+	// stays valid as the corridor is trimmed and replanned.
 	int ncorners = 0;
 	navquery->findStraightPath(m_pos, m_target, m_path, m_npath,
-							   cornerVerts, cornerFlags, cornerPolys, &ncorners, maxCorners);
+							   cornerVerts, cornerFlags, cornerPolys, &ncorners, maxCorners,
+							   0, &m_portals);
 	
 	// Prune points in the beginning of the path which are too close.
 	while (ncorners)
@@ -517,6 +546,7 @@ void dtPathCorridor::setCorridor(const float* target, const dtPolyRef* path, con
 	dtVcopy(m_target, target);
 	memcpy(m_path, path, sizeof(dtPolyRef)*npath);
 	m_npath = npath;
+	m_validVersion = 0;
 }
 
 bool dtPathCorridor::fixPathStart(dtPolyRef safeRef, const float* safePos)
@@ -524,6 +554,7 @@ bool dtPathCorridor::fixPathStart(dtPolyRef safeRef, const float* safePos)
 	dtAssert(m_path);
 
 	dtVcopy(m_pos, safePos);
+	m_validVersion = 0;
 	if (m_npath < 3 && m_npath > 0)
 	{
 		m_path[2] = m_path[m_npath-1];
@@ -558,7 +589,9 @@ bool dtPathCorridor::trimInvalidPath(dtPolyRef safeRef, const float* safePos,
 		// All valid, no need to fix.
 		return true;
 	}
-	else if (n == 0)
+
+	m_validVersion = 0;
+	if (n == 0)
 	{
 		// The first polyref is bad, use current safe values.
 		dtVcopy(m_pos, safePos);
@@ -595,3 +628,58 @@ bool dtPathCorridor::isValid(const int maxLookAhead, dtNavMeshQuery* navquery, c
 
 	return true;
 }
+
+/// @par
+///
+/// The result is the same as #isValid.  Once the whole path has been found valid, 
+/// later calls only check the polygons in tiles that changed since then. (See: 
+/// dtNavMesh::hasTileChanged)  So while the mesh and the filter's flags don't change,
+/// the check costs a single comparison.
+///
+/// Polygons beyond @p maxLookAhead in changed tiles are checked too, but only the 
+/// look ahead affects the result.  If one of them fails, the changed tiles are 
+/// rechecked on each call until the path no longer contains the polygon.
+///
+/// Polygons added by the move and optimize functions come from queries against the 
+/// current mesh, so they are trusted as long as the same filter is used.  New paths
+/// (#setCorridor, #reset, #fixPathStart) are always checked in full.
+///
+/// Derived filters (DT_VIRTUAL_QUERYFILTER) can test anything, so every call does
+/// the full check.
+bool dtPathCorridor::isValidIncremental(const int maxLookAhead, dtNavMeshQuery* navquery, const dtQueryFilter* filter)
+{
+#ifdef DT_VIRTUAL_QUERYFILTER
+	return isValid(maxLookAhead, navquery, filter);
+#else
+	const dtNavMesh* nav = navquery->getAttachedNavMesh();
+	const unsigned int version = nav->getVersion();
+	
+	const bool checked = m_validVersion != 0
+		&& m_validNav == nav
+		&& m_validFilter == filter
+		&& m_validIncludeFlags == filter->getIncludeFlags()
+		&& m_validExcludeFlags == filter->getExcludeFlags();
+	
+	if (checked && m_validVersion == version)
+		return true;
+	
+	// The last check stays in place until the whole path passes, so a polygon that
+	// fails is found again on later calls.
+	const int n = dtMin(m_npath, maxLookAhead);
+	for (int i = 0; i < m_npath; ++i)
+	{
+		if (checked && !nav->hasTileChanged(m_path[i], m_validVersion))
+			continue;
+		if (!navquery->isValidPolyRef(m_path[i], filter))
+			return i >= n;
+	}
+	
+	m_validNav = nav;
+	m_validFilter = filter;
+	m_validVersion = version;
+	m_validIncludeFlags = filter->getIncludeFlags();
+	m_validExcludeFlags = filter->getExcludeFlags();
+	
+	return true;
+#endif
+}
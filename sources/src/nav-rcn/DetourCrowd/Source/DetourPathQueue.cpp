@@ -23,15 +23,41 @@
 #include "DetourAlloc.h"
 #include "DetourCommon.h"
 
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+// Returns a monotonic time stamp in microseconds.
+static double getTimeUsec()
+{
+#if defined(_WIN32)
+	LARGE_INTEGER freq, count;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&count);
+	return (double)count.QuadPart * 1000000.0 / (double)freq.QuadPart;
+#else
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1000000.0 + (double)ts.tv_nsec / 1000.0;
+#endif
+}
+
 
 dtPathQueue::dtPathQueue() :
+	m_queue(0),
+	m_maxQueue(0),
 	m_nextHandle(1),
 	m_maxPathSize(0),
-	m_queueHead(0),
-	m_navquery(0)
+	m_active(-1),
+	m_activeIters(0),
+	m_tick(0),
+	m_navquery(0),
+	m_cache(0)
 {
-	for (int i = 0; i < MAX_QUEUE; ++i)
-		m_queue[i].path = 0;
+	resetStats();
 }
 
 dtPathQueue::~dtPathQueue()
@@ -43,112 +69,203 @@ void dtPathQueue::purge()
 {
 	dtFreeNavMeshQuery(m_navquery);
 	m_navquery = 0;
-	for (int i = 0; i < MAX_QUEUE; ++i)
-	{
+	for (int i = 0; i < m_maxQueue; ++i)
 		dtFree(m_queue[i].path);
-		m_queue[i].path = 0;
-	}
+	dtFree(m_queue);
+	m_queue = 0;
+	m_maxQueue = 0;
+	m_active = -1;
 }
 
-bool dtPathQueue::init(const int maxPathSize, const int maxSearchNodeCount, dtNavMesh* nav)
+int dtPathQueue::getMemUsed() const
+{
+	int mem = sizeof(*this) + (int)dtAllocSize(m_queue);
+	for (int i = 0; i < m_maxQueue; ++i)
+		mem += (int)dtAllocSize(m_queue[i].path);
+	if (m_navquery)
+		mem += m_navquery->getMemUsed();
+	return mem;
+}
+
+bool dtPathQueue::init(const int maxPathSize, const int maxSearchNodeCount, dtNavMesh* nav,
+					   const int maxQueue)
 {
 	purge();
 
+	if (maxQueue < 1)
+		return false;
+
 	m_navquery = dtAllocNavMeshQuery();
 	if (!m_navquery)
 		return false;
 	if (dtStatusFailed(m_navquery->init(nav, maxSearchNodeCount)))
 		return false;
 	
+	m_queue = (PathQuery*)dtAlloc(sizeof(PathQuery)*maxQueue, DT_ALLOC_PERM, DT_ALLOC_TAG_PATH_QUEUE);
+	if (!m_queue)
+		return false;
+	memset(m_queue, 0, sizeof(PathQuery)*maxQueue);
+	m_maxQueue = maxQueue;
+
 	m_maxPathSize = maxPathSize;
-	for (int i = 0; i < MAX_QUEUE; ++i)
+	for (int i = 0; i < m_maxQueue; ++i)
 	{
 		m_queue[i].ref = DT_PATHQ_INVALID;
-		m_queue[i].path = (dtPolyRef*)dtAlloc(sizeof(dtPolyRef)*m_maxPathSize, DT_ALLOC_PERM);
+		m_queue[i].path = (dtPolyRef*)dtAlloc(sizeof(dtPolyRef)*m_maxPathSize, DT_ALLOC_PERM, DT_ALLOC_TAG_PATH_QUEUE);
 		if (!m_queue[i].path)
 			return false;
 	}
 	
-	m_queueHead = 0;
+	m_active = -1;
+	m_tick = 0;
+	resetStats();
 	
 	return true;
 }
 
-void dtPathQueue::update(const int maxIters)
+int dtPathQueue::findNextRequest() const
+{
+	// Highest priority first, oldest first among equals.
+	int best = -1;
+	for (int i = 0; i < m_maxQueue; ++i)
+	{
+		const PathQuery& q = m_queue[i];
+		if (q.ref == DT_PATHQ_INVALID || q.status != 0)
+			continue;
+		if (best != -1)
+		{
+			const PathQuery& b = m_queue[best];
+			if (q.priority < b.priority)
+				continue;
+			if (q.priority == b.priority && q.ref - b.ref < b.ref - q.ref)
+				continue;
+		}
+		best = i;
+	}
+	return best;
+}
+
+void dtPathQueue::completeRequest(PathQuery& q)
+{
+	q.keepAlive = 0;
+
+	const int wait = (int)(m_tick - q.requestTick);
+	m_completedCount++;
+	m_totalWaitTicks += (unsigned int)wait;
+	m_maxWaitTicks = dtMax(m_maxWaitTicks, wait);
+}
+
+void dtPathQueue::update(const int maxIters, const float maxTime)
 {
 	static const int MAX_KEEP_ALIVE = 2; // in update ticks.
+	// Pathfinder iterations between checks of the time budget.
+	static const int TIME_SLICE_ITERS = 16;
 
-	// Update path request until there is nothing to update
-	// or upto maxIters pathfinder iterations has been consumed.
-	int iterCount = maxIters;
-	
-	for (int i = 0; i < MAX_QUEUE; ++i)
+	// No reader slot.  The requests wait for the next update.
+	if (dtStatusFailed(m_navquery->beginRead()))
+		return;
+
+	const double startTime = getTimeUsec();
+	m_tick++;
+
+	// If the path result has not been read in few frames, free the slot.
+	for (int i = 0; i < m_maxQueue; ++i)
 	{
-		PathQuery& q = m_queue[m_queueHead % MAX_QUEUE];
-		
-		// Skip inactive requests.
+		PathQuery& q = m_queue[i];
 		if (q.ref == DT_PATHQ_INVALID)
-		{
-			m_queueHead++;
 			continue;
-		}
-		
-		// Handle completed request.
 		if (dtStatusSucceed(q.status) || dtStatusFailed(q.status))
 		{
-			// If the path result has not been read in few frames, free the slot.
 			q.keepAlive++;
 			if (q.keepAlive > MAX_KEEP_ALIVE)
 			{
 				q.ref = DT_PATHQ_INVALID;
 				q.status = 0;
 			}
-			
-			m_queueHead++;
-			continue;
 		}
+	}
+
+	// Update path requests until there is nothing to update,
+	// upto maxIters pathfinder iterations have been consumed,
+	// or the time budget has been spent.
+	// The request that owns the sliced query always runs to completion
+	// before the next one is picked.
+	int iterCount = maxIters;
+	
+	while (iterCount > 0)
+	{
+		if (m_active == -1)
+			m_active = findNextRequest();
+		if (m_active == -1)
+			break;
+
+		PathQuery& q = m_queue[m_active];
 		
 		// Handle query start.
 		if (q.status == 0)
 		{
-			q.status = m_navquery->initSlicedFindPath(q.startRef, q.endRef, q.startPos, q.endPos, q.filter);
+			q.status = m_navquery->initSlicedFindPath(q.startRef, q.endRef, q.startPos, q.endPos, q.filter, q.options);
+			m_activeIters = 0;
 		}		
 		// Handle query in progress.
 		if (dtStatusInProgress(q.status))
 		{
+			const int slice = maxTime > 0 ? dtMin(iterCount, TIME_SLICE_ITERS) : iterCount;
 			int iters = 0;
-			q.status = m_navquery->updateSlicedFindPath(iterCount, &iters);
+			q.status = m_navquery->updateSlicedFindPath(slice, &iters);
 			iterCount -= iters;
+			m_activeIters += iters;
 		}
 		if (dtStatusSucceed(q.status))
 		{
 			q.status = m_navquery->finalizeSlicedFindPath(q.path, &q.npath, m_maxPathSize);
+			if (m_cache && q.status == DT_SUCCESS)
+				m_cache->store(q.startRef, q.endRef, q.filter, q.path, q.npath);
 		}
 
-		if (iterCount <= 0)
-			break;
+		if (!dtStatusInProgress(q.status))
+		{
+			completeRequest(q);
+			m_active = -1;
+		}
 
-		m_queueHead++;
+		if (maxTime > 0 && getTimeUsec() - startTime >= maxTime)
+			break;
 	}
+
+	m_navquery->endRead();
+
+	m_lastIterCount = maxIters - dtMax(iterCount, 0);
+	m_lastUpdateTime = (float)(getTimeUsec() - startTime);
 }
 
 dtPathQueueRef dtPathQueue::request(dtPolyRef startRef, dtPolyRef endRef,
 									const float* startPos, const float* endPos,
-									const dtQueryFilter* filter)
+									const dtQueryFilter* filter, const float priority,
+									const unsigned int options)
 {
 	// Find empty slot
 	int slot = -1;
-	for (int i = 0; i < MAX_QUEUE; ++i)
+	int pending = 0;
+	for (int i = 0; i < m_maxQueue; ++i)
 	{
-		if (m_queue[i].ref == DT_PATHQ_INVALID)
+		const PathQuery& q = m_queue[i];
+		if (q.ref == DT_PATHQ_INVALID)
 		{
-			slot = i;
-			break;
+			if (slot == -1)
+				slot = i;
+		}
+		else if (q.status == 0 || dtStatusInProgress(q.status))
+		{
+			pending++;
 		}
 	}
 	// Could not find slot.
 	if (slot == -1)
+	{
+		m_rejectedCount++;
 		return DT_PATHQ_INVALID;
+	}
 	
 	dtPathQueueRef ref = m_nextHandle++;
 	if (m_nextHandle == DT_PATHQ_INVALID) m_nextHandle++;
@@ -163,14 +280,26 @@ dtPathQueueRef dtPathQueue::request(dtPolyRef startRef, dtPolyRef endRef,
 	q.status = 0;
 	q.npath = 0;
 	q.filter = filter;
+	q.options = options;
 	q.keepAlive = 0;
+	q.priority = priority;
+	q.requestTick = m_tick;
+
+	// A cached path completes the request without using the pathfinder.
+	if (m_cache && m_cache->find(startRef, endRef, filter, q.path, &q.npath, m_maxPathSize))
+	{
+		q.status = DT_SUCCESS;
+		completeRequest(q);
+	}
+
+	m_maxPendingCount = dtMax(m_maxPendingCount, pending + 1);
 	
 	return ref;
 }
 
 dtStatus dtPathQueue::getRequestStatus(dtPathQueueRef ref) const
 {
-	for (int i = 0; i < MAX_QUEUE; ++i)
+	for (int i = 0; i < m_maxQueue; ++i)
 	{
 		if (m_queue[i].ref == ref)
 			return m_queue[i].status;
@@ -180,7 +309,7 @@ dtStatus dtPathQueue::getRequestStatus(dtPathQueueRef ref) const
 
 dtStatus dtPathQueue::getPathResult(dtPathQueueRef ref, dtPolyRef* path, int* pathSize, const int maxPath)
 {
-	for (int i = 0; i < MAX_QUEUE; ++i)
+	for (int i = 0; i < m_maxQueue; ++i)
 	{
 		if (m_queue[i].ref == ref)
 		{
@@ -198,3 +327,236 @@ dtStatus dtPathQueue::getPathResult(dtPathQueueRef ref, dtPolyRef* path, int* pa
 	}
 	return DT_FAILURE;
 }
+
+void dtPathQueue::getStats(dtPathQueueStats* stats) const
+{
+	if (!stats)
+		return;
+
+	stats->maxQueue = m_maxQueue;
+	stats->pendingCount = 0;
+	stats->readyCount = 0;
+	for (int i = 0; i < m_maxQueue; ++i)
+	{
+		const PathQuery& q = m_queue[i];
+		if (q.ref == DT_PATHQ_INVALID)
+			continue;
+		if (q.status == 0 || dtStatusInProgress(q.status))
+			stats->pendingCount++;
+		else
+			stats->readyCount++;
+	}
+	stats->maxPendingCount = m_maxPendingCount;
+	stats->rejectedCount = m_rejectedCount;
+	stats->completedCount = m_completedCount;
+	stats->maxWaitTicks = m_maxWaitTicks;
+	stats->avgWaitTicks = m_completedCount
+		? (float)m_totalWaitTicks / (float)m_completedCount : 0.0f;
+	stats->lastIterCount = m_lastIterCount;
+	stats->lastUpdateTime = m_lastUpdateTime;
+}
+
+void dtPathQueue::resetStats()
+{
+	m_maxPendingCount = 0;
+	m_rejectedCount = 0;
+	m_completedCount = 0;
+	m_maxWaitTicks = 0;
+	m_totalWaitTicks = 0;
+	m_lastIterCount = 0;
+	m_lastUpdateTime = 0;
+}
+
+struct dtPathQueueState
+{
+	int magic;								// Magic number, used to identify the data.
+	int version;							// Data version number.
+	int requestCount;						// The number of stored requests.
+	dtPathQueueRef nextHandle;				// The reference of the next request.
+	unsigned int tick;						// The update tick at the time of storing the data.
+	int active;								// The slot of the request owning the sliced query, or -1.
+	int activeIters;						// The iterations spent on the active request.
+};
+
+struct dtPathQueueRequestState
+{
+	dtPolyRef startRef, endRef;				// Path find start and end polygons.
+	float startPos[3], endPos[3];			// Path find start and end location.
+	dtPathQueueRef ref;						// Request reference.
+	int slot;								// The queue slot of the request.
+	dtStatus status;						// Zero if the request has not completed.
+	int npath;								// The number of polygons in the stored path.
+	int keepAlive;
+	int filterIndex;						// Index of the request filter, or -1.
+	unsigned int options;
+	float priority;
+	unsigned int requestTick;
+};
+
+///  @see #storeState
+int dtPathQueue::getStateSize() const
+{
+	int size = dtAlign4(sizeof(dtPathQueueState));
+	for (int i = 0; i < m_maxQueue; ++i)
+	{
+		const PathQuery& q = m_queue[i];
+		if (q.ref == DT_PATHQ_INVALID)
+			continue;
+		size += dtAlign4(sizeof(dtPathQueueRequestState));
+		if (dtStatusSucceed(q.status))
+			size += dtAlign4(sizeof(dtPolyRef) * q.npath);
+	}
+	return size;
+}
+
+/// @par
+///
+/// The state includes the pending requests and the completed results that have not been read.
+/// A request that is being processed is stored with the number of iterations spent on it, and
+/// its search is replayed up to that point on restore, so the restored queue produces the same
+/// results on the same updates.  (The search is deterministic.)  Filters are stored as indices into @p filters, so a request that uses
+/// any other filter is dropped on restore.
+///
+/// The state stays valid across processes for a navigation mesh with the same polygon
+/// references.
+/// @see #getStateSize, #restoreState
+dtStatus dtPathQueue::storeState(unsigned char* data, const int maxDataSize,
+								 const dtQueryFilter* filters, const int filterCount) const
+{
+	// Make sure there is enough space to store the state.
+	const int sizeReq = getStateSize();
+	if (!data || maxDataSize < sizeReq)
+		return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+
+	dtPathQueueState* state = dtGetThenAdvanceBufferPointer<dtPathQueueState>(data, dtAlign4(sizeof(dtPathQueueState)));
+	state->magic = DT_PATHQ_STATE_MAGIC;
+	state->version = DT_PATHQ_STATE_VERSION;
+	state->requestCount = 0;
+	state->nextHandle = m_nextHandle;
+	state->tick = m_tick;
+	state->active = m_active;
+	state->activeIters = m_active == -1 ? 0 : m_activeIters;
+
+	for (int i = 0; i < m_maxQueue; ++i)
+	{
+		const PathQuery& q = m_queue[i];
+		if (q.ref == DT_PATHQ_INVALID)
+			continue;
+
+		dtPathQueueRequestState* s = dtGetThenAdvanceBufferPointer<dtPathQueueRequestState>(data, dtAlign4(sizeof(dtPathQueueRequestState)));
+		s->startRef = q.startRef;
+		s->endRef = q.endRef;
+		dtVcopy(s->startPos, q.startPos);
+		dtVcopy(s->endPos, q.endPos);
+		s->ref = q.ref;
+		s->slot = i;
+		s->status = dtStatusInProgress(q.status) ? 0 : q.status;
+		s->npath = dtStatusSucceed(q.status) ? q.npath : 0;
+		s->keepAlive = q.keepAlive;
+		s->filterIndex = -1;
+		if (q.filter >= filters && q.filter < filters + filterCount)
+			s->filterIndex = (int)(q.filter - filters);
+		s->options = q.options;
+		s->priority = q.priority;
+		s->requestTick = q.requestTick;
+
+		memcpy(data, q.path, sizeof(dtPolyRef) * s->npath);
+		data += dtAlign4(sizeof(dtPolyRef) * s->npath);
+
+		state->requestCount++;
+	}
+
+	return DT_SUCCESS;
+}
+
+/// @par
+///
+/// All current requests are replaced.  The search of the request that was being processed is
+/// replayed, which costs the iterations that were spent on it.  Paths longer than the queue's maximum path size are
+/// truncated and marked with #DT_BUFFER_TOO_SMALL.  The statistics are not changed.
+/// @see #storeState
+dtStatus dtPathQueue::restoreState(const unsigned char* data, const int maxDataSize,
+								   const dtQueryFilter* filters, const int filterCount)
+{
+	const int headerSize = dtAlign4(sizeof(dtPathQueueState));
+	if (!data || maxDataSize < headerSize)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	const unsigned char* end = data + maxDataSize;
+	const dtPathQueueState* state = dtGetThenAdvanceBufferPointer<const dtPathQueueState>(data, headerSize);
+
+	// Check that the restore is possible.
+	if (state->magic != DT_PATHQ_STATE_MAGIC)
+		return DT_FAILURE | DT_WRONG_MAGIC;
+	if (state->version != DT_PATHQ_STATE_VERSION)
+		return DT_FAILURE | DT_WRONG_VERSION;
+	if (state->requestCount < 0 || state->requestCount > m_maxQueue)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	for (int i = 0; i < m_maxQueue; ++i)
+	{
+		m_queue[i].ref = DT_PATHQ_INVALID;
+		m_queue[i].status = 0;
+	}
+	m_active = -1;
+	m_activeIters = 0;
+	m_nextHandle = state->nextHandle;
+	m_tick = state->tick;
+
+	for (int i = 0; i < state->requestCount; ++i)
+	{
+		const int requestSize = dtAlign4(sizeof(dtPathQueueRequestState));
+		if (end - data < requestSize)
+			return DT_FAILURE | DT_INVALID_PARAM;
+
+		const dtPathQueueRequestState* s = dtGetThenAdvanceBufferPointer<const dtPathQueueRequestState>(data, requestSize);
+		// The count is checked before the size is computed, so the size can't overflow.
+		if (s->npath < 0 || s->npath > (int)((end - data) / sizeof(dtPolyRef)))
+			return DT_FAILURE | DT_INVALID_PARAM;
+		const int pathSize = dtAlign4(sizeof(dtPolyRef) * s->npath);
+		if (end - data < pathSize)
+			return DT_FAILURE | DT_INVALID_PARAM;
+
+		const unsigned char* path = data;
+		data += pathSize;
+
+		if (s->ref == DT_PATHQ_INVALID || s->slot < 0 || s->slot >= m_maxQueue
+			|| m_queue[s->slot].ref != DT_PATHQ_INVALID
+			|| s->filterIndex < 0 || s->filterIndex >= filterCount)
+		{
+			continue;
+		}
+
+		PathQuery& q = m_queue[s->slot];
+		q.ref = s->ref;
+		q.startRef = s->startRef;
+		q.endRef = s->endRef;
+		dtVcopy(q.startPos, s->startPos);
+		dtVcopy(q.endPos, s->endPos);
+		q.status = s->status;
+		q.npath = dtMin(s->npath, m_maxPathSize);
+		if (q.npath < s->npath)
+			q.status |= DT_BUFFER_TOO_SMALL;
+		memcpy(q.path, path, sizeof(dtPolyRef) * q.npath);
+		q.keepAlive = s->keepAlive;
+		q.filter = &filters[s->filterIndex];
+		q.options = s->options;
+		q.priority = s->priority;
+		q.requestTick = s->requestTick;
+	}
+
+	// Replay the search of the active request.
+	if (state->active >= 0 && state->active < m_maxQueue)
+	{
+		PathQuery& q = m_queue[state->active];
+		if (q.ref != DT_PATHQ_INVALID && q.status == 0)
+		{
+			m_active = state->active;
+			q.status = m_navquery->initSlicedFindPath(q.startRef, q.endRef, q.startPos, q.endPos, q.filter, q.options);
+			if (dtStatusInProgress(q.status) && state->activeIters > 0)
+				q.status = m_navquery->updateSlicedFindPath(state->activeIters, &m_activeIters);
+		}
+	}
+
+	return DT_SUCCESS;
+}
@@ -27,7 +27,7 @@
 
 dtProximityGrid* dtAllocProximityGrid()
 {
-	void* mem = dtAlloc(sizeof(dtProximityGrid), DT_ALLOC_PERM);
+	void* mem = dtAlloc(sizeof(dtProximityGrid), DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
 	if (!mem) return 0;
 	return new(mem) dtProximityGrid;
 }
@@ -49,11 +49,18 @@ inline int hashPos2(int x, int y, int n)
 dtProximityGrid::dtProximityGrid() :
 	m_cellSize(0),
 	m_invCellSize(0),
+	m_type(DT_PROXIMITY_GRID_HASHED),
 	m_pool(0),
 	m_poolHead(0),
 	m_poolSize(0),
 	m_buckets(0),
-	m_bucketsSize(0)
+	m_bucketsSize(0),
+	m_itemBounds(0),
+	m_cellStart(0),
+	m_sortedIds(0),
+	m_sortedCells(0),
+	m_sortedBounds(0),
+	m_sortedCount(0)
 {
 }
 
@@ -61,29 +68,77 @@ dtProximityGrid::~dtProximityGrid()
 {
 	dtFree(m_buckets);
 	dtFree(m_pool);
+	dtFree(m_itemBounds);
+	dtFree(m_cellStart);
+	dtFree(m_sortedIds);
+	dtFree(m_sortedCells);
+	dtFree(m_sortedBounds);
 }
 
-bool dtProximityGrid::init(const int poolSize, const float cellSize)
+int dtProximityGrid::getMemUsed() const
+{
+	return sizeof(*this) +
+		(int)dtAllocSize(m_pool) +
+		(int)dtAllocSize(m_buckets) +
+		(int)dtAllocSize(m_itemBounds) +
+		(int)dtAllocSize(m_cellStart) +
+		(int)dtAllocSize(m_sortedIds) +
+		(int)dtAllocSize(m_sortedCells) +
+		(int)dtAllocSize(m_sortedBounds);
+}
+
+/// @par
+///
+/// For a hashed grid the pool size is the maximum number of item cells, so it
+/// should allow for items overlapping more than one cell.  For a sorted grid
+/// it is the maximum number of items.
+bool dtProximityGrid::init(const int poolSize, const float cellSize, const int type)
 {
 	dtAssert(poolSize > 0);
 	dtAssert(cellSize > 0.0f);
 	
 	m_cellSize = cellSize;
 	m_invCellSize = 1.0f / m_cellSize;
+	m_type = type;
 	
 	// Allocate hashs buckets
 	m_bucketsSize = dtNextPow2(poolSize);
-	m_buckets = (unsigned short*)dtAlloc(sizeof(unsigned short)*m_bucketsSize, DT_ALLOC_PERM);
-	if (!m_buckets)
-		return false;
+	if (m_type == DT_PROXIMITY_GRID_SORTED)
+	{
+		m_cellStart = (int*)dtAlloc(sizeof(int)*(m_bucketsSize+1), DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+		if (!m_cellStart)
+			return false;
+	}
+	else
+	{
+		m_buckets = (unsigned short*)dtAlloc(sizeof(unsigned short)*m_bucketsSize, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+		if (!m_buckets)
+			return false;
+	}
 	
 	// Allocate pool of items.
 	m_poolSize = poolSize;
 	m_poolHead = 0;
-	m_pool = (Item*)dtAlloc(sizeof(Item)*m_poolSize, DT_ALLOC_PERM);
+	m_pool = (Item*)dtAlloc(sizeof(Item)*m_poolSize, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
 	if (!m_pool)
 		return false;
 	
+	if (m_type == DT_PROXIMITY_GRID_SORTED)
+	{
+		m_itemBounds = (float*)dtAlloc(sizeof(float)*m_poolSize*4, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+		if (!m_itemBounds)
+			return false;
+		m_sortedIds = (unsigned short*)dtAlloc(sizeof(unsigned short)*m_poolSize, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+		if (!m_sortedIds)
+			return false;
+		m_sortedCells = (short*)dtAlloc(sizeof(short)*m_poolSize*2, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+		if (!m_sortedCells)
+			return false;
+		m_sortedBounds = (float*)dtAlloc(sizeof(float)*m_poolSize*4, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+		if (!m_sortedBounds)
+			return false;
+	}
+	
 	clear();
 	
 	return true;
@@ -91,8 +146,14 @@ bool dtProximityGrid::init(const int poolSize, const float cellSize)
 
 void dtProximityGrid::clear()
 {
-	memset(m_buckets, 0xff, sizeof(unsigned short)*m_bucketsSize);
+	if (m_type == DT_PROXIMITY_GRID_SORTED)
+		memset(m_cellStart, 0, sizeof(int)*(m_bucketsSize+1));
+	else
+		memset(m_buckets, 0xff, sizeof(unsigned short)*m_bucketsSize);
 	m_poolHead = 0;
+	m_sortedCount = 0;
+	m_maxCellSpan[0] = 0;
+	m_maxCellSpan[1] = 0;
 	m_bounds[0] = 0xffff;
 	m_bounds[1] = 0xffff;
 	m_bounds[2] = -0xffff;
@@ -113,6 +174,29 @@ void dtProximityGrid::addItem(const unsigned short id,
 	m_bounds[2] = dtMax(m_bounds[2], imaxx);
 	m_bounds[3] = dtMax(m_bounds[3], imaxy);
 	
+	if (m_type == DT_PROXIMITY_GRID_SORTED)
+	{
+		if (m_poolHead >= m_poolSize)
+			return;
+		
+		m_maxCellSpan[0] = dtMax(m_maxCellSpan[0], imaxx - iminx);
+		m_maxCellSpan[1] = dtMax(m_maxCellSpan[1], imaxy - iminy);
+		
+		Item& item = m_pool[m_poolHead];
+		item.x = (short)iminx;
+		item.y = (short)iminy;
+		item.id = id;
+		
+		float* b = &m_itemBounds[m_poolHead*4];
+		b[0] = minx;
+		b[1] = miny;
+		b[2] = maxx;
+		b[3] = maxy;
+		
+		m_poolHead++;
+		return;
+	}
+	
 	for (int y = iminy; y <= imaxy; ++y)
 	{
 		for (int x = iminx; x <= imaxx; ++x)
@@ -133,10 +217,106 @@ void dtProximityGrid::addItem(const unsigned short id,
 	}
 }
 
+/// @par
+///
+/// The items are counting sorted by the hash bucket of their cell, keeping the 
+/// order they were added in within each bucket.
+void dtProximityGrid::sortItems()
+{
+	if (m_type != DT_PROXIMITY_GRID_SORTED)
+		return;
+	
+	const int n = m_poolHead;
+	
+	memset(m_cellStart, 0, sizeof(int)*(m_bucketsSize+1));
+	for (int i = 0; i < n; ++i)
+		m_cellStart[hashPos2(m_pool[i].x, m_pool[i].y, m_bucketsSize)+1]++;
+	for (int i = 0; i < m_bucketsSize; ++i)
+		m_cellStart[i+1] += m_cellStart[i];
+	
+	// Scatter using the start of each bucket as its cursor.  Afterwards each
+	// entry holds the end of its bucket, so shift them back by one.
+	float* minx = &m_sortedBounds[0];
+	float* miny = &m_sortedBounds[m_poolSize];
+	float* maxx = &m_sortedBounds[m_poolSize*2];
+	float* maxy = &m_sortedBounds[m_poolSize*3];
+	for (int i = 0; i < n; ++i)
+	{
+		const Item& item = m_pool[i];
+		const int j = m_cellStart[hashPos2(item.x, item.y, m_bucketsSize)]++;
+		const float* b = &m_itemBounds[i*4];
+		m_sortedIds[j] = item.id;
+		m_sortedCells[j*2+0] = item.x;
+		m_sortedCells[j*2+1] = item.y;
+		minx[j] = b[0];
+		miny[j] = b[1];
+		maxx[j] = b[2];
+		maxy[j] = b[3];
+	}
+	for (int i = m_bucketsSize; i > 0; --i)
+		m_cellStart[i] = m_cellStart[i-1];
+	m_cellStart[0] = 0;
+	
+	m_sortedCount = n;
+}
+
+int dtProximityGrid::querySortedItems(const float minx, const float miny,
+									  const float maxx, const float maxy,
+									  unsigned short* ids, const int maxIds) const
+{
+	if (!m_sortedCount)
+		return 0;
+	
+	// Items are stored in the cell of their minimum bounds, so cells up to the 
+	// largest item span before the query can hold overlapping items.
+	const int iminx = (int)dtMathFloorf(minx * m_invCellSize) - m_maxCellSpan[0];
+	const int iminy = (int)dtMathFloorf(miny * m_invCellSize) - m_maxCellSpan[1];
+	const int imaxx = (int)dtMathFloorf(maxx * m_invCellSize);
+	const int imaxy = (int)dtMathFloorf(maxy * m_invCellSize);
+	
+	const float* bminx = &m_sortedBounds[0];
+	const float* bminy = &m_sortedBounds[m_poolSize];
+	const float* bmaxx = &m_sortedBounds[m_poolSize*2];
+	const float* bmaxy = &m_sortedBounds[m_poolSize*3];
+	
+	// Each item is stored once, and only matches its own cell even if other
+	// cells share its bucket, so no duplicate check is needed.
+	int n = 0;
+	for (int y = iminy; y <= imaxy; ++y)
+	{
+		for (int x = iminx; x <= imaxx; ++x)
+		{
+			const int h = hashPos2(x, y, m_bucketsSize);
+			const int end = m_cellStart[h+1];
+			for (int i = m_cellStart[h]; i < end; ++i)
+			{
+				const bool hit = ((int)m_sortedCells[i*2+0] == x) & ((int)m_sortedCells[i*2+1] == y) &
+								 (bminx[i] <= maxx) & (bmaxx[i] >= minx) &
+								 (bminy[i] <= maxy) & (bmaxy[i] >= miny);
+				if (hit)
+				{
+					if (n >= maxIds)
+						return n;
+					ids[n++] = m_sortedIds[i];
+				}
+			}
+		}
+	}
+	
+	return n;
+}
+
+/// @par
+///
+/// A hashed grid returns the items that share a cell with the query bounds.  
+/// A sorted grid only returns the items whose bounds overlap the query bounds.
 int dtProximityGrid::queryItems(const float minx, const float miny,
 								const float maxx, const float maxy,
 								unsigned short* ids, const int maxIds) const
 {
+	if (m_type == DT_PROXIMITY_GRID_SORTED)
+		return querySortedItems(minx, miny, maxx, maxy, ids, maxIds);
+	
 	const int iminx = (int)dtMathFloorf(minx * m_invCellSize);
 	const int iminy = (int)dtMathFloorf(miny * m_invCellSize);
 	const int imaxx = (int)dtMathFloorf(maxx * m_invCellSize);
@@ -180,6 +360,30 @@ int dtProximityGrid::getItemCountAt(const int x, const int y) const
 {
 	int n = 0;
 	
+	if (m_type == DT_PROXIMITY_GRID_SORTED)
+	{
+		if (!m_sortedCount)
+			return 0;
+		
+		// Count the items whose cell span includes the cell.
+		for (int cy = y - m_maxCellSpan[1]; cy <= y; ++cy)
+		{
+			for (int cx = x - m_maxCellSpan[0]; cx <= x; ++cx)
+			{
+				const int h = hashPos2(cx, cy, m_bucketsSize);
+				for (int i = m_cellStart[h]; i < m_cellStart[h+1]; ++i)
+				{
+					if ((int)m_sortedCells[i*2+0] != cx || (int)m_sortedCells[i*2+1] != cy)
+						continue;
+					if ((int)dtMathFloorf(m_sortedBounds[m_poolSize*2+i] * m_invCellSize) >= x &&
+						(int)dtMathFloorf(m_sortedBounds[m_poolSize*3+i] * m_invCellSize) >= y)
+						n++;
+				}
+			}
+		}
+		return n;
+	}
+	
 	const int h = hashPos2(x, y, m_bucketsSize);
 	unsigned short idx = m_buckets[h];
 	while (idx != 0xffff)
@@ -0,0 +1,358 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#include <string.h>
+#include <new>
+#include "DetourWallSegmentCache.h"
+#include "DetourCommon.h"
+#include "DetourAlloc.h"
+#include "DetourAssert.h"
+
+
+dtWallSegmentCache* dtAllocWallSegmentCache()
+{
+	void* mem = dtAlloc(sizeof(dtWallSegmentCache), DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+	if (!mem) return 0;
+	return new(mem) dtWallSegmentCache;
+}
+
+void dtFreeWallSegmentCache(dtWallSegmentCache* ptr)
+{
+	if (!ptr) return;
+	ptr->~dtWallSegmentCache();
+	dtFree(ptr);
+}
+
+
+static const int MAX_INTERVAL = 16;
+
+struct dtWallInterval
+{
+	dtPolyRef ref;
+	short tmin, tmax;
+};
+
+static void insertInterval(dtWallInterval* ints, int& nints, const int maxInts,
+						   const short tmin, const short tmax, const dtPolyRef ref)
+{
+	if (nints+1 > maxInts) return;
+	// Find insertion point.
+	int idx = 0;
+	while (idx < nints)
+	{
+		if (tmax <= ints[idx].tmin)
+			break;
+		idx++;
+	}
+	// Move current results.
+	if (nints-idx)
+		memmove(ints+idx+1, ints+idx, sizeof(dtWallInterval)*(nints-idx));
+	// Store
+	ints[idx].ref = ref;
+	ints[idx].tmin = tmin;
+	ints[idx].tmax = tmax;
+	nints++;
+}
+
+// Splits a polygon edge into wall and portal segments, in order along the edge.
+// Unlike dtNavMeshQuery::getPolyWallSegments the filter is not applied, every
+// link is stored as a portal.  Returns the number of segments, and only counts
+// them if the output arrays are null.
+static int getEdgeSegments(const dtNavMesh* nav, const dtMeshTile* tile, const dtPoly* poly, const int edge,
+						   float* verts, dtPolyRef* neis)
+{
+	const int j = edge;
+	const int i = (j+1) % (int)poly->vertCount;
+	const float* vj = &tile->verts[poly->verts[j]*3];
+	const float* vi = &tile->verts[poly->verts[i]*3];
+
+	if (!(poly->neis[j] & DT_EXT_LINK))
+	{
+		// Internal edge
+		if (verts)
+		{
+			dtVcopy(verts+0, vj);
+			dtVcopy(verts+3, vi);
+			neis[0] = 0;
+			if (poly->neis[j])
+				neis[0] = nav->getPolyRefBase(tile) | (unsigned int)(poly->neis[j]-1);
+		}
+		return 1;
+	}
+
+	// Tile border.
+	dtWallInterval ints[MAX_INTERVAL];
+	int nints = 0;
+	for (unsigned int k = poly->firstLink; k != DT_NULL_LINK; k = tile->links[k].next)
+	{
+		const dtLink* link = &tile->links[k];
+		if (link->edge == j && link->ref != 0)
+			insertInterval(ints, nints, MAX_INTERVAL, link->bmin, link->bmax, link->ref);
+	}
+	
+	// Add sentinels
+	insertInterval(ints, nints, MAX_INTERVAL, -1, 0, 0);
+	insertInterval(ints, nints, MAX_INTERVAL, 255, 256, 0);
+
+	int n = 0;
+	for (int k = 1; k < nints; ++k)
+	{
+		// Wall segment.
+		const int imin = ints[k-1].tmax;
+		const int imax = ints[k].tmin;
+		if (imin != imax)
+		{
+			if (verts)
+			{
+				dtVlerp(&verts[n*6+0], vj,vi, imin/255.0f);
+				dtVlerp(&verts[n*6+3], vj,vi, imax/255.0f);
+				neis[n] = 0;
+			}
+			n++;
+		}
+
+		// Portal segment.
+		if (ints[k].ref)
+		{
+			if (verts)
+			{
+				dtVlerp(&verts[n*6+0], vj,vi, ints[k].tmin/255.0f);
+				dtVlerp(&verts[n*6+3], vj,vi, ints[k].tmax/255.0f);
+				neis[n] = ints[k].ref;
+			}
+			n++;
+		}
+	}
+	return n;
+}
+
+
+dtWallSegmentCache::dtWallSegmentCache() :
+	m_nav(0),
+	m_tiles(0),
+	m_maxTiles(0)
+{
+}
+
+dtWallSegmentCache::~dtWallSegmentCache()
+{
+	for (int i = 0; i < m_maxTiles; ++i)
+		freeTile(m_tiles[i]);
+	dtFree(m_tiles);
+}
+
+int dtWallSegmentCache::getMemUsed() const
+{
+	int mem = sizeof(*this) + (int)dtAllocSize(m_tiles);
+	for (int i = 0; i < m_maxTiles; ++i)
+		mem += (int)dtAllocSize(m_tiles[i].neis);	// The tile's arrays share one allocation.
+	return mem;
+}
+
+bool dtWallSegmentCache::init(const dtNavMesh* nav)
+{
+	dtAssert(nav);
+
+	for (int i = 0; i < m_maxTiles; ++i)
+		freeTile(m_tiles[i]);
+	dtFree(m_tiles);
+	m_tiles = 0;
+	m_maxTiles = 0;
+
+	m_nav = nav;
+	const int maxTiles = nav->getMaxTiles();
+	m_tiles = (TileSegments*)dtAlloc(sizeof(TileSegments)*maxTiles, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+	if (!m_tiles)
+		return false;
+	memset(m_tiles, 0, sizeof(TileSegments)*maxTiles);
+	m_maxTiles = maxTiles;
+	
+	return true;
+}
+
+void dtWallSegmentCache::freeTile(TileSegments& ts)
+{
+	// The arrays share a single allocation.
+	dtFree(ts.neis);
+	memset(&ts, 0, sizeof(TileSegments));
+}
+
+bool dtWallSegmentCache::buildTile(TileSegments& ts, const dtMeshTile* tile, const dtTileRef ref)
+{
+	const int polyCount = tile->header->polyCount;
+	
+	int segCount = 0;
+	for (int i = 0; i < polyCount; ++i)
+	{
+		const dtPoly* poly = &tile->polys[i];
+		for (int j = 0; j < (int)poly->vertCount; ++j)
+			segCount += getEdgeSegments(m_nav, tile, poly, j, 0, 0);
+	}
+
+	// Allocate the largest elements first to keep them aligned.
+	const int neisSize = dtAlign4(sizeof(dtPolyRef)*segCount);
+	const int vertsSize = dtAlign4(sizeof(float)*6*segCount);
+	const int firstSize = dtAlign4(sizeof(int)*(polyCount+1));
+	const int edgesSize = dtAlign4(sizeof(unsigned char)*segCount);
+	unsigned char* data = (unsigned char*)dtAlloc(neisSize + vertsSize + firstSize + edgesSize, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+	if (!data)
+		return false;
+	
+	ts.ref = ref;
+	ts.tx = tile->header->x;
+	ts.ty = tile->header->y;
+	ts.polyCount = polyCount;
+	ts.segCount = segCount;
+	ts.neis = (dtPolyRef*)data; data += neisSize;
+	ts.verts = (float*)data; data += vertsSize;
+	ts.polyFirst = (int*)data; data += firstSize;
+	ts.edges = data;
+
+	int n = 0;
+	for (int i = 0; i < polyCount; ++i)
+	{
+		const dtPoly* poly = &tile->polys[i];
+		ts.polyFirst[i] = n;
+		for (int j = 0; j < (int)poly->vertCount; ++j)
+		{
+			const int nsegs = getEdgeSegments(m_nav, tile, poly, j, &ts.verts[n*6], &ts.neis[n]);
+			memset(&ts.edges[n], j, nsegs);
+			n += nsegs;
+		}
+	}
+	ts.polyFirst[polyCount] = n;
+	dtAssert(n == segCount);
+	
+	return true;
+}
+
+void dtWallSegmentCache::markNeighbours(const int tx, const int ty)
+{
+	static const int MAX_NEIS = 32;
+	const dtMeshTile* neis[MAX_NEIS];
+	
+	for (int y = ty-1; y <= ty+1; ++y)
+	{
+		for (int x = tx-1; x <= tx+1; ++x)
+		{
+			const int nneis = m_nav->getTilesAt(x, y, neis, MAX_NEIS);
+			for (int i = 0; i < nneis; ++i)
+				m_tiles[m_nav->decodePolyIdTile((dtPolyRef)m_nav->getTileRef(neis[i]))].dirty = true;
+		}
+	}
+}
+
+/// @par
+///
+/// Must be called after tiles are added to or removed from the mesh, and
+/// before #getPolyWallSegments is used.  It only checks the tile salts, so it
+/// is cheap when the mesh has not changed.  Not thread safe.
+void dtWallSegmentCache::update()
+{
+	// Find the tiles that were added or removed.
+	for (int i = 0; i < m_maxTiles; ++i)
+	{
+		const dtMeshTile* tile = m_nav->getTile(i);
+		const dtTileRef ref = tile->header ? m_nav->getTileRef(tile) : 0;
+		TileSegments& ts = m_tiles[i];
+		if (ts.ref == ref)
+			continue;
+		
+		ts.dirty = true;
+		if (ts.ref)
+			markNeighbours(ts.tx, ts.ty);
+		if (ref)
+			markNeighbours(tile->header->x, tile->header->y);
+	}
+	
+	for (int i = 0; i < m_maxTiles; ++i)
+	{
+		TileSegments& ts = m_tiles[i];
+		if (!ts.dirty)
+			continue;
+		
+		freeTile(ts);
+		const dtMeshTile* tile = m_nav->getTile(i);
+		if (tile->header)
+			buildTile(ts, tile, m_nav->getTileRef(tile));
+	}
+}
+
+/// @par
+///
+/// A portal is returned as a wall if the @p filter rejects the polygon it
+/// leads to.  Adjacent wall segments along an edge are merged, so the result
+/// matches dtNavMeshQuery::getPolyWallSegments.
+///
+/// Safe to call from several threads at once.
+dtStatus dtWallSegmentCache::getPolyWallSegments(dtPolyRef ref, const dtQueryFilter* filter,
+												 float* segmentVerts, int* segmentCount,
+												 const int maxSegments) const
+{
+	*segmentCount = 0;
+	
+	unsigned int salt, it, ip;
+	m_nav->decodePolyId(ref, salt, it, ip);
+	if ((int)it >= m_maxTiles)
+		return DT_FAILURE | DT_INVALID_PARAM;
+	const TileSegments& ts = m_tiles[it];
+	if (!ts.ref || m_nav->decodePolyIdSalt((dtPolyRef)ts.ref) != salt || (int)ip >= ts.polyCount)
+		return DT_FAILURE | DT_INVALID_PARAM;
+	
+	dtStatus status = DT_SUCCESS;
+	int n = 0;
+	bool extend = false;
+	for (int i = ts.polyFirst[ip]; i < ts.polyFirst[ip+1]; ++i)
+	{
+		const dtPolyRef nei = ts.neis[i];
+		if (nei)
+		{
+			const dtMeshTile* neiTile = 0;
+			const dtPoly* neiPoly = 0;
+			if (dtStatusSucceed(m_nav->getTileAndPolyByRef(nei, &neiTile, &neiPoly)) &&
+				filter->passFilter(nei, neiTile, neiPoly))
+			{
+				extend = false;
+				continue;
+			}
+		}
+		
+		const float* s = &ts.verts[i*6];
+		if (extend && ts.edges[i] == ts.edges[i-1])
+		{
+			// Continues the previous wall.
+			dtVcopy(&segmentVerts[(n-1)*6+3], s+3);
+			continue;
+		}
+		
+		if (n >= maxSegments)
+		{
+			status |= DT_BUFFER_TOO_SMALL;
+			extend = false;
+			continue;
+		}
+		
+		memcpy(&segmentVerts[n*6], s, sizeof(float)*6);
+		n++;
+		extend = true;
+	}
+	
+	*segmentCount = n;
+	
+	return status;
+}
@@ -0,0 +1,297 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifndef DETOURTILECACHE_H
+#define DETOURTILECACHE_H
+
+#include "DetourStatus.h"
+
+typedef unsigned int dtObstacleRef;
+
+typedef unsigned int dtCompressedTileRef;
+
+/// Flags for addTile
+enum dtCompressedTileFlags
+{
+	DT_COMPRESSEDTILE_FREE_DATA = 0x01,	///< Navmesh owns the tile memory and should free it.
+};
+
+struct dtCompressedTile
+{
+	unsigned int salt;						///< Counter describing modifications to the tile.
+	struct dtTileCacheLayerHeader* header;
+	unsigned char* compressed;
+	int compressedSize;
+	unsigned char* data;
+	int dataSize;
+	unsigned int flags;
+	dtCompressedTile* next;
+};
+
+enum ObstacleState
+{
+	DT_OBSTACLE_EMPTY,
+	DT_OBSTACLE_PROCESSING,
+	DT_OBSTACLE_PROCESSED,
+	DT_OBSTACLE_REMOVING,
+};
+
+enum ObstacleType
+{
+	DT_OBSTACLE_CYLINDER,
+	DT_OBSTACLE_BOX,
+};
+
+static const int DT_MAX_TOUCHED_TILES = 8;
+
+/// A runtime obstacle.  Cylinders use #pos, #radius and #height, boxes
+/// use #bmin and #bmax.
+struct dtTileCacheObstacle
+{
+	float pos[3], radius, height;
+	float bmin[3], bmax[3];
+	dtCompressedTileRef touched[DT_MAX_TOUCHED_TILES];
+	dtCompressedTileRef pending[DT_MAX_TOUCHED_TILES];
+	unsigned short salt;
+	unsigned char type;
+	unsigned char state;
+	unsigned char ntouched;
+	unsigned char npending;
+	dtTileCacheObstacle* next;
+};
+
+struct dtTileCacheParams
+{
+	float orig[3];
+	float cs, ch;
+	int width, height;
+	float walkableHeight;
+	float walkableRadius;
+	float walkableClimb;
+	float maxSimplificationError;
+	int maxTiles;
+	int maxObstacles;
+};
+
+/// Assigns the polygon areas and flags of a rebuilt tile before it is
+/// converted to navigation mesh data.
+struct dtTileCacheMeshProcess
+{
+	virtual ~dtTileCacheMeshProcess() { }
+
+	virtual void process(struct dtNavMeshCreateParams* params,
+						 unsigned char* polyAreas, unsigned short* polyFlags) = 0;
+};
+
+
+/// Stores compressed heightfield layers and rebuilds navigation mesh tiles
+/// from them when obstacles are added or removed.
+/// @ingroup detour
+class dtTileCache
+{
+public:
+	dtTileCache();
+	~dtTileCache();
+
+	struct dtTileCacheAlloc* getAlloc() { return m_talloc; }
+	struct dtTileCacheCompressor* getCompressor() { return m_tcomp; }
+	struct dtTileCacheMeshProcess* getMeshProcess() { return m_tmproc; }
+	const dtTileCacheParams* getParams() const { return &m_params; }
+
+	inline int getTileCount() const { return m_params.maxTiles; }
+	inline const dtCompressedTile* getTile(const int i) const { return &m_tiles[i]; }
+
+	inline int getObstacleCount() const { return m_params.maxObstacles; }
+	inline const dtTileCacheObstacle* getObstacle(const int i) const { return &m_obstacles[i]; }
+
+	const dtTileCacheObstacle* getObstacleByRef(dtObstacleRef ref);
+
+	dtObstacleRef getObstacleRef(const dtTileCacheObstacle* obmin) const;
+
+	/// Initializes the tile cache.
+	///  @param[in]	params	The tile cache parameters.
+	///  @param[in]	talloc	The allocator for the intermediate build data.
+	///  @param[in]	tcomp	The compressor for the layer data.
+	///  @param[in]	tmproc	The processor that assigns polygon areas and flags.
+	/// @return The status flags for the operation.
+	dtStatus init(const dtTileCacheParams* params,
+				  struct dtTileCacheAlloc* talloc,
+				  struct dtTileCacheCompressor* tcomp,
+				  struct dtTileCacheMeshProcess* tmproc);
+
+	int getTilesAt(const int tx, const int ty, dtCompressedTileRef* tiles, const int maxTiles) const ;
+
+	dtCompressedTile* getTileAt(const int tx, const int ty, const int tlayer);
+	dtCompressedTileRef getTileRef(const dtCompressedTile* tile) const;
+	const dtCompressedTile* getTileByRef(dtCompressedTileRef ref) const;
+
+	/// Adds a compressed layer to the cache.
+	///  @param[in]		data		The layer data created by #dtBuildTileCacheLayer.
+	///  @param[in]		dataSize	The size of the data.
+	///  @param[in]		flags		The tile flags. [Flags: #dtCompressedTileFlags]
+	///  @param[out]	result		The reference of the new tile. [opt]
+	/// @return The status flags for the operation.
+	dtStatus addTile(unsigned char* data, const int dataSize, unsigned char flags, dtCompressedTileRef* result);
+
+	dtStatus removeTile(dtCompressedTileRef ref, unsigned char** data, int* dataSize);
+
+	/// Requests a cylinder obstacle.  The affected tiles are rebuilt by #update.
+	dtStatus addObstacle(const float* pos, const float radius, const float height, dtObstacleRef* result);
+
+	/// Requests an axis-aligned box obstacle.  The affected tiles are rebuilt by #update.
+	dtStatus addBoxObstacle(const float* bmin, const float* bmax, dtObstacleRef* result);
+
+	dtStatus removeObstacle(const dtObstacleRef ref);
+
+	dtStatus queryTiles(const float* bmin, const float* bmax,
+						dtCompressedTileRef* results, int* resultCount, const int maxResults) const;
+
+	/// Processes the pending obstacle requests and rebuilds the affected tiles.
+	///  @param[in]		dt			The time step. (Not used.)
+	///  @param[in]		navmesh		The navigation mesh to update.
+	///  @param[out]	upToDate	True if no more rebuilds are pending. [opt]
+	///  @param[in]		maxTime		The build budget for this call. [Unit: us]
+	/// @return The status flags for the operation.
+	dtStatus update(const float dt, class dtNavMesh* navmesh, bool* upToDate = 0, const float maxTime = 0);
+
+	dtStatus buildNavMeshTilesAt(const int tx, const int ty, class dtNavMesh* navmesh);
+
+	dtStatus buildNavMeshTile(const dtCompressedTileRef ref, class dtNavMesh* navmesh);
+
+	void calcTightTileBounds(const struct dtTileCacheLayerHeader* header, float* bmin, float* bmax) const;
+
+	void getObstacleBounds(const struct dtTileCacheObstacle* ob, float* bmin, float* bmax) const;
+
+
+	/// Encodes a tile id.
+	inline dtCompressedTileRef encodeTileId(unsigned int salt, unsigned int it) const
+	{
+		return ((dtCompressedTileRef)salt << m_tileBits) | (dtCompressedTileRef)it;
+	}
+
+	/// Decodes a tile salt.
+	inline unsigned int decodeTileIdSalt(dtCompressedTileRef ref) const
+	{
+		const dtCompressedTileRef saltMask = ((dtCompressedTileRef)1<<m_saltBits)-1;
+		return (unsigned int)((ref >> m_tileBits) & saltMask);
+	}
+
+	/// Decodes a tile id.
+	inline unsigned int decodeTileIdTile(dtCompressedTileRef ref) const
+	{
+		const dtCompressedTileRef tileMask = ((dtCompressedTileRef)1<<m_tileBits)-1;
+		return (unsigned int)(ref & tileMask);
+	}
+
+	/// Encodes an obstacle id.
+	inline dtObstacleRef encodeObstacleId(unsigned int salt, unsigned int it) const
+	{
+		return ((dtObstacleRef)salt << 16) | (dtObstacleRef)it;
+	}
+
+	/// Decodes an obstacle salt.
+	inline unsigned int decodeObstacleIdSalt(dtObstacleRef ref) const
+	{
+		const dtObstacleRef saltMask = ((dtObstacleRef)1<<16)-1;
+		return (unsigned int)((ref >> 16) & saltMask);
+	}
+
+	/// Decodes an obstacle id.
+	inline unsigned int decodeObstacleIdObstacle(dtObstacleRef ref) const
+	{
+		const dtObstacleRef tileMask = ((dtObstacleRef)1<<16)-1;
+		return (unsigned int)(ref & tileMask);
+	}
+
+
+private:
+	// Explicitly disabled copy constructor and copy assignment operator.
+	dtTileCache(const dtTileCache&);
+	dtTileCache& operator=(const dtTileCache&);
+
+	enum ObstacleRequestAction
+	{
+		REQUEST_ADD,
+		REQUEST_REMOVE,
+	};
+
+	struct ObstacleRequest
+	{
+		int action;
+		dtObstacleRef ref;
+	};
+
+	dtStatus addObstacleRequest(dtTileCacheObstacle* ob, dtObstacleRef* result);
+
+	int m_tileLutSize;						///< Tile hash lookup size (must be pot).
+	int m_tileLutMask;						///< Tile hash lookup mask.
+
+	dtCompressedTile** m_posLookup;			///< Tile hash lookup.
+	dtCompressedTile* m_nextFreeTile;		///< Freelist of tiles.
+	dtCompressedTile* m_tiles;				///< List of tiles.
+
+	unsigned int m_saltBits;				///< Number of salt bits in the tile ID.
+	unsigned int m_tileBits;				///< Number of tile bits in the tile ID.
+
+	dtTileCacheParams m_params;
+
+	dtTileCacheAlloc* m_talloc;
+	dtTileCacheCompressor* m_tcomp;
+	dtTileCacheMeshProcess* m_tmproc;
+
+	dtTileCacheObstacle* m_obstacles;
+	dtTileCacheObstacle* m_nextFreeObstacle;
+
+	static const int MAX_REQUESTS = 64;
+	ObstacleRequest m_reqs[MAX_REQUESTS];
+	int m_nreqs;
+
+	static const int MAX_UPDATE = 64;
+	dtCompressedTileRef m_update[MAX_UPDATE];
+	int m_nupdate;
+};
+
+dtTileCache* dtAllocTileCache();
+void dtFreeTileCache(dtTileCache* tc);
+
+#endif // DETOURTILECACHE_H
+
+///////////////////////////////////////////////////////////////////////////
+
+// This section contains detailed documentation for members that don't have
+// a source file. It reduces clutter in the main section of the header.
+
+/**
+
+@class dtTileCache
+@par
+
+The tile cache holds the heightfield layers of a tiled navigation mesh in
+compressed form.  Obstacles mark the layer cells they cover as unwalkable,
+and the affected tiles are decompressed and rebuilt into navigation mesh
+tiles without running the full Recast build.
+
+Obstacle changes are queued and take effect during #update.  Each call to
+#update rebuilds one tile when @p maxTime is zero.  Otherwise it keeps
+rebuilding tiles until the time budget is spent, so callers can bound the
+cost of a server tick.
+
+The layers are normally built with rcBuildHeightfieldLayers and compressed
+with #dtBuildTileCacheLayer.
+
+*/
@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef CAI_DETOURCLUSTERGRAPHEX_H
+#define CAI_DETOURCLUSTERGRAPHEX_H
+
+#include "DetourNavMesh.h"
+#include "DetourNavMeshQuery.h"
+
+static const int RCN_CLUSTERGRAPH_MAGIC = 'R'<<24 | 'C'<<16 | 'N'<<8 | 'G';
+static const int RCN_CLUSTERGRAPH_VERSION = 1;
+
+// Serialized cluster graph header.  Each cluster follows as a
+// rcnClusterDataHeader and its arrays. (See: rcnClusterGraph::getData)
+struct rcnClusterGraphHeader
+{
+    int magic;
+    int version;
+    int polyRefSize;    // sizeof(dtPolyRef) of the writer.
+    int clusterSize;
+    int clusterCount;
+    int dataSize;       // The size of the entire blob.
+};
+
+struct rcnClusterDataHeader
+{
+    int x;
+    int y;
+    unsigned int signature;
+    int portalCount;
+    int linkCount;
+};
+
+// A precomputed abstract graph for long distance (hierarchical) path
+// planning.
+//
+// The tiles of the mesh are grouped into square clusters of clusterSize
+// tiles.  Polygons with links into another cluster are the portals of the
+// graph.  The graph stores the cost between each pair of portals within
+// a cluster, and the cost of each link between clusters.  A query plans
+// over the portals, then each segment of the result is refined with a
+// normal dtNavMeshQuery::findPath as it is needed. (See:
+// rcnRefineClusterPath)
+//
+// Portal costs are calculated with the filter passed to update and are
+// estimates for other filters.  Links are assumed to be traversable in
+// both directions.
+//
+// The graph is not updated automatically.  Call update after tiles are
+// added or removed.  Tile changes are detected from the tile references,
+// so changes to polygon flags and areas must be reported with
+// invalidateTile.
+//
+// Not thread safe.  Each query uses the graph's search buffers.
+class rcnClusterGraph
+{
+public:
+    rcnClusterGraph();
+    ~rcnClusterGraph();
+
+    // The mesh must outlive the graph.
+    dtStatus init(const dtNavMesh* navmesh, int clusterSize, int maxClusters);
+    void purge();
+
+    // Builds clusters for new tiles, rebuilds clusters with changed
+    // tiles (and their neighbors) and frees clusters with no tiles.
+    dtStatus update(const dtQueryFilter* filter, int* rebuildCount = 0);
+
+    // Forces the cluster containing the tile to be rebuilt on the next
+    // update.
+    void invalidateTile(int tx, int ty);
+
+    // Finds the portal waypoints from the start to the end polygon.
+    // The first and last waypoints are the start and end.
+    dtStatus findPath(dtPolyRef startRef
+        , dtPolyRef endRef
+        , const float* startPos
+        , const float* endPos
+        , const dtQueryFilter* filter
+        , dtPolyRef* waypoints
+        , float* waypointPositions
+        , int* waypointCount
+        , const int maxWaypoints);
+
+    // Serializes the graph.  Free the data with dtFree.
+    dtStatus getData(unsigned char** data, int* dataSize) const;
+
+    // Loads serialized clusters into an initialized graph.  Clusters that
+    // no longer match the mesh are rebuilt by the next update.
+    dtStatus load(const unsigned char* data, const int dataSize);
+
+    int getClusterCount() const { return m_clusterCount; }
+    int getPortalCount() const { return m_portalCount; }
+    int getClusterSize() const { return m_clusterSize; }
+
+private:
+    // Explicitly disabled copy constructor and copy assignment operator.
+    rcnClusterGraph(const rcnClusterGraph&);
+    rcnClusterGraph& operator=(const rcnClusterGraph&);
+
+    struct Cluster
+    {
+        int x;
+        int y;
+        unsigned int signature;
+        int portalCount;
+        int linkCount;
+        dtPolyRef* portals;     // [(ref) * portalCount] Sorted.
+        float* positions;       // [(x, y, z) * portalCount]
+        int* linkStart;         // [(index) * (portalCount + 1)]
+        dtPolyRef* links;       // [(ref) * linkCount] Polygons in other clusters.
+        float* linkCosts;       // [(cost) * linkCount]
+        float* costs;           // [(cost) * portalCount * portalCount]
+        int base;               // The index of the first portal in the search buffers.
+        int next;               // Next cluster in the lookup chain or free list.
+        bool used;
+        bool dirty;
+        bool seen;
+    };
+
+    int findCluster(int x, int y) const;
+    int allocCluster(int x, int y);
+    void freeCluster(int index);
+    void freeClusterData(Cluster& cluster);
+    int getClusterCoord(int t) const;
+    int findPolyCluster(dtPolyRef ref) const;
+    unsigned int calcSignature(const Cluster& cluster) const;
+    dtStatus buildCluster(Cluster& cluster, const dtQueryFilter* filter);
+    dtStatus reserveSearch(int maxNodes);
+    dtStatus reserveBuffers();
+    dtStatus searchCluster(const Cluster& cluster
+        , dtPolyRef startRef
+        , const float* startPos
+        , const dtQueryFilter* filter
+        , float* portalCosts
+        , dtPolyRef targetRef
+        , float* targetCost);
+
+    void heapPush(int node);
+    int heapPop();
+    void heapUpdate(int node);
+
+    const dtNavMesh* m_navmesh;
+    int m_clusterSize;
+
+    Cluster* m_clusters;
+    int m_maxClusters;
+    int m_clusterCount;
+    int m_nextFree;
+    int* m_lookup;
+    int m_lookupMask;
+
+    int m_portalCount;
+    int m_maxPortalsPerCluster;
+
+    // Cluster search.
+    class dtNodePool* m_nodePool;
+    class dtNodeQueue* m_openList;
+
+    // Abstract search. [Size: m_portalCount + 2]
+    int m_bufferSize;
+    float* m_g;
+    float* m_f;
+    int* m_parent;
+    int* m_nodeCluster;
+    int* m_heap;
+    int* m_heapIndex;
+    unsigned char* m_closed;
+    int m_heapSize;
+    float* m_startCosts;    // [Size: m_maxPortalsPerCluster]
+    float* m_endCosts;
+};
+
+rcnClusterGraph* rcnAllocClusterGraph();
+void rcnFreeClusterGraph(rcnClusterGraph* graph);
+
+// Refines a segment range of a rcnClusterGraph path into a polygon
+// corridor.
+//
+// Segment i runs from waypoint i to waypoint i + 1.  Up to maxSegments
+// segments are refined, starting with firstSegment.  The index of the
+// first segment that was not refined is returned in nextSegment.  (The
+// refinement is complete when it equals waypointCount - 1.)  Refinement
+// stops early if a segment search fails, or is partial.
+dtStatus rcnRefineClusterPath(const dtNavMeshQuery* query
+    , const dtQueryFilter* filter
+    , const dtPolyRef* waypoints
+    , const float* waypointPositions
+    , const int waypointCount
+    , const int firstSegment
+    , const int maxSegments
+    , dtPolyRef* path
+    , int* pathCount
+    , const int maxPath
+    , int* nextSegment);
+
+#endif
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef CAI_DETOURCROWDSCHEDULEREX_H
+#define CAI_DETOURCROWDSCHEDULEREX_H
+
+#include "DetourCrowd.h"
+#include "DetourThreadPoolEx.h"
+
+// Runs after a crowd's update, on the worker thread that updated it.
+typedef void (*rcnCrowdTickFunc)(void* userData, int crowdIndex, dtCrowd* crowd);
+
+// Updates many crowds at once over a pool of worker threads.
+//
+// Each crowd is one task.  The crowds are started heaviest first, by the 
+// time of their previous update, and dealt across the workers' initial
+// task shares so that every worker starts on a busy crowd.  A worker that 
+// runs out of crowds steals from the others, so a few heavily populated 
+// crowds do not hold up the quiet ones.
+//
+// The crowds may share a navigation mesh, but must not share a task 
+// scheduler, path cache or flow field cache, and the mesh must not be
+// modified during an update.  (Unless concurrent reads are enabled on it.)
+//
+// The scheduler is not thread-safe.  Crowds must not be added, removed or 
+// updated elsewhere while update is running.
+class rcnCrowdScheduler
+{
+public:
+    rcnCrowdScheduler();
+    ~rcnCrowdScheduler();
+
+    // The thread count is the number of threads in addition to the calling 
+    // thread, which always participates.  Zero is valid. (Serial.)
+    dtStatus init(int maxCrowds, int threadCount);
+    void purge();
+
+    // Returns the index of the crowd, or -1 if the scheduler is full, the
+    // crowd is already registered, or it shares a task scheduler or cache 
+    // with a registered crowd.  The crowd is not owned.
+    int addCrowd(dtCrowd* crowd);
+
+    // The crowds after the removed one move down one index.
+    bool removeCrowd(const dtCrowd* crowd);
+
+    // Returns -1 if the crowd is not registered.
+    int findCrowd(const dtCrowd* crowd) const;
+
+    int getCrowdCount() const { return m_crowdCount; }
+    int getMaxCrowds() const { return m_maxCrowds; }
+    dtCrowd* getCrowd(int index) const 
+    { 
+        return (index >= 0 && index < m_crowdCount) ? m_crowds[index] : 0; 
+    }
+
+    int getWorkerCount() const { return m_pool.getWorkerCount(); }
+
+    // Updates every crowd, then returns.  The tick function, if provided,
+    // runs for each crowd right after its update.
+    void update(float dt, rcnCrowdTickFunc func, void* userData);
+
+    // The duration of the crowd's last update, including the tick function.
+    // [Unit: Microseconds]
+    float getTickTime(int index) const 
+    { 
+        return (index >= 0 && index < m_crowdCount) ? m_tickTimes[index] : 0; 
+    }
+
+    // The duration of the last update call. [Unit: Microseconds]
+    float getLastUpdateTime() const { return m_lastUpdateTime; }
+
+private:
+    // Explicitly disabled copy constructor and copy assignment operator.
+    rcnCrowdScheduler(const rcnCrowdScheduler&);
+    rcnCrowdScheduler& operator=(const rcnCrowdScheduler&);
+
+    static void runTask(void* userData, int taskIndex, int workerIndex);
+
+    void orderTasks();
+
+    rcnThreadPool m_pool;
+
+    dtCrowd** m_crowds;
+    float* m_tickTimes;     // Per crowd.
+    int* m_taskCrowds;      // The crowd run by each task index.
+    int* m_sortedCrowds;    // Scratch for orderTasks.
+    int m_crowdCount;
+    int m_maxCrowds;
+
+    rcnCrowdTickFunc m_tickFunc;
+    void* m_tickUserData;
+    float m_dt;
+
+    float m_lastUpdateTime;
+};
+
+rcnCrowdScheduler* rcnAllocCrowdScheduler();
+void rcnFreeCrowdScheduler(rcnCrowdScheduler* scheduler);
+
+#endif
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef CAI_DETOURCROWDSTREAMEX_H
+#define CAI_DETOURCROWDSTREAMEX_H
+
+#include "DetourCrowd.h"
+
+// The replicated state of a crowd agent, as decoded from a state stream.
+// All zero for an inactive agent.
+struct rcnReplicatedAgentState
+{
+    unsigned char state;    // The agent state. (See: CrowdAgentState)
+    dtPolyRef polyRef;      // The polygon that contains the position.
+    float position[3];
+    float velocity[3];
+};
+
+// Stream flags.
+static const unsigned char RCN_STREAM_KEYFRAME = 0x01;  // The baseline was reset.
+
+// The quantized state last written for an agent.
+struct rcnStreamAgentBaseline
+{
+    int position[3];
+    int velocity[3];
+    dtPolyRef polyRef;
+    unsigned char state;
+};
+
+// Writes a compact stream of the agent state changes of a crowd, for
+// network replication.
+//
+// The positions and velocities are quantized to the configured precision 
+// and compared to the values last written for the agent.  Only the agents
+// that changed are written, and only the fields that changed.  The values
+// are written as variable length deltas from the last written values, so
+// a slow moving agent costs a few bytes.
+//
+// Stream layout: A flags byte (RCN_STREAM_KEYFRAME), the record count as 
+// a 32-bit little endian integer, then the records.  Each record is the 
+// zigzag varint of the agent index minus the index after the previous
+// record, a field mask byte, then the fields in mask order:
+//
+// - 0x01: The state byte. (Zero for inactive agents.)
+// - 0x02: The varint of the polygon reference.
+// - 0x04: The zigzag varints of the quantized position delta. (x, y, z)
+// - 0x08: The zigzag varints of the quantized velocity delta. (x, y, z)
+//
+// Each stream is relative to the one before it, so the receiver must 
+// apply every stream in order with a matching rcnCrowdStateDecoder.  Call 
+// reset to resynchronize.  (E.g. for a new receiver.)
+class rcnCrowdStateEncoder
+{
+public:
+    rcnCrowdStateEncoder();
+    ~rcnCrowdStateEncoder();
+
+    // The precisions are the quantization steps in world units. 
+    // (E.g. 0.01 for centimeters.)
+    dtStatus init(int maxAgents, float positionPrecision, float velocityPrecision);
+    void purge();
+
+    // Starts over from an empty baseline.  The next stream is flagged as a
+    // keyframe and holds every active agent.
+    void reset();
+
+    // Writes the changes since the previous stream.  When the buffer fills,
+    // the call stops with DT_BUFFER_TOO_SMALL and the agents that did not 
+    // fit are written by the next call, which starts where this one 
+    // stopped.
+    dtStatus write(dtCrowd* crowd
+        , unsigned char* stream
+        , int maxSize
+        , int* size
+        , int* agentCount);
+
+    int getMaxAgents() const { return m_maxAgents; }
+    float getPositionPrecision() const { return m_posPrecision; }
+    float getVelocityPrecision() const { return m_velPrecision; }
+
+private:
+    // Explicitly disabled copy constructor and copy assignment operator.
+    rcnCrowdStateEncoder(const rcnCrowdStateEncoder&);
+    rcnCrowdStateEncoder& operator=(const rcnCrowdStateEncoder&);
+
+    rcnStreamAgentBaseline* m_baseline;
+    int m_maxAgents;
+    int m_nextAgent;        // Where the next write starts.
+    float m_posPrecision;
+    float m_velPrecision;
+    bool m_keyframe;
+};
+
+// Applies the streams written by a rcnCrowdStateEncoder.
+class rcnCrowdStateDecoder
+{
+public:
+    rcnCrowdStateDecoder();
+    ~rcnCrowdStateDecoder();
+
+    // Must match the encoder.
+    dtStatus init(int maxAgents, float positionPrecision, float velocityPrecision);
+    void purge();
+
+    // Applies a stream to per agent states. [(state) * maxAgents]
+    // A keyframe clears all states first.  The bit of each agent that
+    // changed is set in the optional dirty mask.  [((maxAgents + 31) / 32)]
+    // The states are unchanged if the stream is malformed.
+    dtStatus read(const unsigned char* stream
+        , int size
+        , rcnReplicatedAgentState* states
+        , unsigned int* dirtyMask);
+
+    int getMaxAgents() const { return m_maxAgents; }
+
+private:
+    // Explicitly disabled copy constructor and copy assignment operator.
+    rcnCrowdStateDecoder(const rcnCrowdStateDecoder&);
+    rcnCrowdStateDecoder& operator=(const rcnCrowdStateDecoder&);
+
+    // Reads the stream, applying it if the states are provided.
+    bool parse(const unsigned char* stream
+        , int size
+        , rcnReplicatedAgentState* states
+        , unsigned int* dirtyMask);
+
+    rcnStreamAgentBaseline* m_baseline;
+    int m_maxAgents;
+    float m_posPrecision;
+    float m_velPrecision;
+};
+
+rcnCrowdStateEncoder* rcnAllocCrowdStateEncoder();
+void rcnFreeCrowdStateEncoder(rcnCrowdStateEncoder* encoder);
+
+rcnCrowdStateDecoder* rcnAllocCrowdStateDecoder();
+void rcnFreeCrowdStateDecoder(rcnCrowdStateDecoder* decoder);
+
+#endif
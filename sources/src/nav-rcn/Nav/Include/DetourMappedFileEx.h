@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef CAI_DETOURMAPPEDFILEEX_H
+#define CAI_DETOURMAPPEDFILEEX_H
+
+#include <stddef.h>
+
+// A private (copy-on-write) view of a file.
+//
+// Pages are shared between all processes that map the same file until
+// one of them writes to a page.  Detour writes links and polygon state 
+// into tile data, so only those sections of a tile are ever duplicated.
+struct rcnMappedFile
+{
+    unsigned char* data;
+    size_t dataSize;
+
+    // Platform specific handles.
+    void* fileHandle;
+    void* mapHandle;
+};
+
+// Maps the entire file into memory.  Returns false if the file could
+// not be opened or mapped.  On success the view must be released with 
+// rcnUnmapFile.
+bool rcnMapFile(const char* path, rcnMappedFile* file);
+
+// Releases a view created by rcnMapFile.  Safe to call on a zeroed or
+// already released file.
+void rcnUnmapFile(rcnMappedFile* file);
+
+#endif
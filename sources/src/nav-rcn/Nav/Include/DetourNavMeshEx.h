@@ -31,4 +31,50 @@ struct rcnTileData
     bool isOwned;
 };
 
+// A read-only view of the sections of a tile owned by a navigation mesh.
+//
+// The pointers reference the tile's memory directly and are only valid 
+// until the tile is removed from, or replaced in, the mesh.  Strides are the 
+// size in bytes of one element of the section. (E.g. One vertex.)
+//
+// Compact tiles have no float detail vertices.  For them detailVerts is null
+// and detailQuantVerts/detailQuantParams reference the quantized vertices.
+// Vertices on polygon edges are stored relative to the edge, so use 
+// dtnmGetTileDetailVerts if decoded vertices are required.
+struct rcnNavmeshTileView
+{
+    const dtMeshHeader* header;
+    const dtPoly* polys;
+    const float* verts;
+    const dtLink* links;
+    const dtPolyDetail* detailMeshes;
+    const float* detailVerts;
+    const unsigned short* detailQuantVerts;
+    const float* detailQuantParams;
+    const unsigned char* detailTris;
+    const dtBVNode* bvTree;
+    const dtOffMeshConnection* offMeshCons;
+
+    dtTileRef tileRef;
+    dtPolyRef polyRefBase;
+
+    int polyCount;
+    int vertCount;
+    int linkCount;
+    int detailMeshCount;
+    int detailVertCount;
+    int detailTriCount;
+    int bvNodeCount;
+    int offMeshConCount;
+
+    int polyStride;
+    int vertStride;
+    int linkStride;
+    int detailMeshStride;
+    int detailVertStride;
+    int detailTriStride;
+    int bvNodeStride;
+    int offMeshConStride;
+};
+
 #endif
\ No newline at end of file
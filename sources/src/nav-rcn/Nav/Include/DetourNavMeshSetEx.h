@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef CAI_DETOURNAVMESHSETEX_H
+#define CAI_DETOURNAVMESHSETEX_H
+
+#include "DetourNavMesh.h"
+
+// Serialized navigation mesh (tile set) formats.
+//
+// Version 1: A rcnNavMeshSetHeader followed by (rcnNavMeshTileHeader, tile
+// data) pairs packed back to back.  Must be read in order.
+//
+// Version 2 (indexed): A rcnNavMeshIndexHeader, followed by a table of
+// rcnNavMeshTileIndex entries, followed by the tile data.  Each tile's
+// data starts on a RCN_NAVMESH_TILE_ALIGN boundary (relative to the start 
+// of the blob) and is protected by a CRC-32.  Tiles can be located, 
+// validated and loaded independently.
+//
+// Both formats store tile references, so builds using 64-bit references
+// (DT_POLYREF64) write their own versions and neither build loads the 
+// other's blobs.
+
+static const long RCN_NAVMESH_VERSION = DT_POLYREF_VERSION_FLAG | 1;
+static const int RCN_NAVMESH_INDEXED_VERSION = DT_POLYREF_VERSION_FLAG | 2;
+
+static const int RCN_NAVMESH_MAGIC = 'R'<<24 | 'C'<<16 | 'N'<<8 | 'S';
+
+// The alignment of tile data in indexed blobs.
+static const int RCN_NAVMESH_TILE_ALIGN = 16;
+
+struct rcnNavMeshSetHeader
+{
+    long version;
+    int tileCount;
+    dtNavMeshParams params;
+};
+
+struct rcnNavMeshTileHeader
+{
+	dtTileRef tileRef;
+	int dataSize;
+};
+
+struct rcnNavMeshIndexHeader
+{
+    // Important: Version must be the first field. (Version detection.)
+    int version;
+    int magic;
+    int tileCount;
+    int tableOffset;    // Offset of the tile table.
+    dtNavMeshParams params;
+    int dataSize;       // The size of the entire blob.
+};
+
+struct rcnNavMeshTileIndex
+{
+    dtTileRef tileRef;
+    int x;
+    int y;
+    int layer;
+    int dataOffset;     // Offset of the tile data from the start of the blob.
+    int dataSize;
+    unsigned int crc;   // CRC-32 of the tile data.
+};
+
+inline int rcnAlignTileData(int value)
+{
+    return (value + (RCN_NAVMESH_TILE_ALIGN - 1)) & ~(RCN_NAVMESH_TILE_ALIGN - 1);
+}
+
+// Calculates the CRC-32 (IEEE 802.3) of the data.  Pass the result of
+// a previous call as crc to continue a calculation.
+unsigned int rcnCalcCrc32(const unsigned char* data
+    , const int dataSize
+    , unsigned int crc = 0);
+
+// Returns the format version of the blob, or zero if the blob is not 
+// a recognized navigation mesh set.
+int rcnGetNavMeshSetVersion(const unsigned char* data, const int dataSize);
+
+// Validates the header and tile table of an indexed blob.  Does not
+// validate the tile data. (See: rcnValidateNavMeshTile)
+// Returns the tile table, or null if the blob is not valid.
+const rcnNavMeshTileIndex* rcnGetNavMeshTileTable(const unsigned char* data
+    , const int dataSize);
+
+// Validates the fields of an indexed blob header.  Does not check the
+// header's data size against the available data.
+bool rcnValidateNavMeshIndexHeader(const rcnNavMeshIndexHeader& header);
+
+// Validates the entries of a tile table against the blob header.  
+// (For loaders that read the table separately from the rest of the blob.)
+bool rcnValidateNavMeshTileTable(const rcnNavMeshIndexHeader& header
+    , const rcnNavMeshTileIndex* table);
+
+// Returns true if the tile data matches its index entry.
+bool rcnValidateNavMeshTile(const rcnNavMeshTileIndex& entry
+    , const unsigned char* tileData);
+
+#endif
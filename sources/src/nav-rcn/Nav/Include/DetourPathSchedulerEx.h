@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef CAI_DETOURPATHSCHEDULEREX_H
+#define CAI_DETOURPATHSCHEDULEREX_H
+
+#include "DetourNavMeshQuery.h"
+#include "DetourPathQueue.h"
+#include "DetourEx.h"
+
+class dtPathCache;
+
+// A path request id.  Zero is never a valid id.
+typedef unsigned int rcnPathTicket;
+
+static const rcnPathTicket RCN_PATH_TICKET_INVALID = 0;
+
+// The largest number of requests a scheduler can hold.  (The slot index 
+// is stored in the low bits of the ticket.)
+static const int RCN_PATHSCHED_MAX_REQUESTS = 0xffff;
+
+// Runs many sliced path searches at once over a pool of query objects.
+//
+// Like dtPathQueue, but with more than one search in flight and without 
+// the need for a dtCrowd.  Each query object runs one sliced search at a
+// time. A pump call shares its iteration budget between the running 
+// searches, starts queued requests on the queries that become free, and
+// reports the tickets of the requests that completed.
+//
+// Requests are started highest priority first, oldest first among equals.
+// A completed request holds its slot until its result is read with 
+// getPathResult or it is cancelled.
+//
+// The statistics use the dtPathQueue structure.  Wait times are measured
+// in pump calls.
+//
+// The mesh must not be modified while searches are in flight, and each 
+// request's filter must stay valid until the request completes.
+class rcnPathScheduler
+{
+public:
+    rcnPathScheduler();
+    ~rcnPathScheduler();
+
+    // sliceCount is the number of searches that can be in flight at once.
+    // maxRequests is the number of queued, running and completed requests
+    // that can be held at once.
+    dtStatus init(const dtNavMesh* navmesh
+        , int maxNodes
+        , int sliceCount
+        , int maxRequests
+        , int maxPathSize);
+    void purge();
+
+    // Returns RCN_PATH_TICKET_INVALID if the scheduler is full.
+    // options are the sliced query options. (See: dtFindPathOptions)
+    rcnPathTicket request(const rcnNavmeshPoint& start
+        , const rcnNavmeshPoint& end
+        , const dtQueryFilter* filter
+        , float priority
+        , unsigned int options);
+
+    // Advances the searches by up to maxIters iterations and maxTime 
+    // microseconds.  A zero or negative value removes that limit, but at
+    // least one must be set.
+    //
+    // The tickets of the requests that completed during the call are 
+    // written to completed.  The call stops early, with 
+    // DT_BUFFER_TOO_SMALL, when the buffer is full.  The remaining
+    // completions are reported by the next call.
+    dtStatus pump(int maxIters
+        , float maxTime
+        , rcnPathTicket* completed
+        , int maxCompleted
+        , int* completedCount);
+
+    // Returns zero for a request that has not completed.
+    dtStatus getRequestStatus(rcnPathTicket ticket) const;
+
+    // Copies the path of a completed request and frees its slot.
+    // Returns the status of the search, with DT_BUFFER_TOO_SMALL added if
+    // the path was truncated, or DT_IN_PROGRESS if it has not completed.
+    dtStatus getPathResult(rcnPathTicket ticket
+        , dtPolyRef* path
+        , int* pathCount
+        , int maxPath);
+
+    // Frees the request's slot, stopping its search if it is running.
+    dtStatus cancel(rcnPathTicket ticket);
+
+    // Requests that have a cached path complete without a search, and 
+    // complete searches are stored in the cache.  (Null disables.)
+    // The cache must outlive the scheduler or be removed first.
+    void setPathCache(dtPathCache* cache) { m_cache = cache; }
+
+    int getSliceCount() const { return m_sliceCount; }
+    int getMaxRequests() const { return m_maxRequests; }
+    int getMaxPathSize() const { return m_maxPathSize; }
+
+    void getStats(dtPathQueueStats* stats) const;
+    void resetStats();
+
+private:
+    // Explicitly disabled copy constructor and copy assignment operator.
+    rcnPathScheduler(const rcnPathScheduler&);
+    rcnPathScheduler& operator=(const rcnPathScheduler&);
+
+    enum RequestState
+    {
+        REQUEST_FREE = 0,
+        REQUEST_QUEUED,
+        REQUEST_RUNNING,
+        REQUEST_DONE
+    };
+
+    struct Request
+    {
+        rcnNavmeshPoint start;
+        rcnNavmeshPoint end;
+        const dtQueryFilter* filter;
+        unsigned int options;
+        float priority;
+        unsigned int sequence;
+        unsigned int requestTick;
+        dtStatus status;
+        int pathCount;
+        int slice;           // The query running the search, or -1.
+        unsigned short salt; // Never zero.
+        unsigned char state;
+        bool reported;
+    };
+
+    rcnPathTicket getTicket(int slot) const;
+    int findSlot(rcnPathTicket ticket) const;
+    int findNextRequest() const;
+    void startRequest(int slot, int slice);
+    void finishRequest(int slot);
+    void freeRequest(int slot);
+    void report(int slot
+        , rcnPathTicket* completed
+        , int maxCompleted
+        , int* count);
+
+    dtNavMeshQuery** m_queries;
+    int* m_sliceOwners;          // The request running on each query, or -1.
+    int m_sliceCount;
+    int m_nextSlice;             // Where the next pump starts its rotation.
+
+    Request* m_requests;
+    dtPolyRef* m_paths;          // maxPathSize references per request.
+    int m_maxRequests;
+    int m_maxPathSize;
+    int* m_freeSlots;
+    int m_freeCount;
+    int m_queuedCount;
+    unsigned int m_nextSequence;
+    unsigned int m_tick;
+
+    dtPathCache* m_cache;
+
+    int m_maxPendingCount;
+    int m_rejectedCount;
+    int m_completedCount;
+    int m_maxWaitTicks;
+    unsigned int m_totalWaitTicks;
+    int m_lastIterCount;
+    float m_lastUpdateTime;
+};
+
+rcnPathScheduler* rcnAllocPathScheduler();
+void rcnFreePathScheduler(rcnPathScheduler* scheduler);
+
+#endif
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef CAI_DETOURPATHSOLVEREX_H
+#define CAI_DETOURPATHSOLVEREX_H
+
+#include "DetourNavMeshQuery.h"
+#include "DetourEx.h"
+#include "DetourThreadPoolEx.h"
+
+struct rcnPathRequest
+{
+    rcnNavmeshPoint start;
+    rcnNavmeshPoint end;
+    int filterIndex;
+};
+
+struct rcnPathResult
+{
+    // The status of the path search.  If a straight path was requested
+    // and its search failed, the status of the straight path search.
+    dtStatus status;
+    int pathCount;
+    int straightPathCount;
+};
+
+// Solves batches of path requests across a pool of threads.
+//
+// Each worker has its own query object (and so its own node pool), all
+// against the same navigation mesh.  The mesh and the filters must not be
+// modified while a batch is being solved.
+class rcnPathSolver
+{
+public:
+    rcnPathSolver();
+    ~rcnPathSolver();
+
+    // A thread count of zero solves on the calling thread only.
+    dtStatus init(const dtNavMesh* navmesh, int maxNodes, int threadCount);
+    void purge();
+
+    // Solves all requests and returns when they are complete.
+    //
+    // The outputs are fixed size slots, one per request: paths holds 
+    // maxPath references per request and straightPaths holds 
+    // maxStraightPath points (3 floats) per request.  The straight path
+    // is optional.  (Null straightPaths.)
+    dtStatus solve(const rcnPathRequest* requests
+        , const int requestCount
+        , const dtQueryFilter* const* filters
+        , const int filterCount
+        , dtPolyRef* paths
+        , const int maxPath
+        , float* straightPaths
+        , const int maxStraightPath
+        , rcnPathResult* results);
+
+    int getWorkerCount() const { return m_queryCount; }
+
+private:
+    // Explicitly disabled copy constructor and copy assignment operator.
+    rcnPathSolver(const rcnPathSolver&);
+    rcnPathSolver& operator=(const rcnPathSolver&);
+
+    rcnThreadPool m_pool;
+    dtNavMeshQuery** m_queries;   // One per worker.
+    int m_queryCount;
+};
+
+rcnPathSolver* rcnAllocPathSolver();
+void rcnFreePathSolver(rcnPathSolver* solver);
+
+#endif
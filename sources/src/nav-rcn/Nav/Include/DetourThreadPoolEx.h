@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef CAI_DETOURTHREADPOOLEX_H
+#define CAI_DETOURTHREADPOOLEX_H
+
+#include "DetourTaskScheduler.h"
+
+// Runs a task.  The worker index is in the range [0, getWorkerCount()) and 
+// is unique among the tasks running at the same time, so it can be used to
+// select per-thread resources.
+typedef dtTaskFunc rcnTaskFunc;
+
+struct rcnThreadPoolState;
+
+// A fixed size pool of worker threads for running parallel loops.
+//
+// Each worker starts with an even share of the task indices.  A worker that
+// runs out steals half of the remaining indices of another worker, so
+// uneven task costs still keep all workers busy.
+//
+// The pool is not reentrant: Only one thread may call parallelFor at a
+// time, and tasks must not call parallelFor.
+class rcnThreadPool
+    : public dtTaskScheduler
+{
+public:
+    rcnThreadPool();
+    ~rcnThreadPool();
+
+    // The thread count is the number of threads in addition to the calling 
+    // thread, which always participates.  Zero is valid. (Serial.)
+    bool init(int threadCount);
+    void purge();
+
+    virtual int getWorkerCount() const { return m_threadCount + 1; }
+
+    // Runs the task for each index in [0, taskCount) and returns once all 
+    // tasks are complete.
+    virtual void parallelFor(rcnTaskFunc func, void* userData, int taskCount);
+
+private:
+    // Explicitly disabled copy constructor and copy assignment operator.
+    rcnThreadPool(const rcnThreadPool&);
+    rcnThreadPool& operator=(const rcnThreadPool&);
+
+    rcnThreadPoolState* m_state;
+    int m_threadCount;
+};
+
+// Returns the number of logical processors.  (At least one.)
+int rcnGetProcessorCount();
+
+#endif
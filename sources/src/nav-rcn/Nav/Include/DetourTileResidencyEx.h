@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef CAI_DETOURTILERESIDENCYEX_H
+#define CAI_DETOURTILERESIDENCYEX_H
+
+#include <stdio.h>
+#include "DetourNavMesh.h"
+#include "DetourNavMeshSetEx.h"
+
+struct rcnTileResidencyStats
+{
+    int tileCount;      // Tiles in the file.
+    int residentCount;  // Tiles currently in the mesh.
+    int residentSize;   // Bytes of tile data currently in the mesh.
+    int memoryBudget;
+    int loadCount;      // Total loads since init.
+    int evictCount;     // Total evictions since init.
+    int failedCount;    // Tiles that failed validation. (Never retried.)
+};
+
+// Keeps the tiles around a set of points of interest resident in a 
+// navigation mesh, streaming them from an indexed navigation mesh set
+// file.  (See: DetourNavMeshSetEx.h)
+//
+// Tiles that are not near any point stay resident until the memory budget
+// is needed for other tiles, then they are evicted least recently used
+// first.  Tile references are stable across evictions, and the tile
+// state (polygon flags and areas) is stored on eviction and restored on 
+// reload.
+//
+// The manager owns the navigation mesh.  Tiles must not be added to or
+// removed from the mesh by other means.
+class rcnTileResidency
+{
+public:
+    rcnTileResidency();
+    ~rcnTileResidency();
+
+    // The file stays open until the manager is freed.
+    dtStatus init(const char* filePath, int maxPoints, int memoryBudget);
+
+    // Tiles overlapping the radius (xz-plane) around the point are wanted.
+    bool setPoint(int index, const float* pos, float radius);
+    void clearPoint(int index);
+
+    void setMemoryBudget(int memoryBudget) { m_memoryBudget = memoryBudget; }
+
+    // Loads wanted tiles, nearest first, evicting as needed. No more 
+    // than maxLoads tiles are loaded per call. (Or all if maxLoads <= 0.)
+    // Returns DT_IN_PROGRESS if wanted tiles remain due to maxLoads.
+    // Returns DT_BUFFER_TOO_SMALL detail if the budget can't fit all 
+    // wanted tiles.
+    dtStatus update(int maxLoads);
+
+    dtNavMesh* getNavMesh() { return m_navmesh; }
+    const dtNavMesh* getNavMesh() const { return m_navmesh; }
+
+    void getStats(rcnTileResidencyStats* stats) const;
+
+private:
+    // Explicitly disabled copy constructor and copy assignment operator.
+    rcnTileResidency(const rcnTileResidency&);
+    rcnTileResidency& operator=(const rcnTileResidency&);
+
+    struct TileInfo
+    {
+        unsigned char* state;
+        int stateSize;
+        int lastUsed;       // The update frame the tile was last wanted.
+        int nextInLookup;
+        int prev;           // LRU list. (Resident tiles only.)
+        int next;
+        float priority;     // Squared distance to the nearest point.
+        bool resident;
+        bool failed;
+    };
+
+    struct Point
+    {
+        float pos[3];
+        float radius;
+        bool active;
+    };
+
+    struct PendingTile
+    {
+        int tile;
+        float priority;
+    };
+
+    static int comparePending(const void* va, const void* vb);
+
+    void purge();
+    void touch(int tile);
+    void unlinkLru(int tile);
+    bool evictLru();
+    dtStatus loadTile(int tile);
+    void wantTiles(const Point& point);
+
+    FILE* m_file;
+    dtNavMesh* m_navmesh;
+
+    rcnNavMeshTileIndex* m_table;
+    TileInfo* m_tiles;
+    int m_tileCount;
+
+    int* m_lookup;
+    int m_lookupMask;
+
+    Point* m_points;
+    int m_maxPoints;
+
+    PendingTile* m_pending;
+
+    int m_lruHead;          // Most recently used.
+    int m_lruTail;
+
+    int m_frame;
+    int m_memoryBudget;
+    int m_residentSize;
+    int m_residentCount;
+    int m_loadCount;
+    int m_evictCount;
+    int m_failedCount;
+};
+
+rcnTileResidency* rcnAllocTileResidency();
+void rcnFreeTileResidency(rcnTileResidency* residency);
+
+#endif
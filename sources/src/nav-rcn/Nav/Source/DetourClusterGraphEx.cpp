@@ -0,0 +1,1541 @@
+/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <string.h>
+#include <stdlib.h>
+#include <float.h>
+#include <new>
+#include "DetourClusterGraphEx.h"
+#include "DetourNode.h"
+#include "DetourCommon.h"
+#include "DetourEx.h"
+
+static const float H_SCALE = 0.999f; // Same as dtNavMeshQuery.
+
+// The most layers gathered per tile location.
+static const int MAX_CLUSTER_LAYERS = 32;
+
+inline int computeClusterHash(int x, int y, const int mask)
+{
+    const unsigned int h1 = 0x8da6b343; // Same as dtNavMesh.
+    const unsigned int h2 = 0xd8163841;
+    unsigned int n = h1 * x + h2 * y;
+    return (int)(n & mask);
+}
+
+static void calcPolyCenter(const dtMeshTile* tile, const dtPoly* poly, float* center)
+{
+    center[0] = 0;
+    center[1] = 0;
+    center[2] = 0;
+    for (int i = 0; i < (int)poly->vertCount; ++i)
+        dtVadd(center, center, &tile->verts[poly->verts[i]*3]);
+    dtVscale(center, center, 1.0f / (float)poly->vertCount);
+}
+
+static int findPortal(const dtPolyRef* portals, const int count, const dtPolyRef ref)
+{
+    int lo = 0;
+    int hi = count - 1;
+    while (lo <= hi)
+    {
+        const int mid = (lo + hi) / 2;
+        if (portals[mid] == ref)
+            return mid;
+        if (portals[mid] < ref)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+    return -1;
+}
+
+struct rcnPortalLink
+{
+    dtPolyRef ref;
+    dtPolyRef nref;
+    float cost;
+};
+
+static int comparePortalLinks(const void* va, const void* vb)
+{
+    const rcnPortalLink* a = (const rcnPortalLink*)va;
+    const rcnPortalLink* b = (const rcnPortalLink*)vb;
+    if (a->ref != b->ref)
+        return a->ref < b->ref ? -1 : 1;
+    if (a->nref != b->nref)
+        return a->nref < b->nref ? -1 : 1;
+    return 0;
+}
+
+rcnClusterGraph* rcnAllocClusterGraph()
+{
+    void* mem = dtAlloc(sizeof(rcnClusterGraph), DT_ALLOC_PERM, DT_ALLOC_TAG_CLUSTERS);
+    if (!mem) return 0;
+    return new(mem) rcnClusterGraph;
+}
+
+void rcnFreeClusterGraph(rcnClusterGraph* graph)
+{
+    if (!graph) return;
+    graph->~rcnClusterGraph();
+    dtFree(graph);
+}
+
+rcnClusterGraph::rcnClusterGraph()
+    : m_navmesh(0)
+    , m_clusterSize(0)
+    , m_clusters(0)
+    , m_maxClusters(0)
+    , m_clusterCount(0)
+    , m_nextFree(-1)
+    , m_lookup(0)
+    , m_lookupMask(0)
+    , m_portalCount(0)
+    , m_maxPortalsPerCluster(0)
+    , m_nodePool(0)
+    , m_openList(0)
+    , m_bufferSize(0)
+    , m_g(0)
+    , m_f(0)
+    , m_parent(0)
+    , m_nodeCluster(0)
+    , m_heap(0)
+    , m_heapIndex(0)
+    , m_closed(0)
+    , m_heapSize(0)
+    , m_startCosts(0)
+    , m_endCosts(0)
+{
+}
+
+rcnClusterGraph::~rcnClusterGraph()
+{
+    purge();
+}
+
+void rcnClusterGraph::purge()
+{
+    if (m_clusters)
+    {
+        for (int i = 0; i < m_maxClusters; ++i)
+            freeClusterData(m_clusters[i]);
+    }
+
+    if (m_nodePool)
+    {
+        m_nodePool->~dtNodePool();
+        dtFree(m_nodePool);
+    }
+    if (m_openList)
+    {
+        m_openList->~dtNodeQueue();
+        dtFree(m_openList);
+    }
+
+    dtFree(m_clusters);
+    dtFree(m_lookup);
+    dtFree(m_g);
+    dtFree(m_f);
+    dtFree(m_parent);
+    dtFree(m_nodeCluster);
+    dtFree(m_heap);
+    dtFree(m_heapIndex);
+    dtFree(m_closed);
+    dtFree(m_startCosts);
+    dtFree(m_endCosts);
+
+    m_navmesh = 0;
+    m_clusterSize = 0;
+    m_clusters = 0;
+    m_maxClusters = 0;
+    m_clusterCount = 0;
+    m_nextFree = -1;
+    m_lookup = 0;
+    m_lookupMask = 0;
+    m_portalCount = 0;
+    m_maxPortalsPerCluster = 0;
+    m_nodePool = 0;
+    m_openList = 0;
+    m_bufferSize = 0;
+    m_g = 0;
+    m_f = 0;
+    m_parent = 0;
+    m_nodeCluster = 0;
+    m_heap = 0;
+    m_heapIndex = 0;
+    m_closed = 0;
+    m_heapSize = 0;
+    m_startCosts = 0;
+    m_endCosts = 0;
+}
+
+dtStatus rcnClusterGraph::init(const dtNavMesh* navmesh
+    , int clusterSize
+    , int maxClusters)
+{
+    if (!navmesh || clusterSize < 1 || maxClusters < 1)
+        return DT_FAILURE | DT_INVALID_PARAM;
+
+    purge();
+
+    m_clusters = (Cluster*)dtAlloc(sizeof(Cluster) * maxClusters, DT_ALLOC_PERM, DT_ALLOC_TAG_CLUSTERS);
+
+    int lookupSize = dtNextPow2(maxClusters / 4);
+    if (!lookupSize) lookupSize = 1;
+    m_lookup = (int*)dtAlloc(sizeof(int) * lookupSize, DT_ALLOC_PERM, DT_ALLOC_TAG_CLUSTERS);
+
+    if (!m_clusters || !m_lookup)
+    {
+        purge();
+        return DT_FAILURE | DT_OUT_OF_MEMORY;
+    }
+
+    memset(m_clusters, 0, sizeof(Cluster) * maxClusters);
+    for (int i = maxClusters - 1; i >= 0; --i)
+    {
+        m_clusters[i].next = m_nextFree;
+        m_nextFree = i;
+    }
+
+    m_lookupMask = lookupSize - 1;
+    for (int i = 0; i < lookupSize; ++i)
+        m_lookup[i] = -1;
+
+    m_navmesh = navmesh;
+    m_clusterSize = clusterSize;
+    m_maxClusters = maxClusters;
+
+    return DT_SUCCESS;
+}
+
+int rcnClusterGraph::getClusterCoord(int t) const
+{
+    // Floor division. (Tile locations can be negative.)
+    return t >= 0 ? t / m_clusterSize : -((-t + m_clusterSize - 1) / m_clusterSize);
+}
+
+int rcnClusterGraph::findCluster(int x, int y) const
+{
+    if (!m_lookup)
+        return -1;
+
+    int i = m_lookup[computeClusterHash(x, y, m_lookupMask)];
+    while (i != -1)
+    {
+        const Cluster& cluster = m_clusters[i];
+        if (cluster.x == x && cluster.y == y)
+            return i;
+        i = cluster.next;
+    }
+    return -1;
+}
+
+int rcnClusterGraph::allocCluster(int x, int y)
+{
+    if (m_nextFree == -1)
+        return -1;
+
+    const int index = m_nextFree;
+    Cluster& cluster = m_clusters[index];
+    m_nextFree = cluster.next;
+
+    memset(&cluster, 0, sizeof(Cluster));
+    cluster.x = x;
+    cluster.y = y;
+    cluster.used = true;
+    cluster.dirty = true;
+
+    const int h = computeClusterHash(x, y, m_lookupMask);
+    cluster.next = m_lookup[h];
+    m_lookup[h] = index;
+
+    m_clusterCount++;
+
+    return index;
+}
+
+void rcnClusterGraph::freeCluster(int index)
+{
+    Cluster& cluster = m_clusters[index];
+
+    const int h = computeClusterHash(cluster.x, cluster.y, m_lookupMask);
+    if (m_lookup[h] == index)
+        m_lookup[h] = cluster.next;
+    else
+    {
+        int i = m_lookup[h];
+        while (m_clusters[i].next != index)
+            i = m_clusters[i].next;
+        m_clusters[i].next = cluster.next;
+    }
+
+    freeClusterData(cluster);
+    cluster.used = false;
+    cluster.next = m_nextFree;
+    m_nextFree = index;
+
+    m_clusterCount--;
+}
+
+void rcnClusterGraph::freeClusterData(Cluster& cluster)
+{
+    dtFree(cluster.portals);
+    dtFree(cluster.positions);
+    dtFree(cluster.linkStart);
+    dtFree(cluster.links);
+    dtFree(cluster.linkCosts);
+    dtFree(cluster.costs);
+    cluster.portals = 0;
+    cluster.positions = 0;
+    cluster.linkStart = 0;
+    cluster.links = 0;
+    cluster.linkCosts = 0;
+    cluster.costs = 0;
+    cluster.portalCount = 0;
+    cluster.linkCount = 0;
+}
+
+int rcnClusterGraph::findPolyCluster(dtPolyRef ref) const
+{
+    const dtMeshTile* tile = 0;
+    const dtPoly* poly = 0;
+    if (dtStatusFailed(m_navmesh->getTileAndPolyByRef(ref, &tile, &poly)))
+        return -1;
+    return findCluster(getClusterCoord(tile->header->x), getClusterCoord(tile->header->y));
+}
+
+unsigned int rcnClusterGraph::calcSignature(const Cluster& cluster) const
+{
+    const dtMeshTile* tiles[MAX_CLUSTER_LAYERS];
+
+    // Design note: Summed so that it doesn't depend on the tile order.
+    unsigned int signature = 0;
+
+    for (int ty = 0; ty < m_clusterSize; ++ty)
+    {
+        for (int tx = 0; tx < m_clusterSize; ++tx)
+        {
+            const int ntiles = m_navmesh->getTilesAt(cluster.x * m_clusterSize + tx
+                , cluster.y * m_clusterSize + ty
+                , tiles
+                , MAX_CLUSTER_LAYERS);
+
+            for (int i = 0; i < ntiles; ++i)
+            {
+                const dtTileRef ref = m_navmesh->getTileRef(tiles[i]);
+                unsigned int h = 2166136261u;
+                h = (h ^ (unsigned int)ref) * 16777619u;
+                h = (h ^ (unsigned int)(ref >> 16 >> 16)) * 16777619u;
+                h = (h ^ (unsigned int)tiles[i]->header->polyCount) * 16777619u;
+                signature += h;
+            }
+        }
+    }
+
+    return signature;
+}
+
+dtStatus rcnClusterGraph::reserveSearch(int maxNodes)
+{
+    maxNodes = dtMin(maxNodes, (int)DT_NULL_IDX);
+
+    if (m_nodePool && m_nodePool->getMaxNodes() >= maxNodes)
+        return DT_SUCCESS;
+
+    if (m_nodePool)
+    {
+        m_nodePool->~dtNodePool();
+        dtFree(m_nodePool);
+        m_nodePool = 0;
+    }
+    if (m_openList)
+    {
+        m_openList->~dtNodeQueue();
+        dtFree(m_openList);
+        m_openList = 0;
+    }
+
+    void* poolMem = dtAlloc(sizeof(dtNodePool), DT_ALLOC_PERM, DT_ALLOC_TAG_CLUSTERS);
+    void* listMem = dtAlloc(sizeof(dtNodeQueue), DT_ALLOC_PERM, DT_ALLOC_TAG_CLUSTERS);
+    if (!poolMem || !listMem)
+    {
+        dtFree(poolMem);
+        dtFree(listMem);
+        return DT_FAILURE | DT_OUT_OF_MEMORY;
+    }
+
+    m_nodePool = new(poolMem) dtNodePool(maxNodes, dtNextPow2(maxNodes / 4));
+    m_openList = new(listMem) dtNodeQueue(maxNodes);
+
+    return DT_SUCCESS;
+}
+
+dtStatus rcnClusterGraph::reserveBuffers()
+{
+    // Assign the search buffer indices.
+    m_portalCount = 0;
+    m_maxPortalsPerCluster = 0;
+    for (int i = 0; i < m_maxClusters; ++i)
+    {
+        Cluster& cluster = m_clusters[i];
+        if (!cluster.used)
+            continue;
+        cluster.base = m_portalCount;
+        m_portalCount += cluster.portalCount;
+        m_maxPortalsPerCluster = dtMax(m_maxPortalsPerCluster, cluster.portalCount);
+    }
+
+    const int size = m_portalCount + 2;
+
+    if (size > m_bufferSize)
+    {
+        dtFree(m_g);
+        dtFree(m_f);
+        dtFree(m_parent);
+        dtFree(m_nodeCluster);
+        dtFree(m_heap);
+        dtFree(m_heapIndex);
+        dtFree(m_closed);
+        m_g = (float*)dtAlloc(sizeof(float) * size, DT_ALLOC_PERM, DT_ALLOC_TAG_CLUSTERS);
+        m_f = (float*)dtAlloc(sizeof(float) * size, DT_ALLOC_PERM, DT_ALLOC_TAG_CLUSTERS);
+        m_parent = (int*)dtAlloc(sizeof(int) * size, DT_ALLOC_PERM, DT_ALLOC_TAG_CLUSTERS);
+        m_nodeCluster = (int*)dtAlloc(sizeof(int) * size, DT_ALLOC_PERM, DT_ALLOC_TAG_CLUSTERS);
+        m_heap = (int*)dtAlloc(sizeof(int) * size, DT_ALLOC_PERM, DT_ALLOC_TAG_CLUSTERS);
+        m_heapIndex = (int*)dtAlloc(sizeof(int) * size, DT_ALLOC_PERM, DT_ALLOC_TAG_CLUSTERS);
+        m_closed = (unsigned char*)dtAlloc(size, DT_ALLOC_PERM, DT_ALLOC_TAG_CLUSTERS);
+        m_bufferSize = size;
+
+        if (!m_g || !m_f || !m_parent || !m_nodeCluster
+            || !m_heap || !m_heapIndex || !m_closed)
+        {
+            m_bufferSize = 0;
+            return DT_FAILURE | DT_OUT_OF_MEMORY;
+        }
+    }
+
+    dtFree(m_startCosts);
+    dtFree(m_endCosts);
+    const int costSize = dtMax(m_maxPortalsPerCluster, 1);
+    m_startCosts = (float*)dtAlloc(sizeof(float) * costSize, DT_ALLOC_PERM, DT_ALLOC_TAG_CLUSTERS);
+    m_endCosts = (float*)dtAlloc(sizeof(float) * costSize, DT_ALLOC_PERM, DT_ALLOC_TAG_CLUSTERS);
+    if (!m_startCosts || !m_endCosts)
+        return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+    for (int i = 0; i < m_maxClusters; ++i)
+    {
+        const Cluster& cluster = m_clusters[i];
+        if (!cluster.used)
+            continue;
+        for (int j = 0; j < cluster.portalCount; ++j)
+            m_nodeCluster[cluster.base + j] = i;
+    }
+
+    return DT_SUCCESS;
+}
+
+dtStatus rcnClusterGraph::searchCluster(const Cluster& cluster
+    , dtPolyRef startRef
+    , const float* startPos
+    , const dtQueryFilter* filter
+    , float* portalCosts
+    , dtPolyRef targetRef
+    , float* targetCost)
+{
+    // Dijkstra search limited to the cluster's tiles.
+
+    for (int i = 0; i < cluster.portalCount; ++i)
+        portalCosts[i] = FLT_MAX;
+    if (targetCost)
+        *targetCost = FLT_MAX;
+
+    int remaining = cluster.portalCount + (targetRef ? 1 : 0);
+
+    dtStatus status = DT_SUCCESS;
+
+    m_nodePool->clear();
+    m_openList->clear();
+
+    dtNode* startNode = m_nodePool->getNode(startRef);
+    dtVcopy(startNode->pos, startPos);
+    startNode->pidx = 0;
+    startNode->cost = 0;
+    startNode->total = 0;
+    startNode->id = startRef;
+    startNode->flags = DT_NODE_OPEN;
+    m_openList->push(startNode);
+
+    while (!m_openList->empty() && remaining > 0)
+    {
+        dtNode* bestNode = m_openList->pop();
+        bestNode->flags &= ~DT_NODE_OPEN;
+        bestNode->flags |= DT_NODE_CLOSED;
+
+        const dtPolyRef bestRef = bestNode->id;
+
+        const int portal = findPortal(cluster.portals, cluster.portalCount, bestRef);
+        if (portal != -1)
+        {
+            portalCosts[portal] = bestNode->total;
+            remaining--;
+        }
+        if (bestRef == targetRef)
+        {
+            *targetCost = bestNode->total;
+            remaining--;
+        }
+
+        const dtMeshTile* bestTile = 0;
+        const dtPoly* bestPoly = 0;
+        m_navmesh->getTileAndPolyByRefUnsafe(bestRef, &bestTile, &bestPoly);
+
+        for (unsigned int i = bestPoly->firstLink; i != DT_NULL_LINK; i = bestTile->links[i].next)
+        {
+            const dtPolyRef neighbourRef = bestTile->links[i].ref;
+            if (!neighbourRef)
+                continue;
+
+            const dtMeshTile* neighbourTile = 0;
+            const dtPoly* neighbourPoly = 0;
+            m_navmesh->getTileAndPolyByRefUnsafe(neighbourRef, &neighbourTile, &neighbourPoly);
+
+            if (getClusterCoord(neighbourTile->header->x) != cluster.x
+                || getClusterCoord(neighbourTile->header->y) != cluster.y)
+            {
+                continue;
+            }
+
+            if (!filter->passFilter(neighbourRef, neighbourTile, neighbourPoly))
+                continue;
+
+            dtNode* neighbourNode = m_nodePool->getNode(neighbourRef);
+            if (!neighbourNode)
+            {
+                status |= DT_OUT_OF_NODES;
+                continue;
+            }
+
+            if (neighbourNode->flags & DT_NODE_CLOSED)
+                continue;
+
+            if (neighbourNode->flags == 0)
+                calcPolyCenter(neighbourTile, neighbourPoly, neighbourNode->pos);
+
+            const float total = bestNode->total + filter->getCost(bestNode->pos
+                , neighbourNode->pos
+                , 0, 0, 0
+                , bestRef, bestTile, bestPoly
+                , neighbourRef, neighbourTile, neighbourPoly);
+
+            if ((neighbourNode->flags & DT_NODE_OPEN) && total >= neighbourNode->total)
+                continue;
+
+            neighbourNode->id = neighbourRef;
+            neighbourNode->pidx = m_nodePool->getNodeIdx(bestNode);
+            neighbourNode->total = total;
+
+            if (neighbourNode->flags & DT_NODE_OPEN)
+                m_openList->modify(neighbourNode);
+            else
+            {
+                neighbourNode->flags = DT_NODE_OPEN;
+                m_openList->push(neighbourNode);
+            }
+        }
+    }
+
+    return status;
+}
+
+dtStatus rcnClusterGraph::buildCluster(Cluster& cluster, const dtQueryFilter* filter)
+{
+    freeClusterData(cluster);
+    cluster.dirty = false;
+    cluster.signature = calcSignature(cluster);
+
+    const dtMeshTile* tiles[MAX_CLUSTER_LAYERS];
+
+    // Pass 0 counts the links that leave the cluster, pass 1 stores them.
+    int polyCount = 0;
+    int recordCount = 0;
+    rcnPortalLink* records = 0;
+
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        int n = 0;
+
+        for (int ty = 0; ty < m_clusterSize; ++ty)
+        {
+            for (int tx = 0; tx < m_clusterSize; ++tx)
+            {
+                const int ntiles = m_navmesh->getTilesAt(cluster.x * m_clusterSize + tx
+                    , cluster.y * m_clusterSize + ty
+                    , tiles
+                    , MAX_CLUSTER_LAYERS);
+
+                for (int t = 0; t < ntiles; ++t)
+                {
+                    const dtMeshTile* tile = tiles[t];
+                    const dtPolyRef base = m_navmesh->getPolyRefBase(tile);
+
+                    if (pass == 0)
+                        polyCount += tile->header->polyCount;
+
+                    for (int ip = 0; ip < tile->header->polyCount; ++ip)
+                    {
+                        const dtPoly* poly = &tile->polys[ip];
+                        const dtPolyRef ref = base | (dtPolyRef)ip;
+                        if (!filter->passFilter(ref, tile, poly))
+                            continue;
+
+                        for (unsigned int i = poly->firstLink; i != DT_NULL_LINK; i = tile->links[i].next)
+                        {
+                            const dtPolyRef nref = tile->links[i].ref;
+                            if (!nref)
+                                continue;
+
+                            const dtMeshTile* ntile = 0;
+                            const dtPoly* npoly = 0;
+                            m_navmesh->getTileAndPolyByRefUnsafe(nref, &ntile, &npoly);
+
+                            if (getClusterCoord(ntile->header->x) == cluster.x
+                                && getClusterCoord(ntile->header->y) == cluster.y)
+                            {
+                                continue;
+                            }
+
+                            if (!filter->passFilter(nref, ntile, npoly))
+                                continue;
+
+                            if (pass == 1)
+                            {
+                                float pa[3], pb[3];
+                                calcPolyCenter(tile, poly, pa);
+                                calcPolyCenter(ntile, npoly, pb);
+                                records[n].ref = ref;
+                                records[n].nref = nref;
+                                records[n].cost = filter->getCost(pa, pb
+                                    , 0, 0, 0
+                                    , ref, tile, poly
+                                    , nref, ntile, npoly);
+                            }
+                            n++;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (pass == 0)
+        {
+            recordCount = n;
+            if (recordCount == 0)
+                return DT_SUCCESS;
+
+            records = (rcnPortalLink*)dtAlloc(sizeof(rcnPortalLink) * recordCount, DT_ALLOC_TEMP);
+            if (!records)
+                return DT_FAILURE | DT_OUT_OF_MEMORY;
+        }
+    }
+
+    qsort(records, recordCount, sizeof(rcnPortalLink), comparePortalLinks);
+
+    int portalCount = 0;
+    for (int i = 0; i < recordCount; ++i)
+    {
+        if (i == 0 || records[i].ref != records[i - 1].ref)
+            portalCount++;
+    }
+
+    cluster.portals = (dtPolyRef*)dtAlloc(sizeof(dtPolyRef) * portalCount, DT_ALLOC_PERM, DT_ALLOC_TAG_CLUSTERS);
+    cluster.positions = (float*)dtAlloc(sizeof(float) * portalCount * 3, DT_ALLOC_PERM, DT_ALLOC_TAG_CLUSTERS);
+    cluster.linkStart = (int*)dtAlloc(sizeof(int) * (portalCount + 1), DT_ALLOC_PERM, DT_ALLOC_TAG_CLUSTERS);
+    cluster.links = (dtPolyRef*)dtAlloc(sizeof(dtPolyRef) * recordCount, DT_ALLOC_PERM, DT_ALLOC_TAG_CLUSTERS);
+    cluster.linkCosts = (float*)dtAlloc(sizeof(float) * recordCount, DT_ALLOC_PERM, DT_ALLOC_TAG_CLUSTERS);
+    cluster.costs = (float*)dtAlloc(sizeof(float) * portalCount * portalCount, DT_ALLOC_PERM, DT_ALLOC_TAG_CLUSTERS);
+
+    if (!cluster.portals || !cluster.positions || !cluster.linkStart
+        || !cluster.links || !cluster.linkCosts || !cluster.costs)
+    {
+        dtFree(records);
+        freeClusterData(cluster);
+        return DT_FAILURE | DT_OUT_OF_MEMORY;
+    }
+
+    int p = -1;
+    for (int i = 0; i < recordCount; ++i)
+    {
+        if (i == 0 || records[i].ref != records[i - 1].ref)
+        {
+            p++;
+            cluster.portals[p] = records[i].ref;
+            cluster.linkStart[p] = i;
+
+            const dtMeshTile* tile = 0;
+            const dtPoly* poly = 0;
+            m_navmesh->getTileAndPolyByRefUnsafe(records[i].ref, &tile, &poly);
+            calcPolyCenter(tile, poly, &cluster.positions[p * 3]);
+        }
+        cluster.links[i] = records[i].nref;
+        cluster.linkCosts[i] = records[i].cost;
+    }
+    cluster.linkStart[portalCount] = recordCount;
+    cluster.portalCount = portalCount;
+    cluster.linkCount = recordCount;
+
+    dtFree(records);
+
+    // Portal to portal costs.
+    dtStatus status = reserveSearch(polyCount);
+    if (dtStatusFailed(status))
+    {
+        freeClusterData(cluster);
+        return status;
+    }
+
+    for (int i = 0; i < portalCount; ++i)
+    {
+        status |= searchCluster(cluster
+            , cluster.portals[i]
+            , &cluster.positions[i * 3]
+            , filter
+            , &cluster.costs[i * portalCount]
+            , 0
+            , 0);
+    }
+
+    return status;
+}
+
+void rcnClusterGraph::invalidateTile(int tx, int ty)
+{
+    if (!m_navmesh)
+        return;
+
+    const int index = findCluster(getClusterCoord(tx), getClusterCoord(ty));
+    if (index != -1)
+        m_clusters[index].dirty = true;
+}
+
+dtStatus rcnClusterGraph::update(const dtQueryFilter* filter, int* rebuildCount)
+{
+    if (!m_navmesh || !filter)
+        return DT_FAILURE | DT_INVALID_PARAM;
+
+    dtStatus status = DT_SUCCESS;
+
+    for (int i = 0; i < m_maxClusters; ++i)
+        m_clusters[i].seen = false;
+
+    // Find the clusters that have tiles.
+    for (int i = 0; i < m_navmesh->getMaxTiles(); ++i)
+    {
+        const dtMeshTile* tile = m_navmesh->getTile(i);
+        if (!tile || !tile->header || (tile->flags & DT_TILE_RETIRED))
+            continue;
+
+        const int x = getClusterCoord(tile->header->x);
+        const int y = getClusterCoord(tile->header->y);
+
+        int index = findCluster(x, y);
+        if (index == -1)
+        {
+            index = allocCluster(x, y);
+            if (index == -1)
+            {
+                status |= DT_BUFFER_TOO_SMALL;
+                continue;
+            }
+        }
+
+        m_clusters[index].seen = true;
+    }
+
+    // Find the changed clusters.  Neighbors are rebuilt as well since
+    // their links to the changed polygons are stored in their portals.
+    int* changed = (int*)dtAlloc(sizeof(int) * m_maxClusters * 2, DT_ALLOC_TEMP);
+    if (!changed)
+        return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+    int changedCount = 0;
+    for (int i = 0; i < m_maxClusters; ++i)
+    {
+        Cluster& cluster = m_clusters[i];
+        if (!cluster.used)
+            continue;
+
+        if (!cluster.seen)
+        {
+            changed[changedCount * 2 + 0] = cluster.x;
+            changed[changedCount * 2 + 1] = cluster.y;
+            changedCount++;
+            freeCluster(i);
+        }
+        else if (cluster.dirty || cluster.signature != calcSignature(cluster))
+        {
+            cluster.dirty = true;
+            changed[changedCount * 2 + 0] = cluster.x;
+            changed[changedCount * 2 + 1] = cluster.y;
+            changedCount++;
+        }
+    }
+
+    for (int i = 0; i < changedCount; ++i)
+    {
+        for (int dy = -1; dy <= 1; ++dy)
+        {
+            for (int dx = -1; dx <= 1; ++dx)
+            {
+                const int index = findCluster(changed[i * 2 + 0] + dx, changed[i * 2 + 1] + dy);
+                if (index != -1)
+                    m_clusters[index].dirty = true;
+            }
+        }
+    }
+
+    dtFree(changed);
+
+    int count = 0;
+    for (int i = 0; i < m_maxClusters; ++i)
+    {
+        Cluster& cluster = m_clusters[i];
+        if (!cluster.used || !cluster.dirty)
+            continue;
+
+        dtStatus buildStatus = buildCluster(cluster, filter);
+        if (dtStatusFailed(buildStatus))
+        {
+            // Stays dirty so the next update tries again.
+            cluster.dirty = true;
+            status |= dtStatusDetail(buildStatus, DT_STATUS_DETAIL_MASK)
+                ? (buildStatus & DT_STATUS_DETAIL_MASK) : DT_OUT_OF_MEMORY;
+            continue;
+        }
+        status |= (buildStatus & DT_STATUS_DETAIL_MASK);
+        count++;
+    }
+
+    if (rebuildCount)
+        *rebuildCount = count;
+
+    dtStatus bufferStatus = reserveBuffers();
+    if (dtStatusFailed(bufferStatus))
+        return bufferStatus;
+
+    return status;
+}
+
+void rcnClusterGraph::heapPush(int node)
+{
+    int i = m_heapSize++;
+    m_heap[i] = node;
+    m_heapIndex[node] = i;
+    heapUpdate(node);
+}
+
+void rcnClusterGraph::heapUpdate(int node)
+{
+    // Keys only decrease, so the node can only move up.
+    int i = m_heapIndex[node];
+    while (i > 0)
+    {
+        const int parent = (i - 1) / 2;
+        if (m_f[m_heap[parent]] <= m_f[node])
+            break;
+        m_heap[i] = m_heap[parent];
+        m_heapIndex[m_heap[i]] = i;
+        i = parent;
+    }
+    m_heap[i] = node;
+    m_heapIndex[node] = i;
+}
+
+int rcnClusterGraph::heapPop()
+{
+    const int result = m_heap[0];
+    m_heapIndex[result] = -1;
+    m_heapSize--;
+
+    if (m_heapSize > 0)
+    {
+        const int node = m_heap[m_heapSize];
+        int i = 0;
+        for (;;)
+        {
+            int child = i * 2 + 1;
+            if (child >= m_heapSize)
+                break;
+            if (child + 1 < m_heapSize && m_f[m_heap[child + 1]] < m_f[m_heap[child]])
+                child++;
+            if (m_f[node] <= m_f[m_heap[child]])
+                break;
+            m_heap[i] = m_heap[child];
+            m_heapIndex[m_heap[i]] = i;
+            i = child;
+        }
+        m_heap[i] = node;
+        m_heapIndex[node] = i;
+    }
+
+    return result;
+}
+
+dtStatus rcnClusterGraph::findPath(dtPolyRef startRef
+    , dtPolyRef endRef
+    , const float* startPos
+    , const float* endPos
+    , const dtQueryFilter* filter
+    , dtPolyRef* waypoints
+    , float* waypointPositions
+    , int* waypointCount
+    , const int maxWaypoints)
+{
+    if (!waypointCount)
+        return DT_FAILURE | DT_INVALID_PARAM;
+
+    *waypointCount = 0;
+
+    if (!m_navmesh || !startPos || !endPos || !filter
+        || !waypoints || !waypointPositions || maxWaypoints < 2
+        || !m_navmesh->isValidPolyRef(startRef)
+        || !m_navmesh->isValidPolyRef(endRef)
+        || !m_bufferSize || !m_nodePool)
+    {
+        return DT_FAILURE | DT_INVALID_PARAM;
+    }
+
+    const int startIndex = findPolyCluster(startRef);
+    const int endIndex = findPolyCluster(endRef);
+    if (startIndex == -1 || endIndex == -1)
+        return DT_FAILURE | DT_INVALID_PARAM;
+
+    const Cluster& startCluster = m_clusters[startIndex];
+    const Cluster& endCluster = m_clusters[endIndex];
+
+    dtStatus status = DT_SUCCESS;
+
+    // Costs from the start and to the end.
+    float directCost = FLT_MAX;
+    status |= searchCluster(startCluster
+        , startRef
+        , startPos
+        , filter
+        , m_startCosts
+        , startIndex == endIndex ? endRef : 0
+        , &directCost);
+    status |= searchCluster(endCluster, endRef, endPos, filter, m_endCosts, 0, 0);
+
+    const int startNode = m_portalCount;
+    const int endNode = m_portalCount + 1;
+    const int nodeCount = m_portalCount + 2;
+
+    for (int i = 0; i < nodeCount; ++i)
+    {
+        m_g[i] = FLT_MAX;
+        m_parent[i] = -1;
+        m_heapIndex[i] = -1;
+        m_closed[i] = 0;
+    }
+    m_heapSize = 0;
+
+    m_g[startNode] = 0;
+    m_f[startNode] = dtVdist(startPos, endPos) * H_SCALE;
+    heapPush(startNode);
+
+    while (m_heapSize > 0)
+    {
+        const int node = heapPop();
+        m_closed[node] = 1;
+
+        if (node == endNode)
+            break;
+
+        // Gather the edges of the node.
+        const Cluster* cluster = 0;
+        const float* costs = 0;
+        int portal = -1;
+        if (node == startNode)
+        {
+            cluster = &startCluster;
+            costs = m_startCosts;
+        }
+        else
+        {
+            cluster = &m_clusters[m_nodeCluster[node]];
+            portal = node - cluster->base;
+            costs = &cluster->costs[portal * cluster->portalCount];
+        }
+
+        for (int pass = 0; pass < 3; ++pass)
+        {
+            int first = 0;
+            int last = 0;
+            if (pass == 0)
+                last = cluster->portalCount;        // Within the cluster.
+            else if (pass == 1)
+                last = 1;                           // To the end.
+            else if (portal != -1)
+            {
+                first = cluster->linkStart[portal]; // To other clusters.
+                last = cluster->linkStart[portal + 1];
+            }
+
+            for (int i = first; i < last; ++i)
+            {
+                int neighbour = -1;
+                float cost = FLT_MAX;
+
+                if (pass == 0)
+                {
+                    neighbour = cluster->base + i;
+                    cost = costs[i];
+                }
+                else if (pass == 1)
+                {
+                    neighbour = endNode;
+                    if (node == startNode)
+                        cost = directCost;
+                    else if (cluster == &endCluster)
+                        cost = m_endCosts[portal];
+                }
+                else
+                {
+                    const int index = findPolyCluster(cluster->links[i]);
+                    if (index == -1)
+                        continue;
+                    const Cluster& other = m_clusters[index];
+                    const int j = findPortal(other.portals, other.portalCount, cluster->links[i]);
+                    if (j == -1)
+                        continue;
+                    neighbour = other.base + j;
+                    cost = cluster->linkCosts[i];
+                }
+
+                if (cost == FLT_MAX || neighbour == node || m_closed[neighbour])
+                    continue;
+
+                const float g = m_g[node] + cost;
+                if (g >= m_g[neighbour])
+                    continue;
+
+                const float* pos = endPos;
+                if (neighbour != endNode)
+                {
+                    const Cluster& other = m_clusters[m_nodeCluster[neighbour]];
+                    pos = &other.positions[(neighbour - other.base) * 3];
+                }
+
+                m_g[neighbour] = g;
+                m_f[neighbour] = g + dtVdist(pos, endPos) * H_SCALE;
+                m_parent[neighbour] = node;
+
+                if (m_heapIndex[neighbour] == -1)
+                    heapPush(neighbour);
+                else
+                    heapUpdate(neighbour);
+            }
+        }
+    }
+
+    if (m_parent[endNode] == -1)
+        return DT_FAILURE | (status & DT_STATUS_DETAIL_MASK);
+
+    // Reverse the path.
+    int count = 0;
+    for (int node = endNode; node != -1; node = m_parent[node])
+        count++;
+
+    if (count > maxWaypoints)
+        status |= DT_BUFFER_TOO_SMALL;
+
+    int i = count - 1;
+    for (int node = endNode; node != -1; node = m_parent[node], --i)
+    {
+        if (i >= maxWaypoints)
+            continue;
+
+        if (node == startNode)
+        {
+            waypoints[i] = startRef;
+            dtVcopy(&waypointPositions[i * 3], startPos);
+        }
+        else if (node == endNode)
+        {
+            waypoints[i] = endRef;
+            dtVcopy(&waypointPositions[i * 3], endPos);
+        }
+        else
+        {
+            const Cluster& cluster = m_clusters[m_nodeCluster[node]];
+            const int portal = node - cluster.base;
+            waypoints[i] = cluster.portals[portal];
+            dtVcopy(&waypointPositions[i * 3], &cluster.positions[portal * 3]);
+        }
+    }
+
+    *waypointCount = dtMin(count, maxWaypoints);
+
+    return DT_SUCCESS | status;
+}
+
+static void writeData(unsigned char* data, int& pos, const void* src, const int size)
+{
+    memcpy(&data[pos], src, size);
+    pos += size;
+}
+
+static int getClusterDataSize(const int portalCount, const int linkCount)
+{
+    return sizeof(rcnClusterDataHeader)
+        + sizeof(dtPolyRef) * portalCount
+        + sizeof(float) * portalCount * 3
+        + sizeof(int) * (portalCount + 1)
+        + sizeof(dtPolyRef) * linkCount
+        + sizeof(float) * linkCount
+        + sizeof(float) * portalCount * portalCount;
+}
+
+dtStatus rcnClusterGraph::getData(unsigned char** data, int* dataSize) const
+{
+    if (!data || !dataSize || !m_navmesh)
+        return DT_FAILURE | DT_INVALID_PARAM;
+
+    int totalSize = sizeof(rcnClusterGraphHeader);
+    for (int i = 0; i < m_maxClusters; ++i)
+    {
+        const Cluster& cluster = m_clusters[i];
+        if (cluster.used)
+            totalSize += getClusterDataSize(cluster.portalCount, cluster.linkCount);
+    }
+
+    unsigned char* result = (unsigned char*)dtAlloc(totalSize, DT_ALLOC_PERM, DT_ALLOC_TAG_CLUSTERS);
+    if (!result)
+        return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+    rcnClusterGraphHeader header;
+    header.magic = RCN_CLUSTERGRAPH_MAGIC;
+    header.version = RCN_CLUSTERGRAPH_VERSION;
+    header.polyRefSize = sizeof(dtPolyRef);
+    header.clusterSize = m_clusterSize;
+    header.clusterCount = m_clusterCount;
+    header.dataSize = totalSize;
+
+    int pos = 0;
+    writeData(result, pos, &header, sizeof(header));
+
+    for (int i = 0; i < m_maxClusters; ++i)
+    {
+        const Cluster& cluster = m_clusters[i];
+        if (!cluster.used)
+            continue;
+
+        const int n = cluster.portalCount;
+        const int nlinks = cluster.linkCount;
+        const int zero = 0;
+
+        rcnClusterDataHeader ch;
+        ch.x = cluster.x;
+        ch.y = cluster.y;
+        // A cluster waiting for a rebuild is stored as stale.
+        ch.signature = cluster.dirty ? ~cluster.signature : cluster.signature;
+        ch.portalCount = n;
+        ch.linkCount = nlinks;
+
+        writeData(result, pos, &ch, sizeof(ch));
+        writeData(result, pos, cluster.portals, sizeof(dtPolyRef) * n);
+        writeData(result, pos, cluster.positions, sizeof(float) * n * 3);
+        if (cluster.linkStart)
+            writeData(result, pos, cluster.linkStart, sizeof(int) * (n + 1));
+        else
+            writeData(result, pos, &zero, sizeof(int));
+        writeData(result, pos, cluster.links, sizeof(dtPolyRef) * nlinks);
+        writeData(result, pos, cluster.linkCosts, sizeof(float) * nlinks);
+        writeData(result, pos, cluster.costs, sizeof(float) * n * n);
+    }
+
+    *data = result;
+    *dataSize = totalSize;
+
+    return DT_SUCCESS;
+}
+
+dtStatus rcnClusterGraph::load(const unsigned char* data, const int dataSize)
+{
+    if (!data || !m_navmesh || dataSize < (int)sizeof(rcnClusterGraphHeader))
+        return DT_FAILURE | DT_INVALID_PARAM;
+
+    rcnClusterGraphHeader header;
+    memcpy(&header, data, sizeof(header));
+
+    if (header.magic != RCN_CLUSTERGRAPH_MAGIC)
+        return DT_FAILURE | DT_WRONG_MAGIC;
+    if (header.version != RCN_CLUSTERGRAPH_VERSION
+        || header.polyRefSize != (int)sizeof(dtPolyRef))
+    {
+        return DT_FAILURE | DT_WRONG_VERSION;
+    }
+    if (header.clusterSize != m_clusterSize
+        || header.clusterCount < 0
+        || header.dataSize > dataSize)
+    {
+        return DT_FAILURE | DT_INVALID_PARAM;
+    }
+
+    dtStatus status = DT_SUCCESS;
+
+    int pos = sizeof(header);
+    for (int c = 0; c < header.clusterCount; ++c)
+    {
+        if (pos + (int)sizeof(rcnClusterDataHeader) > header.dataSize)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        rcnClusterDataHeader ch;
+        memcpy(&ch, &data[pos], sizeof(ch));
+
+        // Keeps the size calculation in range.
+        if (ch.portalCount < 0 || ch.portalCount > 0x7fff
+            || ch.linkCount < 0 || ch.linkCount > 0x7ffffff
+            || (ch.portalCount == 0) != (ch.linkCount == 0)
+            || pos + getClusterDataSize(ch.portalCount, ch.linkCount) > header.dataSize)
+        {
+            return DT_FAILURE | DT_INVALID_PARAM;
+        }
+
+        pos += sizeof(ch);
+
+        const int n = ch.portalCount;
+        const int nlinks = ch.linkCount;
+
+        int index = findCluster(ch.x, ch.y);
+        if (index == -1)
+            index = allocCluster(ch.x, ch.y);
+        if (index == -1)
+        {
+            // Skip the cluster.
+            status |= DT_BUFFER_TOO_SMALL;
+            pos += getClusterDataSize(n, nlinks) - sizeof(ch);
+            continue;
+        }
+
+        Cluster& cluster = m_clusters[index];
+        freeClusterData(cluster);
+        cluster.signature = ch.signature;
+        cluster.dirty = false;
+
+        if (n == 0)
+        {
+            pos += sizeof(int);
+            continue;
+        }
+
+        cluster.portals = (dtPolyRef*)dtAlloc(sizeof(dtPolyRef) * n, DT_ALLOC_PERM, DT_ALLOC_TAG_CLUSTERS);
+        cluster.positions = (float*)dtAlloc(sizeof(float) * n * 3, DT_ALLOC_PERM, DT_ALLOC_TAG_CLUSTERS);
+        cluster.linkStart = (int*)dtAlloc(sizeof(int) * (n + 1), DT_ALLOC_PERM, DT_ALLOC_TAG_CLUSTERS);
+        cluster.links = (dtPolyRef*)dtAlloc(sizeof(dtPolyRef) * nlinks, DT_ALLOC_PERM, DT_ALLOC_TAG_CLUSTERS);
+        cluster.linkCosts = (float*)dtAlloc(sizeof(float) * nlinks, DT_ALLOC_PERM, DT_ALLOC_TAG_CLUSTERS);
+        cluster.costs = (float*)dtAlloc(sizeof(float) * n * n, DT_ALLOC_PERM, DT_ALLOC_TAG_CLUSTERS);
+
+        if (!cluster.portals || !cluster.positions || !cluster.linkStart
+            || !cluster.links || !cluster.linkCosts || !cluster.costs)
+        {
+            freeClusterData(cluster);
+            cluster.dirty = true;
+            reserveBuffers();
+            return DT_FAILURE | DT_OUT_OF_MEMORY;
+        }
+
+        memcpy(cluster.portals, &data[pos], sizeof(dtPolyRef) * n);
+        pos += sizeof(dtPolyRef) * n;
+        memcpy(cluster.positions, &data[pos], sizeof(float) * n * 3);
+        pos += sizeof(float) * n * 3;
+        memcpy(cluster.linkStart, &data[pos], sizeof(int) * (n + 1));
+        pos += sizeof(int) * (n + 1);
+        memcpy(cluster.links, &data[pos], sizeof(dtPolyRef) * nlinks);
+        pos += sizeof(dtPolyRef) * nlinks;
+        memcpy(cluster.linkCosts, &data[pos], sizeof(float) * nlinks);
+        pos += sizeof(float) * nlinks;
+        memcpy(cluster.costs, &data[pos], sizeof(float) * n * n);
+        pos += sizeof(float) * n * n;
+
+        cluster.portalCount = n;
+        cluster.linkCount = nlinks;
+
+        // The link ranges are used as array indices.
+        bool valid = cluster.linkStart[0] == 0 && cluster.linkStart[n] == nlinks;
+        for (int i = 0; valid && i < n; ++i)
+        {
+            if (cluster.linkStart[i] > cluster.linkStart[i + 1]
+                || (i > 0 && cluster.portals[i - 1] >= cluster.portals[i]))
+            {
+                valid = false;
+            }
+        }
+        if (!valid)
+        {
+            freeClusterData(cluster);
+            cluster.dirty = true;
+            status |= DT_INVALID_PARAM;
+        }
+    }
+
+    dtStatus bufferStatus = reserveBuffers();
+    if (dtStatusFailed(bufferStatus))
+        return bufferStatus;
+
+    // The search pool is sized by the cluster builds, so make sure
+    // a loaded graph can search its largest cluster.
+    int maxPolys = 1;
+    for (int i = 0; i < m_navmesh->getMaxTiles(); ++i)
+    {
+        const dtMeshTile* tile = m_navmesh->getTile(i);
+        if (tile && tile->header)
+            maxPolys = dtMax(maxPolys, tile->header->polyCount);
+    }
+    bufferStatus = reserveSearch(maxPolys * m_clusterSize * m_clusterSize);
+    if (dtStatusFailed(bufferStatus))
+        return bufferStatus;
+
+    return status;
+}
+
+dtStatus rcnRefineClusterPath(const dtNavMeshQuery* query
+    , const dtQueryFilter* filter
+    , const dtPolyRef* waypoints
+    , const float* waypointPositions
+    , const int waypointCount
+    , const int firstSegment
+    , const int maxSegments
+    , dtPolyRef* path
+    , int* pathCount
+    , const int maxPath
+    , int* nextSegment)
+{
+    if (!pathCount || !nextSegment)
+        return DT_FAILURE | DT_INVALID_PARAM;
+
+    *pathCount = 0;
+    *nextSegment = firstSegment;
+
+    if (!query || !filter || !waypoints || !waypointPositions || !path
+        || maxPath < 1 || firstSegment < 0 || maxSegments < 1)
+    {
+        return DT_FAILURE | DT_INVALID_PARAM;
+    }
+
+    const int lastSegment = dtMin(waypointCount - 1, firstSegment + maxSegments);
+
+    int n = 0;
+    int segment = firstSegment;
+    for (; segment < lastSegment; ++segment)
+    {
+        // Segments share their end polygon with the next segment's start.
+        const int offset = n > 0 ? n - 1 : 0;
+
+        int count = 0;
+        dtStatus status = query->findPath(waypoints[segment]
+            , waypoints[segment + 1]
+            , &waypointPositions[segment * 3]
+            , &waypointPositions[(segment + 1) * 3]
+            , filter
+            , &path[offset]
+            , &count
+            , maxPath - offset);
+
+        if (dtStatusFailed(status))
+        {
+            *pathCount = n;
+            *nextSegment = segment;
+            return n > 0 ? (DT_SUCCESS | DT_PARTIAL_RESULT) : status;
+        }
+
+        n = offset + count;
+
+        if (count == 0 || path[n - 1] != waypoints[segment + 1])
+        {
+            // Partial or truncated segment.
+            *pathCount = n;
+            *nextSegment = segment;
+            return DT_SUCCESS | DT_PARTIAL_RESULT
+                | (status & DT_BUFFER_TOO_SMALL);
+        }
+    }
+
+    *pathCount = n;
+    *nextSegment = segment;
+
+    return DT_SUCCESS;
+}
+
+extern "C"
+{
+    EXPORT_API dtStatus dtnmBuildClusterGraph(const dtNavMesh* navmesh
+        , const int clusterSize
+        , const int maxClusters
+        , const dtQueryFilter* filter
+        , rcnClusterGraph** ppGraph)
+    {
+        if (!ppGraph || !filter)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        *ppGraph = 0;
+
+        rcnClusterGraph* graph = rcnAllocClusterGraph();
+        if (!graph)
+            return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+        dtStatus status = graph->init(navmesh, clusterSize, maxClusters);
+        if (dtStatusSucceed(status))
+            status = graph->update(filter);
+
+        if (dtStatusFailed(status))
+        {
+            rcnFreeClusterGraph(graph);
+            return status;
+        }
+
+        *ppGraph = graph;
+
+        return status;
+    }
+
+    // Creates a graph from serialized data.  Clusters that don't match
+    // the mesh are rebuilt.
+    EXPORT_API dtStatus dtnmLoadClusterGraph(const dtNavMesh* navmesh
+        , const unsigned char* data
+        , const int dataSize
+        , const int maxClusters
+        , const dtQueryFilter* filter
+        , rcnClusterGraph** ppGraph)
+    {
+        if (!ppGraph || !data || !filter
+            || dataSize < (int)sizeof(rcnClusterGraphHeader))
+        {
+            return DT_FAILURE | DT_INVALID_PARAM;
+        }
+
+        *ppGraph = 0;
+
+        rcnClusterGraphHeader header;
+        memcpy(&header, data, sizeof(header));
+
+        rcnClusterGraph* graph = rcnAllocClusterGraph();
+        if (!graph)
+            return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+        dtStatus status = graph->init(navmesh, header.clusterSize, maxClusters);
+        if (dtStatusSucceed(status))
+            status = graph->load(data, dataSize);
+        if (dtStatusSucceed(status))
+            status = graph->update(filter);
+
+        if (dtStatusFailed(status))
+        {
+            rcnFreeClusterGraph(graph);
+            return status;
+        }
+
+        *ppGraph = graph;
+
+        return status;
+    }
+
+    EXPORT_API void dtnmFreeClusterGraph(rcnClusterGraph* graph)
+    {
+        rcnFreeClusterGraph(graph);
+    }
+
+    EXPORT_API dtStatus dtnmUpdateClusterGraph(rcnClusterGraph* graph
+        , const dtQueryFilter* filter
+        , int* rebuildCount)
+    {
+        if (!graph)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        return graph->update(filter, rebuildCount);
+    }
+
+    EXPORT_API void dtnmInvalidateClusterTile(rcnClusterGraph* graph
+        , const int tx
+        , const int ty)
+    {
+        if (graph)
+            graph->invalidateTile(tx, ty);
+    }
+
+    // Free the data with dtnmFreeBytes.
+    EXPORT_API dtStatus dtnmGetClusterGraphData(const rcnClusterGraph* graph
+        , unsigned char** resultData
+        , int* dataSize)
+    {
+        if (!graph)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        return graph->getData(resultData, dataSize);
+    }
+
+    EXPORT_API dtStatus dtqFindClusterPath(rcnClusterGraph* graph
+        , rcnNavmeshPoint startPos
+        , rcnNavmeshPoint endPos
+        , const dtQueryFilter* filter
+        , dtPolyRef* waypoints
+        , float* waypointPositions
+        , int* waypointCount
+        , const int maxWaypoints)
+    {
+        if (!graph)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        return graph->findPath(startPos.polyRef
+            , endPos.polyRef
+            , startPos.point
+            , endPos.point
+            , filter
+            , waypoints
+            , waypointPositions
+            , waypointCount
+            , maxWaypoints);
+    }
+
+    EXPORT_API dtStatus dtqRefineClusterPath(const dtNavMeshQuery* query
+        , const dtQueryFilter* filter
+        , const dtPolyRef* waypoints
+        , const float* waypointPositions
+        , const int waypointCount
+        , const int firstSegment
+        , const int maxSegments
+        , dtPolyRef* path
+        , int* pathCount
+        , const int maxPath
+        , int* nextSegment)
+    {
+        return rcnRefineClusterPath(query
+            , filter
+            , waypoints
+            , waypointPositions
+            , waypointCount
+            , firstSegment
+            , maxSegments
+            , path
+            , pathCount
+            , maxPath
+            , nextSegment);
+    }
+}
@@ -20,9 +20,12 @@
  * THE SOFTWARE.
  */
 #include <string.h>
+#include <new>
 #include "DetourCrowd.h"
 #include "DetourCommon.h"
 #include "DetourEx.h"
+#include "DetourThreadPoolEx.h"
+#include "DetourCrowdSchedulerEx.h"
 
 static const int MAX_LOCAL_BOUNDARY_SEGS = 8;
 
@@ -66,22 +69,245 @@ struct rcnCrowdAgentCoreData
 	float corner[3];	// Next corner.
 };
 
+/*
+ * Caller owned structure-of-arrays buffers for bulk agent export.
+ * All buffers are indexed by agent index and are optional. (Null
+ * buffers are skipped.)
+ */
+struct rcnCrowdAgentBuffers
+{
+    unsigned char* states;      // [(state) * maxAgents] 0 for inactive agents.
+    dtPolyRef* polyRefs;        // [(polyRef) * maxAgents]
+    float* positions;           // [(x, y, z) * maxAgents]
+    float* velocities;          // [(x, y, z) * maxAgents]
+    float* desiredVelocities;   // [(x, y, z) * maxAgents]
+    int* cornerCounts;          // [(count) * maxAgents]
+    float* corners;             // [(x, y, z) * maxCorners * maxAgents]
+    int maxCorners;             // Corners per agent. (The stride of corners.) At most
+                                // DT_CROWDAGENT_MAX_CORNERS are written per agent.
+    unsigned int* dirtyMask;    // [(maxAgents + 31) / 32] Bit set for each changed agent.
+};
+
+template<class T>
+static inline bool rcnSyncValues(T* dest, const T* src, const int count)
+{
+    // Design note: The previous export is still in the caller's
+    // buffer, so it doubles as the change detection snapshot.
+    if (memcmp(dest, src, sizeof(T) * count) == 0)
+        return false;
+    memcpy(dest, src, sizeof(T) * count);
+    return true;
+}
+
+static int rcnSyncAgentBuffers(dtCrowd* crowd, const rcnCrowdAgentBuffers* buffers)
+{
+    static const float zero[3 * DT_CROWDAGENT_MAX_CORNERS] = { 0 };
+
+    const int maxAgents = crowd->getAgentCount();
+    // Design note: Only the number of corners written is clamped.  The
+    // stride stays the caller's, so a larger buffer is not misindexed.
+    const int cornerStride = dtMax(buffers->maxCorners, 0);
+    const int maxCorners = dtMin(cornerStride, DT_CROWDAGENT_MAX_CORNERS);
+
+    if (buffers->dirtyMask)
+        memset(buffers->dirtyMask, 0, sizeof(unsigned int) * ((maxAgents + 31) / 32));
+
+    int dirtyCount = 0;
+
+    for (int i = 0; i < maxAgents; i++)
+    {
+        const dtCrowdAgent* ag = crowd->getAgent(i);
+
+        // Inactive agents are exported as zeroed data.
+        const bool active = ag->active;
+        const unsigned char state = active ? ag->state : 0;
+        const dtPolyRef polyRef = active ? ag->corridor.getFirstPoly() : 0;
+        const int ncorners = active ? dtMin(ag->ncorners, maxCorners) : 0;
+
+        bool dirty = false;
+
+        if (buffers->states)
+            dirty |= rcnSyncValues(&buffers->states[i], &state, 1);
+        if (buffers->polyRefs)
+            dirty |= rcnSyncValues(&buffers->polyRefs[i], &polyRef, 1);
+        if (buffers->positions)
+            dirty |= rcnSyncValues(&buffers->positions[i*3], active ? ag->npos : zero, 3);
+        if (buffers->velocities)
+            dirty |= rcnSyncValues(&buffers->velocities[i*3], active ? ag->vel : zero, 3);
+        if (buffers->desiredVelocities)
+            dirty |= rcnSyncValues(&buffers->desiredVelocities[i*3], active ? ag->dvel : zero, 3);
+        if (buffers->cornerCounts)
+            dirty |= rcnSyncValues(&buffers->cornerCounts[i], &ncorners, 1);
+        if (buffers->corners && ncorners)
+        {
+            dirty |= rcnSyncValues(&buffers->corners[(size_t)i*cornerStride*3]
+                , ag->cornerVerts
+                , ncorners * 3);
+        }
+
+        if (dirty)
+        {
+            dirtyCount++;
+            if (buffers->dirtyMask)
+                buffers->dirtyMask[i >> 5] |= 1u << (i & 31);
+        }
+    }
+
+    return dirtyCount;
+}
+
 extern "C"
 {
     EXPORT_API dtCrowd* dtcDetourCrowdAlloc(const int maxAgents
         , const float maxAgentRadius
-        , dtNavMesh* nav)
+        , dtNavMesh* nav
+        , const int gridType)
     {
-        dtCrowd* result = new dtCrowd();
+        dtCrowd* result = dtAllocCrowd();
         if (result)
-            result->init(maxAgents, maxAgentRadius, nav);
+            result->init(maxAgents, maxAgentRadius, nav, 0, gridType);
         return result;
     }
 
     EXPORT_API void dtcDetourCrowdFree(dtCrowd* crowd)
+    {
+        dtFreeCrowd(crowd);
+    }
+
+    EXPORT_API rcnThreadPool* dtcCreateThreadPool(const int threadCount)
+    {
+        rcnThreadPool* pool = (rcnThreadPool*)dtAlloc(sizeof(rcnThreadPool), DT_ALLOC_PERM);
+        if (!pool)
+            return 0;
+
+        new(pool) rcnThreadPool();
+        if (!pool->init(threadCount))
+        {
+            pool->~rcnThreadPool();
+            dtFree(pool);
+            return 0;
+        }
+
+        return pool;
+    }
+
+    EXPORT_API void dtcFreeThreadPool(rcnThreadPool* pool)
+    {
+        if (!pool)
+            return;
+
+        pool->~rcnThreadPool();
+        dtFree(pool);
+    }
+
+    EXPORT_API bool dtcSetThreadPool(dtCrowd* crowd, rcnThreadPool* pool)
+    {
+        // Design note: A pool can be shared by crowds that are updated
+        // one at a time.  A null pool restores the serial update.
+        if (!crowd)
+            return false;
+        return crowd->setTaskScheduler(pool);
+    }
+
+    EXPORT_API void dtcSetPathQueueBudget(dtCrowd* crowd
+        , const int maxIterations
+        , const float maxTime)
+    {
+        if (crowd)
+            crowd->setPathQueueBudget(maxIterations, maxTime);
+    }
+
+    // The cache is not owned by the crowd and must outlive it, or be
+    // cleared from the crowd first.
+    EXPORT_API void dtcSetPathCache(dtCrowd* crowd
+        , dtPathCache* cache)
+    {
+        if (crowd)
+            crowd->setPathCache(cache);
+    }
+
+    // The cache is not owned by the crowd and must outlive it, or be
+    // cleared from the crowd first.
+    EXPORT_API void dtcSetFlowFieldCache(dtCrowd* crowd
+        , dtFlowFieldCache* cache)
+    {
+        if (crowd)
+            crowd->setFlowFieldCache(cache);
+    }
+
+    EXPORT_API void dtcSetPathPriorityCenter(dtCrowd* crowd
+        , const float* pos
+        , const float weight)
+    {
+        if (crowd && pos)
+            crowd->setPathPriorityCenter(pos, weight);
+    }
+
+    EXPORT_API void dtcSetAgentPathPriority(dtCrowd* crowd
+        , const int idx
+        , const float priority)
+    {
+        if (crowd)
+            crowd->setAgentPathPriority(idx, priority);
+    }
+
+    EXPORT_API void dtcSetLodParams(dtCrowd* crowd
+        , const dtCrowdLodParams* params)
+    {
+        if (crowd && params)
+            crowd->setLodParams(params);
+    }
+
+    EXPORT_API void dtcGetLodParams(dtCrowd* crowd
+        , dtCrowdLodParams* params)
+    {
+        if (crowd && params)
+            *params = *crowd->getLodParams();
+    }
+
+    // The observer count is clamped to DT_CROWD_MAX_LOD_OBSERVERS.
+    EXPORT_API void dtcSetLodObservers(dtCrowd* crowd
+        , const float* pos
+        , const int count)
+    {
+        if (crowd && (pos || count <= 0))
+            crowd->setLodObservers(pos, count);
+    }
+
+    EXPORT_API void dtcSetAgentLod(dtCrowd* crowd
+        , const int idx
+        , const unsigned char lod)
     {
         if (crowd)
-            crowd->~dtCrowd();
+            crowd->setAgentLod(idx, lod);
+    }
+
+    EXPORT_API void dtcGetPathQueueStats(dtCrowd* crowd
+        , dtPathQueueStats* stats
+        , int* waitingCount)
+    {
+        // Design note: The waiting count covers agents that could not
+        // get a queue slot, so it is not part of the queue statistics.
+        if (!crowd)
+            return;
+
+        if (stats)
+            crowd->getPathQueue()->getStats(stats);
+
+        if (waitingCount)
+        {
+            int count = 0;
+            for (int i = 0; i < crowd->getAgentCount(); ++i)
+            {
+                const dtCrowdAgent* ag = crowd->getAgent(i);
+                if (ag->active
+                    && ag->targetState == DT_CROWDAGENT_TARGET_WAITING_FOR_QUEUE)
+                {
+                    count++;
+                }
+            }
+            *waitingCount = count;
+        }
     }
 
 	EXPORT_API void dtcSetObstacleAvoidanceParams(dtCrowd* crowd
@@ -131,6 +357,13 @@ extern "C"
 		return crowd->requestMoveTarget(idx, pos.polyRef, &pos.point[0]);
     }
 
+	EXPORT_API bool dtcRequestFlowFieldTarget(dtCrowd* crowd
+        , const int idx
+		, rcnNavmeshPoint pos)
+    {
+		return crowd->requestFlowFieldTarget(idx, pos.polyRef, &pos.point[0]);
+    }
+
 	EXPORT_API bool dtcAdjustMoveTarget(dtCrowd* crowd
         , const int idx
         , rcnNavmeshPoint pos)
@@ -168,7 +401,7 @@ extern "C"
     {
         if (bounds)
         {
-            memcpy(bounds, grid->getBounds(), sizeof(int) * 6);
+            memcpy(bounds, grid->getBounds(), sizeof(int) * 4);
         }
     }
 
@@ -289,6 +522,108 @@ extern "C"
         }
     }
 
+    // Tick function for dtcUpdateAll.  The user data is the array of
+    // core data buffers, one per crowd.
+    static void rcnExportCoreData(void* userData, int crowdIndex, dtCrowd* crowd)
+    {
+        rcnCrowdAgentCoreData* coreData = ((rcnCrowdAgentCoreData**)userData)[crowdIndex];
+        if (!coreData)
+            return;
+
+        for (int i = 0; i < crowd->getAgentCount(); i++)
+            dtcaGetAgentCoreData(crowd->getAgent(i), &coreData[i]);
+    }
+
+    EXPORT_API dtStatus dtcUpdateAll(rcnCrowdScheduler* scheduler
+        , const float dt
+        , rcnCrowdAgentCoreData** coreData
+        , float* tickTimes)
+    {
+        // Design note: The core data is exported by the worker that
+        // updated the crowd, while it is still in its cache.  A null
+        // entry skips the export for that crowd.
+        if (!scheduler)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        scheduler->update(dt, coreData ? rcnExportCoreData : 0, coreData);
+
+        if (tickTimes)
+        {
+            for (int i = 0; i < scheduler->getCrowdCount(); i++)
+                tickTimes[i] = scheduler->getTickTime(i);
+        }
+
+        return DT_SUCCESS;
+    }
+
+    EXPORT_API dtStatus dtcGetMemoryStats(const dtCrowd* crowd
+        , dtCrowdMemoryStats* stats)
+    {
+        if (!crowd || !stats)
+            return DT_FAILURE | DT_INVALID_PARAM;
+        crowd->getMemoryStats(stats);
+        return DT_SUCCESS;
+    }
+
+    EXPORT_API int dtcGetStateSize(dtCrowd* crowd)
+    {
+        if (!crowd)
+            return 0;
+        return crowd->getStateSize();
+    }
+
+    EXPORT_API dtStatus dtcStoreState(dtCrowd* crowd
+        , unsigned char* stateData
+        , const int dataSize)
+    {
+        if (!crowd)
+            return (DT_FAILURE | DT_INVALID_PARAM);
+        return crowd->storeState(stateData, dataSize);
+    }
+
+    EXPORT_API dtStatus dtcRestoreState(dtCrowd* crowd
+        , const unsigned char* stateData
+        , const int dataSize
+        , const dtCrowdAgent** agents
+        , rcnCrowdAgentCoreData* coreData)
+    {
+        // Design note: The agent pointers are reported even on failure
+        // since a failed restore can leave the crowd without agents.
+        if (!crowd || !agents || !coreData)
+            return (DT_FAILURE | DT_INVALID_PARAM);
+
+        dtStatus status = crowd->restoreState(stateData, dataSize);
+
+        for (int i = 0; i < crowd->getAgentCount(); i++)
+        {
+            const dtCrowdAgent* ag = crowd->getAgent(i);
+            agents[i] = ag->active ? ag : 0;
+            dtcaGetAgentCoreData(ag, &coreData[i]);
+        }
+
+        return status;
+    }
+
+    EXPORT_API int dtcGetAgentBuffers(dtCrowd* crowd
+        , const rcnCrowdAgentBuffers* buffers)
+    {
+        if (!crowd || !buffers)
+            return -1;
+        return rcnSyncAgentBuffers(crowd, buffers);
+    }
+
+    EXPORT_API int dtcUpdateBuffers(dtCrowd* crowd
+        , const float dt
+        , const rcnCrowdAgentBuffers* buffers)
+    {
+        if (!crowd || !buffers)
+            return -1;
+
+        crowd->update(dt, 0);
+
+        return rcnSyncAgentBuffers(crowd, buffers);
+    }
+
     EXPORT_API int dtcAddAgent(dtCrowd* crowd
         , const float* pos
         , const dtCrowdAgentParams* params
@@ -0,0 +1,312 @@
+/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <new>
+#include <string.h>
+#include "DetourCrowdSchedulerEx.h"
+#include "DetourAlloc.h"
+#include "DetourCommon.h"
+#include "DetourEx.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+// Returns a monotonic time stamp in microseconds.
+static double getTimeUsec()
+{
+#if defined(_WIN32)
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart * 1000000.0 / (double)freq.QuadPart;
+#else
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000000.0 + (double)ts.tv_nsec / 1000.0;
+#endif
+}
+
+rcnCrowdScheduler* rcnAllocCrowdScheduler()
+{
+    void* mem = dtAlloc(sizeof(rcnCrowdScheduler), DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+    if (!mem) return 0;
+    return new(mem) rcnCrowdScheduler;
+}
+
+void rcnFreeCrowdScheduler(rcnCrowdScheduler* scheduler)
+{
+    if (!scheduler) return;
+    scheduler->~rcnCrowdScheduler();
+    dtFree(scheduler);
+}
+
+rcnCrowdScheduler::rcnCrowdScheduler()
+    : m_crowds(0)
+    , m_tickTimes(0)
+    , m_taskCrowds(0)
+    , m_sortedCrowds(0)
+    , m_crowdCount(0)
+    , m_maxCrowds(0)
+    , m_tickFunc(0)
+    , m_tickUserData(0)
+    , m_dt(0)
+    , m_lastUpdateTime(0)
+{
+}
+
+rcnCrowdScheduler::~rcnCrowdScheduler()
+{
+    purge();
+}
+
+void rcnCrowdScheduler::purge()
+{
+    m_pool.purge();
+
+    dtFree(m_crowds);
+    dtFree(m_tickTimes);
+    dtFree(m_taskCrowds);
+    dtFree(m_sortedCrowds);
+
+    m_crowds = 0;
+    m_tickTimes = 0;
+    m_taskCrowds = 0;
+    m_sortedCrowds = 0;
+    m_crowdCount = 0;
+    m_maxCrowds = 0;
+    m_lastUpdateTime = 0;
+}
+
+dtStatus rcnCrowdScheduler::init(int maxCrowds, int threadCount)
+{
+    purge();
+
+    if (maxCrowds < 1 || threadCount < 0)
+        return DT_FAILURE | DT_INVALID_PARAM;
+
+    m_crowds = (dtCrowd**)dtAlloc(sizeof(dtCrowd*) * maxCrowds, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+    m_tickTimes = (float*)dtAlloc(sizeof(float) * maxCrowds, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+    m_taskCrowds = (int*)dtAlloc(sizeof(int) * maxCrowds, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+    m_sortedCrowds = (int*)dtAlloc(sizeof(int) * maxCrowds, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+
+    if (!m_crowds || !m_tickTimes || !m_taskCrowds || !m_sortedCrowds)
+    {
+        purge();
+        return DT_FAILURE | DT_OUT_OF_MEMORY;
+    }
+
+    if (!m_pool.init(threadCount))
+    {
+        purge();
+        return DT_FAILURE;
+    }
+
+    m_maxCrowds = maxCrowds;
+
+    return DT_SUCCESS;
+}
+
+int rcnCrowdScheduler::findCrowd(const dtCrowd* crowd) const
+{
+    for (int i = 0; i < m_crowdCount; ++i)
+    {
+        if (m_crowds[i] == crowd)
+            return i;
+    }
+    return -1;
+}
+
+int rcnCrowdScheduler::addCrowd(dtCrowd* crowd)
+{
+    if (!crowd || m_crowdCount >= m_maxCrowds || findCrowd(crowd) != -1)
+        return -1;
+
+    // Design note: These are updated from the crowd's worker, so two
+    // crowds that share one would use it from two threads at once.
+    const dtTaskScheduler* scheduler = crowd->getTaskScheduler();
+    const dtPathCache* pathCache = crowd->getPathQueue()->getPathCache();
+    const dtFlowFieldCache* flowFields = crowd->getFlowFieldCache();
+
+    for (int i = 0; i < m_crowdCount; ++i)
+    {
+        const dtCrowd* other = m_crowds[i];
+        if ((scheduler && scheduler == other->getTaskScheduler())
+            || (pathCache && pathCache == other->getPathQueue()->getPathCache())
+            || (flowFields && flowFields == other->getFlowFieldCache()))
+        {
+            return -1;
+        }
+    }
+
+    const int index = m_crowdCount++;
+    m_crowds[index] = crowd;
+    m_tickTimes[index] = 0;
+
+    return index;
+}
+
+bool rcnCrowdScheduler::removeCrowd(const dtCrowd* crowd)
+{
+    const int index = findCrowd(crowd);
+    if (index == -1)
+        return false;
+
+    const int n = m_crowdCount - index - 1;
+    memmove(&m_crowds[index], &m_crowds[index+1], sizeof(dtCrowd*) * n);
+    memmove(&m_tickTimes[index], &m_tickTimes[index+1], sizeof(float) * n);
+    m_crowdCount--;
+
+    return true;
+}
+
+void rcnCrowdScheduler::orderTasks()
+{
+    // Sort the crowds by their last tick time, heaviest first.
+    // (Insertion sort.  There are few crowds.)
+    int* sorted = m_sortedCrowds;
+    for (int i = 0; i < m_crowdCount; ++i)
+    {
+        int j = i;
+        while (j > 0 && m_tickTimes[sorted[j-1]] < m_tickTimes[i])
+        {
+            sorted[j] = sorted[j-1];
+            j--;
+        }
+        sorted[j] = i;
+    }
+
+    // Deal the sorted crowds across the workers' initial shares of the
+    // task indices, so each worker starts on one of the heaviest crowds.
+    // The shares are contiguous and even. (See: rcnThreadPool)
+    const int workerCount = dtMax(1, dtMin(m_pool.getWorkerCount(), m_crowdCount));
+    const int share = m_crowdCount / workerCount;
+    const int extra = m_crowdCount % workerCount;
+
+    for (int i = 0; i < m_crowdCount; ++i)
+    {
+        const int worker = i % workerCount;
+        const int begin = worker * share + dtMin(worker, extra);
+        m_taskCrowds[begin + i / workerCount] = sorted[i];
+    }
+}
+
+void rcnCrowdScheduler::runTask(void* userData, int taskIndex, int /*workerIndex*/)
+{
+    rcnCrowdScheduler* scheduler = (rcnCrowdScheduler*)userData;
+
+    const int index = scheduler->m_taskCrowds[taskIndex];
+    dtCrowd* crowd = scheduler->m_crowds[index];
+
+    const double startTime = getTimeUsec();
+
+    crowd->update(scheduler->m_dt, 0);
+
+    if (scheduler->m_tickFunc)
+        scheduler->m_tickFunc(scheduler->m_tickUserData, index, crowd);
+
+    scheduler->m_tickTimes[index] = (float)(getTimeUsec() - startTime);
+}
+
+void rcnCrowdScheduler::update(float dt, rcnCrowdTickFunc func, void* userData)
+{
+    const double startTime = getTimeUsec();
+
+    orderTasks();
+
+    m_tickFunc = func;
+    m_tickUserData = userData;
+    m_dt = dt;
+
+    m_pool.parallelFor(runTask, this, m_crowdCount);
+
+    m_tickFunc = 0;
+    m_tickUserData = 0;
+
+    m_lastUpdateTime = (float)(getTimeUsec() - startTime);
+}
+
+extern "C"
+{
+    EXPORT_API dtStatus dtcsAlloc(const int maxCrowds
+        , const int threadCount
+        , rcnCrowdScheduler** ppScheduler)
+    {
+        if (!ppScheduler)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        *ppScheduler = 0;
+
+        rcnCrowdScheduler* scheduler = rcnAllocCrowdScheduler();
+        if (!scheduler)
+            return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+        dtStatus status = scheduler->init(maxCrowds, threadCount);
+
+        if (dtStatusFailed(status))
+        {
+            rcnFreeCrowdScheduler(scheduler);
+            return status;
+        }
+
+        *ppScheduler = scheduler;
+
+        return DT_SUCCESS;
+    }
+
+    EXPORT_API void dtcsFree(rcnCrowdScheduler* scheduler)
+    {
+        rcnFreeCrowdScheduler(scheduler);
+    }
+
+    EXPORT_API int dtcsAddCrowd(rcnCrowdScheduler* scheduler
+        , dtCrowd* crowd)
+    {
+        if (!scheduler)
+            return -1;
+        return scheduler->addCrowd(crowd);
+    }
+
+    EXPORT_API bool dtcsRemoveCrowd(rcnCrowdScheduler* scheduler
+        , dtCrowd* crowd)
+    {
+        if (!scheduler)
+            return false;
+        return scheduler->removeCrowd(crowd);
+    }
+
+    EXPORT_API int dtcsGetWorkerCount(rcnCrowdScheduler* scheduler)
+    {
+        if (!scheduler)
+            return 0;
+        return scheduler->getWorkerCount();
+    }
+
+    EXPORT_API float dtcsGetLastUpdateTime(rcnCrowdScheduler* scheduler)
+    {
+        if (!scheduler)
+            return 0;
+        return scheduler->getLastUpdateTime();
+    }
+}
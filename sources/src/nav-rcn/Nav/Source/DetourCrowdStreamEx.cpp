@@ -0,0 +1,565 @@
+/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <new>
+#include <string.h>
+#include "DetourCrowdStreamEx.h"
+#include "DetourAlloc.h"
+#include "DetourCommon.h"
+#include "DetourMath.h"
+#include "DetourEx.h"
+
+static const int STREAM_HEADER_SIZE = 5;
+
+static const unsigned char FIELD_STATE = 0x01;
+static const unsigned char FIELD_POLYREF = 0x02;
+static const unsigned char FIELD_POSITION = 0x04;
+static const unsigned char FIELD_VELOCITY = 0x08;
+
+// Keeps the quantized values well inside the int range, so deltas do not
+// overflow.
+static const float MAX_QUANTIZED = 1073741823.0f;
+
+static int quantize(float v, float precision)
+{
+    const float q = dtClamp(v / precision, -MAX_QUANTIZED, MAX_QUANTIZED);
+    return (int)dtMathFloorf(q + 0.5f);
+}
+
+static unsigned int zigzag(int v)
+{
+    return ((unsigned int)v << 1) ^ (unsigned int)(v >> 31);
+}
+
+static int unzigzag(unsigned int v)
+{
+    return (int)((v >> 1) ^ (0u - (v & 1)));
+}
+
+// A bounded byte writer.  Writes past the end set the overflow flag.
+struct rcnStreamWriter
+{
+    unsigned char* data;
+    int size;
+    int maxSize;
+    bool overflow;
+
+    void putByte(unsigned char v)
+    {
+        if (size < maxSize)
+            data[size++] = v;
+        else
+            overflow = true;
+    }
+
+    template<class T>
+    void putVarUint(T v)
+    {
+        while (v >= 0x80)
+        {
+            putByte((unsigned char)(v | 0x80));
+            v >>= 7;
+        }
+        putByte((unsigned char)v);
+    }
+};
+
+// A bounded byte reader.  Reads past the end set the error flag.
+struct rcnStreamReader
+{
+    const unsigned char* data;
+    int size;
+    int pos;
+    bool error;
+
+    unsigned char getByte()
+    {
+        if (pos < size)
+            return data[pos++];
+        error = true;
+        return 0;
+    }
+
+    template<class T>
+    T getVarUint()
+    {
+        T v = 0;
+        for (unsigned int shift = 0; shift < sizeof(T) * 8; shift += 7)
+        {
+            const unsigned char b = getByte();
+            v |= (T)(b & 0x7f) << shift;
+            if (!(b & 0x80))
+                return v;
+        }
+        error = true;
+        return 0;
+    }
+};
+
+rcnCrowdStateEncoder* rcnAllocCrowdStateEncoder()
+{
+    void* mem = dtAlloc(sizeof(rcnCrowdStateEncoder), DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+    if (!mem) return 0;
+    return new(mem) rcnCrowdStateEncoder;
+}
+
+void rcnFreeCrowdStateEncoder(rcnCrowdStateEncoder* encoder)
+{
+    if (!encoder) return;
+    encoder->~rcnCrowdStateEncoder();
+    dtFree(encoder);
+}
+
+rcnCrowdStateEncoder::rcnCrowdStateEncoder()
+    : m_baseline(0)
+    , m_maxAgents(0)
+    , m_nextAgent(0)
+    , m_posPrecision(0)
+    , m_velPrecision(0)
+    , m_keyframe(true)
+{
+}
+
+rcnCrowdStateEncoder::~rcnCrowdStateEncoder()
+{
+    purge();
+}
+
+void rcnCrowdStateEncoder::purge()
+{
+    dtFree(m_baseline);
+    m_baseline = 0;
+    m_maxAgents = 0;
+    m_nextAgent = 0;
+}
+
+dtStatus rcnCrowdStateEncoder::init(int maxAgents
+    , float positionPrecision
+    , float velocityPrecision)
+{
+    purge();
+
+    if (maxAgents < 1 || !(positionPrecision > 0) || !(velocityPrecision > 0))
+        return DT_FAILURE | DT_INVALID_PARAM;
+
+    m_baseline = (rcnStreamAgentBaseline*)dtAlloc(
+        sizeof(rcnStreamAgentBaseline) * maxAgents, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+    if (!m_baseline)
+        return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+    m_maxAgents = maxAgents;
+    m_posPrecision = positionPrecision;
+    m_velPrecision = velocityPrecision;
+
+    reset();
+
+    return DT_SUCCESS;
+}
+
+void rcnCrowdStateEncoder::reset()
+{
+    if (m_baseline)
+        memset(m_baseline, 0, sizeof(rcnStreamAgentBaseline) * m_maxAgents);
+    m_nextAgent = 0;
+    m_keyframe = true;
+}
+
+dtStatus rcnCrowdStateEncoder::write(dtCrowd* crowd
+    , unsigned char* stream
+    , int maxSize
+    , int* size
+    , int* agentCount)
+{
+    if (!crowd || !stream || !size || !m_baseline
+        || crowd->getAgentCount() > m_maxAgents)
+    {
+        return DT_FAILURE | DT_INVALID_PARAM;
+    }
+
+    *size = 0;
+    if (agentCount)
+        *agentCount = 0;
+
+    if (maxSize < STREAM_HEADER_SIZE)
+        return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+
+    rcnStreamWriter writer;
+    writer.data = stream;
+    writer.size = STREAM_HEADER_SIZE;
+    writer.maxSize = maxSize;
+    writer.overflow = false;
+
+    const int n = crowd->getAgentCount();
+    int records = 0;
+    int prevIndex = -1;
+    int checked = 0;
+
+    // Design note: Starts where the previous call stopped, so agents at the 
+    // end of the pool are not starved when every stream fills the buffer.
+    const int start = m_nextAgent < n ? m_nextAgent : 0;
+
+    for (; checked < n; ++checked)
+    {
+        const int i = (start + checked) % n;
+        const dtCrowdAgent* ag = crowd->getAgent(i);
+        rcnStreamAgentBaseline& base = m_baseline[i];
+
+        rcnStreamAgentBaseline cur;
+        memset(&cur, 0, sizeof(cur));
+        if (ag->active)
+        {
+            cur.state = (unsigned char)ag->state;
+            cur.polyRef = ag->corridor.getFirstPoly();
+            for (int k = 0; k < 3; ++k)
+            {
+                cur.position[k] = quantize(ag->npos[k], m_posPrecision);
+                cur.velocity[k] = quantize(ag->vel[k], m_velPrecision);
+            }
+        }
+        else if (base.state)
+        {
+            // Keeps the last position as the baseline, so the agent is 
+            // cheap to write if the slot is reused nearby.
+            memcpy(cur.position, base.position, sizeof(cur.position));
+            memcpy(cur.velocity, base.velocity, sizeof(cur.velocity));
+        }
+        else
+            continue;
+
+        unsigned char mask = 0;
+        if (cur.state != base.state)
+            mask |= FIELD_STATE;
+        if (cur.polyRef != base.polyRef)
+            mask |= FIELD_POLYREF;
+        if (memcmp(cur.position, base.position, sizeof(cur.position)) != 0)
+            mask |= FIELD_POSITION;
+        if (memcmp(cur.velocity, base.velocity, sizeof(cur.velocity)) != 0)
+            mask |= FIELD_VELOCITY;
+        if (!mask)
+            continue;
+
+        const int recordStart = writer.size;
+
+        writer.putVarUint(zigzag(i - (prevIndex + 1)));
+        writer.putByte(mask);
+        if (mask & FIELD_STATE)
+            writer.putByte(cur.state);
+        if (mask & FIELD_POLYREF)
+            writer.putVarUint(cur.polyRef);
+        if (mask & FIELD_POSITION)
+        {
+            for (int k = 0; k < 3; ++k)
+                writer.putVarUint(zigzag(cur.position[k] - base.position[k]));
+        }
+        if (mask & FIELD_VELOCITY)
+        {
+            for (int k = 0; k < 3; ++k)
+                writer.putVarUint(zigzag(cur.velocity[k] - base.velocity[k]));
+        }
+
+        if (writer.overflow)
+        {
+            writer.size = recordStart;
+            break;
+        }
+
+        base = cur;
+        prevIndex = i;
+        records++;
+    }
+
+    stream[0] = m_keyframe ? RCN_STREAM_KEYFRAME : 0;
+    for (int k = 0; k < 4; ++k)
+        stream[1 + k] = (unsigned char)((unsigned int)records >> (k * 8));
+
+    m_keyframe = false;
+    m_nextAgent = checked < n ? (start + checked) % n : 0;
+
+    *size = writer.size;
+    if (agentCount)
+        *agentCount = records;
+
+    return DT_SUCCESS | (checked < n ? DT_BUFFER_TOO_SMALL : 0);
+}
+
+rcnCrowdStateDecoder* rcnAllocCrowdStateDecoder()
+{
+    void* mem = dtAlloc(sizeof(rcnCrowdStateDecoder), DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+    if (!mem) return 0;
+    return new(mem) rcnCrowdStateDecoder;
+}
+
+void rcnFreeCrowdStateDecoder(rcnCrowdStateDecoder* decoder)
+{
+    if (!decoder) return;
+    decoder->~rcnCrowdStateDecoder();
+    dtFree(decoder);
+}
+
+rcnCrowdStateDecoder::rcnCrowdStateDecoder()
+    : m_baseline(0)
+    , m_maxAgents(0)
+    , m_posPrecision(0)
+    , m_velPrecision(0)
+{
+}
+
+rcnCrowdStateDecoder::~rcnCrowdStateDecoder()
+{
+    purge();
+}
+
+void rcnCrowdStateDecoder::purge()
+{
+    dtFree(m_baseline);
+    m_baseline = 0;
+    m_maxAgents = 0;
+}
+
+dtStatus rcnCrowdStateDecoder::init(int maxAgents
+    , float positionPrecision
+    , float velocityPrecision)
+{
+    purge();
+
+    if (maxAgents < 1 || !(positionPrecision > 0) || !(velocityPrecision > 0))
+        return DT_FAILURE | DT_INVALID_PARAM;
+
+    m_baseline = (rcnStreamAgentBaseline*)dtAlloc(
+        sizeof(rcnStreamAgentBaseline) * maxAgents, DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+    if (!m_baseline)
+        return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+    memset(m_baseline, 0, sizeof(rcnStreamAgentBaseline) * maxAgents);
+
+    m_maxAgents = maxAgents;
+    m_posPrecision = positionPrecision;
+    m_velPrecision = velocityPrecision;
+
+    return DT_SUCCESS;
+}
+
+bool rcnCrowdStateDecoder::parse(const unsigned char* stream
+    , int size
+    , rcnReplicatedAgentState* states
+    , unsigned int* dirtyMask)
+{
+    rcnStreamReader reader;
+    reader.data = stream;
+    reader.size = size;
+    reader.pos = 0;
+    reader.error = false;
+
+    const unsigned char flags = reader.getByte();
+    unsigned int records = 0;
+    for (int k = 0; k < 4; ++k)
+        records |= (unsigned int)reader.getByte() << (k * 8);
+    if (reader.error)
+        return false;
+
+    if (states && (flags & RCN_STREAM_KEYFRAME))
+    {
+        memset(m_baseline, 0, sizeof(rcnStreamAgentBaseline) * m_maxAgents);
+        memset(states, 0, sizeof(rcnReplicatedAgentState) * m_maxAgents);
+        if (dirtyMask)
+            memset(dirtyMask, 0xff, sizeof(unsigned int) * ((m_maxAgents + 31) / 32));
+    }
+
+    int prevIndex = -1;
+    for (unsigned int r = 0; r < records; ++r)
+    {
+        const int i = prevIndex + 1 + unzigzag(reader.getVarUint<unsigned int>());
+        const unsigned char mask = reader.getByte();
+        if (reader.error || i < 0 || i >= m_maxAgents)
+            return false;
+
+        rcnStreamAgentBaseline& base = m_baseline[i];
+
+        unsigned char state = base.state;
+        dtPolyRef polyRef = base.polyRef;
+        int position[3], velocity[3];
+        memcpy(position, base.position, sizeof(position));
+        memcpy(velocity, base.velocity, sizeof(velocity));
+
+        if (mask & FIELD_STATE)
+            state = reader.getByte();
+        if (mask & FIELD_POLYREF)
+            polyRef = reader.getVarUint<dtPolyRef>();
+        if (mask & FIELD_POSITION)
+        {
+            for (int k = 0; k < 3; ++k)
+                position[k] += unzigzag(reader.getVarUint<unsigned int>());
+        }
+        if (mask & FIELD_VELOCITY)
+        {
+            for (int k = 0; k < 3; ++k)
+                velocity[k] += unzigzag(reader.getVarUint<unsigned int>());
+        }
+        if (reader.error)
+            return false;
+
+        prevIndex = i;
+
+        if (!states)
+            continue;
+
+        base.state = state;
+        base.polyRef = polyRef;
+        memcpy(base.position, position, sizeof(position));
+        memcpy(base.velocity, velocity, sizeof(velocity));
+
+        rcnReplicatedAgentState& out = states[i];
+        if (state)
+        {
+            out.state = state;
+            out.polyRef = polyRef;
+            for (int k = 0; k < 3; ++k)
+            {
+                out.position[k] = position[k] * m_posPrecision;
+                out.velocity[k] = velocity[k] * m_velPrecision;
+            }
+        }
+        else
+            memset(&out, 0, sizeof(out));
+
+        if (dirtyMask)
+            dirtyMask[i >> 5] |= 1u << (i & 31);
+    }
+
+    return reader.pos == size;
+}
+
+dtStatus rcnCrowdStateDecoder::read(const unsigned char* stream
+    , int size
+    , rcnReplicatedAgentState* states
+    , unsigned int* dirtyMask)
+{
+    if (!stream || !states || !m_baseline)
+        return DT_FAILURE | DT_INVALID_PARAM;
+
+    // Design note: The stream is validated in full before it is applied,
+    // so a malformed stream cannot leave the baseline half updated.
+    if (!parse(stream, size, 0, 0))
+        return DT_FAILURE | DT_INVALID_PARAM;
+
+    if (dirtyMask)
+        memset(dirtyMask, 0, sizeof(unsigned int) * ((m_maxAgents + 31) / 32));
+
+    parse(stream, size, states, dirtyMask);
+
+    return DT_SUCCESS;
+}
+
+extern "C"
+{
+    EXPORT_API dtStatus dtcseAlloc(const int maxAgents
+        , const float positionPrecision
+        , const float velocityPrecision
+        , rcnCrowdStateEncoder** ppEncoder)
+    {
+        if (!ppEncoder)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        *ppEncoder = 0;
+
+        rcnCrowdStateEncoder* encoder = rcnAllocCrowdStateEncoder();
+        if (!encoder)
+            return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+        dtStatus status = encoder->init(maxAgents, positionPrecision, velocityPrecision);
+
+        if (dtStatusFailed(status))
+        {
+            rcnFreeCrowdStateEncoder(encoder);
+            return status;
+        }
+
+        *ppEncoder = encoder;
+
+        return DT_SUCCESS;
+    }
+
+    EXPORT_API void dtcseFree(rcnCrowdStateEncoder* encoder)
+    {
+        rcnFreeCrowdStateEncoder(encoder);
+    }
+
+    EXPORT_API void dtcseReset(rcnCrowdStateEncoder* encoder)
+    {
+        if (encoder)
+            encoder->reset();
+    }
+
+    EXPORT_API dtStatus dtcWriteStateDelta(dtCrowd* crowd
+        , rcnCrowdStateEncoder* encoder
+        , unsigned char* stream
+        , const int maxSize
+        , int* size
+        , int* agentCount)
+    {
+        if (!encoder)
+            return DT_FAILURE | DT_INVALID_PARAM;
+        return encoder->write(crowd, stream, maxSize, size, agentCount);
+    }
+
+    EXPORT_API dtStatus dtcsdAlloc(const int maxAgents
+        , const float positionPrecision
+        , const float velocityPrecision
+        , rcnCrowdStateDecoder** ppDecoder)
+    {
+        if (!ppDecoder)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        *ppDecoder = 0;
+
+        rcnCrowdStateDecoder* decoder = rcnAllocCrowdStateDecoder();
+        if (!decoder)
+            return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+        dtStatus status = decoder->init(maxAgents, positionPrecision, velocityPrecision);
+
+        if (dtStatusFailed(status))
+        {
+            rcnFreeCrowdStateDecoder(decoder);
+            return status;
+        }
+
+        *ppDecoder = decoder;
+
+        return DT_SUCCESS;
+    }
+
+    EXPORT_API void dtcsdFree(rcnCrowdStateDecoder* decoder)
+    {
+        rcnFreeCrowdStateDecoder(decoder);
+    }
+
+    EXPORT_API dtStatus dtcsdRead(rcnCrowdStateDecoder* decoder
+        , const unsigned char* stream
+        , const int size
+        , rcnReplicatedAgentState* states
+        , unsigned int* dirtyMask)
+    {
+        if (!decoder)
+            return DT_FAILURE | DT_INVALID_PARAM;
+        return decoder->read(stream, size, states, dirtyMask);
+    }
+}
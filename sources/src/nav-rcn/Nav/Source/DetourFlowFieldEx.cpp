@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <string.h>
+#include "DetourFlowField.h"
+#include "DetourEx.h"
+
+extern "C"
+{
+    EXPORT_API dtStatus dtffAlloc(const dtNavMesh* navmesh
+        , const int maxFields
+        , const int maxPolys
+        , const float radius
+        , dtFlowFieldCache** ppCache)
+    {
+        if (!ppCache)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        *ppCache = 0;
+
+        dtFlowFieldCache* cache = dtAllocFlowFieldCache();
+        if (!cache)
+            return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+        dtStatus status = cache->init(navmesh, maxFields, maxPolys, radius);
+        if (dtStatusFailed(status))
+        {
+            dtFreeFlowFieldCache(cache);
+            return status;
+        }
+
+        *ppCache = cache;
+
+        return DT_SUCCESS;
+    }
+
+    EXPORT_API void dtffFree(dtFlowFieldCache* cache)
+    {
+        dtFreeFlowFieldCache(cache);
+    }
+
+    // Follows the goal's flow field from the start polygon.  The field is
+    // built if it isn't cached.  Fails if the start polygon is outside the 
+    // field.
+    EXPORT_API dtStatus dtffGetPath(dtFlowFieldCache* cache
+        , rcnNavmeshPoint goalPos
+        , const dtQueryFilter* filter
+        , const dtPolyRef startRef
+        , dtPolyRef* path
+        , int* pathCount
+        , const int maxPath)
+    {
+        if (!cache || !pathCount)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        *pathCount = 0;
+
+        const dtFlowField* field = 0;
+        dtStatus status = cache->getField(goalPos.polyRef
+            , &goalPos.point[0]
+            , filter
+            , &field);
+
+        if (dtStatusFailed(status))
+            return status;
+
+        return field->getPath(startRef, path, pathCount, maxPath);
+    }
+
+    // Tile removal and replacement is detected automatically.  Report 
+    // added tiles and flag and area changes.
+    EXPORT_API void dtffInvalidateTile(dtFlowFieldCache* cache
+        , const int tx
+        , const int ty)
+    {
+        if (cache)
+            cache->invalidateTile(tx, ty);
+    }
+
+    EXPORT_API void dtffInvalidatePoly(dtFlowFieldCache* cache
+        , const dtPolyRef polyRef)
+    {
+        if (cache)
+            cache->invalidatePoly(polyRef);
+    }
+
+    EXPORT_API void dtffClear(dtFlowFieldCache* cache)
+    {
+        if (cache)
+            cache->clear();
+    }
+
+    EXPORT_API void dtffGetStats(const dtFlowFieldCache* cache
+        , dtFlowFieldCacheStats* stats)
+    {
+        if (cache)
+            cache->getStats(stats);
+    }
+
+    EXPORT_API void dtffResetStats(dtFlowFieldCache* cache)
+    {
+        if (cache)
+            cache->resetStats();
+    }
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <string.h>
+#include "DetourMappedFileEx.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+bool rcnMapFile(const char* path, rcnMappedFile* file)
+{
+    if (!path || !file)
+        return false;
+
+    memset(file, 0, sizeof(rcnMappedFile));
+
+#if defined(_WIN32)
+    HANDLE fh = CreateFileA(path
+        , GENERIC_READ
+        , FILE_SHARE_READ
+        , 0
+        , OPEN_EXISTING
+        , FILE_ATTRIBUTE_NORMAL
+        , 0);
+
+    if (fh == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(fh, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(fh);
+        return false;
+    }
+
+    // Write copy pages are shared until modified.
+    HANDLE mh = CreateFileMappingA(fh, 0, PAGE_WRITECOPY, 0, 0, 0);
+    if (!mh)
+    {
+        CloseHandle(fh);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mh, FILE_MAP_COPY, 0, 0, 0);
+    if (!view)
+    {
+        CloseHandle(mh);
+        CloseHandle(fh);
+        return false;
+    }
+
+    file->data = (unsigned char*)view;
+    file->dataSize = (size_t)size.QuadPart;
+    file->fileHandle = fh;
+    file->mapHandle = mh;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    // Private mappings are shared until modified.
+    void* view = mmap(0
+        , (size_t)st.st_size
+        , PROT_READ | PROT_WRITE
+        , MAP_PRIVATE
+        , fd
+        , 0);
+
+    // The mapping keeps its own reference to the file.
+    close(fd);
+
+    if (view == MAP_FAILED)
+        return false;
+
+    file->data = (unsigned char*)view;
+    file->dataSize = (size_t)st.st_size;
+#endif
+
+    return true;
+}
+
+void rcnUnmapFile(rcnMappedFile* file)
+{
+    if (!file || !file->data)
+        return;
+
+#if defined(_WIN32)
+    UnmapViewOfFile(file->data);
+    if (file->mapHandle)
+        CloseHandle((HANDLE)file->mapHandle);
+    if (file->fileHandle)
+        CloseHandle((HANDLE)file->fileHandle);
+#else
+    munmap(file->data, file->dataSize);
+#endif
+
+    memset(file, 0, sizeof(rcnMappedFile));
+}
@@ -23,8 +23,8 @@
 #include "DetourNavMeshBuilder.h"
 #include "DetourCommon.h"
 #include "DetourNavMeshEx.h"
-
-const long RCN_NAVMESH_VERSION = 1;
+#include "DetourMappedFileEx.h"
+#include "DetourNavMeshSetEx.h"
 
 struct rcnNavMeshCreateParams
     : dtNavMeshCreateParams
@@ -40,19 +40,421 @@ struct rcnNavMeshCreateParams
     int maxConns;
 };
 
-struct rcnNavMeshSetHeader
+struct rcnNavMeshMapping
 {
-    long version;
-    int tileCount;
-    dtNavMeshParams params;
+    rcnMappedFile file;
+    dtNavMesh* navmesh;
 };
 
-struct rcnNavMeshTileHeader
+// Serialized mesh data shared by several meshes.  The tiles are used in
+// place with DT_TILE_SHARED_DATA, so the memory cost of each mesh is its 
+// polygons and links.
+// Design note: The reference count is not thread safe.  Create and free
+// the meshes from one thread.
+struct rcnSharedNavMeshData
 {
-	dtTileRef tileRef;
-	int dataSize;
+    unsigned char* data;
+    int dataSize;
+    int refCount;   // The owner, plus one for each mesh.
 };
 
+static void rcnReleaseSharedData(rcnSharedNavMeshData* shared)
+{
+    if (--shared->refCount > 0)
+        return;
+
+    dtFree(shared->data);
+    dtFree(shared);
+}
+
+// The alignment tile data requires in order to be used in place.
+static const int RCN_TILE_ALIGNMENT = 
+    (sizeof(dtPolyRef) > sizeof(float) ? sizeof(dtPolyRef) : sizeof(float));
+
+// Adds a serialized tile to the mesh, copying the data if required.
+// (See rcnBuildNavMesh for the meaning of safeStorage, inPlace and shared.)
+static dtStatus rcnAddSerializedTile(dtNavMesh* mesh
+    , unsigned char* data
+    , int dataSize
+    , dtTileRef tileRef
+    , bool safeStorage
+    , bool inPlace
+    , bool shared)
+{
+    unsigned char* tileData = data;
+    int flags = shared ? DT_TILE_SHARED_DATA : DT_TILE_EXTERNAL_DATA;
+    bool copied = false;
+
+    if (!inPlace || ((size_t)tileData % RCN_TILE_ALIGNMENT) != 0)
+    {
+        tileData = (unsigned char*)dtAlloc(dataSize, DT_ALLOC_PERM, DT_ALLOC_TAG_TILE_DATA);
+        if (!tileData)
+            return DT_FAILURE + DT_OUT_OF_MEMORY;
+        memcpy(tileData, data, dataSize);
+        flags = (safeStorage || shared ? DT_TILE_FREE_DATA : 0);
+        copied = true;
+    }
+
+    dtStatus status = mesh->addTile(tileData, dataSize, flags, tileRef, 0);
+
+    if (dtStatusFailed(status) && copied)
+        dtFree(tileData);
+
+    return status;
+}
+
+static dtStatus rcnAddTilesV1(dtNavMesh* mesh
+    , unsigned char* data
+    , int dataSize
+    , const rcnNavMeshSetHeader& header
+    , bool safeStorage
+    , bool inPlace
+    , bool shared)
+{
+    int pos = sizeof(rcnNavMeshSetHeader);
+
+    for (int i = 0; i < header.tileCount; ++i)
+    {
+        rcnNavMeshTileHeader tileHeader;
+        int size = sizeof(rcnNavMeshTileHeader);
+        if (pos + size > dataSize)
+            return DT_FAILURE + DT_INVALID_PARAM;
+
+        memcpy(&tileHeader, &data[pos], size);
+        pos += size;
+
+        size = tileHeader.dataSize;
+        if (!tileHeader.tileRef 
+            || tileHeader.dataSize <= 0
+            || size > dataSize - pos)
+        {
+            return DT_FAILURE + DT_INVALID_PARAM;
+        }
+
+        dtStatus status = rcnAddSerializedTile(mesh
+            , &data[pos]
+            , size
+            , tileHeader.tileRef
+            , safeStorage
+            , inPlace
+            , shared);
+
+        if (dtStatusFailed(status))
+            return status;
+
+        pos += size;
+    }
+
+    return DT_SUCCESS;
+}
+
+static dtStatus rcnAddTilesIndexed(dtNavMesh* mesh
+    , unsigned char* data
+    , const rcnNavMeshTileIndex* table
+    , int tileCount
+    , bool safeStorage
+    , bool inPlace
+    , bool shared)
+{
+    for (int i = 0; i < tileCount; ++i)
+    {
+        const rcnNavMeshTileIndex& entry = table[i];
+        unsigned char* tileData = &data[entry.dataOffset];
+
+        if (!rcnValidateNavMeshTile(entry, tileData))
+            return DT_FAILURE + DT_INVALID_PARAM;
+
+        dtStatus status = rcnAddSerializedTile(mesh
+            , tileData
+            , entry.dataSize
+            , entry.tileRef
+            , safeStorage
+            , inPlace
+            , shared);
+
+        if (dtStatusFailed(status))
+            return status;
+    }
+
+    return DT_SUCCESS;
+}
+
+// Builds a navigation mesh from a serialized navigation mesh blob.
+// Supports all blob versions.  (See: DetourNavMeshSetEx.h)
+//
+// If inPlace is true, aligned tiles are handed directly to the mesh
+// with DT_TILE_EXTERNAL_DATA, so they are never freed.  The data must be 
+// writable and must outlive the mesh.  Tiles that are not suitably 
+// aligned are copied.
+// The safeStorage setting only applies to copied tiles.
+//
+// If shared is true (requires inPlace), the tiles are added with
+// DT_TILE_SHARED_DATA, so the data is never written and may be used by
+// several meshes at once.  Copied tiles are always owned by the mesh.
+static dtStatus rcnBuildNavMesh(unsigned char* data
+    , int dataSize
+    , bool safeStorage
+    , bool inPlace
+    , bool shared
+    , dtNavMesh** ppNavMesh)
+{
+    if (!data || !ppNavMesh)
+        return DT_FAILURE + DT_INVALID_PARAM;
+
+    *ppNavMesh = 0;
+
+    const int version = rcnGetNavMeshSetVersion(data, dataSize);
+
+    dtNavMeshParams params;
+    rcnNavMeshSetHeader header;
+    const rcnNavMeshTileIndex* table = 0;
+    int tileCount = 0;
+
+    if (version == RCN_NAVMESH_VERSION)
+    {
+        memcpy(&header, data, sizeof(rcnNavMeshSetHeader));
+        memcpy(&params, &header.params, sizeof(dtNavMeshParams));
+    }
+    else if (version == RCN_NAVMESH_INDEXED_VERSION)
+    {
+        table = rcnGetNavMeshTileTable(data, dataSize);
+        if (!table)
+            return DT_FAILURE + DT_INVALID_PARAM;
+
+        const rcnNavMeshIndexHeader* indexHeader = 
+            (const rcnNavMeshIndexHeader*)data;
+        memcpy(&params, &indexHeader->params, sizeof(dtNavMeshParams));
+        tileCount = indexHeader->tileCount;
+    }
+    else if (dataSize < (int)sizeof(int))
+        return DT_FAILURE + DT_INVALID_PARAM;
+    else
+        return DT_FAILURE + DT_WRONG_VERSION;
+
+    dtNavMesh* mesh = dtAllocNavMesh();
+    if (!mesh)
+        return DT_FAILURE + DT_OUT_OF_MEMORY;
+
+    dtStatus status = mesh->init(&params);
+    if (dtStatusSucceed(status))
+    {
+        if (table)
+        {
+            status = rcnAddTilesIndexed(mesh
+                , data, table, tileCount, safeStorage, inPlace, shared);
+        }
+        else
+        {
+            status = rcnAddTilesV1(mesh
+                , data, dataSize, header, safeStorage, inPlace, shared);
+        }
+    }
+
+    if (dtStatusFailed(status))
+    {
+        dtFreeNavMesh(mesh);
+        return status;
+    }
+
+    *ppNavMesh = mesh;
+
+    return DT_SUCCESS;
+}
+
+// Returns the tile at the index of the serialization range, or null if
+// there is no tile.  (If tileRefs is null, the range is the full tile array.)
+static const dtMeshTile* rcnGetSetTile(const dtNavMesh* mesh
+    , const dtTileRef* tileRefs
+    , int index)
+{
+    const dtMeshTile* tile = 
+        tileRefs ? mesh->getTileByRef(tileRefs[index]) : mesh->getTile(index);
+
+    if (!tile || !tile->header || !tile->dataSize || (tile->flags & DT_TILE_RETIRED))
+        return 0;
+
+    return tile;
+}
+
+// Copies the tile data into the buffer.  The polygons and links of 
+// shared tiles are kept outside the data, so they are copied over the 
+// shared versions. (Which only hold the state the tile was loaded with.)
+static void rcnCopyTileData(unsigned char* buffer, const dtMeshTile* tile)
+{
+    memcpy(buffer, tile->data, tile->dataSize);
+
+    if (!(tile->flags & DT_TILE_SHARED_DATA))
+        return;
+
+    const dtMeshHeader* header = tile->header;
+
+    const int headerSize = dtAlign4(sizeof(dtMeshHeader));
+    const int vertsSize = dtAlign4(sizeof(float)*3*header->vertCount);
+    const int polysSize = dtAlign4(sizeof(dtPoly)*header->polyCount);
+
+    unsigned char* verts = buffer + headerSize;
+    memcpy(verts, tile->verts, sizeof(float)*3*header->vertCount);
+    memcpy(verts + vertsSize, tile->polys, sizeof(dtPoly)*header->polyCount);
+    memcpy(verts + vertsSize + polysSize
+        , tile->links, sizeof(dtLink)*header->maxLinkCount);
+}
+
+// Gets the size of the blob rcnWriteNavMeshSet will produce.
+static int rcnGetNavMeshSetSize(const dtNavMesh* mesh
+    , bool indexed
+    , const dtTileRef* tileRefs
+    , int tileRefCount
+    , int* resultTileCount)
+{
+    const int count = tileRefs ? tileRefCount : mesh->getMaxTiles();
+
+    int tileCount = 0;
+    int payloadSize = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        const dtMeshTile* tile = rcnGetSetTile(mesh, tileRefs, i);
+        if (!tile) continue;
+        tileCount++;
+        payloadSize += indexed ? rcnAlignTileData(tile->dataSize) 
+            : tile->dataSize + (int)sizeof(rcnNavMeshTileHeader);
+    }
+
+    *resultTileCount = tileCount;
+
+    if (!indexed)
+        return (int)sizeof(rcnNavMeshSetHeader) + payloadSize;
+
+    const int tableOffset = rcnAlignTileData(sizeof(rcnNavMeshIndexHeader));
+    return rcnAlignTileData(tableOffset 
+        + tileCount * (int)sizeof(rcnNavMeshTileIndex)) + payloadSize;
+}
+
+// Serializes the mesh straight into the buffer.  If tileRefs is null all 
+// tiles are written, otherwise only the listed tiles. (Which must be 
+// unique.)  Invalid references are skipped.
+//
+// Design note: The tiles are walked twice.  The sizing pass only reads
+// the tile headers.  It is needed because the buffer size must be checked
+// (and the required size reported) before anything is written, and the
+// indexed format places the payloads after a table sized by the number of 
+// valid tiles.  The second pass copies each tile once.
+static dtStatus rcnWriteNavMeshSet(const dtNavMesh* mesh
+    , bool indexed
+    , const dtTileRef* tileRefs
+    , int tileRefCount
+    , unsigned char* buffer
+    , int bufferSize
+    , int* dataSize)
+{
+    int tileCount;
+    const int totalDataSize = 
+        rcnGetNavMeshSetSize(mesh, indexed, tileRefs, tileRefCount, &tileCount);
+
+    *dataSize = totalDataSize;
+
+    if (!buffer || bufferSize < totalDataSize)
+        return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+
+    const int count = tileRefs ? tileRefCount : mesh->getMaxTiles();
+
+    if (!indexed)
+    {
+        rcnNavMeshSetHeader header;
+        header.version = RCN_NAVMESH_VERSION;
+        header.tileCount = tileCount;
+        memcpy(&header.params, mesh->getParams(), sizeof(dtNavMeshParams));
+
+        int pos = 0;
+        memcpy(&buffer[pos], &header, sizeof(rcnNavMeshSetHeader));
+        pos += sizeof(rcnNavMeshSetHeader);
+
+        for (int i = 0; i < count; ++i)
+        {
+            const dtMeshTile* tile = rcnGetSetTile(mesh, tileRefs, i);
+            if (!tile) continue;
+
+            rcnNavMeshTileHeader tileHeader;
+            tileHeader.tileRef = mesh->getTileRef(tile);
+            tileHeader.dataSize = tile->dataSize;
+
+            memcpy(&buffer[pos], &tileHeader, sizeof(rcnNavMeshTileHeader));
+            pos += sizeof(rcnNavMeshTileHeader);
+            rcnCopyTileData(&buffer[pos], tile);
+            pos += tile->dataSize;
+        }
+
+        return DT_SUCCESS;
+    }
+
+    // Zero the header, table and padding so equal meshes produce equal blobs.
+    const int tableOffset = rcnAlignTileData(sizeof(rcnNavMeshIndexHeader));
+    int pos = rcnAlignTileData(
+        tableOffset + tileCount * (int)sizeof(rcnNavMeshTileIndex));
+    memset(buffer, 0, pos);
+
+    rcnNavMeshIndexHeader* header = (rcnNavMeshIndexHeader*)buffer;
+    header->version = RCN_NAVMESH_INDEXED_VERSION;
+    header->magic = RCN_NAVMESH_MAGIC;
+    header->tileCount = tileCount;
+    header->tableOffset = tableOffset;
+    memcpy(&header->params, mesh->getParams(), sizeof(dtNavMeshParams));
+    header->dataSize = totalDataSize;
+
+    rcnNavMeshTileIndex* table = (rcnNavMeshTileIndex*)&buffer[tableOffset];
+
+    int n = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        const dtMeshTile* tile = rcnGetSetTile(mesh, tileRefs, i);
+        if (!tile) continue;
+
+        rcnNavMeshTileIndex& entry = table[n++];
+        entry.tileRef = mesh->getTileRef(tile);
+        entry.x = tile->header->x;
+        entry.y = tile->header->y;
+        entry.layer = tile->header->layer;
+        entry.dataOffset = pos;
+        entry.dataSize = tile->dataSize;
+
+        rcnCopyTileData(&buffer[pos], tile);
+
+        // Design note: The CRC is calculated from the copy.  So the
+        // links written by addTile are included.  They are rebuilt 
+        // on load, so this is harmless.
+        entry.crc = rcnCalcCrc32(&buffer[pos], tile->dataSize);
+
+        const int alignedSize = rcnAlignTileData(tile->dataSize);
+        memset(&buffer[pos + tile->dataSize], 0, alignedSize - tile->dataSize);
+        pos += alignedSize;
+    }
+
+    return DT_SUCCESS;
+}
+
+// Allocates a buffer and serializes the mesh into it.
+static void rcnGetNavMeshSetData(const dtNavMesh* mesh
+    , bool indexed
+    , const dtTileRef* tileRefs
+    , int tileRefCount
+    , unsigned char** resultData
+    , int* dataSize)
+{
+    int tileCount;
+    const int totalDataSize = 
+        rcnGetNavMeshSetSize(mesh, indexed, tileRefs, tileRefCount, &tileCount);
+
+    unsigned char* data = (unsigned char*)dtAlloc(totalDataSize, DT_ALLOC_PERM, DT_ALLOC_TAG_TILE_DATA);
+    if (!data)
+        return;
+
+    int size;
+    rcnWriteNavMeshSet(mesh
+        , indexed, tileRefs, tileRefCount, data, totalDataSize, &size);
+
+    *resultData = data;
+    *dataSize = totalDataSize;
+}
+
 extern "C"
 {
 
@@ -83,7 +485,7 @@ extern "C"
         }
 
         resultData->data = (unsigned char*)dtAlloc(
-            sizeof(unsigned char)*dataSize, DT_ALLOC_PERM);
+            sizeof(unsigned char)*dataSize, DT_ALLOC_PERM, DT_ALLOC_TAG_TILE_DATA);
 
         if (!resultData->data)
             return false;
@@ -116,7 +518,7 @@ extern "C"
 
 		if (header->magic != DT_NAVMESH_MAGIC)
 			return DT_FAILURE | DT_WRONG_MAGIC;
-		if (header->version != DT_NAVMESH_VERSION)
+		if (!dtIsNavMeshVersion(header->version))
 			return DT_FAILURE | DT_WRONG_VERSION;
 
 		memcpy(resultHeader, header, sizeof(dtMeshHeader));
@@ -138,68 +540,89 @@ extern "C"
         , unsigned char** resultData
         , int* dataSize)
     {
-        if (!navMesh || !resultData || !dataSize)
-        {
-            *resultData = 0;
-            *dataSize = 0;
+        if (!resultData || !dataSize)
             return;
-        }
 
-        rcnNavMeshSetHeader header;
-        header.version = RCN_NAVMESH_VERSION;
-        header.tileCount = 0;
-
-	    for (int i = 0; i < navMesh->getMaxTiles(); ++i)
-	    {
-		    const dtMeshTile* tile = navMesh->getTile(i);
-		    if (!tile || !tile->header || !tile->dataSize) continue;
-		    header.tileCount++;
-	    }
-        memcpy(&header.params, navMesh->getParams(), sizeof(dtNavMeshParams));
-
-        int totalDataSize = 0;
-        rcnNavMeshTileHeader* tileHeaders = 
-            new rcnNavMeshTileHeader[header.tileCount];
-
-	    for (int i = 0; i < navMesh->getMaxTiles(); ++i)
-	    {
-		    const dtMeshTile* tile = navMesh->getTile(i);
-		    if (!tile || !tile->header || !tile->dataSize) continue;
-
-            tileHeaders[i].tileRef = navMesh->getTileRef(tile);
-		    tileHeaders[i].dataSize = tile->dataSize;
-            totalDataSize += tile->dataSize;
-	    }
-        
-        totalDataSize += sizeof(rcnNavMeshSetHeader);
-        totalDataSize += sizeof(rcnNavMeshTileHeader) * header.tileCount;
+        *resultData = 0;
+        *dataSize = 0;
+
+        if (navMesh)
+            rcnGetNavMeshSetData(navMesh, false, 0, 0, resultData, dataSize);
+    }
 
-        unsigned char* data = 
-            (unsigned char*)dtAlloc(totalDataSize, DT_ALLOC_PERM);
+    EXPORT_API void dtnmGetNavMeshIndexedData(const dtNavMesh* navMesh
+        , unsigned char** resultData
+        , int* dataSize)
+    {
+        if (!resultData || !dataSize)
+            return;
 
-        int pos = 0;
-        int size = sizeof(rcnNavMeshSetHeader);
-        memcpy(&data[pos], &header, size);
-        pos += size;
+        *resultData = 0;
+        *dataSize = 0;
+
+        if (navMesh)
+            rcnGetNavMeshSetData(navMesh, true, 0, 0, resultData, dataSize);
+    }
+
+    EXPORT_API int dtnmGetNavMeshDataSize(const dtNavMesh* navMesh
+        , bool indexed
+        , const dtTileRef* tileRefs
+        , int tileRefCount)
+    {
+        if (!navMesh || (tileRefs && tileRefCount < 0))
+            return 0;
+
+        int tileCount;
+        return rcnGetNavMeshSetSize(navMesh
+            , indexed, tileRefs, tileRefCount, &tileCount);
+    }
 
-        for (int i = 0; i < header.tileCount; ++i)
+    EXPORT_API dtStatus dtnmWriteNavMeshData(const dtNavMesh* navMesh
+        , bool indexed
+        , const dtTileRef* tileRefs
+        , int tileRefCount
+        , unsigned char* buffer
+        , int bufferSize
+        , int* dataSize)
+    {
+        // Design note: A tileRefs list produces a partial (delta) blob 
+        // of only the listed tiles, e.g. the tiles rebuilt since the 
+        // last save.  It has the same format as a full blob.
+
+        if (!navMesh || !dataSize || (tileRefs && tileRefCount < 0))
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        return rcnWriteNavMeshSet(navMesh
+            , indexed, tileRefs, tileRefCount, buffer, bufferSize, dataSize);
+    }
+
+    EXPORT_API dtStatus dtnmValidateNavMeshTiles(const unsigned char* data
+        , int dataSize
+        , int firstTile
+        , int tileCount)
+    {
+        // Design note: The range parameters allow validation to be
+        // split across threads.
+
+        const rcnNavMeshTileIndex* table = rcnGetNavMeshTileTable(data, dataSize);
+        if (!table)
+            return DT_FAILURE + DT_INVALID_PARAM;
+
+        const rcnNavMeshIndexHeader* header = (const rcnNavMeshIndexHeader*)data;
+        if (firstTile < 0 
+            || tileCount < 0 
+            || tileCount > header->tileCount - firstTile)
         {
-            size = sizeof(rcnNavMeshTileHeader);
-            memcpy(&data[pos], &tileHeaders[i], size);
-            pos += size;
-
-            size = tileHeaders[i].dataSize;
-            const dtMeshTile* tile = 
-                navMesh->getTileByRef(tileHeaders[i].tileRef);
-            memcpy(&data[pos], tile->data, size);
-            pos += size;
+            return DT_FAILURE + DT_INVALID_PARAM;
         }
-        
-        delete tileHeaders;
-        tileHeaders = 0;
 
-        *resultData = data;
-        *dataSize = totalDataSize;
+        for (int i = firstTile; i < firstTile + tileCount; ++i)
+        {
+            if (!rcnValidateNavMeshTile(table[i], &data[table[i].dataOffset]))
+                return DT_FAILURE + DT_INVALID_PARAM;
+        }
+
+        return DT_SUCCESS;
     }
 
     EXPORT_API void dtnmFreeBytes(unsigned char** data)
@@ -213,89 +636,85 @@ extern "C"
 		, bool safeStorage
         , dtNavMesh** ppNavMesh)
     {
-        if (!data || dataSize < sizeof(rcnNavMeshSetHeader) || !ppNavMesh)
+        // Design note: The data is only read when the tiles are copied.
+        return rcnBuildNavMesh((unsigned char*)data
+            , dataSize
+            , safeStorage
+            , false
+            , false
+            , ppNavMesh);
+    }
+
+    EXPORT_API dtStatus dtnmBuildDTNavMeshInPlace(unsigned char* data
+        , int dataSize
+        , dtNavMesh** ppNavMesh)
+    {
+        // The buffer must outlive the mesh.  Free the mesh using
+        // dtnmFreeNavMesh(mesh, false).
+        return rcnBuildNavMesh(data, dataSize, true, true, false, ppNavMesh);
+    }
+
+    EXPORT_API dtStatus dtnmMapNavMesh(const char* filePath
+        , dtNavMesh** ppNavMesh
+        , rcnNavMeshMapping** ppMapping)
+    {
+        if (!filePath || !ppNavMesh || !ppMapping)
             return DT_FAILURE + DT_INVALID_PARAM;
 
-        int pos = 0;
-        int size = sizeof(rcnNavMeshSetHeader);
+        *ppNavMesh = 0;
+        *ppMapping = 0;
 
-        rcnNavMeshSetHeader header;
-        memcpy(&header, data, size);
-        pos += size;
+        rcnNavMeshMapping* mapping = 
+            (rcnNavMeshMapping*)dtAlloc(sizeof(rcnNavMeshMapping), DT_ALLOC_PERM, DT_ALLOC_TAG_NAVMESH);
+        if (!mapping)
+            return DT_FAILURE + DT_OUT_OF_MEMORY;
 
-        if (header.version != RCN_NAVMESH_VERSION)
-        {
-            *ppNavMesh = 0;
-            return DT_FAILURE + DT_WRONG_VERSION;
-        }
+        memset(mapping, 0, sizeof(rcnNavMeshMapping));
 
-        dtNavMesh* mesh = dtAllocNavMesh();
-        if (!mesh)
+        if (!rcnMapFile(filePath, &mapping->file)
+            || mapping->file.dataSize > 0x7fffffff)
         {
-            *ppNavMesh = 0;
-            return DT_FAILURE + DT_OUT_OF_MEMORY;
+            rcnUnmapFile(&mapping->file);
+            dtFree(mapping);
+            return DT_FAILURE + DT_INVALID_PARAM;
         }
 
-	    dtStatus status = mesh->init(&header.params);
-	    if (dtStatusFailed(status))
-	    {
-		    *ppNavMesh = 0;
-		    return status;
-	    }
-
-	    // Read tiles.
-        bool success = true;
-	    for (int i = 0; i < header.tileCount; ++i)
-	    {
-		    rcnNavMeshTileHeader tileHeader;
-            size = sizeof(rcnNavMeshTileHeader);
-		    memcpy(&tileHeader, &data[pos], size);
-            pos += size;
-
-            size = tileHeader.dataSize;
-			if (!tileHeader.tileRef || !tileHeader.dataSize)
-            {
-                success = false;
-                status = DT_FAILURE + DT_INVALID_PARAM;
-			    break;
-            }
-    		
-		    unsigned char* tileData = 
-                (unsigned char*)dtAlloc(size, DT_ALLOC_PERM);
-		    if (!tileData)
-            {
-                success = false;
-                status = DT_FAILURE + DT_OUT_OF_MEMORY;
-                break;
-            }
-            memcpy(tileData, &data[pos], size);
-            pos += size;
-
-		    status = mesh->addTile(tileData
-                , size
-				, (safeStorage ? DT_TILE_FREE_DATA : 0)
-                , tileHeader.tileRef
-                , 0);
-
-            if (dtStatusFailed(status))
-            {
-                success = false;
-                break;
-            }
-	    }
-
-        if (!success)
+        dtStatus status = rcnBuildNavMesh(mapping->file.data
+            , (int)mapping->file.dataSize
+            , true
+            , true
+            , false
+            , &mapping->navmesh);
+
+        if (dtStatusFailed(status))
         {
-            dtFreeNavMesh(mesh);
-            *ppNavMesh = 0;
+            rcnUnmapFile(&mapping->file);
+            dtFree(mapping);
             return status;
         }
 
-        *ppNavMesh = mesh;
+        *ppNavMesh = mapping->navmesh;
+        *ppMapping = mapping;
 
         return DT_SUCCESS;
     }
 
+    EXPORT_API void dtnmFreeMappedNavMesh(rcnNavMeshMapping** ppMapping)
+    {
+        if (!ppMapping || !(*ppMapping))
+            return;
+
+        rcnNavMeshMapping* mapping = *ppMapping;
+
+        // The mesh has to go first.  Some of its tiles may have been
+        // copied out of the view (misaligned), and those it owns.
+        dtFreeNavMesh(mapping->navmesh);
+        rcnUnmapFile(&mapping->file);
+        dtFree(mapping);
+
+        *ppMapping = 0;
+    }
+
     EXPORT_API dtStatus dtnmInitTiledNavMesh(dtNavMeshParams* params
         , dtNavMesh** ppNavMesh)
     {
@@ -363,8 +782,6 @@ extern "C"
 
 		if (freeTiles)
 		{
-			unsigned char* tData = 0;
-			
 			for (int i = 0; i < mesh->getMaxTiles(); ++i)
 			{
 				const dtMeshTile* tile = cmesh->getTile(i);
@@ -374,16 +791,93 @@ extern "C"
 
 				dtTileRef tref = mesh->getTileRef(tile);
 
-				dtStatus status = mesh->removeTile(tref, &tData, 0);
+				// Shared data belongs to the rcnSharedNavMeshData, and
+				// external data to the caller.  The mesh frees the rest,
+				// deferred if the tile is retired.
+				if (!(tile->flags & (DT_TILE_SHARED_DATA | DT_TILE_EXTERNAL_DATA)))
+					const_cast<dtMeshTile*>(tile)->flags |= DT_TILE_FREE_DATA;
 
-				if (dtStatusSucceed(status) && tData)
-				{
-					dtFree(tData);
-					tData = 0;
-				}
+				mesh->removeTile(tref, 0, 0);
 			}
 		}
 
         dtFreeNavMesh(mesh);
     }
-}
\ No newline at end of file
+
+    // The data is copied.  The caller retains ownership of its buffer.
+    // Release the result with dtnmReleaseSharedNavMeshData.
+    EXPORT_API dtStatus dtnmCreateSharedNavMeshData(const unsigned char* data
+        , int dataSize
+        , rcnSharedNavMeshData** ppShared)
+    {
+        if (!data || dataSize < 1 || !ppShared)
+            return DT_FAILURE + DT_INVALID_PARAM;
+
+        *ppShared = 0;
+
+        rcnSharedNavMeshData* shared = (rcnSharedNavMeshData*)dtAlloc(
+            sizeof(rcnSharedNavMeshData), DT_ALLOC_PERM, DT_ALLOC_TAG_TILE_DATA);
+        if (!shared)
+            return DT_FAILURE + DT_OUT_OF_MEMORY;
+
+        // Design note: dtAlloc is suitably aligned for in place tiles.
+        shared->data = (unsigned char*)dtAlloc(dataSize, DT_ALLOC_PERM, DT_ALLOC_TAG_TILE_DATA);
+        if (!shared->data)
+        {
+            dtFree(shared);
+            return DT_FAILURE + DT_OUT_OF_MEMORY;
+        }
+
+        memcpy(shared->data, data, dataSize);
+        shared->dataSize = dataSize;
+        shared->refCount = 1;
+
+        *ppShared = shared;
+
+        return DT_SUCCESS;
+    }
+
+    // The data is freed once it has been released and all of its 
+    // meshes have been freed.
+    EXPORT_API void dtnmReleaseSharedNavMeshData(rcnSharedNavMeshData** ppShared)
+    {
+        if (!ppShared || !(*ppShared))
+            return;
+
+        rcnReleaseSharedData(*ppShared);
+        *ppShared = 0;
+    }
+
+    // Free the mesh using dtnmFreeSharedNavMesh.
+    EXPORT_API dtStatus dtnmBuildSharedNavMesh(rcnSharedNavMeshData* shared
+        , dtNavMesh** ppNavMesh)
+    {
+        if (!shared || !ppNavMesh)
+            return DT_FAILURE + DT_INVALID_PARAM;
+
+        dtStatus status = rcnBuildNavMesh(shared->data
+            , shared->dataSize
+            , true
+            , true
+            , true
+            , ppNavMesh);
+
+        if (dtStatusSucceed(status))
+            shared->refCount++;
+
+        return status;
+    }
+
+    EXPORT_API void dtnmFreeSharedNavMesh(rcnSharedNavMeshData* shared
+        , dtNavMesh** ppNavMesh)
+    {
+        if (!shared || !ppNavMesh || !(*ppNavMesh))
+            return;
+
+        // The tile data is only freed for tiles that had to be copied.
+        dtFreeNavMesh(*ppNavMesh);
+        *ppNavMesh = 0;
+
+        rcnReleaseSharedData(shared);
+    }
+}
@@ -21,7 +21,9 @@
  */
 #include <stdlib.h>
 #include <string.h>
+#include "DetourCommon.h"
 #include "DetourNavMeshQuery.h"
+#include "DetourRandomSampler.h"
 #include "DetourEx.h"
 
 // Returns a random number [0..1)
@@ -30,6 +32,21 @@ static float frand()
 	return (float)rand()/(float)RAND_MAX;
 }
 
+// Gets the filter for an item in a batch.  If there are no filter indices, 
+// all items use the first filter.  Returns null if the item's filter index
+// is out of range or references a null filter.
+static inline const dtQueryFilter* getBatchFilter(
+    const dtQueryFilter* const* filters
+    , const int filterCount
+    , const int* filterIndices
+    , const int index)
+{
+    const int fi = filterIndices ? filterIndices[index] : 0;
+    if (fi < 0 || fi >= filterCount)
+        return 0;
+    return filters[fi];
+}
+
 extern "C"
 {
     EXPORT_API dtStatus dtnqBuildDTNavQuery(dtNavMesh* pNavMesh
@@ -62,6 +79,26 @@ extern "C"
         dtFreeNavMeshQuery(*pNavQuery);
     }
 
+    EXPORT_API int dtnqGetMemUsed(const dtNavMeshQuery* query)
+    {
+        if (!query)
+            return 0;
+        return query->getMemUsed();
+    }
+
+    EXPORT_API dtStatus dtnqBeginRead(dtNavMeshQuery* query)
+    {
+        if (!query)
+            return DT_FAILURE | DT_INVALID_PARAM;
+        return query->beginRead();
+    }
+
+    EXPORT_API void dtnqEndRead(dtNavMeshQuery* query)
+    {
+        if (query)
+            query->endRead();
+    }
+
     EXPORT_API dtStatus dtqGetPolyWallSegments(dtNavMeshQuery* query
         , dtPolyRef ref
         , const dtQueryFilter* filter
@@ -91,6 +128,36 @@ extern "C"
             , &nearest->point[0]);
     }
 
+    EXPORT_API dtStatus dtqFindNearestPolyWithOptions(dtNavMeshQuery* query
+        , const float* center
+        , const float* extents
+        , const dtQueryFilter* filter
+        , const int options
+        , rcnNavmeshPoint* nearest)
+    {
+        return query->findNearestPoly(center
+            , extents
+            , filter
+            , &nearest->polyRef
+            , &nearest->point[0]
+            , options);
+    }
+
+    EXPORT_API dtStatus dtqFindNearestPolyHinted(dtNavMeshQuery* query
+        , dtPolyRef hintRef
+        , const float* center
+        , const float* extents
+        , const dtQueryFilter* filter
+        , rcnNavmeshPoint* nearest)
+    {
+        return query->findNearestPolyHinted(hintRef
+            , center
+            , extents
+            , filter
+            , &nearest->polyRef
+            , &nearest->point[0]);
+    }
+
     EXPORT_API dtStatus dtqQueryPolygons(dtNavMeshQuery* query 
         , const float* center
         , const float* extents
@@ -229,6 +296,24 @@ extern "C"
             , maxPath);
     }
 
+    EXPORT_API dtStatus dtqFindPathBidirectional(dtNavMeshQuery* query 
+		, rcnNavmeshPoint startPos
+        , rcnNavmeshPoint endPos
+		, const dtQueryFilter* filter
+		, dtPolyRef* path
+        , int* pathCount
+        , const int maxPath)
+    {
+		return query->findPathBidirectional(startPos.polyRef
+			, endPos.polyRef
+			, &startPos.point[0]
+			, &endPos.point[0]
+            , filter
+            , path
+            , pathCount
+            , maxPath);
+    }
+
     EXPORT_API dtStatus dtqFindPathExt(dtNavMeshQuery* query 
 		, rcnNavmeshPoint* startPos
         , rcnNavmeshPoint* endPos
@@ -287,6 +372,22 @@ extern "C"
         return query->isValidPolyRef(ref, filter);
     }
 
+    EXPORT_API bool dtqGetQueryStats(const dtNavMeshQuery* query
+        , dtQueryStats* lastQuery
+        , dtQueryStats* total)
+    {
+        if (!query)
+            return false;
+
+        return query->getQueryStats(lastQuery, total);
+    }
+
+    EXPORT_API void dtqResetQueryStats(dtNavMeshQuery* query)
+    {
+        if (query)
+            query->resetQueryStats();
+    }
+
 	EXPORT_API dtStatus dtqRaycast(dtNavMeshQuery* query
         , rcnNavmeshPoint startPos
         , const float* endPos
@@ -395,4 +496,330 @@ extern "C"
 			, &randomPt->polyRef, &randomPt->point[0]);
 	}
 
+    EXPORT_API dtStatus dtrsAlloc(const dtNavMeshQuery* query
+        , const dtQueryFilter* filter
+        , dtRandomPointSampler** ppSampler)
+    {
+        if (!ppSampler)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        *ppSampler = 0;
+
+        dtRandomPointSampler* sampler = dtAllocRandomPointSampler();
+        if (!sampler)
+            return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+        dtStatus status = sampler->init(query, filter);
+        if (dtStatusFailed(status))
+        {
+            dtFreeRandomPointSampler(sampler);
+            return status;
+        }
+
+        *ppSampler = sampler;
+
+        return status;
+    }
+
+    EXPORT_API void dtrsFree(dtRandomPointSampler* sampler)
+    {
+        dtFreeRandomPointSampler(sampler);
+    }
+
+    // Call after tiles are added or removed.
+    EXPORT_API dtStatus dtrsUpdate(dtRandomPointSampler* sampler
+        , int* rebuildCount)
+    {
+        if (!sampler)
+            return DT_FAILURE | DT_INVALID_PARAM;
+        return sampler->update(rebuildCount);
+    }
+
+    EXPORT_API void dtrsInvalidateTile(dtRandomPointSampler* sampler
+        , const dtMeshTile* tile)
+    {
+        if (sampler)
+            sampler->invalidateTile(tile);
+    }
+
+    EXPORT_API void dtrsInvalidateAll(dtRandomPointSampler* sampler)
+    {
+        if (sampler)
+            sampler->invalidateAll();
+    }
+
+    EXPORT_API dtStatus dtrsFindRandomPoint(const dtRandomPointSampler* sampler
+        , rcnNavmeshPoint* randomPt)
+    {
+        if (!sampler || !randomPt)
+            return DT_FAILURE | DT_INVALID_PARAM;
+        return sampler->findRandomPoint(frand, &randomPt->polyRef, &randomPt->point[0]);
+    }
+
+    EXPORT_API dtStatus dtrsFindRandomPoints(const dtRandomPointSampler* sampler
+        , const int count
+        , rcnNavmeshPoint* randomPts)
+    {
+        if (!sampler || !randomPts || count < 0)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        // The sampler returns the references and the points as separate
+        // arrays, so the points are picked in chunks and interleaved.
+        static const int CHUNK_SIZE = 64;
+        dtPolyRef refs[CHUNK_SIZE];
+        float pts[CHUNK_SIZE * 3];
+
+        for (int i = 0; i < count; i += CHUNK_SIZE)
+        {
+            const int n = dtMin(count - i, CHUNK_SIZE);
+            dtStatus status = sampler->findRandomPoints(frand, n, refs, pts);
+            if (dtStatusFailed(status))
+                return status;
+
+            for (int j = 0; j < n; ++j)
+            {
+                randomPts[i + j].polyRef = refs[j];
+                dtVcopy(&randomPts[i + j].point[0], &pts[j * 3]);
+            }
+        }
+
+        return DT_SUCCESS;
+    }
+
+    // Batch queries: Inputs and outputs are structures of arrays, one
+    // element per item, and each item gets its own status.  The return
+    // value only indicates whether the batch as a whole was valid.
+    //
+    // Design note: These exist so managed callers can run many queries 
+    // per interop transition.  The filter indices reference the filters
+    // array, so items can use different filters.  An item whose filter 
+    // index is out of range gets DT_INVALID_PARAM and is not run.
+
+    EXPORT_API dtStatus dtqFindNearestPolyBatch(dtNavMeshQuery* query
+        , const float* centers
+        , const float* extents
+        , const int extentsCount  // 1 (shared) or count.
+        , const dtQueryFilter* const* filters
+        , const int filterCount
+        , const int* filterIndices
+        , const int count
+        , dtPolyRef* resultPolyRefs
+        , float* resultPoints
+        , dtStatus* resultStatus)
+    {
+        if (!query
+            || !centers
+            || !extents
+            || (extentsCount != 1 && extentsCount != count)
+            || !filters
+            || filterCount < 1
+            || count < 0
+            || !resultPolyRefs
+            || !resultPoints
+            || !resultStatus)
+        {
+            return DT_FAILURE | DT_INVALID_PARAM;
+        }
+
+        for (int i = 0; i < count; ++i)
+        {
+            const dtQueryFilter* filter = 
+                getBatchFilter(filters, filterCount, filterIndices, i);
+            if (!filter)
+            {
+                resultPolyRefs[i] = 0;
+                resultStatus[i] = DT_FAILURE | DT_INVALID_PARAM;
+                continue;
+            }
+
+            resultStatus[i] = query->findNearestPoly(&centers[i*3]
+                , &extents[extentsCount == 1 ? 0 : i*3]
+                , filter
+                , &resultPolyRefs[i]
+                , &resultPoints[i*3]);
+        }
+
+        return DT_SUCCESS;
+    }
+
+    // The points are updated in place.  On input the reference of each 
+    // point is the hint for the item.  (E.g. The result of the previous
+    // update, or zero.)  On output the point is the item's result.
+    EXPORT_API dtStatus dtqFindNearestPolyHintedBatch(dtNavMeshQuery* query
+        , const float* centers
+        , const float* extents
+        , const int extentsCount  // 1 (shared) or count.
+        , const dtQueryFilter* const* filters
+        , const int filterCount
+        , const int* filterIndices
+        , const int count
+        , const int options       // Used by the full searches.
+        , rcnNavmeshPoint* points
+        , dtStatus* resultStatus)
+    {
+        if (!query
+            || !centers
+            || !extents
+            || (extentsCount != 1 && extentsCount != count)
+            || !filters
+            || filterCount < 1
+            || count < 0
+            || !points
+            || !resultStatus)
+        {
+            return DT_FAILURE | DT_INVALID_PARAM;
+        }
+
+        for (int i = 0; i < count; ++i)
+        {
+            const dtQueryFilter* filter = 
+                getBatchFilter(filters, filterCount, filterIndices, i);
+            if (!filter)
+            {
+                points[i].polyRef = 0;
+                resultStatus[i] = DT_FAILURE | DT_INVALID_PARAM;
+                continue;
+            }
+
+            rcnNavmeshPoint& point = points[i];
+            resultStatus[i] = query->findNearestPolyHinted(point.polyRef
+                , &centers[i*3]
+                , &extents[extentsCount == 1 ? 0 : i*3]
+                , filter
+                , &point.polyRef
+                , &point.point[0]
+                , options);
+        }
+
+        return DT_SUCCESS;
+    }
+
+    EXPORT_API dtStatus dtqRaycastBatch(dtNavMeshQuery* query
+        , const dtPolyRef* startRefs
+        , const float* startPositions
+        , const float* endPositions
+        , const dtQueryFilter* const* filters
+        , const int filterCount
+        , const int* filterIndices
+        , const int count
+        , float* resultParams
+        , float* resultNormals       // Optional
+        , dtStatus* resultStatus)
+    {
+        if (!query
+            || !startRefs
+            || !startPositions
+            || !endPositions
+            || !filters
+            || filterCount < 1
+            || count < 0
+            || !resultParams
+            || !resultStatus)
+        {
+            return DT_FAILURE | DT_INVALID_PARAM;
+        }
+
+        for (int i = 0; i < count; ++i)
+        {
+            const dtQueryFilter* filter = 
+                getBatchFilter(filters, filterCount, filterIndices, i);
+            if (!filter)
+            {
+                resultStatus[i] = DT_FAILURE | DT_INVALID_PARAM;
+                continue;
+            }
+
+            resultStatus[i] = query->raycast(startRefs[i]
+                , &startPositions[i*3]
+                , &endPositions[i*3]
+                , filter
+                , &resultParams[i]
+                , resultNormals ? &resultNormals[i*3] : 0
+                , 0, 0, 0);
+        }
+
+        return DT_SUCCESS;
+    }
+
+    EXPORT_API dtStatus dtqFindPathBatch(dtNavMeshQuery* query
+        , const dtPolyRef* startRefs
+        , const dtPolyRef* endRefs
+        , const float* startPositions
+        , const float* endPositions
+        , const dtQueryFilter* const* filters
+        , const int filterCount
+        , const int* filterIndices
+        , const int count
+        , dtPolyRef* resultPaths     // count * maxPath
+        , int* resultPathCounts
+        , const int maxPath
+        , dtStatus* resultStatus)
+    {
+        if (!query
+            || !startRefs
+            || !endRefs
+            || !startPositions
+            || !endPositions
+            || !filters
+            || filterCount < 1
+            || count < 0
+            || !resultPaths
+            || !resultPathCounts
+            || maxPath < 1
+            || !resultStatus)
+        {
+            return DT_FAILURE | DT_INVALID_PARAM;
+        }
+
+        for (int i = 0; i < count; ++i)
+        {
+            const dtQueryFilter* filter = 
+                getBatchFilter(filters, filterCount, filterIndices, i);
+            if (!filter)
+            {
+                resultPathCounts[i] = 0;
+                resultStatus[i] = DT_FAILURE | DT_INVALID_PARAM;
+                continue;
+            }
+
+            resultStatus[i] = query->findPath(startRefs[i]
+                , endRefs[i]
+                , &startPositions[i*3]
+                , &endPositions[i*3]
+                , filter
+                , &resultPaths[i*maxPath]
+                , &resultPathCounts[i]
+                , maxPath);
+        }
+
+        return DT_SUCCESS;
+    }
+
+    EXPORT_API dtStatus dtqGetPolyHeightBatch(dtNavMeshQuery* query
+        , const dtPolyRef* polyRefs
+        , const float* positions
+        , const int count
+        , float* resultHeights
+        , dtStatus* resultStatus)
+    {
+        if (!query 
+            || !polyRefs 
+            || !positions 
+            || count < 0 
+            || !resultHeights
+            || !resultStatus)
+        {
+            return DT_FAILURE | DT_INVALID_PARAM;
+        }
+
+        for (int i = 0; i < count; ++i)
+        {
+            resultStatus[i] = query->getPolyHeight(polyRefs[i]
+                , &positions[i*3]
+                , &resultHeights[i]);
+        }
+
+        return DT_SUCCESS;
+    }
+
 }
\ No newline at end of file
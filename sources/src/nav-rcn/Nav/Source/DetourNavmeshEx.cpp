@@ -20,6 +20,7 @@
  * THE SOFTWARE.
  */
 #include <string.h>
+#include "DetourAlloc.h"
 #include "DetourNavMeshEx.h"
 #include "DetourCommon.h"
 
@@ -75,7 +76,24 @@ extern "C"
 
 		if (!navMesh)
 			return DT_FAILURE + DT_INVALID_PARAM;
+
+		// Shared data belongs to the rcnSharedNavMeshData, and external
+		// data to the caller.
+		const dtMeshTile* tile = navMesh->getTileByRef(ref);
+		const bool external = tile 
+			&& (tile->flags & (DT_TILE_SHARED_DATA | DT_TILE_EXTERNAL_DATA));
+
+		if (!data && tile && !external)
+		{
+			// The caller doesn't want the data, so the mesh frees it.
+			// Design note: With concurrent reads the tile may be retired
+			// rather than released, and a read may still be using the 
+			// data.  The mesh frees it when the tile is reclaimed.
+			const_cast<dtMeshTile*>(tile)->flags |= DT_TILE_FREE_DATA;
+		}
 		
+		// Returned data must not be freed while the mesh has retired
+		// tiles.  (See: dtNavMesh::removeTile)
 		dtStatus status = navMesh->removeTile(ref, &tData, &tDataSize);
 
 		if (data)
@@ -83,18 +101,76 @@ extern "C"
 		if (dataSize)
 			*dataSize = tDataSize;
 
-		if (dtStatusFailed(status))
-			return status;
+		return status;
+    }
 
-		if (!data && tData)
-		{
-			// Data was returned, but the caller doesn't want it.
-			// Need to free the memory.
-			dtFree(tData);
-			tData = 0;
-		}
+    EXPORT_API dtStatus dtnmSetPolyGridsEnabled(dtNavMesh* navMesh
+        , bool enabled)
+    {
+        if (!navMesh)
+            return DT_FAILURE | DT_INVALID_PARAM;
+        return navMesh->setPolyGridsEnabled(enabled);
+    }
 
-		return status;
+    EXPORT_API bool dtnmGetPolyGridsEnabled(const dtNavMesh* navMesh)
+    {
+        if (!navMesh)
+            return false;
+        return navMesh->getPolyGridsEnabled();
+    }
+
+    EXPORT_API dtStatus dtnmSetHeightGridsEnabled(dtNavMesh* navMesh
+        , bool enabled)
+    {
+        if (!navMesh)
+            return DT_FAILURE | DT_INVALID_PARAM;
+        return navMesh->setHeightGridsEnabled(enabled);
+    }
+
+    EXPORT_API bool dtnmGetHeightGridsEnabled(const dtNavMesh* navMesh)
+    {
+        if (!navMesh)
+            return false;
+        return navMesh->getHeightGridsEnabled();
+    }
+
+    EXPORT_API dtStatus dtnmGetMemoryStats(const dtNavMesh* navMesh
+        , dtNavMeshMemoryStats* stats)
+    {
+        if (!navMesh || !stats)
+            return DT_FAILURE | DT_INVALID_PARAM;
+        navMesh->getMemoryStats(stats);
+        return DT_SUCCESS;
+    }
+
+    EXPORT_API dtStatus dtnmInitConcurrentReads(dtNavMesh* navMesh
+        , const int maxReaders)
+    {
+        if (!navMesh)
+            return DT_FAILURE | DT_INVALID_PARAM;
+        return navMesh->initConcurrentReads(maxReaders);
+    }
+
+    // Returns the number of removed tiles still in use by reads.
+    EXPORT_API int dtnmReclaimRetiredTiles(dtNavMesh* navMesh)
+    {
+        if (!navMesh)
+            return 0;
+        return navMesh->reclaimRetired();
+    }
+
+    // Fills one entry per allocation tag and returns the number of entries.
+    EXPORT_API int dtnmGetAllocStats(dtAllocStats* stats
+        , const int maxStats)
+    {
+        if (!stats)
+            return 0;
+
+        const int count = dtMin(maxStats, (int)DT_MAX_ALLOC_TAGS);
+        for (int i = 0; i < count; ++i)
+            dtGetAllocStats((dtAllocTag)i, &stats[i]);
+
+        return count;
     }
 
     EXPORT_API void dtnmCalcTileLoc(const dtNavMesh* navMesh
@@ -293,6 +369,88 @@ extern "C"
         return 0;
     }
 
+    EXPORT_API dtStatus dtnmGetTileView(const dtNavMesh* navmesh
+        , const dtMeshTile* tile
+        , rcnNavmeshTileView* view)
+    {
+        if (!navmesh || !tile || !view)
+            return (DT_FAILURE | DT_INVALID_PARAM);
+
+        memset(view, 0, sizeof(rcnNavmeshTileView));
+
+        const dtMeshHeader* header = tile->header;
+
+        if (!header || !tile->dataSize)
+            return (DT_FAILURE | DT_INVALID_PARAM);
+
+        view->header = header;
+        view->polys = tile->polys;
+        view->verts = tile->verts;
+        view->links = tile->links;
+        view->detailMeshes = tile->detailMeshes;
+        view->detailVerts = tile->detailVerts;
+        view->detailQuantVerts = tile->detailQuantVerts;
+        view->detailQuantParams = tile->detailQuantParams;
+        view->detailTris = tile->detailTris;
+        view->bvTree = tile->bvTree;
+        view->offMeshCons = tile->offMeshCons;
+
+        view->tileRef = navmesh->getTileRef(tile);
+        view->polyRefBase = navmesh->getPolyRefBase(tile);
+
+        view->polyCount = header->polyCount;
+        view->vertCount = header->vertCount;
+        view->linkCount = header->maxLinkCount;
+        view->detailMeshCount = header->detailMeshCount;
+        view->detailVertCount = header->detailVertCount;
+        view->detailTriCount = header->detailTriCount;
+        view->bvNodeCount = tile->bvTree ? header->bvNodeCount : 0;
+        view->offMeshConCount = header->offMeshConCount;
+
+        view->polyStride = sizeof(dtPoly);
+        view->vertStride = sizeof(float) * 3;
+        view->linkStride = sizeof(dtLink);
+        view->detailMeshStride = sizeof(dtPolyDetail);
+        view->detailVertStride = tile->detailVerts 
+            ? sizeof(float) * 3 : sizeof(unsigned short) * 3;
+        view->detailTriStride = sizeof(unsigned char) * 4;
+        view->bvNodeStride = sizeof(dtBVNode);
+        view->offMeshConStride = sizeof(dtOffMeshConnection);
+
+        return DT_SUCCESS;
+    }
+
+    EXPORT_API dtStatus dtnmGetTileViews(const dtNavMesh* navmesh
+        , rcnNavmeshTileView* views
+        , const int maxViews
+        , int* viewCount)
+    {
+        if (!navmesh || !views || maxViews < 0 || !viewCount)
+            return (DT_FAILURE | DT_INVALID_PARAM);
+
+        int count = 0;
+        dtStatus status = DT_SUCCESS;
+
+        for (int i = 0; i < navmesh->getMaxTiles(); i++)
+        {
+            const dtMeshTile* tile = navmesh->getTile(i);
+            if (!tile->header || !tile->dataSize || (tile->flags & DT_TILE_RETIRED))
+                continue;
+
+            if (count == maxViews)
+            {
+                status |= DT_BUFFER_TOO_SMALL;
+                break;
+            }
+
+            dtnmGetTileView(navmesh, tile, &views[count++]);
+        }
+
+        *viewCount = count;
+
+        return status;
+    }
+
     EXPORT_API int dtnmGetTileVerts(const dtMeshTile* tile
         , float* verts
         , const int vertsCount)
@@ -350,8 +508,19 @@ extern "C"
 
         int count = tile->header->detailVertCount;
 
-        if (count > 0)
+        if (count > 0 && tile->detailVerts)
             memcpy(verts, tile->detailVerts, sizeof(float) * count * 3);
+        else if (count > 0)
+        {
+            // Compact tile.  The vertices are decoded per polygon since
+            // the ones on polygon edges are stored relative to the edge.
+            for (int i = 0; i < tile->header->detailMeshCount; i++)
+            {
+                const dtPoly* poly = &tile->polys[i];
+                const dtPolyDetail* pd = &tile->detailMeshes[i];
+                dtGetDetailVerts(tile, poly, pd, &verts[pd->vertBase * 3]);
+            }
+        }
 
 		return count;
     }
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <string.h>
+#include "DetourPathCache.h"
+#include "DetourEx.h"
+
+extern "C"
+{
+    EXPORT_API dtStatus dtpchAlloc(const dtNavMesh* navmesh
+        , const int maxEntries
+        , const int maxPathSize
+        , dtPathCache** ppCache)
+    {
+        if (!ppCache)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        *ppCache = 0;
+
+        dtPathCache* cache = dtAllocPathCache();
+        if (!cache)
+            return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+        dtStatus status = cache->init(navmesh, maxEntries, maxPathSize);
+        if (dtStatusFailed(status))
+        {
+            dtFreePathCache(cache);
+            return status;
+        }
+
+        *ppCache = cache;
+
+        return DT_SUCCESS;
+    }
+
+    EXPORT_API void dtpchFree(dtPathCache* cache)
+    {
+        dtFreePathCache(cache);
+    }
+
+    EXPORT_API dtStatus dtpchFindPath(dtPathCache* cache
+        , const dtNavMeshQuery* query
+        , rcnNavmeshPoint startPos
+        , rcnNavmeshPoint endPos
+        , const dtQueryFilter* filter
+        , dtPolyRef* path
+        , int* pathCount
+        , const int maxPath)
+    {
+        if (!cache)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        return cache->findPath(query
+            , startPos.polyRef
+            , endPos.polyRef
+            , &startPos.point[0]
+            , &endPos.point[0]
+            , filter
+            , path
+            , pathCount
+            , maxPath);
+    }
+
+    // Flag and area changes are detected when a path is looked up, so
+    // this is only needed when a path depends on state the cache can't
+    // see.  (E.g. A custom filter under DT_VIRTUAL_QUERYFILTER.)
+    EXPORT_API void dtpchInvalidatePoly(dtPathCache* cache
+        , const dtPolyRef polyRef)
+    {
+        if (cache)
+            cache->invalidatePoly(polyRef);
+    }
+
+    EXPORT_API void dtpchClear(dtPathCache* cache)
+    {
+        if (cache)
+            cache->clear();
+    }
+
+    EXPORT_API void dtpchGetStats(const dtPathCache* cache
+        , dtPathCacheStats* stats)
+    {
+        if (cache)
+            cache->getStats(stats);
+    }
+
+    EXPORT_API void dtpchResetStats(dtPathCache* cache)
+    {
+        if (cache)
+            cache->resetStats();
+    }
+}
@@ -20,7 +20,9 @@
  * THE SOFTWARE.
  */
 #include <string.h>
+#include <new>
 #include "DetourCommon.h"
+#include "DetourAlloc.h"
 #include "DetourPathCorridor.h"
 #include "DetourEx.h"
 
@@ -28,16 +30,22 @@ extern "C"
 {
 	EXPORT_API dtPathCorridor* dtpcAlloc(const int maxPath)
 	{
-		dtPathCorridor* corridor = new dtPathCorridor();
-		if (corridor)
-			corridor->init(maxPath);
+		void* mem = dtAlloc(sizeof(dtPathCorridor), DT_ALLOC_PERM, DT_ALLOC_TAG_CROWD);
+		if (!mem)
+			return 0;
+
+		dtPathCorridor* corridor = new(mem) dtPathCorridor();
+		corridor->init(maxPath);
 		return corridor;
 	}
 
 	EXPORT_API void dtpcFree(dtPathCorridor* corridor)
 	{
-		if (corridor)
-			corridor->~dtPathCorridor();
+		if (!corridor)
+			return;
+
+		corridor->~dtPathCorridor();
+		dtFree(corridor);
 	}
 
 	EXPORT_API void dtpcReset(dtPathCorridor* corridor
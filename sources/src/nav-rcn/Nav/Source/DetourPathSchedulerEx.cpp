@@ -0,0 +1,691 @@
+/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <new>
+#include <string.h>
+#include "DetourPathSchedulerEx.h"
+#include "DetourPathCache.h"
+#include "DetourAlloc.h"
+#include "DetourCommon.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+// Returns a monotonic time stamp in microseconds.
+static double getTimeUsec()
+{
+#if defined(_WIN32)
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart * 1000000.0 / (double)freq.QuadPart;
+#else
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000000.0 + (double)ts.tv_nsec / 1000.0;
+#endif
+}
+
+static const int TICKET_SLOT_BITS = 16;
+static const unsigned int TICKET_SLOT_MASK = (1u << TICKET_SLOT_BITS) - 1;
+
+rcnPathScheduler* rcnAllocPathScheduler()
+{
+    void* mem = dtAlloc(sizeof(rcnPathScheduler), DT_ALLOC_PERM, DT_ALLOC_TAG_PATH_QUEUE);
+    if (!mem) return 0;
+    return new(mem) rcnPathScheduler;
+}
+
+void rcnFreePathScheduler(rcnPathScheduler* scheduler)
+{
+    if (!scheduler) return;
+    scheduler->~rcnPathScheduler();
+    dtFree(scheduler);
+}
+
+rcnPathScheduler::rcnPathScheduler()
+    : m_queries(0)
+    , m_sliceOwners(0)
+    , m_sliceCount(0)
+    , m_nextSlice(0)
+    , m_requests(0)
+    , m_paths(0)
+    , m_maxRequests(0)
+    , m_maxPathSize(0)
+    , m_freeSlots(0)
+    , m_freeCount(0)
+    , m_queuedCount(0)
+    , m_nextSequence(0)
+    , m_tick(0)
+    , m_cache(0)
+{
+    resetStats();
+}
+
+rcnPathScheduler::~rcnPathScheduler()
+{
+    purge();
+}
+
+void rcnPathScheduler::purge()
+{
+    for (int i = 0; i < m_sliceCount; ++i)
+        dtFreeNavMeshQuery(m_queries[i]);
+    dtFree(m_queries);
+    dtFree(m_sliceOwners);
+    dtFree(m_requests);
+    dtFree(m_paths);
+    dtFree(m_freeSlots);
+
+    m_queries = 0;
+    m_sliceOwners = 0;
+    m_sliceCount = 0;
+    m_nextSlice = 0;
+    m_requests = 0;
+    m_paths = 0;
+    m_maxRequests = 0;
+    m_maxPathSize = 0;
+    m_freeSlots = 0;
+    m_freeCount = 0;
+    m_queuedCount = 0;
+}
+
+dtStatus rcnPathScheduler::init(const dtNavMesh* navmesh
+    , int maxNodes
+    , int sliceCount
+    , int maxRequests
+    , int maxPathSize)
+{
+    purge();
+
+    if (!navmesh 
+        || maxNodes < 1 
+        || sliceCount < 1 
+        || maxRequests < 1 
+        || maxRequests > RCN_PATHSCHED_MAX_REQUESTS
+        || maxPathSize < 1)
+    {
+        return DT_FAILURE | DT_INVALID_PARAM;
+    }
+
+    m_queries = (dtNavMeshQuery**)dtAlloc(
+        sizeof(dtNavMeshQuery*) * sliceCount, DT_ALLOC_PERM, DT_ALLOC_TAG_PATH_QUEUE);
+    m_sliceOwners = (int*)dtAlloc(sizeof(int) * sliceCount, DT_ALLOC_PERM, DT_ALLOC_TAG_PATH_QUEUE);
+    m_requests = (Request*)dtAlloc(sizeof(Request) * maxRequests, DT_ALLOC_PERM, DT_ALLOC_TAG_PATH_QUEUE);
+    m_paths = (dtPolyRef*)dtAlloc(
+        sizeof(dtPolyRef) * maxRequests * maxPathSize, DT_ALLOC_PERM, DT_ALLOC_TAG_PATH_QUEUE);
+    m_freeSlots = (int*)dtAlloc(sizeof(int) * maxRequests, DT_ALLOC_PERM, DT_ALLOC_TAG_PATH_QUEUE);
+
+    if (!m_queries || !m_sliceOwners || !m_requests || !m_paths || !m_freeSlots)
+    {
+        purge();
+        return DT_FAILURE | DT_OUT_OF_MEMORY;
+    }
+
+    for (int i = 0; i < sliceCount; ++i)
+    {
+        dtNavMeshQuery* query = dtAllocNavMeshQuery();
+        if (!query)
+        {
+            purge();
+            return DT_FAILURE | DT_OUT_OF_MEMORY;
+        }
+
+        m_queries[m_sliceCount++] = query;
+        m_sliceOwners[i] = -1;
+
+        dtStatus status = query->init(navmesh, maxNodes);
+        if (dtStatusFailed(status))
+        {
+            purge();
+            return status;
+        }
+    }
+
+    memset(m_requests, 0, sizeof(Request) * maxRequests);
+    m_maxRequests = maxRequests;
+    m_maxPathSize = maxPathSize;
+
+    // Pushed in reverse so the low slots are used first.
+    for (int i = 0; i < maxRequests; ++i)
+    {
+        m_requests[i].salt = 1;
+        m_requests[i].slice = -1;
+        m_freeSlots[i] = maxRequests - 1 - i;
+    }
+    m_freeCount = maxRequests;
+
+    m_nextSlice = 0;
+    m_nextSequence = 0;
+    m_tick = 0;
+    resetStats();
+
+    return DT_SUCCESS;
+}
+
+rcnPathTicket rcnPathScheduler::getTicket(int slot) const
+{
+    return ((rcnPathTicket)m_requests[slot].salt << TICKET_SLOT_BITS)
+        | (rcnPathTicket)slot;
+}
+
+int rcnPathScheduler::findSlot(rcnPathTicket ticket) const
+{
+    const int slot = (int)(ticket & TICKET_SLOT_MASK);
+    if (slot >= m_maxRequests)
+        return -1;
+
+    const Request& q = m_requests[slot];
+    if (q.state == REQUEST_FREE || getTicket(slot) != ticket)
+        return -1;
+
+    return slot;
+}
+
+int rcnPathScheduler::findNextRequest() const
+{
+    // Highest priority first, oldest first among equals.
+    int best = -1;
+    for (int i = 0; i < m_maxRequests; ++i)
+    {
+        const Request& q = m_requests[i];
+        if (q.state != REQUEST_QUEUED)
+            continue;
+        if (best != -1)
+        {
+            const Request& b = m_requests[best];
+            if (q.priority < b.priority)
+                continue;
+            if (q.priority == b.priority 
+                && q.sequence - b.sequence < b.sequence - q.sequence)
+            {
+                continue;
+            }
+        }
+        best = i;
+    }
+    return best;
+}
+
+void rcnPathScheduler::startRequest(int slot, int slice)
+{
+    Request& q = m_requests[slot];
+
+    m_queuedCount--;
+    q.state = REQUEST_RUNNING;
+    q.slice = slice;
+    m_sliceOwners[slice] = slot;
+
+    q.status = m_queries[slice]->initSlicedFindPath(q.start.polyRef
+        , q.end.polyRef
+        , q.start.point
+        , q.end.point
+        , q.filter
+        , q.options);
+
+    if (!dtStatusInProgress(q.status))
+        finishRequest(slot);
+}
+
+void rcnPathScheduler::finishRequest(int slot)
+{
+    Request& q = m_requests[slot];
+
+    if (q.slice != -1)
+    {
+        if (dtStatusSucceed(q.status))
+        {
+            q.status = m_queries[q.slice]->finalizeSlicedFindPath(
+                &m_paths[slot * m_maxPathSize], &q.pathCount, m_maxPathSize);
+
+            if (m_cache && q.status == DT_SUCCESS)
+            {
+                m_cache->store(q.start.polyRef, q.end.polyRef, q.filter
+                    , &m_paths[slot * m_maxPathSize], q.pathCount);
+            }
+        }
+        m_sliceOwners[q.slice] = -1;
+        q.slice = -1;
+    }
+
+    q.state = REQUEST_DONE;
+    q.reported = false;
+
+    const int wait = (int)(m_tick - q.requestTick);
+    m_completedCount++;
+    m_totalWaitTicks += (unsigned int)wait;
+    m_maxWaitTicks = dtMax(m_maxWaitTicks, wait);
+}
+
+void rcnPathScheduler::freeRequest(int slot)
+{
+    Request& q = m_requests[slot];
+
+    if (q.state == REQUEST_QUEUED)
+        m_queuedCount--;
+    else if (q.slice != -1)
+        m_sliceOwners[q.slice] = -1;
+
+    q.state = REQUEST_FREE;
+    q.slice = -1;
+    q.filter = 0;
+
+    // Invalidates the tickets that refer to the slot.
+    q.salt++;
+    if (q.salt == 0)
+        q.salt = 1;
+
+    m_freeSlots[m_freeCount++] = slot;
+}
+
+void rcnPathScheduler::report(int slot
+    , rcnPathTicket* completed
+    , int maxCompleted
+    , int* count)
+{
+    if (!completed || *count >= maxCompleted)
+        return;
+
+    completed[(*count)++] = getTicket(slot);
+    m_requests[slot].reported = true;
+}
+
+rcnPathTicket rcnPathScheduler::request(const rcnNavmeshPoint& start
+    , const rcnNavmeshPoint& end
+    , const dtQueryFilter* filter
+    , float priority
+    , unsigned int options)
+{
+    if (!filter || m_freeCount == 0)
+    {
+        m_rejectedCount++;
+        return RCN_PATH_TICKET_INVALID;
+    }
+
+    int running = 0;
+    for (int i = 0; i < m_sliceCount; ++i)
+    {
+        if (m_sliceOwners[i] != -1)
+            running++;
+    }
+    m_maxPendingCount = dtMax(m_maxPendingCount, m_queuedCount + running + 1);
+
+    const int slot = m_freeSlots[--m_freeCount];
+
+    Request& q = m_requests[slot];
+    q.start = start;
+    q.end = end;
+    q.filter = filter;
+    q.options = options;
+    q.priority = priority;
+    q.sequence = m_nextSequence++;
+    q.requestTick = m_tick;
+    q.status = 0;
+    q.pathCount = 0;
+    q.slice = -1;
+    q.state = REQUEST_QUEUED;
+    q.reported = false;
+    m_queuedCount++;
+
+    // A cached path completes the request without using a query.
+    if (m_cache && m_cache->find(start.polyRef, end.polyRef, filter
+        , &m_paths[slot * m_maxPathSize], &q.pathCount, m_maxPathSize))
+    {
+        m_queuedCount--;
+        q.status = DT_SUCCESS;
+        finishRequest(slot);
+    }
+
+    return getTicket(slot);
+}
+
+dtStatus rcnPathScheduler::pump(int maxIters
+    , float maxTime
+    , rcnPathTicket* completed
+    , int maxCompleted
+    , int* completedCount)
+{
+    // Pathfinder iterations between checks of the time budget.
+    static const int TIME_SLICE_ITERS = 16;
+
+    if (!completedCount)
+        return DT_FAILURE | DT_INVALID_PARAM;
+
+    *completedCount = 0;
+
+    if (!m_sliceCount 
+        || (maxIters <= 0 && maxTime <= 0)
+        || (completed && maxCompleted < 1))
+    {
+        return DT_FAILURE | DT_INVALID_PARAM;
+    }
+
+    const dtStatus readStatus = m_queries[0]->beginRead();
+    if (dtStatusFailed(readStatus))
+        return readStatus;
+
+    const double startTime = getTimeUsec();
+    m_tick++;
+
+    int count = 0;
+
+    // Completions that could not be reported earlier, and cache hits.
+    for (int i = 0; i < m_maxRequests && completed; ++i)
+    {
+        const Request& q = m_requests[i];
+        if (q.state == REQUEST_DONE && !q.reported)
+            report(i, completed, maxCompleted, &count);
+    }
+
+    const int maxCount = completed ? maxCompleted : 0x7fffffff;
+    const int budget = maxIters > 0 ? maxIters : 0x7fffffff;
+    int iterCount = budget;
+    bool stop = false;
+
+    while (!stop && iterCount > 0 && count < maxCount)
+    {
+        // Start queued requests on the free queries.
+        int running = 0;
+        for (int i = 0; i < m_sliceCount; ++i)
+        {
+            while (m_sliceOwners[i] == -1 && m_queuedCount > 0 && count < maxCount)
+            {
+                const int slot = findNextRequest();
+                startRequest(slot, i);
+                if (m_requests[slot].state == REQUEST_DONE)
+                    report(slot, completed, maxCompleted, &count);
+            }
+            if (m_sliceOwners[i] != -1)
+                running++;
+        }
+
+        if (running == 0)
+            break;
+
+        // Share the remaining budget evenly.  The rotation gives each query
+        // its turn when the budget is smaller than the number of searches.
+        int share = dtMax(1, iterCount / running);
+        if (maxTime > 0)
+            share = dtMin(share, TIME_SLICE_ITERS);
+
+        for (int n = 0; n < m_sliceCount && !stop; ++n)
+        {
+            const int i = (m_nextSlice + n) % m_sliceCount;
+            const int slot = m_sliceOwners[i];
+            if (slot == -1)
+                continue;
+
+            Request& q = m_requests[slot];
+            int iters = 0;
+            q.status = m_queries[i]->updateSlicedFindPath(
+                dtMin(share, iterCount), &iters);
+            iterCount -= dtMax(iters, 1);
+
+            if (!dtStatusInProgress(q.status))
+            {
+                finishRequest(slot);
+                report(slot, completed, maxCompleted, &count);
+            }
+
+            if (iterCount <= 0 
+                || count >= maxCount
+                || (maxTime > 0 && getTimeUsec() - startTime >= maxTime))
+            {
+                stop = true;
+            }
+        }
+
+        m_nextSlice = (m_nextSlice + 1) % m_sliceCount;
+    }
+
+    m_queries[0]->endRead();
+
+    *completedCount = count;
+
+    m_lastIterCount = budget - dtMax(iterCount, 0);
+    m_lastUpdateTime = (float)(getTimeUsec() - startTime);
+
+    if (completed && count >= maxCompleted)
+    {
+        // Only report an overflow if there is something left to report.
+        for (int i = 0; i < m_maxRequests; ++i)
+        {
+            const Request& q = m_requests[i];
+            if (q.state == REQUEST_DONE && !q.reported)
+                return DT_SUCCESS | DT_BUFFER_TOO_SMALL;
+        }
+    }
+
+    return DT_SUCCESS;
+}
+
+dtStatus rcnPathScheduler::getRequestStatus(rcnPathTicket ticket) const
+{
+    const int slot = findSlot(ticket);
+    if (slot == -1)
+        return DT_FAILURE | DT_INVALID_PARAM;
+
+    const Request& q = m_requests[slot];
+    return q.state == REQUEST_DONE ? q.status : 0;
+}
+
+dtStatus rcnPathScheduler::getPathResult(rcnPathTicket ticket
+    , dtPolyRef* path
+    , int* pathCount
+    , int maxPath)
+{
+    if (!path || !pathCount || maxPath < 1)
+        return DT_FAILURE | DT_INVALID_PARAM;
+
+    *pathCount = 0;
+
+    const int slot = findSlot(ticket);
+    if (slot == -1)
+        return DT_FAILURE | DT_INVALID_PARAM;
+
+    const Request& q = m_requests[slot];
+    if (q.state != REQUEST_DONE)
+        return DT_IN_PROGRESS;
+
+    dtStatus status = q.status;
+    if (dtStatusSucceed(status))
+    {
+        const int n = dtMin(q.pathCount, maxPath);
+        memcpy(path, &m_paths[slot * m_maxPathSize], sizeof(dtPolyRef) * n);
+        *pathCount = n;
+        if (n < q.pathCount)
+            status |= DT_BUFFER_TOO_SMALL;
+    }
+
+    freeRequest(slot);
+
+    return status;
+}
+
+dtStatus rcnPathScheduler::cancel(rcnPathTicket ticket)
+{
+    const int slot = findSlot(ticket);
+    if (slot == -1)
+        return DT_FAILURE | DT_INVALID_PARAM;
+
+    freeRequest(slot);
+
+    return DT_SUCCESS;
+}
+
+void rcnPathScheduler::getStats(dtPathQueueStats* stats) const
+{
+    if (!stats)
+        return;
+
+    stats->maxQueue = m_maxRequests;
+    stats->pendingCount = m_queuedCount;
+    for (int i = 0; i < m_sliceCount; ++i)
+    {
+        if (m_sliceOwners[i] != -1)
+            stats->pendingCount++;
+    }
+    stats->readyCount = m_maxRequests - m_freeCount - stats->pendingCount;
+    stats->maxPendingCount = m_maxPendingCount;
+    stats->rejectedCount = m_rejectedCount;
+    stats->completedCount = m_completedCount;
+    stats->maxWaitTicks = m_maxWaitTicks;
+    stats->avgWaitTicks = m_completedCount
+        ? (float)m_totalWaitTicks / (float)m_completedCount : 0.0f;
+    stats->lastIterCount = m_lastIterCount;
+    stats->lastUpdateTime = m_lastUpdateTime;
+}
+
+void rcnPathScheduler::resetStats()
+{
+    m_maxPendingCount = 0;
+    m_rejectedCount = 0;
+    m_completedCount = 0;
+    m_maxWaitTicks = 0;
+    m_totalWaitTicks = 0;
+    m_lastIterCount = 0;
+    m_lastUpdateTime = 0;
+}
+
+extern "C"
+{
+    EXPORT_API dtStatus dtpsAlloc(const dtNavMesh* navmesh
+        , const int maxNodes
+        , const int sliceCount
+        , const int maxRequests
+        , const int maxPathSize
+        , rcnPathScheduler** ppScheduler)
+    {
+        if (!ppScheduler)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        *ppScheduler = 0;
+
+        rcnPathScheduler* scheduler = rcnAllocPathScheduler();
+        if (!scheduler)
+            return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+        dtStatus status = scheduler->init(navmesh
+            , maxNodes
+            , sliceCount
+            , maxRequests
+            , maxPathSize);
+
+        if (dtStatusFailed(status))
+        {
+            rcnFreePathScheduler(scheduler);
+            return status;
+        }
+
+        *ppScheduler = scheduler;
+
+        return DT_SUCCESS;
+    }
+
+    EXPORT_API void dtpsFree(rcnPathScheduler* scheduler)
+    {
+        rcnFreePathScheduler(scheduler);
+    }
+
+    EXPORT_API rcnPathTicket dtpsRequest(rcnPathScheduler* scheduler
+        , rcnNavmeshPoint startPos
+        , rcnNavmeshPoint endPos
+        , const dtQueryFilter* filter
+        , const float priority
+        , const unsigned int options)
+    {
+        if (!scheduler)
+            return RCN_PATH_TICKET_INVALID;
+
+        return scheduler->request(startPos, endPos, filter, priority, options);
+    }
+
+    EXPORT_API dtStatus dtpsPump(rcnPathScheduler* scheduler
+        , const int maxIters
+        , const float maxTime
+        , rcnPathTicket* completed
+        , const int maxCompleted
+        , int* completedCount)
+    {
+        if (!scheduler)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        return scheduler->pump(maxIters
+            , maxTime
+            , completed
+            , maxCompleted
+            , completedCount);
+    }
+
+    EXPORT_API dtStatus dtpsGetRequestStatus(rcnPathScheduler* scheduler
+        , const rcnPathTicket ticket)
+    {
+        if (!scheduler)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        return scheduler->getRequestStatus(ticket);
+    }
+
+    EXPORT_API dtStatus dtpsGetPathResult(rcnPathScheduler* scheduler
+        , const rcnPathTicket ticket
+        , dtPolyRef* path
+        , int* pathCount
+        , const int maxPath)
+    {
+        if (!scheduler)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        return scheduler->getPathResult(ticket, path, pathCount, maxPath);
+    }
+
+    EXPORT_API dtStatus dtpsCancel(rcnPathScheduler* scheduler
+        , const rcnPathTicket ticket)
+    {
+        if (!scheduler)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        return scheduler->cancel(ticket);
+    }
+
+    EXPORT_API void dtpsSetPathCache(rcnPathScheduler* scheduler
+        , dtPathCache* cache)
+    {
+        if (scheduler)
+            scheduler->setPathCache(cache);
+    }
+
+    EXPORT_API void dtpsGetStats(rcnPathScheduler* scheduler
+        , dtPathQueueStats* stats)
+    {
+        if (scheduler)
+            scheduler->getStats(stats);
+    }
+
+    EXPORT_API void dtpsResetStats(rcnPathScheduler* scheduler)
+    {
+        if (scheduler)
+            scheduler->resetStats();
+    }
+}
@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <new>
+#include "DetourPathSolverEx.h"
+#include "DetourAlloc.h"
+#include "DetourCommon.h"
+
+struct rcnPathBatch
+{
+    dtNavMeshQuery** queries;
+    const rcnPathRequest* requests;
+    const dtQueryFilter* const* filters;
+    int filterCount;
+    dtPolyRef* paths;
+    int maxPath;
+    float* straightPaths;
+    int maxStraightPath;
+    rcnPathResult* results;
+};
+
+static void solvePath(void* userData, int taskIndex, int workerIndex)
+{
+    const rcnPathBatch& batch = *(const rcnPathBatch*)userData;
+    const rcnPathRequest& request = batch.requests[taskIndex];
+    rcnPathResult& result = batch.results[taskIndex];
+    dtNavMeshQuery* query = batch.queries[workerIndex];
+
+    result.pathCount = 0;
+    result.straightPathCount = 0;
+
+    if (request.filterIndex < 0 || request.filterIndex >= batch.filterCount)
+    {
+        result.status = DT_FAILURE | DT_INVALID_PARAM;
+        return;
+    }
+
+    const dtQueryFilter* filter = batch.filters[request.filterIndex];
+    dtPolyRef* path = &batch.paths[taskIndex * batch.maxPath];
+
+    result.status = query->findPath(request.start.polyRef
+        , request.end.polyRef
+        , request.start.point
+        , request.end.point
+        , filter
+        , path
+        , &result.pathCount
+        , batch.maxPath);
+
+    if (dtStatusFailed(result.status) 
+        || !batch.straightPaths 
+        || result.pathCount == 0)
+    {
+        return;
+    }
+
+    // The path may be partial, so clamp the end point to the last polygon.
+    float endPos[3];
+    dtVcopy(endPos, request.end.point);
+    if (path[result.pathCount - 1] != request.end.polyRef)
+    {
+        query->closestPointOnPoly(path[result.pathCount - 1]
+            , request.end.point
+            , endPos
+            , 0);
+    }
+
+    dtStatus status = query->findStraightPath(request.start.point
+        , endPos
+        , path
+        , result.pathCount
+        , &batch.straightPaths[taskIndex * batch.maxStraightPath * 3]
+        , 0
+        , 0
+        , &result.straightPathCount
+        , batch.maxStraightPath);
+
+    if (dtStatusFailed(status))
+        result.status = status;
+}
+
+rcnPathSolver* rcnAllocPathSolver()
+{
+    void* mem = dtAlloc(sizeof(rcnPathSolver), DT_ALLOC_PERM, DT_ALLOC_TAG_QUERY);
+    if (!mem) return 0;
+    return new(mem) rcnPathSolver;
+}
+
+void rcnFreePathSolver(rcnPathSolver* solver)
+{
+    if (!solver) return;
+    solver->~rcnPathSolver();
+    dtFree(solver);
+}
+
+rcnPathSolver::rcnPathSolver()
+    : m_queries(0)
+    , m_queryCount(0)
+{
+}
+
+rcnPathSolver::~rcnPathSolver()
+{
+    purge();
+}
+
+void rcnPathSolver::purge()
+{
+    m_pool.purge();
+
+    for (int i = 0; i < m_queryCount; ++i)
+        dtFreeNavMeshQuery(m_queries[i]);
+    dtFree(m_queries);
+
+    m_queries = 0;
+    m_queryCount = 0;
+}
+
+dtStatus rcnPathSolver::init(const dtNavMesh* navmesh
+    , int maxNodes
+    , int threadCount)
+{
+    purge();
+
+    if (!navmesh || maxNodes < 1 || threadCount < 0)
+        return DT_FAILURE | DT_INVALID_PARAM;
+
+    const int queryCount = threadCount + 1;
+
+    m_queries = (dtNavMeshQuery**)dtAlloc(
+        sizeof(dtNavMeshQuery*) * queryCount, DT_ALLOC_PERM, DT_ALLOC_TAG_QUERY);
+    if (!m_queries)
+        return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+    for (int i = 0; i < queryCount; ++i)
+    {
+        dtNavMeshQuery* query = dtAllocNavMeshQuery();
+        if (!query)
+        {
+            purge();
+            return DT_FAILURE | DT_OUT_OF_MEMORY;
+        }
+
+        m_queries[m_queryCount++] = query;
+
+        dtStatus status = query->init(navmesh, maxNodes);
+        if (dtStatusFailed(status))
+        {
+            purge();
+            return status;
+        }
+    }
+
+    if (!m_pool.init(threadCount))
+    {
+        purge();
+        return DT_FAILURE | DT_OUT_OF_MEMORY;
+    }
+
+    return DT_SUCCESS;
+}
+
+dtStatus rcnPathSolver::solve(const rcnPathRequest* requests
+    , const int requestCount
+    , const dtQueryFilter* const* filters
+    , const int filterCount
+    , dtPolyRef* paths
+    , const int maxPath
+    , float* straightPaths
+    , const int maxStraightPath
+    , rcnPathResult* results)
+{
+    if (!m_queryCount
+        || !requests
+        || requestCount < 0
+        || !filters
+        || filterCount < 1
+        || !paths
+        || maxPath < 1
+        || (straightPaths && maxStraightPath < 1)
+        || !results)
+    {
+        return DT_FAILURE | DT_INVALID_PARAM;
+    }
+
+    rcnPathBatch batch;
+    batch.queries = m_queries;
+    batch.requests = requests;
+    batch.filters = filters;
+    batch.filterCount = filterCount;
+    batch.paths = paths;
+    batch.maxPath = maxPath;
+    batch.straightPaths = straightPaths;
+    batch.maxStraightPath = maxStraightPath;
+    batch.results = results;
+
+    // The workers only read while the batch runs, so one read covers them all.
+    const dtStatus readStatus = m_queries[0]->beginRead();
+    if (dtStatusFailed(readStatus))
+        return readStatus;
+
+    m_pool.parallelFor(solvePath, &batch, requestCount);
+    m_queries[0]->endRead();
+
+    return DT_SUCCESS;
+}
+
+extern "C"
+{
+    EXPORT_API dtStatus dtnqBuildPathSolver(const dtNavMesh* navmesh
+        , const int maxNodes
+        , const int threadCount
+        , rcnPathSolver** ppSolver)
+    {
+        if (!ppSolver)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        *ppSolver = 0;
+
+        rcnPathSolver* solver = rcnAllocPathSolver();
+        if (!solver)
+            return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+        dtStatus status = solver->init(navmesh, maxNodes, threadCount);
+        if (dtStatusFailed(status))
+        {
+            rcnFreePathSolver(solver);
+            return status;
+        }
+
+        *ppSolver = solver;
+
+        return DT_SUCCESS;
+    }
+
+    EXPORT_API void dtnqFreePathSolver(rcnPathSolver* solver)
+    {
+        rcnFreePathSolver(solver);
+    }
+
+    EXPORT_API dtStatus dtqSolvePaths(rcnPathSolver* solver
+        , const rcnPathRequest* requests
+        , const int requestCount
+        , const dtQueryFilter* const* filters
+        , const int filterCount
+        , dtPolyRef* paths
+        , const int maxPath
+        , float* straightPaths
+        , const int maxStraightPath
+        , rcnPathResult* results)
+    {
+        if (!solver)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        return solver->solve(requests
+            , requestCount
+            , filters
+            , filterCount
+            , paths
+            , maxPath
+            , straightPaths
+            , maxStraightPath
+            , results);
+    }
+}
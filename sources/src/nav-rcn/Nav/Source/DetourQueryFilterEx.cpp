@@ -19,6 +19,8 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  */
+#include <new>
+#include "DetourAlloc.h"
 #include "DetourNavMeshQuery.h"
 #include "DetourEx.h"
 
@@ -26,13 +28,20 @@ extern "C"
 {
     EXPORT_API dtQueryFilter* dtqfAlloc()
     {
-        return new dtQueryFilter();
+        void* mem = dtAlloc(sizeof(dtQueryFilter), DT_ALLOC_PERM, DT_ALLOC_TAG_QUERY);
+        if (!mem)
+            return 0;
+
+        return new(mem) dtQueryFilter();
     }
     
     EXPORT_API void dtqfFree(dtQueryFilter* filter)
     {
-        if (filter)
-             filter->~dtQueryFilter();
+        if (!filter)
+            return;
+
+        filter->~dtQueryFilter();
+        dtFree(filter);
     }
     
     EXPORT_API void dtqfSetAreaCost(dtQueryFilter* filter
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <string.h>
+#include "DetourRaycastCache.h"
+#include "DetourThreadPoolEx.h"
+#include "DetourEx.h"
+
+extern "C"
+{
+    EXPORT_API dtStatus dtrcAlloc(const dtNavMesh* navmesh
+        , const int maxEntries
+        , const float quantum
+        , dtRaycastCache** ppCache)
+    {
+        if (!ppCache)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        *ppCache = 0;
+
+        dtRaycastCache* cache = dtAllocRaycastCache();
+        if (!cache)
+            return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+        dtStatus status = cache->init(navmesh, maxEntries, quantum);
+        if (dtStatusFailed(status))
+        {
+            dtFreeRaycastCache(cache);
+            return status;
+        }
+
+        *ppCache = cache;
+
+        return DT_SUCCESS;
+    }
+
+    EXPORT_API void dtrcFree(dtRaycastCache* cache)
+    {
+        dtFreeRaycastCache(cache);
+    }
+
+    EXPORT_API bool dtrcSetThreadPool(dtRaycastCache* cache, rcnThreadPool* pool)
+    {
+        // Design note: The pool can be shared with crowds, as long as they
+        // are not updated during a batch.  A null pool casts the misses on
+        // the calling thread.
+        if (!cache)
+            return false;
+        return cache->setTaskScheduler(pool);
+    }
+
+    EXPORT_API dtStatus dtrcRaycastBatch(dtRaycastCache* cache
+        , const dtPolyRef* startRefs
+        , const float* startPositions
+        , const float* endPositions
+        , const dtQueryFilter* const* filters
+        , const int filterCount
+        , const int* filterIndices
+        , const int count
+        , float* resultParams
+        , float* resultNormals       // Optional
+        , dtStatus* resultStatus)
+    {
+        /* 
+         * Design notes:
+         * 
+         * Same arguments as dtqRaycastBatch, so a perception system can 
+         * switch between the two.  The cache owns its queries, one per
+         * pool worker, so no query is passed.
+         * 
+         * The status of a ray never has DT_BUFFER_TOO_SMALL, since the
+         * path is not returned.
+         */
+
+        if (!cache)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        return cache->raycastBatch(startRefs
+            , startPositions
+            , endPositions
+            , filters
+            , filterCount
+            , filterIndices
+            , count
+            , resultParams
+            , resultNormals
+            , resultStatus);
+    }
+
+    EXPORT_API void dtrcClear(dtRaycastCache* cache)
+    {
+        if (cache)
+            cache->clear();
+    }
+
+    EXPORT_API void dtrcGetStats(const dtRaycastCache* cache
+        , dtRaycastCacheStats* stats)
+    {
+        if (cache)
+            cache->getStats(stats);
+    }
+
+    EXPORT_API void dtrcResetStats(dtRaycastCache* cache)
+    {
+        if (cache)
+            cache->resetStats();
+    }
+}
@@ -0,0 +1,379 @@
+/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "DetourThreadPoolEx.h"
+#include "DetourAlloc.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+// Design note: nmgThreadPool in nmgen-rcn (ThreadPool.cpp) is a copy of 
+// this pool for the rcTaskScheduler interface, since that library can't
+// link Detour.  Fixes to the worker or wait logic belong in both files.
+
+// Minimal platform wrappers.  Only the parts the pool needs.
+
+#if defined(_WIN32)
+
+struct rcnMutex { CRITICAL_SECTION cs; };
+struct rcnCondition { CONDITION_VARIABLE cv; };
+typedef HANDLE rcnThread;
+
+static void initMutex(rcnMutex& m) { InitializeCriticalSection(&m.cs); }
+static void freeMutex(rcnMutex& m) { DeleteCriticalSection(&m.cs); }
+static void lock(rcnMutex& m) { EnterCriticalSection(&m.cs); }
+static void unlock(rcnMutex& m) { LeaveCriticalSection(&m.cs); }
+
+static void initCondition(rcnCondition& c) { InitializeConditionVariable(&c.cv); }
+static void freeCondition(rcnCondition&) { }
+static void wait(rcnCondition& c, rcnMutex& m) 
+{ 
+    SleepConditionVariableCS(&c.cv, &m.cs, INFINITE); 
+}
+static void broadcast(rcnCondition& c) { WakeAllConditionVariable(&c.cv); }
+
+#else
+
+struct rcnMutex { pthread_mutex_t mutex; };
+struct rcnCondition { pthread_cond_t cond; };
+typedef pthread_t rcnThread;
+
+static void initMutex(rcnMutex& m) { pthread_mutex_init(&m.mutex, 0); }
+static void freeMutex(rcnMutex& m) { pthread_mutex_destroy(&m.mutex); }
+static void lock(rcnMutex& m) { pthread_mutex_lock(&m.mutex); }
+static void unlock(rcnMutex& m) { pthread_mutex_unlock(&m.mutex); }
+
+static void initCondition(rcnCondition& c) { pthread_cond_init(&c.cond, 0); }
+static void freeCondition(rcnCondition& c) { pthread_cond_destroy(&c.cond); }
+static void wait(rcnCondition& c, rcnMutex& m) 
+{ 
+    pthread_cond_wait(&c.cond, &m.mutex); 
+}
+static void broadcast(rcnCondition& c) { pthread_cond_broadcast(&c.cond); }
+
+#endif
+
+int rcnGetProcessorCount()
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    const int count = (int)info.dwNumberOfProcessors;
+#else
+    const int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return count > 0 ? count : 1;
+}
+
+// The unclaimed task indices of a worker.
+struct rcnTaskRange
+{
+    rcnMutex mutex;
+    int begin;
+    int end;
+};
+
+struct rcnThreadPoolState;
+
+struct rcnWorkerStart
+{
+    rcnThreadPoolState* state;
+    int workerIndex;
+};
+
+struct rcnThreadPoolState
+{
+    rcnMutex mutex;
+    rcnCondition wake;      // Signaled when a loop starts or on shutdown.
+    rcnCondition done;      // Signaled when the last thread finishes a loop.
+
+    rcnThread* threads;
+    rcnWorkerStart* starts;
+    rcnTaskRange* ranges;   // One per worker.
+    int threadCount;
+
+    rcnTaskFunc func;
+    void* userData;
+    int generation;         // Incremented for each loop.
+    int busyCount;          // Threads still working on the current loop.
+    bool shutdown;
+};
+
+// Claims the next index of the worker's range, stealing from other workers 
+// as needed.  Returns -1 when no tasks remain.
+static int claimTask(rcnThreadPoolState* state, int workerIndex)
+{
+    const int workerCount = state->threadCount + 1;
+    rcnTaskRange& own = state->ranges[workerIndex];
+
+    lock(own.mutex);
+    if (own.begin < own.end)
+    {
+        const int index = own.begin++;
+        unlock(own.mutex);
+        return index;
+    }
+    unlock(own.mutex);
+
+    for (int i = 1; i < workerCount; ++i)
+    {
+        rcnTaskRange& victim = state->ranges[(workerIndex + i) % workerCount];
+
+        lock(victim.mutex);
+        const int remaining = victim.end - victim.begin;
+        if (remaining <= 0)
+        {
+            unlock(victim.mutex);
+            continue;
+        }
+
+        // Take the upper half. (Or the last index.)
+        const int stolenBegin = victim.end - (remaining + 1) / 2;
+        const int stolenEnd = victim.end;
+        victim.end = stolenBegin;
+        unlock(victim.mutex);
+
+        lock(own.mutex);
+        own.begin = stolenBegin + 1;
+        own.end = stolenEnd;
+        unlock(own.mutex);
+
+        return stolenBegin;
+    }
+
+    return -1;
+}
+
+static void runTasks(rcnThreadPoolState* state, int workerIndex)
+{
+    for (int i = claimTask(state, workerIndex); 
+        i >= 0; 
+        i = claimTask(state, workerIndex))
+    {
+        state->func(state->userData, i, workerIndex);
+    }
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI workerMain(void* arg)
+#else
+static void* workerMain(void* arg)
+#endif
+{
+    rcnWorkerStart* start = (rcnWorkerStart*)arg;
+    rcnThreadPoolState* state = start->state;
+
+    // Design note: Starts from zero rather than the current generation, 
+    // in case a loop was started before this thread got here.
+    int seen = 0;
+
+    lock(state->mutex);
+    for (;;)
+    {
+        while (state->generation == seen && !state->shutdown)
+            wait(state->wake, state->mutex);
+
+        if (state->shutdown)
+            break;
+
+        seen = state->generation;
+        unlock(state->mutex);
+
+        runTasks(state, start->workerIndex);
+
+        lock(state->mutex);
+        if (--state->busyCount == 0)
+            broadcast(state->done);
+    }
+    unlock(state->mutex);
+
+    return 0;
+}
+
+rcnThreadPool::rcnThreadPool()
+    : m_state(0)
+    , m_threadCount(0)
+{
+}
+
+rcnThreadPool::~rcnThreadPool()
+{
+    purge();
+}
+
+void rcnThreadPool::purge()
+{
+    rcnThreadPoolState* state = m_state;
+    if (!state)
+        return;
+
+    lock(state->mutex);
+    state->shutdown = true;
+    broadcast(state->wake);
+    unlock(state->mutex);
+
+    for (int i = 0; i < state->threadCount; ++i)
+    {
+#if defined(_WIN32)
+        WaitForSingleObject(state->threads[i], INFINITE);
+        CloseHandle(state->threads[i]);
+#else
+        pthread_join(state->threads[i], 0);
+#endif
+    }
+
+    for (int i = 0; i < m_threadCount + 1; ++i)
+        freeMutex(state->ranges[i].mutex);
+
+    freeCondition(state->done);
+    freeCondition(state->wake);
+    freeMutex(state->mutex);
+
+    dtFree(state->threads);
+    dtFree(state->starts);
+    dtFree(state->ranges);
+    dtFree(state);
+
+    m_state = 0;
+    m_threadCount = 0;
+}
+
+bool rcnThreadPool::init(int threadCount)
+{
+    purge();
+
+    if (threadCount < 0)
+        return false;
+
+    rcnThreadPoolState* state = 
+        (rcnThreadPoolState*)dtAlloc(sizeof(rcnThreadPoolState), DT_ALLOC_PERM);
+    if (!state)
+        return false;
+
+    state->threads = 
+        (rcnThread*)dtAlloc(sizeof(rcnThread) * (threadCount + 1), DT_ALLOC_PERM);
+    state->starts = (rcnWorkerStart*)dtAlloc(
+        sizeof(rcnWorkerStart) * (threadCount + 1), DT_ALLOC_PERM);
+    state->ranges = (rcnTaskRange*)dtAlloc(
+        sizeof(rcnTaskRange) * (threadCount + 1), DT_ALLOC_PERM);
+
+    if (!state->threads || !state->starts || !state->ranges)
+    {
+        dtFree(state->threads);
+        dtFree(state->starts);
+        dtFree(state->ranges);
+        dtFree(state);
+        return false;
+    }
+
+    initMutex(state->mutex);
+    initCondition(state->wake);
+    initCondition(state->done);
+    for (int i = 0; i < threadCount + 1; ++i)
+    {
+        initMutex(state->ranges[i].mutex);
+        state->ranges[i].begin = 0;
+        state->ranges[i].end = 0;
+    }
+
+    state->threadCount = 0;
+    state->func = 0;
+    state->userData = 0;
+    state->generation = 0;
+    state->busyCount = 0;
+    state->shutdown = false;
+
+    m_state = state;
+    m_threadCount = threadCount;
+
+    // Worker zero is the thread that calls parallelFor.
+    for (int i = 0; i < threadCount; ++i)
+    {
+        rcnWorkerStart& start = state->starts[i];
+        start.state = state;
+        start.workerIndex = i + 1;
+
+#if defined(_WIN32)
+        state->threads[i] = CreateThread(0, 0, workerMain, &start, 0, 0);
+        const bool created = (state->threads[i] != 0);
+#else
+        const bool created = 
+            (pthread_create(&state->threads[i], 0, workerMain, &start) == 0);
+#endif
+        if (!created)
+        {
+            purge();
+            return false;
+        }
+        state->threadCount++;
+    }
+
+    return true;
+}
+
+void rcnThreadPool::parallelFor(rcnTaskFunc func, void* userData, int taskCount)
+{
+    if (!func || taskCount <= 0)
+        return;
+
+    rcnThreadPoolState* state = m_state;
+
+    if (!state || state->threadCount == 0 || taskCount == 1)
+    {
+        for (int i = 0; i < taskCount; ++i)
+            func(userData, i, 0);
+        return;
+    }
+
+    const int workerCount = state->threadCount + 1;
+
+    // Design note: No locks needed.  The workers are idle until the
+    // generation changes.
+    const int share = taskCount / workerCount;
+    const int extra = taskCount % workerCount;
+    int begin = 0;
+    for (int i = 0; i < workerCount; ++i)
+    {
+        state->ranges[i].begin = begin;
+        begin += share + (i < extra ? 1 : 0);
+        state->ranges[i].end = begin;
+    }
+
+    lock(state->mutex);
+    state->func = func;
+    state->userData = userData;
+    state->busyCount = state->threadCount;
+    state->generation++;
+    broadcast(state->wake);
+    unlock(state->mutex);
+
+    runTasks(state, 0);
+
+    lock(state->mutex);
+    while (state->busyCount > 0)
+        wait(state->done, state->mutex);
+    unlock(state->mutex);
+}
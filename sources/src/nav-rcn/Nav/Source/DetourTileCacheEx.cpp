@@ -0,0 +1,384 @@
+/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <string.h>
+#include <new>
+#include "DetourTileCache.h"
+#include "DetourTileCacheBuilder.h"
+#include "DetourNavMeshBuilder.h"
+#include "DetourCommon.h"
+#include "DetourEx.h"
+
+/*
+ * Run length (PackBits) compression of the layer grids.  The grids are
+ * mostly long runs of identical heights, areas and connections, so this
+ * gets most of the benefit of a general purpose compressor without
+ * adding a dependency.
+ *
+ * Control byte c:
+ * c < 128:  The next c + 1 bytes are literals.
+ * c >= 128: The next byte is repeated c - 125 times. (3 to 130)
+ */
+class rcnRunLengthCompressor
+    : public dtTileCacheCompressor
+{
+public:
+    static const int MAX_LITERALS = 128;
+    static const int MIN_RUN = 3;
+    static const int MAX_RUN = 130;
+
+    virtual int maxCompressedSize(const int bufferSize)
+    {
+        return bufferSize + (bufferSize + MAX_LITERALS - 1) / MAX_LITERALS;
+    }
+
+    virtual dtStatus compress(const unsigned char* buffer
+        , const int bufferSize
+        , unsigned char* compressed
+        , const int maxCompressedSize
+        , int* compressedSize)
+    {
+        int n = 0;
+        int i = 0;
+        int literalStart = 0;
+
+        while (i < bufferSize)
+        {
+            int run = 1;
+            while (i + run < bufferSize
+                && run < MAX_RUN
+                && buffer[i + run] == buffer[i])
+            {
+                run++;
+            }
+
+            if (run < MIN_RUN)
+            {
+                i += run;
+                if (i - literalStart >= MAX_LITERALS)
+                {
+                    if (!flushLiterals(buffer + literalStart, MAX_LITERALS
+                        , compressed, maxCompressedSize, n))
+                    {
+                        return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+                    }
+                    literalStart += MAX_LITERALS;
+                }
+                continue;
+            }
+
+            if (!flushLiterals(buffer + literalStart, i - literalStart
+                , compressed, maxCompressedSize, n))
+            {
+                return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+            }
+
+            if (n + 2 > maxCompressedSize)
+                return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+
+            compressed[n++] = (unsigned char)(run + 125);
+            compressed[n++] = buffer[i];
+
+            i += run;
+            literalStart = i;
+        }
+
+        if (!flushLiterals(buffer + literalStart, i - literalStart
+            , compressed, maxCompressedSize, n))
+        {
+            return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+        }
+
+        *compressedSize = n;
+
+        return DT_SUCCESS;
+    }
+
+    virtual dtStatus decompress(const unsigned char* compressed
+        , const int compressedSize
+        , unsigned char* buffer
+        , const int maxBufferSize
+        , int* bufferSize)
+    {
+        int n = 0;
+        int i = 0;
+
+        while (i < compressedSize)
+        {
+            const int c = compressed[i++];
+            if (c < MAX_LITERALS)
+            {
+                const int count = c + 1;
+                if (i + count > compressedSize || n + count > maxBufferSize)
+                    return DT_FAILURE | DT_INVALID_PARAM;
+                memcpy(&buffer[n], &compressed[i], count);
+                i += count;
+                n += count;
+            }
+            else
+            {
+                const int count = c - 125;
+                if (i >= compressedSize || n + count > maxBufferSize)
+                    return DT_FAILURE | DT_INVALID_PARAM;
+                memset(&buffer[n], compressed[i++], count);
+                n += count;
+            }
+        }
+
+        *bufferSize = n;
+
+        return DT_SUCCESS;
+    }
+
+private:
+    static bool flushLiterals(const unsigned char* literals
+        , const int count
+        , unsigned char* compressed
+        , const int maxCompressedSize
+        , int& n)
+    {
+        if (count == 0)
+            return true;
+
+        if (n + count + 1 > maxCompressedSize)
+            return false;
+
+        compressed[n++] = (unsigned char)(count - 1);
+        memcpy(&compressed[n], literals, count);
+        n += count;
+
+        return true;
+    }
+};
+
+// Assigns polygon flags by area.
+class rcnTileCacheMeshProcess
+    : public dtTileCacheMeshProcess
+{
+public:
+    unsigned short areaFlags[DT_MAX_AREAS];
+
+    rcnTileCacheMeshProcess()
+    {
+        memset(areaFlags, 0, sizeof(areaFlags));
+    }
+
+    virtual void process(dtNavMeshCreateParams* params
+        , unsigned char* polyAreas
+        , unsigned short* polyFlags)
+    {
+        for (int i = 0; i < params->polyCount; ++i)
+        {
+            if (polyAreas[i] < DT_MAX_AREAS)
+                polyFlags[i] = areaFlags[polyAreas[i]];
+        }
+    }
+};
+
+/*
+ * The tile cache and the objects it uses.
+ * Design note: The cache is declared last so it is destroyed first.
+ */
+struct rcnTileCache
+{
+    dtTileCacheAlloc alloc;
+    rcnRunLengthCompressor compressor;
+    rcnTileCacheMeshProcess meshProcess;
+    dtTileCache cache;
+};
+
+extern "C"
+{
+    EXPORT_API dtStatus dttcBuildLayer(const dtTileCacheLayerHeader* header
+        , const unsigned char* heights
+        , const unsigned char* areas
+        , const unsigned char* cons
+        , unsigned char** resultData
+        , int* dataSize)
+    {
+        if (!header || !resultData || !dataSize)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        dtTileCacheLayerHeader lheader = *header;
+        lheader.magic = DT_TILECACHE_MAGIC;
+        lheader.version = DT_TILECACHE_VERSION;
+
+        rcnRunLengthCompressor compressor;
+
+        return dtBuildTileCacheLayer(&compressor
+            , &lheader, heights, areas, cons, resultData, dataSize);
+    }
+
+    EXPORT_API void dttcFreeLayerData(unsigned char* data)
+    {
+        dtFree(data);
+    }
+
+    EXPORT_API dtStatus dttcAlloc(const dtTileCacheParams* params
+        , rcnTileCache** ppCache)
+    {
+        if (!params || !ppCache)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        *ppCache = 0;
+
+        void* mem = dtAlloc(sizeof(rcnTileCache), DT_ALLOC_PERM, DT_ALLOC_TAG_TILE_CACHE);
+        if (!mem)
+            return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+        rcnTileCache* tc = new(mem) rcnTileCache;
+
+        dtStatus status = tc->cache.init(params
+            , &tc->alloc
+            , &tc->compressor
+            , &tc->meshProcess);
+
+        if (dtStatusFailed(status))
+        {
+            tc->~rcnTileCache();
+            dtFree(tc);
+            return status;
+        }
+
+        *ppCache = tc;
+
+        return DT_SUCCESS;
+    }
+
+    EXPORT_API void dttcFree(rcnTileCache* tc)
+    {
+        if (!tc)
+            return;
+
+        tc->~rcnTileCache();
+        dtFree(tc);
+    }
+
+    EXPORT_API void dttcSetAreaFlags(rcnTileCache* tc
+        , const unsigned char area
+        , const unsigned short flags)
+    {
+        if (tc && area < DT_MAX_AREAS)
+            tc->meshProcess.areaFlags[area] = flags;
+    }
+
+    // The data is copied.  The caller retains ownership of its buffer.
+    EXPORT_API dtStatus dttcAddTile(rcnTileCache* tc
+        , const unsigned char* data
+        , const int dataSize
+        , dtCompressedTileRef* result)
+    {
+        if (!tc || !data || dataSize < 1)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        unsigned char* tdata = (unsigned char*)dtAlloc(dataSize, DT_ALLOC_PERM, DT_ALLOC_TAG_TILE_CACHE);
+        if (!tdata)
+            return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+        memcpy(tdata, data, dataSize);
+
+        dtStatus status = tc->cache.addTile(tdata
+            , dataSize
+            , DT_COMPRESSEDTILE_FREE_DATA
+            , result);
+
+        if (dtStatusFailed(status))
+            dtFree(tdata);
+
+        return status;
+    }
+
+    EXPORT_API dtStatus dttcRemoveTile(rcnTileCache* tc
+        , const dtCompressedTileRef ref)
+    {
+        if (!tc)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        return tc->cache.removeTile(ref, 0, 0);
+    }
+
+    EXPORT_API dtStatus dttcBuildNavMeshTilesAt(rcnTileCache* tc
+        , const int tx
+        , const int ty
+        , dtNavMesh* navmesh)
+    {
+        if (!tc || !navmesh)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        return tc->cache.buildNavMeshTilesAt(tx, ty, navmesh);
+    }
+
+    EXPORT_API dtStatus dttcAddObstacle(rcnTileCache* tc
+        , const float* pos
+        , const float radius
+        , const float height
+        , dtObstacleRef* result)
+    {
+        if (!tc || !pos)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        return tc->cache.addObstacle(pos, radius, height, result);
+    }
+
+    EXPORT_API dtStatus dttcAddBoxObstacle(rcnTileCache* tc
+        , const float* bmin
+        , const float* bmax
+        , dtObstacleRef* result)
+    {
+        if (!tc || !bmin || !bmax)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        return tc->cache.addBoxObstacle(bmin, bmax, result);
+    }
+
+    EXPORT_API dtStatus dttcRemoveObstacle(rcnTileCache* tc
+        , const dtObstacleRef ref)
+    {
+        if (!tc)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        return tc->cache.removeObstacle(ref);
+    }
+
+    // Returns DT_OBSTACLE_EMPTY for invalid references.
+    EXPORT_API unsigned char dttcGetObstacleState(rcnTileCache* tc
+        , const dtObstacleRef ref)
+    {
+        if (!tc)
+            return DT_OBSTACLE_EMPTY;
+
+        const dtTileCacheObstacle* ob = tc->cache.getObstacleByRef(ref);
+
+        return ob ? ob->state : (unsigned char)DT_OBSTACLE_EMPTY;
+    }
+
+    // maxTime is in microseconds.  Zero rebuilds one tile per call.
+    EXPORT_API dtStatus dttcUpdate(rcnTileCache* tc
+        , dtNavMesh* navmesh
+        , const float maxTime
+        , bool* upToDate)
+    {
+        if (!tc || !navmesh)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        return tc->cache.update(0, navmesh, upToDate, maxTime);
+    }
+}
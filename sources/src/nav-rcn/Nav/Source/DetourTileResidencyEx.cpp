@@ -0,0 +1,582 @@
+/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <string.h>
+#include <stdlib.h>
+#include <new>
+#include "DetourTileResidencyEx.h"
+#include "DetourNavMeshEx.h"
+#include "DetourCommon.h"
+
+inline int computeTileHash(int x, int y, const int mask)
+{
+    const unsigned int h1 = 0x8da6b343; // Same as dtNavMesh.
+    const unsigned int h2 = 0xd8163841;
+    unsigned int n = h1 * x + h2 * y;
+    return (int)(n & mask);
+}
+
+rcnTileResidency* rcnAllocTileResidency()
+{
+    void* mem = dtAlloc(sizeof(rcnTileResidency), DT_ALLOC_PERM, DT_ALLOC_TAG_NAVMESH);
+    if (!mem) return 0;
+    return new(mem) rcnTileResidency;
+}
+
+void rcnFreeTileResidency(rcnTileResidency* residency)
+{
+    if (!residency) return;
+    residency->~rcnTileResidency();
+    dtFree(residency);
+}
+
+rcnTileResidency::rcnTileResidency()
+    : m_file(0)
+    , m_navmesh(0)
+    , m_table(0)
+    , m_tiles(0)
+    , m_tileCount(0)
+    , m_lookup(0)
+    , m_lookupMask(0)
+    , m_points(0)
+    , m_maxPoints(0)
+    , m_pending(0)
+    , m_lruHead(-1)
+    , m_lruTail(-1)
+    , m_frame(0)
+    , m_memoryBudget(0)
+    , m_residentSize(0)
+    , m_residentCount(0)
+    , m_loadCount(0)
+    , m_evictCount(0)
+    , m_failedCount(0)
+{
+}
+
+rcnTileResidency::~rcnTileResidency()
+{
+    purge();
+}
+
+void rcnTileResidency::purge()
+{
+    // Design note: Freeing the mesh frees all resident tile data.
+    dtFreeNavMesh(m_navmesh);
+    m_navmesh = 0;
+
+    if (m_tiles)
+    {
+        for (int i = 0; i < m_tileCount; ++i)
+            dtFree(m_tiles[i].state);
+    }
+
+    dtFree(m_table);
+    dtFree(m_tiles);
+    dtFree(m_lookup);
+    dtFree(m_points);
+    dtFree(m_pending);
+    m_table = 0;
+    m_tiles = 0;
+    m_lookup = 0;
+    m_points = 0;
+    m_pending = 0;
+    m_tileCount = 0;
+    m_maxPoints = 0;
+    m_lruHead = -1;
+    m_lruTail = -1;
+    m_residentSize = 0;
+    m_residentCount = 0;
+
+    if (m_file)
+    {
+        fclose(m_file);
+        m_file = 0;
+    }
+}
+
+dtStatus rcnTileResidency::init(const char* filePath
+    , int maxPoints
+    , int memoryBudget)
+{
+    if (!filePath || maxPoints < 1 || memoryBudget < 0)
+        return DT_FAILURE | DT_INVALID_PARAM;
+
+    purge();
+
+    m_file = fopen(filePath, "rb");
+    if (!m_file)
+        return DT_FAILURE | DT_INVALID_PARAM;
+
+    rcnNavMeshIndexHeader header;
+    if (fread(&header, sizeof(header), 1, m_file) != 1
+        || !rcnValidateNavMeshIndexHeader(header)
+        || fseek(m_file, 0, SEEK_END) != 0
+        || ftell(m_file) < header.dataSize)
+    {
+        purge();
+        return DT_FAILURE | DT_WRONG_VERSION;
+    }
+
+    // The header check bounds the table by the blob size, but the per-tile
+    // state is larger than a table entry.
+    const size_t maxEntrySize = sizeof(TileInfo) > sizeof(rcnNavMeshTileIndex) 
+        ? sizeof(TileInfo) : sizeof(rcnNavMeshTileIndex);
+    if ((size_t)header.tileCount > ((size_t)-1) / maxEntrySize)
+    {
+        purge();
+        return DT_FAILURE | DT_INVALID_PARAM;
+    }
+
+    m_tileCount = header.tileCount;
+
+    if (m_tileCount > 0)
+    {
+        m_table = (rcnNavMeshTileIndex*)dtAlloc(
+            sizeof(rcnNavMeshTileIndex) * m_tileCount, DT_ALLOC_PERM, DT_ALLOC_TAG_NAVMESH);
+        m_tiles = (TileInfo*)dtAlloc(sizeof(TileInfo) * m_tileCount, DT_ALLOC_PERM, DT_ALLOC_TAG_NAVMESH);
+        m_pending = (PendingTile*)dtAlloc(
+            sizeof(PendingTile) * m_tileCount, DT_ALLOC_PERM, DT_ALLOC_TAG_NAVMESH);
+
+        if (!m_table || !m_tiles || !m_pending)
+        {
+            purge();
+            return DT_FAILURE | DT_OUT_OF_MEMORY;
+        }
+
+        memset(m_tiles, 0, sizeof(TileInfo) * m_tileCount);
+
+        if (fseek(m_file, header.tableOffset, SEEK_SET) != 0
+            || fread(m_table, sizeof(rcnNavMeshTileIndex), m_tileCount, m_file) 
+                != (size_t)m_tileCount
+            || !rcnValidateNavMeshTileTable(header, m_table))
+        {
+            purge();
+            return DT_FAILURE | DT_INVALID_PARAM;
+        }
+    }
+
+    int lookupSize = dtNextPow2(m_tileCount / 4);
+    if (!lookupSize) lookupSize = 1;
+    m_lookupMask = lookupSize - 1;
+
+    m_lookup = (int*)dtAlloc(sizeof(int) * lookupSize, DT_ALLOC_PERM, DT_ALLOC_TAG_NAVMESH);
+    m_points = (Point*)dtAlloc(sizeof(Point) * maxPoints, DT_ALLOC_PERM, DT_ALLOC_TAG_NAVMESH);
+    if (!m_lookup || !m_points)
+    {
+        purge();
+        return DT_FAILURE | DT_OUT_OF_MEMORY;
+    }
+
+    memset(m_points, 0, sizeof(Point) * maxPoints);
+    m_maxPoints = maxPoints;
+
+    for (int i = 0; i < lookupSize; ++i)
+        m_lookup[i] = -1;
+
+    for (int i = 0; i < m_tileCount; ++i)
+    {
+        TileInfo& info = m_tiles[i];
+        info.prev = -1;
+        info.next = -1;
+        info.lastUsed = -1;
+
+        const int h = computeTileHash(m_table[i].x, m_table[i].y, m_lookupMask);
+        info.nextInLookup = m_lookup[h];
+        m_lookup[h] = i;
+    }
+
+    m_navmesh = dtAllocNavMesh();
+    if (!m_navmesh)
+    {
+        purge();
+        return DT_FAILURE | DT_OUT_OF_MEMORY;
+    }
+
+    dtStatus status = m_navmesh->init(&header.params);
+    if (dtStatusFailed(status))
+    {
+        purge();
+        return status;
+    }
+
+    m_memoryBudget = memoryBudget;
+    m_frame = 0;
+    m_loadCount = 0;
+    m_evictCount = 0;
+    m_failedCount = 0;
+
+    return DT_SUCCESS;
+}
+
+bool rcnTileResidency::setPoint(int index, const float* pos, float radius)
+{
+    if (index < 0 || index >= m_maxPoints || !pos || radius < 0)
+        return false;
+
+    Point& point = m_points[index];
+    dtVcopy(point.pos, pos);
+    point.radius = radius;
+    point.active = true;
+
+    return true;
+}
+
+void rcnTileResidency::clearPoint(int index)
+{
+    if (index >= 0 && index < m_maxPoints)
+        m_points[index].active = false;
+}
+
+void rcnTileResidency::unlinkLru(int tile)
+{
+    TileInfo& info = m_tiles[tile];
+
+    if (info.prev >= 0)
+        m_tiles[info.prev].next = info.next;
+    else
+        m_lruHead = info.next;
+
+    if (info.next >= 0)
+        m_tiles[info.next].prev = info.prev;
+    else
+        m_lruTail = info.prev;
+
+    info.prev = -1;
+    info.next = -1;
+}
+
+void rcnTileResidency::touch(int tile)
+{
+    if (m_lruHead == tile)
+        return;
+
+    TileInfo& info = m_tiles[tile];
+
+    // Any linked tile other than the head has a previous tile.
+    if (info.prev >= 0)
+        unlinkLru(tile);
+
+    info.next = m_lruHead;
+    if (m_lruHead >= 0)
+        m_tiles[m_lruHead].prev = tile;
+    m_lruHead = tile;
+    if (m_lruTail < 0)
+        m_lruTail = tile;
+}
+
+bool rcnTileResidency::evictLru()
+{
+    const int tile = m_lruTail;
+
+    // Design note: Wanted tiles are always at the head of the list.
+    if (tile < 0 || m_tiles[tile].lastUsed == m_frame)
+        return false;
+
+    TileInfo& info = m_tiles[tile];
+    const rcnNavMeshTileIndex& entry = m_table[tile];
+    const dtMeshTile* meshTile = m_navmesh->getTileByRef(entry.tileRef);
+
+    if (meshTile)
+    {
+        if (!info.state)
+        {
+            const int size = m_navmesh->getTileStateSize(meshTile);
+            info.state = (unsigned char*)dtAlloc(size, DT_ALLOC_PERM, DT_ALLOC_TAG_NAVMESH);
+            info.stateSize = info.state ? size : 0;
+        }
+
+        if (info.state)
+            m_navmesh->storeTileState(meshTile, info.state, info.stateSize);
+
+        m_navmesh->removeTile(entry.tileRef, 0, 0);
+    }
+
+    unlinkLru(tile);
+    info.resident = false;
+    m_residentSize -= entry.dataSize;
+    m_residentCount--;
+    m_evictCount++;
+
+    return true;
+}
+
+dtStatus rcnTileResidency::loadTile(int tile)
+{
+    TileInfo& info = m_tiles[tile];
+    const rcnNavMeshTileIndex& entry = m_table[tile];
+
+    unsigned char* data = (unsigned char*)dtAlloc(entry.dataSize, DT_ALLOC_PERM, DT_ALLOC_TAG_TILE_DATA);
+    if (!data)
+        return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+    if (fseek(m_file, entry.dataOffset, SEEK_SET) != 0
+        || fread(data, entry.dataSize, 1, m_file) != 1
+        || !rcnValidateNavMeshTile(entry, data))
+    {
+        dtFree(data);
+        info.failed = true;
+        m_failedCount++;
+        return DT_FAILURE | DT_INVALID_PARAM;
+    }
+
+    // Design note: Adding with the stored reference restores the tile 
+    // salt, so references held by clients remain valid after a reload.
+    dtStatus status = m_navmesh->addTile(data
+        , entry.dataSize
+        , DT_TILE_FREE_DATA
+        , entry.tileRef
+        , 0);
+
+    if (dtStatusFailed(status))
+    {
+        dtFree(data);
+        info.failed = true;
+        m_failedCount++;
+        return status;
+    }
+
+    if (info.state)
+    {
+        dtMeshTile* meshTile = 
+            const_cast<dtMeshTile*>(m_navmesh->getTileByRef(entry.tileRef));
+        m_navmesh->restoreTileState(meshTile, info.state, info.stateSize);
+    }
+
+    info.resident = true;
+    touch(tile);
+    m_residentSize += entry.dataSize;
+    m_residentCount++;
+    m_loadCount++;
+
+    return DT_SUCCESS;
+}
+
+void rcnTileResidency::wantTiles(const Point& point)
+{
+    const dtNavMeshParams* params = m_navmesh->getParams();
+
+    float bmin[3];
+    float bmax[3];
+    dtVcopy(bmin, point.pos);
+    dtVcopy(bmax, point.pos);
+    bmin[0] -= point.radius;
+    bmin[2] -= point.radius;
+    bmax[0] += point.radius;
+    bmax[2] += point.radius;
+
+    int minx, miny, maxx, maxy;
+    m_navmesh->calcTileLoc(bmin, &minx, &miny);
+    m_navmesh->calcTileLoc(bmax, &maxx, &maxy);
+
+    for (int y = miny; y <= maxy; ++y)
+    {
+        for (int x = minx; x <= maxx; ++x)
+        {
+            const float dx = params->orig[0] 
+                + (x + 0.5f) * params->tileWidth - point.pos[0];
+            const float dz = params->orig[2] 
+                + (y + 0.5f) * params->tileHeight - point.pos[2];
+            const float priority = dx * dx + dz * dz;
+
+            const int h = computeTileHash(x, y, m_lookupMask);
+            for (int i = m_lookup[h]; i >= 0; i = m_tiles[i].nextInLookup)
+            {
+                if (m_table[i].x != x || m_table[i].y != y)
+                    continue;
+
+                TileInfo& info = m_tiles[i];
+                if (info.lastUsed != m_frame)
+                {
+                    info.lastUsed = m_frame;
+                    info.priority = priority;
+                    if (info.resident)
+                        touch(i);
+                }
+                else if (priority < info.priority)
+                    info.priority = priority;
+            }
+        }
+    }
+}
+
+dtStatus rcnTileResidency::update(int maxLoads)
+{
+    if (!m_navmesh)
+        return DT_FAILURE | DT_INVALID_PARAM;
+
+    m_frame++;
+
+    for (int i = 0; i < m_maxPoints; ++i)
+    {
+        if (m_points[i].active)
+            wantTiles(m_points[i]);
+    }
+
+    // Give back memory if the budget was reduced.
+    while (m_residentSize > m_memoryBudget && evictLru()) { }
+
+    int pendingCount = 0;
+    for (int i = 0; i < m_tileCount; ++i)
+    {
+        const TileInfo& info = m_tiles[i];
+        if (info.lastUsed == m_frame && !info.resident && !info.failed)
+        {
+            m_pending[pendingCount].tile = i;
+            m_pending[pendingCount].priority = info.priority;
+            pendingCount++;
+        }
+    }
+
+    if (pendingCount > 1)
+        qsort(m_pending, pendingCount, sizeof(PendingTile), comparePending);
+
+    dtStatus status = DT_SUCCESS;
+    int loads = 0;
+
+    for (int i = 0; i < pendingCount; ++i)
+    {
+        if (maxLoads > 0 && loads >= maxLoads)
+        {
+            status |= DT_IN_PROGRESS;
+            break;
+        }
+
+        const int tile = m_pending[i].tile;
+        const int size = m_table[tile].dataSize;
+
+        while (m_residentSize + size > m_memoryBudget && evictLru()) { }
+
+        if (m_residentSize + size > m_memoryBudget)
+        {
+            // Everything resident is wanted.  Nearer tiles win.
+            status |= DT_BUFFER_TOO_SMALL;
+            break;
+        }
+
+        // Design note: A failed tile is flagged and skipped so one bad 
+        // tile does not block the rest.
+        if (dtStatusSucceed(loadTile(tile)))
+            loads++;
+    }
+
+    return status;
+}
+
+int rcnTileResidency::comparePending(const void* va, const void* vb)
+{
+    const float a = ((const PendingTile*)va)->priority;
+    const float b = ((const PendingTile*)vb)->priority;
+    return (a < b) ? -1 : ((a > b) ? 1 : 0);
+}
+
+void rcnTileResidency::getStats(rcnTileResidencyStats* stats) const
+{
+    if (!stats)
+        return;
+
+    stats->tileCount = m_tileCount;
+    stats->residentCount = m_residentCount;
+    stats->residentSize = m_residentSize;
+    stats->memoryBudget = m_memoryBudget;
+    stats->loadCount = m_loadCount;
+    stats->evictCount = m_evictCount;
+    stats->failedCount = m_failedCount;
+}
+
+extern "C"
+{
+    EXPORT_API dtStatus dtnmCreateTileResidency(const char* filePath
+        , int maxPoints
+        , int memoryBudget
+        , rcnTileResidency** ppResidency)
+    {
+        if (!ppResidency)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        *ppResidency = 0;
+
+        rcnTileResidency* residency = rcnAllocTileResidency();
+        if (!residency)
+            return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+        dtStatus status = residency->init(filePath, maxPoints, memoryBudget);
+        if (dtStatusFailed(status))
+        {
+            rcnFreeTileResidency(residency);
+            return status;
+        }
+
+        *ppResidency = residency;
+
+        return DT_SUCCESS;
+    }
+
+    EXPORT_API void dtnmFreeTileResidency(rcnTileResidency* residency)
+    {
+        rcnFreeTileResidency(residency);
+    }
+
+    EXPORT_API dtNavMesh* dtnmGetResidencyNavMesh(rcnTileResidency* residency)
+    {
+        if (residency)
+            return residency->getNavMesh();
+        return 0;
+    }
+
+    EXPORT_API bool dtnmSetResidencyPoint(rcnTileResidency* residency
+        , int index
+        , const float* pos
+        , float radius)
+    {
+        if (residency)
+            return residency->setPoint(index, pos, radius);
+        return false;
+    }
+
+    EXPORT_API void dtnmClearResidencyPoint(rcnTileResidency* residency
+        , int index)
+    {
+        if (residency)
+            residency->clearPoint(index);
+    }
+
+    EXPORT_API void dtnmSetResidencyBudget(rcnTileResidency* residency
+        , int memoryBudget)
+    {
+        if (residency)
+            residency->setMemoryBudget(memoryBudget);
+    }
+
+    EXPORT_API dtStatus dtnmUpdateTileResidency(rcnTileResidency* residency
+        , int maxLoads)
+    {
+        if (residency)
+            return residency->update(maxLoads);
+        return (DT_FAILURE | DT_INVALID_PARAM);
+    }
+
+    EXPORT_API void dtnmGetResidencyStats(const rcnTileResidency* residency
+        , rcnTileResidencyStats* stats)
+    {
+        if (residency)
+            residency->getStats(stats);
+    }
+}
@@ -44,4 +44,11 @@ extern "C"
 			dtVcopy(&vector3out[i * 3], &vector3in[i * 3]);
 		}
 	}
+
+	// Allows checking that the managed reference type matches the
+	// dtPolyRef size the library was built with. (See: DT_POLYREF64)
+	EXPORT_API int dtvlGetPolyRefSize()
+	{
+		return (int)sizeof(dtPolyRef);
+	}
 }
\ No newline at end of file
@@ -22,7 +22,9 @@
 #ifndef CAI_NMG_EX_H
 #define CAI_NMG_EX_H
 
+#include <stdint.h>
 #include "Recast.h"
+#include "RecastTaskScheduler.h"
 
 #if _MSC_VER    // TRUE for Microsoft compiler.
 #define EXPORT_API __declspec(dllexport) // Required for VC++
@@ -62,20 +64,247 @@ public:
 
     bool getLogEnabled() const { return m_logEnabled; }
 
+    // The peak scratch arena use of the stage, in bytes.
+    int getScratchPeak(const rcTimerLabel stage) const { return mScratchPeaks[stage]; }
+    void recordScratchPeak(const rcTimerLabel stage, const int bytes);
+
+    // The peak working set of the thread during the stage, in bytes.  This 
+    // includes the memory still held from earlier stages.
+    int getWorkingSetPeak(const rcTimerLabel stage) const { return mWorkingSetPeaks[stage]; }
+    void recordWorkingSetPeak(const rcTimerLabel stage, const int bytes);
+
+    // Resets both the scratch and working set peaks.
+    void resetScratchPeaks();
+
+    // Timers are disabled by default.  (See: rcContext::enableTimer)
+    bool getTimerEnabled() const { return m_timerEnabled; }
+
+    // The accumulated time of the timer, in microseconds.  Unlike
+    // getAccumulatedTime(), which is limited to an int, this does not
+    // saturate on long builds.
+    int64_t getTimerTotal(const rcTimerLabel label) const { return mTimerTotals[label]; }
+
+    // The number of times the timer was started since the last reset.
+    int getTimerCount(const rcTimerLabel label) const { return mTimerCounts[label]; }
+
+    // Adds the timer totals of another context to this context.
+    void addTimers(const nmgBuildContext& other);
+
+    // The scheduler used by the build steps that support parallel
+    // execution.  (Optional.  Not owned by the context.)
+    rcTaskScheduler* getTaskScheduler() const { return mTaskScheduler; }
+    void setTaskScheduler(rcTaskScheduler* scheduler) { mTaskScheduler = scheduler; }
+
+    // The rasterization flags used by the build.  (See: rcRasterizeFlags)
+    int getRasterizeFlags() const { return mRasterizeFlags; }
+    void setRasterizeFlags(const int flags) { mRasterizeFlags = flags; }
+
 protected:
     virtual void doResetLog();
     virtual void doLog(const rcLogCategory category
         , const char* msg
         , const int len);
 
+    virtual void doResetTimers();
+    virtual void doStartTimer(const rcTimerLabel label);
+    virtual void doStopTimer(const rcTimerLabel label);
+    virtual int doGetAccumulatedTime(const rcTimerLabel label) const;
+
 private:
     const char* mMessages[MAX_MESSAGES];
     int mMessageCount;
 
     char mTextPool[MESSAGE_POOL_SIZE];
     int mTextPoolSize;
+
+    int mScratchPeaks[RC_MAX_TIMERS];
+    int mWorkingSetPeaks[RC_MAX_TIMERS];
+
+    // Times are in microseconds.
+    int64_t mTimerStart[RC_MAX_TIMERS];
+    int64_t mTimerTotals[RC_MAX_TIMERS];
+    int mTimerCounts[RC_MAX_TIMERS];
+
+    rcTaskScheduler* mTaskScheduler;
+    int mRasterizeFlags;
+};
+
+/*
+ * Serves RC_ALLOC_TEMP allocations from a per-thread arena for the
+ * lifetime of the scope.  All arena memory allocated within the scope
+ * is released in bulk when the scope ends.  Scopes can be nested.
+ *
+ * The peak arena use and peak working set of the scope are recorded
+ * in the context under the stage label.  (The context is optional.)
+ */
+class nmgScratchScope
+{
+public:
+    nmgScratchScope(nmgBuildContext* ctx, const rcTimerLabel stage);
+    ~nmgScratchScope();
+
+private:
+    nmgBuildContext* mContext;
+    rcTimerLabel mStage;
+    void* mChunk;
+    int mTop;
+    int mUsed;
+    int mPeak;
+    int mWorkingSetPeak;
+    bool mActive;
+
+    // Explicitly disabled copy constructor and copy assignment operator.
+    nmgScratchScope(const nmgScratchScope&);
+    nmgScratchScope& operator=(const nmgScratchScope&);
+};
+
+struct nmgThreadPoolState;
+
+// A fixed size pool of worker threads for running parallel loops.
+//
+// Each worker starts with an even share of the task indices.  A worker that
+// runs out steals half of the remaining indices of another worker, so
+// uneven task costs still keep all workers busy.
+//
+// The pool is not reentrant: Only one thread may call parallelFor at a
+// time, and tasks must not call parallelFor.
+class nmgThreadPool
+    : public rcTaskScheduler
+{
+public:
+    nmgThreadPool();
+    ~nmgThreadPool();
+
+    // The thread count is the number of threads in addition to the calling 
+    // thread, which always participates.  Zero is valid. (Serial.)
+    bool init(int threadCount);
+    void purge();
+
+    virtual int getWorkerCount() const { return m_threadCount + 1; }
+
+    // Runs the task for each index in [0, taskCount) and returns once all 
+    // tasks are complete.
+    virtual void parallelFor(rcTaskFunc func, void* userData, int taskCount);
+
+private:
+    // Explicitly disabled copy constructor and copy assignment operator.
+    nmgThreadPool(const nmgThreadPool&);
+    nmgThreadPool& operator=(const nmgThreadPool&);
+
+    nmgThreadPoolState* m_state;
+    int m_threadCount;
+};
+
+struct nmgRasterSessionState;
+
+// Rasterizes triangles into a heightfield as they arrive, so the full 
+// source mesh never needs to exist in one place.
+//
+// The heightfield is split into bands of rows, each with its own span pools
+// and lock.  A chunk only locks the bands its vertices overlap, so several 
+// producers can add chunks at the same time.  Each cell receives its spans 
+// in the order the chunks reached its band.  A single producer that adds 
+// chunks in mesh order gets the same result as rcRasterizeTriangles.
+//
+// The heightfield must not be used by anything else while the session is 
+// open.  The band pools are handed to the heightfield on close.
+class nmgRasterSession
+{
+public:
+    nmgRasterSession();
+    ~nmgRasterSession();
+
+    // A band count <= 0 selects a count based on the heightfield depth.
+    bool open(rcHeightfield* hf, int bandCount, int flagMergeThr, int flags);
+
+    // Thread-safe.  The chunk's triangles index into its own vertices.
+    bool addTriangles(const float* verts, int nv
+        , const int* tris, const unsigned char* areas, int nt);
+
+    void close();
+
+    bool isOpen() const { return m_state != 0; }
+
+private:
+    // Explicitly disabled copy constructor and copy assignment operator.
+    nmgRasterSession(const nmgRasterSession&);
+    nmgRasterSession& operator=(const nmgRasterSession&);
+
+    nmgRasterSessionState* m_state;
+};
+
+// Frees the calling thread's retained arena memory.  Threads that use
+// scratch scopes should call this before they exit.
+void nmgReleaseScratch();
+
+// A detail mesh that tracks its buffer sizes and allocation type.
+struct nmgPolyMeshDetail
+    : rcPolyMeshDetail
+{
+    int maxmeshes;
+    int maxverts;
+    int maxtris;
+    unsigned char resourcetype;
+};
+
+// Area marker types.
+static const unsigned char NMG_MARKER_CONVEX = 0;
+static const unsigned char NMG_MARKER_CYLINDER = 1;
+
+static const int NMG_MAX_MARKER_VERTS = 16;
+
+// An area marker applied by the tile builder to each tile's compact 
+// heightfield before it is eroded.
+//
+// Convex markers use verts, nverts, ymin and ymax.  Cylinder markers use the
+// first vertex as the center of the base, radius and height.
+struct nmgAreaMarker
+{
+    float verts[NMG_MAX_MARKER_VERTS * 3];
+    int nverts;
+    float ymin;
+    float ymax;
+    float radius;
+    float height;
+    unsigned char type;
+    unsigned char area;
 };
 
+// Caches the unmarked compact heightfield of each tile so that tiles can be 
+// rebuilt after marker changes without rasterizing them again.
+struct nmgTileCache;
+
+// A content key of a tile's build inputs.  Tiles with the same key build 
+// the same output.
+struct nmgTileKey
+{
+    unsigned int words[4];
+};
+
+// A streaming 128-bit hash.  (MurmurHash3, x86 128-bit variant.)  The 
+// result only depends on the bytes added, not on how they were split.
+class nmgContentHash
+{
+public:
+    nmgContentHash(unsigned int seed = 0);
+
+    void add(const void* data, int size);
+    template<class T> void addValue(const T& value) { add(&value, sizeof(T)); }
+
+    void finish(nmgTileKey& key) const;
+
+private:
+    void addBlock(const unsigned char* block);
+
+    unsigned int m_h[4];
+    unsigned char m_tail[16];
+    int m_tailSize;
+    unsigned int m_size;
+};
+
+// Returns the number of vertices referenced by the mesh's polygons.
+int getMaxVerts(rcPolyMesh& mesh);
+
 template<class T> inline bool nmgSloppyEquals(T a, T b) 
 { 
     return !(b < a - NMG_TOLERANCE || b > a + NMG_TOLERANCE);
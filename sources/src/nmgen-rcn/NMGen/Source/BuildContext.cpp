@@ -20,8 +20,33 @@
  * THE SOFTWARE.
  */
 #include <string.h>
+#include <limits.h>
 #include "NMGen.h"
 
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+static int64_t getTimeUsec()
+{
+#if defined(_WIN32)
+    LARGE_INTEGER freq;
+    LARGE_INTEGER count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    // Split to keep the scaling from overflowing.
+    return (count.QuadPart / freq.QuadPart) * 1000000
+        + (count.QuadPart % freq.QuadPart) * 1000000 / freq.QuadPart;
+#else
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
 void nmgTransferMessages(const nmgBuildContext* context
     , unsigned char* messageBuffer
     , int messageBufferSize)
@@ -35,9 +60,15 @@ void nmgTransferMessages(const nmgBuildContext* context
 }
 
 nmgBuildContext::nmgBuildContext()
-    : rcContext(false), mMessageCount(0), mTextPoolSize(0)
+    : rcContext(false), mMessageCount(0), mTextPoolSize(0), mTaskScheduler(0)
+    , mRasterizeFlags(0)
 {
+    // Design note: Timers are opt-in.  They cost two clock reads per
+    // stage, and most builds never read them.
     m_logEnabled = true;
+    m_timerEnabled = false;
+    resetScratchPeaks();
+    doResetTimers();
 }
 
 nmgBuildContext::~nmgBuildContext()
@@ -84,6 +115,56 @@ const char* nmgBuildContext::getMessage(const int i) const
     return mMessages[i];
 }
 
+void nmgBuildContext::recordScratchPeak(const rcTimerLabel stage, const int bytes)
+{
+    mScratchPeaks[stage] = rcMax(mScratchPeaks[stage], bytes);
+}
+
+void nmgBuildContext::recordWorkingSetPeak(const rcTimerLabel stage, const int bytes)
+{
+    mWorkingSetPeaks[stage] = rcMax(mWorkingSetPeaks[stage], bytes);
+}
+
+void nmgBuildContext::resetScratchPeaks()
+{
+    memset(mScratchPeaks, 0, sizeof(mScratchPeaks));
+    memset(mWorkingSetPeaks, 0, sizeof(mWorkingSetPeaks));
+}
+
+void nmgBuildContext::doResetTimers()
+{
+    memset(mTimerStart, 0, sizeof(mTimerStart));
+    memset(mTimerTotals, 0, sizeof(mTimerTotals));
+    memset(mTimerCounts, 0, sizeof(mTimerCounts));
+}
+
+void nmgBuildContext::doStartTimer(const rcTimerLabel label)
+{
+    mTimerStart[label] = getTimeUsec();
+    mTimerCounts[label]++;
+}
+
+void nmgBuildContext::doStopTimer(const rcTimerLabel label)
+{
+    mTimerTotals[label] += getTimeUsec() - mTimerStart[label];
+}
+
+int nmgBuildContext::doGetAccumulatedTime(const rcTimerLabel label) const
+{
+    // The rcContext interface is limited to an int.  Saturate rather than
+    // wrap.  (See: getTimerTotal)
+    return (int)rcMin(mTimerTotals[label], (int64_t)INT_MAX);
+}
+
+void nmgBuildContext::addTimers(const nmgBuildContext& other)
+{
+    for (int i = 0; i < RC_MAX_TIMERS; i++)
+    {
+        mTimerTotals[i] += other.mTimerTotals[i];
+        mTimerCounts[i] += other.mTimerCounts[i];
+    }
+}
+
 int nmgBuildContext::getMessagePoolLength() const { return mTextPoolSize; }
 const char* nmgBuildContext::getMessagePool() const { return mTextPool; }
 
@@ -139,6 +220,92 @@ extern "C"
         return context->getMessageCount();
     }
 
+    EXPORT_API int nmbcGetScratchPeak(const nmgBuildContext* context
+        , const rcTimerLabel stage)
+    {
+        if (!context || stage < 0 || stage >= RC_MAX_TIMERS)
+            return 0;
+        return context->getScratchPeak(stage);
+    }
+
+    EXPORT_API int nmbcGetWorkingSetPeak(const nmgBuildContext* context
+        , const rcTimerLabel stage)
+    {
+        if (!context || stage < 0 || stage >= RC_MAX_TIMERS)
+            return 0;
+        return context->getWorkingSetPeak(stage);
+    }
+
+    EXPORT_API void nmbcResetScratchPeaks(nmgBuildContext* context)
+    {
+        if (context)
+            context->resetScratchPeaks();
+    }
+
+    EXPORT_API void nmbcEnableTimers(nmgBuildContext* context, bool state)
+    {
+        if (context)
+            context->enableTimer(state);
+    }
+
+    EXPORT_API bool nmbcGetTimersEnabled(nmgBuildContext* context)
+    {
+        if (context)
+            return context->getTimerEnabled();
+        return false;
+    }
+
+    EXPORT_API void nmbcResetTimers(nmgBuildContext* context)
+    {
+        if (context)
+            context->resetTimers();
+    }
+
+    // times and counts are indexed by rcTimerLabel.  Times are in 
+    // microseconds. Returns the number of labels loaded.
+    EXPORT_API int nmbcGetTimers(const nmgBuildContext* context
+        , int64_t* times
+        , int* counts
+        , const int bufferSize)
+    {
+        if (!context || !times || !counts)
+            return 0;
+
+        const int count = rcMin(bufferSize, (int)RC_MAX_TIMERS);
+        for (int i = 0; i < count; i++)
+        {
+            const rcTimerLabel label = (rcTimerLabel)i;
+            times[i] = context->getTimerTotal(label);
+            counts[i] = context->getTimerCount(label);
+        }
+
+        return count;
+    }
+
+    EXPORT_API bool nmbcSetThreadPool(nmgBuildContext* context
+        , nmgThreadPool* pool)
+    {
+        // Design note: A null pool restores the serial build.
+        if (!context)
+            return false;
+        context->setTaskScheduler(pool);
+        return true;
+    }
+
+    EXPORT_API void nmbcSetRasterizeFlags(nmgBuildContext* context
+        , const int flags)
+    {
+        if (context)
+            context->setRasterizeFlags(flags);
+    }
+
+    EXPORT_API int nmbcGetRasterizeFlags(const nmgBuildContext* context)
+    {
+        if (context)
+            return context->getRasterizeFlags();
+        return 0;
+    }
+
     EXPORT_API void nmbcLog(nmgBuildContext* context
         , const char* message)
     {
@@ -34,6 +34,8 @@ extern "C"
         if (!ctx || !hf || !chf)
             return false;
 
+        nmgScratchScope scope(ctx, RC_TIMER_BUILD_COMPACTHEIGHTFIELD);
+
         return rcBuildCompactHeightfield(ctx
             , walkableHeight
             , walkableClimb
@@ -56,6 +58,23 @@ extern "C"
         }
     }
 
+    EXPORT_API void nmcfFreeDistanceData(rcCompactHeightfield* chf)
+    {
+        /*
+         * Design notes:
+         *
+         * Only the region build reads the distance field, so it can be
+         * released once the regions exist.  It is the largest per-span
+         * buffer after the spans themselves.
+         */
+        if (chf)
+        {
+            rcFree(chf->dist);
+            chf->dist = 0;
+            chf->maxDistance = 0;
+        }
+    }
+
     EXPORT_API bool nmcfGetCellData(rcCompactHeightfield* chf
         , rcCompactCell* cells
         , const int cellsSize)
@@ -89,7 +108,10 @@ extern "C"
         , rcCompactHeightfield* chf)
     {
         if (ctx && chf)
-            return rcErodeWalkableArea(ctx, radius, *chf);
+        {
+            nmgScratchScope scope(ctx, RC_TIMER_ERODE_AREA);
+            return rcErodeWalkableArea(ctx, radius, *chf, ctx->getTaskScheduler());
+        }
         return false;
     }
 
@@ -97,7 +119,10 @@ extern "C"
         , rcCompactHeightfield* chf)
     {
         if (ctx && chf)
-            return rcMedianFilterWalkableArea(ctx, *chf);
+        {
+            nmgScratchScope scope(ctx, RC_TIMER_MEDIAN_AREA);
+            return rcMedianFilterWalkableArea(ctx, *chf, ctx->getTaskScheduler());
+        }
         return false;
     }
 
@@ -150,7 +175,10 @@ extern "C"
         , rcCompactHeightfield* chf)
     {
         if (ctx && chf)
-            return rcBuildDistanceField(ctx, *chf);
+        {
+            nmgScratchScope scope(ctx, RC_TIMER_BUILD_DISTANCEFIELD);
+            return rcBuildDistanceField(ctx, *chf, ctx->getTaskScheduler());
+        }
         return false;
     }
 
@@ -161,11 +189,15 @@ extern "C"
         , const int mergeRegionArea)
     {
         if (ctx && chf)
+        {
+            nmgScratchScope scope(ctx, RC_TIMER_BUILD_REGIONS);
             return rcBuildRegions(ctx
                 , *chf
                 , borderSize
                 , minRegionArea
-                , mergeRegionArea);
+                , mergeRegionArea
+                , ctx->getTaskScheduler());
+        }
         return false;
     }
 
@@ -176,11 +208,14 @@ extern "C"
         , const int mergeRegionArea)
     {
         if (ctx && chf)
+        {
+            nmgScratchScope scope(ctx, RC_TIMER_BUILD_REGIONS);
             return rcBuildRegions(ctx
                 , *chf
                 , borderSize
                 , minRegionArea
                 , mergeRegionArea);
+        }
         return false;
     }
 }
\ No newline at end of file
@@ -35,12 +35,15 @@ extern "C"
         if (!ctx || !chf || !cset)
             return false;
 
+        nmgScratchScope scope(ctx, RC_TIMER_BUILD_CONTOURS);
+
         return rcBuildContours(ctx
             , *chf
             , maxError
             , maxEdgeLen
             , *cset
-            , flags);
+            , flags
+            , ctx->getTaskScheduler());
     }
 
     EXPORT_API void nmcsFreeSetData(rcContourSet* cset)
@@ -90,7 +90,8 @@ extern "C"
             , &v[0], &v[3], &v[6]
             , area
             , *hf
-            , flagMergeThr);
+            , flagMergeThr
+            , ctx->getRasterizeFlags());
 
         return true;
     }
@@ -145,7 +146,8 @@ extern "C"
 				, lareas
 				, nodes[iNode].count
 				, *hf
-				, flagMergeThr);
+				, flagMergeThr
+				, ctx->getRasterizeFlags());
 		}
 
 		rcFree(ltris);
@@ -173,11 +175,36 @@ extern "C"
             , areas
             , nt
             , *hf
-            , flagMergeThr);
+            , flagMergeThr
+            , ctx->getRasterizeFlags());
 
         return true;
     }
 
+    EXPORT_API bool nmhfRasterizeTriMeshParallel(nmgBuildContext* ctx
+        , const float* verts
+        , const int nv
+        , const int* tris
+        , const unsigned char* areas
+        , const int nt
+        , rcHeightfield* hf
+        , const int flagMergeThr)
+    {
+        if (!ctx || !verts || !tris || !areas || !hf)
+            return false;
+
+        return rcRasterizeTrianglesParallel(ctx
+            , verts
+            , nv
+            , tris
+            , areas
+            , nt
+            , *hf
+            , ctx->getTaskScheduler()
+            , flagMergeThr
+            , ctx->getRasterizeFlags());
+    }
+
     EXPORT_API bool nmhfRasterizeTriMeshShort(nmgBuildContext* ctx
         , const float* verts
         , const int nv
@@ -197,7 +224,8 @@ extern "C"
             , areas
             , nt
             , *hf
-            , flagMergeThr);
+            , flagMergeThr
+            , ctx->getRasterizeFlags());
 
         return true;
     }
@@ -217,7 +245,8 @@ extern "C"
             , areas
             , nt
             , *hf
-            , flagMergeThr);
+            , flagMergeThr
+            , ctx->getRasterizeFlags());
 
         return true;
     }
@@ -34,6 +34,8 @@ extern "C"
         if (!ctx || !chf)
             return -1;
 
+        nmgScratchScope scope(ctx, RC_TIMER_BUILD_LAYERS);
+
         rcHeightfieldLayerSet* lset = rcAllocHeightfieldLayerSet();
         if (!lset)
             return -1;
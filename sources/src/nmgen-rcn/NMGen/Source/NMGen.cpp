@@ -31,6 +31,19 @@ extern "C"
         *data = 0;
     }
 
+    // Fills one entry per allocation tag and returns the number of entries.
+    EXPORT_API int nmgGetAllocStats(rcAllocStats* stats, const int maxStats)
+    {
+        if (!stats)
+            return 0;
+
+        const int count = rcMin(maxStats, (int)RC_MAX_ALLOC_TAGS);
+        for (int i = 0; i < count; ++i)
+            rcGetAllocStats((rcAllocTag)i, &stats[i]);
+
+        return count;
+    }
+
     // The only purpose for this function is to allow testing
     // the context interop.
     EXPORT_API void nmgTestContext(rcContext* ctx, const int count)
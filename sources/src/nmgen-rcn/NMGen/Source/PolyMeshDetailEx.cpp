@@ -37,15 +37,6 @@ struct nmgPolyMeshDetailHeader
     long version;
 };
 
-struct nmgPolyMeshDetail
-    : rcPolyMeshDetail
-{
-    int maxmeshes;
-    int maxverts;
-    int maxtris;
-    unsigned char resourcetype;
-};
-
 // Iterates an array of vertices and copies the unique vertices to
 // another array.
 // vertCount - The number of vertices in sourceVerts.
@@ -155,7 +146,7 @@ extern "C"
         int totalDataSize = headerSize + vertSize + meshSize + trisSize;
 
         unsigned char* data = 
-            (unsigned char*)rcAlloc(totalDataSize, RC_ALLOC_PERM);
+            (unsigned char*)rcAlloc(totalDataSize, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH_DETAIL);
 
         if (!data)
             return false;
@@ -210,21 +201,21 @@ extern "C"
         // This needs to be set early or the error handling won't work.
         resultMesh->resourcetype = NMG_ALLOC_TYPE_LOCAL;
 
-        resultMesh->meshes = (unsigned int*)rcAlloc(meshSize, RC_ALLOC_PERM);
+        resultMesh->meshes = (unsigned int*)rcAlloc(meshSize, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH_DETAIL);
         if (!resultMesh->meshes)
         {
            rcpdFreeMeshData(resultMesh);
            return false;
         }
 
-        resultMesh->tris = (unsigned char*)rcAlloc(trisSize, RC_ALLOC_PERM);
+        resultMesh->tris = (unsigned char*)rcAlloc(trisSize, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH_DETAIL);
         if (!resultMesh->tris)
         {
            rcpdFreeMeshData(resultMesh);
            return false;
         }
 
-        resultMesh->verts = (float*)rcAlloc(vertSize, RC_ALLOC_PERM);
+        resultMesh->verts = (float*)rcAlloc(vertSize, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH_DETAIL);
         if (!resultMesh->verts)
         {
            rcpdFreeMeshData(resultMesh);
@@ -325,12 +316,15 @@ extern "C"
         if (!ctx || !mesh || !chf || !dmesh)
             return false;
 
+        nmgScratchScope scope(ctx, RC_TIMER_BUILD_POLYMESHDETAIL);
+
         if (rcBuildPolyMeshDetail(ctx
             , *mesh
             , *chf
             , sampleDist
             , sampleMaxError
-            , *dmesh))
+            , *dmesh
+            , ctx->getTaskScheduler()))
         {
             dmesh->maxverts = dmesh->nverts;
             dmesh->maxtris = dmesh->ntris;
@@ -141,7 +141,7 @@ extern "C"
             + 2 * regionFlagSize + areaSize;
 
         unsigned char* data = 
-            (unsigned char*)rcAlloc(totalDataSize, RC_ALLOC_PERM);
+            (unsigned char*)rcAlloc(totalDataSize, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH);
 
         if (!data)
             return false;
@@ -209,14 +209,14 @@ extern "C"
         if (dataSize < totalDataSize)
             return false;
 
-        resultMesh->verts = (unsigned short*)rcAlloc(vertSize, RC_ALLOC_PERM);
+        resultMesh->verts = (unsigned short*)rcAlloc(vertSize, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH);
         if (!resultMesh->verts)
         {
            rcpmFreeMeshData(resultMesh);
            return false;
         }
 
-        resultMesh->polys = (unsigned short*)rcAlloc(polySize, RC_ALLOC_PERM);
+        resultMesh->polys = (unsigned short*)rcAlloc(polySize, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH);
         if (!resultMesh->polys)
         {
            rcpmFreeMeshData(resultMesh);
@@ -224,7 +224,7 @@ extern "C"
         }
 
         resultMesh->regs = 
-            (unsigned short*)rcAlloc(regionFlagSize, RC_ALLOC_PERM);
+            (unsigned short*)rcAlloc(regionFlagSize, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH);
         if (!resultMesh->regs)
         {
             rcpmFreeMeshData(resultMesh);
@@ -232,14 +232,14 @@ extern "C"
         }
 
         resultMesh->flags = 
-            (unsigned short*)rcAlloc(regionFlagSize, RC_ALLOC_PERM);
+            (unsigned short*)rcAlloc(regionFlagSize, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH);
         if (!resultMesh->flags)
         {
             rcpmFreeMeshData(resultMesh);
             return false;
         }
 
-        resultMesh->areas = (unsigned char*)rcAlloc(areaSize, RC_ALLOC_PERM);
+        resultMesh->areas = (unsigned char*)rcAlloc(areaSize, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH);
         if (!resultMesh->areas)
         {
             rcpmFreeMeshData(resultMesh);
@@ -283,6 +283,8 @@ extern "C"
         if (!ctx || !cset || !mesh || !maxVerts)
             return false;
 
+        nmgScratchScope scope(ctx, RC_TIMER_BUILD_POLYMESH);
+
         if (!rcBuildPolyMesh(ctx, *cset, nvp, *mesh))
             return false;
 
@@ -300,15 +302,17 @@ extern "C"
         if (!ctx || !meshes || !mesh || !maxVerts)
             return false;
 
+        nmgScratchScope scope(ctx, RC_TIMER_MERGE_POLYMESH);
+
         rcPolyMesh** m = (rcPolyMesh**)
-            rcAlloc(sizeof(rcPolyMesh*) * nmeshes, RC_ALLOC_PERM);
+            rcAlloc(sizeof(rcPolyMesh*) * nmeshes, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH);
 
         for (int i = 0; i < nmeshes; i++)
         {
             m[i] = &meshes[i];
         }
 
-        bool result = rcMergePolyMeshes(ctx, m, nmeshes, *mesh);
+        bool result = rcMergePolyMeshes(ctx, m, nmeshes, *mesh, ctx->getTaskScheduler());
 
         rcFree(m);
 
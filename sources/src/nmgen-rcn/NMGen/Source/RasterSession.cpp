@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <new>
+#include <math.h>
+#include "NMGen.h"
+#include "RecastAlloc.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+// Minimal platform wrappers.  Only the parts the session needs.
+
+#if defined(_WIN32)
+
+struct nmgMutex { CRITICAL_SECTION cs; };
+
+static void initMutex(nmgMutex& m) { InitializeCriticalSection(&m.cs); }
+static void freeMutex(nmgMutex& m) { DeleteCriticalSection(&m.cs); }
+static void lock(nmgMutex& m) { EnterCriticalSection(&m.cs); }
+static void unlock(nmgMutex& m) { LeaveCriticalSection(&m.cs); }
+
+#else
+
+struct nmgMutex { pthread_mutex_t mutex; };
+
+static void initMutex(nmgMutex& m) { pthread_mutex_init(&m.mutex, 0); }
+static void freeMutex(nmgMutex& m) { pthread_mutex_destroy(&m.mutex); }
+static void lock(nmgMutex& m) { pthread_mutex_lock(&m.mutex); }
+static void unlock(nmgMutex& m) { pthread_mutex_unlock(&m.mutex); }
+
+#endif
+
+// Bands smaller than this spend most of their time on rejected triangles.
+static const int MIN_BAND_ROWS = 16;
+static const int MAX_BANDS = 64;
+
+struct nmgRasterBand
+{
+    nmgMutex mutex;
+    rcHeightfield hf;   // Shares the span grid.  Owns its own span pools.
+    int rowMin;
+    int rowMax;
+};
+
+struct nmgRasterSessionState
+{
+    rcHeightfield* target;
+    nmgRasterBand* bands;
+    int bandCount;
+    int flagMergeThr;
+    int flags;
+};
+
+nmgRasterSession::nmgRasterSession()
+    : m_state(0)
+{
+}
+
+nmgRasterSession::~nmgRasterSession()
+{
+    close();
+}
+
+bool nmgRasterSession::open(rcHeightfield* hf
+    , int bandCount
+    , const int flagMergeThr
+    , const int flags)
+{
+    close();
+
+    if (!hf || !hf->spans || hf->height < 1)
+        return false;
+
+    if (bandCount <= 0)
+        bandCount = rcClamp(hf->height / MIN_BAND_ROWS, 1, MAX_BANDS);
+    bandCount = rcMin(bandCount, hf->height);
+
+    nmgRasterSessionState* state = (nmgRasterSessionState*)rcAlloc(
+        sizeof(nmgRasterSessionState), RC_ALLOC_PERM);
+    nmgRasterBand* bands = (nmgRasterBand*)rcAlloc(
+        sizeof(nmgRasterBand) * bandCount, RC_ALLOC_PERM);
+
+    if (!state || !bands)
+    {
+        rcFree(state);
+        rcFree(bands);
+        return false;
+    }
+
+    for (int i = 0; i < bandCount; ++i)
+    {
+        nmgRasterBand& band = bands[i];
+        initMutex(band.mutex);
+        band.hf = *hf;
+        band.hf.pools = 0;
+        band.hf.freelist = 0;
+        band.rowMin = hf->height * i / bandCount;
+        band.rowMax = hf->height * (i + 1) / bandCount - 1;
+    }
+
+    state->target = hf;
+    state->bands = bands;
+    state->bandCount = bandCount;
+    state->flagMergeThr = flagMergeThr;
+    state->flags = flags;
+
+    m_state = state;
+
+    return true;
+}
+
+bool nmgRasterSession::addTriangles(const float* verts
+    , const int nv
+    , const int* tris
+    , const unsigned char* areas
+    , const int nt)
+{
+    if (!m_state || !verts || !tris || !areas || nv < 1 || nt < 0)
+        return false;
+
+    if (nt == 0)
+        return true;
+
+    const rcHeightfield& hf = *m_state->target;
+
+    // The rows the chunk can touch.  Only the bands that overlap them
+    // are locked.
+    float zmin = verts[2];
+    float zmax = verts[2];
+    for (int i = 1; i < nv; ++i)
+    {
+        zmin = rcMin(zmin, verts[i * 3 + 2]);
+        zmax = rcMax(zmax, verts[i * 3 + 2]);
+    }
+
+    if (zmax < hf.bmin[2] || zmin > hf.bmax[2])
+        return true;
+
+    const float ics = 1.0f / hf.cs;
+    const int rowMin = rcMax((int)floorf((zmin - hf.bmin[2]) * ics), 0);
+    const int rowMax = rcMin((int)floorf((zmax - hf.bmin[2]) * ics), hf.height - 1);
+
+    for (int i = 0; i < m_state->bandCount; ++i)
+    {
+        nmgRasterBand& band = m_state->bands[i];
+        if (band.rowMax < rowMin || band.rowMin > rowMax)
+            continue;
+
+        lock(band.mutex);
+        rcRasterizeTrianglesInRows(verts, nv, tris, areas, nt
+            , band.hf
+            , rcMax(band.rowMin, rowMin)
+            , rcMin(band.rowMax, rowMax)
+            , m_state->flagMergeThr
+            , m_state->flags);
+        unlock(band.mutex);
+    }
+
+    return true;
+}
+
+void nmgRasterSession::close()
+{
+    if (!m_state)
+        return;
+
+    rcHeightfield& solid = *m_state->target;
+
+    // Hand the band pools and free spans to the heightfield.
+    for (int i = 0; i < m_state->bandCount; ++i)
+    {
+        nmgRasterBand& band = m_state->bands[i];
+        rcHeightfield& hf = band.hf;
+        while (hf.pools)
+        {
+            rcSpanPool* next = hf.pools->next;
+            hf.pools->next = solid.pools;
+            solid.pools = hf.pools;
+            hf.pools = next;
+        }
+        while (hf.freelist)
+        {
+            rcSpan* next = hf.freelist->next;
+            hf.freelist->next = solid.freelist;
+            solid.freelist = hf.freelist;
+            hf.freelist = next;
+        }
+        freeMutex(band.mutex);
+    }
+
+    rcFree(m_state->bands);
+    rcFree(m_state);
+    m_state = 0;
+}
+
+extern "C"
+{
+    EXPORT_API nmgRasterSession* nmhfOpenRasterSession(nmgBuildContext* ctx
+        , rcHeightfield* hf
+        , const int bandCount
+        , const int flagMergeThr)
+    {
+        if (!ctx || !hf)
+            return 0;
+
+        nmgRasterSession* session = 
+            (nmgRasterSession*)rcAlloc(sizeof(nmgRasterSession), RC_ALLOC_PERM);
+        if (!session)
+            return 0;
+
+        new(session) nmgRasterSession();
+        if (!session->open(hf, bandCount, flagMergeThr, ctx->getRasterizeFlags()))
+        {
+            ctx->log(RC_LOG_ERROR, "nmhfOpenRasterSession: Could not open the session.");
+            session->~nmgRasterSession();
+            rcFree(session);
+            return 0;
+        }
+
+        return session;
+    }
+
+    EXPORT_API bool nmhfAddRasterChunk(nmgRasterSession* session
+        , const float* verts
+        , const int nv
+        , const int* tris
+        , const unsigned char* areas
+        , const int nt)
+    {
+        if (!session)
+            return false;
+
+        return session->addTriangles(verts, nv, tris, areas, nt);
+    }
+
+    EXPORT_API void nmhfCloseRasterSession(nmgRasterSession* session)
+    {
+        if (!session)
+            return;
+
+        session->~nmgRasterSession();
+        rcFree(session);
+    }
+}
@@ -0,0 +1,317 @@
+/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "NMGen.h"
+#include "RecastAlloc.h"
+#include "RecastAssert.h"
+
+#if defined(_MSC_VER)
+#define NMG_THREAD_LOCAL __declspec(thread)
+#else
+#define NMG_THREAD_LOCAL __thread
+#endif
+
+/*
+ * Design notes:
+ *
+ * The allocator is installed for the whole library, so every block
+ * carries a header identifying its source.  rcFree() provides no hint,
+ * so this is the only way to tell arena blocks from heap blocks.
+ *
+ * Arena blocks are only freed in bulk, except that freeing the most
+ * recent block rolls the arena back.  Temporary allocations must not
+ * outlive the scope they were made in.
+ *
+ * The working set is tracked per thread: heap blocks allocated by the
+ * thread, less the heap blocks it freed, plus its arena use.  Blocks
+ * freed by another thread are subtracted from that thread instead, so
+ * the values are only exact for builds that stay on one thread.
+ */
+
+static const unsigned int NMG_BLOCK_HEAP = 0x4e4d4850;   // 'NMHP'
+static const unsigned int NMG_BLOCK_ARENA = 0x4e4d4152;  // 'NMAR'
+
+// The smallest chunk allocated for an arena.
+static const int NMG_ARENA_CHUNK_SIZE = 1 << 20;
+// The largest chunk size used when growing.  (Larger requests still succeed.)
+static const int NMG_ARENA_MAX_CHUNK_SIZE = 1 << 26;
+// The chunk memory kept between outermost scopes.
+static const int NMG_ARENA_RETAIN_SIZE = 1 << 24;
+
+static const int NMG_ALIGN = 16;
+
+struct nmgBlockHeader
+{
+    unsigned int tag;
+    int size;       // Arena blocks: Total block size, including the header.
+    int pad[2];
+};
+
+struct nmgArenaChunk
+{
+    nmgArenaChunk* next;
+    int size;
+    int top;
+};
+
+struct nmgArena
+{
+    nmgArenaChunk* head;
+    nmgArenaChunk* current;
+    int used;
+    int peak;
+    int depth;
+};
+
+static const int NMG_BLOCK_HEADER_SIZE = 
+    (sizeof(nmgBlockHeader) + NMG_ALIGN - 1) & ~(NMG_ALIGN - 1);
+static const int NMG_CHUNK_HEADER_SIZE = 
+    (sizeof(nmgArenaChunk) + NMG_ALIGN - 1) & ~(NMG_ALIGN - 1);
+
+static NMG_THREAD_LOCAL nmgArena* tArena = 0;
+
+// The working set of the thread and its peak since the innermost scope began.
+static NMG_THREAD_LOCAL int tHeapLive = 0;
+static NMG_THREAD_LOCAL int tWorkingSetPeak = 0;
+
+inline int getWorkingSet()
+{
+    return tHeapLive + (tArena ? tArena->used : 0);
+}
+
+inline void updateWorkingSetPeak()
+{
+    tWorkingSetPeak = rcMax(tWorkingSetPeak, getWorkingSet());
+}
+
+inline unsigned char* getChunkData(nmgArenaChunk* chunk)
+{
+    return (unsigned char*)chunk + NMG_CHUNK_HEADER_SIZE;
+}
+
+static void freeChunks(nmgArenaChunk* chunk)
+{
+    while (chunk)
+    {
+        nmgArenaChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+}
+
+static void* allocArenaBlock(nmgArena& arena, const int size)
+{
+    const int need = NMG_BLOCK_HEADER_SIZE + ((size + NMG_ALIGN - 1) & ~(NMG_ALIGN - 1));
+
+    nmgArenaChunk* chunk = arena.current;
+    if (!chunk || chunk->top + need > chunk->size)
+    {
+        // Everything after the current chunk is unused.
+        nmgArenaChunk* next = chunk ? chunk->next : arena.head;
+        if (next && next->size >= need)
+        {
+            next->top = 0;
+        }
+        else
+        {
+            freeChunks(next);
+
+            int chunkSize = rcMax(NMG_ARENA_CHUNK_SIZE, need);
+            if (chunk)
+                chunkSize = rcMax(chunkSize, rcMin(chunk->size * 2, NMG_ARENA_MAX_CHUNK_SIZE));
+
+            next = (nmgArenaChunk*)malloc(NMG_CHUNK_HEADER_SIZE + chunkSize);
+            if (!next)
+            {
+                if (chunk)
+                    chunk->next = 0;
+                else
+                    arena.head = 0;
+                return 0;
+            }
+
+            next->next = 0;
+            next->size = chunkSize;
+            next->top = 0;
+
+            if (chunk)
+                chunk->next = next;
+            else
+                arena.head = next;
+        }
+        chunk = next;
+        arena.current = chunk;
+    }
+
+    nmgBlockHeader* header = (nmgBlockHeader*)(getChunkData(chunk) + chunk->top);
+    header->tag = NMG_BLOCK_ARENA;
+    header->size = need;
+
+    chunk->top += need;
+    arena.used += need;
+    arena.peak = rcMax(arena.peak, arena.used);
+
+    return (unsigned char*)header + NMG_BLOCK_HEADER_SIZE;
+}
+
+static void* nmgAlloc(int size, rcAllocHint hint)
+{
+    if (hint == RC_ALLOC_TEMP && tArena && tArena->depth > 0)
+    {
+        void* ptr = allocArenaBlock(*tArena, size);
+        if (ptr)
+        {
+            updateWorkingSetPeak();
+            return ptr;
+        }
+        // Fall back to the heap.
+    }
+
+    nmgBlockHeader* header = (nmgBlockHeader*)malloc(NMG_BLOCK_HEADER_SIZE + size);
+    if (!header)
+        return 0;
+
+    header->tag = NMG_BLOCK_HEAP;
+    header->size = size;
+
+    tHeapLive += size;
+    updateWorkingSetPeak();
+
+    return (unsigned char*)header + NMG_BLOCK_HEADER_SIZE;
+}
+
+static void nmgFree(void* ptr)
+{
+    nmgBlockHeader* header = (nmgBlockHeader*)((unsigned char*)ptr - NMG_BLOCK_HEADER_SIZE);
+
+    if (header->tag == NMG_BLOCK_HEAP)
+    {
+        tHeapLive -= header->size;
+        free(header);
+        return;
+    }
+
+    rcAssert(header->tag == NMG_BLOCK_ARENA);
+
+    // Roll back the most recent block.  Others are released with the scope.
+    nmgArena* arena = tArena;
+    if (arena && arena->current)
+    {
+        nmgArenaChunk* chunk = arena->current;
+        if ((unsigned char*)header + header->size == getChunkData(chunk) + chunk->top)
+        {
+            chunk->top -= header->size;
+            arena->used -= header->size;
+        }
+    }
+}
+
+// Installs the allocator before any other code in the library runs.
+struct nmgAllocInstaller
+{
+    nmgAllocInstaller() { rcAllocSetCustom(nmgAlloc, nmgFree); }
+};
+
+static nmgAllocInstaller sAllocInstaller;
+
+nmgScratchScope::nmgScratchScope(nmgBuildContext* ctx, const rcTimerLabel stage)
+    : mContext(ctx), mStage(stage), mChunk(0), mTop(0), mUsed(0), mPeak(0)
+    , mWorkingSetPeak(0), mActive(false)
+{
+    if (!tArena)
+    {
+        tArena = (nmgArena*)malloc(sizeof(nmgArena));
+        if (!tArena)
+            return;
+        memset(tArena, 0, sizeof(nmgArena));
+    }
+
+    nmgArena& arena = *tArena;
+
+    mChunk = arena.current;
+    mTop = arena.current ? arena.current->top : 0;
+    mUsed = arena.used;
+    mPeak = arena.peak;
+    mWorkingSetPeak = tWorkingSetPeak;
+    mActive = true;
+
+    arena.peak = arena.used;
+    arena.depth++;
+    tWorkingSetPeak = getWorkingSet();
+}
+
+nmgScratchScope::~nmgScratchScope()
+{
+    if (!mActive)
+        return;
+
+    nmgArena& arena = *tArena;
+
+    const int scopePeak = arena.peak - mUsed;
+    const int workingSetPeak = tWorkingSetPeak;
+
+    // Release everything allocated within the scope.
+    arena.current = (nmgArenaChunk*)mChunk;
+    if (arena.current)
+        arena.current->top = mTop;
+    arena.used = mUsed;
+    arena.peak = rcMax(mPeak, arena.peak);
+    arena.depth--;
+    tWorkingSetPeak = rcMax(mWorkingSetPeak, tWorkingSetPeak);
+
+    if (arena.depth == 0)
+    {
+        // Trim the retained memory.
+        int retained = 0;
+        nmgArenaChunk* prev = 0;
+        for (nmgArenaChunk* chunk = arena.head; chunk; chunk = chunk->next)
+        {
+            retained += chunk->size;
+            if (retained > NMG_ARENA_RETAIN_SIZE && prev)
+            {
+                freeChunks(chunk);
+                prev->next = 0;
+                break;
+            }
+            prev = chunk;
+        }
+        arena.current = 0;
+        arena.peak = 0;
+    }
+
+    if (mContext)
+    {
+        mContext->recordScratchPeak(mStage, scopePeak);
+        mContext->recordWorkingSetPeak(mStage, workingSetPeak);
+    }
+}
+
+void nmgReleaseScratch()
+{
+    if (!tArena || tArena->depth > 0)
+        return;
+
+    freeChunks(tArena->head);
+    free(tArena);
+    tArena = 0;
+}
@@ -0,0 +1,1479 @@
+/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <string.h>
+#include "NMGen.h"
+#include "RecastAlloc.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+// Tile build flags.
+static const unsigned char NMG_TILE_FILTER_LOW_OBSTACLES = 0x01;
+static const unsigned char NMG_TILE_FILTER_LEDGES = 0x02;
+static const unsigned char NMG_TILE_FILTER_LOW_HEIGHT = 0x04;
+static const unsigned char NMG_TILE_MONOTONE_REGIONS = 0x08;
+
+// Tile build results.
+static const unsigned char NMG_TILE_NO_RESULT = 0;
+static const unsigned char NMG_TILE_COMPLETE = 1;
+static const unsigned char NMG_TILE_FAILED = 2;
+
+// Build settings shared by all tiles.
+struct nmgTileBuildConfig
+{
+    rcConfig config;
+    int contourFlags;
+    unsigned char buildFlags;
+};
+
+struct nmgTileCache
+{
+    nmgTileBuildConfig cfg;
+
+    // The tile grid.  Empty tiles have no field.
+    int width;
+    int depth;
+    rcCompactHeightfield** fields;
+};
+
+// Off-mesh connections, in the layout of the navigation build data.
+struct nmgTileConnections
+{
+    const float* verts;     // (start, end) [Size: 6 * count]
+    const float* radii;
+    const unsigned char* dirs;
+    const unsigned char* areas;
+    const unsigned short* flags;
+    const unsigned int* userIds;
+    int count;
+};
+
+// The version of the tile key contents.  Change it whenever the build 
+// output can change for the same inputs.
+static const unsigned int NMG_TILE_KEY_VERSION = 1;
+
+// Per-worker state.  Nothing in here is shared between threads.
+struct nmgTileWorker
+{
+    nmgBuildContext* ctx;
+    int* tris;
+    unsigned char* areas;
+    int maxTris;
+};
+
+struct nmgTileBuildJob
+{
+    const nmgTileBuildConfig* cfg;
+
+    const float* verts;
+    int nverts;
+    const int* tris;
+    const unsigned char* areas;
+
+    // Triangles overlapping each tile.  (Compressed rows.)
+    const int* tileTriStart;
+    const int* tileTris;
+
+    const nmgAreaMarker* markers;
+    int markerCount;
+
+    const int* tiles;
+    int tileCount;
+
+    // The walkable radius of each output profile.  The outputs are profile
+    // major.  [tileCount * profileCount]
+    const int* walkableRadii;
+    int profileCount;
+
+    // Rebuilds start from the cached fields instead of the triangles.
+    nmgTileCache* cache;
+    bool rebuild;
+
+    // Hash jobs write the key of each tile instead of building it.
+    nmgTileKey* keys;
+    const nmgTileConnections* connections;
+    unsigned int salt;
+
+    rcPolyMesh* polyMeshes;
+    nmgPolyMeshDetail* detailMeshes;
+    int* maxVerts;
+    unsigned char* results;
+
+    nmgTileWorker* workers;
+
+    int nextTile;
+#if defined(_WIN32)
+    CRITICAL_SECTION lock;
+#else
+    pthread_mutex_t lock;
+#endif
+};
+
+struct nmgTileThread
+{
+    nmgTileBuildJob* job;
+    int workerIndex;
+#if defined(_WIN32)
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+};
+
+static int nmgGetProcessorCount()
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    const long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+#endif
+}
+
+static void nmgGetTileBounds(const rcConfig& config
+    , const int tx
+    , const int tz
+    , float* bmin
+    , float* bmax)
+{
+    rcVcopy(bmin, config.bmin);
+    rcVcopy(bmax, config.bmax);
+
+    if (config.tileSize <= 0)
+        return;
+
+    const float tcs = config.tileSize * config.cs;
+    const float border = config.borderSize * config.cs;
+
+    bmin[0] = config.bmin[0] + tx * tcs - border;
+    bmin[2] = config.bmin[2] + tz * tcs - border;
+    bmax[0] = config.bmin[0] + (tx + 1) * tcs + border;
+    bmax[2] = config.bmin[2] + (tz + 1) * tcs + border;
+}
+
+static bool nmgReserveTris(nmgTileWorker& worker, const int count)
+{
+    if (count <= worker.maxTris)
+        return true;
+
+    rcFree(worker.tris);
+    rcFree(worker.areas);
+    worker.tris = (int*)rcAlloc(sizeof(int) * count * 3, RC_ALLOC_PERM);
+    worker.areas = (unsigned char*)rcAlloc(sizeof(unsigned char) * count, RC_ALLOC_PERM);
+    worker.maxTris = (worker.tris && worker.areas) ? count : 0;
+
+    return worker.maxTris > 0;
+}
+
+static void nmgGetTileGridSize(const rcConfig& cfg, int* width, int* depth)
+{
+    *width = 1;
+    *depth = 1;
+    if (cfg.tileSize > 0)
+    {
+        *width = (cfg.width + cfg.tileSize - 1) / cfg.tileSize;
+        *depth = (cfg.height + cfg.tileSize - 1) / cfg.tileSize;
+    }
+}
+
+// Returns the cache entry for the tile, or null if the tile is outside 
+// the cache grid.
+static rcCompactHeightfield** nmgGetCacheSlot(nmgTileCache& cache, int tx, int tz)
+{
+    if (cache.cfg.config.tileSize <= 0)
+    {
+        tx = 0;
+        tz = 0;
+    }
+
+    if (!cache.fields || tx < 0 || tz < 0 || tx >= cache.width || tz >= cache.depth)
+        return 0;
+
+    return &cache.fields[tx + tz * cache.width];
+}
+
+static void nmgSetCachedField(rcCompactHeightfield** slot, rcCompactHeightfield* chf)
+{
+    rcFreeCompactHeightfield(*slot);
+    *slot = chf;
+}
+
+static void nmgClearTileCache(nmgTileCache& cache)
+{
+    if (cache.fields)
+    {
+        for (int i = 0; i < cache.width * cache.depth; i++)
+            rcFreeCompactHeightfield(cache.fields[i]);
+    }
+    rcFree(cache.fields);
+
+    cache.fields = 0;
+    cache.width = 0;
+    cache.depth = 0;
+}
+
+// Makes the cache match the build settings.  Cached fields are kept only 
+// if the settings have not changed.
+static bool nmgPrepareTileCache(nmgTileCache& cache, const nmgTileBuildConfig& tcfg)
+{
+    if (cache.fields && memcmp(&cache.cfg, &tcfg, sizeof(nmgTileBuildConfig)) == 0)
+        return true;
+
+    nmgClearTileCache(cache);
+
+    int width;
+    int depth;
+    nmgGetTileGridSize(tcfg.config, &width, &depth);
+
+    const int size = sizeof(rcCompactHeightfield*) * width * depth;
+    cache.fields = (rcCompactHeightfield**)rcAlloc(size, RC_ALLOC_PERM);
+    if (!cache.fields)
+        return false;
+
+    memset(cache.fields, 0, size);
+    memcpy(&cache.cfg, &tcfg, sizeof(nmgTileBuildConfig));
+    cache.width = width;
+    cache.depth = depth;
+
+    return true;
+}
+
+static rcCompactHeightfield* nmgCloneCompactField(const rcCompactHeightfield& src)
+{
+    rcCompactHeightfield* chf = rcAllocCompactHeightfield();
+    if (!chf)
+        return 0;
+
+    memcpy(chf, &src, sizeof(rcCompactHeightfield));
+    chf->cells = 0;
+    chf->spans = 0;
+    chf->dist = 0;
+    chf->areas = 0;
+
+    const int cellCount = src.width * src.height;
+    chf->cells = (rcCompactCell*)rcAlloc(sizeof(rcCompactCell) * cellCount, RC_ALLOC_PERM, RC_ALLOC_TAG_COMPACT_HEIGHTFIELD);
+    chf->spans = (rcCompactSpan*)rcAlloc(sizeof(rcCompactSpan) * src.spanCount, RC_ALLOC_PERM, RC_ALLOC_TAG_COMPACT_HEIGHTFIELD);
+    chf->areas = (unsigned char*)rcAlloc(sizeof(unsigned char) * src.spanCount, RC_ALLOC_PERM, RC_ALLOC_TAG_COMPACT_HEIGHTFIELD);
+    if (src.dist)
+        chf->dist = (unsigned short*)rcAlloc(sizeof(unsigned short) * src.spanCount, RC_ALLOC_PERM, RC_ALLOC_TAG_COMPACT_HEIGHTFIELD);
+
+    if (!chf->cells || !chf->spans || !chf->areas || (src.dist && !chf->dist))
+    {
+        rcFreeCompactHeightfield(chf);
+        return 0;
+    }
+
+    memcpy(chf->cells, src.cells, sizeof(rcCompactCell) * cellCount);
+    memcpy(chf->spans, src.spans, sizeof(rcCompactSpan) * src.spanCount);
+    memcpy(chf->areas, src.areas, sizeof(unsigned char) * src.spanCount);
+    if (src.dist)
+        memcpy(chf->dist, src.dist, sizeof(unsigned short) * src.spanCount);
+
+    return chf;
+}
+
+// Applies the markers in array order.
+static void nmgMarkAreas(nmgBuildContext* ctx
+    , const nmgAreaMarker* markers
+    , const int markerCount
+    , rcCompactHeightfield& chf)
+{
+    for (int i = 0; i < markerCount; i++)
+    {
+        const nmgAreaMarker& marker = markers[i];
+        if (marker.type == NMG_MARKER_CYLINDER)
+        {
+            rcMarkCylinderArea(ctx
+                , marker.verts, marker.radius, marker.height, marker.area, chf);
+        }
+        else
+        {
+            rcMarkConvexPolyArea(ctx
+                , marker.verts, marker.nverts, marker.ymin, marker.ymax, marker.area, chf);
+        }
+    }
+}
+
+// Gets the xz-bounds of the marker.  (The y-values are not set.)
+static void nmgGetMarkerBounds(const nmgAreaMarker& marker, float* bmin, float* bmax)
+{
+    if (marker.type == NMG_MARKER_CYLINDER)
+    {
+        bmin[0] = marker.verts[0] - marker.radius;
+        bmin[2] = marker.verts[2] - marker.radius;
+        bmax[0] = marker.verts[0] + marker.radius;
+        bmax[2] = marker.verts[2] + marker.radius;
+        return;
+    }
+
+    bmin[0] = bmax[0] = marker.verts[0];
+    bmin[2] = bmax[2] = marker.verts[2];
+    for (int i = 1; i < marker.nverts; i++)
+    {
+        const float* v = &marker.verts[i * 3];
+        bmin[0] = rcMin(bmin[0], v[0]);
+        bmin[2] = rcMin(bmin[2], v[2]);
+        bmax[0] = rcMax(bmax[0], v[0]);
+        bmax[2] = rcMax(bmax[2], v[2]);
+    }
+}
+
+static bool nmgMarkerOverlaps(const nmgAreaMarker& marker
+    , const float* tmin
+    , const float* tmax)
+{
+    float bmin[3];
+    float bmax[3];
+    nmgGetMarkerBounds(marker, bmin, bmax);
+
+    return bmin[0] <= tmax[0] && bmax[0] >= tmin[0]
+        && bmin[2] <= tmax[2] && bmax[2] >= tmin[2];
+}
+
+static void nmgSetTileResults(nmgTileBuildJob& job
+    , const int tileIndex
+    , const unsigned char result)
+{
+    for (int i = 0; i < job.profileCount; i++)
+        job.results[i * job.tileCount + tileIndex] = result;
+}
+
+// Runs the radius dependent part of the build chain, from the area marking 
+// step on.  The field is consumed.
+static unsigned char nmgBuildTileMesh(nmgTileBuildJob& job
+    , nmgBuildContext* ctx
+    , const rcConfig& cfg
+    , const int tx
+    , const int tz
+    , const int outputIndex
+    , rcCompactHeightfield& chf)
+{
+    const nmgTileBuildConfig& tcfg = *job.cfg;
+
+    rcContourSet* cset = 0;
+    rcPolyMesh& mesh = job.polyMeshes[outputIndex];
+    nmgPolyMeshDetail& dmesh = job.detailMeshes[outputIndex];
+
+    unsigned char result = NMG_TILE_FAILED;
+
+    nmgMarkAreas(ctx, job.markers, job.markerCount, chf);
+
+    if (cfg.walkableRadius > 0)
+    {
+        nmgScratchScope scope(ctx, RC_TIMER_ERODE_AREA);
+        if (!rcErodeWalkableArea(ctx, cfg.walkableRadius, chf))
+        {
+            ctx->log(RC_LOG_ERROR, "Tile (%d, %d): Erode failed.", tx, tz);
+            goto done;
+        }
+    }
+
+    if (tcfg.buildFlags & NMG_TILE_MONOTONE_REGIONS)
+    {
+        nmgScratchScope scope(ctx, RC_TIMER_BUILD_REGIONS);
+        if (!rcBuildRegionsMonotone(ctx
+            , chf, cfg.borderSize, cfg.minRegionArea, cfg.mergeRegionArea))
+        {
+            ctx->log(RC_LOG_ERROR, "Tile (%d, %d): Monotone region build failed.", tx, tz);
+            goto done;
+        }
+    }
+    else
+    {
+        nmgScratchScope scope(ctx, RC_TIMER_BUILD_REGIONS);
+        if (!rcBuildDistanceField(ctx, chf)
+            || !rcBuildRegions(ctx
+                , chf, cfg.borderSize, cfg.minRegionArea, cfg.mergeRegionArea))
+        {
+            ctx->log(RC_LOG_ERROR, "Tile (%d, %d): Region build failed.", tx, tz);
+            goto done;
+        }
+
+        // The later stages don't use the distance field.
+        rcFree(chf.dist);
+        chf.dist = 0;
+        chf.maxDistance = 0;
+    }
+
+    if (chf.maxRegions < 2)
+    {
+        // Null region counts as a region.
+        result = NMG_TILE_NO_RESULT;
+        goto done;
+    }
+
+    cset = rcAllocContourSet();
+    {
+        nmgScratchScope scope(ctx, RC_TIMER_BUILD_CONTOURS);
+        if (!cset || !rcBuildContours(ctx
+            , chf, cfg.maxSimplificationError, cfg.maxEdgeLen, *cset, tcfg.contourFlags))
+        {
+            ctx->log(RC_LOG_ERROR, "Tile (%d, %d): Contour build failed.", tx, tz);
+            goto done;
+        }
+    }
+
+    if (cset->nconts == 0)
+    {
+        result = NMG_TILE_NO_RESULT;
+        goto done;
+    }
+
+    {
+        nmgScratchScope scope(ctx, RC_TIMER_BUILD_POLYMESH);
+        if (!rcBuildPolyMesh(ctx, *cset, cfg.maxVertsPerPoly, mesh))
+        {
+            ctx->log(RC_LOG_ERROR, "Tile (%d, %d): Poly mesh build failed.", tx, tz);
+            goto done;
+        }
+    }
+
+    rcFreeContourSet(cset);
+    cset = 0;
+
+    if (mesh.npolys == 0)
+    {
+        result = NMG_TILE_NO_RESULT;
+        goto done;
+    }
+
+    job.maxVerts[outputIndex] = getMaxVerts(mesh);
+
+    {
+        nmgScratchScope scope(ctx, RC_TIMER_BUILD_POLYMESHDETAIL);
+        if (!rcBuildPolyMeshDetail(ctx
+            , mesh, chf, cfg.detailSampleDist, cfg.detailSampleMaxError, dmesh))
+        {
+            ctx->log(RC_LOG_ERROR, "Tile (%d, %d): Detail mesh build failed.", tx, tz);
+            goto done;
+        }
+    }
+
+    dmesh.maxverts = dmesh.nverts;
+    dmesh.maxtris = dmesh.ntris;
+    dmesh.maxmeshes = dmesh.nmeshes;
+    dmesh.resourcetype = NMG_ALLOC_TYPE_LOCAL;
+
+    result = NMG_TILE_COMPLETE;
+
+done:
+    rcFreeContourSet(cset);
+
+    return result;
+}
+
+// Runs the full build chain for one tile, once per profile.  The radius 
+// independent steps are shared by all profiles.
+static void nmgBuildTile(nmgTileBuildJob& job
+    , nmgTileWorker& worker
+    , const int tileIndex)
+{
+    const nmgTileBuildConfig& tcfg = *job.cfg;
+    const rcConfig& base = tcfg.config;
+    nmgBuildContext* ctx = worker.ctx;
+
+    const int tx = job.tiles[tileIndex * 2 + 0];
+    const int tz = job.tiles[tileIndex * 2 + 1];
+
+    rcConfig cfg = base;
+    nmgGetTileBounds(base, tx, tz, cfg.bmin, cfg.bmax);
+    if (base.tileSize > 0)
+    {
+        cfg.width = base.tileSize + base.borderSize * 2;
+        cfg.height = base.tileSize + base.borderSize * 2;
+    }
+
+    // Each tile has its own cache entry, so no locking is needed as long as
+    // the tile list has no duplicates.
+    rcCompactHeightfield** slot = job.cache ? nmgGetCacheSlot(*job.cache, tx, tz) : 0;
+    bool cached = false;
+
+    int ntris = 0;
+    if (job.rebuild)
+    {
+        // Tiles without a cached field have nothing to rebuild.
+        if (!slot || !*slot)
+        {
+            nmgSetTileResults(job, tileIndex, NMG_TILE_NO_RESULT);
+            return;
+        }
+    }
+    else
+    {
+        // Gather the triangles that overlap the tile into scratch memory.
+        const int* tileTris = &job.tileTris[job.tileTriStart[tileIndex]];
+        ntris = job.tileTriStart[tileIndex + 1] - job.tileTriStart[tileIndex];
+
+        if (ntris == 0)
+        {
+            if (slot)
+                nmgSetCachedField(slot, 0);
+            nmgSetTileResults(job, tileIndex, NMG_TILE_NO_RESULT);
+            return;
+        }
+
+        if (!nmgReserveTris(worker, ntris))
+        {
+            ctx->log(RC_LOG_ERROR, "Tile (%d, %d): Out of memory.", tx, tz);
+            if (slot)
+                nmgSetCachedField(slot, 0);
+            nmgSetTileResults(job, tileIndex, NMG_TILE_FAILED);
+            return;
+        }
+
+        for (int i = 0; i < ntris; i++)
+        {
+            const int t = tileTris[i];
+            memcpy(&worker.tris[i * 3], &job.tris[t * 3], sizeof(int) * 3);
+            worker.areas[i] = job.areas[t];
+        }
+    }
+
+    rcHeightfield* hf = 0;
+    rcCompactHeightfield* chf = 0;
+
+    // Temporary memory is released per stage, and again when the tile ends.
+    nmgScratchScope tileScope(ctx, RC_TIMER_TOTAL);
+
+    const int64_t startTime = ctx->getTimerTotal(RC_TIMER_TOTAL);
+    ctx->startTimer(RC_TIMER_TOTAL);
+
+    if (job.rebuild)
+    {
+        chf = nmgCloneCompactField(**slot);
+        if (!chf)
+        {
+            ctx->log(RC_LOG_ERROR, "Tile (%d, %d): Out of memory.", tx, tz);
+            goto done;
+        }
+    }
+    else
+    {
+        hf = rcAllocHeightfield();
+        if (!hf || !rcCreateHeightfield(ctx
+            , *hf, cfg.width, cfg.height, cfg.bmin, cfg.bmax, cfg.cs, cfg.ch))
+        {
+            ctx->log(RC_LOG_ERROR, "Tile (%d, %d): Heightfield creation failed.", tx, tz);
+            goto done;
+        }
+
+        rcRasterizeTriangles(ctx
+            , job.verts, job.nverts, worker.tris, worker.areas, ntris
+            , *hf, cfg.walkableClimb, ctx->getRasterizeFlags());
+
+        if (tcfg.buildFlags & NMG_TILE_FILTER_LOW_OBSTACLES)
+            rcFilterLowHangingWalkableObstacles(ctx, cfg.walkableClimb, *hf);
+        if (tcfg.buildFlags & NMG_TILE_FILTER_LEDGES)
+            rcFilterLedgeSpans(ctx, cfg.walkableHeight, cfg.walkableClimb, *hf);
+        if (tcfg.buildFlags & NMG_TILE_FILTER_LOW_HEIGHT)
+            rcFilterWalkableLowHeightSpans(ctx, cfg.walkableHeight, *hf);
+
+        chf = rcAllocCompactHeightfield();
+        if (!chf || !rcBuildCompactHeightfield(ctx
+            , cfg.walkableHeight, cfg.walkableClimb, *hf, *chf))
+        {
+            ctx->log(RC_LOG_ERROR, "Tile (%d, %d): Compact heightfield build failed.", tx, tz);
+            goto done;
+        }
+
+        rcFreeHeightField(hf);
+        hf = 0;
+
+        if (chf->spanCount == 0)
+        {
+            nmgSetTileResults(job, tileIndex, NMG_TILE_NO_RESULT);
+            goto done;
+        }
+
+        if (slot)
+        {
+            // The cached field is unmarked so the markers can change.
+            rcCompactHeightfield* field = nmgCloneCompactField(*chf);
+            if (!field)
+            {
+                ctx->log(RC_LOG_ERROR, "Tile (%d, %d): Out of memory.", tx, tz);
+                goto done;
+            }
+            nmgSetCachedField(slot, field);
+            cached = true;
+        }
+    }
+
+    for (int i = 0; i < job.profileCount; i++)
+    {
+        // The last profile consumes the shared field.
+        rcCompactHeightfield* field = chf;
+        if (i < job.profileCount - 1)
+        {
+            field = nmgCloneCompactField(*chf);
+            if (!field)
+            {
+                ctx->log(RC_LOG_ERROR, "Tile (%d, %d): Out of memory.", tx, tz);
+                goto done;
+            }
+        }
+
+        cfg.walkableRadius = job.walkableRadii[i];
+
+        const int outputIndex = i * job.tileCount + tileIndex;
+        job.results[outputIndex] = nmgBuildTileMesh(job, ctx, cfg, tx, tz, outputIndex, *field);
+
+        if (field != chf)
+            rcFreeCompactHeightfield(field);
+    }
+
+done:
+    // Don't leave a stale field in the cache.
+    if (slot && !job.rebuild && !cached)
+        nmgSetCachedField(slot, 0);
+
+    rcFreeHeightField(hf);
+    rcFreeCompactHeightfield(chf);
+
+    ctx->stopTimer(RC_TIMER_TOTAL);
+    if (ctx->getTimerEnabled())
+    {
+        // Only logged when timers are on, so default builds stay quiet.
+        ctx->log(RC_LOG_PROGRESS, "Tile (%d, %d): Built in %.3f ms."
+            , tx, tz, (ctx->getTimerTotal(RC_TIMER_TOTAL) - startTime) / 1000.0);
+    }
+}
+
+// Hashes everything the tile's build reads.  Values are hashed instead of 
+// indices, so edits elsewhere in the source mesh do not change the key.
+static void nmgHashTile(nmgTileBuildJob& job
+    , nmgTileWorker& worker
+    , const int tileIndex)
+{
+    const nmgTileBuildConfig& tcfg = *job.cfg;
+
+    const int tx = job.tiles[tileIndex * 2 + 0];
+    const int tz = job.tiles[tileIndex * 2 + 1];
+
+    float tmin[3];
+    float tmax[3];
+    nmgGetTileBounds(tcfg.config, tx, tz, tmin, tmax);
+
+    nmgContentHash hash(NMG_TILE_KEY_VERSION);
+    hash.addValue(job.salt);
+    hash.addValue(tcfg.config);
+    hash.addValue(tcfg.contourFlags);
+    hash.addValue(tcfg.buildFlags);
+    hash.addValue(worker.ctx->getRasterizeFlags());
+    hash.addValue(tx);
+    hash.addValue(tz);
+
+    // The triangles, in the order they are rasterized.
+    const int* tileTris = &job.tileTris[job.tileTriStart[tileIndex]];
+    const int ntris = job.tileTriStart[tileIndex + 1] - job.tileTriStart[tileIndex];
+    for (int i = 0; i < ntris; i++)
+    {
+        const int t = tileTris[i];
+        for (int j = 0; j < 3; j++)
+            hash.add(&job.verts[job.tris[t * 3 + j] * 3], sizeof(float) * 3);
+        hash.addValue(job.areas[t]);
+    }
+    hash.addValue(ntris);
+
+    // Markers outside the tile bounds have no effect.  The others are 
+    // applied in array order.
+    int count = 0;
+    for (int i = 0; i < job.markerCount; i++)
+    {
+        const nmgAreaMarker& marker = job.markers[i];
+        if (!nmgMarkerOverlaps(marker, tmin, tmax))
+            continue;
+
+        hash.addValue(marker.type);
+        hash.addValue(marker.area);
+        if (marker.type == NMG_MARKER_CYLINDER)
+        {
+            hash.add(marker.verts, sizeof(float) * 3);
+            hash.addValue(marker.radius);
+            hash.addValue(marker.height);
+        }
+        else
+        {
+            hash.addValue(marker.nverts);
+            hash.add(marker.verts, sizeof(float) * 3 * marker.nverts);
+            hash.addValue(marker.ymin);
+            hash.addValue(marker.ymax);
+        }
+        count++;
+    }
+    hash.addValue(count);
+
+    // Connections belong to the tile that contains their start point.  The
+    // border is included, so a key may cover a few connections that the
+    // tile itself does not get.
+    const nmgTileConnections& conns = *job.connections;
+    count = 0;
+    for (int i = 0; i < conns.count; i++)
+    {
+        const float* v = &conns.verts[i * 6];
+        if (v[0] < tmin[0] || v[0] > tmax[0] || v[2] < tmin[2] || v[2] > tmax[2])
+            continue;
+
+        hash.add(v, sizeof(float) * 6);
+        hash.addValue(conns.radii[i]);
+        hash.addValue(conns.dirs[i]);
+        hash.addValue(conns.areas[i]);
+        hash.addValue(conns.flags[i]);
+        hash.addValue(conns.userIds[i]);
+        count++;
+    }
+    hash.addValue(count);
+
+    hash.finish(job.keys[tileIndex]);
+}
+
+static void nmgRunTileWorker(nmgTileBuildJob* job, const int workerIndex)
+{
+    nmgTileWorker& worker = job->workers[workerIndex];
+
+    for (;;)
+    {
+#if defined(_WIN32)
+        EnterCriticalSection(&job->lock);
+        const int i = job->nextTile++;
+        LeaveCriticalSection(&job->lock);
+#else
+        pthread_mutex_lock(&job->lock);
+        const int i = job->nextTile++;
+        pthread_mutex_unlock(&job->lock);
+#endif
+        if (i >= job->tileCount)
+            break;
+
+        if (job->keys)
+            nmgHashTile(*job, worker, i);
+        else
+            nmgBuildTile(*job, worker, i);
+    }
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI nmgTileThreadMain(LPVOID arg)
+#else
+static void* nmgTileThreadMain(void* arg)
+#endif
+{
+    nmgTileThread* thread = (nmgTileThread*)arg;
+    nmgRunTileWorker(thread->job, thread->workerIndex);
+    nmgReleaseScratch();
+    return 0;
+}
+
+// Buckets triangles by the tiles their xz-bounds overlap.
+static bool nmgBuildTileLists(const rcConfig& cfg
+    , const float* verts
+    , const int* tris
+    , const int ntris
+    , const int* tiles
+    , const int tileCount
+    , int** resultStart
+    , int** resultTris)
+{
+    // Map tile grid locations to tile indices.
+    int gw = 1;
+    int gh = 1;
+    if (cfg.tileSize > 0)
+    {
+        gw = (cfg.width + cfg.tileSize - 1) / cfg.tileSize;
+        gh = (cfg.height + cfg.tileSize - 1) / cfg.tileSize;
+    }
+
+    int* grid = (int*)rcAlloc(sizeof(int) * gw * gh, RC_ALLOC_TEMP);
+    int* start = (int*)rcAlloc(sizeof(int) * (tileCount + 1), RC_ALLOC_TEMP);
+    if (!grid || !start)
+    {
+        rcFree(grid);
+        rcFree(start);
+        return false;
+    }
+
+    memset(grid, 0xff, sizeof(int) * gw * gh);
+    memset(start, 0, sizeof(int) * (tileCount + 1));
+
+    for (int i = 0; i < tileCount; i++)
+    {
+        const int tx = cfg.tileSize > 0 ? tiles[i * 2 + 0] : 0;
+        const int tz = cfg.tileSize > 0 ? tiles[i * 2 + 1] : 0;
+        if (tx >= 0 && tz >= 0 && tx < gw && tz < gh)
+            grid[tx + tz * gw] = i;
+    }
+
+    const float tcs = cfg.tileSize > 0 ? cfg.tileSize * cfg.cs : 1;
+    const float border = cfg.borderSize * cfg.cs;
+
+    int* list = 0;
+
+    // Two passes: Count, then fill.
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (int t = 0; t < ntris; t++)
+        {
+            int x0 = 0;
+            int x1 = 0;
+            int z0 = 0;
+            int z1 = 0;
+
+            if (cfg.tileSize > 0)
+            {
+                const float* v0 = &verts[tris[t * 3 + 0] * 3];
+                const float* v1 = &verts[tris[t * 3 + 1] * 3];
+                const float* v2 = &verts[tris[t * 3 + 2] * 3];
+
+                const float xmin = rcMin(v0[0], rcMin(v1[0], v2[0])) - cfg.bmin[0];
+                const float xmax = rcMax(v0[0], rcMax(v1[0], v2[0])) - cfg.bmin[0];
+                const float zmin = rcMin(v0[2], rcMin(v1[2], v2[2])) - cfg.bmin[2];
+                const float zmax = rcMax(v0[2], rcMax(v1[2], v2[2])) - cfg.bmin[2];
+
+                // Tiles include a border, so a triangle can touch
+                // the tiles next to the one it is in.
+                if (xmax + border < 0 || zmax + border < 0)
+                    continue;
+
+                x0 = rcMax(0, (int)((xmin - border) / tcs));
+                x1 = rcMin(gw - 1, (int)((xmax + border) / tcs));
+                z0 = rcMax(0, (int)((zmin - border) / tcs));
+                z1 = rcMin(gh - 1, (int)((zmax + border) / tcs));
+            }
+
+            for (int z = z0; z <= z1; z++)
+            {
+                for (int x = x0; x <= x1; x++)
+                {
+                    const int i = grid[x + z * gw];
+                    if (i < 0)
+                        continue;
+
+                    if (pass == 0)
+                        start[i + 1]++;
+                    else
+                        list[start[i]++] = t;
+                }
+            }
+        }
+
+        if (pass == 0)
+        {
+            for (int i = 0; i < tileCount; i++)
+                start[i + 1] += start[i];
+
+            list = (int*)rcAlloc(sizeof(int) * rcMax(start[tileCount], 1), RC_ALLOC_TEMP);
+            if (!list)
+            {
+                rcFree(grid);
+                rcFree(start);
+                return false;
+            }
+        }
+        else
+        {
+            // The fill advanced each start to the start of the next row.
+            for (int i = tileCount; i > 0; i--)
+                start[i] = start[i - 1];
+            start[0] = 0;
+        }
+    }
+
+    rcFree(grid);
+
+    *resultStart = start;
+    *resultTris = list;
+
+    return true;
+}
+
+// Builds the job's tiles on a set of worker threads.  Worker logs, timers
+// and scratch peaks are merged into the context once all tiles are done.
+static bool nmgRunTileJob(nmgBuildContext* ctx
+    , nmgTileBuildJob& job
+    , const int threadCount
+    , const char* name)
+{
+    int workerCount = threadCount > 0 ? threadCount : nmgGetProcessorCount();
+    workerCount = rcClamp(workerCount, 1, job.tileCount);
+
+    nmgTileWorker* workers = (nmgTileWorker*)rcAlloc(
+        sizeof(nmgTileWorker) * workerCount, RC_ALLOC_TEMP);
+    nmgTileThread* threads = (nmgTileThread*)rcAlloc(
+        sizeof(nmgTileThread) * workerCount, RC_ALLOC_TEMP);
+
+    bool ok = workers && threads;
+    if (workers)
+        memset(workers, 0, sizeof(nmgTileWorker) * workerCount);
+
+    const bool logEnabled = ctx ? ctx->getLogEnabled() : false;
+    for (int i = 0; ok && i < workerCount; i++)
+    {
+        workers[i].ctx = new nmgBuildContext();
+        if (workers[i].ctx)
+        {
+            workers[i].ctx->enableLog(logEnabled);
+            workers[i].ctx->enableTimer(ctx ? ctx->getTimerEnabled() : false);
+            workers[i].ctx->setRasterizeFlags(ctx ? ctx->getRasterizeFlags() : 0);
+        }
+        else
+            ok = false;
+    }
+
+    if (ok)
+    {
+        job.workers = workers;
+        job.nextTile = 0;
+
+#if defined(_WIN32)
+        InitializeCriticalSection(&job.lock);
+#else
+        pthread_mutex_init(&job.lock, 0);
+#endif
+        // The calling thread is worker zero.
+        int started = 1;
+        for (int i = 1; i < workerCount; i++)
+        {
+            nmgTileThread& thread = threads[i];
+            thread.job = &job;
+            thread.workerIndex = i;
+#if defined(_WIN32)
+            thread.handle = CreateThread(0, 0, nmgTileThreadMain, &thread, 0, 0);
+            if (!thread.handle)
+                break;
+#else
+            if (pthread_create(&thread.handle, 0, nmgTileThreadMain, &thread) != 0)
+                break;
+#endif
+            started++;
+        }
+
+        nmgRunTileWorker(&job, 0);
+
+        for (int i = 1; i < started; i++)
+        {
+#if defined(_WIN32)
+            WaitForSingleObject(threads[i].handle, INFINITE);
+            CloseHandle(threads[i].handle);
+#else
+            pthread_join(threads[i].handle, 0);
+#endif
+        }
+
+#if defined(_WIN32)
+        DeleteCriticalSection(&job.lock);
+#else
+        pthread_mutex_destroy(&job.lock);
+#endif
+        if (ctx)
+        {
+            for (int i = 0; i < started; i++)
+            {
+                for (int j = 0; j < RC_MAX_TIMERS; j++)
+                {
+                    ctx->recordScratchPeak((rcTimerLabel)j
+                        , workers[i].ctx->getScratchPeak((rcTimerLabel)j));
+                    ctx->recordWorkingSetPeak((rcTimerLabel)j
+                        , workers[i].ctx->getWorkingSetPeak((rcTimerLabel)j));
+                }
+                // Stage times are summed across workers.
+                ctx->addTimers(*workers[i].ctx);
+            }
+        }
+
+        if (ctx && logEnabled)
+        {
+            for (int i = 0; i < started; i++)
+            {
+                const nmgBuildContext* wctx = workers[i].ctx;
+                for (int j = 0; j < wctx->getMessageCount(); j++)
+                    ctx->log(RC_LOG_PROGRESS, "%s", wctx->getMessage(j));
+            }
+        }
+    }
+    else if (ctx)
+        ctx->log(RC_LOG_ERROR, "%s: Out of memory.", name);
+
+    if (workers)
+    {
+        for (int i = 0; i < workerCount; i++)
+        {
+            delete workers[i].ctx;
+            rcFree(workers[i].tris);
+            rcFree(workers[i].areas);
+        }
+    }
+
+
+    rcFree(workers);
+    rcFree(threads);
+
+    return ok;
+}
+
+// Builds the tiles from the triangles, once per walkable radius.
+static bool nmgBuildTileSet(nmgBuildContext* ctx
+    , const rcConfig* config
+    , const int contourFlags
+    , const unsigned char buildFlags
+    , const float* verts
+    , const int nverts
+    , const int* tris
+    , const unsigned char* areas
+    , const int ntris
+    , const nmgAreaMarker* markers
+    , const int markerCount
+    , const int* walkableRadii
+    , const int profileCount
+    , const int* tiles
+    , const int tileCount
+    , const int threadCount
+    , nmgTileCache* cache
+    , rcPolyMesh* polyMeshes
+    , nmgPolyMeshDetail* detailMeshes
+    , int* maxVerts
+    , unsigned char* results
+    , const char* name)
+{
+    const int outputCount = tileCount * profileCount;
+
+    memset(polyMeshes, 0, sizeof(rcPolyMesh) * outputCount);
+    memset(detailMeshes, 0, sizeof(nmgPolyMeshDetail) * outputCount);
+    memset(maxVerts, 0, sizeof(int) * outputCount);
+    memset(results, NMG_TILE_FAILED, sizeof(unsigned char) * outputCount);
+
+    // Zeroed so that the cache can compare configurations.
+    nmgTileBuildConfig tcfg;
+    memset(&tcfg, 0, sizeof(nmgTileBuildConfig));
+    tcfg.config = *config;
+    tcfg.contourFlags = contourFlags;
+    tcfg.buildFlags = buildFlags;
+
+    int* tileTriStart = 0;
+    int* tileTris = 0;
+    if (!nmgBuildTileLists(tcfg.config
+        , verts, tris, ntris, tiles, tileCount, &tileTriStart, &tileTris))
+    {
+        if (ctx)
+            ctx->log(RC_LOG_ERROR, "%s: Out of memory.", name);
+        return false;
+    }
+
+    bool ok = true;
+    if (cache && !nmgPrepareTileCache(*cache, tcfg))
+    {
+        if (ctx)
+            ctx->log(RC_LOG_ERROR, "%s: Out of memory.", name);
+        ok = false;
+    }
+
+    if (ok)
+    {
+        nmgTileBuildJob job;
+        job.cfg = &tcfg;
+        job.verts = verts;
+        job.nverts = nverts;
+        job.tris = tris;
+        job.areas = areas;
+        job.tileTriStart = tileTriStart;
+        job.tileTris = tileTris;
+        job.markers = markers;
+        job.markerCount = markerCount;
+        job.tiles = tiles;
+        job.tileCount = tileCount;
+        job.walkableRadii = walkableRadii;
+        job.profileCount = profileCount;
+        job.cache = cache;
+        job.rebuild = false;
+        job.keys = 0;
+        job.connections = 0;
+        job.salt = 0;
+        job.polyMeshes = polyMeshes;
+        job.detailMeshes = detailMeshes;
+        job.maxVerts = maxVerts;
+        job.results = results;
+
+        ok = nmgRunTileJob(ctx, job, threadCount, name);
+    }
+
+    rcFree(tileTriStart);
+    rcFree(tileTris);
+
+    return ok;
+}
+
+extern "C"
+{
+    EXPORT_API bool nmgBuildTiles(nmgBuildContext* ctx
+        , const rcConfig* config
+        , const int contourFlags
+        , const unsigned char buildFlags
+        , const float* verts
+        , const int nverts
+        , const int* tris
+        , const unsigned char* areas
+        , const int ntris
+        , const nmgAreaMarker* markers
+        , const int markerCount
+        , const int* tiles
+        , const int tileCount
+        , const int threadCount
+        , nmgTileCache* cache
+        , rcPolyMesh* polyMeshes
+        , nmgPolyMeshDetail* detailMeshes
+        , int* maxVerts
+        , unsigned char* results)
+    {
+        /*
+         * Design notes:
+         *
+         * Each tile runs the same steps as the managed incremental
+         * builder, minus the custom processors.  The output meshes are
+         * owned by the caller and are freed with rcpmFreeMeshData and
+         * rcpdFreeMeshData.
+         *
+         * The tile data step is left to the navigation library since it
+         * is cheap and this library does not link Detour.
+         *
+         * Worker logs are appended to the context after all tiles are done.
+         *
+         * If a cache is provided, each tile's compact heightfield is
+         * cached before the markers are applied so nmgRebuildTiles can
+         * rebuild the tile later.  The cache is cleared if the build
+         * settings change.
+         */
+
+        if (!config 
+            || !verts || !tris || !areas 
+            || (markerCount > 0 && !markers)
+            || !tiles || tileCount < 1
+            || (config->tileSize <= 0 && tileCount != 1)
+            || !polyMeshes || !detailMeshes || !maxVerts || !results)
+        {
+            return false;
+        }
+
+        return nmgBuildTileSet(ctx, config, contourFlags, buildFlags
+            , verts, nverts, tris, areas, ntris, markers, markerCount
+            , &config->walkableRadius, 1
+            , tiles, tileCount, threadCount, cache
+            , polyMeshes, detailMeshes, maxVerts, results
+            , "nmgBuildTiles");
+    }
+
+    EXPORT_API bool nmgBuildTileProfiles(nmgBuildContext* ctx
+        , const rcConfig* config
+        , const int contourFlags
+        , const unsigned char buildFlags
+        , const float* verts
+        , const int nverts
+        , const int* tris
+        , const unsigned char* areas
+        , const int ntris
+        , const nmgAreaMarker* markers
+        , const int markerCount
+        , const int* walkableRadii
+        , const int profileCount
+        , const int* tiles
+        , const int tileCount
+        , const int threadCount
+        , rcPolyMesh* polyMeshes
+        , nmgPolyMeshDetail* detailMeshes
+        , int* maxVerts
+        , unsigned char* results)
+    {
+        /*
+         * Design notes:
+         *
+         * Builds the tiles for several agent radii at once.  Only the
+         * erosion and the steps after it depend on the radius, so each
+         * tile is rasterized, filtered and compacted once, and the
+         * compact heightfield is cloned for each radius.
+         *
+         * The config's walkable radius is ignored.  Its border size is
+         * shared by all profiles, so it must suit the largest radius.
+         *
+         * The outputs are profile major.  The outputs of profile p
+         * start at index p * tileCount and are the same as for
+         * nmgBuildTiles with that radius.  [Size: tileCount * profileCount]
+         *
+         * There is no cache since a cache is rebuilt for one radius.
+         */
+
+        if (!config 
+            || !verts || !tris || !areas 
+            || (markerCount > 0 && !markers)
+            || !walkableRadii || profileCount < 1
+            || !tiles || tileCount < 1
+            || (config->tileSize <= 0 && tileCount != 1)
+            || !polyMeshes || !detailMeshes || !maxVerts || !results)
+        {
+            return false;
+        }
+
+        for (int i = 0; i < profileCount; i++)
+        {
+            if (walkableRadii[i] < 0)
+                return false;
+        }
+
+        return nmgBuildTileSet(ctx, config, contourFlags, buildFlags
+            , verts, nverts, tris, areas, ntris, markers, markerCount
+            , walkableRadii, profileCount
+            , tiles, tileCount, threadCount, 0
+            , polyMeshes, detailMeshes, maxVerts, results
+            , "nmgBuildTileProfiles");
+    }
+
+    EXPORT_API bool nmgHashTiles(nmgBuildContext* ctx
+        , const rcConfig* config
+        , const int contourFlags
+        , const unsigned char buildFlags
+        , const float* verts
+        , const int nverts
+        , const int* tris
+        , const unsigned char* areas
+        , const int ntris
+        , const nmgAreaMarker* markers
+        , const int markerCount
+        , const float* connVerts
+        , const float* connRadii
+        , const unsigned char* connDirs
+        , const unsigned char* connAreas
+        , const unsigned short* connFlags
+        , const unsigned int* connUserIds
+        , const int connCount
+        , const unsigned int salt
+        , const int* tiles
+        , const int tileCount
+        , const int threadCount
+        , nmgTileKey* keys)
+    {
+        /*
+         * Design notes:
+         *
+         * Gets a content key for each tile, for use with nmgStoreTileData
+         * and nmgLoadTileData.  The arguments are the same as for 
+         * nmgBuildTiles, plus the off-mesh connections of the tile data.
+         * A tile's key covers its triangles (with the border), the 
+         * markers and connections in its bounds, the full configuration 
+         * and the context's rasterize flags.
+         *
+         * The salt covers everything else that goes into the tile data, 
+         * such as the custom processors, polygon flags and the bounding
+         * volume setting.  Change it when any of those change.
+         *
+         * Tiles are hashed on the worker threads, the same as a build.
+         */
+
+        if (!config 
+            || !verts || !tris || !areas 
+            || (markerCount > 0 && !markers)
+            || (connCount > 0 && (!connVerts || !connRadii || !connDirs
+                || !connAreas || !connFlags || !connUserIds))
+            || !tiles || tileCount < 1
+            || (config->tileSize <= 0 && tileCount != 1)
+            || !keys)
+        {
+            return false;
+        }
+
+        memset(keys, 0, sizeof(nmgTileKey) * tileCount);
+
+        nmgTileBuildConfig tcfg;
+        memset(&tcfg, 0, sizeof(nmgTileBuildConfig));
+        tcfg.config = *config;
+        tcfg.contourFlags = contourFlags;
+        tcfg.buildFlags = buildFlags;
+
+        int* tileTriStart = 0;
+        int* tileTris = 0;
+        if (!nmgBuildTileLists(tcfg.config
+            , verts, tris, ntris, tiles, tileCount, &tileTriStart, &tileTris))
+        {
+            if (ctx)
+                ctx->log(RC_LOG_ERROR, "nmgHashTiles: Out of memory.");
+            return false;
+        }
+
+        nmgTileConnections conns;
+        conns.verts = connVerts;
+        conns.radii = connRadii;
+        conns.dirs = connDirs;
+        conns.areas = connAreas;
+        conns.flags = connFlags;
+        conns.userIds = connUserIds;
+        conns.count = rcMax(connCount, 0);
+
+        nmgTileBuildJob job;
+        memset(&job, 0, sizeof(nmgTileBuildJob));
+        job.cfg = &tcfg;
+        job.verts = verts;
+        job.nverts = nverts;
+        job.tris = tris;
+        job.areas = areas;
+        job.tileTriStart = tileTriStart;
+        job.tileTris = tileTris;
+        job.markers = markers;
+        job.markerCount = markerCount;
+        job.tiles = tiles;
+        job.tileCount = tileCount;
+        job.keys = keys;
+        job.connections = &conns;
+        job.salt = salt;
+
+        const bool ok = nmgRunTileJob(ctx, job, threadCount, "nmgHashTiles");
+
+        rcFree(tileTriStart);
+        rcFree(tileTris);
+
+        return ok;
+    }
+
+    EXPORT_API nmgTileCache* nmgAllocTileCache()
+    {
+        nmgTileCache* cache = (nmgTileCache*)rcAlloc(sizeof(nmgTileCache), RC_ALLOC_PERM);
+        if (cache)
+            memset(cache, 0, sizeof(nmgTileCache));
+        return cache;
+    }
+
+    EXPORT_API void nmgFreeTileCache(nmgTileCache* cache)
+    {
+        if (!cache)
+            return;
+
+        nmgClearTileCache(*cache);
+        rcFree(cache);
+    }
+
+    EXPORT_API int nmgGetDirtyTiles(nmgTileCache* cache
+        , const nmgAreaMarker* markers
+        , const int markerCount
+        , int* tiles
+        , const int maxTiles)
+    {
+        /*
+         * Pass both the old and the new state of the markers that
+         * changed.  Only tiles with a cached field are returned since
+         * no other tile can change.
+         *
+         * The tile bounds include the border, so a marker near a tile
+         * edge dirties the neighbor tiles as well.
+         *
+         * Returns the total number of dirty tiles, even if it is more
+         * than maxTiles.  Only the first maxTiles are loaded, so a
+         * result greater than maxTiles means the buffer was too small.
+         * (The tiles buffer may be null if maxTiles is zero.)
+         */
+
+        if (!cache || !cache->fields || !markers || (!tiles && maxTiles > 0))
+            return 0;
+
+        int count = 0;
+        for (int tz = 0; tz < cache->depth; tz++)
+        {
+            for (int tx = 0; tx < cache->width; tx++)
+            {
+                if (!cache->fields[tx + tz * cache->width])
+                    continue;
+
+                float tmin[3];
+                float tmax[3];
+                nmgGetTileBounds(cache->cfg.config, tx, tz, tmin, tmax);
+
+                bool dirty = false;
+                for (int i = 0; !dirty && i < markerCount; i++)
+                    dirty = nmgMarkerOverlaps(markers[i], tmin, tmax);
+
+                if (!dirty)
+                    continue;
+
+                if (count < maxTiles)
+                {
+                    tiles[count * 2 + 0] = tx;
+                    tiles[count * 2 + 1] = tz;
+                }
+                count++;
+            }
+        }
+
+        return count;
+    }
+
+    EXPORT_API bool nmgRebuildTiles(nmgBuildContext* ctx
+        , nmgTileCache* cache
+        , const nmgAreaMarker* markers
+        , const int markerCount
+        , const int* tiles
+        , const int tileCount
+        , const int threadCount
+        , rcPolyMesh* polyMeshes
+        , nmgPolyMeshDetail* detailMeshes
+        , int* maxVerts
+        , unsigned char* results)
+    {
+        /*
+         * Each tile is rebuilt from its cached field with the complete
+         * current marker set, starting from the area marking step.  The
+         * outputs are the same as for nmgBuildTiles.  The caller swaps
+         * the new tiles into the navigation mesh.
+         */
+
+        if (!cache || !cache->fields
+            || (markerCount > 0 && !markers)
+            || !tiles || tileCount < 1
+            || !polyMeshes || !detailMeshes || !maxVerts || !results)
+        {
+            return false;
+        }
+
+        memset(polyMeshes, 0, sizeof(rcPolyMesh) * tileCount);
+        memset(detailMeshes, 0, sizeof(nmgPolyMeshDetail) * tileCount);
+        memset(maxVerts, 0, sizeof(int) * tileCount);
+        memset(results, NMG_TILE_FAILED, sizeof(unsigned char) * tileCount);
+
+        nmgTileBuildJob job;
+        memset(&job, 0, sizeof(nmgTileBuildJob));
+        job.cfg = &cache->cfg;
+        job.markers = markers;
+        job.markerCount = markerCount;
+        job.tiles = tiles;
+        job.tileCount = tileCount;
+        job.walkableRadii = &cache->cfg.config.walkableRadius;
+        job.profileCount = 1;
+        job.cache = cache;
+        job.rebuild = true;
+        job.polyMeshes = polyMeshes;
+        job.detailMeshes = detailMeshes;
+        job.maxVerts = maxVerts;
+        job.results = results;
+
+        return nmgRunTileJob(ctx, job, threadCount, "nmgRebuildTiles");
+    }
+}
@@ -0,0 +1,331 @@
+/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "NMGen.h"
+#include "RecastAlloc.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+static const unsigned int C1 = 0x239b961b;
+static const unsigned int C2 = 0xab0e9789;
+static const unsigned int C3 = 0x38b34ae5;
+static const unsigned int C4 = 0xa1e38b93;
+
+inline unsigned int rotl(const unsigned int v, const int r)
+{
+    return (v << r) | (v >> (32 - r));
+}
+
+inline unsigned int fmix(unsigned int h)
+{
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+    return h;
+}
+
+// Reads up to four bytes as a little endian word.
+inline unsigned int getWord(const unsigned char* p, const int count)
+{
+    unsigned int k = 0;
+    for (int i = count - 1; i >= 0; i--)
+        k = (k << 8) | p[i];
+    return k;
+}
+
+// The per-lane key mixing.
+inline unsigned int mixK1(const unsigned int k) { return rotl(k * C1, 15) * C2; }
+inline unsigned int mixK2(const unsigned int k) { return rotl(k * C2, 16) * C3; }
+inline unsigned int mixK3(const unsigned int k) { return rotl(k * C3, 17) * C4; }
+inline unsigned int mixK4(const unsigned int k) { return rotl(k * C4, 18) * C1; }
+
+nmgContentHash::nmgContentHash(unsigned int seed)
+    : m_tailSize(0)
+    , m_size(0)
+{
+    for (int i = 0; i < 4; i++)
+        m_h[i] = seed;
+}
+
+void nmgContentHash::addBlock(const unsigned char* block)
+{
+    unsigned int* h = m_h;
+
+    h[0] ^= mixK1(getWord(block + 0, 4));
+    h[0] = rotl(h[0], 19) + h[1];
+    h[0] = h[0] * 5 + 0x561ccd1b;
+
+    h[1] ^= mixK2(getWord(block + 4, 4));
+    h[1] = rotl(h[1], 17) + h[2];
+    h[1] = h[1] * 5 + 0x0bcaa747;
+
+    h[2] ^= mixK3(getWord(block + 8, 4));
+    h[2] = rotl(h[2], 15) + h[3];
+    h[2] = h[2] * 5 + 0x96cd1c35;
+
+    h[3] ^= mixK4(getWord(block + 12, 4));
+    h[3] = rotl(h[3], 13) + h[0];
+    h[3] = h[3] * 5 + 0x32ac3b17;
+}
+
+void nmgContentHash::add(const void* data, int size)
+{
+    const unsigned char* p = (const unsigned char*)data;
+    m_size += (unsigned int)size;
+
+    if (m_tailSize > 0)
+    {
+        const int count = rcMin(size, 16 - m_tailSize);
+        memcpy(&m_tail[m_tailSize], p, count);
+        m_tailSize += count;
+        p += count;
+        size -= count;
+
+        if (m_tailSize < 16)
+            return;
+
+        addBlock(m_tail);
+        m_tailSize = 0;
+    }
+
+    for (; size >= 16; p += 16, size -= 16)
+        addBlock(p);
+
+    memcpy(m_tail, p, size);
+    m_tailSize = size;
+}
+
+void nmgContentHash::finish(nmgTileKey& key) const
+{
+    unsigned int h[4];
+    memcpy(h, m_h, sizeof(h));
+
+    // The tail covers the lanes in order.
+    const int n = m_tailSize;
+    if (n > 12)
+        h[3] ^= mixK4(getWord(m_tail + 12, n - 12));
+    if (n > 8)
+        h[2] ^= mixK3(getWord(m_tail + 8, rcMin(n - 8, 4)));
+    if (n > 4)
+        h[1] ^= mixK2(getWord(m_tail + 4, rcMin(n - 4, 4)));
+    if (n > 0)
+        h[0] ^= mixK1(getWord(m_tail, rcMin(n, 4)));
+
+    for (int i = 0; i < 4; i++)
+        h[i] ^= m_size;
+
+    h[0] += h[1] + h[2] + h[3];
+    h[1] += h[0];
+    h[2] += h[0];
+    h[3] += h[0];
+
+    for (int i = 0; i < 4; i++)
+        h[i] = fmix(h[i]);
+
+    h[0] += h[1] + h[2] + h[3];
+    h[1] += h[0];
+    h[2] += h[0];
+    h[3] += h[0];
+
+    memcpy(key.words, h, sizeof(h));
+}
+
+// Tile data files: A header followed by the data.  The data checksum 
+// guards against truncated or damaged files.
+static const int NMG_TILE_DATA_MAGIC = 'N'<<24 | 'M'<<16 | 'T'<<8 | 'D';
+static const int NMG_TILE_DATA_VERSION = 1;
+
+static const int NMG_MAX_PATH = 1024;
+
+struct nmgTileDataHeader
+{
+    int magic;
+    int version;
+    nmgTileKey key;
+    int dataSize;
+    nmgTileKey check;
+};
+
+// Gets the path of the key's file, with the suffix appended.
+static bool nmgGetTileDataPath(const char* directory
+    , const nmgTileKey& key
+    , const char* suffix
+    , char* path)
+{
+    const int n = snprintf(path, NMG_MAX_PATH, "%s/%08x%08x%08x%08x.tile%s"
+        , directory, key.words[0], key.words[1], key.words[2], key.words[3], suffix);
+    return n > 0 && n < NMG_MAX_PATH;
+}
+
+// A suffix that no other thread or process is using at the same time.
+static void nmgGetTempSuffix(char* suffix, const int size)
+{
+#if defined(_WIN32)
+    const unsigned int process = (unsigned int)GetCurrentProcessId();
+    const DWORD thread = GetCurrentThreadId();
+#else
+    const unsigned int process = (unsigned int)getpid();
+    const pthread_t thread = pthread_self();
+#endif
+    nmgContentHash hash;
+    hash.addValue(thread);
+    nmgTileKey key;
+    hash.finish(key);
+
+    snprintf(suffix, size, ".%x-%x.tmp", process, key.words[0]);
+}
+
+static void nmgGetDataCheck(const unsigned char* data
+    , const int dataSize
+    , nmgTileKey& check)
+{
+    nmgContentHash hash(NMG_TILE_DATA_VERSION);
+    hash.add(data, dataSize);
+    hash.finish(check);
+}
+
+extern "C"
+{
+    EXPORT_API bool nmgStoreTileData(const char* directory
+        , const nmgTileKey* key
+        , const unsigned char* data
+        , const int dataSize)
+    {
+        /*
+         * Design notes:
+         *
+         * The file is written under a temporary name and then renamed, so 
+         * a reader never sees a partial file, and bake servers sharing a
+         * directory can store the same key at the same time.  Equal keys
+         * have equal data, so it does not matter which writer wins.
+         */
+
+        if (!directory || !key || !data || dataSize <= 0)
+            return false;
+
+        char suffix[64];
+        nmgGetTempSuffix(suffix, sizeof(suffix));
+
+        char path[NMG_MAX_PATH];
+        char tempPath[NMG_MAX_PATH];
+        if (!nmgGetTileDataPath(directory, *key, "", path)
+            || !nmgGetTileDataPath(directory, *key, suffix, tempPath))
+        {
+            return false;
+        }
+
+        nmgTileDataHeader header;
+        memset(&header, 0, sizeof(header));
+        header.magic = NMG_TILE_DATA_MAGIC;
+        header.version = NMG_TILE_DATA_VERSION;
+        header.key = *key;
+        header.dataSize = dataSize;
+        nmgGetDataCheck(data, dataSize, header.check);
+
+        FILE* fp = fopen(tempPath, "wb");
+        if (!fp)
+            return false;
+
+        bool ok = fwrite(&header, sizeof(header), 1, fp) == 1
+            && fwrite(data, dataSize, 1, fp) == 1;
+        ok = (fclose(fp) == 0) && ok;
+
+#if defined(_WIN32)
+        ok = ok && MoveFileExA(tempPath, path, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+        ok = ok && rename(tempPath, path) == 0;
+#endif
+        if (!ok)
+            remove(tempPath);
+
+        return ok;
+    }
+
+    EXPORT_API bool nmgLoadTileData(const char* directory
+        , const nmgTileKey* key
+        , unsigned char** data
+        , int* dataSize)
+    {
+        /*
+         * A missing, damaged or foreign file is a miss.  The data is 
+         * freed with nmgFreeSerializationData.
+         */
+
+        if (!directory || !key || !data || !dataSize)
+            return false;
+
+        *data = 0;
+        *dataSize = 0;
+
+        char path[NMG_MAX_PATH];
+        if (!nmgGetTileDataPath(directory, *key, "", path))
+            return false;
+
+        FILE* fp = fopen(path, "rb");
+        if (!fp)
+            return false;
+
+        nmgTileDataHeader header;
+        unsigned char* result = 0;
+
+        bool ok = fread(&header, sizeof(header), 1, fp) == 1
+            && header.magic == NMG_TILE_DATA_MAGIC
+            && header.version == NMG_TILE_DATA_VERSION
+            && memcmp(&header.key, key, sizeof(nmgTileKey)) == 0
+            && header.dataSize > 0;
+
+        if (ok)
+        {
+            result = (unsigned char*)rcAlloc(header.dataSize, RC_ALLOC_PERM);
+            ok = result && fread(result, header.dataSize, 1, fp) == 1;
+        }
+
+        fclose(fp);
+
+        if (ok)
+        {
+            nmgTileKey check;
+            nmgGetDataCheck(result, header.dataSize, check);
+            ok = memcmp(&check, &header.check, sizeof(nmgTileKey)) == 0;
+        }
+
+        if (!ok)
+        {
+            rcFree(result);
+            return false;
+        }
+
+        *data = result;
+        *dataSize = header.dataSize;
+
+        return true;
+    }
+}
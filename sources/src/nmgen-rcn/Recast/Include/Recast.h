@@ -19,6 +19,8 @@
 #ifndef RECAST_H
 #define RECAST_H
 
+class rcTaskScheduler;
+
 /// The value of PI used by Recast.
 static const float RC_PI = 3.14159265f;
 
@@ -794,6 +796,16 @@ void rcAddSpan(rcContext* ctx, rcHeightfield& hf, const int x, const int y,
 			   const unsigned short smin, const unsigned short smax,
 			   const unsigned char area, const int flagMergeThr);
 
+/// Rasterization flags.
+/// @see rcRasterizeTriangle, rcRasterizeTriangles
+enum rcRasterizeFlags
+{
+	/// Finds the spans of each row in a single vectorized pass instead of 
+	/// clipping the row polygon column by column.  Faster, but span heights 
+	/// are not guaranteed to be bit-identical to the default path.
+	RC_RASTERIZE_FAST = 0x01,
+};
+
 /// Rasterizes a triangle into the specified heightfield.
 ///  @ingroup recast
 ///  @param[in,out]	ctx				The build context to use during the operation.
@@ -804,9 +816,10 @@ void rcAddSpan(rcContext* ctx, rcHeightfield& hf, const int x, const int y,
 ///  @param[in,out]	solid			An initialized heightfield.
 ///  @param[in]		flagMergeThr	The distance where the walkable flag is favored over the non-walkable flag.
 ///  								[Limit: >= 0] [Units: vx]
+///  @param[in]		flags			The rasterization flags. (See: #rcRasterizeFlags)
 void rcRasterizeTriangle(rcContext* ctx, const float* v0, const float* v1, const float* v2,
 						 const unsigned char area, rcHeightfield& solid,
-						 const int flagMergeThr = 1);
+						 const int flagMergeThr = 1, const int flags = 0);
 
 /// Rasterizes an indexed triangle mesh into the specified heightfield.
 ///  @ingroup recast
@@ -819,9 +832,10 @@ void rcRasterizeTriangle(rcContext* ctx, const float* v0, const float* v1, const
 ///  @param[in,out]	solid			An initialized heightfield.
 ///  @param[in]		flagMergeThr	The distance where the walkable flag is favored over the non-walkable flag. 
 ///  								[Limit: >= 0] [Units: vx]
+///  @param[in]		flags			The rasterization flags. (See: #rcRasterizeFlags)
 void rcRasterizeTriangles(rcContext* ctx, const float* verts, const int nv,
 						  const int* tris, const unsigned char* areas, const int nt,
-						  rcHeightfield& solid, const int flagMergeThr = 1);
+						  rcHeightfield& solid, const int flagMergeThr = 1, const int flags = 0);
 
 /// Rasterizes an indexed triangle mesh into the specified heightfield.
 ///  @ingroup recast
@@ -834,9 +848,47 @@ void rcRasterizeTriangles(rcContext* ctx, const float* verts, const int nv,
 ///  @param[in,out]	solid		An initialized heightfield.
 ///  @param[in]		flagMergeThr	The distance where the walkable flag is favored over the non-walkable flag. 
 ///  							[Limit: >= 0] [Units: vx]
+///  @param[in]		flags			The rasterization flags. (See: #rcRasterizeFlags)
 void rcRasterizeTriangles(rcContext* ctx, const float* verts, const int nv,
 						  const unsigned short* tris, const unsigned char* areas, const int nt,
-						  rcHeightfield& solid, const int flagMergeThr = 1);
+						  rcHeightfield& solid, const int flagMergeThr = 1, const int flags = 0);
+
+/// Rasterizes an indexed triangle mesh into the specified heightfield, in parallel.
+///  @ingroup recast
+///  @param[in,out]	ctx				The build context to use during the operation.
+///  @param[in]		verts			The vertices. [(x, y, z) * @p nv]
+///  @param[in]		nv				The number of vertices.
+///  @param[in]		tris			The triangle indices. [(vertA, vertB, vertC) * @p nt]
+///  @param[in]		areas			The area id's of the triangles. [Limit: <= #RC_WALKABLE_AREA] [Size: @p nt]
+///  @param[in]		nt				The number of triangles.
+///  @param[in,out]	solid			An initialized heightfield.
+///  @param[in]		scheduler		The scheduler to run the rasterization on. (Serial if null.)
+///  @param[in]		flagMergeThr	The distance where the walkable flag is favored over the non-walkable flag. 
+///  								[Limit: >= 0] [Units: vx]
+///  @param[in]		flags			The rasterization flags. (See: #rcRasterizeFlags)
+///  @returns True if the operation completed successfully.
+bool rcRasterizeTrianglesParallel(rcContext* ctx, const float* verts, const int nv,
+								  const int* tris, const unsigned char* areas, const int nt,
+								  rcHeightfield& solid, rcTaskScheduler* scheduler,
+								  const int flagMergeThr = 1, const int flags = 0);
+
+/// Rasterizes the part of an indexed triangle mesh that covers a range of heightfield rows.
+///  @ingroup recast
+///  @param[in]		verts			The vertices. [(x, y, z) * @p nv]
+///  @param[in]		nv				The number of vertices.
+///  @param[in]		tris			The triangle indices. [(vertA, vertB, vertC) * @p nt]
+///  @param[in]		areas			The area id's of the triangles. [Limit: <= #RC_WALKABLE_AREA] [Size: @p nt]
+///  @param[in]		nt				The number of triangles.
+///  @param[in,out]	solid			An initialized heightfield.
+///  @param[in]		rowMin			The first row to rasterize. [Limit: >= 0]
+///  @param[in]		rowMax			The last row to rasterize. [Limit: < rcHeightfield::height]
+///  @param[in]		flagMergeThr	The distance where the walkable flag is favored over the non-walkable flag. 
+///  								[Limit: >= 0] [Units: vx]
+///  @param[in]		flags			The rasterization flags. (See: #rcRasterizeFlags)
+void rcRasterizeTrianglesInRows(const float* verts, const int nv,
+								const int* tris, const unsigned char* areas, const int nt,
+								rcHeightfield& solid, const int rowMin, const int rowMax,
+								const int flagMergeThr = 1, const int flags = 0);
 
 /// Rasterizes triangles into the specified heightfield.
 ///  @ingroup recast
@@ -847,8 +899,9 @@ void rcRasterizeTriangles(rcContext* ctx, const float* verts, const int nv,
 ///  @param[in,out]	solid			An initialized heightfield.
 ///  @param[in]		flagMergeThr	The distance where the walkable flag is favored over the non-walkable flag. 
 ///  								[Limit: >= 0] [Units: vx]
+///  @param[in]		flags			The rasterization flags. (See: #rcRasterizeFlags)
 void rcRasterizeTriangles(rcContext* ctx, const float* verts, const unsigned char* areas, const int nt,
-						  rcHeightfield& solid, const int flagMergeThr = 1);
+						  rcHeightfield& solid, const int flagMergeThr = 1, const int flags = 0);
 
 /// Marks non-walkable spans as walkable if their maximum is within @p walkableClimp of a walkable neihbor. 
 ///  @ingroup recast
@@ -907,15 +960,19 @@ bool rcBuildCompactHeightfield(rcContext* ctx, const int walkableHeight, const i
 ///  @param[in,out]	ctx		The build context to use during the operation.
 ///  @param[in]		radius	The radius of erosion. [Limits: 0 < value < 255] [Units: vx]
 ///  @param[in,out]	chf		The populated compact heightfield to erode.
+///  @param[in]		scheduler	The scheduler used to run the filter in parallel. (Optional)
 ///  @returns True if the operation completed successfully.
-bool rcErodeWalkableArea(rcContext* ctx, int radius, rcCompactHeightfield& chf);
+bool rcErodeWalkableArea(rcContext* ctx, int radius, rcCompactHeightfield& chf,
+						 rcTaskScheduler* scheduler = 0);
 
 /// Applies a median filter to walkable area types (based on area id), removing noise.
 ///  @ingroup recast
 ///  @param[in,out]	ctx		The build context to use during the operation.
 ///  @param[in,out]	chf		A populated compact heightfield.
+///  @param[in]		scheduler	The scheduler used to run the filter in parallel. (Optional)
 ///  @returns True if the operation completed successfully.
-bool rcMedianFilterWalkableArea(rcContext* ctx, rcCompactHeightfield& chf);
+bool rcMedianFilterWalkableArea(rcContext* ctx, rcCompactHeightfield& chf,
+								rcTaskScheduler* scheduler = 0);
 
 /// Applies an area id to all spans within the specified bounding box. (AABB) 
 ///  @ingroup recast
@@ -966,8 +1023,10 @@ void rcMarkCylinderArea(rcContext* ctx, const float* pos,
 ///  @ingroup recast
 ///  @param[in,out]	ctx		The build context to use during the operation.
 ///  @param[in,out]	chf		A populated compact heightfield.
+///  @param[in]		scheduler	The scheduler used to run the build in parallel. (Optional)
 ///  @returns True if the operation completed successfully.
-bool rcBuildDistanceField(rcContext* ctx, rcCompactHeightfield& chf);
+bool rcBuildDistanceField(rcContext* ctx, rcCompactHeightfield& chf,
+						  rcTaskScheduler* scheduler = 0);
 
 /// Builds region data for the heightfield using watershed partitioning.
 ///  @ingroup recast
@@ -979,9 +1038,11 @@ bool rcBuildDistanceField(rcContext* ctx, rcCompactHeightfield& chf);
 ///  								[Limit: >=0] [Units: vx].
 ///  @param[in]		mergeRegionArea		Any regions with a span count smaller than this value will, if possible,
 ///  								be merged with larger regions. [Limit: >=0] [Units: vx] 
+///  @param[in]		scheduler		The scheduler used to run the region expansion in parallel. (Optional)
 ///  @returns True if the operation completed successfully.
 bool rcBuildRegions(rcContext* ctx, rcCompactHeightfield& chf,
-					const int borderSize, const int minRegionArea, const int mergeRegionArea);
+					const int borderSize, const int minRegionArea, const int mergeRegionArea,
+					rcTaskScheduler* scheduler = 0);
 
 /// Builds region data for the heightfield by partitioning the heightfield in non-overlapping layers.
 ///  @ingroup recast
@@ -1080,10 +1141,12 @@ bool rcBuildHeightfieldLayers(rcContext* ctx, rcCompactHeightfield& chf,
 ///  							[Limit: >=0] [Units: vx]
 ///  @param[out]	cset		The resulting contour set. (Must be pre-allocated.)
 ///  @param[in]		buildFlags	The build flags. (See: #rcBuildContoursFlags)
+///  @param[in]		scheduler	The scheduler used to trace the region contours in parallel. (Optional)
 ///  @returns True if the operation completed successfully.
 bool rcBuildContours(rcContext* ctx, rcCompactHeightfield& chf,
 					 const float maxError, const int maxEdgeLen,
-					 rcContourSet& cset, const int buildFlags = RC_CONTOUR_TESS_WALL_EDGES);
+					 rcContourSet& cset, const int buildFlags = RC_CONTOUR_TESS_WALL_EDGES,
+					 rcTaskScheduler* scheduler = 0);
 
 /// Builds a polygon mesh from the provided contours.
 ///  @ingroup recast
@@ -1101,8 +1164,10 @@ bool rcBuildPolyMesh(rcContext* ctx, rcContourSet& cset, const int nvp, rcPolyMe
 ///  @param[in]		meshes	An array of polygon meshes to merge. [Size: @p nmeshes]
 ///  @param[in]		nmeshes	The number of polygon meshes in the meshes array.
 ///  @param[in]		mesh	The resulting polygon mesh. (Must be pre-allocated.)
+///  @param[in]		scheduler	The scheduler used to merge the meshes in parallel. (Optional)
 ///  @returns True if the operation completed successfully.
-bool rcMergePolyMeshes(rcContext* ctx, rcPolyMesh** meshes, const int nmeshes, rcPolyMesh& mesh);
+bool rcMergePolyMeshes(rcContext* ctx, rcPolyMesh** meshes, const int nmeshes, rcPolyMesh& mesh,
+					   rcTaskScheduler* scheduler = 0);
 
 /// Builds a detail mesh from the provided polygon mesh.
 ///  @ingroup recast
@@ -1113,10 +1178,11 @@ bool rcMergePolyMeshes(rcContext* ctx, rcPolyMesh** meshes, const int nmeshes, r
 ///  @param[in]		sampleMaxError	The maximum distance the detail mesh surface should deviate from 
 ///  								heightfield data. [Limit: >=0] [Units: wu]
 ///  @param[out]	dmesh			The resulting detail mesh.  (Must be pre-allocated.)
+///  @param[in]		scheduler		The scheduler used to build the polygon detail in parallel. (Optional)
 ///  @returns True if the operation completed successfully.
 bool rcBuildPolyMeshDetail(rcContext* ctx, const rcPolyMesh& mesh, const rcCompactHeightfield& chf,
 						   const float sampleDist, const float sampleMaxError,
-						   rcPolyMeshDetail& dmesh);
+						   rcPolyMeshDetail& dmesh, rcTaskScheduler* scheduler = 0);
 
 /// Copies the poly mesh data from src to dst.
 ///  @ingroup recast
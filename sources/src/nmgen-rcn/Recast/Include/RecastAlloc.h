@@ -27,6 +27,30 @@ enum rcAllocHint
 	RC_ALLOC_TEMP		///< Memory used temporarily within a function.
 };
 
+/// Identifies the build stage that owns an allocation.  Used for memory accounting.
+/// @see rcGetAllocStats
+enum rcAllocTag
+{
+	RC_ALLOC_TAG_GENERAL,				///< Untagged memory.
+	RC_ALLOC_TAG_HEIGHTFIELD,			///< Heightfields and their span pools.
+	RC_ALLOC_TAG_COMPACT_HEIGHTFIELD,	///< Compact heightfields.
+	RC_ALLOC_TAG_LAYERS,				///< Heightfield layer sets.
+	RC_ALLOC_TAG_CONTOURS,				///< Contour sets.
+	RC_ALLOC_TAG_POLYMESH,				///< Polygon meshes.
+	RC_ALLOC_TAG_POLYMESH_DETAIL,		///< Detail meshes.
+	RC_MAX_ALLOC_TAGS					///< The number of tags.
+};
+
+/// The memory accounting of a tag.
+/// @see rcGetAllocStats
+struct rcAllocStats
+{
+	int liveBytes;		///< The bytes currently allocated.
+	int peakBytes;		///< The most bytes that were allocated at one time.
+	int liveBlocks;		///< The number of blocks currently allocated.
+	int totalBlocks;	///< The number of blocks allocated since startup.
+};
+
 /// A memory allocation function.
 //  @param[in]		size			The size, in bytes of memory, to allocate.
 //  @param[in]		rcAllocHint	A hint to the allocator on how long the memory is expected to be in use.
@@ -51,11 +75,24 @@ void rcAllocSetCustom(rcAllocFunc *allocFunc, rcFreeFunc *freeFunc);
 /// @see rcFree
 void* rcAlloc(int size, rcAllocHint hint);
 
+/// Allocates a memory block owned by a build stage.
+///  @param[in]		size	The size, in bytes of memory, to allocate.
+///  @param[in]		hint	A hint to the allocator on how long the memory is expected to be in use.
+///  @param[in]		tag		The build stage the memory is accounted to.
+///  @return A pointer to the beginning of the allocated memory block, or null if the allocation failed.
+/// @see rcFree, rcGetAllocStats
+void* rcAlloc(int size, rcAllocHint hint, rcAllocTag tag);
+
 /// Deallocates a memory block.
 ///  @param[in]		ptr		A pointer to a memory block previously allocated using #rcAlloc.
 /// @see rcAlloc
 void rcFree(void* ptr);
 
+/// Gets the memory accounting of a build stage.
+///  @param[in]		tag		The build stage.
+///  @param[out]	stats	The accounting of the build stage.
+void rcGetAllocStats(rcAllocTag tag, rcAllocStats* stats);
+
 
 /// A simple dynamic array of integers.
 class rcIntArray
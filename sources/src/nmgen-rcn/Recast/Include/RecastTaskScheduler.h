@@ -0,0 +1,52 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifndef RECASTTASKSCHEDULER_H
+#define RECASTTASKSCHEDULER_H
+
+/// A task run by a #rcTaskScheduler.
+///  @param[in]		userData	The user data passed to #rcTaskScheduler::parallelFor.
+///  @param[in]		taskIndex	The index of the task. [Limits: 0 <= value < taskCount]
+///  @param[in]		workerIndex	The index of the worker running the task. 
+///								[Limits: 0 <= value < #rcTaskScheduler::getWorkerCount()]
+typedef void (*rcTaskFunc)(void* userData, int taskIndex, int workerIndex);
+
+/// Provides parallel execution to the Recast build steps that support it.
+///
+/// Recast does not create threads.  The application implements this
+/// interface on top of its own job system or thread pool.
+///
+/// @note No two tasks running at the same time may share a worker index.
+class rcTaskScheduler
+{
+public:
+	virtual ~rcTaskScheduler() {}
+
+	/// The number of workers.  (The maximum number of tasks that can run
+	/// at the same time.)
+	virtual int getWorkerCount() const = 0;
+
+	/// Runs the function for every task index in [0, taskCount), then 
+	/// returns once all tasks have completed.
+	///  @param[in]		func		The task function.
+	///  @param[in]		userData	The user data to pass to the function.
+	///  @param[in]		taskCount	The number of tasks.
+	virtual void parallelFor(rcTaskFunc func, void* userData, int taskCount) = 0;
+};
+
+#endif // RECASTTASKSCHEDULER_H
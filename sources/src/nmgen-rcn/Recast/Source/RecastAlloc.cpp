@@ -20,6 +20,11 @@
 #include <string.h>
 #include "RecastAlloc.h"
 
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
 static void *rcAllocDefault(int size, rcAllocHint)
 {
 	return malloc(size);
@@ -33,6 +38,54 @@ static void rcFreeDefault(void *ptr)
 static rcAllocFunc* sRecastAllocFunc = rcAllocDefault;
 static rcFreeFunc* sRecastFreeFunc = rcFreeDefault;
 
+// Prefixed to each block for the accounting.  Sized so the block keeps the 
+// alignment of the base allocator.
+union rcAllocHeader
+{
+	struct
+	{
+		int size;
+		int tag;
+	} info;
+	double align[2];
+};
+
+struct rcAllocCounters
+{
+	volatile long liveBytes;
+	volatile long peakBytes;
+	volatile long liveBlocks;
+	volatile long totalBlocks;
+};
+
+static rcAllocCounters sRecastCounters[RC_MAX_ALLOC_TAGS];
+
+// Adds the delta and returns the new value.
+static long atomicAdd(volatile long* value, long delta)
+{
+#if defined(_WIN32)
+	return InterlockedExchangeAdd(value, delta) + delta;
+#else
+	return __sync_add_and_fetch(value, delta);
+#endif
+}
+
+static void atomicMax(volatile long* value, long v)
+{
+	long current = *value;
+	while (current < v)
+	{
+#if defined(_WIN32)
+		const long prev = InterlockedCompareExchange(value, v, current);
+#else
+		const long prev = __sync_val_compare_and_swap(value, current, v);
+#endif
+		if (prev == current)
+			break;
+		current = prev;
+	}
+}
+
 /// @see rcAlloc, rcFree
 void rcAllocSetCustom(rcAllocFunc *allocFunc, rcFreeFunc *freeFunc)
 {
@@ -43,7 +96,31 @@ void rcAllocSetCustom(rcAllocFunc *allocFunc, rcFreeFunc *freeFunc)
 /// @see rcAllocSetCustom
 void* rcAlloc(int size, rcAllocHint hint)
 {
-	return sRecastAllocFunc(size, hint);
+	return rcAlloc(size, hint, RC_ALLOC_TAG_GENERAL);
+}
+
+/// @par
+///
+/// Each block carries a small header that records its size and tag, so the 
+/// custom allocation function receives slightly larger requests than the 
+/// caller made.
+///
+/// @see rcAllocSetCustom, rcGetAllocStats
+void* rcAlloc(int size, rcAllocHint hint, rcAllocTag tag)
+{
+	rcAllocHeader* header = (rcAllocHeader*)sRecastAllocFunc((int)sizeof(rcAllocHeader) + size, hint);
+	if (!header)
+		return 0;
+
+	header->info.size = size;
+	header->info.tag = (int)tag;
+
+	rcAllocCounters& counters = sRecastCounters[tag];
+	atomicMax(&counters.peakBytes, atomicAdd(&counters.liveBytes, size));
+	atomicAdd(&counters.liveBlocks, 1);
+	atomicAdd(&counters.totalBlocks, 1);
+
+	return header + 1;
 }
 
 /// @par
@@ -54,8 +131,32 @@ void* rcAlloc(int size, rcAllocHint hint)
 /// @see rcAllocSetCustom
 void rcFree(void* ptr)
 {
-	if (ptr)
-		sRecastFreeFunc(ptr);
+	if (!ptr)
+		return;
+
+	rcAllocHeader* header = (rcAllocHeader*)ptr - 1;
+
+	rcAllocCounters& counters = sRecastCounters[header->info.tag];
+	atomicAdd(&counters.liveBytes, -header->info.size);
+	atomicAdd(&counters.liveBlocks, -1);
+
+	sRecastFreeFunc(header);
+}
+
+/// @par
+///
+/// The counters are updated atomically, but the values are read separately, 
+/// so they can be slightly out of step while other threads allocate.
+void rcGetAllocStats(rcAllocTag tag, rcAllocStats* stats)
+{
+	if (!stats)
+		return;
+
+	const rcAllocCounters& counters = sRecastCounters[tag];
+	stats->liveBytes = (int)counters.liveBytes;
+	stats->peakBytes = (int)counters.peakBytes;
+	stats->liveBlocks = (int)counters.liveBlocks;
+	stats->totalBlocks = (int)counters.totalBlocks;
 }
 
 /// @class rcIntArray
@@ -25,36 +25,323 @@
 #include "Recast.h"
 #include "RecastAlloc.h"
 #include "RecastAssert.h"
+#include "RecastTaskScheduler.h"
 
-/// @par 
-/// 
-/// Basically, any spans that are closer to a boundary or obstruction than the specified radius 
-/// are marked as unwalkable.
-///
-/// This method is usually called immediately after the heightfield has been built.
-///
-/// @see rcCompactHeightfield, rcBuildCompactHeightfield, rcConfig::walkableRadius
-bool rcErodeWalkableArea(rcContext* ctx, int radius, rcCompactHeightfield& chf)
+// Define RC_DISABLE_SIMD to build the dense area filters without intrinsics.
+#if !defined(RC_DISABLE_SIMD)
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RC_AREA_SSE2
+#define RC_AREA_VEC_WIDTH 16
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RC_AREA_NEON
+#define RC_AREA_VEC_WIDTH 16
+#endif
+#endif
+
+// Byte lane operations.  The scalar versions work on one cell with the 
+// same semantics, so each filter kernel is written once for both.
+// Masks are 0xff where true and 0 where false.  vecTest() checks a single bit.
+
+inline unsigned char vecMin(const unsigned char a, const unsigned char b) { return a < b ? a : b; }
+inline unsigned char vecMax(const unsigned char a, const unsigned char b) { return a > b ? a : b; }
+inline unsigned char vecAdds(const unsigned char a, const unsigned char b) { return (unsigned char)rcMin((int)a + (int)b, 255); }
+inline unsigned char vecAnd(const unsigned char a, const unsigned char b) { return a & b; }
+inline unsigned char vecEq(const unsigned char a, const unsigned char b) { return a == b ? 0xff : 0; }
+inline unsigned char vecTest(const unsigned char a, const unsigned char bit) { return (a & bit) ? 0xff : 0; }
+inline unsigned char vecSelect(const unsigned char mask, const unsigned char a, const unsigned char b) { return (unsigned char)((mask & a) | (~mask & b)); }
+inline void vecStore(unsigned char* p, const unsigned char v) { *p = v; }
+
+template<class V> inline V vecLoad(const unsigned char* p);
+template<class V> inline V vecSet(const unsigned char v);
+template<> inline unsigned char vecLoad<unsigned char>(const unsigned char* p) { return *p; }
+template<> inline unsigned char vecSet<unsigned char>(const unsigned char v) { return v; }
+
+#if defined(RC_AREA_SSE2)
+typedef __m128i rcAreaVec;
+inline rcAreaVec vecMin(const rcAreaVec a, const rcAreaVec b) { return _mm_min_epu8(a, b); }
+inline rcAreaVec vecMax(const rcAreaVec a, const rcAreaVec b) { return _mm_max_epu8(a, b); }
+inline rcAreaVec vecAdds(const rcAreaVec a, const rcAreaVec b) { return _mm_adds_epu8(a, b); }
+inline rcAreaVec vecAnd(const rcAreaVec a, const rcAreaVec b) { return _mm_and_si128(a, b); }
+inline rcAreaVec vecEq(const rcAreaVec a, const rcAreaVec b) { return _mm_cmpeq_epi8(a, b); }
+inline rcAreaVec vecTest(const rcAreaVec a, const rcAreaVec bit) { return _mm_cmpeq_epi8(_mm_and_si128(a, bit), bit); }
+inline rcAreaVec vecSelect(const rcAreaVec mask, const rcAreaVec a, const rcAreaVec b) { return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); }
+inline void vecStore(unsigned char* p, const rcAreaVec v) { _mm_storeu_si128((__m128i*)p, v); }
+template<> inline rcAreaVec vecLoad<rcAreaVec>(const unsigned char* p) { return _mm_loadu_si128((const __m128i*)p); }
+template<> inline rcAreaVec vecSet<rcAreaVec>(const unsigned char v) { return _mm_set1_epi8((char)v); }
+#elif defined(RC_AREA_NEON)
+typedef uint8x16_t rcAreaVec;
+inline rcAreaVec vecMin(const rcAreaVec a, const rcAreaVec b) { return vminq_u8(a, b); }
+inline rcAreaVec vecMax(const rcAreaVec a, const rcAreaVec b) { return vmaxq_u8(a, b); }
+inline rcAreaVec vecAdds(const rcAreaVec a, const rcAreaVec b) { return vqaddq_u8(a, b); }
+inline rcAreaVec vecAnd(const rcAreaVec a, const rcAreaVec b) { return vandq_u8(a, b); }
+inline rcAreaVec vecEq(const rcAreaVec a, const rcAreaVec b) { return vceqq_u8(a, b); }
+inline rcAreaVec vecTest(const rcAreaVec a, const rcAreaVec bit) { return vtstq_u8(a, bit); }
+inline rcAreaVec vecSelect(const rcAreaVec mask, const rcAreaVec a, const rcAreaVec b) { return vbslq_u8(mask, a, b); }
+inline void vecStore(unsigned char* p, const rcAreaVec v) { vst1q_u8(p, v); }
+template<> inline rcAreaVec vecLoad<rcAreaVec>(const unsigned char* p) { return vld1q_u8(p); }
+template<> inline rcAreaVec vecSet<rcAreaVec>(const unsigned char v) { return vdupq_n_u8(v); }
+#endif
+
+// Runs a kernel over n cells starting at grid index i.
+template<class Kernel>
+static void runKernel(const Kernel& kernel, int i, const int n)
 {
-	rcAssert(ctx);
+	const int end = i + n;
+#if defined(RC_AREA_VEC_WIDTH)
+	for (; i + RC_AREA_VEC_WIDTH <= end; i += RC_AREA_VEC_WIDTH)
+		kernel.template run<rcAreaVec>(i);
+#endif
+	for (; i < end; ++i)
+		kernel.template run<unsigned char>(i);
+}
+
+// With SIMD, the filters run on a dense copy of the field when every connection
+// stays on the same layer.  (The layer of a span is its index in its column.)
+// Each layer is then a plain grid, and is padded by one cell on every side 
+// so the neighbours of every cell are in range.  Other fields use the 
+// spans directly.
+static const int RC_AREA_GRID_MAX_LAYERS = 4;
+
+struct rcAreaGrid
+{
+	int width;				// The padded width.
+	int layerSize;			// The padded cell count of a layer.
+	int layerCount;
+	unsigned char* cons;	// The connected directions of each cell. (1 << dir)
+	unsigned char* src;
+	unsigned char* dst;
+};
+
+inline int getGridIndex(const rcAreaGrid& grid, const int x, const int y, const int layer)
+{
+	return layer*grid.layerSize + (x+1) + (y+1)*grid.width;
+}
+
+// Builds the dense grid, with the span areas in 'src'.  Returns false, 
+// with nothing allocated, if the field is not suitable.
+static bool initAreaGrid(const rcCompactHeightfield& chf, rcAreaGrid& grid)
+{
+	memset(&grid, 0, sizeof(grid));
 	
+#if !defined(RC_AREA_VEC_WIDTH)
+	// The dense filters are only faster with SIMD.
+	rcIgnoreUnused(chf);
+	return false;
+#else
 	const int w = chf.width;
 	const int h = chf.height;
 	
-	ctx->startTimer(RC_TIMER_ERODE_AREA);
+	int layerCount = 0;
+	for (int i = 0; i < w*h; ++i)
+		layerCount = rcMax(layerCount, (int)chf.cells[i].count);
+	if (layerCount == 0 || layerCount > RC_AREA_GRID_MAX_LAYERS)
+		return false;
 	
-	unsigned char* dist = (unsigned char*)rcAlloc(sizeof(unsigned char)*chf.spanCount, RC_ALLOC_TEMP);
-	if (!dist)
+	for (int i = 0; i < w*h; ++i)
 	{
-		ctx->log(RC_LOG_ERROR, "erodeWalkableArea: Out of memory 'dist' (%d).", chf.spanCount);
-		return false;
+		const rcCompactCell& c = chf.cells[i];
+		for (int k = 0; k < (int)c.count; ++k)
+		{
+			const rcCompactSpan& s = chf.spans[(int)c.index + k];
+			for (int dir = 0; dir < 4; ++dir)
+			{
+				const int con = rcGetCon(s, dir);
+				if (con != RC_NOT_CONNECTED && con != k)
+					return false;
+			}
+		}
 	}
 	
-	// Init distance.
-	memset(dist, 0xff, sizeof(unsigned char)*chf.spanCount);
+	grid.width = w+2;
+	grid.layerSize = (w+2)*(h+2);
+	grid.layerCount = layerCount;
+	
+	const int size = grid.layerSize*layerCount;
+	grid.cons = (unsigned char*)rcAlloc(sizeof(unsigned char)*size*3, RC_ALLOC_TEMP);
+	if (!grid.cons)
+		return false;
+	grid.src = grid.cons + size;
+	grid.dst = grid.src + size;
+	memset(grid.cons, 0, sizeof(unsigned char)*size*3);
 	
-	// Mark boundary cells.
 	for (int y = 0; y < h; ++y)
+	{
+		for (int x = 0; x < w; ++x)
+		{
+			const rcCompactCell& c = chf.cells[x+y*w];
+			for (int k = 0; k < (int)c.count; ++k)
+			{
+				const int i = (int)c.index + k;
+				const rcCompactSpan& s = chf.spans[i];
+				unsigned char cons = 0;
+				for (int dir = 0; dir < 4; ++dir)
+				{
+					if (rcGetCon(s, dir) != RC_NOT_CONNECTED)
+						cons |= (unsigned char)(1 << dir);
+				}
+				const int gi = getGridIndex(grid, x, y, k);
+				grid.cons[gi] = cons;
+				grid.src[gi] = chf.areas[i];
+			}
+		}
+	}
+	
+	return true;
+#endif
+}
+
+// Zero for the spans that are unwalkable or next to an unwalkable or 
+// missing span, the maximum for all others.
+struct rcErodeBoundaryKernel
+{
+	const unsigned char* cons;
+	const unsigned char* areas;
+	unsigned char* dist;
+	int stride;
+	
+	template<class V> void run(const int i) const
+	{
+		V a = vecLoad<V>(areas+i);
+		a = vecMin(a, vecLoad<V>(areas+i-1));
+		a = vecMin(a, vecLoad<V>(areas+i+1));
+		a = vecMin(a, vecLoad<V>(areas+i-stride));
+		a = vecMin(a, vecLoad<V>(areas+i+stride));
+		const V connected = vecEq(vecLoad<V>(cons+i), vecSet<V>(0xf));
+		vecStore(dist+i, vecSelect(vecEq(a, vecSet<V>(RC_NULL_AREA)), vecSet<V>(0), connected));
+	}
+};
+
+// The part of the first distance pass that depends on the row above:
+// (0,-1), (1,-1) and (-1,-1).
+struct rcErodePass1Kernel
+{
+	const unsigned char* cons;
+	unsigned char* dist;
+	int stride;
+	
+	template<class V> void run(const int i) const
+	{
+		const V none = vecSet<V>(0xff);
+		const V two = vecSet<V>(2);
+		const V three = vecSet<V>(3);
+		const V c = vecLoad<V>(cons+i);
+		const V up = vecTest(c, vecSet<V>(1 << 3));
+		const V upRight = vecAnd(up, vecTest(vecLoad<V>(cons+i-stride), vecSet<V>(1 << 2)));
+		const V upLeft = vecAnd(vecTest(c, vecSet<V>(1 << 0)), vecTest(vecLoad<V>(cons+i-1), vecSet<V>(1 << 3)));
+		
+		V d = vecLoad<V>(dist+i);
+		d = vecMin(d, vecSelect(up, vecAdds(vecLoad<V>(dist+i-stride), two), none));
+		d = vecMin(d, vecSelect(upRight, vecAdds(vecLoad<V>(dist+i-stride+1), three), none));
+		d = vecMin(d, vecSelect(upLeft, vecAdds(vecLoad<V>(dist+i-stride-1), three), none));
+		vecStore(dist+i, d);
+	}
+};
+
+// The part of the second distance pass that depends on the row below:
+// (0,1), (-1,1) and (1,1).
+struct rcErodePass2Kernel
+{
+	const unsigned char* cons;
+	unsigned char* dist;
+	int stride;
+	
+	template<class V> void run(const int i) const
+	{
+		const V none = vecSet<V>(0xff);
+		const V two = vecSet<V>(2);
+		const V three = vecSet<V>(3);
+		const V c = vecLoad<V>(cons+i);
+		const V down = vecTest(c, vecSet<V>(1 << 1));
+		const V downLeft = vecAnd(down, vecTest(vecLoad<V>(cons+i+stride), vecSet<V>(1 << 0)));
+		const V downRight = vecAnd(vecTest(c, vecSet<V>(1 << 2)), vecTest(vecLoad<V>(cons+i+1), vecSet<V>(1 << 1)));
+		
+		V d = vecLoad<V>(dist+i);
+		d = vecMin(d, vecSelect(down, vecAdds(vecLoad<V>(dist+i+stride), two), none));
+		d = vecMin(d, vecSelect(downLeft, vecAdds(vecLoad<V>(dist+i+stride-1), three), none));
+		d = vecMin(d, vecSelect(downRight, vecAdds(vecLoad<V>(dist+i+stride+1), three), none));
+		vecStore(dist+i, d);
+	}
+};
+
+template<class V> inline void vecSort(V& a, V& b)
+{
+	const V t = vecMin(a, b);
+	b = vecMax(a, b);
+	a = t;
+}
+
+// The median of 9 values.  (Same as the fifth value after sorting.)
+template<class V> inline V vecMedian9(V* p)
+{
+	vecSort(p[1], p[2]); vecSort(p[4], p[5]); vecSort(p[7], p[8]);
+	vecSort(p[0], p[1]); vecSort(p[3], p[4]); vecSort(p[6], p[7]);
+	vecSort(p[1], p[2]); vecSort(p[4], p[5]); vecSort(p[7], p[8]);
+	p[3] = vecMax(p[0], p[3]);
+	p[5] = vecMin(p[5], p[8]);
+	vecSort(p[4], p[7]);
+	p[6] = vecMax(p[3], p[6]);
+	p[4] = vecMax(p[1], p[4]);
+	p[2] = vecMin(p[2], p[5]);
+	p[4] = vecMin(p[4], p[7]);
+	vecSort(p[4], p[2]);
+	p[4] = vecMax(p[6], p[4]);
+	return vecMin(p[4], p[2]);
+}
+
+struct rcMedianKernel
+{
+	const unsigned char* cons;
+	const unsigned char* areas;
+	unsigned char* dst;
+	int offsets[4];	// The grid offset of each direction.
+	
+	template<class V> void run(const int i) const
+	{
+		const V null = vecSet<V>(RC_NULL_AREA);
+		const V a = vecLoad<V>(areas+i);
+		const V c = vecLoad<V>(cons+i);
+		
+		V nei[9];
+		for (int dir = 0; dir < 4; ++dir)
+		{
+			const int dir2 = (dir+1) & 0x3;
+			const int ai = i + offsets[dir];
+			const int ai2 = ai + offsets[dir2];
+			const V connected = vecTest(c, vecSet<V>((unsigned char)(1 << dir)));
+			const V connected2 = vecAnd(connected, vecTest(vecLoad<V>(cons+ai), vecSet<V>((unsigned char)(1 << dir2))));
+			const V n = vecLoad<V>(areas+ai);
+			const V n2 = vecLoad<V>(areas+ai2);
+			nei[dir*2+0] = vecSelect(connected, vecSelect(vecEq(n, null), a, n), a);
+			nei[dir*2+1] = vecSelect(connected2, vecSelect(vecEq(n2, null), a, n2), a);
+		}
+		nei[8] = a;
+		
+		vecStore(dst+i, vecSelect(vecEq(a, null), a, vecMedian9(nei)));
+	}
+};
+
+// Sets the initial erosion distances of the spans in rows [y0, y1).
+static void erodeBoundaryRows(const rcCompactHeightfield& chf, const rcAreaGrid* grid,
+							  unsigned char* dist, const int y0, const int y1)
+{
+	const int w = chf.width;
+	
+	if (grid)
+	{
+		rcErodeBoundaryKernel kernel;
+		kernel.cons = grid->cons;
+		kernel.areas = grid->src;
+		kernel.dist = grid->dst;
+		kernel.stride = grid->width;
+		for (int layer = 0; layer < grid->layerCount; ++layer)
+			for (int y = y0; y < y1; ++y)
+				runKernel(kernel, getGridIndex(*grid, 0, y, layer), w);
+		return;
+	}
+	
+	for (int y = y0; y < y1; ++y)
 	{
 		for (int x = 0; x < w; ++x)
 		{
@@ -83,19 +370,49 @@ bool rcErodeWalkableArea(rcContext* ctx, int radius, rcCompactHeightfield& chf)
 						}
 					}
 					// At least one missing neighbour.
-					if (nc != 4)
-						dist[i] = 0;
+					dist[i] = (nc != 4) ? 0 : 0xff;
 				}
 			}
 		}
 	}
+}
+
+// The first erosion pass over the cells in [x0, x1) x [y0, y1).
+// Each cell depends on (-1,0), (-1,-1), (0,-1) and (1,-1).
+static void erodePass1(const rcCompactHeightfield& chf, const rcAreaGrid* grid, unsigned char* dist,
+					   const int x0, const int x1, const int y0, const int y1)
+{
+	const int w = chf.width;
+	
+	if (grid)
+	{
+		rcErodePass1Kernel kernel;
+		kernel.cons = grid->cons;
+		kernel.dist = grid->dst;
+		kernel.stride = grid->width;
+		for (int layer = 0; layer < grid->layerCount; ++layer)
+		{
+			for (int y = y0; y < y1; ++y)
+			{
+				const int row = getGridIndex(*grid, 0, y, layer);
+				runKernel(kernel, row + x0, x1 - x0);
+				
+				// (-1,0) depends on the cell before it in the row.
+				for (int i = row + x0; i < row + x1; ++i)
+				{
+					if (grid->cons[i] & (1 << 0))
+						grid->dst[i] = vecMin(grid->dst[i], vecAdds(grid->dst[i-1], 2));
+				}
+			}
+		}
+		return;
+	}
 	
 	unsigned char nd;
 	
-	// Pass 1
-	for (int y = 0; y < h; ++y)
+	for (int y = y0; y < y1; ++y)
 	{
-		for (int x = 0; x < w; ++x)
+		for (int x = x0; x < x1; ++x)
 		{
 			const rcCompactCell& c = chf.cells[x+y*w];
 			for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
@@ -149,11 +466,44 @@ bool rcErodeWalkableArea(rcContext* ctx, int radius, rcCompactHeightfield& chf)
 			}
 		}
 	}
+}
+
+// The second erosion pass over the cells in [x0, x1) x [y0, y1), in 
+// reverse order.  Each cell depends on (1,0), (1,1), (0,1) and (-1,1).
+static void erodePass2(const rcCompactHeightfield& chf, const rcAreaGrid* grid, unsigned char* dist,
+					   const int x0, const int x1, const int y0, const int y1)
+{
+	const int w = chf.width;
 	
-	// Pass 2
-	for (int y = h-1; y >= 0; --y)
+	if (grid)
 	{
-		for (int x = w-1; x >= 0; --x)
+		rcErodePass2Kernel kernel;
+		kernel.cons = grid->cons;
+		kernel.dist = grid->dst;
+		kernel.stride = grid->width;
+		for (int layer = 0; layer < grid->layerCount; ++layer)
+		{
+			for (int y = y1-1; y >= y0; --y)
+			{
+				const int row = getGridIndex(*grid, 0, y, layer);
+				runKernel(kernel, row + x0, x1 - x0);
+				
+				// (1,0) depends on the cell after it in the row.
+				for (int i = row + x1 - 1; i >= row + x0; --i)
+				{
+					if (grid->cons[i] & (1 << 2))
+						grid->dst[i] = vecMin(grid->dst[i], vecAdds(grid->dst[i+1], 2));
+				}
+			}
+		}
+		return;
+	}
+	
+	unsigned char nd;
+	
+	for (int y = y1-1; y >= y0; --y)
+	{
+		for (int x = x1-1; x >= x0; --x)
 		{
 			const rcCompactCell& c = chf.cells[x+y*w];
 			for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
@@ -207,57 +557,52 @@ bool rcErodeWalkableArea(rcContext* ctx, int radius, rcCompactHeightfield& chf)
 			}
 		}
 	}
-	
-	const unsigned char thr = (unsigned char)(radius*2);
-	for (int i = 0; i < chf.spanCount; ++i)
-		if (dist[i] < thr)
-			chf.areas[i] = RC_NULL_AREA;
-	
-	rcFree(dist);
-	
-	ctx->stopTimer(RC_TIMER_ERODE_AREA);
-	
-	return true;
 }
 
-static void insertSort(unsigned char* a, const int n)
+// Clears the areas of the spans in rows [y0, y1) that are closer than the
+// threshold to the edge.
+static void erodeAreaRows(rcCompactHeightfield& chf, const rcAreaGrid* grid,
+						  const unsigned char* dist, const unsigned char thr,
+						  const int y0, const int y1)
 {
-	int i, j;
-	for (i = 1; i < n; i++)
+	const int w = chf.width;
+	
+	for (int y = y0; y < y1; ++y)
 	{
-		const unsigned char value = a[i];
-		for (j = i - 1; j >= 0 && a[j] > value; j--)
-			a[j+1] = a[j];
-		a[j+1] = value;
+		for (int x = 0; x < w; ++x)
+		{
+			const rcCompactCell& c = chf.cells[x+y*w];
+			for (int k = 0; k < (int)c.count; ++k)
+			{
+				const int i = (int)c.index + k;
+				const unsigned char d = grid ? grid->dst[getGridIndex(*grid, x, y, k)] : dist[i];
+				if (d < thr)
+					chf.areas[i] = RC_NULL_AREA;
+			}
+		}
 	}
 }
 
-/// @par
-///
-/// This filter is usually applied after applying area id's using functions
-/// such as #rcMarkBoxArea, #rcMarkConvexPolyArea, and #rcMarkCylinderArea.
-/// 
-/// @see rcCompactHeightfield
-bool rcMedianFilterWalkableArea(rcContext* ctx, rcCompactHeightfield& chf)
+static void medianRows(const rcCompactHeightfield& chf, const rcAreaGrid* grid,
+					   unsigned char* areas, const int y0, const int y1)
 {
-	rcAssert(ctx);
-	
 	const int w = chf.width;
-	const int h = chf.height;
-	
-	ctx->startTimer(RC_TIMER_MEDIAN_AREA);
 	
-	unsigned char* areas = (unsigned char*)rcAlloc(sizeof(unsigned char)*chf.spanCount, RC_ALLOC_TEMP);
-	if (!areas)
+	if (grid)
 	{
-		ctx->log(RC_LOG_ERROR, "medianFilterWalkableArea: Out of memory 'areas' (%d).", chf.spanCount);
-		return false;
+		rcMedianKernel kernel;
+		kernel.cons = grid->cons;
+		kernel.areas = grid->src;
+		kernel.dst = grid->dst;
+		for (int dir = 0; dir < 4; ++dir)
+			kernel.offsets[dir] = rcGetDirOffsetX(dir) + rcGetDirOffsetY(dir)*grid->width;
+		for (int layer = 0; layer < grid->layerCount; ++layer)
+			for (int y = y0; y < y1; ++y)
+				runKernel(kernel, getGridIndex(*grid, 0, y, layer), w);
+		return;
 	}
 	
-	// Init distance.
-	memset(areas, 0xff, sizeof(unsigned char)*chf.spanCount);
-	
-	for (int y = 0; y < h; ++y)
+	for (int y = y0; y < y1; ++y)
 	{
 		for (int x = 0; x < w; ++x)
 		{
@@ -297,15 +642,267 @@ bool rcMedianFilterWalkableArea(rcContext* ctx, rcCompactHeightfield& chf)
 						}
 					}
 				}
-				insertSort(nei, 9);
-				areas[i] = nei[4];
+				areas[i] = vecMedian9(nei);
+			}
+		}
+	}
+}
+
+// Copies the filtered areas in rows [y0, y1) back to the field.
+static void storeAreaRows(rcCompactHeightfield& chf, const rcAreaGrid* grid,
+						  const unsigned char* areas, const int y0, const int y1)
+{
+	const int w = chf.width;
+	
+	for (int y = y0; y < y1; ++y)
+	{
+		for (int x = 0; x < w; ++x)
+		{
+			const rcCompactCell& c = chf.cells[x+y*w];
+			for (int k = 0; k < (int)c.count; ++k)
+			{
+				const int i = (int)c.index + k;
+				chf.areas[i] = grid ? grid->dst[getGridIndex(*grid, x, y, k)] : areas[i];
 			}
 		}
 	}
+}
+
+// The parallel filters split the rows between tasks.  The erosion passes 
+// work on blocks of cells instead.  Each row of a block starts one cell to the
+// left of the row above it, so a block only depends on its left neighbour and
+// the blocks above it and above-right of it.  All blocks with the same value
+// of (bx + 2*by) can then run at the same time.  The results are identical to
+// the serial filters.
+static const int RC_AREA_BLOCK_SIZE = 32;
+
+struct rcAreaFilterJob
+{
+	rcCompactHeightfield* chf;
+	const rcAreaGrid* grid;	// Null if the sparse filters are used.
+	unsigned char* values;	// The sparse distances or areas.
+	unsigned char thr;
+	int rowsPerTask;
+	int nbx, nby;
+	int step;			// The current wavefront step.
+	int firstBlockY;	// The block row of the first task in the step.
+};
+
+static int getAreaRowTaskCount(const int h, const int workerCount, int& rowsPerTask)
+{
+	const int taskCount = rcMin(h, workerCount*4);
+	rowsPerTask = (h + taskCount - 1) / taskCount;
+	return (h + rowsPerTask - 1) / rowsPerTask;
+}
+
+static void erodeBoundaryTask(void* userData, int taskIndex, int /*workerIndex*/)
+{
+	rcAreaFilterJob& job = *(rcAreaFilterJob*)userData;
+	const int y0 = taskIndex * job.rowsPerTask;
+	const int y1 = rcMin(job.chf->height, y0 + job.rowsPerTask);
+	erodeBoundaryRows(*job.chf, job.grid, job.values, y0, y1);
+}
+
+static void erodePass1Task(void* userData, int taskIndex, int /*workerIndex*/)
+{
+	rcAreaFilterJob& job = *(rcAreaFilterJob*)userData;
+	const int w = job.chf->width;
+	const int by = job.firstBlockY + taskIndex;
+	const int bx = job.step - by*2;
+	const int y0 = by*RC_AREA_BLOCK_SIZE;
+	const int y1 = rcMin(job.chf->height, y0 + RC_AREA_BLOCK_SIZE);
+	for (int y = y0; y < y1; ++y)
+	{
+		const int x0 = rcMax(0, bx*RC_AREA_BLOCK_SIZE - (y - y0));
+		const int x1 = rcMin(w, (bx+1)*RC_AREA_BLOCK_SIZE - (y - y0));
+		if (x0 < x1)
+			erodePass1(*job.chf, job.grid, job.values, x0, x1, y, y+1);
+	}
+}
+
+static void erodePass2Task(void* userData, int taskIndex, int /*workerIndex*/)
+{
+	// Same as pass 1, with the field mirrored.
+	rcAreaFilterJob& job = *(rcAreaFilterJob*)userData;
+	const int w = job.chf->width;
+	const int h = job.chf->height;
+	const int by = job.firstBlockY + taskIndex;
+	const int bx = job.step - by*2;
+	const int y0 = by*RC_AREA_BLOCK_SIZE;
+	const int y1 = rcMin(h, y0 + RC_AREA_BLOCK_SIZE);
+	for (int y = y0; y < y1; ++y)
+	{
+		const int x0 = rcMax(0, bx*RC_AREA_BLOCK_SIZE - (y - y0));
+		const int x1 = rcMin(w, (bx+1)*RC_AREA_BLOCK_SIZE - (y - y0));
+		if (x0 < x1)
+			erodePass2(*job.chf, job.grid, job.values, w - x1, w - x0, h-1 - y, h - y);
+	}
+}
+
+static void erodeAreaTask(void* userData, int taskIndex, int /*workerIndex*/)
+{
+	rcAreaFilterJob& job = *(rcAreaFilterJob*)userData;
+	const int y0 = taskIndex * job.rowsPerTask;
+	const int y1 = rcMin(job.chf->height, y0 + job.rowsPerTask);
+	erodeAreaRows(*job.chf, job.grid, job.values, job.thr, y0, y1);
+}
+
+static void medianTask(void* userData, int taskIndex, int /*workerIndex*/)
+{
+	rcAreaFilterJob& job = *(rcAreaFilterJob*)userData;
+	const int y0 = taskIndex * job.rowsPerTask;
+	const int y1 = rcMin(job.chf->height, y0 + job.rowsPerTask);
+	medianRows(*job.chf, job.grid, job.values, y0, y1);
+}
+
+static void storeAreaTask(void* userData, int taskIndex, int /*workerIndex*/)
+{
+	rcAreaFilterJob& job = *(rcAreaFilterJob*)userData;
+	const int y0 = taskIndex * job.rowsPerTask;
+	const int y1 = rcMin(job.chf->height, y0 + job.rowsPerTask);
+	storeAreaRows(*job.chf, job.grid, job.values, y0, y1);
+}
+
+static void runAreaWavefront(rcTaskScheduler* scheduler, rcAreaFilterJob& job, rcTaskFunc func)
+{
+	const int stepCount = (job.nbx-1) + (job.nby-1)*2 + 1;
+	for (int t = 0; t < stepCount; ++t)
+	{
+		// The block rows with a block column in range.
+		const int by0 = t - (job.nbx-1) > 0 ? (t - (job.nbx-1) + 1) / 2 : 0;
+		const int by1 = rcMin(job.nby-1, t/2);
+		job.step = t;
+		job.firstBlockY = by0;
+		scheduler->parallelFor(func, &job, by1 - by0 + 1);
+	}
+}
+
+/// @par 
+/// 
+/// Basically, any spans that are closer to a boundary or obstruction than the specified radius 
+/// are marked as unwalkable.
+///
+/// This method is usually called immediately after the heightfield has been built.
+///
+/// Fields where every connection stays on the same layer of its column are filtered on a
+/// dense grid, using SIMD where available.  The result is the same for all fields with or 
+/// without a scheduler.
+///
+/// @see rcCompactHeightfield, rcBuildCompactHeightfield, rcConfig::walkableRadius
+bool rcErodeWalkableArea(rcContext* ctx, int radius, rcCompactHeightfield& chf,
+						 rcTaskScheduler* scheduler)
+{
+	rcAssert(ctx);
+	
+	const int w = chf.width;
+	const int h = chf.height;
+	
+	ctx->startTimer(RC_TIMER_ERODE_AREA);
+	
+	rcAreaGrid grid;
+	const bool dense = initAreaGrid(chf, grid);
+	
+	unsigned char* dist = 0;
+	if (!dense)
+	{
+		dist = (unsigned char*)rcAlloc(sizeof(unsigned char)*chf.spanCount, RC_ALLOC_TEMP);
+		if (!dist)
+		{
+			ctx->log(RC_LOG_ERROR, "erodeWalkableArea: Out of memory 'dist' (%d).", chf.spanCount);
+			return false;
+		}
+	}
+	
+	const unsigned char thr = (unsigned char)(radius*2);
+	
+	if (scheduler && scheduler->getWorkerCount() > 1 && h > 0)
+	{
+		rcAreaFilterJob job;
+		memset(&job, 0, sizeof(job));
+		job.chf = &chf;
+		job.grid = dense ? &grid : 0;
+		job.values = dist;
+		job.thr = thr;
+		// The sheared blocks need one extra column to cover the field.
+		job.nbx = (w + RC_AREA_BLOCK_SIZE-1) / RC_AREA_BLOCK_SIZE + 1;
+		job.nby = (h + RC_AREA_BLOCK_SIZE-1) / RC_AREA_BLOCK_SIZE;
+		
+		const int taskCount = getAreaRowTaskCount(h, scheduler->getWorkerCount(), job.rowsPerTask);
+		scheduler->parallelFor(erodeBoundaryTask, &job, taskCount);
+		runAreaWavefront(scheduler, job, erodePass1Task);
+		runAreaWavefront(scheduler, job, erodePass2Task);
+		scheduler->parallelFor(erodeAreaTask, &job, taskCount);
+	}
+	else
+	{
+		const rcAreaGrid* g = dense ? &grid : 0;
+		erodeBoundaryRows(chf, g, dist, 0, h);
+		erodePass1(chf, g, dist, 0, w, 0, h);
+		erodePass2(chf, g, dist, 0, w, 0, h);
+		erodeAreaRows(chf, g, dist, thr, 0, h);
+	}
 	
-	memcpy(chf.areas, areas, sizeof(unsigned char)*chf.spanCount);
+	rcFree(dist);
+	rcFree(grid.cons);
+	
+	ctx->stopTimer(RC_TIMER_ERODE_AREA);
+	
+	return true;
+}
+
+/// @par
+///
+/// This filter is usually applied after applying area id's using functions
+/// such as #rcMarkBoxArea, #rcMarkConvexPolyArea, and #rcMarkCylinderArea.
+/// 
+/// Like #rcErodeWalkableArea, suitable fields are filtered on a dense grid.
+/// 
+/// @see rcCompactHeightfield
+bool rcMedianFilterWalkableArea(rcContext* ctx, rcCompactHeightfield& chf,
+								rcTaskScheduler* scheduler)
+{
+	rcAssert(ctx);
+	
+	const int h = chf.height;
+	
+	ctx->startTimer(RC_TIMER_MEDIAN_AREA);
+	
+	rcAreaGrid grid;
+	const bool dense = initAreaGrid(chf, grid);
+	
+	unsigned char* areas = 0;
+	if (!dense)
+	{
+		areas = (unsigned char*)rcAlloc(sizeof(unsigned char)*chf.spanCount, RC_ALLOC_TEMP);
+		if (!areas)
+		{
+			ctx->log(RC_LOG_ERROR, "medianFilterWalkableArea: Out of memory 'areas' (%d).", chf.spanCount);
+			return false;
+		}
+	}
+	
+	if (scheduler && scheduler->getWorkerCount() > 1 && h > 0)
+	{
+		rcAreaFilterJob job;
+		memset(&job, 0, sizeof(job));
+		job.chf = &chf;
+		job.grid = dense ? &grid : 0;
+		job.values = areas;
+		
+		// All rows are filtered before any are stored.
+		const int taskCount = getAreaRowTaskCount(h, scheduler->getWorkerCount(), job.rowsPerTask);
+		scheduler->parallelFor(medianTask, &job, taskCount);
+		scheduler->parallelFor(storeAreaTask, &job, taskCount);
+	}
+	else if (h > 0)
+	{
+		const rcAreaGrid* g = dense ? &grid : 0;
+		medianRows(chf, g, areas, 0, h);
+		storeAreaRows(chf, g, areas, 0, h);
+	}
 	
 	rcFree(areas);
+	rcFree(grid.cons);
 
 	ctx->stopTimer(RC_TIMER_MEDIAN_AREA);
 	
@@ -24,6 +24,7 @@
 #include "Recast.h"
 #include "RecastAlloc.h"
 #include "RecastAssert.h"
+#include "RecastTaskScheduler.h"
 
 
 static int getCornerHeight(int x, int y, int i, int dir,
@@ -606,7 +607,7 @@ static void removeDegenerateSegments(rcIntArray& simplified)
 static bool mergeContours(rcContour& ca, rcContour& cb, int ia, int ib)
 {
 	const int maxVerts = ca.nverts + cb.nverts + 2;
-	int* verts = (int*)rcAlloc(sizeof(int)*maxVerts*4, RC_ALLOC_PERM);
+	int* verts = (int*)rcAlloc(sizeof(int)*maxVerts*4, RC_ALLOC_PERM, RC_ALLOC_TAG_CONTOURS);
 	if (!verts)
 		return false;
 	
@@ -778,7 +779,7 @@ static void mergeRegionHoles(rcContext* ctx, rcContourRegion& region)
 			for (int j = 0; j < ndiags; j++)
 			{
 				const int* pt = &outline->verts[diags[j].vert*4];
-				bool intersect = intersectSegCountour(pt, corner, diags[i].vert, outline->nverts, outline->verts);
+				bool intersect = intersectSegCountour(pt, corner, diags[j].vert, outline->nverts, outline->verts);
 				for (int k = i; k < region.nholes && !intersect; k++)
 					intersect |= intersectSegCountour(pt, corner, -1, region.holes[k].contour->nverts, region.holes[k].contour->verts);
 				if (!intersect)
@@ -808,6 +809,344 @@ static void mergeRegionHoles(rcContext* ctx, rcContourRegion& region)
 }
 
 
+static void markContourBoundaries(const rcCompactHeightfield& chf, unsigned char* flags,
+								  const int y0, const int y1)
+{
+	const int w = chf.width;
+	for (int y = y0; y < y1; ++y)
+	{
+		for (int x = 0; x < w; ++x)
+		{
+			const rcCompactCell& c = chf.cells[x+y*w];
+			for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
+			{
+				unsigned char res = 0;
+				const rcCompactSpan& s = chf.spans[i];
+				if (!chf.spans[i].reg || (chf.spans[i].reg & RC_BORDER_REG))
+				{
+					flags[i] = 0;
+					continue;
+				}
+				for (int dir = 0; dir < 4; ++dir)
+				{
+					unsigned short r = 0;
+					if (rcGetCon(s, dir) != RC_NOT_CONNECTED)
+					{
+						const int ax = x + rcGetDirOffsetX(dir);
+						const int ay = y + rcGetDirOffsetY(dir);
+						const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, dir);
+						r = chf.spans[ai].reg;
+					}
+					if (r == chf.spans[i].reg)
+						res |= (1 << dir);
+				}
+				flags[i] = res ^ 0xf; // Inverse, mark non connected edges.
+			}
+		}
+	}
+}
+
+// Copies contour vertices, removing the border offset.
+static bool copyContourVerts(const rcIntArray& src, const int borderSize, int*& dst, int& ndst)
+{
+	ndst = src.size()/4;
+	dst = (int*)rcAlloc(sizeof(int)*ndst*4, RC_ALLOC_PERM, RC_ALLOC_TAG_CONTOURS);
+	if (!dst)
+		return false;
+	memcpy(dst, &src[0], sizeof(int)*ndst*4);
+	if (borderSize > 0)
+	{
+		// If the heightfield was build with bordersize, remove the offset.
+		for (int j = 0; j < ndst; ++j)
+		{
+			int* v = &dst[j*4];
+			v[0] -= borderSize;
+			v[2] -= borderSize;
+		}
+	}
+	return true;
+}
+
+// The fewest regions worth a separate contour task.
+static const int RC_CONTOUR_MIN_TASK_REGIONS = 4;
+
+// The contours of a range of regions, in the order of their first span.
+struct rcContourTask
+{
+	int candStart, candEnd;
+	rcContour* conts;
+	int* starts;		// The span each contour was traced from.
+	int nconts, cap;
+	bool failed;
+};
+
+struct rcContourJob
+{
+	rcCompactHeightfield* chf;
+	unsigned char* flags;
+	float maxError;
+	int maxEdgeLen;
+	int buildFlags;
+	int rowsPerTask;
+	const int* cands;	// (span, cell) pairs, grouped by task.
+	rcContourTask* tasks;
+};
+
+static void markContourBoundariesTask(void* userData, int taskIndex, int /*workerIndex*/)
+{
+	rcContourJob& job = *(rcContourJob*)userData;
+	const int y0 = taskIndex * job.rowsPerTask;
+	const int y1 = rcMin(job.chf->height, y0 + job.rowsPerTask);
+	markContourBoundaries(*job.chf, job.flags, y0, y1);
+}
+
+static void buildContoursTask(void* userData, int taskIndex, int /*workerIndex*/)
+{
+	rcContourJob& job = *(rcContourJob*)userData;
+	rcContourTask& task = job.tasks[taskIndex];
+	rcCompactHeightfield& chf = *job.chf;
+	unsigned char* flags = job.flags;
+	const int w = chf.width;
+	
+	rcIntArray verts(256);
+	rcIntArray simplified(64);
+	
+	// Walks of one region only visit that region's spans, and all of the
+	// region's spans are in this task, so the scan order matches the serial
+	// build.
+	for (int k = task.candStart; k < task.candEnd; ++k)
+	{
+		const int i = job.cands[k*2+0];
+		const int x = job.cands[k*2+1] % w;
+		const int y = job.cands[k*2+1] / w;
+		if (flags[i] == 0 || flags[i] == 0xf)
+		{
+			flags[i] = 0;
+			continue;
+		}
+		const unsigned short reg = chf.spans[i].reg;
+		const unsigned char area = chf.areas[i];
+		
+		verts.resize(0);
+		simplified.resize(0);
+		
+		walkContour(x, y, i, chf, flags, verts);
+		simplifyContour(verts, simplified, job.maxError, job.maxEdgeLen, job.buildFlags);
+		removeDegenerateSegments(simplified);
+		
+		if (simplified.size()/4 < 3)
+			continue;
+		
+		if (task.nconts >= task.cap)
+		{
+			const int cap = rcMax(task.cap*2, 8);
+			rcContour* conts = (rcContour*)rcAlloc(sizeof(rcContour)*cap, RC_ALLOC_PERM, RC_ALLOC_TAG_CONTOURS);
+			int* starts = (int*)rcAlloc(sizeof(int)*cap, RC_ALLOC_PERM, RC_ALLOC_TAG_CONTOURS);
+			if (!conts || !starts)
+			{
+				rcFree(conts);
+				rcFree(starts);
+				task.failed = true;
+				return;
+			}
+			if (task.nconts)
+			{
+				memcpy(conts, task.conts, sizeof(rcContour)*task.nconts);
+				memcpy(starts, task.starts, sizeof(int)*task.nconts);
+			}
+			rcFree(task.conts);
+			rcFree(task.starts);
+			task.conts = conts;
+			task.starts = starts;
+			task.cap = cap;
+		}
+		
+		rcContour* cont = &task.conts[task.nconts];
+		cont->verts = 0;
+		cont->rverts = 0;
+		if (!copyContourVerts(simplified, chf.borderSize, cont->verts, cont->nverts)
+			|| !copyContourVerts(verts, chf.borderSize, cont->rverts, cont->nrverts))
+		{
+			rcFree(cont->verts);
+			rcFree(cont->rverts);
+			task.failed = true;
+			return;
+		}
+		cont->reg = reg;
+		cont->area = area;
+		task.starts[task.nconts++] = i;
+	}
+}
+
+static void freeContourTasks(rcContourTask* tasks, const int taskCount, const bool freeContours)
+{
+	for (int i = 0; i < taskCount; ++i)
+	{
+		rcContourTask& task = tasks[i];
+		if (freeContours)
+		{
+			for (int j = 0; j < task.nconts; ++j)
+			{
+				rcFree(task.conts[j].verts);
+				rcFree(task.conts[j].rverts);
+			}
+		}
+		rcFree(task.conts);
+		rcFree(task.starts);
+	}
+}
+
+// Traces and simplifies the contours of groups of regions as separate tasks,
+// then stores them in the serial build order.
+static bool buildContoursParallel(rcContext* ctx, rcCompactHeightfield& chf, unsigned char* flags,
+								  const float maxError, const int maxEdgeLen, const int buildFlags,
+								  rcTaskScheduler* scheduler, const int taskCount,
+								  rcContourSet& cset, int& maxContours)
+{
+	const int nregions = chf.maxRegions+1;
+	
+	// Count the candidate start spans of each region.
+	rcScopedDelete<int> regTask = (int*)rcAlloc(sizeof(int)*nregions, RC_ALLOC_TEMP);
+	if (!regTask)
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildContours: Out of memory 'regTask' (%d).", nregions);
+		return false;
+	}
+	memset(regTask, 0, sizeof(int)*nregions);
+	int ncands = 0;
+	for (int i = 0; i < chf.spanCount; ++i)
+	{
+		if (flags[i] == 0)
+			continue;
+		regTask[chf.spans[i].reg]++;
+		ncands++;
+	}
+	
+	// Split the regions into ranges with about the same number of candidates.
+	rcScopedDelete<rcContourTask> tasks = (rcContourTask*)rcAlloc(sizeof(rcContourTask)*taskCount, RC_ALLOC_TEMP);
+	rcScopedDelete<int> cands = (int*)rcAlloc(sizeof(int)*rcMax(ncands, 1)*2, RC_ALLOC_TEMP);
+	if (!tasks || !cands)
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildContours: Out of memory 'cands' (%d).", ncands*2);
+		return false;
+	}
+	memset((rcContourTask*)tasks, 0, sizeof(rcContourTask)*taskCount);
+	int sum = 0;
+	for (int r = 0, t = 0; r < nregions; ++r)
+	{
+		const int n = regTask[r];
+		while (t < taskCount-1 && sum >= ncands*(t+1)/taskCount)
+			t++;
+		regTask[r] = t;
+		tasks[t].candEnd += n;
+		sum += n;
+	}
+	for (int t = 1; t < taskCount; ++t)
+	{
+		tasks[t].candStart = tasks[t-1].candEnd;
+		tasks[t].candEnd += tasks[t].candStart;
+	}
+	
+	// Group the candidates by task, keeping them in scan order.
+	rcScopedDelete<int> fill = (int*)rcAlloc(sizeof(int)*taskCount, RC_ALLOC_TEMP);
+	if (!fill)
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildContours: Out of memory 'fill' (%d).", taskCount);
+		return false;
+	}
+	for (int t = 0; t < taskCount; ++t)
+		fill[t] = tasks[t].candStart;
+	const int w = chf.width;
+	const int h = chf.height;
+	for (int y = 0; y < h; ++y)
+	{
+		for (int x = 0; x < w; ++x)
+		{
+			const rcCompactCell& c = chf.cells[x+y*w];
+			for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
+			{
+				if (flags[i] == 0)
+					continue;
+				const int k = fill[regTask[chf.spans[i].reg]]++;
+				cands[k*2+0] = i;
+				cands[k*2+1] = x+y*w;
+			}
+		}
+	}
+	
+	rcContourJob job;
+	job.chf = &chf;
+	job.flags = flags;
+	job.maxError = maxError;
+	job.maxEdgeLen = maxEdgeLen;
+	job.buildFlags = buildFlags;
+	job.rowsPerTask = 0;
+	job.cands = cands;
+	job.tasks = tasks;
+	
+	scheduler->parallelFor(buildContoursTask, &job, taskCount);
+	
+	int nconts = 0;
+	bool failed = false;
+	for (int t = 0; t < taskCount; ++t)
+	{
+		nconts += tasks[t].nconts;
+		failed |= tasks[t].failed;
+	}
+	if (failed)
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildContours: Out of memory 'verts'.");
+		freeContourTasks(tasks, taskCount, true);
+		return false;
+	}
+	
+	if (nconts > maxContours)
+	{
+		// This happens when regions have holes.
+		while (nconts > maxContours)
+		{
+			ctx->log(RC_LOG_WARNING, "rcBuildContours: Expanding max contours from %d to %d.", maxContours, maxContours*2);
+			maxContours *= 2;
+		}
+		rcContour* newConts = (rcContour*)rcAlloc(sizeof(rcContour)*maxContours, RC_ALLOC_PERM, RC_ALLOC_TAG_CONTOURS);
+		if (!newConts)
+		{
+			ctx->log(RC_LOG_ERROR, "rcBuildContours: Out of memory 'conts' (%d).", maxContours);
+			freeContourTasks(tasks, taskCount, true);
+			return false;
+		}
+		rcFree(cset.conts);
+		cset.conts = newConts;
+	}
+	
+	// Each task's contours are in scan order.  Merge them by start span.
+	rcScopedDelete<int> next = (int*)rcAlloc(sizeof(int)*taskCount, RC_ALLOC_TEMP);
+	if (!next)
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildContours: Out of memory 'next' (%d).", taskCount);
+		freeContourTasks(tasks, taskCount, true);
+		return false;
+	}
+	memset(next, 0, sizeof(int)*taskCount);
+	while (cset.nconts < nconts)
+	{
+		int best = -1;
+		for (int t = 0; t < taskCount; ++t)
+		{
+			if (next[t] < tasks[t].nconts
+				&& (best == -1 || tasks[t].starts[next[t]] < tasks[best].starts[next[best]]))
+			{
+				best = t;
+			}
+		}
+		cset.conts[cset.nconts++] = tasks[best].conts[next[best]++];
+	}
+	
+	freeContourTasks(tasks, taskCount, false);
+	
+	return true;
+}
+
 /// @par
 ///
 /// The raw contours will match the region outlines exactly. The @p maxError and @p maxEdgeLen
@@ -820,10 +1159,17 @@ static void mergeRegionHoles(rcContext* ctx, rcContourRegion& region)
 ///
 /// See the #rcConfig documentation for more information on the configuration parameters.
 ///
+/// If a scheduler is provided, the regions are split into groups that are traced and 
+/// simplified as separate tasks.  A contour walk only visits the spans of its own region, 
+/// so each group sees the same boundary flags as in the serial build.  The contours are 
+/// then stored in the order of their first span, so the result is identical to the serial 
+/// build.  Hole merging is serial.
+///
 /// @see rcAllocContourSet, rcCompactHeightfield, rcContourSet, rcConfig
 bool rcBuildContours(rcContext* ctx, rcCompactHeightfield& chf,
 					 const float maxError, const int maxEdgeLen,
-					 rcContourSet& cset, const int buildFlags)
+					 rcContourSet& cset, const int buildFlags,
+					 rcTaskScheduler* scheduler)
 {
 	rcAssert(ctx);
 	
@@ -851,7 +1197,7 @@ bool rcBuildContours(rcContext* ctx, rcCompactHeightfield& chf,
 	cset.borderSize = chf.borderSize;
 	
 	int maxContours = rcMax((int)chf.maxRegions, 8);
-	cset.conts = (rcContour*)rcAlloc(sizeof(rcContour)*maxContours, RC_ALLOC_PERM);
+	cset.conts = (rcContour*)rcAlloc(sizeof(rcContour)*maxContours, RC_ALLOC_PERM, RC_ALLOC_TAG_CONTOURS);
 	if (!cset.conts)
 		return false;
 	cset.nconts = 0;
@@ -866,139 +1212,110 @@ bool rcBuildContours(rcContext* ctx, rcCompactHeightfield& chf,
 	ctx->startTimer(RC_TIMER_BUILD_CONTOURS_TRACE);
 	
 	// Mark boundaries.
-	for (int y = 0; y < h; ++y)
+	const int workerCount = scheduler ? scheduler->getWorkerCount() : 1;
+	if (workerCount > 1 && h > 1)
 	{
-		for (int x = 0; x < w; ++x)
-		{
-			const rcCompactCell& c = chf.cells[x+y*w];
-			for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
-			{
-				unsigned char res = 0;
-				const rcCompactSpan& s = chf.spans[i];
-				if (!chf.spans[i].reg || (chf.spans[i].reg & RC_BORDER_REG))
-				{
-					flags[i] = 0;
-					continue;
-				}
-				for (int dir = 0; dir < 4; ++dir)
-				{
-					unsigned short r = 0;
-					if (rcGetCon(s, dir) != RC_NOT_CONNECTED)
-					{
-						const int ax = x + rcGetDirOffsetX(dir);
-						const int ay = y + rcGetDirOffsetY(dir);
-						const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, dir);
-						r = chf.spans[ai].reg;
-					}
-					if (r == chf.spans[i].reg)
-						res |= (1 << dir);
-				}
-				flags[i] = res ^ 0xf; // Inverse, mark non connected edges.
-			}
-		}
+		rcContourJob job;
+		memset(&job, 0, sizeof(job));
+		job.chf = &chf;
+		job.flags = flags;
+		const int taskCount = rcMin(h, workerCount*4);
+		job.rowsPerTask = (h + taskCount - 1) / taskCount;
+		scheduler->parallelFor(markContourBoundariesTask, &job, (h + job.rowsPerTask - 1) / job.rowsPerTask);
+	}
+	else
+	{
+		markContourBoundaries(chf, flags, 0, h);
 	}
 	
 	ctx->stopTimer(RC_TIMER_BUILD_CONTOURS_TRACE);
 	
-	rcIntArray verts(256);
-	rcIntArray simplified(64);
-	
-	for (int y = 0; y < h; ++y)
+	const int taskCount = rcMin(workerCount*4, (int)chf.maxRegions / RC_CONTOUR_MIN_TASK_REGIONS);
+	if (workerCount > 1 && taskCount > 1)
 	{
-		for (int x = 0; x < w; ++x)
+		// The trace and simplify time is reported as trace time.
+		ctx->startTimer(RC_TIMER_BUILD_CONTOURS_TRACE);
+		const bool ok = buildContoursParallel(ctx, chf, flags, maxError, maxEdgeLen, buildFlags,
+											  scheduler, taskCount, cset, maxContours);
+		ctx->stopTimer(RC_TIMER_BUILD_CONTOURS_TRACE);
+		if (!ok)
+			return false;
+	}
+	else
+	{
+		rcIntArray verts(256);
+		rcIntArray simplified(64);
+		
+		for (int y = 0; y < h; ++y)
 		{
-			const rcCompactCell& c = chf.cells[x+y*w];
-			for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
+			for (int x = 0; x < w; ++x)
 			{
-				if (flags[i] == 0 || flags[i] == 0xf)
+				const rcCompactCell& c = chf.cells[x+y*w];
+				for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
 				{
-					flags[i] = 0;
-					continue;
-				}
-				const unsigned short reg = chf.spans[i].reg;
-				if (!reg || (reg & RC_BORDER_REG))
-					continue;
-				const unsigned char area = chf.areas[i];
-				
-				verts.resize(0);
-				simplified.resize(0);
-				
-				ctx->startTimer(RC_TIMER_BUILD_CONTOURS_TRACE);
-				walkContour(x, y, i, chf, flags, verts);
-				ctx->stopTimer(RC_TIMER_BUILD_CONTOURS_TRACE);
-				
-				ctx->startTimer(RC_TIMER_BUILD_CONTOURS_SIMPLIFY);
-				simplifyContour(verts, simplified, maxError, maxEdgeLen, buildFlags);
-				removeDegenerateSegments(simplified);
-				ctx->stopTimer(RC_TIMER_BUILD_CONTOURS_SIMPLIFY);
-				
-				
-				// Store region->contour remap info.
-				// Create contour.
-				if (simplified.size()/4 >= 3)
-				{
-					if (cset.nconts >= maxContours)
+					if (flags[i] == 0 || flags[i] == 0xf)
 					{
-						// Allocate more contours.
-						// This happens when a region has holes.
-						const int oldMax = maxContours;
-						maxContours *= 2;
-						rcContour* newConts = (rcContour*)rcAlloc(sizeof(rcContour)*maxContours, RC_ALLOC_PERM);
-						for (int j = 0; j < cset.nconts; ++j)
-						{
-							newConts[j] = cset.conts[j];
-							// Reset source pointers to prevent data deletion.
-							cset.conts[j].verts = 0;
-							cset.conts[j].rverts = 0;
-						}
-						rcFree(cset.conts);
-						cset.conts = newConts;
-						
-						ctx->log(RC_LOG_WARNING, "rcBuildContours: Expanding max contours from %d to %d.", oldMax, maxContours);
+						flags[i] = 0;
+						continue;
 					}
+					const unsigned short reg = chf.spans[i].reg;
+					if (!reg || (reg & RC_BORDER_REG))
+						continue;
+					const unsigned char area = chf.areas[i];
 					
-					rcContour* cont = &cset.conts[cset.nconts++];
+					verts.resize(0);
+					simplified.resize(0);
 					
-					cont->nverts = simplified.size()/4;
-					cont->verts = (int*)rcAlloc(sizeof(int)*cont->nverts*4, RC_ALLOC_PERM);
-					if (!cont->verts)
-					{
-						ctx->log(RC_LOG_ERROR, "rcBuildContours: Out of memory 'verts' (%d).", cont->nverts);
-						return false;
-					}
-					memcpy(cont->verts, &simplified[0], sizeof(int)*cont->nverts*4);
-					if (borderSize > 0)
+					ctx->startTimer(RC_TIMER_BUILD_CONTOURS_TRACE);
+					walkContour(x, y, i, chf, flags, verts);
+					ctx->stopTimer(RC_TIMER_BUILD_CONTOURS_TRACE);
+					
+					ctx->startTimer(RC_TIMER_BUILD_CONTOURS_SIMPLIFY);
+					simplifyContour(verts, simplified, maxError, maxEdgeLen, buildFlags);
+					removeDegenerateSegments(simplified);
+					ctx->stopTimer(RC_TIMER_BUILD_CONTOURS_SIMPLIFY);
+					
+					
+					// Store region->contour remap info.
+					// Create contour.
+					if (simplified.size()/4 >= 3)
 					{
-						// If the heightfield was build with bordersize, remove the offset.
-						for (int j = 0; j < cont->nverts; ++j)
+						if (cset.nconts >= maxContours)
 						{
-							int* v = &cont->verts[j*4];
-							v[0] -= borderSize;
-							v[2] -= borderSize;
+							// Allocate more contours.
+							// This happens when a region has holes.
+							const int oldMax = maxContours;
+							maxContours *= 2;
+							rcContour* newConts = (rcContour*)rcAlloc(sizeof(rcContour)*maxContours, RC_ALLOC_PERM, RC_ALLOC_TAG_CONTOURS);
+							for (int j = 0; j < cset.nconts; ++j)
+							{
+								newConts[j] = cset.conts[j];
+								// Reset source pointers to prevent data deletion.
+								cset.conts[j].verts = 0;
+								cset.conts[j].rverts = 0;
+							}
+							rcFree(cset.conts);
+							cset.conts = newConts;
+							
+							ctx->log(RC_LOG_WARNING, "rcBuildContours: Expanding max contours from %d to %d.", oldMax, maxContours);
 						}
-					}
-					
-					cont->nrverts = verts.size()/4;
-					cont->rverts = (int*)rcAlloc(sizeof(int)*cont->nrverts*4, RC_ALLOC_PERM);
-					if (!cont->rverts)
-					{
-						ctx->log(RC_LOG_ERROR, "rcBuildContours: Out of memory 'rverts' (%d).", cont->nrverts);
-						return false;
-					}
-					memcpy(cont->rverts, &verts[0], sizeof(int)*cont->nrverts*4);
-					if (borderSize > 0)
-					{
-						// If the heightfield was build with bordersize, remove the offset.
-						for (int j = 0; j < cont->nrverts; ++j)
+						
+						rcContour* cont = &cset.conts[cset.nconts++];
+						
+						if (!copyContourVerts(simplified, borderSize, cont->verts, cont->nverts))
 						{
-							int* v = &cont->rverts[j*4];
-							v[0] -= borderSize;
-							v[2] -= borderSize;
+							ctx->log(RC_LOG_ERROR, "rcBuildContours: Out of memory 'verts' (%d).", simplified.size()/4);
+							return false;
 						}
+						if (!copyContourVerts(verts, borderSize, cont->rverts, cont->nrverts))
+						{
+							ctx->log(RC_LOG_ERROR, "rcBuildContours: Out of memory 'rverts' (%d).", verts.size()/4);
+							return false;
+						}
+						
+						cont->reg = reg;
+						cont->area = area;
 					}
-					
-					cont->reg = reg;
-					cont->area = area;
 				}
 			}
 		}
@@ -23,6 +23,7 @@
 #include "Recast.h"
 #include "RecastAlloc.h"
 #include "RecastAssert.h"
+#include "RecastTaskScheduler.h"
 
 struct rcEdge
 {
@@ -125,13 +126,13 @@ static bool buildMeshAdjacency(unsigned short* polys, const int npolys,
 
 static const int VERTEX_BUCKET_COUNT = (1<<12);
 
-inline int computeVertexHash(int x, int y, int z)
+inline int computeVertexHash(int x, int y, int z, const int bucketMask = VERTEX_BUCKET_COUNT-1)
 {
 	const unsigned int h1 = 0x8da6b343; // Large multiplicative constants;
 	const unsigned int h2 = 0xd8163841; // here arbitrarily chosen primes
 	const unsigned int h3 = 0xcb1ab31f;
 	unsigned int n = h1 * x + h2 * y + h3 * z;
-	return (int)(n & (VERTEX_BUCKET_COUNT-1));
+	return (int)(n & bucketMask);
 }
 
 static unsigned short addVertex(unsigned short x, unsigned short y, unsigned short z,
@@ -1017,25 +1018,25 @@ bool rcBuildPolyMesh(rcContext* ctx, rcContourSet& cset, const int nvp, rcPolyMe
 	}
 	memset(vflags, 0, maxVertices);
 	
-	mesh.verts = (unsigned short*)rcAlloc(sizeof(unsigned short)*maxVertices*3, RC_ALLOC_PERM);
+	mesh.verts = (unsigned short*)rcAlloc(sizeof(unsigned short)*maxVertices*3, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH);
 	if (!mesh.verts)
 	{
 		ctx->log(RC_LOG_ERROR, "rcBuildPolyMesh: Out of memory 'mesh.verts' (%d).", maxVertices);
 		return false;
 	}
-	mesh.polys = (unsigned short*)rcAlloc(sizeof(unsigned short)*maxTris*nvp*2, RC_ALLOC_PERM);
+	mesh.polys = (unsigned short*)rcAlloc(sizeof(unsigned short)*maxTris*nvp*2, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH);
 	if (!mesh.polys)
 	{
 		ctx->log(RC_LOG_ERROR, "rcBuildPolyMesh: Out of memory 'mesh.polys' (%d).", maxTris*nvp*2);
 		return false;
 	}
-	mesh.regs = (unsigned short*)rcAlloc(sizeof(unsigned short)*maxTris, RC_ALLOC_PERM);
+	mesh.regs = (unsigned short*)rcAlloc(sizeof(unsigned short)*maxTris, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH);
 	if (!mesh.regs)
 	{
 		ctx->log(RC_LOG_ERROR, "rcBuildPolyMesh: Out of memory 'mesh.regs' (%d).", maxTris);
 		return false;
 	}
-	mesh.areas = (unsigned char*)rcAlloc(sizeof(unsigned char)*maxTris, RC_ALLOC_PERM);
+	mesh.areas = (unsigned char*)rcAlloc(sizeof(unsigned char)*maxTris, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH);
 	if (!mesh.areas)
 	{
 		ctx->log(RC_LOG_ERROR, "rcBuildPolyMesh: Out of memory 'mesh.areas' (%d).", maxTris);
@@ -1276,7 +1277,7 @@ bool rcBuildPolyMesh(rcContext* ctx, rcContourSet& cset, const int nvp, rcPolyMe
 	}
 
 	// Just allocate the mesh flags array. The user is resposible to fill it.
-	mesh.flags = (unsigned short*)rcAlloc(sizeof(unsigned short)*mesh.npolys, RC_ALLOC_PERM);
+	mesh.flags = (unsigned short*)rcAlloc(sizeof(unsigned short)*mesh.npolys, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH);
 	if (!mesh.flags)
 	{
 		ctx->log(RC_LOG_ERROR, "rcBuildPolyMesh: Out of memory 'mesh.flags' (%d).", mesh.npolys);
@@ -1298,8 +1299,170 @@ bool rcBuildPolyMesh(rcContext* ctx, rcContourSet& cset, const int nvp, rcPolyMe
 	return true;
 }
 
+// The fewest vertices worth merging in parallel.
+static const int RC_MERGE_MIN_PARALLEL_VERTS = 4096;
+
+struct rcMergeJob
+{
+	rcPolyMesh** meshes;
+	rcPolyMesh* mesh;
+	const int* vertBase;		// The first input vertex of each mesh. [Size: nmeshes+1]
+	const int* polyBase;		// The first merged polygon of each mesh. [Size: nmeshes]
+	unsigned short* inVerts;	// The input vertices, offset to the merged mesh.
+	int* buckets;				// The hash bucket of each input vertex.
+	int* firstVert;
+	int* nextVert;
+	int* remap;					// The welded input vertex, later the merged vertex.
+	int nverts;
+	int bucketMask;
+	int bucketsPerTask;
+};
+
+static void getMergeOffset(const rcPolyMesh& mesh, const rcPolyMesh& pmesh,
+						   unsigned short& ox, unsigned short& oz)
+{
+	ox = (unsigned short)floorf((pmesh.bmin[0]-mesh.bmin[0])/mesh.cs+0.5f);
+	oz = (unsigned short)floorf((pmesh.bmin[2]-mesh.bmin[2])/mesh.cs+0.5f);
+}
+
+static void offsetMergeVertsTask(void* userData, int taskIndex, int /*workerIndex*/)
+{
+	rcMergeJob& job = *(rcMergeJob*)userData;
+	const rcPolyMesh* pmesh = job.meshes[taskIndex];
+	unsigned short ox, oz;
+	getMergeOffset(*job.mesh, *pmesh, ox, oz);
+	
+	const int base = job.vertBase[taskIndex];
+	for (int j = 0; j < pmesh->nverts; ++j)
+	{
+		const unsigned short* v = &pmesh->verts[j*3];
+		unsigned short* dst = &job.inVerts[(base+j)*3];
+		dst[0] = (unsigned short)(v[0]+ox);
+		dst[1] = v[1];
+		dst[2] = (unsigned short)(v[2]+oz);
+		job.buckets[base+j] = computeVertexHash(dst[0], 0, dst[2], job.bucketMask);
+	}
+}
+
+// Welds the input vertices that hash to the task's bucket range.  Vertices
+// can only weld to vertices in the same bucket, so the ranges are independent.
+static void weldMergeVertsTask(void* userData, int taskIndex, int /*workerIndex*/)
+{
+	rcMergeJob& job = *(rcMergeJob*)userData;
+	const int b0 = taskIndex * job.bucketsPerTask;
+	const int b1 = b0 + job.bucketsPerTask;
+	
+	for (int g = 0; g < job.nverts; ++g)
+	{
+		const int bucket = job.buckets[g];
+		if (bucket < b0 || bucket >= b1)
+			continue;
+		
+		const unsigned short* p = &job.inVerts[g*3];
+		int i = job.firstVert[bucket];
+		while (i != -1)
+		{
+			const unsigned short* v = &job.inVerts[i*3];
+			if (v[0] == p[0] && (rcAbs(v[1] - p[1]) <= 2) && v[2] == p[2])
+				break;
+			i = job.nextVert[i];
+		}
+		
+		if (i == -1)
+		{
+			// New vertex.
+			i = g;
+			job.nextVert[g] = job.firstVert[bucket];
+			job.firstVert[bucket] = g;
+		}
+		job.remap[g] = i;
+	}
+}
+
+static void copyMergePolysTask(void* userData, int taskIndex, int /*workerIndex*/)
+{
+	rcMergeJob& job = *(rcMergeJob*)userData;
+	rcPolyMesh& mesh = *job.mesh;
+	const rcPolyMesh* pmesh = job.meshes[taskIndex];
+	
+	unsigned short ox, oz;
+	getMergeOffset(mesh, *pmesh, ox, oz);
+	
+	bool isMinX = (ox == 0);
+	bool isMinZ = (oz == 0);
+	bool isMaxX = ((unsigned short)floorf((mesh.bmax[0] - pmesh->bmax[0]) / mesh.cs + 0.5f)) == 0;
+	bool isMaxZ = ((unsigned short)floorf((mesh.bmax[2] - pmesh->bmax[2]) / mesh.cs + 0.5f)) == 0;
+	bool isOnBorder = (isMinX || isMinZ || isMaxX || isMaxZ);
+	
+	const int* vremap = &job.remap[job.vertBase[taskIndex]];
+	const int polyBase = job.polyBase[taskIndex];
+	
+	for (int j = 0; j < pmesh->npolys; ++j)
+	{
+		unsigned short* tgt = &mesh.polys[(polyBase+j)*2*mesh.nvp];
+		unsigned short* src = &pmesh->polys[j*2*mesh.nvp];
+		mesh.regs[polyBase+j] = pmesh->regs[j];
+		mesh.areas[polyBase+j] = pmesh->areas[j];
+		mesh.flags[polyBase+j] = pmesh->flags[j];
+		for (int k = 0; k < mesh.nvp; ++k)
+		{
+			if (src[k] == RC_MESH_NULL_IDX) break;
+			tgt[k] = (unsigned short)vremap[src[k]];
+		}
+		
+		if (isOnBorder)
+		{
+			for (int k = mesh.nvp; k < mesh.nvp * 2; ++k)
+			{
+				if (src[k] & 0x8000 && src[k] != 0xffff)
+				{
+					unsigned short dir = src[k] & 0xf;
+					switch (dir)
+					{
+						case 0: // Portal x-
+							if (isMinX)
+								tgt[k] = src[k];
+							break;
+						case 1: // Portal z+
+							if (isMaxZ)
+								tgt[k] = src[k];
+							break;
+						case 2: // Portal x+
+							if (isMaxX)
+								tgt[k] = src[k];
+							break;
+						case 3: // Portal z-
+							if (isMinZ)
+								tgt[k] = src[k];
+							break;
+					}
+				}
+			}
+		}
+	}
+}
+
+static void runMergeTasks(rcTaskScheduler* scheduler, rcTaskFunc func, rcMergeJob& job, const int taskCount)
+{
+	if (scheduler)
+	{
+		scheduler->parallelFor(func, &job, taskCount);
+		return;
+	}
+	for (int i = 0; i < taskCount; ++i)
+		func(&job, i, 0);
+}
+
+/// @par
+///
+/// The vertex hash is sized from the total vertex count.  If a scheduler is provided
+/// and the meshes are large enough, the vertex offsetting, the welding (split by hash 
+/// bucket range) and the polygon copies run in parallel.  Vertices are numbered in 
+/// input order in all cases, so the result does not depend on the scheduler.
+///
 /// @see rcAllocPolyMesh, rcPolyMesh
-bool rcMergePolyMeshes(rcContext* ctx, rcPolyMesh** meshes, const int nmeshes, rcPolyMesh& mesh)
+bool rcMergePolyMeshes(rcContext* ctx, rcPolyMesh** meshes, const int nmeshes, rcPolyMesh& mesh,
+					   rcTaskScheduler* scheduler)
 {
 	rcAssert(ctx);
 	
@@ -1316,18 +1479,16 @@ bool rcMergePolyMeshes(rcContext* ctx, rcPolyMesh** meshes, const int nmeshes, r
 
 	int maxVerts = 0;
 	int maxPolys = 0;
-	int maxVertsPerMesh = 0;
 	for (int i = 0; i < nmeshes; ++i)
 	{
 		rcVmin(mesh.bmin, meshes[i]->bmin);
 		rcVmax(mesh.bmax, meshes[i]->bmax);
-		maxVertsPerMesh = rcMax(maxVertsPerMesh, meshes[i]->nverts);
 		maxVerts += meshes[i]->nverts;
 		maxPolys += meshes[i]->npolys;
 	}
 	
 	mesh.nverts = 0;
-	mesh.verts = (unsigned short*)rcAlloc(sizeof(unsigned short)*maxVerts*3, RC_ALLOC_PERM);
+	mesh.verts = (unsigned short*)rcAlloc(sizeof(unsigned short)*maxVerts*3, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH);
 	if (!mesh.verts)
 	{
 		ctx->log(RC_LOG_ERROR, "rcMergePolyMeshes: Out of memory 'mesh.verts' (%d).", maxVerts*3);
@@ -1335,7 +1496,7 @@ bool rcMergePolyMeshes(rcContext* ctx, rcPolyMesh** meshes, const int nmeshes, r
 	}
 
 	mesh.npolys = 0;
-	mesh.polys = (unsigned short*)rcAlloc(sizeof(unsigned short)*maxPolys*2*mesh.nvp, RC_ALLOC_PERM);
+	mesh.polys = (unsigned short*)rcAlloc(sizeof(unsigned short)*maxPolys*2*mesh.nvp, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH);
 	if (!mesh.polys)
 	{
 		ctx->log(RC_LOG_ERROR, "rcMergePolyMeshes: Out of memory 'mesh.polys' (%d).", maxPolys*2*mesh.nvp);
@@ -1343,7 +1504,7 @@ bool rcMergePolyMeshes(rcContext* ctx, rcPolyMesh** meshes, const int nmeshes, r
 	}
 	memset(mesh.polys, 0xff, sizeof(unsigned short)*maxPolys*2*mesh.nvp);
 
-	mesh.regs = (unsigned short*)rcAlloc(sizeof(unsigned short)*maxPolys, RC_ALLOC_PERM);
+	mesh.regs = (unsigned short*)rcAlloc(sizeof(unsigned short)*maxPolys, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH);
 	if (!mesh.regs)
 	{
 		ctx->log(RC_LOG_ERROR, "rcMergePolyMeshes: Out of memory 'mesh.regs' (%d).", maxPolys);
@@ -1351,7 +1512,7 @@ bool rcMergePolyMeshes(rcContext* ctx, rcPolyMesh** meshes, const int nmeshes, r
 	}
 	memset(mesh.regs, 0, sizeof(unsigned short)*maxPolys);
 
-	mesh.areas = (unsigned char*)rcAlloc(sizeof(unsigned char)*maxPolys, RC_ALLOC_PERM);
+	mesh.areas = (unsigned char*)rcAlloc(sizeof(unsigned char)*maxPolys, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH);
 	if (!mesh.areas)
 	{
 		ctx->log(RC_LOG_ERROR, "rcMergePolyMeshes: Out of memory 'mesh.areas' (%d).", maxPolys);
@@ -1359,7 +1520,7 @@ bool rcMergePolyMeshes(rcContext* ctx, rcPolyMesh** meshes, const int nmeshes, r
 	}
 	memset(mesh.areas, 0, sizeof(unsigned char)*maxPolys);
 
-	mesh.flags = (unsigned short*)rcAlloc(sizeof(unsigned short)*maxPolys, RC_ALLOC_PERM);
+	mesh.flags = (unsigned short*)rcAlloc(sizeof(unsigned short)*maxPolys, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH);
 	if (!mesh.flags)
 	{
 		ctx->log(RC_LOG_ERROR, "rcMergePolyMeshes: Out of memory 'mesh.flags' (%d).", maxPolys);
@@ -1367,96 +1528,81 @@ bool rcMergePolyMeshes(rcContext* ctx, rcPolyMesh** meshes, const int nmeshes, r
 	}
 	memset(mesh.flags, 0, sizeof(unsigned short)*maxPolys);
 	
-	rcScopedDelete<int> nextVert = (int*)rcAlloc(sizeof(int)*maxVerts, RC_ALLOC_TEMP);
-	if (!nextVert)
-	{
-		ctx->log(RC_LOG_ERROR, "rcMergePolyMeshes: Out of memory 'nextVert' (%d).", maxVerts);
-		return false;
-	}
-	memset(nextVert, 0, sizeof(int)*maxVerts);
+	int bucketCount = VERTEX_BUCKET_COUNT;
+	while (bucketCount < maxVerts)
+		bucketCount *= 2;
 	
-	rcScopedDelete<int> firstVert = (int*)rcAlloc(sizeof(int)*VERTEX_BUCKET_COUNT, RC_ALLOC_TEMP);
-	if (!firstVert)
+	// All of the scratch arrays share one allocation.
+	const int scratchInts = maxVerts*3 + bucketCount + nmeshes*2+1;
+	const int scratchShorts = maxVerts*3;
+	rcScopedDelete<int> scratch = (int*)rcAlloc(sizeof(int)*scratchInts + sizeof(unsigned short)*scratchShorts, RC_ALLOC_TEMP);
+	if (!scratch)
 	{
-		ctx->log(RC_LOG_ERROR, "rcMergePolyMeshes: Out of memory 'firstVert' (%d).", VERTEX_BUCKET_COUNT);
+		ctx->log(RC_LOG_ERROR, "rcMergePolyMeshes: Out of memory 'scratch' (%d).", scratchInts);
 		return false;
 	}
-	for (int i = 0; i < VERTEX_BUCKET_COUNT; ++i)
+	int* buckets = scratch;
+	int* nextVert = buckets + maxVerts;
+	int* remap = nextVert + maxVerts;
+	int* firstVert = remap + maxVerts;
+	int* vertBase = firstVert + bucketCount;
+	int* polyBase = vertBase + nmeshes+1;
+	unsigned short* inVerts = (unsigned short*)(polyBase + nmeshes);
+	
+	for (int i = 0; i < bucketCount; ++i)
 		firstVert[i] = -1;
-
-	rcScopedDelete<unsigned short> vremap = (unsigned short*)rcAlloc(sizeof(unsigned short)*maxVertsPerMesh, RC_ALLOC_PERM);
-	if (!vremap)
+	
+	vertBase[0] = 0;
+	for (int i = 0; i < nmeshes; ++i)
 	{
-		ctx->log(RC_LOG_ERROR, "rcMergePolyMeshes: Out of memory 'vremap' (%d).", maxVertsPerMesh);
-		return false;
+		vertBase[i+1] = vertBase[i] + meshes[i]->nverts;
+		polyBase[i] = i > 0 ? polyBase[i-1] + meshes[i-1]->npolys : 0;
 	}
-	memset(vremap, 0, sizeof(unsigned short)*maxVertsPerMesh);
 	
-	for (int i = 0; i < nmeshes; ++i)
+	rcMergeJob job;
+	job.meshes = meshes;
+	job.mesh = &mesh;
+	job.vertBase = vertBase;
+	job.polyBase = polyBase;
+	job.inVerts = inVerts;
+	job.buckets = buckets;
+	job.firstVert = firstVert;
+	job.nextVert = nextVert;
+	job.remap = remap;
+	job.nverts = maxVerts;
+	job.bucketMask = bucketCount-1;
+	
+	const int workerCount = scheduler ? scheduler->getWorkerCount() : 1;
+	if (workerCount < 2 || maxVerts < RC_MERGE_MIN_PARALLEL_VERTS)
+		scheduler = 0;
+	
+	runMergeTasks(scheduler, offsetMergeVertsTask, job, nmeshes);
+	
+	// Each task scans all of the vertices, so use one task per worker.
+	const int weldTaskCount = scheduler ? workerCount : 1;
+	job.bucketsPerTask = (bucketCount + weldTaskCount-1) / weldTaskCount;
+	runMergeTasks(scheduler, weldMergeVertsTask, job, weldTaskCount);
+	
+	// Number the welded vertices in input order.
+	for (int g = 0; g < maxVerts; ++g)
 	{
-		const rcPolyMesh* pmesh = meshes[i];
-		
-		const unsigned short ox = (unsigned short)floorf((pmesh->bmin[0]-mesh.bmin[0])/mesh.cs+0.5f);
-		const unsigned short oz = (unsigned short)floorf((pmesh->bmin[2]-mesh.bmin[2])/mesh.cs+0.5f);
-		
-		bool isMinX = (ox == 0);
-		bool isMinZ = (oz == 0);
-		bool isMaxX = ((unsigned short)floorf((mesh.bmax[0] - pmesh->bmax[0]) / mesh.cs + 0.5f)) == 0;
-		bool isMaxZ = ((unsigned short)floorf((mesh.bmax[2] - pmesh->bmax[2]) / mesh.cs + 0.5f)) == 0;
-		bool isOnBorder = (isMinX || isMinZ || isMaxX || isMaxZ);
-
-		for (int j = 0; j < pmesh->nverts; ++j)
+		if (remap[g] == g)
 		{
-			unsigned short* v = &pmesh->verts[j*3];
-			vremap[j] = addVertex(v[0]+ox, v[1], v[2]+oz,
-								  mesh.verts, firstVert, nextVert, mesh.nverts);
+			const unsigned short* v = &inVerts[g*3];
+			unsigned short* dst = &mesh.verts[mesh.nverts*3];
+			dst[0] = v[0];
+			dst[1] = v[1];
+			dst[2] = v[2];
+			remap[g] = mesh.nverts++;
 		}
-		
-		for (int j = 0; j < pmesh->npolys; ++j)
+		else
 		{
-			unsigned short* tgt = &mesh.polys[mesh.npolys*2*mesh.nvp];
-			unsigned short* src = &pmesh->polys[j*2*mesh.nvp];
-			mesh.regs[mesh.npolys] = pmesh->regs[j];
-			mesh.areas[mesh.npolys] = pmesh->areas[j];
-			mesh.flags[mesh.npolys] = pmesh->flags[j];
-			mesh.npolys++;
-			for (int k = 0; k < mesh.nvp; ++k)
-			{
-				if (src[k] == RC_MESH_NULL_IDX) break;
-				tgt[k] = vremap[src[k]];
-			}
-
-			if (isOnBorder)
-			{
-				for (int k = mesh.nvp; k < mesh.nvp * 2; ++k)
-				{
-					if (src[k] & 0x8000 && src[k] != 0xffff)
-					{
-						unsigned short dir = src[k] & 0xf;
-						switch (dir)
-						{
-							case 0: // Portal x-
-								if (isMinX)
-									tgt[k] = src[k];
-								break;
-							case 1: // Portal z+
-								if (isMaxZ)
-									tgt[k] = src[k];
-								break;
-							case 2: // Portal x+
-								if (isMaxX)
-									tgt[k] = src[k];
-								break;
-							case 3: // Portal z-
-								if (isMinZ)
-									tgt[k] = src[k];
-								break;
-						}
-					}
-				}
-			}
+			remap[g] = remap[remap[g]];
 		}
 	}
+	
+	runMergeTasks(scheduler, copyMergePolysTask, job, nmeshes);
+	mesh.npolys = maxPolys;
 
 	// Calculate adjacency.
 	if (!buildMeshAdjacency(mesh.polys, mesh.npolys, mesh.nverts, mesh.nvp))
@@ -1500,7 +1646,7 @@ bool rcCopyPolyMesh(rcContext* ctx, const rcPolyMesh& src, rcPolyMesh& dst)
 	dst.ch = src.ch;
 	dst.borderSize = src.borderSize;
 	
-	dst.verts = (unsigned short*)rcAlloc(sizeof(unsigned short)*src.nverts*3, RC_ALLOC_PERM);
+	dst.verts = (unsigned short*)rcAlloc(sizeof(unsigned short)*src.nverts*3, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH);
 	if (!dst.verts)
 	{
 		ctx->log(RC_LOG_ERROR, "rcCopyPolyMesh: Out of memory 'dst.verts' (%d).", src.nverts*3);
@@ -1508,7 +1654,7 @@ bool rcCopyPolyMesh(rcContext* ctx, const rcPolyMesh& src, rcPolyMesh& dst)
 	}
 	memcpy(dst.verts, src.verts, sizeof(unsigned short)*src.nverts*3);
 	
-	dst.polys = (unsigned short*)rcAlloc(sizeof(unsigned short)*src.npolys*2*src.nvp, RC_ALLOC_PERM);
+	dst.polys = (unsigned short*)rcAlloc(sizeof(unsigned short)*src.npolys*2*src.nvp, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH);
 	if (!dst.polys)
 	{
 		ctx->log(RC_LOG_ERROR, "rcCopyPolyMesh: Out of memory 'dst.polys' (%d).", src.npolys*2*src.nvp);
@@ -1516,7 +1662,7 @@ bool rcCopyPolyMesh(rcContext* ctx, const rcPolyMesh& src, rcPolyMesh& dst)
 	}
 	memcpy(dst.polys, src.polys, sizeof(unsigned short)*src.npolys*2*src.nvp);
 	
-	dst.regs = (unsigned short*)rcAlloc(sizeof(unsigned short)*src.npolys, RC_ALLOC_PERM);
+	dst.regs = (unsigned short*)rcAlloc(sizeof(unsigned short)*src.npolys, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH);
 	if (!dst.regs)
 	{
 		ctx->log(RC_LOG_ERROR, "rcCopyPolyMesh: Out of memory 'dst.regs' (%d).", src.npolys);
@@ -1524,7 +1670,7 @@ bool rcCopyPolyMesh(rcContext* ctx, const rcPolyMesh& src, rcPolyMesh& dst)
 	}
 	memcpy(dst.regs, src.regs, sizeof(unsigned short)*src.npolys);
 	
-	dst.areas = (unsigned char*)rcAlloc(sizeof(unsigned char)*src.npolys, RC_ALLOC_PERM);
+	dst.areas = (unsigned char*)rcAlloc(sizeof(unsigned char)*src.npolys, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH);
 	if (!dst.areas)
 	{
 		ctx->log(RC_LOG_ERROR, "rcCopyPolyMesh: Out of memory 'dst.areas' (%d).", src.npolys);
@@ -1532,7 +1678,7 @@ bool rcCopyPolyMesh(rcContext* ctx, const rcPolyMesh& src, rcPolyMesh& dst)
 	}
 	memcpy(dst.areas, src.areas, sizeof(unsigned char)*src.npolys);
 	
-	dst.flags = (unsigned short*)rcAlloc(sizeof(unsigned short)*src.npolys, RC_ALLOC_PERM);
+	dst.flags = (unsigned short*)rcAlloc(sizeof(unsigned short)*src.npolys, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH);
 	if (!dst.flags)
 	{
 		ctx->log(RC_LOG_ERROR, "rcCopyPolyMesh: Out of memory 'dst.flags' (%d).", src.npolys);
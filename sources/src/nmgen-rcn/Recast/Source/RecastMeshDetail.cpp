@@ -25,6 +25,7 @@
 #include "Recast.h"
 #include "RecastAlloc.h"
 #include "RecastAssert.h"
+#include "RecastTaskScheduler.h"
 
 
 static const unsigned RC_UNSET_HEIGHT = 0xffff;
@@ -1109,22 +1110,80 @@ static unsigned char getTriFlags(const float* va, const float* vb, const float*
 	return flags;
 }
 
-/// @par
-///
-/// See the #rcConfig documentation for more information on the configuration parameters.
-///
-/// @see rcAllocPolyMeshDetail, rcPolyMesh, rcCompactHeightfield, rcPolyMeshDetail, rcConfig
-bool rcBuildPolyMeshDetail(rcContext* ctx, const rcPolyMesh& mesh, const rcCompactHeightfield& chf,
-						   const float sampleDist, const float sampleMaxError,
-						   rcPolyMeshDetail& dmesh)
+// The log text a detail task can hold.  Later messages are dropped.
+static const int RC_DETAIL_LOG_SIZE = 1024;
+
+// The fewest polygons worth a separate detail task.
+static const int RC_DETAIL_MIN_TASK_POLYS = 8;
+
+// The detail meshes of a contiguous range of polygons.
+struct rcDetailChunk
 {
-	rcAssert(ctx);
-	
-	ctx->startTimer(RC_TIMER_BUILD_POLYMESHDETAIL);
+	int polyStart, polyEnd;
+	float* verts;
+	int nverts, vcap;
+	unsigned char* tris;
+	int ntris, tcap;
+	bool failed;
+	int logSize;
+	char log[RC_DETAIL_LOG_SIZE];	// (category, message, '\0') entries.
+};
+
+struct rcDetailJob
+{
+	const rcPolyMesh* mesh;
+	const rcCompactHeightfield* chf;
+	float sampleDist;
+	float sampleMaxError;
+	const int* bounds;
+	int maxhw, maxhh;
+	unsigned int* meshes;
+	rcDetailChunk* chunks;
+};
+
+// Records the messages logged by a detail task so that the calling thread
+// can replay them in polygon order.
+class rcDetailTaskContext : public rcContext
+{
+public:
+	inline rcDetailTaskContext(rcDetailChunk* chunk) : rcContext(true), m_chunk(chunk) {}
 	
-	if (mesh.nverts == 0 || mesh.npolys == 0)
-		return true;
+protected:
+	virtual void doLog(const rcLogCategory category, const char* msg, const int len)
+	{
+		if (m_chunk->logSize + len + 2 > RC_DETAIL_LOG_SIZE)
+			return;
+		char* dst = &m_chunk->log[m_chunk->logSize];
+		dst[0] = (char)category;
+		memcpy(dst+1, msg, len);
+		dst[len+1] = '\0';
+		m_chunk->logSize += len + 2;
+	}
 	
+private:
+	rcDetailChunk* m_chunk;
+};
+
+static void initDetailChunk(rcDetailChunk& chunk, const int polyStart, const int polyEnd)
+{
+	chunk.polyStart = polyStart;
+	chunk.polyEnd = polyEnd;
+	chunk.verts = 0;
+	chunk.nverts = 0;
+	chunk.vcap = 0;
+	chunk.tris = 0;
+	chunk.ntris = 0;
+	chunk.tcap = 0;
+	chunk.failed = false;
+	chunk.logSize = 0;
+}
+
+// Builds the detail meshes of the chunk's polygons.  The sub-mesh offsets
+// stored in the job's mesh array are relative to the chunk's buffers.
+static bool buildDetailChunk(rcContext* ctx, const rcDetailJob& job, rcDetailChunk& chunk)
+{
+	const rcPolyMesh& mesh = *job.mesh;
+	const rcCompactHeightfield& chf = *job.chf;
 	const int nvp = mesh.nvp;
 	const float cs = mesh.cs;
 	const float ch = mesh.ch;
@@ -1138,14 +1197,7 @@ bool rcBuildPolyMeshDetail(rcContext* ctx, const rcPolyMesh& mesh, const rcCompa
 	float verts[256*3];
 	rcHeightPatch hp;
 	int nPolyVerts = 0;
-	int maxhw = 0, maxhh = 0;
 	
-	rcScopedDelete<int> bounds = (int*)rcAlloc(sizeof(int)*mesh.npolys*4, RC_ALLOC_TEMP);
-	if (!bounds)
-	{
-		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'bounds' (%d).", mesh.npolys*4);
-		return false;
-	}
 	rcScopedDelete<float> poly = (float*)rcAlloc(sizeof(float)*nvp*3, RC_ALLOC_TEMP);
 	if (!poly)
 	{
@@ -1153,73 +1205,42 @@ bool rcBuildPolyMeshDetail(rcContext* ctx, const rcPolyMesh& mesh, const rcCompa
 		return false;
 	}
 	
-	// Find max size for a polygon area.
-	for (int i = 0; i < mesh.npolys; ++i)
+	hp.data = (unsigned short*)rcAlloc(sizeof(unsigned short)*job.maxhw*job.maxhh, RC_ALLOC_TEMP);
+	if (!hp.data)
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'hp.data' (%d).", job.maxhw*job.maxhh);
+		return false;
+	}
+	
+	for (int i = chunk.polyStart; i < chunk.polyEnd; ++i)
 	{
 		const unsigned short* p = &mesh.polys[i*nvp*2];
-		int& xmin = bounds[i*4+0];
-		int& xmax = bounds[i*4+1];
-		int& ymin = bounds[i*4+2];
-		int& ymax = bounds[i*4+3];
-		xmin = chf.width;
-		xmax = 0;
-		ymin = chf.height;
-		ymax = 0;
 		for (int j = 0; j < nvp; ++j)
 		{
 			if(p[j] == RC_MESH_NULL_IDX) break;
-			const unsigned short* v = &mesh.verts[p[j]*3];
-			xmin = rcMin(xmin, (int)v[0]);
-			xmax = rcMax(xmax, (int)v[0]);
-			ymin = rcMin(ymin, (int)v[2]);
-			ymax = rcMax(ymax, (int)v[2]);
 			nPolyVerts++;
 		}
-		xmin = rcMax(0,xmin-1);
-		xmax = rcMin(chf.width,xmax+1);
-		ymin = rcMax(0,ymin-1);
-		ymax = rcMin(chf.height,ymax+1);
-		if (xmin >= xmax || ymin >= ymax) continue;
-		maxhw = rcMax(maxhw, xmax-xmin);
-		maxhh = rcMax(maxhh, ymax-ymin);
-	}
-	
-	hp.data = (unsigned short*)rcAlloc(sizeof(unsigned short)*maxhw*maxhh, RC_ALLOC_TEMP);
-	if (!hp.data)
-	{
-		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'hp.data' (%d).", maxhw*maxhh);
-		return false;
-	}
-	
-	dmesh.nmeshes = mesh.npolys;
-	dmesh.nverts = 0;
-	dmesh.ntris = 0;
-	dmesh.meshes = (unsigned int*)rcAlloc(sizeof(unsigned int)*dmesh.nmeshes*4, RC_ALLOC_PERM);
-	if (!dmesh.meshes)
-	{
-		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'dmesh.meshes' (%d).", dmesh.nmeshes*4);
-		return false;
 	}
 	
-	int vcap = nPolyVerts+nPolyVerts/2;
-	int tcap = vcap*2;
+	int& vcap = chunk.vcap;
+	int& tcap = chunk.tcap;
+	vcap = nPolyVerts+nPolyVerts/2;
+	tcap = vcap*2;
 	
-	dmesh.nverts = 0;
-	dmesh.verts = (float*)rcAlloc(sizeof(float)*vcap*3, RC_ALLOC_PERM);
-	if (!dmesh.verts)
+	chunk.verts = (float*)rcAlloc(sizeof(float)*vcap*3, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH_DETAIL);
+	if (!chunk.verts)
 	{
 		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'dmesh.verts' (%d).", vcap*3);
 		return false;
 	}
-	dmesh.ntris = 0;
-	dmesh.tris = (unsigned char*)rcAlloc(sizeof(unsigned char)*tcap*4, RC_ALLOC_PERM);
-	if (!dmesh.tris)
+	chunk.tris = (unsigned char*)rcAlloc(sizeof(unsigned char)*tcap*4, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH_DETAIL);
+	if (!chunk.tris)
 	{
 		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'dmesh.tris' (%d).", tcap*4);
 		return false;
 	}
 	
-	for (int i = 0; i < mesh.npolys; ++i)
+	for (int i = chunk.polyStart; i < chunk.polyEnd; ++i)
 	{
 		const unsigned short* p = &mesh.polys[i*nvp*2];
 		
@@ -1236,16 +1257,16 @@ bool rcBuildPolyMeshDetail(rcContext* ctx, const rcPolyMesh& mesh, const rcCompa
 		}
 		
 		// Get the height data from the area of the polygon.
-		hp.xmin = bounds[i*4+0];
-		hp.ymin = bounds[i*4+2];
-		hp.width = bounds[i*4+1]-bounds[i*4+0];
-		hp.height = bounds[i*4+3]-bounds[i*4+2];
+		hp.xmin = job.bounds[i*4+0];
+		hp.ymin = job.bounds[i*4+2];
+		hp.width = job.bounds[i*4+1]-job.bounds[i*4+0];
+		hp.height = job.bounds[i*4+3]-job.bounds[i*4+2];
 		getHeightData(chf, p, npoly, mesh.verts, borderSize, hp, stack, mesh.regs[i]);
 		
 		// Build detail mesh.
 		int nverts = 0;
 		if (!buildPolyDetail(ctx, poly, npoly,
-							 sampleDist, sampleMaxError,
+							 job.sampleDist, job.sampleMaxError,
 							 chf, hp, verts, nverts, tris,
 							 edges, samples))
 		{
@@ -1270,63 +1291,251 @@ bool rcBuildPolyMeshDetail(rcContext* ctx, const rcPolyMesh& mesh, const rcCompa
 		// Store detail submesh.
 		const int ntris = tris.size()/4;
 		
-		dmesh.meshes[i*4+0] = (unsigned int)dmesh.nverts;
-		dmesh.meshes[i*4+1] = (unsigned int)nverts;
-		dmesh.meshes[i*4+2] = (unsigned int)dmesh.ntris;
-		dmesh.meshes[i*4+3] = (unsigned int)ntris;
+		job.meshes[i*4+0] = (unsigned int)chunk.nverts;
+		job.meshes[i*4+1] = (unsigned int)nverts;
+		job.meshes[i*4+2] = (unsigned int)chunk.ntris;
+		job.meshes[i*4+3] = (unsigned int)ntris;
 		
 		// Store vertices, allocate more memory if necessary.
-		if (dmesh.nverts+nverts > vcap)
+		if (chunk.nverts+nverts > vcap)
 		{
-			while (dmesh.nverts+nverts > vcap)
+			while (chunk.nverts+nverts > vcap)
 				vcap += 256;
 			
-			float* newv = (float*)rcAlloc(sizeof(float)*vcap*3, RC_ALLOC_PERM);
+			float* newv = (float*)rcAlloc(sizeof(float)*vcap*3, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH_DETAIL);
 			if (!newv)
 			{
 				ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'newv' (%d).", vcap*3);
 				return false;
 			}
-			if (dmesh.nverts)
-				memcpy(newv, dmesh.verts, sizeof(float)*3*dmesh.nverts);
-			rcFree(dmesh.verts);
-			dmesh.verts = newv;
+			if (chunk.nverts)
+				memcpy(newv, chunk.verts, sizeof(float)*3*chunk.nverts);
+			rcFree(chunk.verts);
+			chunk.verts = newv;
 		}
 		for (int j = 0; j < nverts; ++j)
 		{
-			dmesh.verts[dmesh.nverts*3+0] = verts[j*3+0];
-			dmesh.verts[dmesh.nverts*3+1] = verts[j*3+1];
-			dmesh.verts[dmesh.nverts*3+2] = verts[j*3+2];
-			dmesh.nverts++;
+			chunk.verts[chunk.nverts*3+0] = verts[j*3+0];
+			chunk.verts[chunk.nverts*3+1] = verts[j*3+1];
+			chunk.verts[chunk.nverts*3+2] = verts[j*3+2];
+			chunk.nverts++;
 		}
 		
 		// Store triangles, allocate more memory if necessary.
-		if (dmesh.ntris+ntris > tcap)
+		if (chunk.ntris+ntris > tcap)
 		{
-			while (dmesh.ntris+ntris > tcap)
+			while (chunk.ntris+ntris > tcap)
 				tcap += 256;
-			unsigned char* newt = (unsigned char*)rcAlloc(sizeof(unsigned char)*tcap*4, RC_ALLOC_PERM);
+			unsigned char* newt = (unsigned char*)rcAlloc(sizeof(unsigned char)*tcap*4, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH_DETAIL);
 			if (!newt)
 			{
 				ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'newt' (%d).", tcap*4);
 				return false;
 			}
-			if (dmesh.ntris)
-				memcpy(newt, dmesh.tris, sizeof(unsigned char)*4*dmesh.ntris);
-			rcFree(dmesh.tris);
-			dmesh.tris = newt;
+			if (chunk.ntris)
+				memcpy(newt, chunk.tris, sizeof(unsigned char)*4*chunk.ntris);
+			rcFree(chunk.tris);
+			chunk.tris = newt;
 		}
 		for (int j = 0; j < ntris; ++j)
 		{
 			const int* t = &tris[j*4];
-			dmesh.tris[dmesh.ntris*4+0] = (unsigned char)t[0];
-			dmesh.tris[dmesh.ntris*4+1] = (unsigned char)t[1];
-			dmesh.tris[dmesh.ntris*4+2] = (unsigned char)t[2];
-			dmesh.tris[dmesh.ntris*4+3] = getTriFlags(&verts[t[0]*3], &verts[t[1]*3], &verts[t[2]*3], poly, npoly);
-			dmesh.ntris++;
+			chunk.tris[chunk.ntris*4+0] = (unsigned char)t[0];
+			chunk.tris[chunk.ntris*4+1] = (unsigned char)t[1];
+			chunk.tris[chunk.ntris*4+2] = (unsigned char)t[2];
+			chunk.tris[chunk.ntris*4+3] = getTriFlags(&verts[t[0]*3], &verts[t[1]*3], &verts[t[2]*3], poly, npoly);
+			chunk.ntris++;
 		}
 	}
 	
+	return true;
+}
+
+static void buildDetailChunkTask(void* userData, int taskIndex, int /*workerIndex*/)
+{
+	rcDetailJob& job = *(rcDetailJob*)userData;
+	rcDetailChunk& chunk = job.chunks[taskIndex];
+	rcDetailTaskContext ctx(&chunk);
+	chunk.failed = !buildDetailChunk(&ctx, job, chunk);
+}
+
+/// @par
+///
+/// See the #rcConfig documentation for more information on the configuration parameters.
+///
+/// If a scheduler is provided, the polygons are split into contiguous ranges
+/// that are built as separate tasks, each into its own vertex and triangle 
+/// buffers.  The buffers are then joined in polygon order, so the result is 
+/// identical to the serial build.  Messages logged by the tasks are passed
+/// to the context once all tasks are done.
+///
+/// @see rcAllocPolyMeshDetail, rcPolyMesh, rcCompactHeightfield, rcPolyMeshDetail, rcConfig
+bool rcBuildPolyMeshDetail(rcContext* ctx, const rcPolyMesh& mesh, const rcCompactHeightfield& chf,
+						   const float sampleDist, const float sampleMaxError,
+						   rcPolyMeshDetail& dmesh, rcTaskScheduler* scheduler)
+{
+	rcAssert(ctx);
+	
+	ctx->startTimer(RC_TIMER_BUILD_POLYMESHDETAIL);
+	
+	if (mesh.nverts == 0 || mesh.npolys == 0)
+		return true;
+	
+	const int nvp = mesh.nvp;
+	int maxhw = 0, maxhh = 0;
+	
+	rcScopedDelete<int> bounds = (int*)rcAlloc(sizeof(int)*mesh.npolys*4, RC_ALLOC_TEMP);
+	if (!bounds)
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'bounds' (%d).", mesh.npolys*4);
+		return false;
+	}
+	
+	// Find max size for a polygon area.
+	for (int i = 0; i < mesh.npolys; ++i)
+	{
+		const unsigned short* p = &mesh.polys[i*nvp*2];
+		int& xmin = bounds[i*4+0];
+		int& xmax = bounds[i*4+1];
+		int& ymin = bounds[i*4+2];
+		int& ymax = bounds[i*4+3];
+		xmin = chf.width;
+		xmax = 0;
+		ymin = chf.height;
+		ymax = 0;
+		for (int j = 0; j < nvp; ++j)
+		{
+			if(p[j] == RC_MESH_NULL_IDX) break;
+			const unsigned short* v = &mesh.verts[p[j]*3];
+			xmin = rcMin(xmin, (int)v[0]);
+			xmax = rcMax(xmax, (int)v[0]);
+			ymin = rcMin(ymin, (int)v[2]);
+			ymax = rcMax(ymax, (int)v[2]);
+		}
+		xmin = rcMax(0,xmin-1);
+		xmax = rcMin(chf.width,xmax+1);
+		ymin = rcMax(0,ymin-1);
+		ymax = rcMin(chf.height,ymax+1);
+		if (xmin >= xmax || ymin >= ymax) continue;
+		maxhw = rcMax(maxhw, xmax-xmin);
+		maxhh = rcMax(maxhh, ymax-ymin);
+	}
+	
+	dmesh.nmeshes = mesh.npolys;
+	dmesh.nverts = 0;
+	dmesh.ntris = 0;
+	dmesh.meshes = (unsigned int*)rcAlloc(sizeof(unsigned int)*dmesh.nmeshes*4, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH_DETAIL);
+	if (!dmesh.meshes)
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'dmesh.meshes' (%d).", dmesh.nmeshes*4);
+		return false;
+	}
+	
+	rcDetailJob job;
+	job.mesh = &mesh;
+	job.chf = &chf;
+	job.sampleDist = sampleDist;
+	job.sampleMaxError = sampleMaxError;
+	job.bounds = bounds;
+	job.maxhw = maxhw;
+	job.maxhh = maxhh;
+	job.meshes = dmesh.meshes;
+	job.chunks = 0;
+	
+	const int workerCount = scheduler ? scheduler->getWorkerCount() : 1;
+	const int taskCount = rcMin(workerCount*4, mesh.npolys / RC_DETAIL_MIN_TASK_POLYS);
+	if (workerCount < 2 || taskCount < 2)
+	{
+		// Build straight into the detail mesh.
+		rcDetailChunk chunk;
+		initDetailChunk(chunk, 0, mesh.npolys);
+		const bool ok = buildDetailChunk(ctx, job, chunk);
+		dmesh.verts = chunk.verts;
+		dmesh.nverts = chunk.nverts;
+		dmesh.tris = chunk.tris;
+		dmesh.ntris = chunk.ntris;
+		if (!ok)
+			return false;
+		
+		ctx->stopTimer(RC_TIMER_BUILD_POLYMESHDETAIL);
+		
+		return true;
+	}
+	
+	rcScopedDelete<rcDetailChunk> chunks = (rcDetailChunk*)rcAlloc(sizeof(rcDetailChunk)*taskCount, RC_ALLOC_TEMP);
+	if (!chunks)
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'chunks' (%d).", taskCount);
+		return false;
+	}
+	for (int i = 0; i < taskCount; ++i)
+		initDetailChunk(chunks[i], mesh.npolys*i/taskCount, mesh.npolys*(i+1)/taskCount);
+	job.chunks = chunks;
+	
+	scheduler->parallelFor(buildDetailChunkTask, &job, taskCount);
+	
+	// Pass on the task messages in polygon order.
+	bool failed = false;
+	int nverts = 0;
+	int ntris = 0;
+	for (int i = 0; i < taskCount; ++i)
+	{
+		const rcDetailChunk& chunk = chunks[i];
+		for (int j = 0; j < chunk.logSize; )
+		{
+			const char* entry = &chunk.log[j];
+			ctx->log((rcLogCategory)entry[0], "%s", entry+1);
+			j += (int)strlen(entry+1) + 2;
+		}
+		failed |= chunk.failed;
+		nverts += chunk.nverts;
+		ntris += chunk.ntris;
+	}
+	
+	if (!failed)
+	{
+		dmesh.verts = (float*)rcAlloc(sizeof(float)*nverts*3, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH_DETAIL);
+		if (!dmesh.verts)
+		{
+			ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'dmesh.verts' (%d).", nverts*3);
+			failed = true;
+		}
+	}
+	if (!failed)
+	{
+		dmesh.tris = (unsigned char*)rcAlloc(sizeof(unsigned char)*ntris*4, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH_DETAIL);
+		if (!dmesh.tris)
+		{
+			ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'dmesh.tris' (%d).", ntris*4);
+			failed = true;
+		}
+	}
+	
+	// Join the chunks and rebase their sub-meshes.
+	for (int i = 0; i < taskCount; ++i)
+	{
+		rcDetailChunk& chunk = chunks[i];
+		if (!failed)
+		{
+			if (chunk.nverts)
+				memcpy(&dmesh.verts[dmesh.nverts*3], chunk.verts, sizeof(float)*3*chunk.nverts);
+			if (chunk.ntris)
+				memcpy(&dmesh.tris[dmesh.ntris*4], chunk.tris, sizeof(unsigned char)*4*chunk.ntris);
+			for (int j = chunk.polyStart; j < chunk.polyEnd; ++j)
+			{
+				dmesh.meshes[j*4+0] += (unsigned int)dmesh.nverts;
+				dmesh.meshes[j*4+2] += (unsigned int)dmesh.ntris;
+			}
+			dmesh.nverts += chunk.nverts;
+			dmesh.ntris += chunk.ntris;
+		}
+		rcFree(chunk.verts);
+		rcFree(chunk.tris);
+	}
+	
+	if (failed)
+		return false;
+	
 	ctx->stopTimer(RC_TIMER_BUILD_POLYMESHDETAIL);
 	
 	return true;
@@ -1352,7 +1561,7 @@ bool rcMergePolyMeshDetails(rcContext* ctx, rcPolyMeshDetail** meshes, const int
 	}
 	
 	mesh.nmeshes = 0;
-	mesh.meshes = (unsigned int*)rcAlloc(sizeof(unsigned int)*maxMeshes*4, RC_ALLOC_PERM);
+	mesh.meshes = (unsigned int*)rcAlloc(sizeof(unsigned int)*maxMeshes*4, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH_DETAIL);
 	if (!mesh.meshes)
 	{
 		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'pmdtl.meshes' (%d).", maxMeshes*4);
@@ -1360,7 +1569,7 @@ bool rcMergePolyMeshDetails(rcContext* ctx, rcPolyMeshDetail** meshes, const int
 	}
 	
 	mesh.ntris = 0;
-	mesh.tris = (unsigned char*)rcAlloc(sizeof(unsigned char)*maxTris*4, RC_ALLOC_PERM);
+	mesh.tris = (unsigned char*)rcAlloc(sizeof(unsigned char)*maxTris*4, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH_DETAIL);
 	if (!mesh.tris)
 	{
 		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'dmesh.tris' (%d).", maxTris*4);
@@ -1368,7 +1577,7 @@ bool rcMergePolyMeshDetails(rcContext* ctx, rcPolyMeshDetail** meshes, const int
 	}
 	
 	mesh.nverts = 0;
-	mesh.verts = (float*)rcAlloc(sizeof(float)*maxVerts*3, RC_ALLOC_PERM);
+	mesh.verts = (float*)rcAlloc(sizeof(float)*maxVerts*3, RC_ALLOC_PERM, RC_ALLOC_TAG_POLYMESH_DETAIL);
 	if (!mesh.verts)
 	{
 		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'dmesh.verts' (%d).", maxVerts*3);
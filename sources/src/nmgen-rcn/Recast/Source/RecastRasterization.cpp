@@ -19,9 +19,22 @@
 #define _USE_MATH_DEFINES
 #include <math.h>
 #include <stdio.h>
+#include <float.h>
 #include "Recast.h"
 #include "RecastAlloc.h"
 #include "RecastAssert.h"
+#include "RecastTaskScheduler.h"
+
+// Define RC_DISABLE_SIMD to build the fast rasterizer without intrinsics.
+#if !defined(RC_DISABLE_SIMD)
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define RC_RASTER_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RC_RASTER_NEON
+#endif
+#endif
 
 inline bool overlapBounds(const float* amin, const float* amax, const float* bmin, const float* bmax)
 {
@@ -48,7 +61,7 @@ static rcSpan* allocSpan(rcHeightfield& hf)
 	{
 		// Create new page.
 		// Allocate memory for the new pool.
-		rcSpanPool* pool = (rcSpanPool*)rcAlloc(sizeof(rcSpanPool), RC_ALLOC_PERM);
+		rcSpanPool* pool = (rcSpanPool*)rcAlloc(sizeof(rcSpanPool), RC_ALLOC_PERM, RC_ALLOC_TAG_HEIGHTFIELD);
 		if (!pool) return 0;
 
 		// Add the pool into the list of pools.
@@ -226,12 +239,189 @@ static void dividePoly(const float* in, int nin,
 }
 
 
+// Snaps the span to the height grid and adds it.  Spans outside the 
+// heightfield's vertical bounds are skipped.
+inline void addClippedSpan(rcHeightfield& hf, const int x, const int y,
+						   float smin, float smax, const float by, const float ich,
+						   const unsigned char area, const int flagMergeThr)
+{
+	// Skip the span if it is outside the heightfield bbox
+	if (smax < 0.0f) return;
+	if (smin > by) return;
+	// Clamp the span to the heightfield bbox.
+	if (smin < 0.0f) smin = 0;
+	if (smax > by) smax = by;
+	
+	// Snap the span to the heightfield height grid.
+	unsigned short ismin = (unsigned short)rcClamp((int)floorf(smin * ich), 0, RC_SPAN_MAX_HEIGHT);
+	unsigned short ismax = (unsigned short)rcClamp((int)ceilf(smax * ich), (int)ismin+1, RC_SPAN_MAX_HEIGHT);
+	
+	addSpan(hf, x, y, ismin, ismax, area, flagMergeThr);
+}
+
+// The number of columns handled per pass of the fast row rasterizer.
+static const int RC_RASTER_CHUNK_SIZE = 64;
+
+// The edges of a row polygon that are not parallel to the z-axis.
+// The height along edge e is ey[e] + slope[e]*(x - ex[e]).
+struct rcRasterEdges
+{
+	float exmin[7], exmax[7];
+	float ex[7], ey[7], slope[7];
+	int n;
+};
+
+// Finds the height range where each of the nb column boundaries in bx 
+// crosses the polygon.  Boundaries that do not cross the polygon get an
+// empty range.  (lo > hi)  nb must be a multiple of four.
+static void crossBoundaries(const rcRasterEdges& edges, const float* bx, const int nb,
+							float* lo, float* hi)
+{
+#if defined(RC_RASTER_SSE)
+	const __m128 inf = _mm_set1_ps(FLT_MAX);
+	const __m128 ninf = _mm_set1_ps(-FLT_MAX);
+	for (int k = 0; k < nb; k += 4)
+	{
+		const __m128 x = _mm_loadu_ps(&bx[k]);
+		__m128 vlo = inf, vhi = ninf;
+		for (int e = 0; e < edges.n; ++e)
+		{
+			const __m128 m = _mm_and_ps(_mm_cmpge_ps(x, _mm_set1_ps(edges.exmin[e])),
+										_mm_cmple_ps(x, _mm_set1_ps(edges.exmax[e])));
+			const __m128 y = _mm_add_ps(_mm_set1_ps(edges.ey[e]),
+				_mm_mul_ps(_mm_set1_ps(edges.slope[e]), _mm_sub_ps(x, _mm_set1_ps(edges.ex[e]))));
+			vlo = _mm_min_ps(vlo, _mm_or_ps(_mm_and_ps(m, y), _mm_andnot_ps(m, inf)));
+			vhi = _mm_max_ps(vhi, _mm_or_ps(_mm_and_ps(m, y), _mm_andnot_ps(m, ninf)));
+		}
+		_mm_storeu_ps(&lo[k], vlo);
+		_mm_storeu_ps(&hi[k], vhi);
+	}
+#elif defined(RC_RASTER_NEON)
+	const float32x4_t inf = vdupq_n_f32(FLT_MAX);
+	const float32x4_t ninf = vdupq_n_f32(-FLT_MAX);
+	for (int k = 0; k < nb; k += 4)
+	{
+		const float32x4_t x = vld1q_f32(&bx[k]);
+		float32x4_t vlo = inf, vhi = ninf;
+		for (int e = 0; e < edges.n; ++e)
+		{
+			const uint32x4_t m = vandq_u32(vcgeq_f32(x, vdupq_n_f32(edges.exmin[e])),
+										   vcleq_f32(x, vdupq_n_f32(edges.exmax[e])));
+			const float32x4_t y = vaddq_f32(vdupq_n_f32(edges.ey[e]),
+				vmulq_f32(vdupq_n_f32(edges.slope[e]), vsubq_f32(x, vdupq_n_f32(edges.ex[e]))));
+			vlo = vminq_f32(vlo, vbslq_f32(m, y, inf));
+			vhi = vmaxq_f32(vhi, vbslq_f32(m, y, ninf));
+		}
+		vst1q_f32(&lo[k], vlo);
+		vst1q_f32(&hi[k], vhi);
+	}
+#else
+	for (int k = 0; k < nb; ++k)
+	{
+		const float x = bx[k];
+		float slo = FLT_MAX, shi = -FLT_MAX;
+		for (int e = 0; e < edges.n; ++e)
+		{
+			if (x < edges.exmin[e] || x > edges.exmax[e])
+				continue;
+			const float y = edges.ey[e] + edges.slope[e]*(x - edges.ex[e]);
+			slo = rcMin(slo, y);
+			shi = rcMax(shi, y);
+		}
+		lo[k] = slo;
+		hi[k] = shi;
+	}
+#endif
+}
+
+// Rasterizes the columns [x0, x1] of a row polygon without clipping the 
+// polygon column by column.  The span of a column is bounded by the 
+// polygon vertices inside the column and the points where the polygon 
+// crosses the column's boundaries, so only those are evaluated.
+//
+// The columns match the clipping path.  Column x0 also takes the part of 
+// the polygon left of it, and the part right of column x1 is dropped.  A 
+// column the polygon only touches is skipped, unless the polygon has no 
+// width.  (E.g. A wall face on a column boundary.)  Then it goes to x0.
+static void rasterizeRowFast(const float* poly, const int nv, const float minX, const float maxX,
+							 const int x0, const int x1, const int y,
+							 const unsigned char area, rcHeightfield& hf,
+							 const float* bmin, const float by,
+							 const float cs, const float ics, const float ich,
+							 const int flagMergeThr)
+{
+	rcRasterEdges edges;
+	edges.n = 0;
+	for (int i = 0, j = nv-1; i < nv; j=i, ++i)
+	{
+		const float* vj = &poly[j*3];
+		const float* vi = &poly[i*3];
+		if (vj[0] == vi[0])
+			continue;	// Covered by the vertices.
+		edges.exmin[edges.n] = rcMin(vj[0], vi[0]);
+		edges.exmax[edges.n] = rcMax(vj[0], vi[0]);
+		edges.ex[edges.n] = vj[0];
+		edges.ey[edges.n] = vj[1];
+		edges.slope[edges.n] = (vi[1] - vj[1]) / (vi[0] - vj[0]);
+		edges.n++;
+	}
+
+	// Vertices right of column x1 get no column. (x0 >= 0)
+	const float xend = bmin[0] + x1*cs + cs;
+	int vcol[7];
+	for (int i = 0; i < nv; ++i)
+	{
+		if (poly[i*3+0] > xend)
+			vcol[i] = -1;
+		else
+			vcol[i] = rcClamp((int)floorf((poly[i*3+0] - bmin[0])*ics), x0, x1);
+	}
+	
+	// Boundary k of a chunk is the left side of column xs+k.
+	float bx[RC_RASTER_CHUNK_SIZE+4];
+	float blo[RC_RASTER_CHUNK_SIZE+4], bhi[RC_RASTER_CHUNK_SIZE+4];
+	
+	for (int xs = x0; xs <= x1; xs += RC_RASTER_CHUNK_SIZE)
+	{
+		const int n = rcMin(RC_RASTER_CHUNK_SIZE, x1 - xs + 1);
+		const int nb = (n + 1 + 3) & ~3;
+		// Same arithmetic as the clipping path, so the boundaries match it.
+		for (int k = 0; k < nb; ++k)
+			bx[k] = bmin[0] + (xs+k-1)*cs + cs;
+		
+		crossBoundaries(edges, bx, nb, blo, bhi);
+		
+		for (int c = 0; c < n; ++c)
+		{
+			// Skip columns the polygon only touches.
+			if (xs+c > x0 && maxX <= bx[c])
+				continue;
+			if (minX > bx[c+1] || (minX == bx[c+1] && minX < maxX))
+				continue;
+			
+			float smin = rcMin(blo[c], blo[c+1]);
+			float smax = rcMax(bhi[c], bhi[c+1]);
+			for (int i = 0; i < nv; ++i)
+			{
+				if (vcol[i] != xs+c)
+					continue;
+				smin = rcMin(smin, poly[i*3+1]);
+				smax = rcMax(smax, poly[i*3+1]);
+			}
+			if (smin > smax)
+				continue;
+
+			addClippedSpan(hf, xs+c, y, smin - bmin[1], smax - bmin[1], by, ich, area, flagMergeThr);
+		}
+	}
+}
 
 static void rasterizeTri(const float* v0, const float* v1, const float* v2,
 						 const unsigned char area, rcHeightfield& hf,
 						 const float* bmin, const float* bmax,
 						 const float cs, const float ics, const float ich,
-						 const int flagMergeThr)
+						 const int flagMergeThr, const bool fast,
+						 const int rowMin, const int rowMax)
 {
 	const int w = hf.width;
 	const int h = hf.height;
@@ -256,6 +446,13 @@ static void rasterizeTri(const float* v0, const float* v1, const float* v2,
 	y0 = rcClamp(y0, 0, h-1);
 	y1 = rcClamp(y1, 0, h-1);
 	
+	// Only rows [rowMin, rowMax] are rasterized.  The rows before rowMin 
+	// are still clipped so that the remaining polygon is the same as when 
+	// rasterizing the whole triangle.
+	if (y0 > rowMax || y1 < rowMin)
+		return;
+	y1 = rcMin(y1, rowMax);
+	
 	// Clip the triangle into all grid cells it touches.
 	float buf[7*3*4];
 	float *in = buf, *inrow = buf+7*3, *p1 = inrow+7*3, *p2 = p1+7*3;
@@ -272,6 +469,7 @@ static void rasterizeTri(const float* v0, const float* v1, const float* v2,
 		dividePoly(in, nvIn, inrow, &nvrow, p1, &nvIn, cz+cs, 2);
 		rcSwap(in, p1);
 		if (nvrow < 3) continue;
+		if (y < rowMin) continue;
 		
 		// find the horizontal bounds in the row
 		float minX = inrow[0], maxX = inrow[0];
@@ -285,6 +483,13 @@ static void rasterizeTri(const float* v0, const float* v1, const float* v2,
 		x0 = rcClamp(x0, 0, w-1);
 		x1 = rcClamp(x1, 0, w-1);
 
+		if (fast)
+		{
+			rasterizeRowFast(inrow, nvrow, minX, maxX, x0, x1, y, area, hf
+				, bmin, by, cs, ics, ich, flagMergeThr);
+			continue;
+		}
+
 		int nv, nv2 = nvrow;
 
 		for (int x = x0; x <= x1; ++x)
@@ -302,20 +507,8 @@ static void rasterizeTri(const float* v0, const float* v1, const float* v2,
 				smin = rcMin(smin, p1[i*3+1]);
 				smax = rcMax(smax, p1[i*3+1]);
 			}
-			smin -= bmin[1];
-			smax -= bmin[1];
-			// Skip the span if it is outside the heightfield bbox
-			if (smax < 0.0f) continue;
-			if (smin > by) continue;
-			// Clamp the span to the heightfield bbox.
-			if (smin < 0.0f) smin = 0;
-			if (smax > by) smax = by;
-			
-			// Snap the span to the heightfield height grid.
-			unsigned short ismin = (unsigned short)rcClamp((int)floorf(smin * ich), 0, RC_SPAN_MAX_HEIGHT);
-			unsigned short ismax = (unsigned short)rcClamp((int)ceilf(smax * ich), (int)ismin+1, RC_SPAN_MAX_HEIGHT);
 			
-			addSpan(hf, x, y, ismin, ismax, area, flagMergeThr);
+			addClippedSpan(hf, x, y, smin - bmin[1], smax - bmin[1], by, ich, area, flagMergeThr);
 		}
 	}
 }
@@ -327,7 +520,7 @@ static void rasterizeTri(const float* v0, const float* v1, const float* v2,
 /// @see rcHeightfield
 void rcRasterizeTriangle(rcContext* ctx, const float* v0, const float* v1, const float* v2,
 						 const unsigned char area, rcHeightfield& solid,
-						 const int flagMergeThr)
+						 const int flagMergeThr, const int flags)
 {
 	rcAssert(ctx);
 
@@ -335,7 +528,8 @@ void rcRasterizeTriangle(rcContext* ctx, const float* v0, const float* v1, const
 
 	const float ics = 1.0f/solid.cs;
 	const float ich = 1.0f/solid.ch;
-	rasterizeTri(v0, v1, v2, area, solid, solid.bmin, solid.bmax, solid.cs, ics, ich, flagMergeThr);
+	rasterizeTri(v0, v1, v2, area, solid, solid.bmin, solid.bmax, solid.cs, ics, ich, flagMergeThr,
+					 (flags & RC_RASTERIZE_FAST) != 0, 0, solid.height-1);
 
 	ctx->stopTimer(RC_TIMER_RASTERIZE_TRIANGLES);
 }
@@ -347,7 +541,7 @@ void rcRasterizeTriangle(rcContext* ctx, const float* v0, const float* v1, const
 /// @see rcHeightfield
 void rcRasterizeTriangles(rcContext* ctx, const float* verts, const int /*nv*/,
 						  const int* tris, const unsigned char* areas, const int nt,
-						  rcHeightfield& solid, const int flagMergeThr)
+						  rcHeightfield& solid, const int flagMergeThr, const int flags)
 {
 	rcAssert(ctx);
 
@@ -362,7 +556,8 @@ void rcRasterizeTriangles(rcContext* ctx, const float* verts, const int /*nv*/,
 		const float* v1 = &verts[tris[i*3+1]*3];
 		const float* v2 = &verts[tris[i*3+2]*3];
 		// Rasterize.
-		rasterizeTri(v0, v1, v2, areas[i], solid, solid.bmin, solid.bmax, solid.cs, ics, ich, flagMergeThr);
+		rasterizeTri(v0, v1, v2, areas[i], solid, solid.bmin, solid.bmax, solid.cs, ics, ich, flagMergeThr,
+					 (flags & RC_RASTERIZE_FAST) != 0, 0, solid.height-1);
 	}
 	
 	ctx->stopTimer(RC_TIMER_RASTERIZE_TRIANGLES);
@@ -375,7 +570,7 @@ void rcRasterizeTriangles(rcContext* ctx, const float* verts, const int /*nv*/,
 /// @see rcHeightfield
 void rcRasterizeTriangles(rcContext* ctx, const float* verts, const int /*nv*/,
 						  const unsigned short* tris, const unsigned char* areas, const int nt,
-						  rcHeightfield& solid, const int flagMergeThr)
+						  rcHeightfield& solid, const int flagMergeThr, const int flags)
 {
 	rcAssert(ctx);
 
@@ -390,7 +585,8 @@ void rcRasterizeTriangles(rcContext* ctx, const float* verts, const int /*nv*/,
 		const float* v1 = &verts[tris[i*3+1]*3];
 		const float* v2 = &verts[tris[i*3+2]*3];
 		// Rasterize.
-		rasterizeTri(v0, v1, v2, areas[i], solid, solid.bmin, solid.bmax, solid.cs, ics, ich, flagMergeThr);
+		rasterizeTri(v0, v1, v2, areas[i], solid, solid.bmin, solid.bmax, solid.cs, ics, ich, flagMergeThr,
+					 (flags & RC_RASTERIZE_FAST) != 0, 0, solid.height-1);
 	}
 	
 	ctx->stopTimer(RC_TIMER_RASTERIZE_TRIANGLES);
@@ -402,7 +598,7 @@ void rcRasterizeTriangles(rcContext* ctx, const float* verts, const int /*nv*/,
 ///
 /// @see rcHeightfield
 void rcRasterizeTriangles(rcContext* ctx, const float* verts, const unsigned char* areas, const int nt,
-						  rcHeightfield& solid, const int flagMergeThr)
+						  rcHeightfield& solid, const int flagMergeThr, const int flags)
 {
 	rcAssert(ctx);
 	
@@ -417,8 +613,157 @@ void rcRasterizeTriangles(rcContext* ctx, const float* verts, const unsigned cha
 		const float* v1 = &verts[(i*3+1)*3];
 		const float* v2 = &verts[(i*3+2)*3];
 		// Rasterize.
-		rasterizeTri(v0, v1, v2, areas[i], solid, solid.bmin, solid.bmax, solid.cs, ics, ich, flagMergeThr);
+		rasterizeTri(v0, v1, v2, areas[i], solid, solid.bmin, solid.bmax, solid.cs, ics, ich, flagMergeThr,
+					 (flags & RC_RASTERIZE_FAST) != 0, 0, solid.height-1);
+	}
+	
+	ctx->stopTimer(RC_TIMER_RASTERIZE_TRIANGLES);
+}
+
+/// @par
+///
+/// Only the spans of the cells in rows [@p rowMin, @p rowMax] are added, and they are the same
+/// spans the whole mesh would add to those rows.  The function neither uses a context nor
+/// touches other rows, so it can run on several threads for disjoint row ranges, provided
+/// each thread uses a heightfield with its own span pools.  (See: rcRasterizeTrianglesParallel)
+///
+/// @see rcHeightfield, rcRasterizeTriangles
+void rcRasterizeTrianglesInRows(const float* verts, const int /*nv*/,
+								const int* tris, const unsigned char* areas, const int nt,
+								rcHeightfield& solid, const int rowMin, const int rowMax,
+								const int flagMergeThr, const int flags)
+{
+	const float ics = 1.0f/solid.cs;
+	const float ich = 1.0f/solid.ch;
+	const int r0 = rcMax(rowMin, 0);
+	const int r1 = rcMin(rowMax, solid.height-1);
+	if (r0 > r1)
+		return;
+	for (int i = 0; i < nt; ++i)
+	{
+		const float* v0 = &verts[tris[i*3+0]*3];
+		const float* v1 = &verts[tris[i*3+1]*3];
+		const float* v2 = &verts[tris[i*3+2]*3];
+		rasterizeTri(v0, v1, v2, areas[i], solid, solid.bmin, solid.bmax, solid.cs, ics, ich, flagMergeThr,
+					 (flags & RC_RASTERIZE_FAST) != 0, r0, r1);
 	}
+}
+
+struct rcRasterizeBand
+{
+	rcHeightfield hf;	// Shares the span grid.  Owns its own span pools.
+	int rowMin, rowMax;
+};
+
+struct rcRasterizeJob
+{
+	const float* verts;
+	const int* tris;
+	const unsigned char* areas;
+	int nt;
+	int flagMergeThr;
+	bool fast;
+	rcRasterizeBand* bands;
+};
+
+static void rasterizeBandTask(void* userData, int taskIndex, int /*workerIndex*/)
+{
+	rcRasterizeJob& job = *(rcRasterizeJob*)userData;
+	rcRasterizeBand& band = job.bands[taskIndex];
+	rcHeightfield& hf = band.hf;
+	
+	const float ics = 1.0f/hf.cs;
+	const float ich = 1.0f/hf.ch;
+	for (int i = 0; i < job.nt; ++i)
+	{
+		const float* v0 = &job.verts[job.tris[i*3+0]*3];
+		const float* v1 = &job.verts[job.tris[i*3+1]*3];
+		const float* v2 = &job.verts[job.tris[i*3+2]*3];
+		rasterizeTri(v0, v1, v2, job.areas[i], hf, hf.bmin, hf.bmax, hf.cs, ics, ich,
+					 job.flagMergeThr, job.fast, band.rowMin, band.rowMax);
+	}
+}
+
+/// @par
+///
+/// The heightfield is split into bands of rows, one task per band.  Each 
+/// task rasterizes every triangle that overlaps its band using its own span 
+/// pools, and the pools are handed to the heightfield once all tasks are 
+/// done.  Each cell receives its spans in the same order as in the serial 
+/// rasterization, so the result is identical.
+///
+/// @see rcHeightfield, rcRasterizeTriangles
+bool rcRasterizeTrianglesParallel(rcContext* ctx, const float* verts, const int nv,
+								  const int* tris, const unsigned char* areas, const int nt,
+								  rcHeightfield& solid, rcTaskScheduler* scheduler,
+								  const int flagMergeThr, const int flags)
+{
+	rcAssert(ctx);
+	
+	// Bands smaller than this spend most of their time on rejected triangles.
+	static const int MIN_BAND_ROWS = 16;
+	
+	const int workerCount = scheduler ? scheduler->getWorkerCount() : 1;
+	const int bandCount = rcMin(workerCount*2, solid.height / MIN_BAND_ROWS);
+	if (workerCount < 2 || bandCount < 2)
+	{
+		rcRasterizeTriangles(ctx, verts, nv, tris, areas, nt, solid, flagMergeThr, flags);
+		return true;
+	}
+	
+	rcRasterizeBand* bands = (rcRasterizeBand*)rcAlloc(sizeof(rcRasterizeBand)*bandCount, RC_ALLOC_TEMP);
+	if (!bands)
+	{
+		ctx->log(RC_LOG_ERROR, "rcRasterizeTrianglesParallel: Out of memory 'bands' (%d).", bandCount);
+		return false;
+	}
+	
+	ctx->startTimer(RC_TIMER_RASTERIZE_TRIANGLES);
+	
+	for (int i = 0; i < bandCount; ++i)
+	{
+		rcRasterizeBand& band = bands[i];
+		band.hf = solid;
+		band.hf.pools = 0;
+		band.hf.freelist = 0;
+		band.rowMin = solid.height * i / bandCount;
+		band.rowMax = solid.height * (i+1) / bandCount - 1;
+	}
+	
+	rcRasterizeJob job;
+	job.verts = verts;
+	job.tris = tris;
+	job.areas = areas;
+	job.nt = nt;
+	job.flagMergeThr = flagMergeThr;
+	job.fast = (flags & RC_RASTERIZE_FAST) != 0;
+	job.bands = bands;
+	
+	scheduler->parallelFor(rasterizeBandTask, &job, bandCount);
+	
+	// Hand the band pools and free spans to the heightfield.
+	for (int i = 0; i < bandCount; ++i)
+	{
+		rcHeightfield& hf = bands[i].hf;
+		while (hf.pools)
+		{
+			rcSpanPool* next = hf.pools->next;
+			hf.pools->next = solid.pools;
+			solid.pools = hf.pools;
+			hf.pools = next;
+		}
+		while (hf.freelist)
+		{
+			rcSpan* next = hf.freelist->next;
+			hf.freelist->next = solid.freelist;
+			solid.freelist = hf.freelist;
+			hf.freelist = next;
+		}
+	}
+	
+	rcFree(bands);
 	
 	ctx->stopTimer(RC_TIMER_RASTERIZE_TRIANGLES);
+	
+	return true;
 }
@@ -25,20 +25,18 @@
 #include "Recast.h"
 #include "RecastAlloc.h"
 #include "RecastAssert.h"
+#include "RecastTaskScheduler.h"
 #include <new>
 
 
-static void calculateDistanceField(rcCompactHeightfield& chf, unsigned short* src, unsigned short& maxDist)
+// Sets the initial distances of the spans in rows [y0, y1).
+// Boundary spans get zero, all others get the maximum.
+static void markBoundaryRows(const rcCompactHeightfield& chf, unsigned short* src,
+							 const int y0, const int y1)
 {
 	const int w = chf.width;
-	const int h = chf.height;
-	
-	// Init distance and points.
-	for (int i = 0; i < chf.spanCount; ++i)
-		src[i] = 0xffff;
 	
-	// Mark boundary cells.
-	for (int y = 0; y < h; ++y)
+	for (int y = y0; y < y1; ++y)
 	{
 		for (int x = 0; x < w; ++x)
 		{
@@ -60,17 +58,22 @@ static void calculateDistanceField(rcCompactHeightfield& chf, unsigned short* sr
 							nc++;
 					}
 				}
-				if (nc != 4)
-					src[i] = 0;
+				src[i] = (nc != 4) ? 0 : 0xffff;
 			}
 		}
 	}
+}
+
+// The first distance pass over the cells in [x0, x1) x [y0, y1).
+// Each cell depends on (-1,0), (-1,-1), (0,-1) and (1,-1).
+static void distancePass1(const rcCompactHeightfield& chf, unsigned short* src,
+						  const int x0, const int x1, const int y0, const int y1)
+{
+	const int w = chf.width;
 	
-			
-	// Pass 1
-	for (int y = 0; y < h; ++y)
+	for (int y = y0; y < y1; ++y)
 	{
-		for (int x = 0; x < w; ++x)
+		for (int x = x0; x < x1; ++x)
 		{
 			const rcCompactCell& c = chf.cells[x+y*w];
 			for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
@@ -120,11 +123,18 @@ static void calculateDistanceField(rcCompactHeightfield& chf, unsigned short* sr
 			}
 		}
 	}
+}
+
+// The second distance pass over the cells in [x0, x1) x [y0, y1), in 
+// reverse order.  Each cell depends on (1,0), (1,1), (0,1) and (-1,1).
+static void distancePass2(const rcCompactHeightfield& chf, unsigned short* src,
+						  const int x0, const int x1, const int y0, const int y1)
+{
+	const int w = chf.width;
 	
-	// Pass 2
-	for (int y = h-1; y >= 0; --y)
+	for (int y = y1-1; y >= y0; --y)
 	{
-		for (int x = w-1; x >= 0; --x)
+		for (int x = x1-1; x >= x0; --x)
 		{
 			const rcCompactCell& c = chf.cells[x+y*w];
 			for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
@@ -173,23 +183,16 @@ static void calculateDistanceField(rcCompactHeightfield& chf, unsigned short* sr
 				}
 			}
 		}
-	}	
-	
-	maxDist = 0;
-	for (int i = 0; i < chf.spanCount; ++i)
-		maxDist = rcMax(src[i], maxDist);
-	
+	}
 }
 
-static unsigned short* boxBlur(rcCompactHeightfield& chf, int thr,
-							   unsigned short* src, unsigned short* dst)
+static void blurRows(const rcCompactHeightfield& chf, const int thr,
+					 const unsigned short* src, unsigned short* dst,
+					 const int y0, const int y1)
 {
 	const int w = chf.width;
-	const int h = chf.height;
 	
-	thr *= 2;
-	
-	for (int y = 0; y < h; ++y)
+	for (int y = y0; y < y1; ++y)
 	{
 		for (int x = 0; x < w; ++x)
 		{
@@ -237,6 +240,158 @@ static unsigned short* boxBlur(rcCompactHeightfield& chf, int thr,
 			}
 		}
 	}
+}
+
+// The parallel distance field works on blocks of cells.  Each row of a block 
+// starts one cell to the left of the row above it, so a block only depends on
+// its left neighbour and the blocks above it and above-right of it.  All blocks
+// with the same value of (bx + 2*by) can then run at the same time.  The 
+// result is identical to the serial passes.
+static const int RC_DIST_BLOCK_SIZE = 32;
+
+struct rcDistanceFieldJob
+{
+	const rcCompactHeightfield* chf;
+	unsigned short* src;
+	unsigned short* dst;
+	int thr;
+	int rowsPerTask;
+	int nbx, nby;
+	int step;		// The current wavefront step.
+	int firstBlockY;	// The block row of the first task in the step.
+};
+
+static int getRowTaskCount(const int h, const int workerCount, int& rowsPerTask)
+{
+	const int taskCount = rcMin(h, workerCount*4);
+	rowsPerTask = (h + taskCount - 1) / taskCount;
+	return (h + rowsPerTask - 1) / rowsPerTask;
+}
+
+static void markBoundaryTask(void* userData, int taskIndex, int /*workerIndex*/)
+{
+	rcDistanceFieldJob& job = *(rcDistanceFieldJob*)userData;
+	const int y0 = taskIndex * job.rowsPerTask;
+	const int y1 = rcMin(job.chf->height, y0 + job.rowsPerTask);
+	markBoundaryRows(*job.chf, job.src, y0, y1);
+}
+
+static void blurTask(void* userData, int taskIndex, int /*workerIndex*/)
+{
+	rcDistanceFieldJob& job = *(rcDistanceFieldJob*)userData;
+	const int y0 = taskIndex * job.rowsPerTask;
+	const int y1 = rcMin(job.chf->height, y0 + job.rowsPerTask);
+	blurRows(*job.chf, job.thr, job.src, job.dst, y0, y1);
+}
+
+static void distancePass1Task(void* userData, int taskIndex, int /*workerIndex*/)
+{
+	rcDistanceFieldJob& job = *(rcDistanceFieldJob*)userData;
+	const int w = job.chf->width;
+	const int by = job.firstBlockY + taskIndex;
+	const int bx = job.step - by*2;
+	const int y0 = by*RC_DIST_BLOCK_SIZE;
+	const int y1 = rcMin(job.chf->height, y0 + RC_DIST_BLOCK_SIZE);
+	for (int y = y0; y < y1; ++y)
+	{
+		const int x0 = rcMax(0, bx*RC_DIST_BLOCK_SIZE - (y - y0));
+		const int x1 = rcMin(w, (bx+1)*RC_DIST_BLOCK_SIZE - (y - y0));
+		if (x0 < x1)
+			distancePass1(*job.chf, job.src, x0, x1, y, y+1);
+	}
+}
+
+static void distancePass2Task(void* userData, int taskIndex, int /*workerIndex*/)
+{
+	// Same as pass 1, with the field mirrored.
+	rcDistanceFieldJob& job = *(rcDistanceFieldJob*)userData;
+	const int w = job.chf->width;
+	const int h = job.chf->height;
+	const int by = job.firstBlockY + taskIndex;
+	const int bx = job.step - by*2;
+	const int y0 = by*RC_DIST_BLOCK_SIZE;
+	const int y1 = rcMin(h, y0 + RC_DIST_BLOCK_SIZE);
+	for (int y = y0; y < y1; ++y)
+	{
+		const int x0 = rcMax(0, bx*RC_DIST_BLOCK_SIZE - (y - y0));
+		const int x1 = rcMin(w, (bx+1)*RC_DIST_BLOCK_SIZE - (y - y0));
+		if (x0 < x1)
+			distancePass2(*job.chf, job.src, w - x1, w - x0, h-1 - y, h - y);
+	}
+}
+
+static void runDistanceWavefront(rcTaskScheduler* scheduler, rcDistanceFieldJob& job, rcTaskFunc func)
+{
+	const int stepCount = (job.nbx-1) + (job.nby-1)*2 + 1;
+	for (int t = 0; t < stepCount; ++t)
+	{
+		// The block rows with a block column in range.
+		const int by0 = t - (job.nbx-1) > 0 ? (t - (job.nbx-1) + 1) / 2 : 0;
+		const int by1 = rcMin(job.nby-1, t/2);
+		job.step = t;
+		job.firstBlockY = by0;
+		scheduler->parallelFor(func, &job, by1 - by0 + 1);
+	}
+}
+
+static void calculateDistanceField(rcCompactHeightfield& chf, unsigned short* src, unsigned short& maxDist,
+								   rcTaskScheduler* scheduler)
+{
+	const int w = chf.width;
+	const int h = chf.height;
+	
+	if (scheduler && scheduler->getWorkerCount() > 1 && h > 0)
+	{
+		rcDistanceFieldJob job;
+		memset(&job, 0, sizeof(job));
+		job.chf = &chf;
+		job.src = src;
+		// The sheared blocks need one extra column to cover the field.
+		job.nbx = (w + RC_DIST_BLOCK_SIZE-1) / RC_DIST_BLOCK_SIZE + 1;
+		job.nby = (h + RC_DIST_BLOCK_SIZE-1) / RC_DIST_BLOCK_SIZE;
+		
+		const int taskCount = getRowTaskCount(h, scheduler->getWorkerCount(), job.rowsPerTask);
+		scheduler->parallelFor(markBoundaryTask, &job, taskCount);
+		
+		runDistanceWavefront(scheduler, job, distancePass1Task);
+		runDistanceWavefront(scheduler, job, distancePass2Task);
+	}
+	else
+	{
+		markBoundaryRows(chf, src, 0, h);
+		distancePass1(chf, src, 0, w, 0, h);
+		distancePass2(chf, src, 0, w, 0, h);
+	}
+	
+	maxDist = 0;
+	for (int i = 0; i < chf.spanCount; ++i)
+		maxDist = rcMax(src[i], maxDist);
+	
+}
+
+static unsigned short* boxBlur(rcCompactHeightfield& chf, int thr,
+							   unsigned short* src, unsigned short* dst,
+							   rcTaskScheduler* scheduler)
+{
+	thr *= 2;
+	
+	if (scheduler && scheduler->getWorkerCount() > 1 && chf.height > 0)
+	{
+		rcDistanceFieldJob job;
+		memset(&job, 0, sizeof(job));
+		job.chf = &chf;
+		job.src = src;
+		job.dst = dst;
+		job.thr = thr;
+		
+		const int taskCount = getRowTaskCount(chf.height, scheduler->getWorkerCount(), job.rowsPerTask);
+		scheduler->parallelFor(blurTask, &job, taskCount);
+	}
+	else
+	{
+		blurRows(chf, thr, src, dst, 0, chf.height);
+	}
+	
 	return dst;
 }
 
@@ -343,12 +498,96 @@ static bool floodRegion(int x, int y, int i,
 	return count > 0;
 }
 
+// Expands the regions by one step for the stack entries [j0, j1).  Reads the 
+// source buffers and writes the destination buffers, so the entries can be
+// processed in any order.  Returns the number of entries that failed.
+static int expandStackEntries(const rcCompactHeightfield& chf,
+							  const unsigned short* srcReg, const unsigned short* srcDist,
+							  unsigned short* dstReg, unsigned short* dstDist,
+							  int* entries, const int j0, const int j1)
+{
+	const int w = chf.width;
+	int failed = 0;
+	
+	for (int j = j0; j < j1; j += 3)
+	{
+		int x = entries[j+0];
+		int y = entries[j+1];
+		int i = entries[j+2];
+		if (i < 0)
+		{
+			failed++;
+			continue;
+		}
+		
+		unsigned short r = srcReg[i];
+		unsigned short d2 = 0xffff;
+		const unsigned char area = chf.areas[i];
+		const rcCompactSpan& s = chf.spans[i];
+		for (int dir = 0; dir < 4; ++dir)
+		{
+			if (rcGetCon(s, dir) == RC_NOT_CONNECTED) continue;
+			const int ax = x + rcGetDirOffsetX(dir);
+			const int ay = y + rcGetDirOffsetY(dir);
+			const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, dir);
+			if (chf.areas[ai] != area) continue;
+			if (srcReg[ai] > 0 && (srcReg[ai] & RC_BORDER_REG) == 0)
+			{
+				if ((int)srcDist[ai]+2 < (int)d2)
+				{
+					r = srcReg[ai];
+					d2 = srcDist[ai]+2;
+				}
+			}
+		}
+		if (r)
+		{
+			entries[j+2] = -1; // mark as used
+			dstReg[i] = r;
+			dstDist[i] = d2;
+		}
+		else
+		{
+			failed++;
+		}
+	}
+	
+	return failed;
+}
+
+// The fewest stack entries handed to a parallel expansion task.
+static const int RC_EXPAND_MIN_ENTRIES = 2048;
+static const int RC_EXPAND_MAX_TASKS = 64;
+
+struct rcExpandJob
+{
+	const rcCompactHeightfield* chf;
+	const unsigned short* srcReg;
+	const unsigned short* srcDist;
+	unsigned short* dstReg;
+	unsigned short* dstDist;
+	int* entries;
+	int entryCount;
+	int entriesPerTask;
+	int failed[RC_EXPAND_MAX_TASKS];
+};
+
+static void expandTask(void* userData, int taskIndex, int /*workerIndex*/)
+{
+	rcExpandJob& job = *(rcExpandJob*)userData;
+	const int e0 = taskIndex * job.entriesPerTask;
+	const int e1 = rcMin(job.entryCount, e0 + job.entriesPerTask);
+	job.failed[taskIndex] = expandStackEntries(*job.chf, job.srcReg, job.srcDist
+		, job.dstReg, job.dstDist, job.entries, e0*3, e1*3);
+}
+
 static unsigned short* expandRegions(int maxIter, unsigned short level,
 									 rcCompactHeightfield& chf,
 									 unsigned short* srcReg, unsigned short* srcDist,
 									 unsigned short* dstReg, unsigned short* dstDist, 
 									 rcIntArray& stack,
-									 bool fillStack)
+									 bool fillStack,
+									 rcTaskScheduler* scheduler)
 {
 	const int w = chf.width;
 	const int h = chf.height;
@@ -385,6 +624,8 @@ static unsigned short* expandRegions(int maxIter, unsigned short level,
 		}
 	}
 
+	const int workerCount = scheduler ? scheduler->getWorkerCount() : 1;
+
 	int iter = 0;
 	while (stack.size() > 0)
 	{
@@ -393,47 +634,31 @@ static unsigned short* expandRegions(int maxIter, unsigned short level,
 		memcpy(dstReg, srcReg, sizeof(unsigned short)*chf.spanCount);
 		memcpy(dstDist, srcDist, sizeof(unsigned short)*chf.spanCount);
 		
-		for (int j = 0; j < stack.size(); j += 3)
+		const int entryCount = stack.size() / 3;
+		if (workerCount > 1 && entryCount >= RC_EXPAND_MIN_ENTRIES*2)
 		{
-			int x = stack[j+0];
-			int y = stack[j+1];
-			int i = stack[j+2];
-			if (i < 0)
-			{
-				failed++;
-				continue;
-			}
+			rcExpandJob job;
+			job.chf = &chf;
+			job.srcReg = srcReg;
+			job.srcDist = srcDist;
+			job.dstReg = dstReg;
+			job.dstDist = dstDist;
+			job.entries = &stack[0];
+			job.entryCount = entryCount;
+
+			const int taskCount = rcMin(rcMin(workerCount*4, RC_EXPAND_MAX_TASKS)
+										, entryCount / RC_EXPAND_MIN_ENTRIES);
+			job.entriesPerTask = (entryCount + taskCount-1) / taskCount;
 			
-			unsigned short r = srcReg[i];
-			unsigned short d2 = 0xffff;
-			const unsigned char area = chf.areas[i];
-			const rcCompactSpan& s = chf.spans[i];
-			for (int dir = 0; dir < 4; ++dir)
-			{
-				if (rcGetCon(s, dir) == RC_NOT_CONNECTED) continue;
-				const int ax = x + rcGetDirOffsetX(dir);
-				const int ay = y + rcGetDirOffsetY(dir);
-				const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, dir);
-				if (chf.areas[ai] != area) continue;
-				if (srcReg[ai] > 0 && (srcReg[ai] & RC_BORDER_REG) == 0)
-				{
-					if ((int)srcDist[ai]+2 < (int)d2)
-					{
-						r = srcReg[ai];
-						d2 = srcDist[ai]+2;
-					}
-				}
-			}
-			if (r)
-			{
-				stack[j+2] = -1; // mark as used
-				dstReg[i] = r;
-				dstDist[i] = d2;
-			}
-			else
-			{
-				failed++;
-			}
+			scheduler->parallelFor(expandTask, &job, taskCount);
+			
+			for (int t = 0; t < taskCount; ++t)
+				failed += job.failed[t];
+		}
+		else
+		{
+			failed = expandStackEntries(chf, srcReg, srcDist, dstReg, dstDist
+				, &stack[0], 0, stack.size());
 		}
 		
 		// rcSwap source and dest.
@@ -1253,7 +1478,7 @@ static bool mergeAndFilterLayerRegions(rcContext* ctx, int minRegionArea,
 /// and rcCompactHeightfield::dist fields.
 ///
 /// @see rcCompactHeightfield, rcBuildRegions, rcBuildRegionsMonotone
-bool rcBuildDistanceField(rcContext* ctx, rcCompactHeightfield& chf)
+bool rcBuildDistanceField(rcContext* ctx, rcCompactHeightfield& chf, rcTaskScheduler* scheduler)
 {
 	rcAssert(ctx);
 	
@@ -1265,13 +1490,14 @@ bool rcBuildDistanceField(rcContext* ctx, rcCompactHeightfield& chf)
 		chf.dist = 0;
 	}
 	
-	unsigned short* src = (unsigned short*)rcAlloc(sizeof(unsigned short)*chf.spanCount, RC_ALLOC_TEMP);
+	// Either buffer may end up as chf.dist, so neither is temporary.
+	unsigned short* src = (unsigned short*)rcAlloc(sizeof(unsigned short)*chf.spanCount, RC_ALLOC_PERM, RC_ALLOC_TAG_COMPACT_HEIGHTFIELD);
 	if (!src)
 	{
 		ctx->log(RC_LOG_ERROR, "rcBuildDistanceField: Out of memory 'src' (%d).", chf.spanCount);
 		return false;
 	}
-	unsigned short* dst = (unsigned short*)rcAlloc(sizeof(unsigned short)*chf.spanCount, RC_ALLOC_TEMP);
+	unsigned short* dst = (unsigned short*)rcAlloc(sizeof(unsigned short)*chf.spanCount, RC_ALLOC_PERM, RC_ALLOC_TAG_COMPACT_HEIGHTFIELD);
 	if (!dst)
 	{
 		ctx->log(RC_LOG_ERROR, "rcBuildDistanceField: Out of memory 'dst' (%d).", chf.spanCount);
@@ -1283,7 +1509,7 @@ bool rcBuildDistanceField(rcContext* ctx, rcCompactHeightfield& chf)
 
 	ctx->startTimer(RC_TIMER_BUILD_DISTANCEFIELD_DIST);
 	
-	calculateDistanceField(chf, src, maxDist);
+	calculateDistanceField(chf, src, maxDist, scheduler);
 	chf.maxDistance = maxDist;
 	
 	ctx->stopTimer(RC_TIMER_BUILD_DISTANCEFIELD_DIST);
@@ -1291,7 +1517,7 @@ bool rcBuildDistanceField(rcContext* ctx, rcCompactHeightfield& chf)
 	ctx->startTimer(RC_TIMER_BUILD_DISTANCEFIELD_BLUR);
 	
 	// Blur
-	if (boxBlur(chf, 1, src, dst) != src)
+	if (boxBlur(chf, 1, src, dst, scheduler) != src)
 		rcSwap(src, dst);
 	
 	// Store distance.
@@ -1530,7 +1756,8 @@ bool rcBuildRegionsMonotone(rcContext* ctx, rcCompactHeightfield& chf,
 /// 
 /// @see rcCompactHeightfield, rcCompactSpan, rcBuildDistanceField, rcBuildRegionsMonotone, rcConfig
 bool rcBuildRegions(rcContext* ctx, rcCompactHeightfield& chf,
-					const int borderSize, const int minRegionArea, const int mergeRegionArea)
+					const int borderSize, const int minRegionArea, const int mergeRegionArea,
+					rcTaskScheduler* scheduler)
 {
 	rcAssert(ctx);
 	
@@ -1606,7 +1833,7 @@ bool rcBuildRegions(rcContext* ctx, rcCompactHeightfield& chf,
 		ctx->startTimer(RC_TIMER_BUILD_REGIONS_EXPAND);
 		
 		// Expand current regions until no empty connected cells found.
-		if (expandRegions(expandIters, level, chf, srcReg, srcDist, dstReg, dstDist, lvlStacks[sId], false) != srcReg)
+		if (expandRegions(expandIters, level, chf, srcReg, srcDist, dstReg, dstDist, lvlStacks[sId], false, scheduler) != srcReg)
 		{
 			rcSwap(srcReg, dstReg);
 			rcSwap(srcDist, dstDist);
@@ -1633,7 +1860,7 @@ bool rcBuildRegions(rcContext* ctx, rcCompactHeightfield& chf,
 	}
 	
 	// Expand current regions until no empty connected cells found.
-	if (expandRegions(expandIters*8, 0, chf, srcReg, srcDist, dstReg, dstDist, stack, true) != srcReg)
+	if (expandRegions(expandIters*8, 0, chf, srcReg, srcDist, dstReg, dstDist, stack, true, scheduler) != srcReg)
 	{
 		rcSwap(srcReg, dstReg);
 		rcSwap(srcDist, dstDist);